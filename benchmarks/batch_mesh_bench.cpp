@@ -0,0 +1,81 @@
+#include "almond_voxel/meshing/batch_mesher.hpp"
+#include "almond_voxel/world.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace almond::voxel;
+
+namespace {
+chunk_storage make_terrain_chunk(const region_key& key) {
+    chunk_storage chunk{cubic_extent(32)};
+    auto voxels = chunk.voxels();
+    for (std::uint32_t z = 0; z < 32; ++z) {
+        for (std::uint32_t y = 0; y < 32; ++y) {
+            for (std::uint32_t x = 0; x < 32; ++x) {
+                const auto wx = key.x * 32 + static_cast<std::int32_t>(x);
+                const auto wy = key.y * 32 + static_cast<std::int32_t>(y);
+                const auto wz = key.z * 32 + static_cast<std::int32_t>(z);
+                const auto height = 24 + (wx * 7 + wy * 13) % 17;
+                if (wz < height || (wx + wy + wz) % 11 == 0) {
+                    voxels(x, y, z) = static_cast<voxel_id>(1 + (wz / 8) % 3);
+                }
+            }
+        }
+    }
+    return chunk;
+}
+}
+
+int main() {
+    constexpr std::int32_t radius = 4;
+
+    region_manager regions{cubic_extent(32)};
+    regions.set_loader(make_terrain_chunk);
+    std::vector<region_key> keys;
+    for (std::int32_t z = 0; z < 2; ++z) {
+        for (std::int32_t y = -radius; y < radius; ++y) {
+            for (std::int32_t x = -radius; x < radius; ++x) {
+                keys.push_back({x, y, z});
+                regions.assure(keys.back());
+            }
+        }
+    }
+
+    const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::size_t> worker_counts{1, 2, 4};
+    if (hardware > 4) {
+        worker_counts.push_back(hardware);
+    }
+
+    double baseline = 0.0;
+    std::cout << "hardware threads: " << hardware << '\n';
+    std::cout << "workers  chunks  seconds  meshes/sec  speedup\n";
+    for (const auto workers : worker_counts) {
+        meshing::batch_mesh_config config{};
+        config.worker_count = workers;
+        meshing::batch_mesher mesher{regions, config};
+
+        const auto start = std::chrono::steady_clock::now();
+        mesher.submit(keys, region_key{0, 0, 0});
+        std::size_t completed = 0;
+        while (completed < keys.size()) {
+            const auto delivered = mesher.drain([](meshing::batch_mesh_result&&) {});
+            if (delivered == 0) {
+                std::this_thread::yield();
+            }
+            completed += delivered;
+        }
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const double rate = static_cast<double>(keys.size()) / seconds;
+        baseline = baseline > 0.0 ? baseline : rate;
+
+        std::cout << workers << "  " << keys.size() << "  " << seconds << "  " << rate << "  " << rate / baseline
+                  << "x\n";
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "almond_voxel/chunk.hpp"
+#include "almond_voxel/terrain/classic.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace almond::voxel;
+
+namespace {
+chunk_storage make_sample_chunk(const terrain::classic_heightfield& terrain, std::int32_t index) {
+    auto chunk = terrain(region_key{index, 1, index / 2});
+    // Touch every plane the way a lit, edited chunk would so each codec sees dense data.
+    auto voxels = chunk.voxels();
+    auto sky = chunk.skylight();
+    const auto extent = chunk.extent();
+    for (std::uint32_t z = 0; z < extent.z; ++z) {
+        for (std::uint32_t x = 0; x < extent.x; ++x) {
+            std::uint8_t level = 15;
+            for (std::uint32_t y = extent.y; y-- > 0;) {
+                if (voxels(x, y, z) != voxel_id{}) {
+                    level = 0;
+                }
+                sky(x, y, z) = level;
+            }
+        }
+    }
+    return chunk;
+}
+
+double microseconds_per_op(std::chrono::steady_clock::duration elapsed, std::size_t operations) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / 1000.0 /
+        static_cast<double>(operations);
+}
+}
+
+int main() {
+    constexpr std::size_t chunk_count = 64;
+    const terrain::classic_heightfield terrain{};
+    const std::array<std::pair<const char*, chunk_codec_config>, 5> configs{{
+        {"default", chunk_codec_config{}},
+        {"rle", chunk_codec_config{}.set(chunk_plane::all, codec_id::rle)},
+        {"delta_bitpack", chunk_codec_config{}.set(chunk_plane::all, codec_id::delta_bitpack)},
+        {"lz", chunk_codec_config{}.set(chunk_plane::all, codec_id::lz)},
+        {"automatic", chunk_codec_config{}.set(chunk_plane::all, codec_id::automatic)},
+    }};
+
+    std::cout << "codec  ratio  compress us/chunk  decompress us/chunk\n";
+    for (const auto& [name, config] : configs) {
+        std::vector<chunk_storage> chunks{};
+        chunks.reserve(chunk_count);
+        std::size_t dense_bytes = 0;
+        for (std::size_t i = 0; i < chunk_count; ++i) {
+            chunks.push_back(make_sample_chunk(terrain, static_cast<std::int32_t>(i)));
+            dense_bytes += chunks.back().memory_usage().bytes(chunk_plane::all);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (auto& chunk : chunks) {
+            chunk.compress(config);
+        }
+        const auto compress_time = std::chrono::steady_clock::now() - start;
+
+        std::size_t compressed_bytes = 0;
+        for (const auto& chunk : chunks) {
+            const auto usage = chunk.memory_usage();
+            compressed_bytes += usage.bytes(chunk_plane::all) + usage.compressed;
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (auto& chunk : chunks) {
+            (void)chunk.decompress();
+        }
+        const auto decompress_time = std::chrono::steady_clock::now() - start;
+
+        std::cout << name << "  " << static_cast<double>(dense_bytes) / static_cast<double>(compressed_bytes) << "  "
+                  << microseconds_per_op(compress_time, chunk_count) << "  "
+                  << microseconds_per_op(decompress_time, chunk_count) << '\n';
+    }
+    return 0;
+}
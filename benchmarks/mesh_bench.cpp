@@ -1,10 +1,16 @@
+#include "almond_voxel/meshing/binary_greedy_mesher.hpp"
 #include "almond_voxel/meshing/greedy_mesher.hpp"
+#include "almond_voxel/meshing/marching_cubes.hpp"
+#include "almond_voxel/meshing/mesh_context.hpp"
 
 #include "almond_voxel/chunk.hpp"
 
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <span>
+#include <vector>
 
 using namespace almond::voxel;
 
@@ -30,24 +36,72 @@ int main() {
     chunk_storage chunk{cubic_extent(chunk_size)};
     populate_sample_chunk(chunk);
 
-    const auto start = std::chrono::steady_clock::now();
-    std::size_t total_vertices = 0;
-    std::size_t total_indices = 0;
-    for (std::size_t i = 0; i < iterations; ++i) {
-        const auto mesh = meshing::greedy_mesh(chunk);
-        total_vertices += mesh.vertices.size();
-        total_indices += mesh.indices.size();
-    }
-    const auto end = std::chrono::steady_clock::now();
-    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    const auto run = [&](const char* name, auto&& mesher) {
+        const auto start = std::chrono::steady_clock::now();
+        std::size_t total_vertices = 0;
+        std::size_t total_indices = 0;
+        for (std::size_t i = 0; i < iterations; ++i) {
+            const auto& mesh = mesher(chunk);
+            total_vertices += mesh.vertices.size();
+            total_indices += mesh.indices.size();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        const double seconds = static_cast<double>(elapsed.count()) / 1'000'000.0;
+        const double meshes_per_second = seconds > 0.0 ? static_cast<double>(iterations) / seconds : 0.0;
+
+        std::cout << name << ": meshed " << iterations << " chunk(s) of size " << chunk_size << '^' << 3 << " in "
+                  << seconds << "s\n";
+        std::cout << "  Average meshes/sec: " << meshes_per_second << "\n";
+        std::cout << "  Average vertices  : " << static_cast<double>(total_vertices) / iterations << "\n";
+        std::cout << "  Average indices   : " << static_cast<double>(total_indices) / iterations << '\n';
+    };
+
+    run("greedy", [](const chunk_storage& source) { return meshing::greedy_mesh(source); });
+    run("binary_greedy", [](const chunk_storage& source) { return meshing::binary_greedy_mesh(source); });
+
+    // Reused buffers: the context keeps its output mesh, and the span sink writes packed vertices into fixed storage.
+    meshing::mesher_context context;
+    run("greedy (context)", [&](const chunk_storage& source) -> const meshing::mesh_result& {
+        return context.greedy(source);
+    });
+    run("binary_greedy (context)", [&](const chunk_storage& source) -> const meshing::mesh_result& {
+        return context.binary_greedy(source);
+    });
 
-    const double seconds = static_cast<double>(elapsed.count()) / 1000.0;
-    const double meshes_per_second = seconds > 0.0 ? static_cast<double>(iterations) / seconds : 0.0;
+    struct span_view {
+        std::span<const meshing::packed_vertex> vertices;
+        std::span<const std::uint32_t> indices;
+    };
+    const auto& reference = context.binary_greedy(chunk);
+    std::vector<meshing::packed_vertex> packed_vertices(reference.vertices.size());
+    std::vector<std::uint32_t> packed_indices(reference.indices.size());
+    run("binary_greedy (packed span)", [&](const chunk_storage& source) {
+        meshing::packed_span_sink sink{packed_vertices, packed_indices};
+        meshing::binary_greedy_quads_with_neighbor_chunks(source, {},
+            [](voxel_id id) { return id != voxel_id{}; }, sink, context.scratch());
+        const auto& written = sink.result();
+        return span_view{std::span<const meshing::packed_vertex>{packed_vertices}.first(written.vertex_count),
+            std::span<const std::uint32_t>{packed_indices}.first(written.index_count)};
+    });
 
-    std::cout << "Meshed " << iterations << " chunk(s) of size " << chunk_size << '^' << 3 << " in " << seconds << "s\n";
-    std::cout << "Average meshes/sec: " << meshes_per_second << "\n";
-    std::cout << "Average vertices  : " << static_cast<double>(total_vertices) / iterations << "\n";
-    std::cout << "Average indices   : " << static_cast<double>(total_indices) / iterations << '\n';
+    // Marching cubes: unshared triangles against the indexed form, whose cells share their edge vertices.
+    meshing::mesh_result triangles;
+    run("marching_cubes (triangles)", [&](const chunk_storage& source) -> const meshing::mesh_result& {
+        triangles.vertices.clear();
+        triangles.indices.clear();
+        meshing::marching_cubes_triangles_from_chunk(source, [](voxel_id id) { return id != voxel_id{}; },
+            meshing::chunk_neighborhood{}, {},
+            [&](const std::array<meshing::vertex, 3>& triangle) {
+                meshing::detail::append_triangle(triangles, triangle);
+            },
+            context.scratch());
+        return triangles;
+    });
+    run("marching_cubes (indexed, context)", [&](const chunk_storage& source) -> const meshing::mesh_result& {
+        return context.marching_cubes(source);
+    });
 
     return 0;
 }
@@ -0,0 +1,73 @@
+#include "almond_voxel/world.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace almond::voxel;
+
+namespace {
+region_key key_for(std::uint32_t index) {
+    return region_key{static_cast<std::int32_t>(index % 256), static_cast<std::int32_t>(index / 65536),
+        static_cast<std::int32_t>((index / 256) % 256)};
+}
+
+double nanoseconds_per_op(std::chrono::steady_clock::duration elapsed, std::size_t operations) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+        static_cast<double>(operations);
+}
+}
+
+int main() {
+    constexpr std::size_t operations = 200000;
+    constexpr std::array<std::uint32_t, 4> limits{1024, 4096, 16384, 65536};
+
+    std::cout << "max_resident  touch ns/op  churn ns/op  pin+unpin ns/op\n";
+    for (const auto limit : limits) {
+        region_manager manager{cubic_extent(8)};
+        manager.set_max_resident(limit);
+        for (std::uint32_t i = 0; i < limit; ++i) {
+            manager.assure(key_for(i));
+        }
+
+        std::mt19937 rng{1234};
+        std::uniform_int_distribution<std::uint32_t> pick{0, limit - 1};
+        std::vector<region_key> resident_keys(operations);
+        for (auto& key : resident_keys) {
+            key = key_for(pick(rng));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& key : resident_keys) {
+            manager.assure(key);
+        }
+        const auto touch_time = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < operations; ++i) {
+            manager.assure(key_for(limit + static_cast<std::uint32_t>(i)));
+            manager.evict_until_within_limit();
+        }
+        const auto churn_time = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < operations; ++i) {
+            const auto key = key_for(limit + static_cast<std::uint32_t>(operations - 1 - (i % limit)));
+            manager.pin(key);
+            manager.unpin(key);
+        }
+        const auto pin_time = std::chrono::steady_clock::now() - start;
+
+        std::cout << limit << "  " << nanoseconds_per_op(touch_time, operations) << "  "
+                  << nanoseconds_per_op(churn_time, operations) << "  " << nanoseconds_per_op(pin_time, operations)
+                  << '\n';
+        if (manager.resident() != limit) {
+            std::cerr << "unexpected resident count " << manager.resident() << '\n';
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "almond_voxel/parallel/task_pool.hpp"
+#include "almond_voxel/serialization/region_io.hpp"
+#include "almond_voxel/terrain/classic.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace almond::voxel;
+
+namespace {
+double milliseconds(std::chrono::steady_clock::duration elapsed) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()) / 1000.0;
+}
+
+// The per-blob sink that file_sink used to be: reopen, append, close. Writes unchecked legacy records.
+auto reopening_sink(const std::filesystem::path& path) {
+    return [path](const serialization::region_blob& blob) {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out.write(reinterpret_cast<const char*>(&blob.key), sizeof(blob.key));
+        const auto size = static_cast<std::uint32_t>(blob.payload.size());
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.write(reinterpret_cast<const char*>(blob.payload.data()), static_cast<std::streamsize>(size));
+    };
+}
+}
+
+int main() {
+    constexpr std::int32_t side = 16;
+    const auto directory = std::filesystem::temp_directory_path() / "almond_voxel_world_io_bench";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    const terrain::classic_heightfield terrain{};
+    region_manager world{cubic_extent(32)};
+    world.set_max_resident(side * side * 2);
+    for (std::int32_t z = 0; z < side; ++z) {
+        for (std::int32_t x = 0; x < side; ++x) {
+            for (std::int32_t y = 0; y < 2; ++y) {
+                const region_key key{x, y, z};
+                world.replace(key, terrain(key)).mark_dirty(chunk_plane::all);
+            }
+        }
+    }
+    parallel::task_pool pool{};
+    serialization::batch_io_options options{};
+    options.include_clean = true;
+
+    std::cout << "chunks " << side * side * 2 << ", workers " << pool.worker_count() << "\n";
+    std::cout << "path  save ms  load ms  file MiB\n";
+    const auto report = [&](const std::string& name, const std::filesystem::path& path, auto save, auto load) {
+        std::filesystem::remove(path);
+        auto start = std::chrono::steady_clock::now();
+        save(path);
+        const auto save_time = std::chrono::steady_clock::now() - start;
+
+        region_manager target{cubic_extent(32)};
+        target.set_max_resident(side * side * 2);
+        std::ifstream in{path, std::ios::binary};
+        start = std::chrono::steady_clock::now();
+        load(target, in);
+        const auto load_time = std::chrono::steady_clock::now() - start;
+        std::cout << name << "  " << milliseconds(save_time) << "  " << milliseconds(load_time) << "  "
+                  << static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0) << "\n";
+    };
+    const auto serial_load = [](region_manager& target, std::istream& in) {
+        while (auto blob = serialization::read_region_blob(in)) {
+            serialization::ingest_blob(target, *blob);
+        }
+    };
+    const auto parallel_load = [&](region_manager& target, std::istream& in) {
+        serialization::ingest_parallel(target, pool, in, options);
+    };
+
+    report("reopen_per_blob", directory / "reopen.bin", [&](const std::filesystem::path& path) {
+        serialization::dump_region(world, serialization::make_region_serializer(reopening_sink(path)), true);
+    }, serial_load);
+    report("buffered_serial", directory / "serial.bin", [&](const std::filesystem::path& path) {
+        serialization::dump_region(world, serialization::make_region_serializer(serialization::file_sink(path)), true);
+    }, serial_load);
+    report("parallel_raw", directory / "parallel.bin", [&](const std::filesystem::path& path) {
+        serialization::region_writer writer{path, false};
+        serialization::dump_region_parallel(world, pool,
+            [&writer](const serialization::region_blob& blob) { writer.write(blob); }, options);
+        writer.commit();
+    }, parallel_load);
+    options.codec = codec_id::lz;
+    report("parallel_lz", directory / "parallel_lz.bin", [&](const std::filesystem::path& path) {
+        serialization::region_writer writer{path, false};
+        serialization::dump_region_parallel(world, pool,
+            [&writer](const serialization::region_blob& blob) { writer.write(blob); }, options);
+        writer.commit();
+    }, parallel_load);
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -8,11 +8,27 @@
 #include "almond_voxel/editing/voxel_editing.hpp"
 #include "almond_voxel/generation/noise.hpp"
 #include "almond_voxel/material/voxel_material.hpp"
+#include "almond_voxel/meshing/apron.hpp"
+#include "almond_voxel/meshing/batch_mesher.hpp"
+#include "almond_voxel/meshing/binary_greedy_mesher.hpp"
 #include "almond_voxel/meshing/greedy_mesher.hpp"
 #include "almond_voxel/meshing/marching_cubes.hpp"
+#include "almond_voxel/meshing/marching_cubes_lod.hpp"
+#include "almond_voxel/meshing/mesh_context.hpp"
 #include "almond_voxel/meshing/mesh_types.hpp"
+#include "almond_voxel/meshing/packed_mesh.hpp"
+#include "almond_voxel/meshing/vertex_shading.hpp"
 #include "almond_voxel/navigation/voxel_nav.hpp"
+#include "almond_voxel/parallel/completion_queue.hpp"
+#include "almond_voxel/parallel/task_pool.hpp"
+#include "almond_voxel/serialization/chunk_delta.hpp"
+#include "almond_voxel/serialization/file_commit.hpp"
+#include "almond_voxel/serialization/mapped_region.hpp"
+#include "almond_voxel/serialization/region_file.hpp"
 #include "almond_voxel/serialization/region_io.hpp"
+#include "almond_voxel/storage/checksum.hpp"
+#include "almond_voxel/storage/codecs.hpp"
+#include "almond_voxel/storage/palette_plane.hpp"
 #include "almond_voxel/terrain/classic.hpp"
 #include "almond_voxel/world.hpp"
 #endif
@@ -3,26 +3,286 @@
 #include "almond_voxel/core.hpp"
 #include "almond_voxel/effects/effect_channels.hpp"
 #include "almond_voxel/material/voxel_material.hpp"
+#include "almond_voxel/storage/codecs.hpp"
+#include "almond_voxel/storage/palette_plane.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cstddef>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <span>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace almond::voxel {
 
+enum class voxel_layout : std::uint8_t {
+    dense,
+    palette
+};
+
+// Bit flags naming the individual chunk planes. Used for per-plane dirty tracking and listener filters.
+enum class chunk_plane : std::uint32_t {
+    none = 0u,
+    voxels = 1u << 0u,
+    skylight = 1u << 1u,
+    blocklight = 1u << 2u,
+    metadata = 1u << 3u,
+    materials = 1u << 4u,
+    skylight_cache = 1u << 5u,
+    blocklight_cache = 1u << 6u,
+    effect_density = 1u << 7u,
+    effect_velocity = 1u << 8u,
+    effect_lifetime = 1u << 9u,
+    lighting = skylight | blocklight | skylight_cache | blocklight_cache,
+    effects = effect_density | effect_velocity | effect_lifetime,
+    all = voxels | lighting | metadata | materials | effects
+};
+
+constexpr chunk_plane operator|(chunk_plane lhs, chunk_plane rhs) noexcept {
+    return static_cast<chunk_plane>(static_cast<std::uint32_t>(lhs) | static_cast<std::uint32_t>(rhs));
+}
+
+constexpr chunk_plane operator&(chunk_plane lhs, chunk_plane rhs) noexcept {
+    return static_cast<chunk_plane>(static_cast<std::uint32_t>(lhs) & static_cast<std::uint32_t>(rhs));
+}
+
+constexpr chunk_plane operator~(chunk_plane value) noexcept {
+    return static_cast<chunk_plane>(~static_cast<std::uint32_t>(value));
+}
+
+constexpr chunk_plane& operator|=(chunk_plane& lhs, chunk_plane rhs) noexcept {
+    lhs = lhs | rhs;
+    return lhs;
+}
+
+constexpr chunk_plane& operator&=(chunk_plane& lhs, chunk_plane rhs) noexcept {
+    lhs = lhs & rhs;
+    return lhs;
+}
+
+constexpr bool contains(chunk_plane flags, chunk_plane value) noexcept {
+    return (flags & value) != chunk_plane::none;
+}
+
+inline constexpr std::size_t chunk_plane_count = 10;
+
+// Bytes held by a chunk, split per plane. `overhead` covers the chunk object and its listener table.
+struct chunk_memory_usage {
+    std::array<std::size_t, chunk_plane_count> planes{};
+    std::size_t compressed{0};
+    std::size_t overhead{0};
+
+    [[nodiscard]] constexpr std::size_t bytes(chunk_plane mask) const noexcept {
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < chunk_plane_count; ++i) {
+            if (contains(mask, static_cast<chunk_plane>(1u << i))) {
+                sum += planes[i];
+            }
+        }
+        return sum;
+    }
+
+    [[nodiscard]] constexpr std::size_t total() const noexcept { return bytes(chunk_plane::all) + compressed + overhead; }
+
+    constexpr chunk_memory_usage& operator+=(const chunk_memory_usage& other) noexcept {
+        for (std::size_t i = 0; i < chunk_plane_count; ++i) {
+            planes[i] += other.planes[i];
+        }
+        compressed += other.compressed;
+        overhead += other.overhead;
+        return *this;
+    }
+
+    constexpr chunk_memory_usage& operator-=(const chunk_memory_usage& other) noexcept {
+        for (std::size_t i = 0; i < chunk_plane_count; ++i) {
+            planes[i] -= other.planes[i];
+        }
+        compressed -= other.compressed;
+        overhead -= other.overhead;
+        return *this;
+    }
+};
+
+// Codec used for each plane when a chunk compresses itself with the shared codec registry. The defaults favour fast
+// decoding: RLE for the integer planes, where terrain forms long runs along x, and delta + bit-packing for the float
+// planes. Switch noisy planes to `lz` or let `automatic` pick per plane at a higher encode cost.
+struct chunk_codec_config {
+    std::array<codec_id, chunk_plane_count> planes{codec_id::rle, codec_id::rle, codec_id::rle, codec_id::rle,
+        codec_id::rle, codec_id::delta_bitpack, codec_id::delta_bitpack, codec_id::delta_bitpack,
+        codec_id::delta_bitpack, codec_id::delta_bitpack};
+
+    [[nodiscard]] constexpr codec_id codec_for(chunk_plane plane) const noexcept {
+        return planes[static_cast<std::size_t>(std::countr_zero(static_cast<std::uint32_t>(plane)))];
+    }
+
+    constexpr chunk_codec_config& set(chunk_plane mask, codec_id id) noexcept {
+        for (std::size_t i = 0; i < chunk_plane_count; ++i) {
+            if (contains(mask, static_cast<chunk_plane>(1u << i))) {
+                planes[i] = id;
+            }
+        }
+        return *this;
+    }
+};
+
+// Describes one write to a chunk: which planes changed and the voxel box that contains the change.
+struct dirty_event {
+    chunk_plane planes{chunk_plane::none};
+    voxel_bounds bounds{};
+};
+
 struct chunk_storage_config {
     chunk_extent extent{cubic_extent(32)};
+    voxel_layout layout{voxel_layout::dense};
     bool enable_materials{false};
     bool enable_high_precision_lighting{false};
     effects::channel effect_channels{effects::channel::none};
 };
 
+// One value per plane, describing a chunk whose planes are all uniform.
+struct chunk_uniform_values {
+    voxel_id voxel{};
+    std::uint8_t skylight{0};
+    std::uint8_t blocklight{0};
+    std::uint8_t metadata{0};
+    material_index material{invalid_material_index};
+    float skylight_cache{0.0f};
+    float blocklight_cache{0.0f};
+    float effect_density{0.0f};
+    effects::velocity_sample effect_velocity{};
+    float effect_lifetime{0.0f};
+};
+
+// The planes of a chunk that currently hold a single value, and those values. Fields of other planes are unset.
+struct chunk_uniform_planes {
+    chunk_plane planes{chunk_plane::none};
+    chunk_uniform_values values{};
+};
+
+namespace detail {
+
+// Shared handle to one plane buffer. Snapshots share buffers with their chunk, and write() clones a buffer that someone
+// else still references, so a writer never disturbs a snapshot and untouched planes are never copied. An empty handle
+// reads as a default-constructed value.
+template <typename T>
+class cow_value {
+public:
+    cow_value() = default;
+    explicit cow_value(T value) : value_{std::make_shared<T>(std::move(value))} {}
+
+    [[nodiscard]] const T& operator*() const noexcept { return value_ ? *value_ : empty(); }
+    [[nodiscard]] const T* operator->() const noexcept { return &**this; }
+    [[nodiscard]] bool shared() const noexcept { return value_.use_count() > 1; }
+
+    [[nodiscard]] T& write() {
+        if (!value_) {
+            value_ = std::make_shared<T>();
+        } else if (value_.use_count() > 1) {
+            value_ = std::make_shared<T>(*value_);
+        }
+        return *value_;
+    }
+
+    void assign(T value) {
+        if (value_ && value_.use_count() == 1) {
+            *value_ = std::move(value);
+        } else {
+            value_ = std::make_shared<T>(std::move(value));
+        }
+    }
+
+    void reset() noexcept { value_.reset(); }
+
+private:
+    [[nodiscard]] static const T& empty() noexcept {
+        static const T value{};
+        return value;
+    }
+
+    std::shared_ptr<T> value_{};
+};
+
+// Plane storage that holds a single value until a dense array is needed. A read-only materialisation keeps the
+// uniform value valid so consumers can keep short-circuiting until the first mutable access.
+template <typename T>
+class lazy_plane {
+public:
+    using value_type = T;
+
+    [[nodiscard]] bool uniform() const noexcept { return value_valid_; }
+    [[nodiscard]] bool materialised() const noexcept { return !data_->empty(); }
+    [[nodiscard]] const T& value() const noexcept { return value_; }
+    [[nodiscard]] const T* data() const noexcept { return data_->data(); }
+
+    void reset(T value = T{}) {
+        data_.reset();
+        value_ = value;
+        value_valid_ = true;
+    }
+
+    void fill(T value) {
+        if (data_.shared()) {
+            data_.assign(std::vector<T>(data_->size(), value));
+        } else if (!data_->empty()) {
+            auto& data = data_.write();
+            std::fill(data.begin(), data.end(), value);
+        }
+        value_ = value;
+        value_valid_ = true;
+    }
+
+    [[nodiscard]] const T* read(std::size_t count) {
+        materialise(count);
+        return data_->data();
+    }
+
+    [[nodiscard]] T* write(std::size_t count) {
+        materialise(count);
+        value_valid_ = false;
+        return data_.write().data();
+    }
+
+    bool release() {
+        if (!value_valid_ || data_->empty()) {
+            return false;
+        }
+        data_.reset();
+        return true;
+    }
+
+    [[nodiscard]] std::size_t memory_usage() const noexcept { return data_->capacity() * sizeof(T); }
+
+    // Drops the dense array once a codec has encoded it; the plane is only read again after restore().
+    void discard() noexcept { data_.reset(); }
+
+    void restore(std::vector<T> data) {
+        data_.assign(std::move(data));
+        value_valid_ = false;
+    }
+
+private:
+    void materialise(std::size_t count) {
+        if (data_->empty() && count != 0) {
+            data_.assign(std::vector<T>(count, value_));
+        }
+    }
+
+    cow_value<std::vector<T>> data_{};
+    T value_{};
+    bool value_valid_{true};
+};
+
+} // namespace detail
+
 class chunk_storage {
 public:
     using byte_vector = std::vector<std::byte>;
@@ -53,6 +313,26 @@ public:
     using compress_callback = std::function<byte_vector(const const_planes_view&)>;
     using decompress_callback = std::function<void(const planes_view&, std::span<const std::byte>)>;
     using dirty_listener = std::function<void()>;
+    using plane_dirty_listener = std::function<void(const dirty_event&)>;
+
+    // Batches writes so listeners fire once with the union of touched planes when the scope commits or ends.
+    // Const accessors never mark the chunk dirty; non-const accessors mark only their own plane.
+    class write_scope {
+    public:
+        explicit write_scope(chunk_storage& chunk) noexcept;
+        write_scope(const write_scope&) = delete;
+        write_scope& operator=(const write_scope&) = delete;
+        ~write_scope() { commit(); }
+
+        [[nodiscard]] chunk_storage& chunk() const noexcept { return *chunk_; }
+        [[nodiscard]] chunk_storage* operator->() const noexcept { return chunk_; }
+
+        void commit() noexcept;
+
+    private:
+        chunk_storage* chunk_{nullptr};
+        bool open_{true};
+    };
 
     explicit chunk_storage(chunk_extent extent = cubic_extent(32));
     explicit chunk_storage(chunk_storage_config config);
@@ -64,17 +344,45 @@ public:
     [[nodiscard]] chunk_extent extent() const noexcept { return extent_; }
     [[nodiscard]] std::size_t volume() const noexcept { return extent_.volume(); }
 
-    [[nodiscard]] span3d<voxel_id> voxels() noexcept;
-    [[nodiscard]] span3d<const voxel_id> voxels() const noexcept;
-
-    [[nodiscard]] span3d<std::uint8_t> skylight() noexcept;
-    [[nodiscard]] span3d<const std::uint8_t> skylight() const noexcept;
-
-    [[nodiscard]] span3d<std::uint8_t> blocklight() noexcept;
-    [[nodiscard]] span3d<const std::uint8_t> blocklight() const noexcept;
-
-    [[nodiscard]] span3d<std::uint8_t> metadata() noexcept;
-    [[nodiscard]] span3d<const std::uint8_t> metadata() const noexcept;
+    [[nodiscard]] span3d<voxel_id> voxels();
+    [[nodiscard]] span3d<const voxel_id> voxels() const;
+
+    // Palette-aware access. The dense voxel array is only materialised by voxels(); these helpers read and write the
+    // packed palette directly while the chunk is compacted. On a palette chunk, voxels() const keeps a decoded copy
+    // beside the palette until the next set_voxel, which edits the palette and drops the copy. Read-only passes that
+    // should not leave a copy behind use read_voxels(), which decodes into the caller's scratch, or copy_voxel_row().
+    [[nodiscard]] voxel_layout layout() const noexcept;
+    [[nodiscard]] const palette_plane* palette() const noexcept { return palette_valid_ ? &*palette_ : nullptr; }
+    [[nodiscard]] voxel_id voxel_at(std::uint32_t x, std::uint32_t y, std::uint32_t z) const;
+    bool set_voxel(std::uint32_t x, std::uint32_t y, std::uint32_t z, voxel_id id);
+    void copy_voxels(voxel_span<voxel_id> out) const;
+    // Copies out.size() voxels along x starting at (x, y, z).
+    void copy_voxel_row(std::uint32_t x, std::uint32_t y, std::uint32_t z, voxel_span<voxel_id> out) const;
+    // The dense array when the chunk has one, otherwise the palette decoded into `scratch`.
+    [[nodiscard]] span3d<const voxel_id> read_voxels(std::vector<voxel_id>& scratch) const;
+    bool compact_voxels();
+
+    // Uniform chunks keep one value per plane and allocate nothing until the first write. Read-only consumers can test
+    // uniform_voxel() before calling voxels() to avoid materialising a dense plane.
+    [[nodiscard]] std::optional<voxel_id> uniform_voxel() const noexcept;
+    [[nodiscard]] std::optional<std::uint8_t> uniform_skylight() const noexcept;
+    [[nodiscard]] std::optional<std::uint8_t> uniform_blocklight() const noexcept;
+    [[nodiscard]] bool uniform() const noexcept;
+    [[nodiscard]] std::optional<chunk_uniform_values> uniform_values() const noexcept;
+    [[nodiscard]] chunk_uniform_planes uniform_planes() const noexcept;
+    bool release_uniform_planes();
+
+    // Heap bytes currently held, per plane. Uniform planes that were never materialised cost nothing.
+    [[nodiscard]] chunk_memory_usage memory_usage() const noexcept;
+
+    [[nodiscard]] span3d<std::uint8_t> skylight();
+    [[nodiscard]] span3d<const std::uint8_t> skylight() const;
+
+    [[nodiscard]] span3d<std::uint8_t> blocklight();
+    [[nodiscard]] span3d<const std::uint8_t> blocklight() const;
+
+    [[nodiscard]] span3d<std::uint8_t> metadata();
+    [[nodiscard]] span3d<const std::uint8_t> metadata() const;
 
     [[nodiscard]] bool materials_enabled() const noexcept { return materials_enabled_; }
     [[nodiscard]] span3d<material_index> materials();
@@ -103,59 +411,128 @@ public:
 
     void fill(voxel_id voxel, std::uint8_t sky_level = 0, std::uint8_t block_level = 0, std::uint8_t meta = 0,
         material_index material = invalid_material_index, float sky_cache = 0.0f, float block_cache = 0.0f);
+    void fill(const chunk_uniform_values& values);
     void assign_voxels(voxel_cspan<voxel_id> data);
 
+    // Built-in compression encodes every non-uniform plane through codec_registry::shared() and releases the dense
+    // arrays; the first access decodes them again. Palette-packed voxels stay packed. flush_compression() uses the
+    // built-in codecs unless custom hooks are installed.
+    bool compress(const chunk_codec_config& config);
+    bool compress() { return compress(codec_config_); }
+    void set_codec_config(const chunk_codec_config& config) noexcept { codec_config_ = config; }
+    [[nodiscard]] const chunk_codec_config& codec_config() const noexcept { return codec_config_; }
+
     void set_compression_hooks(compress_callback compressor, decompress_callback decompressor = {});
     void request_compression() noexcept { compression_requested_ = true; }
     [[nodiscard]] bool flush_compression();
     [[nodiscard]] bool decompress();
 
-    [[nodiscard]] bool compressed() const noexcept { return compressed_; }
-    [[nodiscard]] std::span<const std::byte> compressed_blob() const noexcept { return compressed_blob_; }
+    [[nodiscard]] bool compressed() const noexcept { return compressed_.load(std::memory_order_acquire); }
+    [[nodiscard]] std::span<const std::byte> compressed_blob() const noexcept { return *compressed_blob_; }
 
-    void clear_compression() {
-        compression_requested_ = false;
-        compressed_ = false;
-        compressed_blob_.clear();
-    }
+    // Drops the compressed blob. Blobs from custom hooks are discarded as-is; built-in blobs are decoded first because
+    // they own the only copy of their planes.
+    void clear_compression();
 
+    [[nodiscard]] write_scope edit() noexcept { return write_scope{*this}; }
+
+    // Cooperative guards for sharing one chunk between threads. Any number of threads may read through const
+    // accessors while holding a shared guard; writes, compression, fills and moves need the exclusive guard. Const
+    // accessors stay safe under a shared guard because lazy materialisation and decompression run under an internal
+    // mutex. Spans returned by const accessors are valid until the next exclusive section.
+    using shared_guard = std::shared_lock<std::shared_mutex>;
+    using exclusive_guard = std::unique_lock<std::shared_mutex>;
+    [[nodiscard]] shared_guard lock_shared() const { return shared_guard{access_mutex_}; }
+    [[nodiscard]] exclusive_guard lock_exclusive() const { return exclusive_guard{access_mutex_}; }
+    [[nodiscard]] exclusive_guard try_lock_exclusive() const { return exclusive_guard{access_mutex_, std::try_to_lock}; }
+
+    // Frozen copy of the current planes in O(1). Plane buffers stay shared until either side writes one, and only that
+    // plane is cloned. Dirty state, codec settings and compression hooks carry over; listeners do not. Take snapshots
+    // under at least a shared guard when other threads may be writing.
+    [[nodiscard]] std::shared_ptr<const chunk_storage> snapshot() const;
+
+    // mark_dirty(false) clears every plane without notifying listeners.
     void mark_dirty(bool value = true) noexcept;
-    [[nodiscard]] bool dirty() const noexcept { return dirty_; }
+    void mark_dirty(chunk_plane planes) noexcept;
+    void mark_dirty(chunk_plane planes, const voxel_bounds& bounds) noexcept;
+    void clear_dirty(chunk_plane planes = chunk_plane::all) noexcept;
+    [[nodiscard]] bool dirty() const noexcept { return dirty_planes_ != chunk_plane::none; }
+    [[nodiscard]] chunk_plane dirty_planes() const noexcept { return dirty_planes_; }
+
+    // Increments on every committed write notification and survives clear_dirty(), so a saved snapshot's revision
+    // names the baseline a later delta was taken against.
+    [[nodiscard]] std::uint64_t revision() const noexcept { return revision_; }
+
+    // Union of every box written since the last clear. set_voxel contributes a single cell; span accessors and fills
+    // contribute the whole extent.
+    [[nodiscard]] const voxel_bounds& dirty_bounds() const noexcept { return dirty_bounds_; }
+    void clear_dirty_bounds() noexcept { dirty_bounds_ = voxel_bounds{}; }
 
     void add_dirty_listener(dirty_listener listener);
+    void add_plane_dirty_listener(plane_dirty_listener listener, chunk_plane filter = chunk_plane::all);
     void clear_dirty_listeners();
 
 private:
-    void ensure_capacity();
-    [[nodiscard]] planes_view make_planes_view() noexcept;
-    [[nodiscard]] const_planes_view make_const_planes_view() const noexcept;
-    void ensure_decompressed();
-    void decompress_locked();
-
+    void reset_planes();
+    [[nodiscard]] std::size_t linear_index(std::uint32_t x, std::uint32_t y, std::uint32_t z) const noexcept {
+        return span3d<const voxel_id>{nullptr, extent_}.index(x, y, z);
+    }
+    [[nodiscard]] std::optional<voxel_id> uniform_voxel_locked() const noexcept;
+    [[nodiscard]] bool uniform_locked() const noexcept;
+    void ensure_dense_voxels() const;
+    [[nodiscard]] planes_view make_planes_view() const;
+    [[nodiscard]] const_planes_view make_const_planes_view() const;
+    void ensure_decompressed() const;
+    void decompress_locked() const;
+    template <typename T>
+    [[nodiscard]] const T* read_plane(detail::lazy_plane<T>& plane) const;
+    bool compress_locked(const chunk_codec_config& config);
+    void decode_planes_locked() const;
+    template <typename Fn>
+    void for_each_lazy_plane(Fn&& fn) const;
+
+    // Plane storage is mutable because const readers materialise uniform planes and decode compressed blobs on demand;
+    // those transitions happen under state_mutex_ so concurrent readers never observe them half done.
     chunk_extent extent_{};
-    std::vector<voxel_id> voxels_{};
-    std::vector<std::uint8_t> skylight_{};
-    std::vector<std::uint8_t> blocklight_{};
-    std::vector<std::uint8_t> metadata_{};
+    voxel_layout preferred_layout_{voxel_layout::dense};
+    mutable detail::cow_value<std::vector<voxel_id>> voxels_{};
+    mutable detail::cow_value<palette_plane> palette_{};
+    mutable bool palette_valid_{false};
+    mutable detail::lazy_plane<std::uint8_t> skylight_{};
+    mutable detail::lazy_plane<std::uint8_t> blocklight_{};
+    mutable detail::lazy_plane<std::uint8_t> metadata_{};
     bool materials_enabled_{false};
     bool high_precision_lighting_enabled_{false};
     effects::channel effect_channels_{effects::channel::none};
-    std::vector<material_index> materials_{};
-    std::vector<float> skylight_cache_{};
-    std::vector<float> blocklight_cache_{};
-    std::vector<float> effect_density_{};
-    std::vector<effects::velocity_sample> effect_velocity_{};
-    std::vector<float> effect_lifetime_{};
+    mutable detail::lazy_plane<material_index> materials_{};
+    mutable detail::lazy_plane<float> skylight_cache_{};
+    mutable detail::lazy_plane<float> blocklight_cache_{};
+    mutable detail::lazy_plane<float> effect_density_{};
+    mutable detail::lazy_plane<effects::velocity_sample> effect_velocity_{};
+    mutable detail::lazy_plane<float> effect_lifetime_{};
 
     compress_callback compress_{};
     decompress_callback decompress_{};
 
-    bool dirty_{false};
+    struct dirty_subscription {
+        plane_dirty_listener listener;
+        chunk_plane filter{chunk_plane::all};
+    };
+
+    chunk_plane dirty_planes_{chunk_plane::none};
+    chunk_plane pending_planes_{chunk_plane::none};
+    voxel_bounds dirty_bounds_{};
+    voxel_bounds pending_bounds_{};
+    std::uint32_t write_depth_{0};
+    std::uint64_t revision_{0};
     bool compression_requested_{false};
-    bool compressed_{false};
-    byte_vector compressed_blob_{};
-    std::mutex compression_mutex_{};
-    std::vector<dirty_listener> dirty_listeners_{};
+    mutable std::atomic<bool> compressed_{false};
+    mutable bool codec_blob_{false};
+    chunk_codec_config codec_config_{};
+    mutable detail::cow_value<byte_vector> compressed_blob_{};
+    mutable std::mutex state_mutex_{};
+    mutable std::shared_mutex access_mutex_{};
+    std::vector<dirty_subscription> dirty_listeners_{};
 };
 
 inline chunk_storage::chunk_storage(chunk_extent extent)
@@ -164,15 +541,19 @@ inline chunk_storage::chunk_storage(chunk_extent extent)
 
 inline chunk_storage::chunk_storage(chunk_storage_config config)
     : extent_{config.extent}
+    , preferred_layout_{config.layout}
     , materials_enabled_{config.enable_materials}
     , high_precision_lighting_enabled_{config.enable_high_precision_lighting}
     , effect_channels_{config.effect_channels} {
-    ensure_capacity();
+    reset_planes();
 }
 
 inline chunk_storage::chunk_storage(chunk_storage&& other) noexcept
     : extent_{other.extent_}
+    , preferred_layout_{other.preferred_layout_}
     , voxels_{std::move(other.voxels_)}
+    , palette_{std::move(other.palette_)}
+    , palette_valid_{other.palette_valid_}
     , skylight_{std::move(other.skylight_)}
     , blocklight_{std::move(other.blocklight_)}
     , metadata_{std::move(other.metadata_)}
@@ -187,32 +568,48 @@ inline chunk_storage::chunk_storage(chunk_storage&& other) noexcept
     , effect_lifetime_{std::move(other.effect_lifetime_)}
     , compress_{std::move(other.compress_)}
     , decompress_{std::move(other.decompress_)}
-    , dirty_{other.dirty_}
+    , dirty_planes_{other.dirty_planes_}
+    , pending_planes_{other.pending_planes_}
+    , dirty_bounds_{other.dirty_bounds_}
+    , pending_bounds_{other.pending_bounds_}
+    , write_depth_{other.write_depth_}
+    , revision_{other.revision_}
     , compression_requested_{other.compression_requested_}
-    , compressed_{other.compressed_}
+    , compressed_{other.compressed_.load()}
+    , codec_blob_{other.codec_blob_}
+    , codec_config_{other.codec_config_}
     , compressed_blob_{std::move(other.compressed_blob_)}
     , dirty_listeners_{std::move(other.dirty_listeners_)} {
     other.extent_ = chunk_extent{};
+    other.palette_valid_ = false;
     other.materials_enabled_ = false;
     other.high_precision_lighting_enabled_ = false;
     other.effect_channels_ = effects::channel::none;
-    other.materials_.clear();
-    other.skylight_cache_.clear();
-    other.blocklight_cache_.clear();
-    other.effect_density_.clear();
-    other.effect_velocity_.clear();
-    other.effect_lifetime_.clear();
-    other.dirty_ = false;
+    other.materials_.reset(invalid_material_index);
+    other.skylight_cache_.reset();
+    other.blocklight_cache_.reset();
+    other.effect_density_.reset();
+    other.effect_velocity_.reset();
+    other.effect_lifetime_.reset();
+    other.dirty_planes_ = chunk_plane::none;
+    other.pending_planes_ = chunk_plane::none;
+    other.dirty_bounds_ = voxel_bounds{};
+    other.pending_bounds_ = voxel_bounds{};
+    other.write_depth_ = 0;
     other.compression_requested_ = false;
-    other.compressed_ = false;
+    other.compressed_.store(false);
+    other.codec_blob_ = false;
     other.dirty_listeners_.clear();
 }
 
 inline chunk_storage& chunk_storage::operator=(chunk_storage&& other) noexcept {
     if (this != &other) {
-        std::scoped_lock lock{compression_mutex_, other.compression_mutex_};
+        std::scoped_lock lock{state_mutex_, other.state_mutex_};
         extent_ = other.extent_;
+        preferred_layout_ = other.preferred_layout_;
         voxels_ = std::move(other.voxels_);
+        palette_ = std::move(other.palette_);
+        palette_valid_ = other.palette_valid_;
         skylight_ = std::move(other.skylight_);
         blocklight_ = std::move(other.blocklight_);
         metadata_ = std::move(other.metadata_);
@@ -227,26 +624,39 @@ inline chunk_storage& chunk_storage::operator=(chunk_storage&& other) noexcept {
         effect_lifetime_ = std::move(other.effect_lifetime_);
         compress_ = std::move(other.compress_);
         decompress_ = std::move(other.decompress_);
-        dirty_ = other.dirty_;
+        dirty_planes_ = other.dirty_planes_;
+        pending_planes_ = other.pending_planes_;
+        dirty_bounds_ = other.dirty_bounds_;
+        pending_bounds_ = other.pending_bounds_;
+        write_depth_ = other.write_depth_;
+        revision_ = other.revision_;
         compression_requested_ = other.compression_requested_;
-        compressed_ = other.compressed_;
+        compressed_.store(other.compressed_.load());
+        codec_blob_ = other.codec_blob_;
+        codec_config_ = other.codec_config_;
         compressed_blob_ = std::move(other.compressed_blob_);
         dirty_listeners_ = std::move(other.dirty_listeners_);
 
         other.extent_ = chunk_extent{};
+        other.palette_valid_ = false;
         other.materials_enabled_ = false;
         other.high_precision_lighting_enabled_ = false;
         other.effect_channels_ = effects::channel::none;
-        other.materials_.clear();
-        other.skylight_cache_.clear();
-        other.blocklight_cache_.clear();
-        other.effect_density_.clear();
-        other.effect_velocity_.clear();
-        other.effect_lifetime_.clear();
-        other.dirty_ = false;
+        other.materials_.reset(invalid_material_index);
+        other.skylight_cache_.reset();
+        other.blocklight_cache_.reset();
+        other.effect_density_.reset();
+        other.effect_velocity_.reset();
+        other.effect_lifetime_.reset();
+        other.dirty_planes_ = chunk_plane::none;
+        other.pending_planes_ = chunk_plane::none;
+        other.dirty_bounds_ = voxel_bounds{};
+        other.pending_bounds_ = voxel_bounds{};
+        other.write_depth_ = 0;
         other.compression_requested_ = false;
-        other.compressed_ = false;
-        other.compressed_blob_.clear();
+        other.compressed_.store(false);
+        other.codec_blob_ = false;
+        other.compressed_blob_.reset();
         other.compress_ = {};
         other.decompress_ = {};
         other.dirty_listeners_.clear();
@@ -254,70 +664,380 @@ inline chunk_storage& chunk_storage::operator=(chunk_storage&& other) noexcept {
     return *this;
 }
 
+inline std::shared_ptr<const chunk_storage> chunk_storage::snapshot() const {
+    auto copy = std::make_shared<chunk_storage>(chunk_storage_config{extent_, preferred_layout_, materials_enabled_,
+        high_precision_lighting_enabled_, effect_channels_});
+    std::scoped_lock lock{state_mutex_};
+    copy->voxels_ = voxels_;
+    copy->palette_ = palette_;
+    copy->palette_valid_ = palette_valid_;
+    copy->skylight_ = skylight_;
+    copy->blocklight_ = blocklight_;
+    copy->metadata_ = metadata_;
+    copy->materials_ = materials_;
+    copy->skylight_cache_ = skylight_cache_;
+    copy->blocklight_cache_ = blocklight_cache_;
+    copy->effect_density_ = effect_density_;
+    copy->effect_velocity_ = effect_velocity_;
+    copy->effect_lifetime_ = effect_lifetime_;
+    copy->compress_ = compress_;
+    copy->decompress_ = decompress_;
+    copy->dirty_planes_ = dirty_planes_;
+    copy->dirty_bounds_ = dirty_bounds_;
+    copy->revision_ = revision_;
+    copy->compressed_.store(compressed_.load());
+    copy->codec_blob_ = codec_blob_;
+    copy->codec_config_ = codec_config_;
+    copy->compressed_blob_ = compressed_blob_;
+    return copy;
+}
+
+inline chunk_storage::write_scope::write_scope(chunk_storage& chunk) noexcept
+    : chunk_{&chunk} {
+    ++chunk_->write_depth_;
+}
+
+inline void chunk_storage::write_scope::commit() noexcept {
+    if (!open_) {
+        return;
+    }
+    open_ = false;
+    if (--chunk_->write_depth_ == 0 && chunk_->pending_planes_ != chunk_plane::none) {
+        const chunk_plane planes = chunk_->pending_planes_;
+        const voxel_bounds bounds = chunk_->pending_bounds_;
+        chunk_->pending_planes_ = chunk_plane::none;
+        chunk_->pending_bounds_ = voxel_bounds{};
+        chunk_->mark_dirty(planes, bounds);
+    }
+}
+
 inline void chunk_storage::mark_dirty(bool value) noexcept {
-    const bool notify = value;
-    if (dirty_ != value) {
-        dirty_ = value;
-    }
-    if (notify && !dirty_listeners_.empty()) {
-        for (auto& listener : dirty_listeners_) {
-            if (listener) {
-                listener();
-            }
+    if (!value) {
+        dirty_planes_ = chunk_plane::none;
+        pending_planes_ = chunk_plane::none;
+        dirty_bounds_ = voxel_bounds{};
+        pending_bounds_ = voxel_bounds{};
+        return;
+    }
+    mark_dirty(chunk_plane::all);
+}
+
+inline void chunk_storage::mark_dirty(chunk_plane planes) noexcept {
+    mark_dirty(planes, voxel_bounds::full(extent_));
+}
+
+inline void chunk_storage::mark_dirty(chunk_plane planes, const voxel_bounds& bounds) noexcept {
+    if (planes == chunk_plane::none || bounds.empty()) {
+        return;
+    }
+    if (write_depth_ > 0) {
+        pending_planes_ |= planes;
+        pending_bounds_.merge(bounds);
+        return;
+    }
+    dirty_planes_ |= planes;
+    dirty_bounds_.merge(bounds);
+    ++revision_;
+    const dirty_event event{planes, bounds};
+    for (auto& subscription : dirty_listeners_) {
+        if (subscription.listener && contains(subscription.filter, planes)) {
+            subscription.listener(event);
         }
     }
 }
 
+inline void chunk_storage::clear_dirty(chunk_plane planes) noexcept {
+    dirty_planes_ &= ~planes;
+    if (dirty_planes_ == chunk_plane::none) {
+        dirty_bounds_ = voxel_bounds{};
+    }
+}
+
 inline void chunk_storage::add_dirty_listener(dirty_listener listener) {
-    dirty_listeners_.push_back(std::move(listener));
+    if (!listener) {
+        return;
+    }
+    dirty_listeners_.push_back(dirty_subscription{
+        [listener = std::move(listener)](const dirty_event&) { listener(); }, chunk_plane::all});
+}
+
+inline void chunk_storage::add_plane_dirty_listener(plane_dirty_listener listener, chunk_plane filter) {
+    dirty_listeners_.push_back(dirty_subscription{std::move(listener), filter});
 }
 
 inline void chunk_storage::clear_dirty_listeners() {
     dirty_listeners_.clear();
 }
 
-inline span3d<voxel_id> chunk_storage::voxels() noexcept {
+inline span3d<voxel_id> chunk_storage::voxels() {
+    ensure_decompressed();
+    ensure_dense_voxels();
+    palette_valid_ = false;
+    mark_dirty(chunk_plane::voxels);
+    return make_span3d(voxels_.write().data(), extent_);
+}
+
+inline span3d<const voxel_id> chunk_storage::voxels() const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    ensure_dense_voxels();
+    return make_span3d(voxels_->data(), extent_);
+}
+
+inline voxel_layout chunk_storage::layout() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    return voxels_->empty() && palette_valid_ ? voxel_layout::palette : voxel_layout::dense;
+}
+
+inline voxel_id chunk_storage::voxel_at(std::uint32_t x, std::uint32_t y, std::uint32_t z) const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    const auto index = linear_index(x, y, z);
+    // A valid palette is authoritative even when the dense array has been materialised alongside it.
+    if (palette_valid_) {
+        return palette_->get(index);
+    }
+    return voxels_->empty() ? voxel_id{} : (*voxels_)[index];
+}
+
+inline bool chunk_storage::set_voxel(std::uint32_t x, std::uint32_t y, std::uint32_t z, voxel_id id) {
+    if (!extent_.contains(x, y, z)) {
+        return false;
+    }
+    const auto index = linear_index(x, y, z);
+    if (voxel_at(x, y, z) == id) {
+        return true;
+    }
+    if (palette_valid_ && preferred_layout_ == voxel_layout::palette) {
+        // Any dense array is a copy decoded by a const read; drop it rather than letting the edit leave the chunk dense.
+        palette_.write().set(index, id);
+        voxels_.reset();
+        mark_dirty(chunk_plane::voxels, voxel_bounds::cell(x, y, z));
+        return true;
+    }
+    if (voxels_->empty() && preferred_layout_ == voxel_layout::dense) {
+        ensure_dense_voxels();
+    }
+    if (!voxels_->empty()) {
+        voxels_.write()[index] = id;
+        palette_valid_ = false;
+    } else if (palette_valid_) {
+        palette_.write().set(index, id);
+    } else {
+        return false;
+    }
+    mark_dirty(chunk_plane::voxels, voxel_bounds::cell(x, y, z));
+    return true;
+}
+
+inline void chunk_storage::copy_voxels(voxel_span<voxel_id> out) const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    if (out.size() != extent_.volume()) {
+        throw std::runtime_error("voxel data size mismatch");
+    }
+    if (palette_valid_) {
+        palette_->decode(out);
+    } else if (!voxels_->empty()) {
+        std::copy(voxels_->begin(), voxels_->end(), out.begin());
+    }
+}
+
+inline void chunk_storage::copy_voxel_row(std::uint32_t x, std::uint32_t y, std::uint32_t z,
+    voxel_span<voxel_id> out) const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    if (out.empty()) {
+        return;
+    }
+    if (!extent_.contains(x + static_cast<std::uint32_t>(out.size()) - 1, y, z)) {
+        throw std::out_of_range("voxel row lies outside the chunk");
+    }
+    const auto start = linear_index(x, y, z);
+    if (palette_valid_) {
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            out[i] = palette_->get(start + i);
+        }
+    } else if (!voxels_->empty()) {
+        std::copy_n(voxels_->begin() + static_cast<std::ptrdiff_t>(start), out.size(), out.begin());
+    } else {
+        std::fill(out.begin(), out.end(), voxel_id{});
+    }
+}
+
+inline span3d<const voxel_id> chunk_storage::read_voxels(std::vector<voxel_id>& scratch) const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    if (!voxels_->empty()) {
+        return make_span3d(voxels_->data(), extent_);
+    }
+    scratch.resize(extent_.volume());
+    if (palette_valid_) {
+        palette_->decode(scratch);
+    } else {
+        std::fill(scratch.begin(), scratch.end(), voxel_id{});
+    }
+    return make_span3d(static_cast<const voxel_id*>(scratch.data()), extent_);
+}
+
+inline bool chunk_storage::compact_voxels() {
+    ensure_decompressed();
+    if (voxels_->empty()) {
+        return palette_valid_;
+    }
+    if (!palette_valid_) {
+        palette_.assign(palette_plane::from_dense(*voxels_));
+        palette_valid_ = true;
+    }
+    voxels_.reset();
+    return true;
+}
+
+inline std::optional<voxel_id> chunk_storage::uniform_voxel() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    return uniform_voxel_locked();
+}
+
+inline std::optional<voxel_id> chunk_storage::uniform_voxel_locked() const noexcept {
+    if (compressed() || !palette_valid_ || palette_->bits_per_index() != 0 || palette_->palette().empty()) {
+        return std::nullopt;
+    }
+    return palette_->palette().front();
+}
+
+inline std::optional<std::uint8_t> chunk_storage::uniform_skylight() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    return skylight_.uniform() ? std::optional<std::uint8_t>{skylight_.value()} : std::nullopt;
+}
+
+inline std::optional<std::uint8_t> chunk_storage::uniform_blocklight() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    return blocklight_.uniform() ? std::optional<std::uint8_t>{blocklight_.value()} : std::nullopt;
+}
+
+inline bool chunk_storage::uniform() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    return uniform_locked();
+}
+
+inline bool chunk_storage::uniform_locked() const noexcept {
+    return uniform_voxel_locked().has_value() && skylight_.uniform() && blocklight_.uniform() && metadata_.uniform()
+        && materials_.uniform() && skylight_cache_.uniform() && blocklight_cache_.uniform()
+        && effect_density_.uniform() && effect_velocity_.uniform() && effect_lifetime_.uniform();
+}
+
+inline std::optional<chunk_uniform_values> chunk_storage::uniform_values() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    if (!uniform_locked()) {
+        return std::nullopt;
+    }
+    chunk_uniform_values values{};
+    values.voxel = *uniform_voxel_locked();
+    values.skylight = skylight_.value();
+    values.blocklight = blocklight_.value();
+    values.metadata = metadata_.value();
+    values.material = materials_.value();
+    values.skylight_cache = skylight_cache_.value();
+    values.blocklight_cache = blocklight_cache_.value();
+    values.effect_density = effect_density_.value();
+    values.effect_velocity = effect_velocity_.value();
+    values.effect_lifetime = effect_lifetime_.value();
+    return values;
+}
+
+inline chunk_uniform_planes chunk_storage::uniform_planes() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    chunk_uniform_planes result{};
+    if (const auto voxel = uniform_voxel_locked()) {
+        result.planes |= chunk_plane::voxels;
+        result.values.voxel = *voxel;
+    }
+    const auto take = [&](chunk_plane plane, const auto& source, auto& value) {
+        if (source.uniform()) {
+            result.planes |= plane;
+            value = source.value();
+        }
+    };
+    take(chunk_plane::skylight, skylight_, result.values.skylight);
+    take(chunk_plane::blocklight, blocklight_, result.values.blocklight);
+    take(chunk_plane::metadata, metadata_, result.values.metadata);
+    take(chunk_plane::materials, materials_, result.values.material);
+    take(chunk_plane::skylight_cache, skylight_cache_, result.values.skylight_cache);
+    take(chunk_plane::blocklight_cache, blocklight_cache_, result.values.blocklight_cache);
+    take(chunk_plane::effect_density, effect_density_, result.values.effect_density);
+    take(chunk_plane::effect_velocity, effect_velocity_, result.values.effect_velocity);
+    take(chunk_plane::effect_lifetime, effect_lifetime_, result.values.effect_lifetime);
+    return result;
+}
+
+inline bool chunk_storage::release_uniform_planes() {
     ensure_decompressed();
-    mark_dirty();
-    return make_span3d(voxels_.data(), extent_);
+    bool released = false;
+    if (uniform_voxel() && !voxels_->empty()) {
+        voxels_.reset();
+        released = true;
+    }
+    released = skylight_.release() || released;
+    released = blocklight_.release() || released;
+    released = metadata_.release() || released;
+    released = materials_.release() || released;
+    released = skylight_cache_.release() || released;
+    released = blocklight_cache_.release() || released;
+    released = effect_density_.release() || released;
+    released = effect_velocity_.release() || released;
+    released = effect_lifetime_.release() || released;
+    return released;
 }
 
-inline span3d<const voxel_id> chunk_storage::voxels() const noexcept {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    return make_span3d(voxels_.data(), extent_);
+inline chunk_memory_usage chunk_storage::memory_usage() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    chunk_memory_usage usage{};
+    const auto slot = [&](chunk_plane plane) -> std::size_t& {
+        return usage.planes[static_cast<std::size_t>(std::countr_zero(static_cast<std::uint32_t>(plane)))];
+    };
+    slot(chunk_plane::voxels) = voxels_->capacity() * sizeof(voxel_id) + palette_->memory_usage();
+    slot(chunk_plane::skylight) = skylight_.memory_usage();
+    slot(chunk_plane::blocklight) = blocklight_.memory_usage();
+    slot(chunk_plane::metadata) = metadata_.memory_usage();
+    slot(chunk_plane::materials) = materials_.memory_usage();
+    slot(chunk_plane::skylight_cache) = skylight_cache_.memory_usage();
+    slot(chunk_plane::blocklight_cache) = blocklight_cache_.memory_usage();
+    slot(chunk_plane::effect_density) = effect_density_.memory_usage();
+    slot(chunk_plane::effect_velocity) = effect_velocity_.memory_usage();
+    slot(chunk_plane::effect_lifetime) = effect_lifetime_.memory_usage();
+    usage.compressed = compressed_blob_->capacity();
+    usage.overhead = sizeof(chunk_storage) + dirty_listeners_.capacity() * sizeof(dirty_subscription);
+    return usage;
 }
 
-inline span3d<std::uint8_t> chunk_storage::skylight() noexcept {
+inline span3d<std::uint8_t> chunk_storage::skylight() {
     ensure_decompressed();
-    mark_dirty();
-    return make_span3d(skylight_.data(), extent_);
+    mark_dirty(chunk_plane::skylight);
+    return make_span3d(skylight_.write(volume()), extent_);
 }
 
-inline span3d<const std::uint8_t> chunk_storage::skylight() const noexcept {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    return make_span3d(skylight_.data(), extent_);
+inline span3d<const std::uint8_t> chunk_storage::skylight() const {
+    return make_span3d(read_plane(skylight_), extent_);
 }
 
-inline span3d<std::uint8_t> chunk_storage::blocklight() noexcept {
+inline span3d<std::uint8_t> chunk_storage::blocklight() {
     ensure_decompressed();
-    mark_dirty();
-    return make_span3d(blocklight_.data(), extent_);
+    mark_dirty(chunk_plane::blocklight);
+    return make_span3d(blocklight_.write(volume()), extent_);
 }
 
-inline span3d<const std::uint8_t> chunk_storage::blocklight() const noexcept {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    return make_span3d(blocklight_.data(), extent_);
+inline span3d<const std::uint8_t> chunk_storage::blocklight() const {
+    return make_span3d(read_plane(blocklight_), extent_);
 }
 
-inline span3d<std::uint8_t> chunk_storage::metadata() noexcept {
+inline span3d<std::uint8_t> chunk_storage::metadata() {
     ensure_decompressed();
-    mark_dirty();
-    return make_span3d(metadata_.data(), extent_);
+    mark_dirty(chunk_plane::metadata);
+    return make_span3d(metadata_.write(volume()), extent_);
 }
 
-inline span3d<const std::uint8_t> chunk_storage::metadata() const noexcept {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    return make_span3d(metadata_.data(), extent_);
+inline span3d<const std::uint8_t> chunk_storage::metadata() const {
+    return make_span3d(read_plane(metadata_), extent_);
 }
 
 inline span3d<material_index> chunk_storage::materials() {
@@ -325,16 +1045,15 @@ inline span3d<material_index> chunk_storage::materials() {
     if (!materials_enabled_) {
         throw std::logic_error("material plane is disabled");
     }
-    mark_dirty();
-    return make_span3d(materials_.data(), extent_);
+    mark_dirty(chunk_plane::materials);
+    return make_span3d(materials_.write(volume()), extent_);
 }
 
 inline span3d<const material_index> chunk_storage::materials() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
     if (!materials_enabled_) {
         throw std::logic_error("material plane is disabled");
     }
-    return make_span3d(materials_.data(), extent_);
+    return make_span3d(read_plane(materials_), extent_);
 }
 
 inline span3d<float> chunk_storage::skylight_cache() {
@@ -342,16 +1061,15 @@ inline span3d<float> chunk_storage::skylight_cache() {
     if (!high_precision_lighting_enabled_) {
         throw std::logic_error("high precision lighting cache is disabled");
     }
-    mark_dirty();
-    return make_span3d(skylight_cache_.data(), extent_);
+    mark_dirty(chunk_plane::skylight_cache);
+    return make_span3d(skylight_cache_.write(volume()), extent_);
 }
 
 inline span3d<const float> chunk_storage::skylight_cache() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
     if (!high_precision_lighting_enabled_) {
         throw std::logic_error("high precision lighting cache is disabled");
     }
-    return make_span3d(skylight_cache_.data(), extent_);
+    return make_span3d(read_plane(skylight_cache_), extent_);
 }
 
 inline span3d<float> chunk_storage::blocklight_cache() {
@@ -359,16 +1077,15 @@ inline span3d<float> chunk_storage::blocklight_cache() {
     if (!high_precision_lighting_enabled_) {
         throw std::logic_error("high precision lighting cache is disabled");
     }
-    mark_dirty();
-    return make_span3d(blocklight_cache_.data(), extent_);
+    mark_dirty(chunk_plane::blocklight_cache);
+    return make_span3d(blocklight_cache_.write(volume()), extent_);
 }
 
 inline span3d<const float> chunk_storage::blocklight_cache() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
     if (!high_precision_lighting_enabled_) {
         throw std::logic_error("high precision lighting cache is disabled");
     }
-    return make_span3d(blocklight_cache_.data(), extent_);
+    return make_span3d(read_plane(blocklight_cache_), extent_);
 }
 
 inline bool chunk_storage::effect_density_enabled() const noexcept {
@@ -390,39 +1107,20 @@ inline void chunk_storage::set_effect_channels(effects::channel channels) {
     }
     const effects::channel previous = effect_channels_;
     effect_channels_ = channels;
-    const auto count = extent_.volume();
 
-    if (effects::contains(channels, effects::channel::density)) {
-        if (!effects::contains(previous, effects::channel::density)) {
-            effect_density_.assign(count, 0.0f);
-        } else if (effect_density_.size() != count) {
-            effect_density_.resize(count, 0.0f);
-        }
-    } else {
-        effect_density_.clear();
+    if (!effects::contains(channels, effects::channel::density) || !effects::contains(previous, effects::channel::density)) {
+        effect_density_.reset(0.0f);
     }
-
-    if (effects::contains(channels, effects::channel::velocity)) {
-        if (!effects::contains(previous, effects::channel::velocity)) {
-            effect_velocity_.assign(count, effects::velocity_sample{});
-        } else if (effect_velocity_.size() != count) {
-            effect_velocity_.resize(count, effects::velocity_sample{});
-        }
-    } else {
-        effect_velocity_.clear();
+    if (!effects::contains(channels, effects::channel::velocity)
+        || !effects::contains(previous, effects::channel::velocity)) {
+        effect_velocity_.reset(effects::velocity_sample{});
     }
-
-    if (effects::contains(channels, effects::channel::lifetime)) {
-        if (!effects::contains(previous, effects::channel::lifetime)) {
-            effect_lifetime_.assign(count, 0.0f);
-        } else if (effect_lifetime_.size() != count) {
-            effect_lifetime_.resize(count, 0.0f);
-        }
-    } else {
-        effect_lifetime_.clear();
+    if (!effects::contains(channels, effects::channel::lifetime)
+        || !effects::contains(previous, effects::channel::lifetime)) {
+        effect_lifetime_.reset(0.0f);
     }
 
-    mark_dirty();
+    mark_dirty(chunk_plane::effects);
 }
 
 inline void chunk_storage::enable_effect_channels(effects::channel channels) {
@@ -434,16 +1132,15 @@ inline span3d<float> chunk_storage::effect_density() {
     if (!effect_density_enabled()) {
         throw std::logic_error("effect density channel is disabled");
     }
-    mark_dirty();
-    return make_span3d(effect_density_.data(), extent_);
+    mark_dirty(chunk_plane::effect_density);
+    return make_span3d(effect_density_.write(volume()), extent_);
 }
 
 inline span3d<const float> chunk_storage::effect_density() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
     if (!effect_density_enabled()) {
         throw std::logic_error("effect density channel is disabled");
     }
-    return make_span3d(effect_density_.data(), extent_);
+    return make_span3d(read_plane(effect_density_), extent_);
 }
 
 inline span3d<effects::velocity_sample> chunk_storage::effect_velocity() {
@@ -451,16 +1148,15 @@ inline span3d<effects::velocity_sample> chunk_storage::effect_velocity() {
     if (!effect_velocity_enabled()) {
         throw std::logic_error("effect velocity channel is disabled");
     }
-    mark_dirty();
-    return make_span3d(effect_velocity_.data(), extent_);
+    mark_dirty(chunk_plane::effect_velocity);
+    return make_span3d(effect_velocity_.write(volume()), extent_);
 }
 
 inline span3d<const effects::velocity_sample> chunk_storage::effect_velocity() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
     if (!effect_velocity_enabled()) {
         throw std::logic_error("effect velocity channel is disabled");
     }
-    return make_span3d(effect_velocity_.data(), extent_);
+    return make_span3d(read_plane(effect_velocity_), extent_);
 }
 
 inline span3d<float> chunk_storage::effect_lifetime() {
@@ -468,182 +1164,364 @@ inline span3d<float> chunk_storage::effect_lifetime() {
     if (!effect_lifetime_enabled()) {
         throw std::logic_error("effect lifetime channel is disabled");
     }
-    mark_dirty();
-    return make_span3d(effect_lifetime_.data(), extent_);
+    mark_dirty(chunk_plane::effect_lifetime);
+    return make_span3d(effect_lifetime_.write(volume()), extent_);
 }
 
 inline span3d<const float> chunk_storage::effect_lifetime() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
     if (!effect_lifetime_enabled()) {
         throw std::logic_error("effect lifetime channel is disabled");
     }
-    return make_span3d(effect_lifetime_.data(), extent_);
+    return make_span3d(read_plane(effect_lifetime_), extent_);
 }
 
 inline void chunk_storage::fill(voxel_id voxel, std::uint8_t sky_level, std::uint8_t block_level, std::uint8_t meta,
     material_index material, float sky_cache, float block_cache) {
+    chunk_uniform_values values{};
+    values.voxel = voxel;
+    values.skylight = sky_level;
+    values.blocklight = block_level;
+    values.metadata = meta;
+    values.material = material;
+    values.skylight_cache = sky_cache;
+    values.blocklight_cache = block_cache;
+    fill(values);
+}
+
+inline void chunk_storage::fill(const chunk_uniform_values& values) {
     ensure_decompressed();
-    std::fill(voxels_.begin(), voxels_.end(), voxel);
-    std::fill(skylight_.begin(), skylight_.end(), sky_level);
-    std::fill(blocklight_.begin(), blocklight_.end(), block_level);
-    std::fill(metadata_.begin(), metadata_.end(), meta);
+    palette_.assign(palette_plane{extent_.volume(), values.voxel});
+    palette_valid_ = true;
+    if (voxels_.shared()) {
+        voxels_.assign(std::vector<voxel_id>(voxels_->size(), values.voxel));
+    } else if (!voxels_->empty()) {
+        auto& dense = voxels_.write();
+        std::fill(dense.begin(), dense.end(), values.voxel);
+    }
+    skylight_.fill(values.skylight);
+    blocklight_.fill(values.blocklight);
+    metadata_.fill(values.metadata);
     if (materials_enabled_) {
-        std::fill(materials_.begin(), materials_.end(), material);
+        materials_.fill(values.material);
     }
     if (high_precision_lighting_enabled_) {
-        std::fill(skylight_cache_.begin(), skylight_cache_.end(), sky_cache);
-        std::fill(blocklight_cache_.begin(), blocklight_cache_.end(), block_cache);
+        skylight_cache_.fill(values.skylight_cache);
+        blocklight_cache_.fill(values.blocklight_cache);
     }
     if (effect_density_enabled()) {
-        std::fill(effect_density_.begin(), effect_density_.end(), 0.0f);
+        effect_density_.fill(values.effect_density);
     }
     if (effect_velocity_enabled()) {
-        std::fill(effect_velocity_.begin(), effect_velocity_.end(), effects::velocity_sample{});
+        effect_velocity_.fill(values.effect_velocity);
     }
     if (effect_lifetime_enabled()) {
-        std::fill(effect_lifetime_.begin(), effect_lifetime_.end(), 0.0f);
+        effect_lifetime_.fill(values.effect_lifetime);
     }
-    mark_dirty();
+    mark_dirty(chunk_plane::all);
 }
 
 inline void chunk_storage::assign_voxels(voxel_cspan<voxel_id> data) {
     ensure_decompressed();
-    if (data.size() != voxels_.size()) {
+    if (data.size() != extent_.volume()) {
         throw std::runtime_error("voxel data size mismatch");
     }
-    std::copy(data.begin(), data.end(), voxels_.begin());
-    mark_dirty();
+    if (voxels_->empty() && preferred_layout_ == voxel_layout::palette) {
+        palette_.assign(palette_plane::from_dense(data));
+        palette_valid_ = true;
+    } else {
+        voxels_.assign(std::vector<voxel_id>(data.begin(), data.end()));
+        palette_valid_ = false;
+    }
+    mark_dirty(chunk_plane::voxels);
 }
 
 inline void chunk_storage::set_compression_hooks(compress_callback compressor, decompress_callback decompressor) {
-    std::scoped_lock lock{compression_mutex_};
+    std::scoped_lock lock{state_mutex_};
     compress_ = std::move(compressor);
     decompress_ = std::move(decompressor);
 }
 
+inline bool chunk_storage::compress(const chunk_codec_config& config) {
+    std::scoped_lock lock{state_mutex_};
+    if (compressed_) {
+        return false;
+    }
+    compression_requested_ = false;
+    return compress_locked(config);
+}
+
 inline bool chunk_storage::flush_compression() {
-    std::scoped_lock lock{compression_mutex_};
-    if (!compression_requested_ || !compress_) {
+    std::scoped_lock lock{state_mutex_};
+    if (!compression_requested_) {
         return false;
     }
+    if (!compress_) {
+        compression_requested_ = false;
+        return compressed_ || compress_locked(codec_config_);
+    }
     decompress_locked();
     const auto view = make_const_planes_view();
-    compressed_blob_ = compress_(view);
+    compressed_blob_.assign(compress_(view));
     compression_requested_ = false;
     compressed_ = true;
     return true;
 }
 
 inline bool chunk_storage::decompress() {
-    std::scoped_lock lock{compression_mutex_};
-    if (!compressed_ || compressed_blob_.empty()) {
+    std::scoped_lock lock{state_mutex_};
+    if (!compressed_ || compressed_blob_->empty()) {
         return false;
     }
     decompress_locked();
     return true;
 }
 
-inline void chunk_storage::ensure_capacity() {
-    const auto count = extent_.volume();
-    voxels_.assign(count, voxel_id{});
-    skylight_.assign(count, std::uint8_t{});
-    blocklight_.assign(count, std::uint8_t{});
-    metadata_.assign(count, std::uint8_t{});
-    if (materials_enabled_) {
-        materials_.assign(count, invalid_material_index);
-    } else {
-        materials_.clear();
-    }
-    if (high_precision_lighting_enabled_) {
-        skylight_cache_.assign(count, 0.0f);
-        blocklight_cache_.assign(count, 0.0f);
-    } else {
-        skylight_cache_.clear();
-        blocklight_cache_.clear();
-    }
-    if (effect_density_enabled()) {
-        effect_density_.assign(count, 0.0f);
-    } else {
-        effect_density_.clear();
-    }
-    if (effect_velocity_enabled()) {
-        effect_velocity_.assign(count, effects::velocity_sample{});
-    } else {
-        effect_velocity_.clear();
-    }
-    if (effect_lifetime_enabled()) {
-        effect_lifetime_.assign(count, 0.0f);
-    } else {
-        effect_lifetime_.clear();
+inline void chunk_storage::clear_compression() {
+    std::scoped_lock lock{state_mutex_};
+    if (codec_blob_) {
+        decompress_locked();
     }
+    compression_requested_ = false;
+    compressed_ = false;
+    compressed_blob_.reset();
 }
 
-inline chunk_storage::planes_view chunk_storage::make_planes_view() noexcept {
+inline void chunk_storage::reset_planes() {
+    const auto count = extent_.volume();
+    voxels_.reset();
+    palette_.assign(palette_plane{count, voxel_id{}});
+    palette_valid_ = true;
+    skylight_.reset();
+    blocklight_.reset();
+    metadata_.reset();
+    materials_.reset(invalid_material_index);
+    skylight_cache_.reset(0.0f);
+    blocklight_cache_.reset(0.0f);
+    effect_density_.reset(0.0f);
+    effect_velocity_.reset(effects::velocity_sample{});
+    effect_lifetime_.reset(0.0f);
+}
+
+inline chunk_storage::planes_view chunk_storage::make_planes_view() const {
+    const auto count = volume();
+    ensure_dense_voxels();
+    palette_valid_ = false;
     planes_view view{};
-    view.voxels = make_span3d(voxels_.data(), extent_).linear();
-    view.skylight = make_span3d(skylight_.data(), extent_).linear();
-    view.blocklight = make_span3d(blocklight_.data(), extent_).linear();
-    view.metadata = make_span3d(metadata_.data(), extent_).linear();
+    auto& dense = voxels_.write();
+    view.voxels = voxel_span<voxel_id>{dense.data(), dense.size()};
+    view.skylight = voxel_span<std::uint8_t>{skylight_.write(count), count};
+    view.blocklight = voxel_span<std::uint8_t>{blocklight_.write(count), count};
+    view.metadata = voxel_span<std::uint8_t>{metadata_.write(count), count};
     if (materials_enabled_) {
-        view.materials = make_span3d(materials_.data(), extent_).linear();
+        view.materials = voxel_span<material_index>{materials_.write(count), count};
     }
     if (high_precision_lighting_enabled_) {
-        view.skylight_cache = make_span3d(skylight_cache_.data(), extent_).linear();
-        view.blocklight_cache = make_span3d(blocklight_cache_.data(), extent_).linear();
+        view.skylight_cache = std::span<float>{skylight_cache_.write(count), count};
+        view.blocklight_cache = std::span<float>{blocklight_cache_.write(count), count};
     }
     if (effect_density_enabled()) {
-        view.effect_density = make_span3d(effect_density_.data(), extent_).linear();
+        view.effect_density = voxel_span<float>{effect_density_.write(count), count};
     }
     if (effect_velocity_enabled()) {
-        view.effect_velocity = make_span3d(effect_velocity_.data(), extent_).linear();
+        view.effect_velocity = voxel_span<effects::velocity_sample>{effect_velocity_.write(count), count};
     }
     if (effect_lifetime_enabled()) {
-        view.effect_lifetime = make_span3d(effect_lifetime_.data(), extent_).linear();
+        view.effect_lifetime = voxel_span<float>{effect_lifetime_.write(count), count};
     }
     return view;
 }
 
-inline chunk_storage::const_planes_view chunk_storage::make_const_planes_view() const noexcept {
+inline chunk_storage::const_planes_view chunk_storage::make_const_planes_view() const {
+    const auto count = volume();
+    ensure_dense_voxels();
     const_planes_view view{};
-    view.voxels = make_span3d(voxels_.data(), extent_).linear();
-    view.skylight = make_span3d(skylight_.data(), extent_).linear();
-    view.blocklight = make_span3d(blocklight_.data(), extent_).linear();
-    view.metadata = make_span3d(metadata_.data(), extent_).linear();
+    view.voxels = voxel_cspan<voxel_id>{voxels_->data(), voxels_->size()};
+    view.skylight = voxel_cspan<std::uint8_t>{skylight_.read(count), count};
+    view.blocklight = voxel_cspan<std::uint8_t>{blocklight_.read(count), count};
+    view.metadata = voxel_cspan<std::uint8_t>{metadata_.read(count), count};
     if (materials_enabled_) {
-        view.materials = make_span3d(materials_.data(), extent_).linear();
+        view.materials = std::span<const material_index>{materials_.read(count), count};
     }
     if (high_precision_lighting_enabled_) {
-        view.skylight_cache = make_span3d(skylight_cache_.data(), extent_).linear();
-        view.blocklight_cache = make_span3d(blocklight_cache_.data(), extent_).linear();
+        view.skylight_cache = std::span<const float>{skylight_cache_.read(count), count};
+        view.blocklight_cache = std::span<const float>{blocklight_cache_.read(count), count};
     }
     if (effect_density_enabled()) {
-        view.effect_density = make_span3d(effect_density_.data(), extent_).linear();
+        view.effect_density = voxel_cspan<float>{effect_density_.read(count), count};
     }
     if (effect_velocity_enabled()) {
-        view.effect_velocity = make_span3d(effect_velocity_.data(), extent_).linear();
+        view.effect_velocity = voxel_cspan<effects::velocity_sample>{effect_velocity_.read(count), count};
     }
     if (effect_lifetime_enabled()) {
-        view.effect_lifetime = make_span3d(effect_lifetime_.data(), extent_).linear();
+        view.effect_lifetime = voxel_cspan<float>{effect_lifetime_.read(count), count};
     }
     return view;
 }
 
-inline void chunk_storage::ensure_decompressed() {
-    if (compressed_) {
-        std::scoped_lock lock{compression_mutex_};
+template <typename T>
+inline const T* chunk_storage::read_plane(detail::lazy_plane<T>& plane) const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    return plane.read(volume());
+}
+
+inline void chunk_storage::ensure_decompressed() const {
+    if (compressed_.load(std::memory_order_acquire)) {
+        std::scoped_lock lock{state_mutex_};
         decompress_locked();
     }
 }
 
-inline void chunk_storage::decompress_locked() {
-    if (!compressed_ || compressed_blob_.empty()) {
+inline void chunk_storage::ensure_dense_voxels() const {
+    if (!voxels_->empty() || !palette_valid_) {
+        return;
+    }
+    auto& dense = voxels_.write();
+    dense.resize(palette_->size());
+    palette_->decode(dense);
+}
+
+inline void chunk_storage::decompress_locked() const {
+    if (!compressed_ || compressed_blob_->empty()) {
         return;
     }
-    if (decompress_) {
-        decompress_(make_planes_view(), compressed_blob_);
+    if (codec_blob_) {
+        decode_planes_locked();
+    } else if (decompress_) {
+        decompress_(make_planes_view(), *compressed_blob_);
     }
-    compressed_blob_.clear();
+    compressed_blob_.reset();
     compressed_ = false;
+    codec_blob_ = false;
+}
+
+template <typename Fn>
+inline void chunk_storage::for_each_lazy_plane(Fn&& fn) const {
+    fn(chunk_plane::skylight, skylight_);
+    fn(chunk_plane::blocklight, blocklight_);
+    fn(chunk_plane::metadata, metadata_);
+    fn(chunk_plane::materials, materials_);
+    fn(chunk_plane::skylight_cache, skylight_cache_);
+    fn(chunk_plane::blocklight_cache, blocklight_cache_);
+    fn(chunk_plane::effect_density, effect_density_);
+    fn(chunk_plane::effect_velocity, effect_velocity_);
+    fn(chunk_plane::effect_lifetime, effect_lifetime_);
+}
+
+namespace detail {
+
+// Built-in blob layout: version byte, then one record per encoded plane: plane index, codec id, u32 payload size
+// (little endian), payload. Planes without a record were uniform or palette-packed and stayed resident.
+inline constexpr std::uint8_t codec_blob_version = 1;
+inline constexpr std::size_t codec_record_header = 6;
+
+inline std::size_t plane_index(chunk_plane plane) noexcept {
+    return static_cast<std::size_t>(std::countr_zero(static_cast<std::uint32_t>(plane)));
+}
+
+} // namespace detail
+
+inline bool chunk_storage::compress_locked(const chunk_codec_config& config) {
+    const auto& registry = codec_registry::shared();
+    byte_vector blob{std::byte{detail::codec_blob_version}};
+    const auto append = [&](chunk_plane plane, std::span<const std::byte> bytes, std::size_t element_size) {
+        const auto header = blob.size();
+        blob.resize(header + detail::codec_record_header);
+        const auto id = registry.encode(config.codec_for(plane), bytes, element_size, blob);
+        const auto size = static_cast<std::uint32_t>(blob.size() - header - detail::codec_record_header);
+        blob[header] = static_cast<std::byte>(detail::plane_index(plane));
+        blob[header + 1] = static_cast<std::byte>(id);
+        for (std::size_t i = 0; i < 4; ++i) {
+            blob[header + 2 + i] = static_cast<std::byte>((size >> (8 * i)) & 0xFFu);
+        }
+    };
+
+    const bool encode_voxels = !voxels_->empty() && !palette_valid_;
+    if (encode_voxels) {
+        append(chunk_plane::voxels, std::as_bytes(std::span<const voxel_id>{*voxels_}), sizeof(voxel_id));
+    }
+    for_each_lazy_plane([&](chunk_plane plane, auto& lazy) {
+        using value_type = typename std::remove_cvref_t<decltype(lazy)>::value_type;
+        if (!lazy.uniform() && lazy.materialised()) {
+            append(plane, std::as_bytes(std::span<const value_type>{lazy.data(), volume()}), sizeof(value_type));
+        }
+    });
+
+    // Encoding is done; only now drop the dense arrays so a throwing codec leaves the chunk untouched.
+    if (palette_valid_ || encode_voxels) {
+        voxels_.reset();
+    }
+    if (encode_voxels) {
+        palette_.reset();
+    }
+    for_each_lazy_plane([](chunk_plane, auto& lazy) {
+        if (lazy.uniform()) {
+            lazy.release();
+        } else {
+            lazy.discard();
+        }
+    });
+    if (blob.size() == 1) {
+        return false;
+    }
+    blob.shrink_to_fit();
+    compressed_blob_.assign(std::move(blob));
+    compressed_ = true;
+    codec_blob_ = true;
+    return true;
+}
+
+inline void chunk_storage::decode_planes_locked() const {
+    struct record {
+        bool present{false};
+        codec_id id{codec_id::raw};
+        std::span<const std::byte> payload{};
+    };
+
+    const std::span<const std::byte> blob{*compressed_blob_};
+    if (blob.empty() || std::to_integer<std::uint8_t>(blob[0]) != detail::codec_blob_version) {
+        throw std::runtime_error("unsupported chunk codec blob");
+    }
+    std::array<record, chunk_plane_count> records{};
+    std::size_t offset = 1;
+    while (offset < blob.size()) {
+        if (blob.size() - offset < detail::codec_record_header) {
+            throw std::runtime_error("truncated chunk codec blob");
+        }
+        const auto index = std::to_integer<std::size_t>(blob[offset]);
+        const auto id = static_cast<codec_id>(std::to_integer<std::uint8_t>(blob[offset + 1]));
+        std::size_t size = 0;
+        for (std::size_t i = 0; i < 4; ++i) {
+            size |= std::to_integer<std::size_t>(blob[offset + 2 + i]) << (8 * i);
+        }
+        offset += detail::codec_record_header;
+        if (index >= chunk_plane_count || size > blob.size() - offset) {
+            throw std::runtime_error("malformed chunk codec blob");
+        }
+        records[index] = record{true, id, blob.subspan(offset, size)};
+        offset += size;
+    }
+
+    const auto& registry = codec_registry::shared();
+    const auto count = volume();
+    const auto& voxel_record = records[detail::plane_index(chunk_plane::voxels)];
+    if (voxel_record.present) {
+        std::vector<voxel_id> values(count);
+        registry.decode(voxel_record.id, voxel_record.payload, std::as_writable_bytes(std::span{values}),
+            sizeof(voxel_id));
+        voxels_.assign(std::move(values));
+        palette_valid_ = false;
+    }
+    for_each_lazy_plane([&](chunk_plane plane, auto& lazy) {
+        using value_type = typename std::remove_cvref_t<decltype(lazy)>::value_type;
+        const auto& entry = records[detail::plane_index(plane)];
+        if (!entry.present) {
+            return;
+        }
+        std::vector<value_type> values(count);
+        registry.decode(entry.id, entry.payload, std::as_writable_bytes(std::span{values}), sizeof(value_type));
+        lazy.restore(std::move(values));
+    });
 }
 
 } // namespace almond::voxel
@@ -128,6 +128,75 @@ struct chunk_extent {
     return chunk_extent{edge, edge, edge};
 }
 
+// Half-open voxel box [min, max) in chunk-local coordinates. A default-constructed box is empty.
+struct voxel_bounds {
+    std::array<std::uint32_t, 3> min{0, 0, 0};
+    std::array<std::uint32_t, 3> max{0, 0, 0};
+
+    [[nodiscard]] static constexpr voxel_bounds cell(std::uint32_t px, std::uint32_t py, std::uint32_t pz) noexcept {
+        return voxel_bounds{{px, py, pz}, {px + 1, py + 1, pz + 1}};
+    }
+
+    [[nodiscard]] static constexpr voxel_bounds full(const chunk_extent& extent) noexcept {
+        return voxel_bounds{{0, 0, 0}, {extent.x, extent.y, extent.z}};
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return min[0] >= max[0] || min[1] >= max[1] || min[2] >= max[2];
+    }
+
+    [[nodiscard]] constexpr std::size_t volume() const noexcept {
+        return empty() ? 0
+                       : static_cast<std::size_t>(max[0] - min[0]) * static_cast<std::size_t>(max[1] - min[1])
+                * static_cast<std::size_t>(max[2] - min[2]);
+    }
+
+    [[nodiscard]] constexpr bool contains(std::uint32_t px, std::uint32_t py, std::uint32_t pz) const noexcept {
+        return px >= min[0] && px < max[0] && py >= min[1] && py < max[1] && pz >= min[2] && pz < max[2];
+    }
+
+    [[nodiscard]] constexpr bool intersects(const voxel_bounds& other) const noexcept {
+        return !empty() && !other.empty() && min[0] < other.max[0] && other.min[0] < max[0] && min[1] < other.max[1]
+            && other.min[1] < max[1] && min[2] < other.max[2] && other.min[2] < max[2];
+    }
+
+    [[nodiscard]] constexpr bool covers(const chunk_extent& extent) const noexcept {
+        return min[0] == 0 && min[1] == 0 && min[2] == 0 && max[0] >= extent.x && max[1] >= extent.y && max[2] >= extent.z;
+    }
+
+    constexpr void merge(const voxel_bounds& other) noexcept {
+        if (other.empty()) {
+            return;
+        }
+        if (empty()) {
+            *this = other;
+            return;
+        }
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            min[axis] = min[axis] < other.min[axis] ? min[axis] : other.min[axis];
+            max[axis] = max[axis] > other.max[axis] ? max[axis] : other.max[axis];
+        }
+    }
+
+    // Grows the box by the given amounts below and above on each axis, clamped to the extent.
+    [[nodiscard]] constexpr voxel_bounds expanded(const std::array<std::uint32_t, 3>& below,
+        const std::array<std::uint32_t, 3>& above, const chunk_extent& extent) const noexcept {
+        if (empty()) {
+            return *this;
+        }
+        const auto dims = extent.to_array();
+        voxel_bounds result{};
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            result.min[axis] = min[axis] > below[axis] ? min[axis] - below[axis] : 0;
+            const std::uint32_t grown = max[axis] + above[axis];
+            result.max[axis] = grown < dims[axis] ? grown : dims[axis];
+        }
+        return result;
+    }
+
+    [[nodiscard]] constexpr bool operator==(const voxel_bounds&) const noexcept = default;
+};
+
 template <typename T>
 using voxel_span = std::span<T>;
 
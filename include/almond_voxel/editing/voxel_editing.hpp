@@ -6,7 +6,6 @@
 
 #include <array>
 #include <cstdint>
-#include <memory>
 #include <utility>
 
 namespace almond::voxel::editing {
@@ -35,6 +34,18 @@ inline std::pair<std::int32_t, std::uint32_t> floor_divmod(std::int64_t value, s
     return {static_cast<std::int32_t>(quotient), static_cast<std::uint32_t>(remainder)};
 }
 
+// Re-enqueues a copy of itself while particles remain alive.
+struct decay_task {
+    region_manager* manager{nullptr};
+    effects::decay_settings decay{};
+
+    void operator()(chunk_storage& chunk, const region_key& key) const {
+        if (effects::simulate_decay(chunk, decay)) {
+            manager->enqueue_task(key, *this);
+        }
+    }
+};
+
 } // namespace detail
 
 inline chunk_coordinates split_world_position(const world_position& position, const chunk_extent& extent) {
@@ -54,12 +65,7 @@ inline std::size_t linear_index(const chunk_extent& extent, const std::array<std
 }
 
 inline bool set_voxel(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local, voxel_id id) {
-    auto vox = chunk.voxels();
-    if (!vox.contains(local[0], local[1], local[2])) {
-        return false;
-    }
-    vox(local[0], local[1], local[2]) = id;
-    return true;
+    return chunk.set_voxel(local[0], local[1], local[2], id);
 }
 
 inline bool clear_voxel(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local) {
@@ -110,13 +116,11 @@ inline bool clear_voxel(region_manager& regions, const world_position& position)
 inline bool toggle_voxel(region_manager& regions, const world_position& position, voxel_id on_value) {
     const auto coords = split_world_position(position, regions.chunk_dimensions());
     auto& chunk = regions.assure(coords.region);
-    auto vox = chunk.voxels();
-    if (!vox.contains(coords.local[0], coords.local[1], coords.local[2])) {
+    if (!chunk.extent().contains(coords.local[0], coords.local[1], coords.local[2])) {
         return false;
     }
-    voxel_id& value = vox(coords.local[0], coords.local[1], coords.local[2]);
-    value = value == voxel_id{} ? on_value : voxel_id{};
-    return true;
+    const voxel_id value = chunk.voxel_at(coords.local[0], coords.local[1], coords.local[2]);
+    return chunk.set_voxel(coords.local[0], coords.local[1], coords.local[2], value == voxel_id{} ? on_value : voxel_id{});
 }
 
 inline bool paint_particle_emitter(region_manager& regions, const world_position& position,
@@ -128,14 +132,7 @@ inline bool paint_particle_emitter(region_manager& regions, const world_position
         return false;
     }
 
-    auto manager = &regions;
-    auto recurring = std::make_shared<region_manager::task_type>();
-    *recurring = [manager, decay, recurring](chunk_storage& chunk_ref, const region_key& key) {
-        if (effects::simulate_decay(chunk_ref, decay)) {
-            manager->enqueue_task(key, *recurring);
-        }
-    };
-    manager->enqueue_task(coords.region, *recurring);
+    regions.enqueue_task(coords.region, detail::decay_task{&regions, decay});
     return true;
 }
 
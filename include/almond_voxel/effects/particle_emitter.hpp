@@ -25,7 +25,11 @@ inline bool stamp_emitter(chunk_storage& chunk, const std::array<std::uint32_t,
     if (!chunk.effect_density_enabled() || !chunk.effect_velocity_enabled() || !chunk.effect_lifetime_enabled()) {
         return false;
     }
+    if (!chunk.extent().contains(local[0], local[1], local[2])) {
+        return false;
+    }
 
+    auto scope = chunk.edit();
     auto density = chunk.effect_density();
     if (!density.contains(local[0], local[1], local[2])) {
         return false;
@@ -58,6 +62,28 @@ inline bool simulate_decay(chunk_storage& chunk, decay_settings settings) {
         return false;
     }
 
+    // Settled chunks are left untouched so idle emitters do not keep marking effect planes dirty.
+    const auto& settled = chunk;
+    const auto settled_lifetime = settled.effect_lifetime().linear();
+    const auto settled_density = chunk.effect_density_enabled() ? settled.effect_density().linear() : voxel_cspan<float>{};
+    const auto settled_velocity = chunk.effect_velocity_enabled() ? settled.effect_velocity().linear()
+                                                                  : voxel_cspan<velocity_sample>{};
+    bool pending = false;
+    for (std::size_t i = 0; i < settled_lifetime.size() && !pending; ++i) {
+        if (settled_lifetime[i] > 0.0f) {
+            pending = true;
+        } else if (!settled_density.empty() && settled_density[i] != 0.0f) {
+            pending = true;
+        } else if (!settled_velocity.empty()
+            && (settled_velocity[i].x != 0.0f || settled_velocity[i].y != 0.0f || settled_velocity[i].z != 0.0f)) {
+            pending = true;
+        }
+    }
+    if (!pending) {
+        return false;
+    }
+
+    auto scope = chunk.edit();
     auto lifetime = chunk.effect_lifetime();
     auto lifetime_linear = lifetime.linear();
 
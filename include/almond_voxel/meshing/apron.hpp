@@ -0,0 +1,286 @@
+#pragma once
+
+#include "almond_voxel/chunk.hpp"
+#include "almond_voxel/core.hpp"
+#include "almond_voxel/meshing/neighbors.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+// The 26 chunks around a centre chunk, addressed by their offset in {-1, 0, 1} per axis. Slot (0, 0, 0) is unused; the
+// centre chunk is passed separately. Empty slots are missing neighbours.
+struct chunk_neighborhood {
+    std::array<const chunk_storage*, 27> chunks{};
+
+    [[nodiscard]] static constexpr std::size_t slot(int dx, int dy, int dz) noexcept {
+        return static_cast<std::size_t>((dx + 1) + 3 * ((dy + 1) + 3 * (dz + 1)));
+    }
+
+    [[nodiscard]] const chunk_storage* at(int dx, int dy, int dz) const noexcept { return chunks[slot(dx, dy, dz)]; }
+    void set(int dx, int dy, int dz, const chunk_storage* chunk) noexcept { chunks[slot(dx, dy, dz)] = chunk; }
+
+    // Face neighbours only; edge and corner slots stay missing.
+    [[nodiscard]] static chunk_neighborhood from_faces(const chunk_neighbors& neighbors) noexcept {
+        chunk_neighborhood result{};
+        result.set(1, 0, 0, neighbors.pos_x);
+        result.set(-1, 0, 0, neighbors.neg_x);
+        result.set(0, 1, 0, neighbors.pos_y);
+        result.set(0, -1, 0, neighbors.neg_y);
+        result.set(0, 0, 1, neighbors.pos_z);
+        result.set(0, 0, -1, neighbors.neg_z);
+        return result;
+    }
+};
+
+// Copy of one plane of a chunk padded by an apron taken from its neighbours, one voxel wide unless resize() asks for
+// more, so a kernel can read any voxel in [-apron, extent + apron) on every axis, edges and corners included, without
+// bounds tests or neighbour lookups. Neighbours must share the centre's extent; others count as missing. The buffer
+// keeps its capacity across resize(), so a grid reused between chunks of one size allocates once.
+template <typename T>
+class padded_grid {
+public:
+    padded_grid() = default;
+
+    void resize(chunk_extent extent, std::uint32_t apron = 1) {
+        extent_ = extent;
+        apron_ = apron;
+        stride_y_ = static_cast<std::size_t>(extent.x) + 2 * apron;
+        stride_z_ = stride_y_ * (static_cast<std::size_t>(extent.y) + 2 * apron);
+        data_.resize(stride_z_ * (static_cast<std::size_t>(extent.z) + 2 * apron));
+    }
+
+    // Extent of the centre chunk; the grid itself spans extent + 2 * apron() on each axis.
+    [[nodiscard]] chunk_extent extent() const noexcept { return extent_; }
+    [[nodiscard]] std::uint32_t apron() const noexcept { return apron_; }
+    [[nodiscard]] chunk_extent padded_extent() const noexcept {
+        return chunk_extent{extent_.x + 2 * apron_, extent_.y + 2 * apron_, extent_.z + 2 * apron_};
+    }
+
+    // Linear index of chunk-local (x, y, z); each coordinate may reach apron() voxels outside the chunk. Adding
+    // offset() to an index steps to a neighbouring voxel.
+    [[nodiscard]] std::size_t index(std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t z) const noexcept {
+        const auto a = static_cast<std::ptrdiff_t>(apron_);
+        return static_cast<std::size_t>(x + a) + stride_y_ * static_cast<std::size_t>(y + a)
+            + stride_z_ * static_cast<std::size_t>(z + a);
+    }
+    [[nodiscard]] std::ptrdiff_t offset(int dx, int dy, int dz) const noexcept {
+        return dx + static_cast<std::ptrdiff_t>(stride_y_) * dy + static_cast<std::ptrdiff_t>(stride_z_) * dz;
+    }
+
+    [[nodiscard]] const T& operator()(std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t z) const noexcept {
+        return data_[index(x, y, z)];
+    }
+    [[nodiscard]] T& operator()(std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t z) noexcept {
+        return data_[index(x, y, z)];
+    }
+    [[nodiscard]] const T& operator[](std::size_t index) const noexcept { return data_[index]; }
+
+    // The whole padded box, with chunk-local (x, y, z) at padded (x + apron, y + apron, z + apron).
+    [[nodiscard]] span3d<const T> padded() const noexcept { return make_span3d(data_.data(), padded_extent()); }
+    [[nodiscard]] span3d<T> padded() noexcept { return make_span3d(data_.data(), padded_extent()); }
+
+private:
+    std::vector<T> data_{};
+    chunk_extent extent_{0, 0, 0};
+    std::uint32_t apron_{1};
+    std::size_t stride_y_{0};
+    std::size_t stride_z_{0};
+};
+
+namespace detail {
+
+// Walks the 27 blocks of the padded box. Each block is the centre chunk, one face slab, one edge bar or one corner box
+// of a neighbour, `apron` voxels thick across the seam; `copy_block(chunk, source_min, dest_min, size)` copies it row
+// by row along x. A neighbour whose extent differs from the centre is read in its own coordinates: across the seam the
+// apron comes from its near side, along the seam cells share their coordinates, and whatever lies outside its extent
+// is filled with `missing`, as are missing neighbours. Without `include_center` only the apron shell is written and the
+// centre cells keep whatever the buffer held.
+template <typename T, typename CopyBlock>
+void fill_apron_blocks(const chunk_storage& center, const chunk_neighborhood& neighborhood, padded_grid<T>& out,
+    const T& missing, CopyBlock&& copy_block, bool include_center = true, std::uint32_t apron = 1) {
+    const auto extent = center.extent();
+    out.resize(extent, apron);
+    const auto dims = extent.to_array();
+
+    const auto fill_missing = [&](const std::array<std::ptrdiff_t, 3>& dest_min,
+        const std::array<std::uint32_t, 3>& size) {
+        for (std::uint32_t z = 0; z < size[2]; ++z) {
+            for (std::uint32_t y = 0; y < size[1]; ++y) {
+                auto* row = &out(dest_min[0], dest_min[1] + y, dest_min[2] + z);
+                std::fill(row, row + size[0], missing);
+            }
+        }
+    };
+
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (!include_center && dx == 0 && dy == 0 && dz == 0) {
+                    continue;
+                }
+                const std::array<int, 3> delta{dx, dy, dz};
+                std::array<std::ptrdiff_t, 3> dest_min{};
+                std::array<std::uint32_t, 3> size{};
+                for (std::size_t axis = 0; axis < 3; ++axis) {
+                    const auto n = dims[axis];
+                    dest_min[axis] = delta[axis] < 0 ? -static_cast<std::ptrdiff_t>(apron)
+                        : delta[axis] > 0       ? static_cast<std::ptrdiff_t>(n)
+                                                : 0;
+                    size[axis] = delta[axis] == 0 ? n : apron;
+                }
+                if (size[0] == 0 || size[1] == 0 || size[2] == 0) {
+                    continue;
+                }
+
+                const chunk_storage* chunk = dx == 0 && dy == 0 && dz == 0 ? &center : neighborhood.at(dx, dy, dz);
+                if (chunk == nullptr) {
+                    fill_missing(dest_min, size);
+                    continue;
+                }
+
+                // Clip the block to the cells the chunk actually has; the block offsets [lo, hi) per axis map to
+                // chunk coordinates start + offset.
+                const auto source_dims = chunk->extent().to_array();
+                std::array<std::uint32_t, 3> source_min{};
+                std::array<std::ptrdiff_t, 3> copy_dest{};
+                std::array<std::uint32_t, 3> copy_size{};
+                bool partial = false;
+                for (std::size_t axis = 0; axis < 3; ++axis) {
+                    const auto available = static_cast<std::ptrdiff_t>(source_dims[axis]);
+                    const std::ptrdiff_t start = delta[axis] < 0 ? available - static_cast<std::ptrdiff_t>(apron) : 0;
+                    const std::ptrdiff_t lo = std::max<std::ptrdiff_t>(0, -start);
+                    const std::ptrdiff_t hi = std::clamp<std::ptrdiff_t>(available - start, lo, size[axis]);
+                    source_min[axis] = static_cast<std::uint32_t>(start + lo);
+                    copy_dest[axis] = dest_min[axis] + lo;
+                    copy_size[axis] = static_cast<std::uint32_t>(hi - lo);
+                    partial = partial || copy_size[axis] != size[axis];
+                }
+                if (partial) {
+                    fill_missing(dest_min, size);
+                }
+                if (copy_size[0] != 0 && copy_size[1] != 0 && copy_size[2] != 0) {
+                    copy_block(*chunk, source_min, copy_dest, copy_size);
+                }
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+// Builds the padded copy of the plane returned by `plane(const chunk_storage&)` as span3d<const T>, for example
+// skylight(). Chunks for which `uniform(const chunk_storage&)` returns a value, such as uniform_skylight(), are filled
+// with it instead of materialising their plane. Interior rows are bulk copies; apron cells of missing neighbours read
+// `missing`.
+template <typename T, typename Plane, typename Uniform>
+void build_plane_apron(const chunk_storage& center, const chunk_neighborhood& neighborhood, padded_grid<T>& out,
+    Plane&& plane, Uniform&& uniform, std::type_identity_t<T> missing) {
+    detail::fill_apron_blocks(center, neighborhood, out, missing,
+        [&](const chunk_storage& chunk, const std::array<std::uint32_t, 3>& source_min,
+            const std::array<std::ptrdiff_t, 3>& dest_min, const std::array<std::uint32_t, 3>& size) {
+            const std::optional<T> uniform_value = uniform(chunk);
+            span3d<const T> source{};
+            if (!uniform_value) {
+                source = plane(chunk);
+            }
+            for (std::uint32_t z = 0; z < size[2]; ++z) {
+                for (std::uint32_t y = 0; y < size[1]; ++y) {
+                    auto* dest = &out(dest_min[0], dest_min[1] + y, dest_min[2] + z);
+                    if (uniform_value) {
+                        std::fill(dest, dest + size[0], *uniform_value);
+                        continue;
+                    }
+                    const auto* row = &source(source_min[0], source_min[1] + y, source_min[2] + z);
+                    std::copy(row, row + size[0], dest);
+                }
+            }
+        });
+}
+
+template <typename T, typename Plane>
+void build_plane_apron(const chunk_storage& center, const chunk_neighborhood& neighborhood, padded_grid<T>& out,
+    Plane&& plane, std::type_identity_t<T> missing = T{}) {
+    build_plane_apron(center, neighborhood, out, std::forward<Plane>(plane),
+        [](const chunk_storage&) { return std::optional<T>{}; }, missing);
+}
+
+namespace detail {
+
+template <typename T, typename Convert>
+void fill_voxel_blocks(const chunk_storage& center, const chunk_neighborhood& neighborhood, padded_grid<T>& out,
+    Convert& convert, const T& missing, bool include_center, std::uint32_t apron = 1) {
+    std::vector<voxel_id> row;
+    fill_apron_blocks(center, neighborhood, out, missing,
+        [&](const chunk_storage& chunk, const std::array<std::uint32_t, 3>& source_min,
+            const std::array<std::ptrdiff_t, 3>& dest_min, const std::array<std::uint32_t, 3>& size) {
+            const auto uniform = chunk.uniform_voxel();
+            const std::optional<T> uniform_value = uniform ? std::optional<T>{convert(*uniform)} : std::nullopt;
+            for (std::uint32_t z = 0; z < size[2]; ++z) {
+                for (std::uint32_t y = 0; y < size[1]; ++y) {
+                    auto* dest = &out(dest_min[0], dest_min[1] + y, dest_min[2] + z);
+                    if (uniform_value) {
+                        std::fill(dest, dest + size[0], *uniform_value);
+                        continue;
+                    }
+                    // Rows are read through the palette, so compacted chunks are never expanded to a dense plane.
+                    if constexpr (std::is_same_v<std::remove_cvref_t<Convert>, std::identity>) {
+                        chunk.copy_voxel_row(source_min[0], source_min[1] + y, source_min[2] + z,
+                            voxel_span<voxel_id>{dest, size[0]});
+                    } else {
+                        row.resize(size[0]);
+                        chunk.copy_voxel_row(source_min[0], source_min[1] + y, source_min[2] + z, row);
+                        std::transform(row.begin(), row.end(), dest, convert);
+                    }
+                }
+            }
+        },
+        include_center, apron);
+}
+
+} // namespace detail
+
+// Builds a padded grid of `convert(voxel_id)` values, such as opacity or density, in one pass over the voxel planes.
+// Uniform chunks are converted once and filled without materialising their voxels. `apron` widens the border for
+// kernels that reach further than one voxel.
+template <typename T, typename Convert>
+void build_voxel_apron(const chunk_storage& center, const chunk_neighborhood& neighborhood, padded_grid<T>& out,
+    Convert&& convert, std::type_identity_t<T> missing, std::uint32_t apron = 1) {
+    detail::fill_voxel_blocks(center, neighborhood, out, convert, missing, true, apron);
+}
+
+// Padded copy of the voxel ids; apron cells of missing neighbours read `missing` (air by default).
+inline void build_voxel_apron(const chunk_storage& center, const chunk_neighborhood& neighborhood,
+    padded_grid<voxel_id>& out, voxel_id missing = voxel_id{}) {
+    build_voxel_apron(center, neighborhood, out, std::identity{}, missing);
+}
+
+namespace detail {
+
+// Opacity of a chunk padded with its neighbours' boundary layers, read by the blocky meshers' neighbour-aware entry
+// points. Missing neighbours are transparent. Lit meshing needs the full grid for ambient occlusion; unlit meshing
+// only samples across the chunk faces, so build_opacity_shell converts just the apron and leaves the centre unset.
+template <typename IsOpaque>
+void build_opacity_apron(const chunk_storage& chunk, const chunk_neighborhood& neighborhood, IsOpaque& is_opaque,
+    padded_grid<std::uint8_t>& out, bool include_center = true) {
+    auto convert = [&is_opaque](voxel_id id) { return static_cast<std::uint8_t>(is_opaque(id) ? 1u : 0u); };
+    fill_voxel_blocks(chunk, neighborhood, out, convert, std::uint8_t{0}, include_center);
+}
+
+template <typename IsOpaque>
+void build_opacity_shell(const chunk_storage& chunk, const chunk_neighborhood& neighborhood, IsOpaque& is_opaque,
+    padded_grid<std::uint8_t>& out) {
+    build_opacity_apron(chunk, neighborhood, is_opaque, out, false);
+}
+
+} // namespace detail
+
+} // namespace almond::voxel::meshing
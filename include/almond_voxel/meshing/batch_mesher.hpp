@@ -0,0 +1,360 @@
+#pragma once
+
+#include "almond_voxel/chunk.hpp"
+#include "almond_voxel/meshing/apron.hpp"
+#include "almond_voxel/meshing/mesh_context.hpp"
+#include "almond_voxel/meshing/mesh_types.hpp"
+#include "almond_voxel/meshing/neighbors.hpp"
+#include "almond_voxel/parallel/completion_queue.hpp"
+#include "almond_voxel/parallel/task_pool.hpp"
+#include "almond_voxel/world.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+enum class batch_mesher_kind { binary_greedy, greedy, naive, marching_cubes };
+
+struct batch_mesh_config {
+    batch_mesher_kind mesher{batch_mesher_kind::binary_greedy};
+    marching_cubes_config marching_cubes{};
+    // Level of detail for marching cubes, chosen per chunk from its distance to the viewer of the latest
+    // submit(keys, viewer). Results carry the level; resubmit chunks whose level or neighbour levels changed.
+    marching_cubes_lod_policy lod{};
+    // Vertex lighting for the blocky meshers; enabling it also gathers edge and corner neighbours.
+    mesh_lighting_config lighting{};
+    std::size_t worker_count{parallel::task_pool::default_worker_count()};
+};
+
+enum class batch_mesh_status { meshed, missing, failed };
+
+struct batch_mesh_result {
+    region_key key{};
+    batch_mesh_status status{batch_mesh_status::meshed};
+    // chunk_storage::revision() of the snapshot that was meshed, so stale results can be recognised.
+    std::uint64_t revision{0};
+    // Level of detail the chunk was meshed at; always 0 for the blocky meshers.
+    std::uint8_t lod_level{0};
+    mesh_result mesh{};
+    // What the mesher threw for a failed result; the mesh is empty.
+    std::exception_ptr error{};
+};
+
+// Meshes resident chunks of a region_manager on a worker pool. Each job snapshots the chunk and its neighbours (O(1)
+// copy-on-write, under shared guards), then meshes the snapshots with a per-worker mesher_context, so workers never
+// block the owner thread or each other. Queued keys run highest priority first; resubmitting a queued key updates its
+// priority, and a key submitted while it is being meshed runs again afterwards so the newest edit always lands last.
+// Results arrive through a lock-free completion queue drained by one consumer thread.
+//
+// submit(), cancel() and cancel_all() may be called from any thread; try_pop() and drain() from one consumer thread.
+// The region_manager must outlive the batch_mesher. Keys that are not resident when their job runs report missing;
+// keys whose snapshot or mesher throws report failed with the exception attached.
+class batch_mesher {
+public:
+    explicit batch_mesher(const region_manager& regions, batch_mesh_config config = {});
+    batch_mesher(const batch_mesher&) = delete;
+    batch_mesher& operator=(const batch_mesher&) = delete;
+    ~batch_mesher();
+
+    void submit(const region_key& key, int priority = 0);
+    // Nearer regions first: priority is the negated squared distance to `viewer`, in region units.
+    void submit(std::span<const region_key> keys, const region_key& viewer);
+
+    // Drops a queued key and discards the result of a run in progress. Returns false when the key was neither.
+    bool cancel(const region_key& key);
+    void cancel_all();
+
+    [[nodiscard]] bool try_pop(batch_mesh_result& out);
+    // Calls `consume(batch_mesh_result&&)` for each completed result; returns how many were delivered.
+    template <typename Consume>
+    std::size_t drain(Consume&& consume);
+
+    // Keys queued or being meshed, and of those the ones a worker is meshing right now.
+    [[nodiscard]] std::size_t pending() const;
+    [[nodiscard]] std::size_t in_flight() const;
+    [[nodiscard]] std::size_t worker_count() const noexcept { return pool_.worker_count(); }
+    // Blocks until every submitted key has been meshed or cancelled. Not callable from inside a consumer callback
+    // that workers wait on.
+    void wait_idle();
+
+    [[nodiscard]] static int distance_priority(const region_key& key, const region_key& viewer) noexcept;
+
+private:
+    struct queued_entry {
+        int priority{0};
+        std::uint64_t sequence{0};
+        region_key key{};
+        std::uint64_t ticket{0};
+
+        // Max-heap on priority, then first come first served.
+        [[nodiscard]] friend bool operator<(const queued_entry& lhs, const queued_entry& rhs) noexcept {
+            return lhs.priority != rhs.priority ? lhs.priority < rhs.priority : lhs.sequence > rhs.sequence;
+        }
+    };
+
+    struct running_entry {
+        bool cancelled{false};
+        // Set when the key was resubmitted during the run; it is queued again once the run finishes.
+        std::optional<int> rerun{};
+    };
+
+    void push_locked(const region_key& key, int priority);
+    void run_next();
+    [[nodiscard]] batch_mesh_result mesh_key(const region_key& key, const std::optional<region_key>& viewer,
+        mesher_context& context) const;
+
+    const region_manager& regions_;
+    batch_mesh_config config_{};
+
+    mutable std::mutex mutex_{};
+    std::vector<queued_entry> heap_{};
+    std::unordered_map<region_key, std::uint64_t, region_key_hash> queued_{};
+    std::unordered_map<region_key, running_entry, region_key_hash> running_{};
+    std::uint64_t next_sequence_{0};
+    std::uint64_t next_ticket_{0};
+    std::size_t jobs_to_submit_{0};
+    std::optional<region_key> viewer_{};
+
+    parallel::completion_queue<batch_mesh_result> completed_{};
+    std::vector<mesher_context> contexts_{};
+    // Declared last so its workers stop before the state they use is destroyed.
+    parallel::task_pool pool_;
+};
+
+inline batch_mesher::batch_mesher(const region_manager& regions, batch_mesh_config config)
+    : regions_{regions}, config_{config}, contexts_(std::max<std::size_t>(1, config.worker_count)),
+      pool_{std::max<std::size_t>(1, config.worker_count)} {}
+
+inline batch_mesher::~batch_mesher() {
+    cancel_all();
+    pool_.wait_idle();
+}
+
+inline int batch_mesher::distance_priority(const region_key& key, const region_key& viewer) noexcept {
+    const auto dx = static_cast<std::int64_t>(key.x) - viewer.x;
+    const auto dy = static_cast<std::int64_t>(key.y) - viewer.y;
+    const auto dz = static_cast<std::int64_t>(key.z) - viewer.z;
+    const auto distance = dx * dx + dy * dy + dz * dz;
+    return -static_cast<int>(std::min<std::int64_t>(distance, std::numeric_limits<int>::max()));
+}
+
+inline void batch_mesher::push_locked(const region_key& key, int priority) {
+    if (auto running = running_.find(key); running != running_.end()) {
+        running->second.rerun = std::max(priority, running->second.rerun.value_or(priority));
+        return;
+    }
+    // Re-queueing leaves the old heap entry behind with a stale ticket; run_next() skips it.
+    const auto ticket = ++next_ticket_;
+    queued_.insert_or_assign(key, ticket);
+    heap_.push_back(queued_entry{priority, next_sequence_++, key, ticket});
+    std::push_heap(heap_.begin(), heap_.end());
+    ++jobs_to_submit_;
+}
+
+inline void batch_mesher::submit(const region_key& key, int priority) {
+    std::size_t jobs = 0;
+    {
+        std::scoped_lock lock{mutex_};
+        push_locked(key, priority);
+        jobs = std::exchange(jobs_to_submit_, 0);
+    }
+    for (std::size_t i = 0; i < jobs; ++i) {
+        pool_.submit([this] { run_next(); });
+    }
+}
+
+inline void batch_mesher::submit(std::span<const region_key> keys, const region_key& viewer) {
+    std::size_t jobs = 0;
+    {
+        // Queue the whole batch before any worker starts so the first jobs already see the nearest keys.
+        std::scoped_lock lock{mutex_};
+        viewer_ = viewer;
+        for (const auto& key : keys) {
+            push_locked(key, distance_priority(key, viewer));
+        }
+        jobs = std::exchange(jobs_to_submit_, 0);
+    }
+    for (std::size_t i = 0; i < jobs; ++i) {
+        pool_.submit([this] { run_next(); });
+    }
+}
+
+inline bool batch_mesher::cancel(const region_key& key) {
+    std::scoped_lock lock{mutex_};
+    bool found = queued_.erase(key) > 0;
+    if (auto running = running_.find(key); running != running_.end()) {
+        running->second.cancelled = true;
+        running->second.rerun.reset();
+        found = true;
+    }
+    return found;
+}
+
+inline void batch_mesher::cancel_all() {
+    std::scoped_lock lock{mutex_};
+    queued_.clear();
+    heap_.clear();
+    for (auto& [key, running] : running_) {
+        running.cancelled = true;
+        running.rerun.reset();
+    }
+}
+
+inline bool batch_mesher::try_pop(batch_mesh_result& out) {
+    return completed_.try_pop(out);
+}
+
+template <typename Consume>
+std::size_t batch_mesher::drain(Consume&& consume) {
+    std::size_t delivered = 0;
+    batch_mesh_result result;
+    while (completed_.try_pop(result)) {
+        consume(std::move(result));
+        ++delivered;
+    }
+    return delivered;
+}
+
+inline std::size_t batch_mesher::pending() const {
+    std::scoped_lock lock{mutex_};
+    return queued_.size() + running_.size();
+}
+
+inline std::size_t batch_mesher::in_flight() const {
+    std::scoped_lock lock{mutex_};
+    return running_.size();
+}
+
+inline void batch_mesher::wait_idle() {
+    pool_.wait_idle();
+}
+
+inline void batch_mesher::run_next() {
+    region_key key{};
+    std::optional<region_key> viewer{};
+    {
+        // Every queued entry submitted one job, but a job takes whichever live key has the highest priority now.
+        std::scoped_lock lock{mutex_};
+        for (;;) {
+            if (heap_.empty()) {
+                return;
+            }
+            std::pop_heap(heap_.begin(), heap_.end());
+            const auto entry = heap_.back();
+            heap_.pop_back();
+            const auto queued = queued_.find(entry.key);
+            if (queued == queued_.end() || queued->second != entry.ticket) {
+                continue;
+            }
+            queued_.erase(queued);
+            key = entry.key;
+            viewer = viewer_;
+            running_.insert_or_assign(key, running_entry{});
+            break;
+        }
+    }
+
+    // Pool jobs must not throw, and the key has to leave running_ either way or pending() never drains.
+    batch_mesh_result result{key};
+    try {
+        result = mesh_key(key, viewer, contexts_[pool_.worker_index()]);
+    } catch (...) {
+        result = batch_mesh_result{key};
+        result.status = batch_mesh_status::failed;
+        result.error = std::current_exception();
+    }
+
+    std::size_t jobs = 0;
+    {
+        // Publishing before the rerun is queued keeps results for one key in submission order.
+        std::scoped_lock lock{mutex_};
+        const auto running = running_.find(key);
+        if (!running->second.cancelled) {
+            completed_.push(std::move(result));
+        }
+        const auto rerun = running->second.rerun;
+        running_.erase(running);
+        if (rerun) {
+            push_locked(key, *rerun);
+        }
+        jobs = std::exchange(jobs_to_submit_, 0);
+    }
+    for (std::size_t i = 0; i < jobs; ++i) {
+        pool_.submit([this] { run_next(); });
+    }
+}
+
+inline batch_mesh_result batch_mesher::mesh_key(const region_key& key, const std::optional<region_key>& viewer,
+    mesher_context& context) const {
+    batch_mesh_result result{key};
+    const auto snapshot_of = [&](const region_key& at) -> std::shared_ptr<const chunk_storage> {
+        const auto chunk = regions_.find(at);
+        if (!chunk) {
+            return {};
+        }
+        const auto guard = chunk->lock_shared();
+        return chunk->snapshot();
+    };
+
+    const auto center = snapshot_of(key);
+    if (!center) {
+        result.status = batch_mesh_status::missing;
+        return result;
+    }
+    result.revision = center->revision();
+
+    // Marching cubes and vertex lighting sample across chunk edges and corners, so they snapshot all 26 neighbours;
+    // unlit blocky meshing only reads the six face neighbours.
+    const bool diagonals = config_.mesher == batch_mesher_kind::marching_cubes || config_.lighting.enabled();
+    std::array<std::shared_ptr<const chunk_storage>, 27> around{};
+    chunk_neighborhood neighborhood{};
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const int distance = std::abs(dx) + std::abs(dy) + std::abs(dz);
+                if (distance == 0 || (distance > 1 && !diagonals)) {
+                    continue;
+                }
+                auto& snapshot = around[chunk_neighborhood::slot(dx, dy, dz)];
+                snapshot = snapshot_of(region_key{key.x + dx, key.y + dy, key.z + dz});
+                neighborhood.set(dx, dy, dz, snapshot.get());
+            }
+        }
+    }
+    switch (config_.mesher) {
+    case batch_mesher_kind::binary_greedy:
+        result.mesh = context.binary_greedy(*center, neighborhood, config_.lighting);
+        break;
+    case batch_mesher_kind::greedy:
+        result.mesh = context.greedy(*center, neighborhood, config_.lighting);
+        break;
+    case batch_mesher_kind::naive:
+        result.mesh = context.naive(*center, neighborhood, config_.lighting);
+        break;
+    case batch_mesher_kind::marching_cubes:
+        if (config_.lod.enabled() && viewer) {
+            const auto lod = config_.lod.select(key, *viewer);
+            result.lod_level = detail::clamp_lod_level(center->extent(), lod.level);
+            result.mesh = context.marching_cubes(*center, neighborhood, lod, config_.marching_cubes);
+        } else {
+            result.mesh = context.marching_cubes(*center, neighborhood, config_.marching_cubes);
+        }
+        break;
+    }
+    return result;
+}
+
+} // namespace almond::voxel::meshing
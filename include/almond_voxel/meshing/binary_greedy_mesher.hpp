@@ -0,0 +1,330 @@
+#pragma once
+
+#include "almond_voxel/chunk.hpp"
+#include "almond_voxel/core.hpp"
+#include "almond_voxel/meshing/apron.hpp"
+#include "almond_voxel/meshing/greedy_mesher.hpp"
+#include "almond_voxel/meshing/mesh_types.hpp"
+#include "almond_voxel/meshing/neighbors.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+// Largest chunk extent along x and y that the bitmask mesher handles; larger chunks fall back to greedy_mesh.
+inline constexpr std::uint32_t binary_mesh_max_extent = 64;
+
+namespace detail {
+
+[[nodiscard]] constexpr std::uint64_t low_bits(std::size_t count) noexcept {
+    return count >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << count) - 1;
+}
+
+// Greedy rectangle merge over one face plane. rows[v] holds the visible cells of row v as bits along u and is consumed.
+// Runs grow along u first, then along v while the next row covers the whole run with the same id. `id_at(u, v)` is
+// only consulted when the chunk may hold more than one opaque voxel id.
+template <typename IdAt, typename Emit>
+void merge_binary_plane(std::span<std::uint64_t> rows, bool mixed, voxel_id single_id, IdAt&& id_at, Emit&& emit) {
+    for (std::size_t v = 0; v < rows.size(); ++v) {
+        while (rows[v] != 0) {
+            const auto u = static_cast<std::uint32_t>(std::countr_zero(rows[v]));
+            const voxel_id id = mixed ? id_at(u, v) : single_id;
+            auto width = static_cast<std::uint32_t>(std::countr_one(rows[v] >> u));
+            if (mixed) {
+                for (std::uint32_t w = 1; w < width; ++w) {
+                    if (id_at(u + w, v) != id) {
+                        width = w;
+                        break;
+                    }
+                }
+            }
+            const std::uint64_t run = low_bits(width) << u;
+
+            std::size_t height = 1;
+            while (v + height < rows.size() && (rows[v + height] & run) == run) {
+                bool same = true;
+                for (std::uint32_t w = 0; mixed && w < width; ++w) {
+                    if (id_at(u + w, v + height) != id) {
+                        same = false;
+                        break;
+                    }
+                }
+                if (!same) {
+                    break;
+                }
+                ++height;
+            }
+            for (std::size_t h = 0; h < height; ++h) {
+                rows[v + h] &= ~run;
+            }
+            emit(u, static_cast<std::uint32_t>(v), width, static_cast<std::uint32_t>(height), id);
+        }
+    }
+}
+
+} // namespace detail
+
+// Greedy mesher over 64-bit occupancy rows. One pass packs opacity into a bit per voxel along x; face masks then come
+// from shifts (x faces) and ANDs with the adjacent row (y and z faces), and quads are merged with bit scans instead of
+// per-cell tests. Emits the same visible faces as greedy_quads_with_neighbors (y faces may be split into different
+// rectangles), but is_opaque runs once per voxel and neighbor_opaque only for opaque boundary cells. Chunks wider than
+// binary_mesh_max_extent along x or y fall back to greedy_quads_with_neighbors. Bit rows live in `scratch`.
+template <typename IsOpaque, typename NeighborOpaque, typename QuadSink>
+void binary_greedy_quads_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
+    NeighborOpaque&& neighbor_opaque, QuadSink&& sink, mesher_scratch& scratch) {
+    const auto extent = chunk.extent();
+    if (extent.x > binary_mesh_max_extent || extent.y > binary_mesh_max_extent) {
+        greedy_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque),
+            std::forward<NeighborOpaque>(neighbor_opaque), std::forward<QuadSink>(sink), scratch);
+        return;
+    }
+
+    const auto uniform = chunk.uniform_voxel();
+    if ((uniform && !is_opaque(*uniform)) || extent.volume() == 0) {
+        return;
+    }
+    const std::size_t nx = extent.x;
+    const std::size_t ny = extent.y;
+    const std::size_t nz = extent.z;
+
+    // Bit x of rows[y + z * ny] is set when voxel (x, y, z) is opaque.
+    auto& rows = scratch.rows;
+    rows.assign(ny * nz, 0);
+    span3d<const voxel_id> voxels{};
+    bool mixed = false;
+    voxel_id single_id{};
+    if (uniform) {
+        std::fill(rows.begin(), rows.end(), detail::low_bits(nx));
+        single_id = *uniform;
+    } else {
+        voxels = chunk.read_voxels(scratch.voxels);
+        const auto* data = voxels.linear().data();
+        bool found = false;
+        for (std::size_t r = 0; r < rows.size(); ++r) {
+            const auto* row = data + r * nx;
+            std::uint64_t bits = 0;
+            for (std::size_t x = 0; x < nx; ++x) {
+                bits |= std::uint64_t{is_opaque(row[x]) ? 1u : 0u} << x;
+            }
+            rows[r] = bits;
+            // Single-material chunks skip id comparisons while merging.
+            for (auto rest = bits; rest != 0 && !mixed; rest &= rest - 1) {
+                const auto id = row[std::countr_zero(rest)];
+                mixed = found && id != single_id;
+                single_id = found ? single_id : id;
+                found = true;
+            }
+        }
+    }
+
+    const auto neighbor = [&](std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t z) {
+        return neighbor_opaque(std::array<std::ptrdiff_t, 3>{x, y, z});
+    };
+    // Opaque cells just outside the chunk, as bits along x for the y and z boundary rows.
+    const auto boundary_row = [&](std::uint64_t inside, std::ptrdiff_t y, std::ptrdiff_t z) {
+        std::uint64_t bits = 0;
+        for (auto rest = inside; rest != 0; rest &= rest - 1) {
+            const auto x = std::countr_zero(rest);
+            bits |= std::uint64_t{neighbor(x, y, z) ? 1u : 0u} << x;
+        }
+        return bits;
+    };
+
+    auto& plane_rows = scratch.plane_rows;
+    plane_rows.resize(std::max(ny, nz));
+    const auto plane_span = [&](std::size_t count) { return std::span<std::uint64_t>{plane_rows.data(), count}; };
+    const auto id_at = [&](std::size_t x, std::size_t y, std::size_t z) { return voxels(x, y, z); };
+
+    // x faces: shift each row against itself, then scatter the face bits into per-x planes of z rows with y bits.
+    auto& x_planes = scratch.x_planes;
+    x_planes.resize(nx * nz);
+    for (const auto face : {block_face::pos_x, block_face::neg_x}) {
+        const bool positive = face == block_face::pos_x;
+        std::fill(x_planes.begin(), x_planes.end(), 0);
+        for (std::size_t z = 0; z < nz; ++z) {
+            for (std::size_t y = 0; y < ny; ++y) {
+                const auto r = rows[y + z * ny];
+                const std::uint64_t edge = positive ? std::uint64_t{1} << (nx - 1) : 1u;
+                std::uint64_t covered = positive ? r >> 1u : r << 1u;
+                if ((r & edge) != 0 && neighbor(positive ? static_cast<std::ptrdiff_t>(nx) : -1,
+                        static_cast<std::ptrdiff_t>(y), static_cast<std::ptrdiff_t>(z))) {
+                    covered |= edge;
+                }
+                for (auto visible = r & ~covered; visible != 0; visible &= visible - 1) {
+                    x_planes[static_cast<std::size_t>(std::countr_zero(visible)) * nz + z] |= std::uint64_t{1} << y;
+                }
+            }
+        }
+        for (std::size_t x = 0; x < nx; ++x) {
+            detail::merge_binary_plane(std::span<std::uint64_t>{x_planes.data() + x * nz, nz}, mixed, single_id,
+                [&](std::size_t u, std::size_t v) { return id_at(x, u, v); },
+                [&](std::uint32_t u, std::uint32_t v, std::uint32_t w, std::uint32_t h, voxel_id id) {
+                    sink(quad{face, {static_cast<std::uint32_t>(x), u, v}, w, h, id});
+                });
+        }
+    }
+
+    // y faces: AND each row with its neighbour along y; planes hold z rows with x bits.
+    for (const auto face : {block_face::pos_y, block_face::neg_y}) {
+        const bool positive = face == block_face::pos_y;
+        for (std::size_t y = 0; y < ny; ++y) {
+            const bool boundary = positive ? y + 1 == ny : y == 0;
+            const auto outside = positive ? static_cast<std::ptrdiff_t>(ny) : -1;
+            for (std::size_t z = 0; z < nz; ++z) {
+                const auto r = rows[y + z * ny];
+                const auto covered = boundary ? boundary_row(r, outside, static_cast<std::ptrdiff_t>(z))
+                                              : rows[(positive ? y + 1 : y - 1) + z * ny];
+                plane_rows[z] = r & ~covered;
+            }
+            detail::merge_binary_plane(plane_span(nz), mixed, single_id,
+                [&](std::size_t u, std::size_t v) { return id_at(u, y, v); },
+                [&](std::uint32_t u, std::uint32_t v, std::uint32_t w, std::uint32_t h, voxel_id id) {
+                    sink(quad{face, {u, static_cast<std::uint32_t>(y), v}, h, w, id});
+                });
+        }
+    }
+
+    // z faces: AND each row with the same row one layer up or down; planes hold y rows with x bits.
+    for (const auto face : {block_face::pos_z, block_face::neg_z}) {
+        const bool positive = face == block_face::pos_z;
+        for (std::size_t z = 0; z < nz; ++z) {
+            const bool boundary = positive ? z + 1 == nz : z == 0;
+            const auto outside = positive ? static_cast<std::ptrdiff_t>(nz) : -1;
+            for (std::size_t y = 0; y < ny; ++y) {
+                const auto r = rows[y + z * ny];
+                const auto covered = boundary ? boundary_row(r, static_cast<std::ptrdiff_t>(y), outside)
+                                              : rows[y + (positive ? z + 1 : z - 1) * ny];
+                plane_rows[y] = r & ~covered;
+            }
+            detail::merge_binary_plane(plane_span(ny), mixed, single_id,
+                [&](std::size_t u, std::size_t v) { return id_at(u, v, z); },
+                [&](std::uint32_t u, std::uint32_t v, std::uint32_t w, std::uint32_t h, voxel_id id) {
+                    sink(quad{face, {u, v, static_cast<std::uint32_t>(z)}, w, h, id});
+                });
+        }
+    }
+}
+
+template <typename IsOpaque, typename NeighborOpaque, typename QuadSink>
+void binary_greedy_quads_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
+    NeighborOpaque&& neighbor_opaque, QuadSink&& sink) {
+    mesher_scratch scratch;
+    binary_greedy_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque),
+        std::forward<NeighborOpaque>(neighbor_opaque), std::forward<QuadSink>(sink), scratch);
+}
+
+namespace detail {
+
+inline void append_quads(mesh_result& result, const std::vector<quad>& quads) {
+    result.vertices.reserve(result.vertices.size() + quads.size() * 4);
+    result.indices.reserve(result.indices.size() + quads.size() * 6);
+    for (const auto& q : quads) {
+        append_quad(result, q);
+    }
+}
+
+} // namespace detail
+
+template <typename IsOpaque, typename NeighborOpaque>
+[[nodiscard]] mesh_result binary_greedy_mesh_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
+    NeighborOpaque&& neighbor_opaque) {
+    // Quads are gathered first so the vertex and index buffers are sized exactly once.
+    std::vector<quad> quads;
+    binary_greedy_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque),
+        std::forward<NeighborOpaque>(neighbor_opaque), [&quads](const quad& q) { quads.push_back(q); });
+    mesh_result result;
+    detail::append_quads(result, quads);
+    return result;
+}
+
+// Meshes against all 26 neighbours. Shades differ per voxel face, which the bit-plane merge cannot compare, so lit
+// meshes come from greedy_quads_with_neighborhood instead.
+template <typename IsOpaque, typename QuadSink>
+void binary_greedy_quads_with_neighborhood(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting, QuadSink&& sink, mesher_scratch& scratch) {
+    if (lighting.enabled()) {
+        greedy_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+            std::forward<QuadSink>(sink), scratch);
+        return;
+    }
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_opaque(*uniform)) {
+        return;
+    }
+    // The bit rows convert the centre themselves, so only the apron shell goes through is_opaque here.
+    auto& opacity = scratch.opacity;
+    detail::build_opacity_shell(chunk, neighborhood, is_opaque, opacity);
+    auto neighbor_sampler = [&opacity](const std::array<std::ptrdiff_t, 3>& coord) {
+        return opacity(coord[0], coord[1], coord[2]) != 0;
+    };
+
+    binary_greedy_quads_with_neighbors(chunk, is_opaque, neighbor_sampler, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque, typename QuadSink>
+void binary_greedy_quads_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque, QuadSink&& sink, mesher_scratch& scratch) {
+    binary_greedy_quads_with_neighborhood(chunk, chunk_neighborhood::from_faces(neighbors),
+        std::forward<IsOpaque>(is_opaque), mesh_lighting_config{}, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque, typename QuadSink>
+void binary_greedy_quads_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque, QuadSink&& sink) {
+    mesher_scratch scratch;
+    binary_greedy_quads_with_neighbor_chunks(chunk, neighbors, std::forward<IsOpaque>(is_opaque),
+        std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result binary_greedy_mesh_with_neighbor_chunks(const chunk_storage& chunk,
+    const chunk_neighbors& neighbors, IsOpaque&& is_opaque) {
+    std::vector<quad> quads;
+    binary_greedy_quads_with_neighbor_chunks(chunk, neighbors, std::forward<IsOpaque>(is_opaque),
+        [&quads](const quad& q) { quads.push_back(q); });
+    mesh_result result;
+    detail::append_quads(result, quads);
+    return result;
+}
+
+inline mesh_result binary_greedy_mesh_with_neighbor_chunks(const chunk_storage& chunk,
+    const chunk_neighbors& neighbors) {
+    return binary_greedy_mesh_with_neighbor_chunks(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result binary_greedy_mesh_with_neighborhood(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, IsOpaque&& is_opaque, const mesh_lighting_config& lighting = {}) {
+    std::vector<quad> quads;
+    mesher_scratch scratch;
+    binary_greedy_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [&quads](const quad& q) { quads.push_back(q); }, scratch);
+    mesh_result result;
+    detail::append_quads(result, quads);
+    return result;
+}
+
+inline mesh_result binary_greedy_mesh_with_neighborhood(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, const mesh_lighting_config& lighting = {}) {
+    return binary_greedy_mesh_with_neighborhood(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; },
+        lighting);
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result binary_greedy_mesh(const chunk_storage& chunk, IsOpaque&& is_opaque) {
+    auto neighbor = [](const std::array<std::ptrdiff_t, 3>&) { return false; };
+    return binary_greedy_mesh_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), neighbor);
+}
+
+inline mesh_result binary_greedy_mesh(const chunk_storage& chunk) {
+    return binary_greedy_mesh(chunk, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+} // namespace almond::voxel::meshing
@@ -3,7 +3,9 @@
 #include "almond_voxel/chunk.hpp"
 #include "almond_voxel/core.hpp"
 #include "almond_voxel/meshing/mesh_types.hpp"
+#include "almond_voxel/meshing/apron.hpp"
 #include "almond_voxel/meshing/neighbors.hpp"
+#include "almond_voxel/meshing/vertex_shading.hpp"
 
 #include <array>
 #include <cstddef>
@@ -13,21 +15,32 @@
 
 namespace almond::voxel::meshing {
 
-template <typename IsOpaque, typename NeighborOpaque>
-[[nodiscard]] mesh_result greedy_mesh_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
-    NeighborOpaque&& neighbor_opaque) {
-    mesh_result result;
+namespace detail {
+
+// `shade(face, x, y, z)` returns the corner shades of one voxel face; faces only merge when their shades match.
+template <typename IsOpaque, typename NeighborOpaque, typename Shade, typename QuadSink>
+void greedy_quads(const chunk_storage& chunk, IsOpaque&& is_opaque, NeighborOpaque&& neighbor_opaque,
+    const Shade& shade, QuadSink&& sink, mesher_scratch& scratch) {
     const auto extent = chunk.extent();
     const auto dims = extent.to_array();
-    const auto voxels = chunk.voxels();
 
-    struct mask_cell {
-        bool filled{false};
-        voxel_id id{0};
+    // Uniform chunks only expose their boundary planes; empty ones produce nothing.
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_opaque(*uniform)) {
+        return;
+    }
+    span3d<const voxel_id> voxels{};
+    if (!uniform) {
+        voxels = chunk.read_voxels(scratch.voxels);
+    }
+    const auto sample = [&](std::size_t x, std::size_t y, std::size_t z) {
+        return uniform ? *uniform : voxels(x, y, z);
     };
 
+    using mask_cell = detail::greedy_mask_cell;
+    auto& mask = scratch.mask;
+
     const std::array faces{block_face::pos_x, block_face::neg_x, block_face::pos_y, block_face::neg_y, block_face::pos_z, block_face::neg_z};
-    constexpr float vertical_face_bias = 0.001f;
 
     for (auto face : faces) {
         const std::size_t axis = static_cast<std::size_t>(axis_of(face));
@@ -37,9 +50,14 @@ template <typename IsOpaque, typename NeighborOpaque>
         const std::size_t du = dims[u_axis];
         const std::size_t dv = dims[v_axis];
 
-        std::vector<mask_cell> mask(du * dv);
+        if (dims[axis] == 0) {
+            continue;
+        }
+        mask.resize(du * dv);
+        const std::size_t first_plane = uniform && sign > 0 ? dims[axis] - 1 : 0;
+        const std::size_t last_plane = uniform && sign < 0 ? 1 : dims[axis];
 
-        for (std::size_t plane = 0; plane < dims[axis]; ++plane) {
+        for (std::size_t plane = first_plane; plane < last_plane; ++plane) {
             std::fill(mask.begin(), mask.end(), mask_cell{});
 
             for (std::size_t v = 0; v < dv; ++v) {
@@ -50,7 +68,7 @@ template <typename IsOpaque, typename NeighborOpaque>
                     pos[u_axis] = u;
                     pos[v_axis] = v;
 
-                    const voxel_id current = voxels(pos[0], pos[1], pos[2]);
+                    const voxel_id current = sample(pos[0], pos[1], pos[2]);
                     if (!is_opaque(current)) {
                         continue;
                     }
@@ -69,7 +87,7 @@ template <typename IsOpaque, typename NeighborOpaque>
 
                     bool neighbor_solid = false;
                     if (neighbor_inside) {
-                        neighbor_solid = is_opaque(voxels(neighbor[0], neighbor[1], neighbor[2]));
+                        neighbor_solid = is_opaque(sample(neighbor[0], neighbor[1], neighbor[2]));
                     } else {
                         std::array<std::ptrdiff_t, 3> neighbor_local{
                             static_cast<std::ptrdiff_t>(pos[0]),
@@ -81,7 +99,9 @@ template <typename IsOpaque, typename NeighborOpaque>
                     }
 
                     if (!neighbor_solid) {
-                        mask[idx] = mask_cell{true, current};
+                        mask[idx] = mask_cell{true, current,
+                            shade(face, static_cast<std::uint32_t>(pos[0]), static_cast<std::uint32_t>(pos[1]),
+                                static_cast<std::uint32_t>(pos[2]))};
                     }
                 }
             }
@@ -97,7 +117,7 @@ template <typename IsOpaque, typename NeighborOpaque>
                     std::size_t width = 1;
                     while (u + width < du) {
                         const auto& next = mask[idx + width];
-                        if (!next.filled || next.id != cell.id) {
+                        if (!next.filled || next.id != cell.id || next.shade != cell.shade) {
                             break;
                         }
                         ++width;
@@ -108,7 +128,7 @@ template <typename IsOpaque, typename NeighborOpaque>
                     while (v + height < dv && !stop) {
                         for (std::size_t x = 0; x < width; ++x) {
                             const auto& next = mask[idx + x + height * du];
-                            if (!next.filled || next.id != cell.id) {
+                            if (!next.filled || next.id != cell.id || next.shade != cell.shade) {
                                 stop = true;
                                 break;
                             }
@@ -118,47 +138,12 @@ template <typename IsOpaque, typename NeighborOpaque>
                         }
                     }
 
-                    float axis_coord = static_cast<float>(plane + (sign > 0 ? 1 : 0));
-                    if (axis == 2) {
-                        axis_coord += sign > 0 ? vertical_face_bias : -vertical_face_bias;
-                    }
-                    std::array<float, 3> base{0.0f, 0.0f, 0.0f};
-                    base[axis] = axis_coord;
-                    base[u_axis] = static_cast<float>(u);
-                    base[v_axis] = static_cast<float>(v);
-
-                    std::array<float, 3> du_vec{0.0f, 0.0f, 0.0f};
-                    du_vec[u_axis] = static_cast<float>(width);
-                    std::array<float, 3> dv_vec{0.0f, 0.0f, 0.0f};
-                    dv_vec[v_axis] = static_cast<float>(height);
-
-                    std::array<std::array<float, 3>, 4> corners{
-                        base,
-                        std::array<float, 3>{base[0] + du_vec[0], base[1] + du_vec[1], base[2] + du_vec[2]},
-                        std::array<float, 3>{base[0] + du_vec[0] + dv_vec[0], base[1] + du_vec[1] + dv_vec[1], base[2] + du_vec[2] + dv_vec[2]},
-                        std::array<float, 3>{base[0] + dv_vec[0], base[1] + dv_vec[1], base[2] + dv_vec[2]}
-                    };
-
-                    std::array<std::array<float, 2>, 4> uv{
-                        std::array<float, 2>{0.0f, 0.0f},
-                        std::array<float, 2>{static_cast<float>(width), 0.0f},
-                        std::array<float, 2>{static_cast<float>(width), static_cast<float>(height)},
-                        std::array<float, 2>{0.0f, static_cast<float>(height)}
-                    };
-
-                    const auto normal_i = face_normal(face);
-                    const std::array<float, 3> normal{static_cast<float>(normal_i[0]), static_cast<float>(normal_i[1]), static_cast<float>(normal_i[2])};
-
-                    const auto base_index = static_cast<std::uint32_t>(result.vertices.size());
-                    for (std::size_t i = 0; i < 4; ++i) {
-                        result.vertices.push_back(vertex{corners[i], normal, uv[i], cell.id});
-                    }
-
-                    if (sign > 0) {
-                        result.indices.insert(result.indices.end(), {base_index, base_index + 1, base_index + 2, base_index, base_index + 2, base_index + 3});
-                    } else {
-                        result.indices.insert(result.indices.end(), {base_index, base_index + 2, base_index + 1, base_index, base_index + 3, base_index + 2});
-                    }
+                    quad merged{face, {}, static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height), cell.id,
+                        cell.shade};
+                    merged.origin[axis] = static_cast<std::uint32_t>(plane);
+                    merged.origin[u_axis] = static_cast<std::uint32_t>(u);
+                    merged.origin[v_axis] = static_cast<std::uint32_t>(v);
+                    sink(merged);
 
                     for (std::size_t dy = 0; dy < height; ++dy) {
                         for (std::size_t dx = 0; dx < width; ++dx) {
@@ -169,26 +154,99 @@ template <typename IsOpaque, typename NeighborOpaque>
             }
         }
     }
+}
+
+} // namespace detail
+
+// Emits merged face rectangles to `sink(const quad&)`; greedy_mesh_with_neighbors turns them into float vertices and
+// packed_mesh.hpp provides compact sinks. The face mask lives in `scratch`.
+template <typename IsOpaque, typename NeighborOpaque, typename QuadSink>
+void greedy_quads_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque, NeighborOpaque&& neighbor_opaque,
+    QuadSink&& sink, mesher_scratch& scratch) {
+    detail::greedy_quads(chunk, std::forward<IsOpaque>(is_opaque), std::forward<NeighborOpaque>(neighbor_opaque),
+        detail::no_shading{}, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque, typename NeighborOpaque, typename QuadSink>
+void greedy_quads_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque, NeighborOpaque&& neighbor_opaque,
+    QuadSink&& sink) {
+    mesher_scratch scratch;
+    greedy_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), std::forward<NeighborOpaque>(neighbor_opaque),
+        std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque, typename NeighborOpaque>
+[[nodiscard]] mesh_result greedy_mesh_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
+    NeighborOpaque&& neighbor_opaque) {
+    mesh_result result;
+    greedy_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), std::forward<NeighborOpaque>(neighbor_opaque),
+        [&result](const quad& q) { append_quad(result, q); });
+    return result;
+}
+
+// Meshes against all 26 neighbours and bakes the lighting requested in `lighting` into each quad's shade, so ambient
+// occlusion and smooth light seam across chunk faces, edges and corners. Lit faces only merge with faces of the same
+// shade, so lighting costs quads. Padded grids live in `scratch`.
+template <typename IsOpaque, typename QuadSink>
+void greedy_quads_with_neighborhood(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting, QuadSink&& sink, mesher_scratch& scratch) {
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_opaque(*uniform)) {
+        return;
+    }
+    // Unlit meshing only samples the apron; ambient occlusion also reads the centre cells.
+    auto& opacity = scratch.opacity;
+    detail::build_opacity_apron(chunk, neighborhood, is_opaque, opacity, lighting.enabled());
+    auto neighbor_sampler = [&opacity](const std::array<std::ptrdiff_t, 3>& coord) {
+        return opacity(coord[0], coord[1], coord[2]) != 0;
+    };
+
+    if (!lighting.enabled()) {
+        detail::greedy_quads(chunk, is_opaque, neighbor_sampler, detail::no_shading{}, std::forward<QuadSink>(sink),
+            scratch);
+        return;
+    }
+    const auto shader = detail::prepare_face_shader(chunk, neighborhood, lighting, scratch);
+    detail::greedy_quads(chunk, is_opaque, neighbor_sampler, shader, std::forward<QuadSink>(sink), scratch);
+}
 
+template <typename IsOpaque>
+[[nodiscard]] mesh_result greedy_mesh_with_neighborhood(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, IsOpaque&& is_opaque, const mesh_lighting_config& lighting = {}) {
+    mesh_result result;
+    mesher_scratch scratch;
+    greedy_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [&result](const quad& q) { append_quad(result, q); }, scratch);
     return result;
 }
 
+inline mesh_result greedy_mesh_with_neighborhood(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    const mesh_lighting_config& lighting = {}) {
+    return greedy_mesh_with_neighborhood(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; }, lighting);
+}
+
+template <typename IsOpaque, typename QuadSink>
+void greedy_quads_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque, QuadSink&& sink, mesher_scratch& scratch) {
+    greedy_quads_with_neighborhood(chunk, chunk_neighborhood::from_faces(neighbors), std::forward<IsOpaque>(is_opaque),
+        mesh_lighting_config{}, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque, typename QuadSink>
+void greedy_quads_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque, QuadSink&& sink) {
+    mesher_scratch scratch;
+    greedy_quads_with_neighbor_chunks(chunk, neighbors, std::forward<IsOpaque>(is_opaque),
+        std::forward<QuadSink>(sink), scratch);
+}
+
 template <typename IsOpaque>
 [[nodiscard]] mesh_result greedy_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
     IsOpaque&& is_opaque) {
-    const auto neighbor_views = detail::load_neighbor_views(neighbors);
-    auto neighbor_sampler = [&, dims = chunk.extent()](const std::array<std::ptrdiff_t, 3>& coord) {
-        std::array<std::ptrdiff_t, 3> local = coord;
-        const detail::neighbor_view* view = nullptr;
-        if (!detail::remap_to_neighbor_coords(dims, local, neighbor_views, view)) {
-            return false;
-        }
-
-        return is_opaque(view->voxels(static_cast<std::size_t>(local[0]), static_cast<std::size_t>(local[1]),
-            static_cast<std::size_t>(local[2])));
-    };
-
-    return greedy_mesh_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), neighbor_sampler);
+    mesh_result result;
+    greedy_quads_with_neighbor_chunks(chunk, neighbors, std::forward<IsOpaque>(is_opaque),
+        [&result](const quad& q) { append_quad(result, q); });
+    return result;
 }
 
 inline mesh_result greedy_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors) {
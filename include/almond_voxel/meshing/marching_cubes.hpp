@@ -1,16 +1,20 @@
 #pragma once
 
 #include "almond_voxel/chunk.hpp"
+#include "almond_voxel/meshing/apron.hpp"
 #include "almond_voxel/meshing/mesh_types.hpp"
 #include "almond_voxel/meshing/neighbors.hpp"
 #include "almond_voxel/meshing/marching_cubes_tables.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <optional>
+#include <span>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace almond::voxel::meshing {
 
@@ -20,6 +24,17 @@ struct marching_cubes_config {
     float iso_value{0.5f};
 };
 
+// Wraps a row sampler `fill(y, z, std::span<float> row)` that writes the densities of points (0..extent.x, y, z) in
+// one call, so samplers backed by contiguous memory or vectorised noise avoid a call per point. Pass it wherever a
+// density sampler is accepted.
+template <typename Fill>
+struct density_rows {
+    Fill fill;
+};
+
+template <typename Fill>
+density_rows(Fill) -> density_rows<Fill>;
+
 namespace detail {
 
 inline constexpr std::array<std::array<int, 3>, 8> cube_corners{{
@@ -33,143 +48,362 @@ inline constexpr std::array<std::array<int, 3>, 8> cube_corners{{
     {{0, 1, 1}},
 }};
 
-inline constexpr std::array<std::array<int, 2>, 12> edge_connection{{
-    {{0, 1}},
-    {{1, 2}},
-    {{2, 3}},
-    {{3, 0}},
-    {{4, 5}},
-    {{5, 6}},
-    {{6, 7}},
-    {{7, 4}},
-    {{0, 4}},
-    {{1, 5}},
-    {{2, 6}},
-    {{3, 7}},
+// Each cube edge as {axis, x, y, z}: the edge starts at cube corner (x, y, z) and runs along `axis`. Edges are keyed by
+// their lower end, so the cells sharing an edge find the same cached vertex.
+inline constexpr std::array<std::array<int, 4>, 12> cube_edges{{
+    {{0, 0, 0, 0}},
+    {{1, 1, 0, 0}},
+    {{0, 0, 1, 0}},
+    {{1, 0, 0, 0}},
+    {{0, 0, 0, 1}},
+    {{1, 1, 0, 1}},
+    {{0, 0, 1, 1}},
+    {{1, 0, 0, 1}},
+    {{2, 0, 0, 0}},
+    {{2, 1, 0, 0}},
+    {{2, 1, 1, 0}},
+    {{2, 0, 1, 0}},
 }};
 
-inline std::array<float, 3> interpolate_vertex(const std::array<float, 3>& p0, const std::array<float, 3>& p1,
-    float v0, float v1, float iso_value) {
-    const float delta = v1 - v0;
-    if (std::abs(delta) < 1e-6f) {
-        return p0;
-    }
-    const float mu = (iso_value - v0) / delta;
-    return std::array<float, 3>{
-        p0[0] + mu * (p1[0] - p0[0]),
-        p0[1] + mu * (p1[1] - p0[1]),
-        p0[2] + mu * (p1[2] - p0[2])
-    };
+inline constexpr std::uint32_t no_cached_vertex = 0xFFFFFFFFu;
+
+template <typename DensitySampler>
+struct is_density_rows : std::false_type {};
+
+template <typename Fill>
+struct is_density_rows<density_rows<Fill>> : std::true_type {};
+
+// Adapts a density sampler to the row form the slab loop reads; point samplers are called once per row point.
+template <typename DensitySampler>
+[[nodiscard]] auto row_sampler(DensitySampler& density_sampler) {
+    if constexpr (is_density_rows<std::remove_cvref_t<DensitySampler>>::value) {
+        return [&density_sampler](std::size_t y, std::size_t z, std::span<float> row) {
+            density_sampler.fill(y, z, row);
+        };
+    } else {
+        return [&density_sampler](std::size_t y, std::size_t z, std::span<float> row) {
+            for (std::size_t x = 0; x < row.size(); ++x) {
+                row[x] = static_cast<float>(density_sampler(x, y, z));
+            }
+        };
+    }
 }
 
-inline std::array<float, 3> compute_normal(const std::array<float, 3>& p0, const std::array<float, 3>& p1,
-    const std::array<float, 3>& p2) {
-    const std::array<float, 3> u{
-        p1[0] - p0[0],
-        p1[1] - p0[1],
-        p1[2] - p0[2]
-    };
-    const std::array<float, 3> v{
-        p2[0] - p0[0],
-        p2[1] - p0[1],
-        p2[2] - p0[2]
-    };
+// Density gradient at a lattice point of `lattice` (anything with at(x, y, z) and limits()) from central differences,
+// one-sided on the lattice boundary. Used for caller-supplied samplers, which cannot be read outside the lattice.
+template <typename Lattice>
+[[nodiscard]] std::array<float, 3> lattice_gradient(const Lattice& lattice, const std::array<std::size_t, 3>& point) {
+    const auto limit = lattice.limits();
+    std::array<float, 3> result{};
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+        auto lo = point;
+        auto hi = point;
+        lo[axis] = point[axis] > 0 ? point[axis] - 1 : 0;
+        hi[axis] = point[axis] < limit[axis] ? point[axis] + 1 : limit[axis];
+        if (lo[axis] == hi[axis]) {
+            continue;
+        }
+        result[axis] = (lattice.at(hi[0], hi[1], hi[2]) - lattice.at(lo[0], lo[1], lo[2]))
+            / static_cast<float>(hi[axis] - lo[axis]);
+    }
+    return result;
+}
 
-    std::array<float, 3> normal{
-        v[1] * u[2] - v[2] * u[1],
-        v[2] * u[0] - v[0] * u[2],
-        v[0] * u[1] - v[1] * u[0]
-    };
+struct lattice_gradients {
+    template <typename Lattice>
+    [[nodiscard]] std::array<float, 3> operator()(
+        const Lattice& lattice, const std::array<std::size_t, 3>& point) const {
+        return lattice_gradient(lattice, point);
+    }
+};
+
+// Central differences read from the padded density grid instead of the lattice, one lattice step either side of every
+// point, so both chunks on a seam compute the same normal for a shared vertex. Lattice point p sits on voxel p * step,
+// which needs an apron of step + 1 voxels; padded_density_apron() gives it.
+struct padded_gradients {
+    const padded_grid<float>* density{nullptr};
+    std::ptrdiff_t step{1};
+
+    template <typename Lattice>
+    [[nodiscard]] std::array<float, 3> operator()(const Lattice&, const std::array<std::size_t, 3>& point) const {
+        const std::array<std::ptrdiff_t, 3> voxel{static_cast<std::ptrdiff_t>(point[0]) * step,
+            static_cast<std::ptrdiff_t>(point[1]) * step, static_cast<std::ptrdiff_t>(point[2]) * step};
+        const auto base = static_cast<std::ptrdiff_t>(density->index(voxel[0], voxel[1], voxel[2]));
+        std::array<float, 3> result{};
+        for (int axis = 0; axis < 3; ++axis) {
+            std::array<int, 3> unit{};
+            unit[static_cast<std::size_t>(axis)] = 1;
+            const auto reach = density->offset(unit[0], unit[1], unit[2]) * step;
+            result[static_cast<std::size_t>(axis)] = ((*density)[static_cast<std::size_t>(base + reach)]
+                                                         - (*density)[static_cast<std::size_t>(base - reach)])
+                * 0.5f;
+        }
+        return result;
+    }
+};
+
+[[nodiscard]] constexpr std::uint32_t padded_density_apron(std::size_t step) noexcept {
+    return static_cast<std::uint32_t>(step) + 1;
+}
+
+// The surface vertex on the lattice edge that starts at `lo` and runs along `axis`, with positions scaled by
+// `cell_size`. Meshing and LOD stitching both build vertices here, so the same edge always lands on the same point.
+template <typename Lattice, typename Gradient = lattice_gradients>
+[[nodiscard]] vertex edge_vertex(const Lattice& lattice, const std::array<std::size_t, 3>& lo, int axis,
+    float iso_value, voxel_id material, float cell_size, const Gradient& gradient = {}) {
+    const auto a = static_cast<std::size_t>(axis);
+    auto hi = lo;
+    ++hi[a];
+    const float v0 = lattice.at(lo[0], lo[1], lo[2]);
+    const float v1 = lattice.at(hi[0], hi[1], hi[2]);
+    const float delta = v1 - v0;
+    const float mu = std::abs(delta) < 1e-6f ? 0.0f : (iso_value - v0) / delta;
+
+    std::array<float, 3> position{static_cast<float>(lo[0]), static_cast<float>(lo[1]), static_cast<float>(lo[2])};
+    position[a] += mu;
+    for (auto& coordinate : position) {
+        coordinate *= cell_size;
+    }
 
+    const auto g0 = gradient(lattice, lo);
+    const auto g1 = gradient(lattice, hi);
+    std::array<float, 3> normal{g0[0] + mu * (g1[0] - g0[0]), g0[1] + mu * (g1[1] - g0[1]),
+        g0[2] + mu * (g1[2] - g0[2])};
     const float length_sq = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
     if (length_sq <= 1e-12f) {
-        return std::array<float, 3>{0.0f, 0.0f, 0.0f};
+        // Flat field around the edge: face away from its solid end.
+        normal = {0.0f, 0.0f, 0.0f};
+        normal[a] = v0 < iso_value ? 1.0f : -1.0f;
+    } else {
+        const float inv_length = 1.0f / std::sqrt(length_sq);
+        normal = {normal[0] * inv_length, normal[1] * inv_length, normal[2] * inv_length};
     }
-    const float inv_length = 1.0f / std::sqrt(length_sq);
-    normal[0] *= inv_length;
-    normal[1] *= inv_length;
-    normal[2] *= inv_length;
-    return normal;
+    return vertex{position, normal, {position[0], position[1]}, material};
 }
 
-} // namespace detail
+// Density lattice of (extent + 1)^3 points, read one z slice at a time into a ring of four slices: a slab of cells
+// between slices z and z + 1 needs z - 1 and z + 2 for central-difference gradients. Every point is sampled once.
+class density_slab_cache {
+public:
+    density_slab_cache(chunk_extent extent, std::vector<float>& storage)
+        : nx_{static_cast<std::size_t>(extent.x) + 1},
+          ny_{static_cast<std::size_t>(extent.y) + 1},
+          nz_{static_cast<std::size_t>(extent.z) + 1},
+          storage_{storage} {
+        storage_.resize(nx_ * ny_ * 4);
+    }
 
-template <typename DensitySampler, typename MaterialSampler>
-[[nodiscard]] mesh_result marching_cubes(chunk_extent extent, DensitySampler&& density_sampler,
-    MaterialSampler&& material_sampler, const marching_cubes_config& config = {}) {
-    mesh_result result;
-    const std::size_t approximate_cells = static_cast<std::size_t>(extent.volume());
-    result.vertices.reserve(approximate_cells * 3);
-    result.indices.reserve(approximate_cells * 3);
+    // Loads the slices up to `z`; each is read once, in order.
+    template <typename RowSampler>
+    void load_through(std::size_t z, RowSampler& fill_row) {
+        for (; loaded_ <= z && loaded_ < nz_; ++loaded_) {
+            float* slice = storage_.data() + (loaded_ % 4) * nx_ * ny_;
+            for (std::size_t y = 0; y < ny_; ++y) {
+                fill_row(y, loaded_, std::span<float>{slice + y * nx_, nx_});
+            }
+        }
+    }
+
+    [[nodiscard]] const float* slice(std::size_t z) const noexcept {
+        return storage_.data() + (z % 4) * nx_ * ny_;
+    }
+
+    [[nodiscard]] float at(std::size_t x, std::size_t y, std::size_t z) const noexcept {
+        return slice(z)[x + nx_ * y];
+    }
+
+    [[nodiscard]] std::array<std::size_t, 3> limits() const noexcept { return {nx_ - 1, ny_ - 1, nz_ - 1}; }
 
-    std::array<std::array<float, 3>, 12> edge_vertices{};
-    const auto& edge_table = detail::mc_edge_table;
-    const auto& triangle_table = detail::mc_triangle_table;
+    [[nodiscard]] std::size_t points_x() const noexcept { return nx_; }
+    [[nodiscard]] std::size_t slice_size() const noexcept { return nx_ * ny_; }
+
+private:
+    std::size_t nx_;
+    std::size_t ny_;
+    std::size_t nz_;
+    std::vector<float>& storage_;
+    std::size_t loaded_{0};
+};
+
+// Marches the cells one z slab at a time. Edge vertices are created once and cached by their lower lattice point: x
+// and y edges for the slab's bottom and top layers (the top layer becomes the next slab's bottom) and z edges for the
+// slab itself. New vertices go to `emit_vertex(const vertex&)`, which returns the index triangles use, and triangles go
+// to `emit_triangle(const std::array<std::uint32_t, 3>&)` in counter-clockwise order. Normals interpolate the density
+// gradient at the edge ends, taken from `gradient(lattice, point)`, so shared vertices shade smoothly. `extent` counts
+// cells, and positions are scaled by `cell_size`.
+template <typename RowSampler, typename MaterialSampler, typename EmitVertex, typename EmitTriangle,
+    typename Gradient = lattice_gradients>
+void march_slabs(chunk_extent extent, RowSampler&& fill_row, MaterialSampler& material_sampler,
+    const marching_cubes_config& config, mesher_scratch& scratch, EmitVertex&& emit_vertex,
+    EmitTriangle&& emit_triangle, float cell_size = 1.0f, const Gradient& gradient = {}) {
+    if (extent.x == 0 || extent.y == 0 || extent.z == 0) {
+        return;
+    }
+    density_slab_cache density{extent, scratch.density_slices};
+    const auto nx = density.points_x();
+    const auto slice_size = density.slice_size();
+
+    // Layout: x and y edges of layer 0, x and y edges of layer 1, z edges of the current slab.
+    auto& edge_cache = scratch.edge_vertices;
+    edge_cache.assign(slice_size * 5, no_cached_vertex);
+    const auto cached_vertex = [&](int axis, std::size_t point, std::size_t z_layer) -> std::uint32_t& {
+        if (axis == 2) {
+            return edge_cache[slice_size * 4 + point];
+        }
+        return edge_cache[slice_size * (2 * (z_layer & 1u) + static_cast<std::size_t>(axis)) + point];
+    };
+
+    const auto& edge_table = mc_edge_table;
+    const auto& triangle_table = mc_triangle_table;
+    std::array<std::uint32_t, 12> cell_vertices{};
 
     for (std::size_t z = 0; z < extent.z; ++z) {
+        density.load_through(z + 2, fill_row);
+        if (z > 0) {
+            std::fill_n(edge_cache.begin() + static_cast<std::ptrdiff_t>(slice_size * 2 * ((z + 1) & 1u)),
+                slice_size * 2, no_cached_vertex);
+            std::fill_n(edge_cache.begin() + static_cast<std::ptrdiff_t>(slice_size * 4), slice_size,
+                no_cached_vertex);
+        }
+        const float* bottom = density.slice(z);
+        const float* top = density.slice(z + 1);
+
         for (std::size_t y = 0; y < extent.y; ++y) {
             for (std::size_t x = 0; x < extent.x; ++x) {
-                std::array<float, 8> corner_values{};
-                std::array<std::array<float, 3>, 8> corner_positions{};
-
-                for (int corner = 0; corner < 8; ++corner) {
-                    const auto& offset = detail::cube_corners[corner];
-                    const std::size_t sample_x = x + static_cast<std::size_t>(offset[0]);
-                    const std::size_t sample_y = y + static_cast<std::size_t>(offset[1]);
-                    const std::size_t sample_z = z + static_cast<std::size_t>(offset[2]);
-                    corner_values[corner] = static_cast<float>(density_sampler(sample_x, sample_y, sample_z));
-                    corner_positions[corner] = std::array<float, 3>{
-                        static_cast<float>(x + offset[0]),
-                        static_cast<float>(y + offset[1]),
-                        static_cast<float>(z + offset[2])
-                    };
-                }
+                const std::size_t point = x + nx * y;
+                const std::array<float, 8> corner_values{bottom[point], bottom[point + 1], bottom[point + 1 + nx],
+                    bottom[point + nx], top[point], top[point + 1], top[point + 1 + nx], top[point + nx]};
 
                 int cube_index = 0;
                 for (int corner = 0; corner < 8; ++corner) {
-                    if (corner_values[corner] < config.iso_value) {
+                    if (corner_values[static_cast<std::size_t>(corner)] < config.iso_value) {
                         cube_index |= (1 << corner);
                     }
                 }
-
-                if (edge_table[cube_index] == 0) {
+                const int edges = edge_table[cube_index];
+                if (edges == 0) {
                     continue;
                 }
 
-                for (int edge = 0; edge < 12; ++edge) {
-                    if ((edge_table[cube_index] & (1 << edge)) == 0) {
+                const voxel_id material = material_sampler(x, y, z);
+                for (std::size_t edge = 0; edge < cube_edges.size(); ++edge) {
+                    if ((edges & (1 << edge)) == 0) {
                         continue;
                     }
-                    const auto connection = detail::edge_connection[static_cast<std::size_t>(edge)];
-                    edge_vertices[edge] = detail::interpolate_vertex(
-                        corner_positions[connection[0]],
-                        corner_positions[connection[1]],
-                        corner_values[connection[0]],
-                        corner_values[connection[1]],
-                        config.iso_value);
+                    const auto& [axis, ex, ey, ez] = cube_edges[edge];
+                    const std::array<std::size_t, 3> lo{x + static_cast<std::size_t>(ex),
+                        y + static_cast<std::size_t>(ey), z + static_cast<std::size_t>(ez)};
+                    auto& slot = cached_vertex(axis, lo[0] + nx * lo[1], lo[2]);
+                    if (slot == no_cached_vertex) {
+                        slot = emit_vertex(
+                            edge_vertex(density, lo, axis, config.iso_value, material, cell_size, gradient));
+                    }
+                    cell_vertices[edge] = slot;
                 }
 
-                const voxel_id material = material_sampler(x, y, z);
                 for (int tri = 0; triangle_table[cube_index][tri] != -1; tri += 3) {
-                    const int a0 = triangle_table[cube_index][tri];
-                    const int a1 = triangle_table[cube_index][tri + 1];
-                    const int a2 = triangle_table[cube_index][tri + 2];
-
-                    const auto& p0 = edge_vertices[a0];
-                    const auto& p1 = edge_vertices[a1];
-                    const auto& p2 = edge_vertices[a2];
-                    const auto normal = detail::compute_normal(p0, p2, p1);
-
-                    const auto base_index = static_cast<std::uint32_t>(result.vertices.size());
-                    result.vertices.push_back(vertex{p0, normal, {p0[0], p0[1]}, material});
-                    result.vertices.push_back(vertex{p2, normal, {p2[0], p2[1]}, material});
-                    result.vertices.push_back(vertex{p1, normal, {p1[0], p1[1]}, material});
-                    result.indices.insert(result.indices.end(), {base_index, base_index + 1, base_index + 2});
+                    const auto* corners = &triangle_table[cube_index][tri];
+                    emit_triangle(std::array<std::uint32_t, 3>{cell_vertices[static_cast<std::size_t>(corners[0])],
+                        cell_vertices[static_cast<std::size_t>(corners[2])],
+                        cell_vertices[static_cast<std::size_t>(corners[1])]});
                 }
             }
         }
     }
+}
 
+// Appends indexed marching cubes output to a mesh_result.
+struct indexed_mesh_sink {
+    mesh_result& mesh;
+
+    std::uint32_t operator()(const vertex& v) const {
+        mesh.vertices.push_back(v);
+        return static_cast<std::uint32_t>(mesh.vertices.size() - 1);
+    }
+
+    void operator()(const std::array<std::uint32_t, 3>& triangle) const {
+        mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+    }
+};
+
+inline void append_triangle(mesh_result& result, const std::array<vertex, 3>& triangle) {
+    const auto base_index = static_cast<std::uint32_t>(result.vertices.size());
+    result.vertices.insert(result.vertices.end(), triangle.begin(), triangle.end());
+    result.indices.insert(result.indices.end(), {base_index, base_index + 1, base_index + 2});
+}
+
+template <typename DensitySampler, typename MaterialSampler, typename IndexedSink, typename Gradient>
+void march_indexed(chunk_extent extent, DensitySampler& density_sampler, MaterialSampler& material_sampler,
+    const marching_cubes_config& config, IndexedSink& sink, mesher_scratch& scratch, const Gradient& gradient) {
+    march_slabs(extent, row_sampler(density_sampler), material_sampler, config, scratch,
+        [&sink](const vertex& v) -> std::uint32_t { return sink(v); },
+        [&sink](const std::array<std::uint32_t, 3>& triangle) { sink(triangle); }, 1.0f, gradient);
+}
+
+template <typename DensitySampler, typename MaterialSampler, typename TriangleSink, typename Gradient>
+void march_triangles(chunk_extent extent, DensitySampler& density_sampler, MaterialSampler& material_sampler,
+    const marching_cubes_config& config, TriangleSink& sink, mesher_scratch& scratch, const Gradient& gradient) {
+    auto& shared = scratch.smooth_vertices;
+    shared.clear();
+    march_slabs(extent, row_sampler(density_sampler), material_sampler, config, scratch,
+        [&shared](const vertex& v) {
+            shared.push_back(v);
+            return static_cast<std::uint32_t>(shared.size() - 1);
+        },
+        [&](const std::array<std::uint32_t, 3>& triangle) {
+            sink(std::array<vertex, 3>{shared[triangle[0]], shared[triangle[1]], shared[triangle[2]]});
+        },
+        1.0f, gradient);
+}
+
+} // namespace detail
+
+// Indexed output: each surface vertex is emitted once through `std::uint32_t sink(const vertex&)`, which returns the
+// index the sink stored it at, and triangles follow as `sink(const std::array<std::uint32_t, 3>&)` in
+// counter-clockwise order. Cells share the vertices on their common edges, so meshes carry roughly a fifth of the
+// vertices of the triangle form, and the density sampler is called once per lattice point. span_mesh_sink and
+// packed_smooth_sink accept this form.
+template <typename DensitySampler, typename MaterialSampler, typename IndexedSink>
+void marching_cubes_indexed(chunk_extent extent, DensitySampler&& density_sampler,
+    MaterialSampler&& material_sampler, const marching_cubes_config& config, IndexedSink&& sink,
+    mesher_scratch& scratch) {
+    detail::march_indexed(extent, density_sampler, material_sampler, config, sink, scratch,
+        detail::lattice_gradients{});
+}
+
+template <typename DensitySampler, typename MaterialSampler, typename IndexedSink>
+void marching_cubes_indexed(chunk_extent extent, DensitySampler&& density_sampler,
+    MaterialSampler&& material_sampler, const marching_cubes_config& config, IndexedSink&& sink) {
+    mesher_scratch scratch;
+    marching_cubes_indexed(extent, std::forward<DensitySampler>(density_sampler),
+        std::forward<MaterialSampler>(material_sampler), config, std::forward<IndexedSink>(sink), scratch);
+}
+
+// Emits each triangle as three float vertices in counter-clockwise order to `sink(const std::array<vertex, 3>&)`,
+// for consumers that want unshared vertices; positions and normals match the indexed form.
+template <typename DensitySampler, typename MaterialSampler, typename TriangleSink>
+void marching_cubes_triangles(chunk_extent extent, DensitySampler&& density_sampler,
+    MaterialSampler&& material_sampler, const marching_cubes_config& config, TriangleSink&& sink,
+    mesher_scratch& scratch) {
+    detail::march_triangles(extent, density_sampler, material_sampler, config, sink, scratch,
+        detail::lattice_gradients{});
+}
+
+template <typename DensitySampler, typename MaterialSampler, typename TriangleSink>
+void marching_cubes_triangles(chunk_extent extent, DensitySampler&& density_sampler,
+    MaterialSampler&& material_sampler, const marching_cubes_config& config, TriangleSink&& sink) {
+    mesher_scratch scratch;
+    marching_cubes_triangles(extent, std::forward<DensitySampler>(density_sampler),
+        std::forward<MaterialSampler>(material_sampler), config, std::forward<TriangleSink>(sink), scratch);
+}
+
+template <typename DensitySampler, typename MaterialSampler>
+    requires std::is_invocable_v<MaterialSampler&, std::size_t, std::size_t, std::size_t>
+[[nodiscard]] mesh_result marching_cubes(chunk_extent extent, DensitySampler&& density_sampler,
+    MaterialSampler&& material_sampler, const marching_cubes_config& config = {}) {
+    mesh_result result;
+    marching_cubes_indexed(extent, std::forward<DensitySampler>(density_sampler),
+        std::forward<MaterialSampler>(material_sampler), config, detail::indexed_mesh_sink{result});
     return result;
 }
 
@@ -182,42 +416,118 @@ template <typename DensitySampler>
     return marching_cubes(extent, std::forward<DensitySampler>(density_sampler), material_sampler, config);
 }
 
-template <typename IsSolid>
-[[nodiscard]] mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
-    const chunk_neighbors& neighbors, const marching_cubes_config& config = {}) {
-    const auto voxels = chunk.voxels();
-    const auto extent = chunk.extent();
-    const auto neighbor_views = detail::load_neighbor_views(neighbors);
-
-    auto sample_voxel = [&](std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t z) -> std::optional<voxel_id> {
-        if (x >= 0 && x < static_cast<std::ptrdiff_t>(extent.x) && y >= 0 && y < static_cast<std::ptrdiff_t>(extent.y)
-            && z >= 0 && z < static_cast<std::ptrdiff_t>(extent.z)) {
-            return voxels(static_cast<std::size_t>(x), static_cast<std::size_t>(y), static_cast<std::size_t>(z));
-        }
+namespace detail {
 
-        std::array<std::ptrdiff_t, 3> coord{x, y, z};
-        const detail::neighbor_view* view = nullptr;
-        if (!detail::remap_to_neighbor_coords(extent, coord, neighbor_views, view)) {
-            return std::nullopt;
+// Shared set-up of the chunk entry points: pads the chunk's density with its neighbours in `scratch.density`, wide
+// enough for padded_gradients at lattice spacing `step`, and calls `march(const padded_grid<float>& density,
+// material_sampler)`, unless the chunk and its neighbours are uniformly empty.
+template <typename IsSolid, typename March>
+void march_chunk(const chunk_storage& chunk, IsSolid& is_solid, const chunk_neighborhood& neighborhood,
+    mesher_scratch& scratch, March&& march, std::size_t step = 1) {
+    // A uniform empty chunk surrounded by missing or uniform empty neighbors samples a constant density field.
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_solid(*uniform)) {
+        const bool flat = std::all_of(neighborhood.chunks.begin(), neighborhood.chunks.end(),
+            [&](const chunk_storage* neighbor) {
+                if (neighbor == nullptr) {
+                    return true;
+                }
+                const auto id = neighbor->uniform_voxel();
+                return id && !is_solid(*id);
+            });
+        if (flat) {
+            return;
         }
-        return view->voxels(static_cast<std::size_t>(coord[0]), static_cast<std::size_t>(coord[1]),
-            static_cast<std::size_t>(coord[2]));
-    };
+    }
+    span3d<const voxel_id> voxels{};
+    if (!uniform) {
+        voxels = chunk.read_voxels(scratch.voxels);
+    }
 
-    auto density_sampler = [&](std::size_t vx, std::size_t vy, std::size_t vz) -> float {
-        const auto sample = sample_voxel(static_cast<std::ptrdiff_t>(vx), static_cast<std::ptrdiff_t>(vy),
-            static_cast<std::ptrdiff_t>(vz));
-        if (!sample) {
-            return 1.0f;
-        }
-        return is_solid(*sample) ? 0.0f : 1.0f;
-    };
+    auto& density = scratch.density;
+    build_voxel_apron(chunk, neighborhood, density, [&](voxel_id id) { return is_solid(id) ? 0.0f : 1.0f; }, 1.0f,
+        padded_density_apron(step));
 
     auto material_sampler = [&](std::size_t x, std::size_t y, std::size_t z) {
-        return voxels(x, y, z);
+        return uniform ? *uniform : voxels(x, y, z);
     };
+    march(static_cast<const padded_grid<float>&>(density), material_sampler);
+}
+
+// Rows of the padded density grid, copied straight into the slab cache.
+[[nodiscard]] inline auto padded_density_rows(const padded_grid<float>& density) {
+    return density_rows{[&density](std::size_t y, std::size_t z, std::span<float> row) {
+        const auto* source = &density(0, static_cast<std::ptrdiff_t>(y), static_cast<std::ptrdiff_t>(z));
+        std::copy(source, source + row.size(), row.begin());
+    }};
+}
+
+} // namespace detail
+
+// Samples density from a padded copy of the chunk, so cells on chunk edges and corners see the diagonal neighbours in
+// `neighborhood` and the inner loop never leaves the grid. Normals use central differences across the seams too, so
+// vertices shared with a neighbour chunk shade identically in both. Missing neighbours read as empty. The padded
+// density grid and slab caches live in `scratch`.
+template <typename IsSolid, typename IndexedSink>
+void marching_cubes_indexed_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config, IndexedSink&& sink,
+    mesher_scratch& scratch) {
+    detail::march_chunk(chunk, is_solid, neighborhood, scratch, [&](const auto& density, auto& material_sampler) {
+        auto rows = detail::padded_density_rows(density);
+        detail::march_indexed(chunk.extent(), rows, material_sampler, config, sink, scratch,
+            detail::padded_gradients{&density});
+    });
+}
+
+template <typename IsSolid, typename IndexedSink>
+void marching_cubes_indexed_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config, IndexedSink&& sink) {
+    mesher_scratch scratch;
+    marching_cubes_indexed_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, config,
+        std::forward<IndexedSink>(sink), scratch);
+}
 
-    return marching_cubes(extent, density_sampler, material_sampler, config);
+template <typename IsSolid, typename TriangleSink>
+void marching_cubes_triangles_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config, TriangleSink&& sink,
+    mesher_scratch& scratch) {
+    detail::march_chunk(chunk, is_solid, neighborhood, scratch, [&](const auto& density, auto& material_sampler) {
+        auto rows = detail::padded_density_rows(density);
+        detail::march_triangles(chunk.extent(), rows, material_sampler, config, sink, scratch,
+            detail::padded_gradients{&density});
+    });
+}
+
+template <typename IsSolid, typename TriangleSink>
+void marching_cubes_triangles_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config, TriangleSink&& sink) {
+    mesher_scratch scratch;
+    marching_cubes_triangles_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, config,
+        std::forward<TriangleSink>(sink), scratch);
+}
+
+// Face neighbours only: cells on chunk edges and corners treat the missing diagonal neighbours as empty.
+template <typename IsSolid, typename TriangleSink>
+void marching_cubes_triangles_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighbors& neighbors, const marching_cubes_config& config, TriangleSink&& sink) {
+    marching_cubes_triangles_from_chunk(chunk, std::forward<IsSolid>(is_solid),
+        chunk_neighborhood::from_faces(neighbors), config, std::forward<TriangleSink>(sink));
+}
+
+template <typename IsSolid>
+[[nodiscard]] mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config = {}) {
+    mesh_result result;
+    marching_cubes_indexed_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, config,
+        detail::indexed_mesh_sink{result});
+    return result;
+}
+
+template <typename IsSolid>
+[[nodiscard]] mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighbors& neighbors, const marching_cubes_config& config = {}) {
+    return marching_cubes_from_chunk(chunk, std::forward<IsSolid>(is_solid), chunk_neighborhood::from_faces(neighbors),
+        config);
 }
 
 inline mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, const marching_cubes_config& config = {}) {
@@ -0,0 +1,738 @@
+#pragma once
+
+#include "almond_voxel/chunk.hpp"
+#include "almond_voxel/core.hpp"
+#include "almond_voxel/meshing/apron.hpp"
+#include "almond_voxel/meshing/marching_cubes.hpp"
+#include "almond_voxel/meshing/mesh_types.hpp"
+#include "almond_voxel/world_fwd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+inline constexpr std::uint8_t max_marching_cubes_lod = 3;
+
+// Level of detail for marching cubes. Level L meshes cells 2^L voxels wide from point samples of the density, so each
+// level cuts the triangles of smooth terrain about fourfold. `neighbor_levels` holds the levels of the six face
+// neighbours, indexed by block_face: a face next to a coarser neighbour is resampled from the neighbour's samples and
+// stitched to its surface, so chunks meshed at different levels meet without cracks. Levels are clamped to the largest
+// cell size that divides the chunk extent.
+struct marching_cubes_lod {
+    std::uint8_t level{0};
+    std::array<std::uint8_t, block_face_count> neighbor_levels{};
+};
+
+// Chooses levels from the Chebyshev distance, in chunks, between a chunk and the viewer.
+struct marching_cubes_lod_policy {
+    // Distances at which levels 1, 2 and 3 begin, ascending; 0 leaves a level unused. All zero keeps every chunk at
+    // full resolution.
+    std::array<std::uint32_t, max_marching_cubes_lod> level_distances{};
+
+    [[nodiscard]] bool enabled() const noexcept {
+        return std::any_of(level_distances.begin(), level_distances.end(), [](std::uint32_t d) { return d != 0; });
+    }
+
+    [[nodiscard]] std::uint8_t level(const region_key& key, const region_key& viewer) const noexcept {
+        const auto distance = std::max({std::llabs(static_cast<long long>(key.x) - viewer.x),
+            std::llabs(static_cast<long long>(key.y) - viewer.y),
+            std::llabs(static_cast<long long>(key.z) - viewer.z)});
+        std::uint8_t result = 0;
+        for (std::size_t i = 0; i < level_distances.size(); ++i) {
+            if (level_distances[i] != 0 && distance >= static_cast<long long>(level_distances[i])) {
+                result = static_cast<std::uint8_t>(i + 1);
+            }
+        }
+        return result;
+    }
+
+    // Level of `key` together with the levels of its face neighbours, ready to mesh with.
+    [[nodiscard]] marching_cubes_lod select(const region_key& key, const region_key& viewer) const noexcept {
+        marching_cubes_lod result{level(key, viewer), {}};
+        for (std::size_t face = 0; face < block_face_count; ++face) {
+            const auto f = static_cast<block_face>(face);
+            auto neighbor = key;
+            const auto sign = axis_sign(f);
+            switch (axis_of(f)) {
+            case axis::x: neighbor.x += sign; break;
+            case axis::y: neighbor.y += sign; break;
+            case axis::z: neighbor.z += sign; break;
+            }
+            result.neighbor_levels[face] = level(neighbor, viewer);
+        }
+        return result;
+    }
+};
+
+namespace detail {
+
+// Largest level not above `level` whose cell size divides every axis of `extent`.
+[[nodiscard]] inline std::uint8_t clamp_lod_level(chunk_extent extent, std::uint8_t level) noexcept {
+    level = std::min(level, max_marching_cubes_lod);
+    for (; level > 0; --level) {
+        const std::uint32_t step = 1u << level;
+        if (extent.x % step == 0 && extent.y % step == 0 && extent.z % step == 0) {
+            break;
+        }
+    }
+    return level;
+}
+
+// Dense lattice of (cells + 1)^3 density samples for one level of detail.
+class lod_lattice {
+public:
+    lod_lattice(const std::array<std::size_t, 3>& cells, std::vector<float>& storage)
+        : cells_{cells}, storage_{storage} {
+        storage_.resize((cells[0] + 1) * (cells[1] + 1) * (cells[2] + 1));
+    }
+
+    [[nodiscard]] float at(std::size_t x, std::size_t y, std::size_t z) const noexcept {
+        return storage_[index(x, y, z)];
+    }
+    [[nodiscard]] float& at(std::size_t x, std::size_t y, std::size_t z) noexcept { return storage_[index(x, y, z)]; }
+    [[nodiscard]] float at(const std::array<std::size_t, 3>& p) const noexcept { return at(p[0], p[1], p[2]); }
+    [[nodiscard]] float& at(const std::array<std::size_t, 3>& p) noexcept { return at(p[0], p[1], p[2]); }
+
+    [[nodiscard]] const std::array<std::size_t, 3>& cells() const noexcept { return cells_; }
+    [[nodiscard]] const std::array<std::size_t, 3>& limits() const noexcept { return cells_; }
+
+    // Rows for march_slabs.
+    [[nodiscard]] auto rows() const {
+        return [this](std::size_t y, std::size_t z, std::span<float> row) {
+            const auto* source = storage_.data() + index(0, y, z);
+            std::copy(source, source + row.size(), row.begin());
+        };
+    }
+
+private:
+    [[nodiscard]] std::size_t index(std::size_t x, std::size_t y, std::size_t z) const noexcept {
+        return x + (cells_[0] + 1) * (y + (cells_[1] + 1) * z);
+    }
+
+    std::array<std::size_t, 3> cells_;
+    std::vector<float>& storage_;
+};
+
+// Replaces the samples on one lattice face that a neighbour `ratio` times coarser does not have with the bilinear
+// interpolation of those it does have. Both sides then agree on where the surface crosses every coarse edge.
+inline void restrict_lod_face(lod_lattice& lattice, block_face face, std::size_t ratio) {
+    const auto axis = static_cast<std::size_t>(axis_of(face));
+    const auto u = (axis + 1) % 3;
+    const auto v = (axis + 2) % 3;
+    const auto& cells = lattice.cells();
+    std::array<std::size_t, 3> point{};
+    point[axis] = axis_sign(face) > 0 ? cells[axis] : 0;
+    const auto sample = [&](std::size_t pu, std::size_t pv) {
+        auto p = point;
+        p[u] = pu;
+        p[v] = pv;
+        return lattice.at(p);
+    };
+
+    for (std::size_t pv = 0; pv <= cells[v]; ++pv) {
+        for (std::size_t pu = 0; pu <= cells[u]; ++pu) {
+            const auto fu = pu % ratio;
+            const auto fv = pv % ratio;
+            if (fu == 0 && fv == 0) {
+                continue;
+            }
+            const auto u0 = pu - fu;
+            const auto v0 = pv - fv;
+            const auto u1 = fu != 0 ? u0 + ratio : u0;
+            const auto v1 = fv != 0 ? v0 + ratio : v0;
+            const float tu = static_cast<float>(fu) / static_cast<float>(ratio);
+            const float tv = static_cast<float>(fv) / static_cast<float>(ratio);
+            const float bottom = sample(u0, v0) + tu * (sample(u1, v0) - sample(u0, v0));
+            const float top = sample(u0, v1) + tu * (sample(u1, v1) - sample(u0, v1));
+            auto p = point;
+            p[u] = pu;
+            p[v] = pv;
+            lattice.at(p) = bottom + tv * (top - bottom);
+        }
+    }
+}
+
+// A coarser neighbour's view of the lattice: point q reads `sample` at lattice point q * ratio.
+template <typename Sample>
+struct coarse_lattice_view {
+    const Sample& sample;
+    std::size_t ratio;
+
+    [[nodiscard]] float at(std::size_t x, std::size_t y, std::size_t z) const {
+        return sample(std::array<std::size_t, 3>{x * ratio, y * ratio, z * ratio});
+    }
+};
+
+// Where a fine chain or a neighbour chord meets the border of a coarse face cell. `t` runs counter-clockwise round the
+// border in lattice steps from corner 0. Loops enter chains at their tail and chords at their head.
+struct lod_stitch_end {
+    float t{0.0f};
+    std::size_t element{0};
+    int side{0};
+    bool entry{false};
+    int link{-1};
+    vertex point{};
+};
+
+// Fills the cracks along one face restricted by restrict_lod_face. In each coarse face cell our surface crosses the
+// face along chains of fine segments, and the neighbour's along straight chords between its own samples, read through
+// `neighbor_sample(lattice_point)`. The gaps between them lie in the face plane: each is bounded by chains, chords
+// and stretches of the cell border, and is filled with a fan that faces from the solid side to the empty one.
+//
+// Chains are oriented with our solid side on their left and chords with the neighbour's, so walking a chain forwards
+// and a chord backwards keeps the gap on one side. Where a chain and a chord meet the border at the same point the
+// loop steps straight across; elsewhere it follows the border to the next crossing. The latter happens on chunk edges
+// where a coarser face neighbour restricted samples that this neighbour still reads unrestricted, so chunks three or
+// more levels apart around an edge still close. Fine saddle squares pair their crossings as marching cubes did in the
+// cell behind them; a coarse saddle is assumed to cut off its solid corners.
+template <typename NeighborSample, typename MaterialSampler, typename EmitVertex, typename EmitTriangle,
+    typename Gradient>
+void stitch_lod_face(const lod_lattice& lattice, const NeighborSample& neighbor_sample, block_face face,
+    std::size_t ratio, const marching_cubes_config& config, float cell_size, MaterialSampler& material_sampler,
+    EmitVertex& emit_vertex, EmitTriangle& emit_triangle, const Gradient& gradient, mesher_scratch& scratch) {
+    const auto axis = static_cast<std::size_t>(axis_of(face));
+    const auto u = (axis + 1) % 3;
+    const auto v = (axis + 2) % 3;
+    const auto& cells = lattice.cells();
+    std::array<std::size_t, 3> plane{};
+    plane[axis] = axis_sign(face) > 0 ? cells[axis] : 0;
+    const auto lattice_point = [&](std::size_t pu, std::size_t pv) {
+        auto p = plane;
+        p[u] = pu;
+        p[v] = pv;
+        return p;
+    };
+    const auto solid = [&](std::size_t pu, std::size_t pv) {
+        return lattice.at(lattice_point(pu, pv)) < config.iso_value;
+    };
+    // Square corners (0, 0), (1, 0), (1, 1), (0, 1) in (u, v); side k runs from corner k to corner k + 1.
+    constexpr std::array<std::array<std::size_t, 2>, 4> square_corners{{{0, 0}, {1, 0}, {1, 1}, {0, 1}}};
+    const auto square_mask = [&](std::size_t pu, std::size_t pv, std::size_t size) {
+        return int{solid(pu, pv)} | int{solid(pu + size, pv)} << 1 | int{solid(pu + size, pv + size)} << 2
+            | int{solid(pu, pv + size)} << 3;
+    };
+    // Directs a crossing between sides a and b so the solid corners of `mask` lie on its left, as {tail, head}.
+    const auto orient = [](int a, int b, int mask) {
+        return (mask >> ((a + 1) % 4) & 1) != 0 ? std::array<int, 2>{b, a} : std::array<int, 2>{a, b};
+    };
+
+    // A face edge is keyed by its lower lattice point and whether it runs along v.
+    const auto edge_key = [&](std::size_t pu, std::size_t pv, bool along_v) {
+        return (pv * (cells[u] + 1) + pu) * 2 + (along_v ? 1u : 0u);
+    };
+    const auto key_vertex = [&](std::size_t key) {
+        const bool along_v = (key & 1u) != 0;
+        const auto point = key / 2;
+        const auto lo = lattice_point(point % (cells[u] + 1), point / (cells[u] + 1));
+        std::array<std::size_t, 3> cell{};
+        for (std::size_t i = 0; i < 3; ++i) {
+            cell[i] = std::min(lo[i], cells[i] - 1);
+        }
+        return edge_vertex(lattice, lo, static_cast<int>(along_v ? v : u), config.iso_value,
+            material_sampler(cell[0], cell[1], cell[2]), cell_size, gradient);
+    };
+    const coarse_lattice_view<NeighborSample> coarse{neighbor_sample, ratio};
+    const auto coarse_gradient = [&](const auto&, const std::array<std::size_t, 3>& q) {
+        return gradient(lattice, std::array<std::size_t, 3>{q[0] * ratio, q[1] * ratio, q[2] * ratio});
+    };
+
+    // The cube behind a face square, and the face edges its marching cubes triangles cross it along.
+    const auto saddle_pairs = [&](std::size_t fu, std::size_t fv, const std::array<std::size_t, 4>& sides,
+                                  std::array<std::array<int, 2>, 2>& pairs) {
+        auto cube = lattice_point(fu, fv);
+        cube[axis] = plane[axis] == 0 ? 0 : plane[axis] - 1;
+        int cube_index = 0;
+        for (std::size_t corner = 0; corner < cube_corners.size(); ++corner) {
+            if (lattice.at(cube[0] + static_cast<std::size_t>(cube_corners[corner][0]),
+                    cube[1] + static_cast<std::size_t>(cube_corners[corner][1]),
+                    cube[2] + static_cast<std::size_t>(cube_corners[corner][2]))
+                < config.iso_value) {
+                cube_index |= 1 << corner;
+            }
+        }
+        const auto face_side = [&](int edge) {
+            const auto& [edge_axis, ex, ey, ez] = cube_edges[static_cast<std::size_t>(edge)];
+            const std::array<std::size_t, 3> lo{cube[0] + static_cast<std::size_t>(ex),
+                cube[1] + static_cast<std::size_t>(ey), cube[2] + static_cast<std::size_t>(ez)};
+            if (static_cast<std::size_t>(edge_axis) == axis || lo[axis] != plane[axis]) {
+                return -1;
+            }
+            const auto key = edge_key(lo[u], lo[v], static_cast<std::size_t>(edge_axis) == v);
+            return static_cast<int>(std::find(sides.begin(), sides.end(), key) - sides.begin());
+        };
+        // Triangle edges on the face that no second triangle shares are where the surface leaves the cube.
+        std::array<std::array<int, 2>, 8> found{};
+        std::size_t count = 0;
+        const auto& triangles = mc_triangle_table[static_cast<std::size_t>(cube_index)];
+        for (std::size_t tri = 0; triangles[tri] != -1; tri += 3) {
+            for (std::size_t e = 0; e < 3; ++e) {
+                const int a = face_side(triangles[tri + e]);
+                const int b = face_side(triangles[tri + (e + 1) % 3]);
+                if (a < 0 || b < 0 || a > 3 || b > 3 || a == b) {
+                    continue;
+                }
+                const std::array<int, 2> pair{std::min(a, b), std::max(a, b)};
+                const auto match = std::find(found.begin(), found.begin() + static_cast<std::ptrdiff_t>(count), pair);
+                if (match != found.begin() + static_cast<std::ptrdiff_t>(count)) {
+                    *match = found[--count];
+                } else if (count < found.size()) {
+                    found[count++] = pair;
+                }
+            }
+        }
+        if (count != 2) {
+            return false;
+        }
+        pairs = {found[0], found[1]};
+        return true;
+    };
+
+    // Side of the coarse cell at (cu, cv) a face edge lies on, or -1 inside it.
+    const auto border_side = [&](std::size_t key, std::size_t cu, std::size_t cv) {
+        const auto point = key / 2;
+        const auto pu = point % (cells[u] + 1);
+        const auto pv = point / (cells[u] + 1);
+        if ((key & 1u) == 0) {
+            return pv == cv ? 0 : pv == cv + ratio ? 2 : -1;
+        }
+        return pu == cu + ratio ? 1 : pu == cu ? 3 : -1;
+    };
+    const float perimeter = 4.0f * static_cast<float>(ratio);
+    const auto distance = [&](float from, float to, bool ccw) {
+        float d = ccw ? to - from : from - to;
+        return d < 0.0f ? d + perimeter : d;
+    };
+
+    auto& segments = scratch.lod_segments;
+    auto& polyline = scratch.lod_polyline;
+    auto& polygon = scratch.lod_polygon;
+    auto& indices = scratch.lod_polygon_indices;
+    constexpr std::size_t used = static_cast<std::size_t>(-1);
+    const auto emit_polygon = [&] {
+        if (polygon.size() < 3) {
+            return;
+        }
+        indices.clear();
+        for (const auto& corner : polygon) {
+            indices.push_back(emit_vertex(corner));
+        }
+        // Loops keep the gap on our solid side counter-clockwise in (u, v), and (u, v, axis) is right-handed, so
+        // loop order faces along the axis: away from us when our side is solid and towards us when it is empty.
+        for (std::size_t i = 1; i + 1 < indices.size(); ++i) {
+            if (axis_sign(face) > 0) {
+                emit_triangle(std::array<std::uint32_t, 3>{indices[0], indices[i], indices[i + 1]});
+            } else {
+                emit_triangle(std::array<std::uint32_t, 3>{indices[0], indices[i + 1], indices[i]});
+            }
+        }
+    };
+
+    for (std::size_t cv = 0; cv < cells[v]; cv += ratio) {
+        for (std::size_t cu = 0; cu < cells[u]; cu += ratio) {
+            std::array<std::size_t, 3> cell = lattice_point(cu, cv);
+            cell[axis] = std::min(cell[axis], cells[axis] - 1);
+            const voxel_id material = material_sampler(cell[0], cell[1], cell[2]);
+
+            // Our fine crossings, directed with our solid side on the left.
+            segments.clear();
+            for (std::size_t fv = cv; fv < cv + ratio; ++fv) {
+                for (std::size_t fu = cu; fu < cu + ratio; ++fu) {
+                    const int mask = square_mask(fu, fv, 1);
+                    if (mask == 0 || mask == 15) {
+                        continue;
+                    }
+                    const std::array<std::size_t, 4> sides{edge_key(fu, fv, false), edge_key(fu + 1, fv, true),
+                        edge_key(fu, fv + 1, false), edge_key(fu, fv, true)};
+                    std::array<std::array<int, 2>, 2> pairs{};
+                    std::size_t pair_count = 1;
+                    if (mask == 5 || mask == 10) {
+                        if (!saddle_pairs(fu, fv, sides, pairs)) {
+                            // Fall back to cutting off the solid corners.
+                            const int first = mask == 5 ? 0 : 1;
+                            pairs = {std::array<int, 2>{(first + 3) % 4, first},
+                                std::array<int, 2>{(first + 1) % 4, first + 2}};
+                        }
+                        pair_count = 2;
+                    } else {
+                        std::size_t found = 0;
+                        for (int side = 0; side < 4; ++side) {
+                            if ((mask >> side & 1) != (mask >> ((side + 1) % 4) & 1)) {
+                                pairs[0][found++] = side;
+                            }
+                        }
+                    }
+                    for (std::size_t p = 0; p < pair_count; ++p) {
+                        const auto directed = orient(pairs[p][0], pairs[p][1], mask);
+                        segments.push_back({sides[static_cast<std::size_t>(directed[0])],
+                            sides[static_cast<std::size_t>(directed[1])]});
+                    }
+                }
+            }
+
+            // The neighbour's corners and chords.
+            std::array<float, 4> neighbor_values{};
+            std::array<bool, 4> unrestricted{};
+            int neighbor_mask = 0;
+            for (std::size_t corner = 0; corner < 4; ++corner) {
+                const auto p = lattice_point(cu + square_corners[corner][0] * ratio,
+                    cv + square_corners[corner][1] * ratio);
+                neighbor_values[corner] = neighbor_sample(p);
+                unrestricted[corner] = neighbor_values[corner] == lattice.at(p);
+                neighbor_mask |= int{neighbor_values[corner] < config.iso_value} << corner;
+            }
+            if (segments.empty() && (neighbor_mask == 0 || neighbor_mask == 15)) {
+                continue;
+            }
+            std::array<std::array<int, 2>, 2> chords{};
+            std::size_t chord_count = 0;
+            if (neighbor_mask == 5 || neighbor_mask == 10) {
+                for (int corner = 0; corner < 4; ++corner) {
+                    if ((neighbor_mask >> corner & 1) != 0) {
+                        chords[chord_count++] = orient((corner + 3) % 4, corner, neighbor_mask);
+                    }
+                }
+            } else if (neighbor_mask != 0 && neighbor_mask != 15) {
+                std::array<int, 2> crossed{};
+                std::size_t found = 0;
+                for (int side = 0; side < 4; ++side) {
+                    if ((neighbor_mask >> side & 1) != (neighbor_mask >> ((side + 1) % 4) & 1)) {
+                        crossed[found++] = side;
+                    }
+                }
+                chords[chord_count++] = orient(crossed[0], crossed[1], neighbor_mask);
+            }
+
+            // Chain our segments from the border; what is left over are closed islands.
+            std::array<std::array<std::size_t, 2>, 4> chains{};
+            std::size_t chain_count = 0;
+            bool broken = false;
+            polyline.clear();
+            for (auto& start : segments) {
+                if (start[0] == used || border_side(start[0], cu, cv) < 0) {
+                    continue;
+                }
+                if (chain_count == chains.size()) {
+                    broken = true;
+                    break;
+                }
+                const auto begin = polyline.size();
+                polyline.push_back(start[0]);
+                auto* segment = &start;
+                while (true) {
+                    const auto head = (*segment)[1];
+                    polyline.push_back(head);
+                    (*segment)[0] = used;
+                    if (border_side(head, cu, cv) >= 0) {
+                        break;
+                    }
+                    const auto next = std::find_if(
+                        segments.begin(), segments.end(), [head](const auto& s) { return s[0] == head; });
+                    if (next == segments.end()) {
+                        broken = true;
+                        break;
+                    }
+                    segment = &*next;
+                }
+                chains[chain_count++] = {begin, polyline.size()};
+            }
+            if (broken) {
+                continue;
+            }
+
+            // Ends on the border: chains 0..3, chords 4 and 5.
+            std::array<lod_stitch_end, 12> ends{};
+            std::size_t end_count = 0;
+            std::array<int, 4> our_side_end{-1, -1, -1, -1};
+            for (std::size_t c = 0; c < chain_count; ++c) {
+                for (const bool entry : {true, false}) {
+                    const auto key = entry ? polyline[chains[c][0]] : polyline[chains[c][1] - 1];
+                    const int side = border_side(key, cu, cv);
+                    if (our_side_end[static_cast<std::size_t>(side)] >= 0) {
+                        broken = true;
+                    }
+                    our_side_end[static_cast<std::size_t>(side)] = static_cast<int>(end_count);
+                    ends[end_count++] = {0.0f, c, side, entry, -1, key_vertex(key)};
+                }
+            }
+            if (broken) {
+                continue;
+            }
+            for (std::size_t c = 0; c < chord_count; ++c) {
+                for (const bool entry : {true, false}) {
+                    const int side = chords[c][entry ? 1 : 0];
+                    const auto s = static_cast<std::size_t>(side);
+                    auto& end = ends[end_count];
+                    end = {0.0f, 4 + c, side, entry, -1, {}};
+                    const int ours = our_side_end[s];
+                    if (ours >= 0 && unrestricted[s] && unrestricted[(s + 1) % 4]) {
+                        // Same samples on this side, so the same crossing.
+                        end.link = ours;
+                        end.point = ends[static_cast<std::size_t>(ours)].point;
+                        ends[static_cast<std::size_t>(ours)].link = static_cast<int>(end_count);
+                    } else {
+                        // The neighbour interpolates along the whole side, from its lower end.
+                        auto lo = lattice_point(cu + (side == 1 ? ratio : 0), cv + (side == 2 ? ratio : 0));
+                        for (auto& coordinate : lo) {
+                            coordinate /= ratio;
+                        }
+                        end.point = edge_vertex(coarse, lo, static_cast<int>(side % 2 == 0 ? u : v), config.iso_value,
+                            material, cell_size * static_cast<float>(ratio), coarse_gradient);
+                    }
+                    ++end_count;
+                }
+            }
+            for (std::size_t e = 0; e < end_count; ++e) {
+                const auto& position = ends[e].point.position;
+                const float pu = position[u] / cell_size - static_cast<float>(cu);
+                const float pv = position[v] / cell_size - static_cast<float>(cv);
+                const float r = static_cast<float>(ratio);
+                const std::array<float, 4> along{pu, r + pv, 3.0f * r - pu, 4.0f * r - pv};
+                ends[e].t = along[static_cast<std::size_t>(ends[e].side)];
+            }
+
+            // Whether our side (`ours`) or the neighbour's is solid just counter-clockwise of `t`: the next end of
+            // that kind is a chain tail or chord tail exactly when it is.
+            const auto solid_after = [&](float t, bool ours) {
+                float nearest = perimeter + 1.0f;
+                bool result = ours ? (square_mask(cu, cv, ratio) & 1) != 0 : (neighbor_mask & 1) != 0;
+                for (std::size_t e = 0; e < end_count; ++e) {
+                    if ((ends[e].element < 4) != ours) {
+                        continue;
+                    }
+                    float d = distance(t, ends[e].t, true);
+                    d = d > 0.0f ? d : perimeter;
+                    if (d < nearest) {
+                        nearest = d;
+                        result = ours ? ends[e].entry : !ends[e].entry;
+                    }
+                }
+                return result;
+            };
+            const auto append_element = [&](std::size_t element, bool skip_first) {
+                if (element < 4) {
+                    for (auto i = chains[element][0] + (skip_first ? 1 : 0); i < chains[element][1]; ++i) {
+                        polygon.push_back(key_vertex(polyline[i]));
+                    }
+                    return;
+                }
+                for (std::size_t e = 0; e < end_count; ++e) {
+                    if (ends[e].element == element && ends[e].entry && !skip_first) {
+                        polygon.push_back(ends[e].point);
+                    }
+                }
+                for (std::size_t e = 0; e < end_count; ++e) {
+                    if (ends[e].element == element && !ends[e].entry) {
+                        polygon.push_back(ends[e].point);
+                    }
+                }
+            };
+            const auto exit_of = [&](std::size_t element) {
+                std::size_t e = 0;
+                while (ends[e].element != element || ends[e].entry) {
+                    ++e;
+                }
+                return e;
+            };
+
+            std::array<bool, 6> visited{};
+            for (std::size_t start = 0; start < 6; ++start) {
+                if ((start < 4 ? start >= chain_count : start - 4 >= chord_count) || visited[start]) {
+                    continue;
+                }
+                polygon.clear();
+                auto element = start;
+                bool skip_first = false;
+                bool closed = false;
+                for (std::size_t guard = 0; guard < visited.size() && !visited[element]; ++guard) {
+                    visited[element] = true;
+                    append_element(element, skip_first);
+                    const auto& exit = ends[exit_of(element)];
+                    std::size_t next = end_count;
+                    if (exit.link >= 0) {
+                        next = static_cast<std::size_t>(exit.link);
+                        skip_first = true;
+                    } else {
+                        // Follow the border the way the gap lies, turning the cell corners on the way.
+                        const bool ccw = exit.element < 4 ? !solid_after(exit.t, false) : solid_after(exit.t, true);
+                        float nearest = perimeter + 1.0f;
+                        for (std::size_t e = 0; e < end_count; ++e) {
+                            const float d = distance(exit.t, ends[e].t, ccw);
+                            if (&ends[e] != &exit && d < nearest) {
+                                nearest = d;
+                                next = e;
+                            }
+                        }
+                        if (next == end_count || !ends[next].entry) {
+                            break;
+                        }
+                        std::array<std::pair<float, std::size_t>, 4> turns{};
+                        std::size_t turn_count = 0;
+                        for (std::size_t corner = 0; corner < 4; ++corner) {
+                            const float d = distance(exit.t, static_cast<float>(corner * ratio), ccw);
+                            if (d > 0.0f && d < nearest) {
+                                turns[turn_count++] = {d, corner};
+                            }
+                        }
+                        std::sort(turns.begin(), turns.begin() + static_cast<std::ptrdiff_t>(turn_count));
+                        for (std::size_t i = 0; i < turn_count; ++i) {
+                            const auto p = lattice_point(cu + square_corners[turns[i].second][0] * ratio,
+                                cv + square_corners[turns[i].second][1] * ratio);
+                            const auto g = gradient(lattice, p);
+                            const float length = std::sqrt(g[0] * g[0] + g[1] * g[1] + g[2] * g[2]);
+                            std::array<float, 3> normal{};
+                            normal[axis] = static_cast<float>(axis_sign(face));
+                            if (length > 1e-6f) {
+                                normal = {g[0] / length, g[1] / length, g[2] / length};
+                            }
+                            const std::array<float, 3> position{static_cast<float>(p[0]) * cell_size,
+                                static_cast<float>(p[1]) * cell_size, static_cast<float>(p[2]) * cell_size};
+                            polygon.push_back(vertex{position, normal, {position[0], position[1]}, material});
+                        }
+                        skip_first = false;
+                    }
+                    element = ends[next].element;
+                    closed = element == start;
+                }
+                if (closed) {
+                    if (skip_first) {
+                        // Closed across a shared crossing, which already opens the polygon.
+                        polygon.pop_back();
+                    }
+                    emit_polygon();
+                }
+            }
+
+            // An island of one side inside the other gaps against the neighbour wherever the neighbour has no chord,
+            // since then it sees the island's surroundings throughout.
+            for (auto& start : segments) {
+                if (start[0] == used) {
+                    continue;
+                }
+                polygon.clear();
+                const auto first = start[0];
+                auto* segment = &start;
+                bool closed = false;
+                while ((*segment)[0] != used) {
+                    polygon.push_back(key_vertex((*segment)[0]));
+                    const auto head = (*segment)[1];
+                    (*segment)[0] = used;
+                    if (head == first) {
+                        closed = true;
+                        break;
+                    }
+                    const auto next = std::find_if(
+                        segments.begin(), segments.end(), [head](const auto& s) { return s[0] == head; });
+                    if (next == segments.end()) {
+                        break;
+                    }
+                    segment = &*next;
+                }
+                if (!closed || chord_count != 0) {
+                    continue;
+                }
+                float area = 0.0f;
+                for (std::size_t i = 0; i < polygon.size(); ++i) {
+                    const auto& a = polygon[i].position;
+                    const auto& b = polygon[(i + 1) % polygon.size()].position;
+                    area += a[u] * b[v] - a[v] * b[u];
+                }
+                // Counter-clockwise islands are solid on our side.
+                if ((area > 0.0f) != (neighbor_mask == 15)) {
+                    emit_polygon();
+                }
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+// Meshes `chunk` at `lod.level` with the neighbour-aware sampling of marching_cubes_indexed_from_chunk. Positions stay
+// in voxel units, so chunks at any level line up. Faces next to coarser neighbours are restricted and stitched as
+// described on marching_cubes_lod; finer neighbours stitch to this chunk themselves.
+template <typename IsSolid, typename IndexedSink>
+void marching_cubes_lod_indexed_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_lod& lod, const marching_cubes_config& config,
+    IndexedSink&& sink, mesher_scratch& scratch) {
+    const auto extent = chunk.extent();
+    const auto level = detail::clamp_lod_level(extent, lod.level);
+    const std::size_t step = std::size_t{1} << level;
+    detail::march_chunk(
+        chunk, is_solid, neighborhood, scratch,
+        [&](const padded_grid<float>& density, auto& material_sampler) {
+            detail::lod_lattice lattice{{extent.x / step, extent.y / step, extent.z / step}, scratch.lod_density};
+            const auto& cells = lattice.cells();
+            for (std::size_t z = 0; z <= cells[2]; ++z) {
+                for (std::size_t y = 0; y <= cells[1]; ++y) {
+                    for (std::size_t x = 0; x <= cells[0]; ++x) {
+                        lattice.at(x, y, z) = density(static_cast<std::ptrdiff_t>(x * step),
+                            static_cast<std::ptrdiff_t>(y * step), static_cast<std::ptrdiff_t>(z * step));
+                    }
+                }
+            }
+
+            // Coarser faces, coarsest first, so the coarsest neighbour decides the samples on shared chunk edges and
+            // finer faces interpolate from those; a finer face restricted first would keep samples beside the edge
+            // that the coarser face then moved out from under it.
+            std::array<std::pair<std::size_t, block_face>, block_face_count> coarser{};
+            std::size_t coarser_count = 0;
+            for (std::size_t face = 0; face < block_face_count; ++face) {
+                const auto neighbor_level = detail::clamp_lod_level(extent, lod.neighbor_levels[face]);
+                if (neighbor_level > level) {
+                    coarser[coarser_count++] = {std::size_t{1} << (neighbor_level - level),
+                        static_cast<block_face>(face)};
+                }
+            }
+            std::sort(coarser.begin(), coarser.begin() + static_cast<std::ptrdiff_t>(coarser_count),
+                [](const auto& a, const auto& b) { return a.first > b.first; });
+            for (std::size_t i = 0; i < coarser_count; ++i) {
+                detail::restrict_lod_face(lattice, coarser[i].second, coarser[i].first);
+            }
+
+            auto lod_material = [&](std::size_t x, std::size_t y, std::size_t z) {
+                return material_sampler(x * step, y * step, z * step);
+            };
+            auto emit_vertex = [&sink](const vertex& v) -> std::uint32_t { return sink(v); };
+            auto emit_triangle = [&sink](const std::array<std::uint32_t, 3>& triangle) { sink(triangle); };
+            const auto cell_size = static_cast<float>(step);
+            const detail::padded_gradients gradient{&density, static_cast<std::ptrdiff_t>(step)};
+            // Coarser neighbours sample the density itself, not our restricted lattice.
+            const auto neighbor_sample = [&](const std::array<std::size_t, 3>& p) {
+                return density(static_cast<std::ptrdiff_t>(p[0] * step), static_cast<std::ptrdiff_t>(p[1] * step),
+                    static_cast<std::ptrdiff_t>(p[2] * step));
+            };
+            detail::march_slabs(chunk_extent{static_cast<std::uint32_t>(cells[0]),
+                                    static_cast<std::uint32_t>(cells[1]), static_cast<std::uint32_t>(cells[2])},
+                lattice.rows(), lod_material, config, scratch, emit_vertex, emit_triangle, cell_size, gradient);
+            for (std::size_t i = 0; i < coarser_count; ++i) {
+                detail::stitch_lod_face(lattice, neighbor_sample, coarser[i].second, coarser[i].first, config,
+                    cell_size, lod_material, emit_vertex, emit_triangle, gradient, scratch);
+            }
+        },
+        step);
+}
+
+template <typename IsSolid>
+[[nodiscard]] mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_lod& lod, const marching_cubes_config& config = {}) {
+    mesh_result result;
+    mesher_scratch scratch;
+    marching_cubes_lod_indexed_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, lod, config,
+        detail::indexed_mesh_sink{result}, scratch);
+    return result;
+}
+
+inline mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    const marching_cubes_lod& lod, const marching_cubes_config& config = {}) {
+    return marching_cubes_from_chunk(chunk, [](voxel_id id) { return id != voxel_id{}; }, neighborhood, lod, config);
+}
+
+} // namespace almond::voxel::meshing
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "almond_voxel/chunk.hpp"
+#include "almond_voxel/core.hpp"
+#include "almond_voxel/meshing/apron.hpp"
+#include "almond_voxel/meshing/binary_greedy_mesher.hpp"
+#include "almond_voxel/meshing/greedy_mesher.hpp"
+#include "almond_voxel/meshing/marching_cubes.hpp"
+#include "almond_voxel/meshing/marching_cubes_lod.hpp"
+#include "almond_voxel/meshing/mesh_types.hpp"
+#include "almond_voxel/meshing/naive_mesher.hpp"
+#include "almond_voxel/meshing/neighbors.hpp"
+#include "almond_voxel/meshing/packed_mesh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+namespace almond::voxel::meshing {
+
+// Outcome of meshing into caller spans. `vertex_count` and `index_count` were written; the required counts cover
+// every primitive the mesher produced. When they differ the spans were too small: writing stopped at the first
+// primitive that did not fit, so grow the buffers to the required counts and mesh again.
+struct mesh_span_result {
+    std::size_t vertex_count{0};
+    std::size_t index_count{0};
+    std::size_t required_vertices{0};
+    std::size_t required_indices{0};
+
+    [[nodiscard]] bool complete() const noexcept {
+        return vertex_count == required_vertices && index_count == required_indices;
+    }
+};
+
+namespace detail {
+
+template <typename Vertex, std::size_t VertexCount, std::size_t IndexCount, typename MakeIndices>
+void write_span_primitive(std::span<Vertex> vertices, std::span<std::uint32_t> indices, mesh_span_result& result,
+    const std::array<Vertex, VertexCount>& corners, MakeIndices&& make_indices) {
+    const bool fits = result.complete() && result.vertex_count + VertexCount <= vertices.size()
+        && result.index_count + IndexCount <= indices.size();
+    if (fits) {
+        const std::array<std::uint32_t, IndexCount> primitive = make_indices(
+            static_cast<std::uint32_t>(result.vertex_count));
+        std::copy(corners.begin(), corners.end(), vertices.begin() + static_cast<std::ptrdiff_t>(result.vertex_count));
+        std::copy(primitive.begin(), primitive.end(), indices.begin() + static_cast<std::ptrdiff_t>(result.index_count));
+        result.vertex_count += VertexCount;
+        result.index_count += IndexCount;
+    }
+    result.required_vertices += VertexCount;
+    result.required_indices += IndexCount;
+}
+
+} // namespace detail
+
+// Quad and triangle sink that writes float vertices and indices into caller memory, such as a mapped GPU buffer.
+// Pass it by lvalue so the counts survive the call, then read result().
+class span_mesh_sink {
+public:
+    span_mesh_sink(std::span<vertex> vertices, std::span<std::uint32_t> indices) noexcept
+        : vertices_{vertices}, indices_{indices} {}
+
+    void operator()(const quad& q) {
+        detail::write_span_primitive<vertex, 4, 6>(vertices_, indices_, result_, quad_vertices(q),
+            [&](std::uint32_t base) { return quad_indices(base, q); });
+    }
+
+    void operator()(const std::array<vertex, 3>& triangle) {
+        detail::write_span_primitive<vertex, 3, 3>(vertices_, indices_, result_, triangle,
+            [](std::uint32_t base) { return std::array<std::uint32_t, 3>{base, base + 1, base + 2}; });
+    }
+
+    // Indexed marching cubes output. Indices count every vertex this sink has received, and writing stops at the first
+    // vertex or triangle that does not fit.
+    std::uint32_t operator()(const vertex& v) {
+        const auto index = static_cast<std::uint32_t>(result_.required_vertices);
+        if (result_.complete() && result_.vertex_count < vertices_.size()) {
+            vertices_[result_.vertex_count++] = v;
+        }
+        ++result_.required_vertices;
+        return index;
+    }
+
+    void operator()(const std::array<std::uint32_t, 3>& triangle) {
+        if (result_.complete() && result_.index_count + triangle.size() <= indices_.size()) {
+            std::copy(triangle.begin(), triangle.end(),
+                indices_.begin() + static_cast<std::ptrdiff_t>(result_.index_count));
+            result_.index_count += triangle.size();
+        }
+        result_.required_indices += triangle.size();
+    }
+
+    [[nodiscard]] const mesh_span_result& result() const noexcept { return result_; }
+
+private:
+    std::span<vertex> vertices_;
+    std::span<std::uint32_t> indices_;
+    mesh_span_result result_{};
+};
+
+// span_mesh_sink for packed_vertex output.
+class packed_span_sink {
+public:
+    packed_span_sink(std::span<packed_vertex> vertices, std::span<std::uint32_t> indices) noexcept
+        : vertices_{vertices}, indices_{indices} {}
+
+    void operator()(const quad& q) {
+        detail::write_span_primitive<packed_vertex, 4, 6>(vertices_, indices_, result_, pack_quad_vertices(q),
+            [&](std::uint32_t base) { return quad_indices(base, q); });
+    }
+
+    [[nodiscard]] const mesh_span_result& result() const noexcept { return result_; }
+
+private:
+    std::span<packed_vertex> vertices_;
+    std::span<std::uint32_t> indices_;
+    mesh_span_result result_{};
+};
+
+// Reusable mesher state for streaming loops: scratch masks plus one output mesh whose buffers keep their capacity
+// between calls. Once the buffers have grown to the busiest chunk, meshing allocates nothing. Each call replaces the
+// previous mesh, and the returned reference stays valid until the next call. A context is not thread-safe; give each
+// worker its own.
+class mesher_context {
+public:
+    mesher_context() = default;
+
+    // Pre-sizes the output mesh so even the first chunks mesh without growing it.
+    void reserve(std::size_t vertices, std::size_t indices);
+
+    template <typename IsOpaque>
+    const mesh_result& greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors, IsOpaque&& is_opaque);
+    const mesh_result& greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors = {});
+
+    template <typename IsOpaque>
+    const mesh_result& binary_greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+        IsOpaque&& is_opaque);
+    const mesh_result& binary_greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors = {});
+
+    template <typename IsOpaque>
+    const mesh_result& naive(const chunk_storage& chunk, const chunk_neighbors& neighbors, IsOpaque&& is_opaque);
+    const mesh_result& naive(const chunk_storage& chunk, const chunk_neighbors& neighbors = {});
+
+    // All 26 neighbours, with the vertex lighting requested in `lighting` baked into the mesh.
+    template <typename IsOpaque>
+    const mesh_result& greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        IsOpaque&& is_opaque, const mesh_lighting_config& lighting);
+    const mesh_result& greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        const mesh_lighting_config& lighting = {});
+    template <typename IsOpaque>
+    const mesh_result& binary_greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        IsOpaque&& is_opaque, const mesh_lighting_config& lighting);
+    const mesh_result& binary_greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        const mesh_lighting_config& lighting = {});
+    template <typename IsOpaque>
+    const mesh_result& naive(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        IsOpaque&& is_opaque, const mesh_lighting_config& lighting);
+    const mesh_result& naive(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        const mesh_lighting_config& lighting = {});
+
+    template <typename IsSolid>
+    const mesh_result& marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+        const chunk_neighbors& neighbors, const marching_cubes_config& config = {});
+    const mesh_result& marching_cubes(const chunk_storage& chunk, const chunk_neighbors& neighbors = {},
+        const marching_cubes_config& config = {});
+    // Edge and corner neighbours included, for seamless surfaces along chunk edges.
+    template <typename IsSolid>
+    const mesh_result& marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+        const chunk_neighborhood& neighborhood, const marching_cubes_config& config = {});
+    const mesh_result& marching_cubes(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        const marching_cubes_config& config = {});
+    // At a level of detail, stitched to coarser face neighbours.
+    template <typename IsSolid>
+    const mesh_result& marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+        const chunk_neighborhood& neighborhood, const marching_cubes_lod& lod,
+        const marching_cubes_config& config = {});
+    const mesh_result& marching_cubes(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        const marching_cubes_lod& lod, const marching_cubes_config& config = {});
+
+    // For the *_quads entry points when meshing straight into a custom sink such as span_mesh_sink.
+    [[nodiscard]] mesher_scratch& scratch() noexcept { return scratch_; }
+    [[nodiscard]] const mesh_result& mesh() const noexcept { return mesh_; }
+
+private:
+    void reset() noexcept;
+
+    mesher_scratch scratch_{};
+    mesh_result mesh_{};
+};
+
+inline void mesher_context::reserve(std::size_t vertices, std::size_t indices) {
+    mesh_.vertices.reserve(vertices);
+    mesh_.indices.reserve(indices);
+    scratch_.quads.reserve(vertices / 4);
+}
+
+inline void mesher_context::reset() noexcept {
+    mesh_.vertices.clear();
+    mesh_.indices.clear();
+    scratch_.quads.clear();
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque) {
+    return greedy(chunk, chunk_neighborhood::from_faces(neighbors), std::forward<IsOpaque>(is_opaque),
+        mesh_lighting_config{});
+}
+
+inline const mesh_result& mesher_context::greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors) {
+    return greedy(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::binary_greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque) {
+    return binary_greedy(chunk, chunk_neighborhood::from_faces(neighbors), std::forward<IsOpaque>(is_opaque),
+        mesh_lighting_config{});
+}
+
+inline const mesh_result& mesher_context::binary_greedy(const chunk_storage& chunk,
+    const chunk_neighbors& neighbors) {
+    return binary_greedy(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::naive(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque) {
+    return naive(chunk, chunk_neighborhood::from_faces(neighbors), std::forward<IsOpaque>(is_opaque),
+        mesh_lighting_config{});
+}
+
+inline const mesh_result& mesher_context::naive(const chunk_storage& chunk, const chunk_neighbors& neighbors) {
+    return naive(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting) {
+    reset();
+    greedy_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [this](const quad& q) { append_quad(mesh_, q); }, scratch_);
+    return mesh_;
+}
+
+inline const mesh_result& mesher_context::greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    const mesh_lighting_config& lighting) {
+    return greedy(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; }, lighting);
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::binary_greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting) {
+    reset();
+    auto& quads = scratch_.quads;
+    binary_greedy_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [&quads](const quad& q) { quads.push_back(q); }, scratch_);
+    detail::append_quads(mesh_, quads);
+    return mesh_;
+}
+
+inline const mesh_result& mesher_context::binary_greedy(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, const mesh_lighting_config& lighting) {
+    return binary_greedy(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; }, lighting);
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::naive(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting) {
+    reset();
+    naive_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [this](const quad& q) { detail::append_naive_face(mesh_, q); }, scratch_);
+    return mesh_;
+}
+
+inline const mesh_result& mesher_context::naive(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    const mesh_lighting_config& lighting) {
+    return naive(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; }, lighting);
+}
+
+template <typename IsSolid>
+const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighbors& neighbors, const marching_cubes_config& config) {
+    return marching_cubes(chunk, std::forward<IsSolid>(is_solid), chunk_neighborhood::from_faces(neighbors), config);
+}
+
+inline const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk,
+    const chunk_neighbors& neighbors, const marching_cubes_config& config) {
+    return marching_cubes(chunk, [](voxel_id id) { return id != voxel_id{}; }, neighbors, config);
+}
+
+template <typename IsSolid>
+const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config) {
+    reset();
+    marching_cubes_indexed_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, config,
+        detail::indexed_mesh_sink{mesh_}, scratch_);
+    return mesh_;
+}
+
+inline const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config) {
+    return marching_cubes(chunk, [](voxel_id id) { return id != voxel_id{}; }, neighborhood, config);
+}
+
+template <typename IsSolid>
+const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_lod& lod, const marching_cubes_config& config) {
+    reset();
+    marching_cubes_lod_indexed_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, lod, config,
+        detail::indexed_mesh_sink{mesh_}, scratch_);
+    return mesh_;
+}
+
+inline const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, const marching_cubes_lod& lod, const marching_cubes_config& config) {
+    return marching_cubes(chunk, [](voxel_id id) { return id != voxel_id{}; }, neighborhood, lod, config);
+}
+
+} // namespace almond::voxel::meshing
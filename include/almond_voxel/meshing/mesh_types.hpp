@@ -1,18 +1,40 @@
 #pragma once
 
 #include "almond_voxel/core.hpp"
+#include "almond_voxel/meshing/apron.hpp"
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
 namespace almond::voxel::meshing {
 
+// Lighting baked at one blocky vertex. `occlusion` follows the three-neighbour corner rule: 0 when the corner is open,
+// 3 when both side voxels are solid. `skylight` and `blocklight` are smooth light levels in sixteenths (0..240),
+// averaged over the open cells that touch the corner in front of the face. All zero unless lighting was requested.
+struct vertex_shade {
+    std::uint8_t occlusion{0};
+    std::uint8_t skylight{0};
+    std::uint8_t blocklight{0};
+
+    [[nodiscard]] constexpr bool operator==(const vertex_shade&) const noexcept = default;
+};
+
 struct vertex {
     std::array<float, 3> position{};
     std::array<float, 3> normal{};
     std::array<float, 2> uv{};
     voxel_id id{0};
+    vertex_shade shade{};
+};
+
+// Per-vertex lighting the blocky meshers bake while meshing. Both are off by default; see vertex_shade.
+struct mesh_lighting_config {
+    bool ambient_occlusion{false};
+    bool smooth_light{false};
+
+    [[nodiscard]] constexpr bool enabled() const noexcept { return ambient_occlusion || smooth_light; }
 };
 
 struct mesh_result {
@@ -20,4 +42,133 @@ struct mesh_result {
     std::vector<std::uint32_t> indices;
 };
 
+// Face rectangle emitted by the blocky meshers' *_quads functions. `origin` is the voxel cell at the rectangle's
+// minimum corner; `width` and `height` extend along the face's u = (axis + 1) % 3 and v = (axis + 2) % 3 axes. `shade`
+// holds the corners (0, 0), (w, 0), (w, h), (0, h) in (u, v); the greedy meshers only merge faces whose shades match.
+struct quad {
+    block_face face{block_face::pos_x};
+    std::array<std::uint32_t, 3> origin{};
+    std::uint32_t width{1};
+    std::uint32_t height{1};
+    voxel_id id{0};
+    std::array<vertex_shade, 4> shade{};
+};
+
+namespace detail {
+
+// Calls `emit(const vertex&)` for the corners of `q` in order, so callers can write them straight to their storage.
+template <typename Emit>
+void for_each_quad_corner(const quad& q, Emit&& emit) {
+    constexpr float vertical_face_bias = 0.001f;
+    const std::size_t axis = static_cast<std::size_t>(axis_of(q.face));
+    const int sign = axis_sign(q.face);
+    const std::size_t u_axis = (axis + 1) % 3;
+    const std::size_t v_axis = (axis + 2) % 3;
+
+    std::array<float, 3> base{};
+    base[axis] = static_cast<float>(q.origin[axis] + (sign > 0 ? 1u : 0u));
+    if (axis == 2) {
+        base[axis] += sign > 0 ? vertical_face_bias : -vertical_face_bias;
+    }
+    base[u_axis] = static_cast<float>(q.origin[u_axis]);
+    base[v_axis] = static_cast<float>(q.origin[v_axis]);
+    const auto width = static_cast<float>(q.width);
+    const auto height = static_cast<float>(q.height);
+
+    const auto normal_i = face_normal(q.face);
+    const std::array<float, 3> normal{static_cast<float>(normal_i[0]), static_cast<float>(normal_i[1]),
+        static_cast<float>(normal_i[2])};
+    const std::array<std::array<float, 2>, 4> offsets{
+        std::array<float, 2>{0.0f, 0.0f},
+        std::array<float, 2>{width, 0.0f},
+        std::array<float, 2>{width, height},
+        std::array<float, 2>{0.0f, height},
+    };
+
+    for (std::size_t i = 0; i < offsets.size(); ++i) {
+        auto position = base;
+        position[u_axis] += offsets[i][0];
+        position[v_axis] += offsets[i][1];
+        emit(vertex{position, normal, offsets[i], q.id, q.shade[i]});
+    }
+}
+
+} // namespace detail
+
+// Float corners of `q`, running (0, 0), (w, 0), (w, h), (0, h) in (u, v) with matching uvs. z faces are nudged outwards
+// by a small bias so stacked chunks do not z-fight.
+[[nodiscard]] inline std::array<vertex, 4> quad_vertices(const quad& q) {
+    std::array<vertex, 4> corners{};
+    std::size_t i = 0;
+    detail::for_each_quad_corner(q, [&](const vertex& corner) { corners[i++] = corner; });
+    return corners;
+}
+
+// Two triangles over four corners starting at `base_index`, wound to face along `face`.
+[[nodiscard]] constexpr std::array<std::uint32_t, 6> quad_indices(std::uint32_t base_index, block_face face) noexcept {
+    if (axis_sign(face) > 0) {
+        return {base_index, base_index + 1, base_index + 2, base_index, base_index + 2, base_index + 3};
+    }
+    return {base_index, base_index + 2, base_index + 1, base_index, base_index + 3, base_index + 2};
+}
+
+// As above, but split along the diagonal that keeps ambient occlusion from interpolating anisotropically: when corners
+// 0 and 2 are darker than corners 1 and 3, the quad is cut from corner 1 to corner 3 instead.
+[[nodiscard]] constexpr std::array<std::uint32_t, 6> quad_indices(std::uint32_t base_index, const quad& q) noexcept {
+    const auto& shade = q.shade;
+    if (shade[0].occlusion + shade[2].occlusion <= shade[1].occlusion + shade[3].occlusion) {
+        return quad_indices(base_index, q.face);
+    }
+    if (axis_sign(q.face) > 0) {
+        return {base_index + 1, base_index + 2, base_index + 3, base_index + 1, base_index + 3, base_index};
+    }
+    return {base_index + 1, base_index + 3, base_index + 2, base_index + 1, base_index, base_index + 3};
+}
+
+// Appends `q` as four float vertices and two triangles facing along its normal.
+inline void append_quad(mesh_result& mesh, const quad& q) {
+    const auto base_index = static_cast<std::uint32_t>(mesh.vertices.size());
+    detail::for_each_quad_corner(q, [&mesh](const vertex& corner) { mesh.vertices.push_back(corner); });
+    const auto indices = quad_indices(base_index, q);
+    mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+}
+
+namespace detail {
+
+struct greedy_mask_cell {
+    bool filled{false};
+    voxel_id id{0};
+    std::array<vertex_shade, 4> shade{};
+};
+
+} // namespace detail
+
+// Working memory for the blocky meshers. Passing the same scratch to successive *_quads calls reuses its buffers, so
+// once they have grown to the largest chunk seen, meshing allocates nothing.
+struct mesher_scratch {
+    // Palette chunks are decoded here for one call instead of keeping a dense copy beside their palette.
+    std::vector<voxel_id> voxels;
+    std::vector<detail::greedy_mask_cell> mask;
+    std::vector<std::uint64_t> rows;
+    std::vector<std::uint64_t> plane_rows;
+    std::vector<std::uint64_t> x_planes;
+    std::vector<quad> quads;
+    // Neighbour-aware entry points pad the chunk with its neighbours' boundary layers before meshing.
+    padded_grid<std::uint8_t> opacity;
+    padded_grid<float> density;
+    padded_grid<std::uint8_t> skylight;
+    padded_grid<std::uint8_t> blocklight;
+    // Marching cubes keeps a ring of density slices, the shared edge vertices of one slab, and the vertices that the
+    // triangle form expands; level-of-detail meshing resamples the chunk into `lod_density`, and stitching chains the
+    // face crossings of one coarse cell into `lod_polyline` before filling the gap polygon.
+    std::vector<float> density_slices;
+    std::vector<std::uint32_t> edge_vertices;
+    std::vector<vertex> smooth_vertices;
+    std::vector<float> lod_density;
+    std::vector<std::array<std::size_t, 2>> lod_segments;
+    std::vector<std::size_t> lod_polyline;
+    std::vector<vertex> lod_polygon;
+    std::vector<std::uint32_t> lod_polygon_indices;
+};
+
 } // namespace almond::voxel::meshing
@@ -3,7 +3,9 @@
 #include "almond_voxel/chunk.hpp"
 #include "almond_voxel/core.hpp"
 #include "almond_voxel/meshing/mesh_types.hpp"
+#include "almond_voxel/meshing/apron.hpp"
 #include "almond_voxel/meshing/neighbors.hpp"
+#include "almond_voxel/meshing/vertex_shading.hpp"
 
 #include <array>
 #include <cstddef>
@@ -50,19 +52,31 @@ constexpr std::array<block_face, block_face_count> naive_faces{{
     block_face::neg_z,
 }};
 
-} // namespace detail
-
-template <typename IsOpaque, typename NeighborOpaque>
-[[nodiscard]] mesh_result naive_mesh_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
-    NeighborOpaque&& neighbor_opaque) {
-    mesh_result result;
+// `shade(face, x, y, z)` returns the corner shades of one voxel face.
+template <typename IsOpaque, typename NeighborOpaque, typename Shade, typename QuadSink>
+void naive_quads(const chunk_storage& chunk, IsOpaque&& is_opaque, NeighborOpaque&& neighbor_opaque,
+    const Shade& shade, QuadSink&& sink, mesher_scratch& scratch) {
     const auto extent = chunk.extent();
-    const auto voxels = chunk.voxels();
+
+    // Uniform chunks never expose interior faces, so only their boundary shell is visited.
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_opaque(*uniform)) {
+        return;
+    }
+    span3d<const voxel_id> voxels{};
+    if (!uniform) {
+        voxels = chunk.read_voxels(scratch.voxels);
+    }
+    const auto sample = [&](std::size_t x, std::size_t y, std::size_t z) {
+        return uniform ? *uniform : voxels(x, y, z);
+    };
 
     for (std::uint32_t z = 0; z < extent.z; ++z) {
         for (std::uint32_t y = 0; y < extent.y; ++y) {
-            for (std::uint32_t x = 0; x < extent.x; ++x) {
-                const voxel_id id = voxels(x, y, z);
+            const bool interior_row = uniform && z > 0 && z + 1 < extent.z && y > 0 && y + 1 < extent.y;
+            const std::uint32_t x_step = interior_row && extent.x > 1 ? extent.x - 1 : 1;
+            for (std::uint32_t x = 0; x < extent.x; x += x_step) {
+                const voxel_id id = sample(x, y, z);
                 if (!is_opaque(id)) {
                     continue;
                 }
@@ -86,7 +100,7 @@ template <typename IsOpaque, typename NeighborOpaque>
                         && neighbor_coord[2] >= 0
                         && neighbor_coord[2] < static_cast<std::ptrdiff_t>(extent.z);
                     if (neighbor_inside) {
-                        neighbor_solid = is_opaque(voxels(static_cast<std::size_t>(neighbor_coord[0]),
+                        neighbor_solid = is_opaque(sample(static_cast<std::size_t>(neighbor_coord[0]),
                             static_cast<std::size_t>(neighbor_coord[1]), static_cast<std::size_t>(neighbor_coord[2])));
                     } else {
                         neighbor_solid = neighbor_opaque(neighbor_coord);
@@ -96,59 +110,137 @@ template <typename IsOpaque, typename NeighborOpaque>
                         continue;
                     }
 
-                    const auto& definition = detail::naive_face_definitions[static_cast<std::size_t>(face)];
-                    const std::array<float, 3> base{
-                        static_cast<float>(x),
-                        static_cast<float>(y),
-                        static_cast<float>(z),
-                    };
-
-                    const std::array<float, 3> normal{
-                        static_cast<float>(normal_i[0]),
-                        static_cast<float>(normal_i[1]),
-                        static_cast<float>(normal_i[2]),
-                    };
-
-                    const auto base_index = static_cast<std::uint32_t>(result.vertices.size());
-                    for (std::size_t i = 0; i < definition.corners.size(); ++i) {
-                        vertex v{};
-                        v.position = {
-                            base[0] + definition.corners[i][0],
-                            base[1] + definition.corners[i][1],
-                            base[2] + definition.corners[i][2],
-                        };
-                        v.normal = normal;
-                        v.uv = definition.uvs[i];
-                        v.id = id;
-                        result.vertices.push_back(v);
-                    }
-
-                    result.indices.insert(result.indices.end(),
-                        {base_index, base_index + 1, base_index + 2, base_index, base_index + 2, base_index + 3});
+                    sink(quad{face, {x, y, z}, 1, 1, id, shade(face, x, y, z)});
                 }
             }
         }
     }
+}
+
+} // namespace detail
+
+// Emits one unit quad per visible voxel face to `sink(const quad&)`.
+template <typename IsOpaque, typename NeighborOpaque, typename QuadSink>
+void naive_quads_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque, NeighborOpaque&& neighbor_opaque,
+    QuadSink&& sink) {
+    mesher_scratch scratch;
+    detail::naive_quads(chunk, std::forward<IsOpaque>(is_opaque), std::forward<NeighborOpaque>(neighbor_opaque),
+        detail::no_shading{}, std::forward<QuadSink>(sink), scratch);
+}
+
+namespace detail {
 
+// Index into quad::shade of definition corner `corner`, found from its position along the face's u and v axes.
+[[nodiscard]] constexpr std::size_t naive_shade_corner(block_face face, std::size_t corner) noexcept {
+    const auto axis = static_cast<std::size_t>(axis_of(face));
+    const auto& position = naive_face_definitions[static_cast<std::size_t>(face)].corners[corner];
+    const bool u = position[(axis + 1) % 3] > 0.5f;
+    const bool v = position[(axis + 2) % 3] > 0.5f;
+    return u ? (v ? 2 : 1) : (v ? 3 : 0);
+}
+
+inline void append_naive_face(mesh_result& result, const quad& face) {
+    const auto& definition = naive_face_definitions[static_cast<std::size_t>(face.face)];
+    const auto normal_i = face_normal(face.face);
+    const std::array<float, 3> normal{
+        static_cast<float>(normal_i[0]),
+        static_cast<float>(normal_i[1]),
+        static_cast<float>(normal_i[2]),
+    };
+
+    const auto base_index = static_cast<std::uint32_t>(result.vertices.size());
+    for (std::size_t i = 0; i < definition.corners.size(); ++i) {
+        vertex v{};
+        v.position = {
+            static_cast<float>(face.origin[0]) + definition.corners[i][0],
+            static_cast<float>(face.origin[1]) + definition.corners[i][1],
+            static_cast<float>(face.origin[2]) + definition.corners[i][2],
+        };
+        v.normal = normal;
+        v.uv = definition.uvs[i];
+        v.id = face.id;
+        v.shade = face.shade[naive_shade_corner(face.face, i)];
+        result.vertices.push_back(v);
+    }
+
+    // Cut along the brighter diagonal so occlusion interpolates evenly; the winding is unchanged.
+    const auto* corners = result.vertices.data() + base_index;
+    if (corners[0].shade.occlusion + corners[2].shade.occlusion
+        > corners[1].shade.occlusion + corners[3].shade.occlusion) {
+        result.indices.insert(result.indices.end(),
+            {base_index + 1, base_index + 2, base_index + 3, base_index + 1, base_index + 3, base_index});
+        return;
+    }
+    result.indices.insert(result.indices.end(),
+        {base_index, base_index + 1, base_index + 2, base_index, base_index + 2, base_index + 3});
+}
+
+} // namespace detail
+
+template <typename IsOpaque, typename NeighborOpaque>
+[[nodiscard]] mesh_result naive_mesh_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
+    NeighborOpaque&& neighbor_opaque) {
+    mesh_result result;
+    naive_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), std::forward<NeighborOpaque>(neighbor_opaque),
+        [&result](const quad& face) { detail::append_naive_face(result, face); });
     return result;
 }
 
+// Meshes against all 26 neighbours and bakes the lighting requested in `lighting` into each quad's shade. Padded grids
+// live in `scratch`.
+template <typename IsOpaque, typename QuadSink>
+void naive_quads_with_neighborhood(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting, QuadSink&& sink, mesher_scratch& scratch) {
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_opaque(*uniform)) {
+        return;
+    }
+    // Unlit meshing only samples the apron; ambient occlusion also reads the centre cells.
+    auto& opacity = scratch.opacity;
+    detail::build_opacity_apron(chunk, neighborhood, is_opaque, opacity, lighting.enabled());
+    auto neighbor_sampler = [&opacity](const std::array<std::ptrdiff_t, 3>& coord) {
+        return opacity(coord[0], coord[1], coord[2]) != 0;
+    };
+
+    if (!lighting.enabled()) {
+        detail::naive_quads(chunk, is_opaque, neighbor_sampler, detail::no_shading{}, std::forward<QuadSink>(sink),
+            scratch);
+        return;
+    }
+    const auto shader = detail::prepare_face_shader(chunk, neighborhood, lighting, scratch);
+    detail::naive_quads(chunk, is_opaque, neighbor_sampler, shader, std::forward<QuadSink>(sink), scratch);
+}
+
 template <typename IsOpaque>
-[[nodiscard]] mesh_result naive_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
-    IsOpaque&& is_opaque) {
-    const auto neighbor_views = detail::load_neighbor_views(neighbors);
-    auto neighbor_sampler = [&, dims = chunk.extent()](const std::array<std::ptrdiff_t, 3>& coord) {
-        std::array<std::ptrdiff_t, 3> local = coord;
-        const detail::neighbor_view* view = nullptr;
-        if (!detail::remap_to_neighbor_coords(dims, local, neighbor_views, view)) {
-            return false;
-        }
+[[nodiscard]] mesh_result naive_mesh_with_neighborhood(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, IsOpaque&& is_opaque, const mesh_lighting_config& lighting = {}) {
+    mesh_result result;
+    mesher_scratch scratch;
+    naive_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [&result](const quad& face) { detail::append_naive_face(result, face); }, scratch);
+    return result;
+}
 
-        return is_opaque(view->voxels(static_cast<std::size_t>(local[0]), static_cast<std::size_t>(local[1]),
-            static_cast<std::size_t>(local[2])));
-    };
+inline mesh_result naive_mesh_with_neighborhood(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    const mesh_lighting_config& lighting = {}) {
+    return naive_mesh_with_neighborhood(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; }, lighting);
+}
 
-    return naive_mesh_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), neighbor_sampler);
+template <typename IsOpaque, typename QuadSink>
+void naive_quads_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque, QuadSink&& sink) {
+    mesher_scratch scratch;
+    naive_quads_with_neighborhood(chunk, chunk_neighborhood::from_faces(neighbors), std::forward<IsOpaque>(is_opaque),
+        mesh_lighting_config{}, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result naive_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque) {
+    mesh_result result;
+    naive_quads_with_neighbor_chunks(chunk, neighbors, std::forward<IsOpaque>(is_opaque),
+        [&result](const quad& face) { detail::append_naive_face(result, face); });
+    return result;
 }
 
 inline mesh_result naive_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors) {
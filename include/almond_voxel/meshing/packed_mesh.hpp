@@ -0,0 +1,218 @@
+#pragma once
+
+#include "almond_voxel/core.hpp"
+#include "almond_voxel/meshing/mesh_types.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+// Blocky vertex in 8 bytes. position_face holds x, y and z in bits 0-6, 7-13 and 14-20 (0..64, in voxels from the
+// chunk origin), the block_face in bits 21-23 and the vertex_shade occlusion in bits 24-25; bits 26-31 are zero.
+// Smooth light is not packed. uv_id holds the quad-relative u and v in bits 0-6 and 7-13 and the voxel id in bits
+// 16-31. The normal follows from the face. Unlike append_quad, z faces carry no bias; renderers that stack chunks
+// vertically apply it in the shader.
+struct packed_vertex {
+    std::uint32_t position_face{0};
+    std::uint32_t uv_id{0};
+
+    [[nodiscard]] constexpr std::uint32_t x() const noexcept { return position_face & 0x7Fu; }
+    [[nodiscard]] constexpr std::uint32_t y() const noexcept { return (position_face >> 7u) & 0x7Fu; }
+    [[nodiscard]] constexpr std::uint32_t z() const noexcept { return (position_face >> 14u) & 0x7Fu; }
+    [[nodiscard]] constexpr block_face face() const noexcept {
+        return static_cast<block_face>((position_face >> 21u) & 0x7u);
+    }
+    [[nodiscard]] constexpr std::uint32_t occlusion() const noexcept { return (position_face >> 24u) & 0x3u; }
+    [[nodiscard]] constexpr std::uint32_t u() const noexcept { return uv_id & 0x7Fu; }
+    [[nodiscard]] constexpr std::uint32_t v() const noexcept { return (uv_id >> 7u) & 0x7Fu; }
+    [[nodiscard]] constexpr voxel_id id() const noexcept { return static_cast<voxel_id>(uv_id >> 16u); }
+};
+
+// One face rectangle per instance for vertex-pulling renderers, which expand the four corners in the shader, so no
+// index buffer is needed. origin_face holds the origin x, y and z in bits 0-5, 6-11 and 12-17, the block_face in
+// bits 18-20 and the occlusion of corners 0-3 in two bits each from bit 21. size_id holds width - 1 and height - 1 in
+// bits 0-5 and 6-11 and the voxel id in bits 16-31.
+struct packed_quad {
+    std::uint32_t origin_face{0};
+    std::uint32_t size_id{0};
+
+    [[nodiscard]] constexpr std::uint32_t x() const noexcept { return origin_face & 0x3Fu; }
+    [[nodiscard]] constexpr std::uint32_t y() const noexcept { return (origin_face >> 6u) & 0x3Fu; }
+    [[nodiscard]] constexpr std::uint32_t z() const noexcept { return (origin_face >> 12u) & 0x3Fu; }
+    [[nodiscard]] constexpr block_face face() const noexcept {
+        return static_cast<block_face>((origin_face >> 18u) & 0x7u);
+    }
+    [[nodiscard]] constexpr std::uint32_t occlusion(std::size_t corner) const noexcept {
+        return (origin_face >> (21u + 2u * static_cast<std::uint32_t>(corner))) & 0x3u;
+    }
+    [[nodiscard]] constexpr std::uint32_t width() const noexcept { return (size_id & 0x3Fu) + 1u; }
+    [[nodiscard]] constexpr std::uint32_t height() const noexcept { return ((size_id >> 6u) & 0x3Fu) + 1u; }
+    [[nodiscard]] constexpr voxel_id id() const noexcept { return static_cast<voxel_id>(size_id >> 16u); }
+};
+
+// Smooth-surface vertex in 12 bytes: position in 1/256 voxel fixed point (up to 255 voxels per axis), octahedral
+// normal in two snorm8 components, and the voxel id.
+struct packed_smooth_vertex {
+    std::array<std::uint16_t, 3> position{};
+    std::array<std::int8_t, 2> normal{};
+    voxel_id id{0};
+    std::uint16_t reserved{0};
+
+    [[nodiscard]] std::array<float, 3> unpack_position() const noexcept;
+    [[nodiscard]] std::array<float, 3> unpack_normal() const noexcept;
+};
+
+static_assert(sizeof(packed_vertex) == 8, "packed_vertex must stay 8 bytes");
+static_assert(sizeof(packed_quad) == 8, "packed_quad must stay 8 bytes");
+static_assert(sizeof(packed_smooth_vertex) == 12, "packed_smooth_vertex must stay 12 bytes");
+
+inline constexpr float smooth_position_scale = 256.0f;
+
+struct packed_mesh {
+    std::vector<packed_vertex> vertices;
+    std::vector<std::uint32_t> indices;
+};
+
+struct packed_smooth_mesh {
+    std::vector<packed_smooth_vertex> vertices;
+    std::vector<std::uint32_t> indices;
+};
+
+// Corners in the same order and winding as append_quad. Throws std::out_of_range for quads outside a 64³ chunk.
+[[nodiscard]] inline std::array<packed_vertex, 4> pack_quad_vertices(const quad& q) {
+    const std::size_t axis = static_cast<std::size_t>(axis_of(q.face));
+    const std::size_t u_axis = (axis + 1) % 3;
+    const std::size_t v_axis = (axis + 2) % 3;
+    auto base = q.origin;
+    base[axis] += axis_sign(q.face) > 0 ? 1u : 0u;
+    if (base[axis] > 64 || base[u_axis] + q.width > 64 || base[v_axis] + q.height > 64) {
+        throw std::out_of_range("quad exceeds the packed vertex range");
+    }
+
+    const std::array<std::array<std::uint32_t, 2>, 4> offsets{{{0, 0}, {q.width, 0}, {q.width, q.height}, {0, q.height}}};
+    std::array<packed_vertex, 4> corners{};
+    for (std::size_t i = 0; i < 4; ++i) {
+        auto position = base;
+        position[u_axis] += offsets[i][0];
+        position[v_axis] += offsets[i][1];
+        corners[i].position_face = position[0] | (position[1] << 7u) | (position[2] << 14u)
+            | (static_cast<std::uint32_t>(q.face) << 21u) | ((q.shade[i].occlusion & 0x3u) << 24u);
+        corners[i].uv_id = offsets[i][0] | (offsets[i][1] << 7u) | (std::uint32_t{q.id} << 16u);
+    }
+    return corners;
+}
+
+[[nodiscard]] inline packed_quad pack_quad(const quad& q) {
+    if (q.origin[0] > 63 || q.origin[1] > 63 || q.origin[2] > 63 || q.width == 0 || q.width > 64 || q.height == 0
+        || q.height > 64) {
+        throw std::out_of_range("quad exceeds the packed quad range");
+    }
+    packed_quad packed{};
+    packed.origin_face = q.origin[0] | (q.origin[1] << 6u) | (q.origin[2] << 12u)
+        | (static_cast<std::uint32_t>(q.face) << 18u);
+    for (std::size_t i = 0; i < q.shade.size(); ++i) {
+        packed.origin_face |= (q.shade[i].occlusion & 0x3u) << (21u + 2u * static_cast<std::uint32_t>(i));
+    }
+    packed.size_id = (q.width - 1) | ((q.height - 1) << 6u) | (std::uint32_t{q.id} << 16u);
+    return packed;
+}
+
+// Throws std::out_of_range for positions the fixed point cannot hold: negative, past 65535/256 voxels, or not finite.
+[[nodiscard]] inline packed_smooth_vertex pack_smooth_vertex(const vertex& source) {
+    packed_smooth_vertex packed{};
+    for (std::size_t i = 0; i < 3; ++i) {
+        const float scaled = source.position[i] * smooth_position_scale;
+        if (!(scaled >= -0.5f && scaled < 65535.5f)) {
+            throw std::out_of_range("vertex exceeds the packed smooth vertex range");
+        }
+        packed.position[i] = static_cast<std::uint16_t>(std::lround(scaled));
+    }
+
+    // Octahedral mapping: project onto |x| + |y| + |z| = 1 and fold the lower hemisphere over the diagonals.
+    const auto& n = source.normal;
+    const float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+    if (l1 > 0.0f) {
+        float px = n[0] / l1;
+        float py = n[1] / l1;
+        if (n[2] < 0.0f) {
+            const float fx = (1.0f - std::abs(py)) * (px >= 0.0f ? 1.0f : -1.0f);
+            const float fy = (1.0f - std::abs(px)) * (py >= 0.0f ? 1.0f : -1.0f);
+            px = fx;
+            py = fy;
+        }
+        packed.normal[0] = static_cast<std::int8_t>(std::lround(px * 127.0f));
+        packed.normal[1] = static_cast<std::int8_t>(std::lround(py * 127.0f));
+    }
+    packed.id = source.id;
+    return packed;
+}
+
+inline std::array<float, 3> packed_smooth_vertex::unpack_position() const noexcept {
+    return {static_cast<float>(position[0]) / smooth_position_scale,
+        static_cast<float>(position[1]) / smooth_position_scale,
+        static_cast<float>(position[2]) / smooth_position_scale};
+}
+
+inline std::array<float, 3> packed_smooth_vertex::unpack_normal() const noexcept {
+    float x = static_cast<float>(normal[0]) / 127.0f;
+    float y = static_cast<float>(normal[1]) / 127.0f;
+    const float z = 1.0f - std::abs(x) - std::abs(y);
+    if (z < 0.0f) {
+        const float fx = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float fy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    const float length = std::sqrt(x * x + y * y + z * z);
+    return {x / length, y / length, z / length};
+}
+
+// Quad sink for the *_quads mesher entry points that appends four packed vertices and six indices per quad.
+struct packed_mesh_sink {
+    packed_mesh& mesh;
+
+    void operator()(const quad& q) const {
+        const auto base_index = static_cast<std::uint32_t>(mesh.vertices.size());
+        const auto corners = pack_quad_vertices(q);
+        const auto indices = quad_indices(base_index, q);
+        mesh.vertices.insert(mesh.vertices.end(), corners.begin(), corners.end());
+        mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+    }
+};
+
+// Quad sink that appends one packed_quad instance per quad.
+struct packed_quad_sink {
+    std::vector<packed_quad>& quads;
+
+    void operator()(const quad& q) const { quads.push_back(pack_quad(q)); }
+};
+
+// Sink for marching cubes in both the indexed (marching_cubes_indexed*) and triangle (marching_cubes_triangles*) forms.
+struct packed_smooth_sink {
+    packed_smooth_mesh& mesh;
+
+    std::uint32_t operator()(const vertex& v) const {
+        mesh.vertices.push_back(pack_smooth_vertex(v));
+        return static_cast<std::uint32_t>(mesh.vertices.size() - 1);
+    }
+
+    void operator()(const std::array<std::uint32_t, 3>& triangle) const {
+        mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+    }
+
+    void operator()(const std::array<vertex, 3>& triangle) const {
+        // Pack every corner first, so a corner out of range leaves the mesh as it was.
+        const std::array<packed_smooth_vertex, 3> corners{
+            pack_smooth_vertex(triangle[0]), pack_smooth_vertex(triangle[1]), pack_smooth_vertex(triangle[2])};
+        const auto base_index = static_cast<std::uint32_t>(mesh.vertices.size());
+        mesh.vertices.insert(mesh.vertices.end(), corners.begin(), corners.end());
+        mesh.indices.insert(mesh.indices.end(), {base_index, base_index + 1, base_index + 2});
+    }
+};
+
+} // namespace almond::voxel::meshing
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "almond_voxel/chunk.hpp"
+#include "almond_voxel/core.hpp"
+#include "almond_voxel/meshing/apron.hpp"
+#include "almond_voxel/meshing/mesh_types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace almond::voxel::meshing {
+
+// Light levels assumed for missing neighbours when baking smooth light: open sky, no block light.
+inline constexpr std::uint8_t missing_neighbor_skylight = 15;
+inline constexpr std::uint8_t missing_neighbor_blocklight = 0;
+
+namespace detail {
+
+// Shader for meshers that bake no lighting; every corner keeps the default vertex_shade.
+struct no_shading {
+    [[nodiscard]] constexpr std::array<vertex_shade, 4> operator()(block_face, std::uint32_t, std::uint32_t,
+        std::uint32_t) const noexcept {
+        return {};
+    }
+};
+
+// Bakes the corner shades of a voxel face from padded opacity and light grids built for the same chunk. Every sample
+// lies in the cell layer in front of the face, so faces on the chunk boundary read the apron and seam with their
+// neighbours.
+class face_shader {
+public:
+    face_shader(const padded_grid<std::uint8_t>& opacity, const padded_grid<std::uint8_t>& skylight,
+        const padded_grid<std::uint8_t>& blocklight, const mesh_lighting_config& lighting) noexcept
+        : opacity_{opacity}, skylight_{skylight}, blocklight_{blocklight}, lighting_{lighting} {}
+
+    [[nodiscard]] std::array<vertex_shade, 4> operator()(block_face face, std::uint32_t x, std::uint32_t y,
+        std::uint32_t z) const noexcept {
+        const auto axis = static_cast<std::size_t>(axis_of(face));
+        std::array<std::ptrdiff_t, 3> front{x, y, z};
+        front[axis] += axis_sign(face);
+        std::array<int, 3> u{};
+        std::array<int, 3> v{};
+        u[(axis + 1) % 3] = 1;
+        v[(axis + 2) % 3] = 1;
+        const auto base = static_cast<std::ptrdiff_t>(opacity_.index(front[0], front[1], front[2]));
+        const auto step_u = opacity_.offset(u[0], u[1], u[2]);
+        const auto step_v = opacity_.offset(v[0], v[1], v[2]);
+
+        // Corners in quad order: (0, 0), (w, 0), (w, h), (0, h).
+        constexpr std::array<std::array<std::ptrdiff_t, 2>, 4> signs{{{-1, -1}, {1, -1}, {1, 1}, {-1, 1}}};
+        std::array<vertex_shade, 4> result{};
+        for (std::size_t i = 0; i < signs.size(); ++i) {
+            const auto side_u = static_cast<std::size_t>(base + signs[i][0] * step_u);
+            const auto side_v = static_cast<std::size_t>(base + signs[i][1] * step_v);
+            const auto corner = static_cast<std::size_t>(base + signs[i][0] * step_u + signs[i][1] * step_v);
+            const bool solid_u = opacity_[side_u] != 0;
+            const bool solid_v = opacity_[side_v] != 0;
+            // Light cannot leak through a corner whose two sides are solid.
+            const bool solid_corner = opacity_[corner] != 0 || (solid_u && solid_v);
+
+            if (lighting_.ambient_occlusion) {
+                result[i].occlusion = static_cast<std::uint8_t>(solid_u && solid_v
+                        ? 3
+                        : int{solid_u} + int{solid_v} + int{solid_corner});
+            }
+            if (lighting_.smooth_light) {
+                const std::array<std::size_t, 4> cells{static_cast<std::size_t>(base), side_u, side_v, corner};
+                const std::array<bool, 4> open{true, !solid_u, !solid_v, !solid_corner};
+                result[i].skylight = smooth(skylight_, cells, open);
+                result[i].blocklight = smooth(blocklight_, cells, open);
+            }
+        }
+        return result;
+    }
+
+private:
+    // Average level of the open cells in sixteenths of a level, rounded to nearest.
+    [[nodiscard]] static std::uint8_t smooth(const padded_grid<std::uint8_t>& light,
+        const std::array<std::size_t, 4>& cells, const std::array<bool, 4>& open) noexcept {
+        unsigned sum = 0;
+        unsigned count = 0;
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            if (open[i]) {
+                sum += light[cells[i]];
+                ++count;
+            }
+        }
+        const unsigned level = (sum * 16u + count / 2u) / count;
+        return static_cast<std::uint8_t>(level < 240u ? level : 240u);
+    }
+
+    const padded_grid<std::uint8_t>& opacity_;
+    const padded_grid<std::uint8_t>& skylight_;
+    const padded_grid<std::uint8_t>& blocklight_;
+    mesh_lighting_config lighting_;
+};
+
+// Builds the light grids `lighting` needs in `scratch` next to an opacity grid that is already built, and returns a
+// shader over them. Uniform light planes are filled without being materialised.
+[[nodiscard]] inline face_shader prepare_face_shader(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, const mesh_lighting_config& lighting, mesher_scratch& scratch) {
+    if (lighting.smooth_light) {
+        build_plane_apron(chunk, neighborhood, scratch.skylight,
+            [](const chunk_storage& source) { return source.skylight(); },
+            [](const chunk_storage& source) { return source.uniform_skylight(); }, missing_neighbor_skylight);
+        build_plane_apron(chunk, neighborhood, scratch.blocklight,
+            [](const chunk_storage& source) { return source.blocklight(); },
+            [](const chunk_storage& source) { return source.uniform_blocklight(); }, missing_neighbor_blocklight);
+    }
+    return face_shader{scratch.opacity, scratch.skylight, scratch.blocklight, lighting};
+}
+
+} // namespace detail
+
+} // namespace almond::voxel::meshing
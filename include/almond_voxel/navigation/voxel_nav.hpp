@@ -88,6 +88,11 @@ struct nav_grid {
 
 [[nodiscard]] nav_grid build_nav_grid(const chunk_storage& chunk, const nav_build_config& config = {});
 
+// Re-evaluates only the cells whose walkability can depend on voxels inside `dirty` (the box grown by the clearance
+// below and one cell above). `sample_cost` is assumed to depend on the voxel column at the evaluated cell.
+void update_nav_grid(nav_grid& grid, const chunk_storage& chunk, const voxel_bounds& dirty,
+    const nav_build_config& config = {});
+
 struct nav_edge {
     nav_node_index node{std::numeric_limits<nav_node_index>::max()};
     float cost{std::numeric_limits<float>::infinity()};
@@ -149,18 +154,18 @@ void stitch_neighbor_regions(const nav_neighbor_config& neighbor, chunk_extent e
 
 namespace almond::voxel::navigation {
 
-inline nav_grid build_nav_grid(const chunk_storage& chunk, const nav_build_config& config) {
-    nav_grid grid;
-    grid.extent = chunk.extent();
-    grid.cells.resize(grid.extent.volume());
+namespace detail {
 
+inline void evaluate_nav_cells(nav_grid& grid, const chunk_storage& chunk, const nav_build_config& config,
+    const voxel_bounds& region) {
     const auto voxels = chunk.voxels();
     const std::uint32_t clearance = std::max<std::uint32_t>(1, config.clearance);
 
-    for (std::uint32_t z = 0; z < grid.extent.z; ++z) {
-        for (std::uint32_t y = 0; y < grid.extent.y; ++y) {
-            for (std::uint32_t x = 0; x < grid.extent.x; ++x) {
-                const auto idx = grid.index(x, y, z);
+    for (std::uint32_t z = region.min[2]; z < region.max[2]; ++z) {
+        for (std::uint32_t y = region.min[1]; y < region.max[1]; ++y) {
+            for (std::uint32_t x = region.min[0]; x < region.max[0]; ++x) {
+                auto& cell = grid.cells[grid.index(x, y, z)];
+                cell = nav_cell{};
                 bool open = true;
                 for (std::uint32_t h = 0; h < clearance; ++h) {
                     const std::uint32_t sample_y = y + h;
@@ -179,15 +184,53 @@ inline nav_grid build_nav_grid(const chunk_storage& chunk, const nav_build_confi
                 if (!supported) {
                     continue;
                 }
-                grid.cells[idx].walkable = true;
-                grid.cells[idx].traversal_cost = config.sample_cost(chunk, x, y, z);
+                cell.walkable = true;
+                cell.traversal_cost = config.sample_cost(chunk, x, y, z);
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+inline nav_grid build_nav_grid(const chunk_storage& chunk, const nav_build_config& config) {
+    nav_grid grid;
+    grid.extent = chunk.extent();
+    grid.cells.resize(grid.extent.volume());
+
+    if (const auto uniform = chunk.uniform_voxel()) {
+        // Solid chunks have no open cells; open chunks are only supported on their floor layer.
+        if (config.is_solid(*uniform) || grid.extent.y == 0) {
+            return grid;
+        }
+        for (std::uint32_t z = 0; z < grid.extent.z; ++z) {
+            for (std::uint32_t x = 0; x < grid.extent.x; ++x) {
+                auto& cell = grid.cells[grid.index(x, 0, z)];
+                cell.walkable = true;
+                cell.traversal_cost = config.sample_cost(chunk, x, 0, z);
             }
         }
+        return grid;
     }
 
+    detail::evaluate_nav_cells(grid, chunk, config, voxel_bounds::full(grid.extent));
     return grid;
 }
 
+inline void update_nav_grid(nav_grid& grid, const chunk_storage& chunk, const voxel_bounds& dirty,
+    const nav_build_config& config) {
+    if (grid.extent != chunk.extent() || grid.cells.size() != grid.extent.volume() || chunk.uniform_voxel()) {
+        grid = build_nav_grid(chunk, config);
+        return;
+    }
+    const std::uint32_t clearance = std::max<std::uint32_t>(1, config.clearance);
+    const auto region = dirty.expanded({0, clearance - 1, 0}, {0, 1, 0}, grid.extent);
+    if (region.empty()) {
+        return;
+    }
+    detail::evaluate_nav_cells(grid, chunk, config, region);
+}
+
 inline void for_each_neighbor(const nav_grid& grid, nav_node_index node, const nav_neighbor_config& config,
     const std::function<void(nav_edge)>& visitor) {
     if (!grid.walkable(node)) {
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace almond::voxel::parallel {
+
+// Unbounded multi-producer, single-consumer queue. Producers push onto a lock-free stack with one CAS; the consumer
+// detaches the whole stack with one exchange and reverses it, so items come out in push order per producer and no
+// side ever blocks. Only one thread may call try_pop() at a time.
+template <typename T>
+class completion_queue {
+public:
+    completion_queue() = default;
+    completion_queue(const completion_queue&) = delete;
+    completion_queue& operator=(const completion_queue&) = delete;
+    ~completion_queue();
+
+    void push(T value);
+    [[nodiscard]] bool try_pop(T& out);
+    // May miss pushes that are racing with the call.
+    [[nodiscard]] bool empty() const noexcept;
+
+private:
+    struct node {
+        T value;
+        node* next{nullptr};
+    };
+
+    static void destroy(node* list) noexcept;
+
+    std::atomic<node*> incoming_{nullptr};
+    node* ready_{nullptr};
+};
+
+template <typename T>
+completion_queue<T>::~completion_queue() {
+    destroy(ready_);
+    destroy(incoming_.load(std::memory_order_acquire));
+}
+
+template <typename T>
+void completion_queue<T>::push(T value) {
+    auto* item = new node{std::move(value), incoming_.load(std::memory_order_relaxed)};
+    while (!incoming_.compare_exchange_weak(item->next, item, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+template <typename T>
+bool completion_queue<T>::try_pop(T& out) {
+    if (ready_ == nullptr) {
+        // The detached stack is newest first; reversing it restores arrival order.
+        auto* list = incoming_.exchange(nullptr, std::memory_order_acquire);
+        while (list != nullptr) {
+            auto* next = list->next;
+            list->next = ready_;
+            ready_ = list;
+            list = next;
+        }
+        if (ready_ == nullptr) {
+            return false;
+        }
+    }
+    auto* item = ready_;
+    ready_ = item->next;
+    out = std::move(item->value);
+    delete item;
+    return true;
+}
+
+template <typename T>
+bool completion_queue<T>::empty() const noexcept {
+    return ready_ == nullptr && incoming_.load(std::memory_order_acquire) == nullptr;
+}
+
+template <typename T>
+void completion_queue<T>::destroy(node* list) noexcept {
+    while (list != nullptr) {
+        auto* next = list->next;
+        delete list;
+        list = next;
+    }
+}
+
+} // namespace almond::voxel::parallel
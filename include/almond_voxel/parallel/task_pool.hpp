@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::parallel {
+
+class task_pool;
+
+namespace detail {
+
+inline thread_local const task_pool* current_pool = nullptr;
+inline thread_local std::size_t current_worker = 0;
+
+} // namespace detail
+
+// Fixed-size worker pool with one deque per worker. Workers pop their own newest job first and steal the oldest job
+// from other workers when idle. Jobs submitted from a worker land on that worker's deque; external submissions are
+// spread round-robin. Jobs must not throw.
+class task_pool {
+public:
+    using job = std::function<void()>;
+
+    explicit task_pool(std::size_t worker_count = default_worker_count());
+    task_pool(const task_pool&) = delete;
+    task_pool& operator=(const task_pool&) = delete;
+    ~task_pool();
+
+    [[nodiscard]] static std::size_t default_worker_count() noexcept {
+        return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    [[nodiscard]] std::size_t worker_count() const noexcept { return threads_.size(); }
+    [[nodiscard]] bool on_worker_thread() const noexcept { return detail::current_pool == this; }
+    // Index in [0, worker_count()) of the calling worker, for per-worker scratch. Only meaningful on_worker_thread().
+    [[nodiscard]] std::size_t worker_index() const noexcept { return detail::current_worker; }
+
+    void submit(job work);
+
+    // Blocks until every submitted job has finished. Must not be called from a worker thread.
+    void wait_idle();
+
+private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<job> jobs;
+    };
+
+    void run(std::size_t index);
+    [[nodiscard]] bool try_pop(std::size_t index, job& out);
+
+    std::vector<std::unique_ptr<worker_queue>> queues_{};
+    std::vector<std::thread> threads_{};
+    std::mutex state_mutex_{};
+    std::condition_variable wake_{};
+    std::condition_variable idle_{};
+    std::size_t queued_{0};
+    std::size_t running_{0};
+    std::size_t next_queue_{0};
+    bool stopping_{false};
+};
+
+inline task_pool::task_pool(std::size_t worker_count) {
+    worker_count = std::max<std::size_t>(1, worker_count);
+    queues_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        queues_.push_back(std::make_unique<worker_queue>());
+    }
+    threads_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        threads_.emplace_back([this, i] { run(i); });
+    }
+}
+
+inline task_pool::~task_pool() {
+    {
+        std::scoped_lock lock{state_mutex_};
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+inline void task_pool::submit(job work) {
+    std::size_t target = 0;
+    if (on_worker_thread()) {
+        target = detail::current_worker;
+    } else {
+        std::scoped_lock lock{state_mutex_};
+        target = next_queue_++ % queues_.size();
+    }
+    {
+        auto& queue = *queues_[target];
+        std::scoped_lock lock{queue.mutex};
+        queue.jobs.push_back(std::move(work));
+    }
+    {
+        std::scoped_lock lock{state_mutex_};
+        ++queued_;
+    }
+    wake_.notify_one();
+}
+
+inline void task_pool::wait_idle() {
+    std::unique_lock lock{state_mutex_};
+    idle_.wait(lock, [this] { return queued_ == 0 && running_ == 0; });
+}
+
+inline void task_pool::run(std::size_t index) {
+    detail::current_pool = this;
+    detail::current_worker = index;
+    for (;;) {
+        {
+            std::unique_lock lock{state_mutex_};
+            wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+            if (queued_ == 0) {
+                return;
+            }
+            // Reserve one queued job; it is already visible in some deque because submit pushes before counting.
+            --queued_;
+            ++running_;
+        }
+
+        job work;
+        while (!try_pop(index, work)) {
+            std::this_thread::yield();
+        }
+        work();
+        // Release captured state before reporting idle so waiters observe fully finished jobs.
+        work = nullptr;
+
+        {
+            std::scoped_lock lock{state_mutex_};
+            --running_;
+            if (queued_ == 0 && running_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+}
+
+inline bool task_pool::try_pop(std::size_t index, job& out) {
+    {
+        auto& own = *queues_[index];
+        std::scoped_lock lock{own.mutex};
+        if (!own.jobs.empty()) {
+            out = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+    for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+        auto& victim = *queues_[(index + offset) % queues_.size()];
+        std::scoped_lock lock{victim.mutex};
+        if (!victim.jobs.empty()) {
+            out = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace almond::voxel::parallel
@@ -6,26 +6,52 @@
 
 #include <memory>
 #include <algorithm>
+#include <cmath>
+#include <utility>
 
 namespace almond::voxel::raytracing {
 
-inline void bake_lighting(chunk_storage& chunk, const sparse_voxel_octree& svo) {
+namespace detail {
+
+inline cone_trace_desc bake_cone() noexcept {
+    cone_trace_desc desc{};
+    desc.aperture = 0.75f;
+    desc.steps = 6;
+    desc.max_distance = 12.0f;
+    return desc;
+}
+
+} // namespace detail
+
+// Cells whose baked light can change when voxels inside `dirty` change: the upward bake cone reaches
+// `max_distance` above each cell and `aperture` to the sides.
+inline voxel_bounds lighting_influence(const voxel_bounds& dirty, chunk_extent extent) {
+    const auto desc = detail::bake_cone();
+    const auto side = static_cast<std::uint32_t>(std::ceil(desc.aperture));
+    const auto reach = static_cast<std::uint32_t>(std::ceil(desc.max_distance)) + side;
+    return dirty.expanded({side, reach, side}, {side, side, side}, extent);
+}
+
+// Re-bakes the cells inside `region` only. Use lighting_influence() to turn an edit box into a bake region.
+inline void bake_lighting(chunk_storage& chunk, const sparse_voxel_octree& svo, const voxel_bounds& region) {
     (void)svo;
-    auto voxels = chunk.voxels();
+    const auto bounds = region.expanded({0, 0, 0}, {0, 0, 0}, chunk.extent());
+    if (bounds.empty()) {
+        return;
+    }
+    auto scope = chunk.edit();
+    const auto voxels = std::as_const(chunk).voxels();
     auto blocklight = chunk.blocklight();
     auto skylight = chunk.skylight();
     if (voxels.empty() || blocklight.empty() || skylight.empty()) {
         return;
     }
 
-    cone_trace_desc desc{};
-    desc.aperture = 0.75f;
-    desc.steps = 6;
-    desc.max_distance = 12.0f;
+    auto desc = detail::bake_cone();
 
-    for (std::uint32_t z = 0; z < voxels.extent().z; ++z) {
-        for (std::uint32_t y = 0; y < voxels.extent().y; ++y) {
-            for (std::uint32_t x = 0; x < voxels.extent().x; ++x) {
+    for (std::uint32_t z = bounds.min[2]; z < bounds.max[2]; ++z) {
+        for (std::uint32_t y = bounds.min[1]; y < bounds.max[1]; ++y) {
+            for (std::uint32_t x = bounds.min[0]; x < bounds.max[0]; ++x) {
                 voxel_id id = voxels(x, y, z);
                 if (id == voxel_id{}) {
                     blocklight(x, y, z) = 0;
@@ -44,15 +70,19 @@ inline void bake_lighting(chunk_storage& chunk, const sparse_voxel_octree& svo)
     }
 }
 
+inline void bake_lighting(chunk_storage& chunk, const sparse_voxel_octree& svo) {
+    bake_lighting(chunk, svo, voxel_bounds::full(chunk.extent()));
+}
+
 inline void enqueue_global_illumination(region_manager& manager, const std::shared_ptr<acceleration_cache>& cache) {
     if (!cache) {
         return;
     }
 
     cache->rebuild_dirty(manager);
-    manager.add_dirty_observer([cache](const region_key& key) {
-        cache->invalidate_region(key);
-    });
+    manager.add_dirty_region_observer([cache](const region_key& key, const dirty_event& event) {
+        cache->invalidate_region(key, event.bounds);
+    }, chunk_plane::voxels);
 
     auto snapshots = manager.snapshot_loaded(true);
     for (const auto& snapshot : snapshots) {
@@ -63,7 +93,6 @@ inline void enqueue_global_illumination(region_manager& manager, const std::shar
             cache->update_region(key, chunk);
             if (auto* entry = cache->find(key); entry != nullptr) {
                 bake_lighting(chunk, entry->svo);
-                chunk.mark_dirty();
             }
         });
     }
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -26,6 +27,15 @@ struct voxel_node_bounds {
         min_material = std::min(min_material, id);
         max_material = std::max(max_material, id);
     }
+
+    void merge(const voxel_node_bounds& other) {
+        if (!other.occupied) {
+            return;
+        }
+        occupied = true;
+        min_material = std::min(min_material, other.min_material);
+        max_material = std::max(max_material, other.max_material);
+    }
 };
 
 struct sparse_voxel_octree_node {
@@ -50,6 +60,8 @@ public:
     sparse_voxel_octree() = default;
 
     void build(const chunk_storage& chunk, std::uint32_t max_depth = 5);
+    // Rebuilds only the subtrees intersecting `dirty`, falling back to a full build when a subtree empties out.
+    void update(const chunk_storage& chunk, const voxel_bounds& dirty);
 
     [[nodiscard]] const sparse_voxel_octree_node& root() const { return nodes_.front(); }
     [[nodiscard]] const std::vector<sparse_voxel_octree_node>& nodes() const { return nodes_; }
@@ -60,10 +72,14 @@ private:
     void build_node(std::uint32_t node_index, const chunk_storage& chunk, std::uint32_t depth,
         std::array<std::uint32_t, 3> size, std::array<std::uint32_t, 3> offset, std::uint32_t max_depth);
 
+    [[nodiscard]] bool update_node(std::uint32_t node_index, const chunk_storage& chunk, std::uint32_t depth,
+        std::array<std::uint32_t, 3> size, std::array<std::uint32_t, 3> offset, const voxel_bounds& dirty);
+
     [[nodiscard]] static voxel_node_bounds accumulate_bounds(const chunk_storage& chunk,
         const std::array<std::uint32_t, 3>& size, const std::array<std::uint32_t, 3>& offset);
 
     std::vector<sparse_voxel_octree_node> nodes_{};
+    std::uint32_t max_depth_{5};
 };
 
 struct clipmap_level {
@@ -74,6 +90,7 @@ struct clipmap_level {
 class clipmap_grid {
 public:
     void build(const chunk_storage& chunk, std::uint32_t levels = 3);
+    void update(const chunk_storage& chunk, const voxel_bounds& dirty);
 
     [[nodiscard]] const std::vector<clipmap_level>& levels() const noexcept { return levels_; }
 
@@ -81,16 +98,22 @@ private:
     std::vector<clipmap_level> levels_{};
 };
 
+// Entry updates and invalidations are serialised internally so region tasks running on worker threads may share one
+// cache. Pointers returned by find/assure stay valid until the entry is updated again.
 class acceleration_cache {
 public:
     struct region_entry {
         sparse_voxel_octree svo{};
         clipmap_grid clipmap{};
         bool dirty{true};
+        bool built{false};
+        voxel_bounds pending{};
     };
 
+    // Brings the entry up to date. Entries invalidated only by bounded edits are patched in place.
     void update_region(const region_key& key, const chunk_storage& chunk);
     void invalidate_region(const region_key& key);
+    void invalidate_region(const region_key& key, const voxel_bounds& bounds);
 
     [[nodiscard]] const region_entry* find(const region_key& key) const;
     [[nodiscard]] region_entry* assure(const region_key& key);
@@ -98,16 +121,82 @@ public:
     void rebuild_dirty(const region_manager& manager);
 
 private:
+    void update_entry(region_entry& entry, const chunk_storage& chunk);
+
+    mutable std::mutex mutex_{};
     std::unordered_map<region_key, region_entry, region_key_hash> regions_{};
 };
 
 inline void sparse_voxel_octree::build(const chunk_storage& chunk, std::uint32_t max_depth) {
+    max_depth_ = max_depth;
     nodes_.clear();
     nodes_.push_back({});
     auto extent = chunk.extent();
+    if (const auto uniform = chunk.uniform_voxel()) {
+        // Homogeneous chunks collapse to a single leaf covering the whole extent.
+        auto& root = nodes_.front();
+        root.bounds.include(*uniform);
+        if (!root.bounds.occupied) {
+            root.bounds.min_material = 0;
+        }
+        root.size = extent.x;
+        root.children.fill(std::numeric_limits<std::uint32_t>::max());
+        return;
+    }
     build_node(0, chunk, 0, {extent.x, extent.y, extent.z}, {0, 0, 0}, max_depth);
 }
 
+inline void sparse_voxel_octree::update(const chunk_storage& chunk, const voxel_bounds& dirty) {
+    const auto extent = chunk.extent();
+    if (dirty.empty() && !nodes_.empty()) {
+        return;
+    }
+    if (nodes_.empty() || dirty.covers(extent) || chunk.uniform_voxel()
+        || !update_node(0, chunk, 0, {extent.x, extent.y, extent.z}, {0, 0, 0}, dirty)) {
+        build(chunk, max_depth_);
+    }
+}
+
+inline bool sparse_voxel_octree::update_node(std::uint32_t node_index, const chunk_storage& chunk, std::uint32_t depth,
+    std::array<std::uint32_t, 3> size, std::array<std::uint32_t, 3> offset, const voxel_bounds& dirty) {
+    const voxel_bounds box{offset, {offset[0] + size[0], offset[1] + size[1], offset[2] + size[2]}};
+    if (!box.intersects(dirty)) {
+        return true;
+    }
+    if (nodes_[node_index].leaf) {
+        build_node(node_index, chunk, depth, size, offset, max_depth_);
+        return true;
+    }
+
+    const std::array<std::uint32_t, 3> child_size{
+        std::max<std::uint32_t>(1, size[0] / 2), std::max<std::uint32_t>(1, size[1] / 2), std::max<std::uint32_t>(1, size[2] / 2)};
+    voxel_node_bounds merged{};
+    for (std::uint32_t child = 0; child < 8; ++child) {
+        std::array<std::uint32_t, 3> child_offset = offset;
+        if (child & 1) {
+            child_offset[0] += child_size[0];
+        }
+        if (child & 2) {
+            child_offset[1] += child_size[1];
+        }
+        if (child & 4) {
+            child_offset[2] += child_size[2];
+        }
+        const std::uint32_t child_index = nodes_[node_index].children[child];
+        if (!update_node(child_index, chunk, depth + 1, child_size, child_offset, dirty)) {
+            return false;
+        }
+        merged.merge(nodes_[child_index].bounds);
+    }
+    if (!merged.occupied) {
+        return false;
+    }
+    // Odd extents leave a remainder the children do not cover, so those nodes rescan their own box.
+    const bool exact = size[0] % 2 == 0 && size[1] % 2 == 0 && size[2] % 2 == 0;
+    nodes_[node_index].bounds = exact ? merged : accumulate_bounds(chunk, size, offset);
+    return true;
+}
+
 inline voxel_node_bounds sparse_voxel_octree::accumulate_bounds(const chunk_storage& chunk,
     const std::array<std::uint32_t, 3>& size, const std::array<std::uint32_t, 3>& offset) {
     voxel_node_bounds bounds;
@@ -146,14 +235,19 @@ inline void sparse_voxel_octree::build_node(std::uint32_t node_index, const chun
         return;
     }
 
+    // Children are allocated as one contiguous block before recursing; recursion grows nodes_, so the parent is
+    // re-fetched by index rather than held by reference.
+    const auto first_child = static_cast<std::uint32_t>(nodes_.size());
     node.leaf = false;
-    node.first_child = static_cast<std::uint32_t>(nodes_.size());
+    node.first_child = first_child;
+    for (std::uint32_t child = 0; child < 8; ++child) {
+        node.children[child] = first_child + child;
+    }
+    nodes_.resize(nodes_.size() + 8);
     const std::array<std::uint32_t, 3> child_size{
         std::max<std::uint32_t>(1, size[0] / 2), std::max<std::uint32_t>(1, size[1] / 2), std::max<std::uint32_t>(1, size[2] / 2)};
 
     for (std::uint32_t child = 0; child < 8; ++child) {
-        nodes_.push_back({});
-        node.children[child] = node.first_child + child;
         std::array<std::uint32_t, 3> child_offset = offset;
         if (child & 1) {
             child_offset[0] += child_size[0];
@@ -164,7 +258,7 @@ inline void sparse_voxel_octree::build_node(std::uint32_t node_index, const chun
         if (child & 4) {
             child_offset[2] += child_size[2];
         }
-        build_node(node.children[child], chunk, depth + 1, child_size, child_offset, max_depth);
+        build_node(first_child + child, chunk, depth + 1, child_size, child_offset, max_depth);
     }
 }
 
@@ -189,11 +283,22 @@ inline void clipmap_grid::build(const chunk_storage& chunk, std::uint32_t levels
     levels_.reserve(levels);
     auto extent = chunk.extent();
     std::array<std::uint32_t, 3> dims{extent.x, extent.y, extent.z};
+    const auto uniform = chunk.uniform_voxel();
 
     for (std::uint32_t level = 0; level < levels; ++level) {
         clipmap_level entry;
         entry.dimensions = dims;
         entry.cells.resize(static_cast<std::size_t>(dims[0]) * dims[1] * dims[2]);
+        if (uniform) {
+            voxel_node_bounds bounds{};
+            bounds.include(*uniform);
+            std::fill(entry.cells.begin(), entry.cells.end(), bounds);
+            levels_.push_back(std::move(entry));
+            dims[0] = std::max(1U, dims[0] / 2);
+            dims[1] = std::max(1U, dims[1] / 2);
+            dims[2] = std::max(1U, dims[2] / 2);
+            continue;
+        }
         const auto voxels = chunk.voxels();
         for (std::uint32_t z = 0; z < dims[2]; ++z) {
             for (std::uint32_t y = 0; y < dims[1]; ++y) {
@@ -212,22 +317,67 @@ inline void clipmap_grid::build(const chunk_storage& chunk, std::uint32_t levels
     }
 }
 
+inline void clipmap_grid::update(const chunk_storage& chunk, const voxel_bounds& dirty) {
+    if (levels_.empty() || chunk.uniform_voxel()) {
+        build(chunk, levels_.empty() ? 3 : static_cast<std::uint32_t>(levels_.size()));
+        return;
+    }
+    const auto voxels = chunk.voxels();
+    for (auto& level : levels_) {
+        const auto& dims = level.dimensions;
+        const chunk_extent level_extent{dims[0], dims[1], dims[2]};
+        const auto region = dirty.expanded({0, 0, 0}, {0, 0, 0}, level_extent);
+        for (std::uint32_t z = region.min[2]; z < region.max[2]; ++z) {
+            for (std::uint32_t y = region.min[1]; y < region.max[1]; ++y) {
+                for (std::uint32_t x = region.min[0]; x < region.max[0]; ++x) {
+                    auto& cell = level.cells[x + dims[0] * (y + dims[1] * z)];
+                    cell = voxel_node_bounds{};
+                    if (voxels.contains(x, y, z)) {
+                        cell.include(voxels(x, y, z));
+                    }
+                }
+            }
+        }
+    }
+}
+
 inline void acceleration_cache::update_region(const region_key& key, const chunk_storage& chunk) {
-    auto& entry = regions_[key];
-    entry.svo.build(chunk);
-    entry.clipmap.build(chunk);
+    std::scoped_lock lock{mutex_};
+    update_entry(regions_[key], chunk);
+}
+
+inline void acceleration_cache::update_entry(region_entry& entry, const chunk_storage& chunk) {
+    if (entry.built && entry.dirty && !entry.pending.empty() && !entry.pending.covers(chunk.extent())) {
+        entry.svo.update(chunk, entry.pending);
+        entry.clipmap.update(chunk, entry.pending);
+    } else {
+        entry.svo.build(chunk);
+        entry.clipmap.build(chunk);
+    }
+    entry.built = true;
+    entry.pending = voxel_bounds{};
     entry.dirty = false;
 }
 
 inline void acceleration_cache::invalidate_region(const region_key& key) {
-    if (auto it = regions_.find(key); it != regions_.end()) {
-        it->second.dirty = true;
-    } else {
-        regions_[key].dirty = true;
+    std::scoped_lock lock{mutex_};
+    auto& entry = regions_[key];
+    entry.dirty = true;
+    entry.pending = voxel_bounds{};
+}
+
+inline void acceleration_cache::invalidate_region(const region_key& key, const voxel_bounds& bounds) {
+    std::scoped_lock lock{mutex_};
+    auto& entry = regions_[key];
+    if (entry.dirty && entry.pending.empty()) {
+        return;
     }
+    entry.dirty = true;
+    entry.pending.merge(bounds);
 }
 
 inline const acceleration_cache::region_entry* acceleration_cache::find(const region_key& key) const {
+    std::scoped_lock lock{mutex_};
     if (auto it = regions_.find(key); it != regions_.end()) {
         return &it->second;
     }
@@ -235,18 +385,20 @@ inline const acceleration_cache::region_entry* acceleration_cache::find(const re
 }
 
 inline acceleration_cache::region_entry* acceleration_cache::assure(const region_key& key) {
+    std::scoped_lock lock{mutex_};
     return &regions_[key];
 }
 
 inline void acceleration_cache::rebuild_dirty(const region_manager& manager) {
     auto snapshots = manager.snapshot_loaded(true);
+    std::scoped_lock lock{mutex_};
     for (const auto& snapshot : snapshots) {
         if (!snapshot.chunk) {
             continue;
         }
         auto it = regions_.find(snapshot.key);
         if (it == regions_.end() || it->second.dirty) {
-            update_region(snapshot.key, *snapshot.chunk);
+            update_entry(regions_[snapshot.key], *snapshot.chunk);
         }
     }
 }
@@ -0,0 +1,328 @@
+#pragma once
+
+#include "almond_voxel/chunk.hpp"
+#include "almond_voxel/serialization/region_io.hpp"
+#include "almond_voxel/storage/codecs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::serialization {
+
+// Delta payloads patch a chunk from a baseline state to a newer one. Layout after the v2 header: u64 base revision,
+// u64 revision, then one record per changed plane: plane index byte, varint run count, and per run a varint count of
+// unchanged cells to skip, a varint run length and the new raw cell values. Planes without a record are unchanged.
+struct chunk_delta_info {
+    chunk_extent extent{};
+    std::uint32_t channel_flags{0};
+    std::uint64_t base_revision{0};
+    std::uint64_t revision{0};
+    chunk_plane planes{chunk_plane::none};
+};
+
+namespace detail {
+
+inline constexpr std::size_t chunk_delta_prefix = sizeof(chunk_header_v2) + 2 * sizeof(std::uint64_t);
+
+template <typename T>
+void append_plane_delta(std::vector<std::byte>& out, chunk_plane plane, std::span<const T> current,
+    std::span<const T> baseline) {
+    // Snapshots share untouched planes with their chunk, so identical buffers skip the comparison entirely.
+    if (current.data() == baseline.data()) {
+        return;
+    }
+    constexpr std::size_t block = 64 / sizeof(T) == 0 ? 1 : 64 / sizeof(T);
+    const auto equal = [&](std::size_t index, std::size_t count) {
+        return std::memcmp(current.data() + index, baseline.data() + index, count * sizeof(T)) == 0;
+    };
+
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    std::size_t index = 0;
+    const auto count = current.size();
+    while (index < count) {
+        while (index + block <= count && equal(index, block)) {
+            index += block;
+        }
+        while (index < count && equal(index, 1)) {
+            ++index;
+        }
+        if (index == count) {
+            break;
+        }
+        const auto start = index;
+        while (index < count && !equal(index, 1)) {
+            ++index;
+        }
+        runs.emplace_back(start, index - start);
+    }
+    if (runs.empty()) {
+        return;
+    }
+
+    out.push_back(static_cast<std::byte>(voxel::detail::plane_index(plane)));
+    voxel::detail::codecs::put_varint(out, runs.size());
+    std::size_t cursor = 0;
+    for (const auto& [start, length] : runs) {
+        voxel::detail::codecs::put_varint(out, start - cursor);
+        voxel::detail::codecs::put_varint(out, length);
+        append_bytes(out, current.data() + start, length * sizeof(T));
+        cursor = start + length;
+    }
+}
+
+// Diffs one plane of `current` against `baseline`. `read(chunk, scratch)` returns a chunk's cells. A side whose plane
+// is uniform (its value passed instead of nullptr) is compared by value or stood in for by `scratch`, so lazy planes
+// are never materialised just to be diffed.
+template <typename T, typename Read>
+void diff_chunk_plane(std::vector<std::byte>& out, chunk_plane plane, const chunk_storage& current,
+    const chunk_storage& baseline, const T* current_uniform, const T* baseline_uniform, Read&& read) {
+    if (current_uniform && baseline_uniform && std::memcmp(current_uniform, baseline_uniform, sizeof(T)) == 0) {
+        return;
+    }
+    std::vector<T> current_scratch;
+    std::vector<T> baseline_scratch;
+    const auto cells = [&](const chunk_storage& chunk, const T* uniform, std::vector<T>& scratch) {
+        if (uniform == nullptr) {
+            return read(chunk, scratch);
+        }
+        scratch.assign(chunk.volume(), *uniform);
+        return std::span<const T>{scratch};
+    };
+    append_plane_delta<T>(out, plane, cells(current, current_uniform, current_scratch),
+        cells(baseline, baseline_uniform, baseline_scratch));
+}
+
+// Walks the runs of one plane record, calling `write(cell, source, length)` per run. Returns the offset past the record.
+template <typename T, typename Write>
+std::size_t read_plane_delta(std::span<const std::byte> bytes, std::size_t offset, std::size_t count, Write&& write) {
+    const auto runs = voxel::detail::codecs::get_varint(bytes, offset);
+    std::size_t cursor = 0;
+    for (std::uint64_t run = 0; run < runs; ++run) {
+        const auto skip = voxel::detail::codecs::get_varint(bytes, offset);
+        const auto length = voxel::detail::codecs::get_varint(bytes, offset);
+        if (skip > count - cursor || length > count - cursor - skip
+            || length > (bytes.size() - offset) / sizeof(T)) {
+            throw std::runtime_error("malformed chunk delta");
+        }
+        cursor += static_cast<std::size_t>(skip);
+        write(cursor, bytes.data() + offset, static_cast<std::size_t>(length));
+        offset += static_cast<std::size_t>(length) * sizeof(T);
+        cursor += static_cast<std::size_t>(length);
+    }
+    return offset;
+}
+
+// Calls `visit(view)` with a callable returning the writable view of `plane`; throws for planes the chunk lacks.
+template <typename Visit>
+void visit_delta_plane(chunk_storage& chunk, chunk_plane plane, Visit&& visit) {
+    switch (plane) {
+    case chunk_plane::voxels:
+        visit([&] { return chunk.voxels(); });
+        return;
+    case chunk_plane::skylight:
+        visit([&] { return chunk.skylight(); });
+        return;
+    case chunk_plane::blocklight:
+        visit([&] { return chunk.blocklight(); });
+        return;
+    case chunk_plane::metadata:
+        visit([&] { return chunk.metadata(); });
+        return;
+    case chunk_plane::materials:
+        if (chunk.materials_enabled()) {
+            visit([&] { return chunk.materials(); });
+            return;
+        }
+        break;
+    case chunk_plane::skylight_cache:
+        if (chunk.high_precision_lighting_enabled()) {
+            visit([&] { return chunk.skylight_cache(); });
+            return;
+        }
+        break;
+    case chunk_plane::blocklight_cache:
+        if (chunk.high_precision_lighting_enabled()) {
+            visit([&] { return chunk.blocklight_cache(); });
+            return;
+        }
+        break;
+    case chunk_plane::effect_density:
+        if (chunk.effect_density_enabled()) {
+            visit([&] { return chunk.effect_density(); });
+            return;
+        }
+        break;
+    case chunk_plane::effect_velocity:
+        if (chunk.effect_velocity_enabled()) {
+            visit([&] { return chunk.effect_velocity(); });
+            return;
+        }
+        break;
+    case chunk_plane::effect_lifetime:
+        if (chunk.effect_lifetime_enabled()) {
+            visit([&] { return chunk.effect_lifetime(); });
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+    throw std::runtime_error("malformed chunk delta");
+}
+
+} // namespace detail
+
+inline bool is_chunk_delta(std::span<const std::byte> bytes) {
+    if (bytes.size() < sizeof(chunk_header_v2)) {
+        return false;
+    }
+    chunk_header_v2 header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    return std::string_view(header.magic, 4) == std::string_view{chunk_magic.data(), chunk_magic.size()}
+        && header.version == chunk_version_delta && (header.channel_flags & chunk_channel_delta) != 0;
+}
+
+// Encodes the cells of `chunk` that differ from `baseline`. Both chunks must share an extent and channel layout; pass
+// a snapshot taken at the last save as the baseline so shared planes are skipped without being compared.
+inline std::vector<std::byte> serialize_chunk_delta(const chunk_storage& chunk, const chunk_storage& baseline) {
+    const auto extent = chunk.extent();
+    const auto channels = detail::chunk_channels(chunk);
+    if (baseline.extent() != extent || detail::chunk_channels(baseline) != channels) {
+        throw std::runtime_error("chunk delta baseline has a different layout");
+    }
+
+    chunk_header_v2 header{};
+    header.version = chunk_version_delta;
+    header.extent[0] = extent.x;
+    header.extent[1] = extent.y;
+    header.extent[2] = extent.z;
+    header.channel_flags = channels | chunk_channel_delta;
+
+    std::vector<std::byte> buffer;
+    buffer.reserve(detail::chunk_delta_prefix);
+    append_bytes(buffer, &header, sizeof(header));
+    const std::uint64_t revisions[2]{baseline.revision(), chunk.revision()};
+    append_bytes(buffer, revisions, sizeof(revisions));
+
+    const auto current_uniform = chunk.uniform_planes();
+    const auto baseline_uniform = baseline.uniform_planes();
+    const auto diff = [&](chunk_plane plane, auto chunk_uniform_values::*value, auto read) {
+        const auto uniform = [&](const chunk_uniform_planes& planes) {
+            return contains(planes.planes, plane) ? &(planes.values.*value) : nullptr;
+        };
+        detail::diff_chunk_plane(buffer, plane, chunk, baseline, uniform(current_uniform), uniform(baseline_uniform),
+            read);
+    };
+    diff(chunk_plane::voxels, &chunk_uniform_values::voxel,
+        [](const chunk_storage& source, std::vector<voxel_id>& scratch) { return source.read_voxels(scratch).linear(); });
+    diff(chunk_plane::skylight, &chunk_uniform_values::skylight,
+        [](const chunk_storage& source, auto&) { return source.skylight().linear(); });
+    diff(chunk_plane::blocklight, &chunk_uniform_values::blocklight,
+        [](const chunk_storage& source, auto&) { return source.blocklight().linear(); });
+    diff(chunk_plane::metadata, &chunk_uniform_values::metadata,
+        [](const chunk_storage& source, auto&) { return source.metadata().linear(); });
+    if (chunk.materials_enabled()) {
+        diff(chunk_plane::materials, &chunk_uniform_values::material,
+            [](const chunk_storage& source, auto&) { return source.materials().linear(); });
+    }
+    if (chunk.high_precision_lighting_enabled()) {
+        diff(chunk_plane::skylight_cache, &chunk_uniform_values::skylight_cache,
+            [](const chunk_storage& source, auto&) { return source.skylight_cache().linear(); });
+        diff(chunk_plane::blocklight_cache, &chunk_uniform_values::blocklight_cache,
+            [](const chunk_storage& source, auto&) { return source.blocklight_cache().linear(); });
+    }
+    if (chunk.effect_density_enabled()) {
+        diff(chunk_plane::effect_density, &chunk_uniform_values::effect_density,
+            [](const chunk_storage& source, auto&) { return source.effect_density().linear(); });
+    }
+    if (chunk.effect_velocity_enabled()) {
+        diff(chunk_plane::effect_velocity, &chunk_uniform_values::effect_velocity,
+            [](const chunk_storage& source, auto&) { return source.effect_velocity().linear(); });
+    }
+    if (chunk.effect_lifetime_enabled()) {
+        diff(chunk_plane::effect_lifetime, &chunk_uniform_values::effect_lifetime,
+            [](const chunk_storage& source, auto&) { return source.effect_lifetime().linear(); });
+    }
+    return buffer;
+}
+
+// Reads the header and revisions of a delta without applying it. `planes` is left empty.
+inline chunk_delta_info read_chunk_delta_info(std::span<const std::byte> bytes) {
+    if (bytes.size() < detail::chunk_delta_prefix || !is_chunk_delta(bytes)) {
+        throw std::runtime_error("payload is not a chunk delta");
+    }
+    chunk_header_v2 header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    chunk_delta_info info{};
+    info.extent = chunk_extent{header.extent[0], header.extent[1], header.extent[2]};
+    info.channel_flags = header.channel_flags & ~chunk_channel_delta;
+    std::memcpy(&info.base_revision, bytes.data() + sizeof(header), sizeof(info.base_revision));
+    std::memcpy(&info.revision, bytes.data() + sizeof(header) + sizeof(info.base_revision), sizeof(info.revision));
+    return info;
+}
+
+// Patches `chunk` in place. The chunk should hold the delta's baseline state; callers that track revisions can compare
+// read_chunk_delta_info().base_revision before applying. The whole payload is validated before the first cell is
+// written, so a malformed or truncated delta throws and leaves the chunk untouched. Listeners fire once for the union
+// of patched planes.
+inline chunk_delta_info apply_chunk_delta(chunk_storage& chunk, std::span<const std::byte> bytes) {
+    auto info = read_chunk_delta_info(bytes);
+    if (info.extent != chunk.extent() || info.channel_flags != detail::chunk_channels(chunk)) {
+        throw std::runtime_error("chunk delta does not match the target chunk layout");
+    }
+
+    const auto count = chunk.volume();
+    const auto extent = chunk.extent();
+    // Walks every plane record; `patch(plane, view, offset)` reads one record and returns the offset past it.
+    const auto walk = [&](auto&& patch) {
+        std::size_t offset = detail::chunk_delta_prefix;
+        while (offset < bytes.size()) {
+            const auto index = std::to_integer<std::uint32_t>(bytes[offset++]);
+            if (index >= chunk_plane_count) {
+                throw std::runtime_error("malformed chunk delta");
+            }
+            const auto plane = static_cast<chunk_plane>(1u << index);
+            detail::visit_delta_plane(chunk, plane, [&](auto view) { offset = patch(plane, view, offset); });
+            info.planes |= plane;
+        }
+    };
+
+    walk([&](chunk_plane, auto view, std::size_t offset) {
+        using value_type = typename decltype(view())::element_type;
+        return detail::read_plane_delta<value_type>(bytes, offset, count,
+            [](std::size_t, const std::byte*, std::size_t) {});
+    });
+
+    auto scope = chunk.edit();
+    walk([&](chunk_plane plane, auto view, std::size_t offset) {
+        using value_type = typename decltype(view())::element_type;
+        if (plane == chunk_plane::voxels && chunk.palette() != nullptr) {
+            // Keep palette chunks packed; patches are usually a handful of cells.
+            return detail::read_plane_delta<voxel_id>(bytes, offset, count,
+                [&](std::size_t cell, const std::byte* source, std::size_t length) {
+                    for (std::size_t i = 0; i < length; ++i, ++cell) {
+                        voxel_id value{};
+                        std::memcpy(&value, source + i * sizeof(voxel_id), sizeof(voxel_id));
+                        const auto x = static_cast<std::uint32_t>(cell % extent.x);
+                        const auto y = static_cast<std::uint32_t>((cell / extent.x) % extent.y);
+                        const auto z = static_cast<std::uint32_t>(cell / (static_cast<std::size_t>(extent.x) * extent.y));
+                        chunk.set_voxel(x, y, z, value);
+                    }
+                });
+        }
+        auto* data = view().linear().data();
+        return detail::read_plane_delta<value_type>(bytes, offset, count,
+            [data](std::size_t cell, const std::byte* source, std::size_t length) {
+                std::memcpy(data + cell, source, length * sizeof(value_type));
+            });
+    });
+    return info;
+}
+
+} // namespace almond::voxel::serialization
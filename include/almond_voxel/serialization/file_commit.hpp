@@ -0,0 +1,87 @@
+#pragma once
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+// Trim <windows.h> and keep its min/max macros out, without leaking either setting into the including code.
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#define ALMOND_VOXEL_UNDEF_NOMINMAX
+#endif
+#include <windows.h>
+#ifdef ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#ifdef ALMOND_VOXEL_UNDEF_NOMINMAX
+#undef NOMINMAX
+#undef ALMOND_VOXEL_UNDEF_NOMINMAX
+#endif
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace almond::voxel::serialization {
+
+// Forces the written contents of `path` to stable storage. Streams must be flushed first; the file is reopened, so
+// this works for files written through std::ofstream.
+inline void sync_file(const std::filesystem::path& path) {
+#if defined(_WIN32)
+    const HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open file for sync");
+    }
+    const bool synced = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+#else
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("failed to open file for sync");
+    }
+    const bool synced = ::fsync(descriptor) == 0;
+    ::close(descriptor);
+#endif
+    if (!synced) {
+        throw std::runtime_error("failed to sync file");
+    }
+}
+
+// Makes a rename or create inside `directory` durable. NTFS journals metadata itself, so this is a no-op on Windows.
+inline void sync_directory(const std::filesystem::path& directory) {
+#if !defined(_WIN32)
+    const int descriptor = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("failed to open directory for sync");
+    }
+    const bool synced = ::fsync(descriptor) == 0;
+    ::close(descriptor);
+    if (!synced) {
+        throw std::runtime_error("failed to sync directory");
+    }
+#else
+    static_cast<void>(directory);
+#endif
+}
+
+// Atomically replaces `target` with the fully written `temporary`: the data is synced before the rename, so a crash
+// leaves either the old file or the complete new one, never a torn mix.
+inline void commit_file(const std::filesystem::path& temporary, const std::filesystem::path& target) {
+    sync_file(temporary);
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+    if (error) {
+        throw std::runtime_error("failed to replace " + target.string() + ": " + error.message());
+    }
+    sync_directory(target.parent_path());
+}
+
+} // namespace almond::voxel::serialization
@@ -0,0 +1,388 @@
+#pragma once
+
+#include "almond_voxel/chunk.hpp"
+#include "almond_voxel/serialization/region_file.hpp"
+#include "almond_voxel/serialization/region_io.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+// Trim <windows.h> and keep its min/max macros out, without leaking either setting into the including code.
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#define ALMOND_VOXEL_UNDEF_NOMINMAX
+#endif
+#include <windows.h>
+#ifdef ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#ifdef ALMOND_VOXEL_UNDEF_NOMINMAX
+#undef NOMINMAX
+#undef ALMOND_VOXEL_UNDEF_NOMINMAX
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace almond::voxel::serialization {
+
+// Read-only memory mapping of a whole file.
+class mapped_file {
+public:
+    explicit mapped_file(const std::filesystem::path& path);
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    ~mapped_file();
+
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return {data_, size_}; }
+
+private:
+    const std::byte* data_{nullptr};
+    std::size_t size_{0};
+#if defined(_WIN32)
+    HANDLE file_{INVALID_HANDLE_VALUE};
+    HANDLE mapping_{nullptr};
+#endif
+};
+
+// Read-only view of a serialized chunk payload. Dense planes alias the payload bytes, so nothing is copied until
+// promote(). The view keeps its backing storage (for example a mapped file) alive.
+class chunk_view {
+public:
+    chunk_view() = default;
+    explicit chunk_view(std::span<const std::byte> payload, std::shared_ptr<const void> owner = {});
+
+    [[nodiscard]] chunk_extent extent() const noexcept { return extent_; }
+    [[nodiscard]] std::size_t volume() const noexcept { return extent_.volume(); }
+    [[nodiscard]] std::uint32_t channel_flags() const noexcept { return header_.channel_flags; }
+    [[nodiscard]] std::span<const std::byte> payload() const noexcept { return payload_; }
+
+    [[nodiscard]] bool uniform() const noexcept { return (header_.channel_flags & chunk_channel_uniform) != 0; }
+    [[nodiscard]] std::optional<voxel_id> uniform_voxel() const noexcept;
+    [[nodiscard]] voxel_id voxel_at(std::uint32_t x, std::uint32_t y, std::uint32_t z) const;
+
+    // Aliasing plane views; only available for dense (non-uniform) payloads.
+    [[nodiscard]] span3d<const voxel_id> voxels() const;
+    [[nodiscard]] span3d<const std::uint8_t> skylight() const;
+    [[nodiscard]] span3d<const std::uint8_t> blocklight() const;
+    [[nodiscard]] span3d<const std::uint8_t> metadata() const;
+
+    // Decodes an owned, clean chunk.
+    [[nodiscard]] chunk_storage promote() const { return deserialize_chunk(payload_); }
+
+private:
+    [[nodiscard]] const std::byte* plane(std::size_t offset) const;
+
+    std::span<const std::byte> payload_{};
+    std::shared_ptr<const void> owner_{};
+    chunk_header_v2 header_{};
+    chunk_extent extent_{};
+};
+
+// Chunk that reads through a chunk_view until first mutated, then promotes itself to an owned chunk_storage.
+class cow_chunk {
+public:
+    explicit cow_chunk(chunk_view view) : view_{std::move(view)} {}
+
+    [[nodiscard]] bool promoted() const noexcept { return owned_.has_value(); }
+    [[nodiscard]] chunk_extent extent() const noexcept { return view_.extent(); }
+    [[nodiscard]] const chunk_view& view() const noexcept { return view_; }
+    [[nodiscard]] const chunk_storage* owned() const noexcept { return owned_ ? &*owned_ : nullptr; }
+
+    [[nodiscard]] std::optional<voxel_id> uniform_voxel() const noexcept {
+        return owned_ ? owned_->uniform_voxel() : view_.uniform_voxel();
+    }
+    [[nodiscard]] voxel_id voxel_at(std::uint32_t x, std::uint32_t y, std::uint32_t z) const {
+        return owned_ ? owned_->voxel_at(x, y, z) : view_.voxel_at(x, y, z);
+    }
+
+    [[nodiscard]] chunk_storage& mutate() {
+        if (!owned_) {
+            owned_.emplace(view_.promote());
+        }
+        return *owned_;
+    }
+
+    // Releases the owned chunk (promoting first if needed), e.g. to hand it to region_manager::replace.
+    [[nodiscard]] chunk_storage take() {
+        chunk_storage chunk = std::move(mutate());
+        owned_.reset();
+        return chunk;
+    }
+
+private:
+    chunk_view view_{};
+    std::optional<chunk_storage> owned_{};
+};
+
+// Memory-mapped region_file. Chunk views alias the mapped pages, so a cold read is bounded by page faults rather than
+// copies. Views of version 2 files verify the payload checksum when created. The file must not be rewritten or
+// compacted while mapped.
+class mapped_region_file {
+public:
+    explicit mapped_region_file(const std::filesystem::path& path);
+
+    [[nodiscard]] region_key region() const noexcept {
+        return region_key{header_.region[0], header_.region[1], header_.region[2]};
+    }
+    [[nodiscard]] std::uint32_t region_size() const noexcept { return header_.region_size; }
+    [[nodiscard]] bool contains(const region_key& chunk) const noexcept;
+    [[nodiscard]] std::size_t chunk_count() const noexcept;
+
+    [[nodiscard]] std::optional<chunk_view> view(const region_key& chunk) const;
+    void for_each(const std::function<void(const region_key&, const chunk_view&)>& visitor) const;
+
+private:
+    [[nodiscard]] std::optional<std::size_t> slot(const region_key& chunk) const noexcept;
+    [[nodiscard]] chunk_view view_slot(std::size_t index) const;
+
+    std::shared_ptr<const mapped_file> file_{};
+    region_file_header header_{};
+    std::vector<region_file_entry> index_{};
+};
+
+#if defined(_WIN32)
+inline mapped_file::mapped_file(const std::filesystem::path& path) {
+    file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open file for mapping");
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file_, &size)) {
+        CloseHandle(file_);
+        throw std::runtime_error("failed to query mapped file size");
+    }
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    if (size_ == 0) {
+        return;
+    }
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ == nullptr) {
+        CloseHandle(file_);
+        throw std::runtime_error("failed to create file mapping");
+    }
+    data_ = static_cast<const std::byte*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        CloseHandle(mapping_);
+        CloseHandle(file_);
+        throw std::runtime_error("failed to map file");
+    }
+}
+
+inline mapped_file::~mapped_file() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+    }
+}
+#else
+inline mapped_file::mapped_file(const std::filesystem::path& path) {
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("failed to open file for mapping");
+    }
+    struct stat info {};
+    if (::fstat(descriptor, &info) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error("failed to query mapped file size");
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0) {
+        void* address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (address == MAP_FAILED) {
+            ::close(descriptor);
+            throw std::runtime_error("failed to map file");
+        }
+        data_ = static_cast<const std::byte*>(address);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close(descriptor);
+}
+
+inline mapped_file::~mapped_file() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+}
+#endif
+
+inline chunk_view::chunk_view(std::span<const std::byte> payload, std::shared_ptr<const void> owner)
+    : payload_{payload}
+    , owner_{std::move(owner)} {
+    if (payload_.size() < sizeof(chunk_header_v2)) {
+        throw std::runtime_error("chunk payload too small");
+    }
+    std::memcpy(&header_, payload_.data(), sizeof(header_));
+    if (std::string_view(header_.magic, 4) != std::string_view{chunk_magic.data(), chunk_magic.size()}) {
+        throw std::runtime_error("invalid chunk magic");
+    }
+    if (header_.version < 2) {
+        throw std::runtime_error("chunk views require a version 2+ payload");
+    }
+    detail::reject_delta_payload(header_);
+    extent_ = chunk_extent{header_.extent[0], header_.extent[1], header_.extent[2]};
+    if (payload_.size() < sizeof(chunk_header_v2) + chunk_payload_bytes(header_.channel_flags, extent_.volume())) {
+        throw std::runtime_error("chunk payload truncated");
+    }
+}
+
+inline std::optional<voxel_id> chunk_view::uniform_voxel() const noexcept {
+    if (!uniform()) {
+        return std::nullopt;
+    }
+    voxel_id value{};
+    std::memcpy(&value, payload_.data() + sizeof(chunk_header_v2), sizeof(value));
+    return value;
+}
+
+inline voxel_id chunk_view::voxel_at(std::uint32_t x, std::uint32_t y, std::uint32_t z) const {
+    if (!extent_.contains(x, y, z)) {
+        throw std::out_of_range("voxel coordinate outside chunk view");
+    }
+    if (const auto value = uniform_voxel()) {
+        return *value;
+    }
+    const std::size_t index = x + std::size_t{extent_.x} * (y + std::size_t{extent_.y} * z);
+    voxel_id value{};
+    std::memcpy(&value, payload_.data() + sizeof(chunk_header_v2) + index * sizeof(voxel_id), sizeof(value));
+    return value;
+}
+
+inline span3d<const voxel_id> chunk_view::voxels() const {
+    const auto* data = plane(0);
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(voxel_id) != 0) {
+        throw std::runtime_error("chunk view voxel plane is misaligned");
+    }
+    return span3d<const voxel_id>{reinterpret_cast<const voxel_id*>(data), extent_};
+}
+
+inline span3d<const std::uint8_t> chunk_view::skylight() const {
+    return span3d<const std::uint8_t>{reinterpret_cast<const std::uint8_t*>(plane(volume() * sizeof(voxel_id))), extent_};
+}
+
+inline span3d<const std::uint8_t> chunk_view::blocklight() const {
+    return span3d<const std::uint8_t>{
+        reinterpret_cast<const std::uint8_t*>(plane(volume() * (sizeof(voxel_id) + 1))), extent_};
+}
+
+inline span3d<const std::uint8_t> chunk_view::metadata() const {
+    return span3d<const std::uint8_t>{
+        reinterpret_cast<const std::uint8_t*>(plane(volume() * (sizeof(voxel_id) + 2))), extent_};
+}
+
+inline const std::byte* chunk_view::plane(std::size_t offset) const {
+    if (uniform()) {
+        throw std::logic_error("uniform chunk views have no dense planes");
+    }
+    return payload_.data() + sizeof(chunk_header_v2) + offset;
+}
+
+inline mapped_region_file::mapped_region_file(const std::filesystem::path& path)
+    : file_{std::make_shared<const mapped_file>(path)} {
+    const auto bytes = file_->bytes();
+    if (bytes.size() < sizeof(region_file_header)) {
+        throw std::runtime_error("region file too small");
+    }
+    std::memcpy(&header_, bytes.data(), sizeof(header_));
+    if (std::string_view(header_.magic, 4) != std::string_view{region_file_magic.data(), region_file_magic.size()}) {
+        throw std::runtime_error("invalid region file header");
+    }
+    if (header_.version == 0 || header_.version > region_file_version || header_.region_size == 0) {
+        throw std::runtime_error("unsupported region file version");
+    }
+    const std::size_t n = header_.region_size;
+    index_.resize(n * n * n);
+    const auto index_bytes = index_.size() * sizeof(region_file_entry);
+    if (bytes.size() < sizeof(region_file_header) + index_bytes) {
+        throw std::runtime_error("truncated region file index");
+    }
+    std::memcpy(index_.data(), bytes.data() + sizeof(region_file_header), index_bytes);
+    for (const auto& entry : index_) {
+        if (entry.sector_count != 0
+            && std::uintmax_t{entry.sector} * header_.sector_size + entry.size > bytes.size()) {
+            throw std::runtime_error("corrupt region file index entry");
+        }
+    }
+}
+
+inline bool mapped_region_file::contains(const region_key& chunk) const noexcept {
+    const auto index = slot(chunk);
+    return index && index_[*index].sector_count != 0;
+}
+
+inline std::size_t mapped_region_file::chunk_count() const noexcept {
+    std::size_t count = 0;
+    for (const auto& entry : index_) {
+        count += entry.sector_count != 0 ? 1 : 0;
+    }
+    return count;
+}
+
+inline std::optional<chunk_view> mapped_region_file::view(const region_key& chunk) const {
+    const auto index = slot(chunk);
+    if (!index || index_[*index].sector_count == 0) {
+        return std::nullopt;
+    }
+    return view_slot(*index);
+}
+
+inline void mapped_region_file::for_each(
+    const std::function<void(const region_key&, const chunk_view&)>& visitor) const {
+    const auto n = static_cast<std::int32_t>(header_.region_size);
+    const auto origin = region();
+    for (std::size_t i = 0; i < index_.size(); ++i) {
+        if (index_[i].sector_count == 0) {
+            continue;
+        }
+        const auto local = static_cast<std::int32_t>(i);
+        const region_key key{origin.x * n + local % n, origin.y * n + (local / n) % n, origin.z * n + local / (n * n)};
+        visitor(key, view_slot(i));
+    }
+}
+
+inline std::optional<std::size_t> mapped_region_file::slot(const region_key& chunk) const noexcept {
+    if (region_file::region_of(chunk, header_.region_size) != region()) {
+        return std::nullopt;
+    }
+    const auto size = static_cast<std::int32_t>(header_.region_size);
+    const auto local = [size](std::int32_t value) { return static_cast<std::size_t>(((value % size) + size) % size); };
+    const std::size_t n = header_.region_size;
+    return local(chunk.x) + n * (local(chunk.y) + n * local(chunk.z));
+}
+
+inline chunk_view mapped_region_file::view_slot(std::size_t index) const {
+    const auto& entry = index_[index];
+    const auto offset = static_cast<std::size_t>(std::uintmax_t{entry.sector} * header_.sector_size);
+    const auto payload = file_->bytes().subspan(offset, entry.size);
+    if (header_.version >= 2 && detail::region_payload_checksum(payload) != entry.checksum) {
+        throw std::runtime_error("region file payload checksum mismatch");
+    }
+    return chunk_view{payload, file_};
+}
+
+} // namespace almond::voxel::serialization
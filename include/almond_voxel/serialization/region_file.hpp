@@ -0,0 +1,595 @@
+#pragma once
+
+#include "almond_voxel/chunk.hpp"
+#include "almond_voxel/serialization/file_commit.hpp"
+#include "almond_voxel/serialization/region_io.hpp"
+#include "almond_voxel/storage/checksum.hpp"
+#include "almond_voxel/world.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::serialization {
+
+// Version 2 stores a payload checksum in each index entry; version 1 files are still read, unverified.
+constexpr std::uint32_t region_file_version = 2;
+constexpr std::array<char, 4> region_file_magic{'A', 'V', 'R', 'G'};
+
+struct region_file_config {
+    // Chunks per axis covered by one file.
+    std::uint32_t region_size{16};
+    std::uint32_t sector_size{4096};
+    // Sync each relocated payload to disk before its index entry is repointed, so a power loss cannot leave the entry
+    // pointing at sectors that never reached the disk. Costs one fsync per write.
+    bool sync_writes{false};
+};
+
+struct region_file_header {
+    char magic[4]{region_file_magic[0], region_file_magic[1], region_file_magic[2], region_file_magic[3]};
+    std::uint32_t version{region_file_version};
+    std::uint32_t region_size{16};
+    std::uint32_t sector_size{4096};
+    std::int32_t region[3]{0, 0, 0};
+    std::uint32_t reserved{0};
+};
+
+// Index slot for one chunk. sector_count == 0 marks an empty slot.
+struct region_file_entry {
+    std::uint32_t sector{0};
+    std::uint32_t sector_count{0};
+    std::uint32_t size{0};
+    // Low 32 bits of the payload's XXH64.
+    std::uint32_t checksum{0};
+};
+
+namespace detail {
+
+inline std::uint32_t region_payload_checksum(std::span<const std::byte> payload) {
+    return static_cast<std::uint32_t>(xxhash64(payload));
+}
+
+} // namespace detail
+
+// Region container: a fixed header, an index table keyed by local chunk coordinates, then sector-aligned payloads.
+// Writes never overwrite live sectors: the payload goes to the first free run and the index entry is repointed (and
+// the old sectors released) only afterwards, so a crash mid-write leaves the previous copy reachable. read() verifies
+// each payload against its checksum. compact() rebuilds the packed file beside the original and swaps it in with
+// commit_file(). The first write to a version 1 file checksums its payloads and upgrades the header to version 2.
+class region_file {
+public:
+    explicit region_file(std::filesystem::path path, region_key region = {}, region_file_config config = {});
+
+    [[nodiscard]] static region_key region_of(const region_key& chunk, std::uint32_t region_size) noexcept;
+
+    [[nodiscard]] const std::filesystem::path& path() const noexcept { return path_; }
+    [[nodiscard]] region_key region() const noexcept {
+        return region_key{header_.region[0], header_.region[1], header_.region[2]};
+    }
+    [[nodiscard]] std::uint32_t region_size() const noexcept { return header_.region_size; }
+    [[nodiscard]] std::uint32_t sector_size() const noexcept { return header_.sector_size; }
+    [[nodiscard]] bool covers(const region_key& chunk) const noexcept;
+
+    [[nodiscard]] bool contains(const region_key& chunk) const;
+    [[nodiscard]] std::optional<std::vector<std::byte>> read(const region_key& chunk);
+    void write(const region_key& chunk, std::span<const std::byte> payload);
+    bool erase(const region_key& chunk);
+
+    [[nodiscard]] std::optional<chunk_storage> load_chunk(const region_key& chunk);
+    void store_chunk(const region_key& chunk, const chunk_storage& storage);
+
+    // Returns the number of bytes released.
+    std::size_t compact();
+    void flush();
+
+    [[nodiscard]] std::size_t chunk_count() const noexcept;
+    [[nodiscard]] std::size_t sector_count() const noexcept { return used_.size(); }
+    [[nodiscard]] std::size_t used_sectors() const noexcept;
+    [[nodiscard]] std::uintmax_t file_size() const noexcept { return std::uintmax_t{used_.size()} * header_.sector_size; }
+
+private:
+    [[nodiscard]] std::size_t slot(const region_key& chunk) const;
+    [[nodiscard]] std::size_t data_sector() const noexcept;
+    [[nodiscard]] std::uint32_t sectors_for(std::size_t bytes) const noexcept;
+    [[nodiscard]] std::uint32_t allocate(std::uint32_t count);
+    void mark(std::uint32_t sector, std::uint32_t count, bool used);
+    void write_preamble(std::ostream& out, std::span<const region_file_entry> index) const;
+    void upgrade_version();
+    void write_entry(std::size_t index);
+    void write_payload(std::uint32_t sector, std::uint32_t count, std::span<const std::byte> payload);
+    void read_payload(const region_file_entry& entry, std::span<std::byte> out);
+    void open_stream();
+
+    std::filesystem::path path_{};
+    std::fstream stream_{};
+    region_file_header header_{};
+    std::vector<region_file_entry> index_{};
+    std::vector<bool> used_{};
+    bool sync_writes_{false};
+};
+
+// Maps chunk keys onto one region_file per region inside a directory and keeps the files open. Safe to share between
+// threads, so it can back region_manager loaders that run on worker threads. Each file has its own lock, so chunks in
+// different regions load and save in parallel; chunk (de)serialisation runs outside the file locks.
+class region_store {
+public:
+    explicit region_store(std::filesystem::path directory, region_file_config config = {});
+
+    [[nodiscard]] std::optional<chunk_storage> load(const region_key& chunk);
+    void save(const region_key& chunk, const chunk_storage& storage);
+    bool erase(const region_key& chunk);
+    void flush();
+
+    // Loader that falls back to `fallback` (or an empty chunk of `extent`) when the chunk was never stored.
+    [[nodiscard]] region_manager::loader_type loader(chunk_extent extent, region_manager::loader_type fallback = {});
+    [[nodiscard]] region_manager::saver_type saver();
+
+    [[nodiscard]] std::filesystem::path file_path(const region_key& region) const;
+
+private:
+    // One region's file, opened on first use. `file` is only touched under `mutex`.
+    struct open_region {
+        std::mutex mutex{};
+        std::unique_ptr<region_file> file{};
+    };
+
+    [[nodiscard]] open_region& region_for(const region_key& chunk);
+    [[nodiscard]] region_file& file_of(open_region& region, const region_key& chunk);
+
+    std::filesystem::path directory_{};
+    region_file_config config_{};
+    // Guards the map only; entries are never removed, so references to them stay valid without it.
+    std::mutex files_mutex_{};
+    std::unordered_map<region_key, std::unique_ptr<open_region>, region_key_hash> files_{};
+};
+
+inline region_file::region_file(std::filesystem::path path, region_key region, region_file_config config)
+    : path_{std::move(path)}
+    , sync_writes_{config.sync_writes} {
+    if (config.region_size == 0 || config.sector_size < sizeof(region_file_header)) {
+        throw std::logic_error("invalid region file configuration");
+    }
+    header_.region_size = config.region_size;
+    header_.sector_size = config.sector_size;
+    header_.region[0] = region.x;
+    header_.region[1] = region.y;
+    header_.region[2] = region.z;
+
+    if (!path_.parent_path().empty()) {
+        std::filesystem::create_directories(path_.parent_path());
+    }
+
+    if (std::filesystem::exists(path_) && std::filesystem::file_size(path_) > 0) {
+        open_stream();
+        region_file_header stored{};
+        stream_.read(reinterpret_cast<char*>(&stored), sizeof(stored));
+        if (!stream_ || std::string_view(stored.magic, 4)
+                != std::string_view{region_file_magic.data(), region_file_magic.size()}) {
+            throw std::runtime_error("invalid region file header");
+        }
+        if (stored.version == 0 || stored.version > region_file_version) {
+            throw std::runtime_error("unsupported region file version");
+        }
+        header_.version = stored.version;
+        if (stored.region_size != config.region_size || stored.sector_size != config.sector_size
+            || stored.region[0] != region.x || stored.region[1] != region.y || stored.region[2] != region.z) {
+            throw std::runtime_error("region file layout does not match the requested region");
+        }
+        index_.resize(std::size_t{header_.region_size} * header_.region_size * header_.region_size);
+        stream_.read(reinterpret_cast<char*>(index_.data()),
+            static_cast<std::streamsize>(index_.size() * sizeof(region_file_entry)));
+        if (!stream_) {
+            throw std::runtime_error("truncated region file index");
+        }
+        const auto total = static_cast<std::size_t>(std::filesystem::file_size(path_) / header_.sector_size);
+        used_.assign(std::max(total, data_sector()), false);
+        mark(0, static_cast<std::uint32_t>(data_sector()), true);
+        for (const auto& entry : index_) {
+            if (entry.sector_count == 0) {
+                continue;
+            }
+            if (entry.sector < data_sector() || std::size_t{entry.sector} + entry.sector_count > used_.size()
+                || entry.size > std::size_t{entry.sector_count} * header_.sector_size) {
+                throw std::runtime_error("corrupt region file index entry");
+            }
+            mark(entry.sector, entry.sector_count, true);
+        }
+        return;
+    }
+
+    {
+        std::ofstream create(path_, std::ios::binary | std::ios::trunc);
+        if (!create) {
+            throw std::runtime_error("failed to create region file");
+        }
+    }
+    open_stream();
+    index_.assign(std::size_t{header_.region_size} * header_.region_size * header_.region_size, region_file_entry{});
+    used_.assign(data_sector(), true);
+    stream_.seekp(0);
+    write_preamble(stream_, index_);
+    stream_.flush();
+    if (!stream_) {
+        throw std::runtime_error("failed to initialise region file");
+    }
+}
+
+inline region_key region_file::region_of(const region_key& chunk, std::uint32_t region_size) noexcept {
+    const auto size = static_cast<std::int32_t>(region_size);
+    const auto floor_div = [size](std::int32_t value) { return value >= 0 ? value / size : -((-value - 1) / size) - 1; };
+    return region_key{floor_div(chunk.x), floor_div(chunk.y), floor_div(chunk.z)};
+}
+
+inline bool region_file::covers(const region_key& chunk) const noexcept {
+    return region_of(chunk, header_.region_size) == region();
+}
+
+inline bool region_file::contains(const region_key& chunk) const {
+    return index_[slot(chunk)].sector_count != 0;
+}
+
+inline std::optional<std::vector<std::byte>> region_file::read(const region_key& chunk) {
+    const auto& entry = index_[slot(chunk)];
+    if (entry.sector_count == 0) {
+        return std::nullopt;
+    }
+    std::vector<std::byte> payload(entry.size);
+    read_payload(entry, payload);
+    if (header_.version >= 2 && detail::region_payload_checksum(payload) != entry.checksum) {
+        throw std::runtime_error("region file payload checksum mismatch");
+    }
+    return payload;
+}
+
+inline void region_file::write(const region_key& chunk, std::span<const std::byte> payload) {
+    const auto index = slot(chunk);
+    auto& entry = index_[index];
+    const auto needed = sectors_for(payload.size());
+    if (needed == 0) {
+        erase(chunk);
+        return;
+    }
+    upgrade_version();
+
+    // Write the new copy before repointing the index so the old payload stays readable until then.
+    const auto sector = allocate(needed);
+    mark(sector, needed, true);
+    write_payload(sector, needed, payload);
+    if (sync_writes_) {
+        flush();
+    }
+    mark(entry.sector, entry.sector_count, false);
+    entry.sector = sector;
+    entry.sector_count = needed;
+    entry.size = static_cast<std::uint32_t>(payload.size());
+    entry.checksum = detail::region_payload_checksum(payload);
+    write_entry(index);
+}
+
+inline bool region_file::erase(const region_key& chunk) {
+    const auto index = slot(chunk);
+    auto& entry = index_[index];
+    if (entry.sector_count == 0) {
+        return false;
+    }
+    upgrade_version();
+    mark(entry.sector, entry.sector_count, false);
+    entry = region_file_entry{};
+    write_entry(index);
+    return true;
+}
+
+inline std::optional<chunk_storage> region_file::load_chunk(const region_key& chunk) {
+    auto payload = read(chunk);
+    if (!payload) {
+        return std::nullopt;
+    }
+    return deserialize_chunk(*payload);
+}
+
+inline void region_file::store_chunk(const region_key& chunk, const chunk_storage& storage) {
+    const auto payload = serialize_chunk(storage);
+    write(chunk, payload);
+}
+
+inline std::size_t region_file::compact() {
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < index_.size(); ++i) {
+        if (index_[i].sector_count != 0) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return index_[lhs].sector < index_[rhs].sector;
+    });
+
+    // Live sectors are never touched: the packed copy goes to a temporary file that replaces this one only once it is
+    // complete and synced, so a crash at any point leaves either the old or the new file intact.
+    auto temporary = path_;
+    temporary += ".tmp";
+    std::vector<region_file_entry> packed(index_.size());
+    auto next = static_cast<std::uint32_t>(data_sector());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("failed to create compacted region file");
+        }
+        // Placeholder preamble; the final index is written once every payload has its new offset.
+        write_preamble(out, packed);
+        std::vector<std::byte> buffer;
+        for (const auto i : order) {
+            const auto& entry = index_[i];
+            buffer.resize(entry.size);
+            read_payload(entry, buffer);
+            const auto padding = std::size_t{entry.sector_count} * header_.sector_size - buffer.size();
+            out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+            const std::vector<char> zeros(padding, 0);
+            out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+            packed[i] = region_file_entry{next, entry.sector_count, entry.size,
+                header_.version >= 2 ? entry.checksum : detail::region_payload_checksum(buffer)};
+            next += entry.sector_count;
+        }
+        auto header = header_;
+        header.version = region_file_version;
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(packed.data()),
+            static_cast<std::streamsize>(packed.size() * sizeof(region_file_entry)));
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("failed to write compacted region file");
+        }
+    }
+
+    const auto before = file_size();
+    stream_.close();
+    std::exception_ptr error;
+    try {
+        commit_file(temporary, path_);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    open_stream();
+    // A failed directory sync happens after the rename, so the packed layout may already be the live file.
+    if (!std::filesystem::exists(temporary)) {
+        header_.version = region_file_version;
+        index_ = std::move(packed);
+        used_.assign(next, true);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return static_cast<std::size_t>(before - file_size());
+}
+
+inline void region_file::flush() {
+    stream_.flush();
+    if (!stream_) {
+        throw std::runtime_error("failed to flush region file");
+    }
+    if (sync_writes_) {
+        sync_file(path_);
+    }
+}
+
+inline std::size_t region_file::chunk_count() const noexcept {
+    return static_cast<std::size_t>(std::count_if(index_.begin(), index_.end(),
+        [](const region_file_entry& entry) { return entry.sector_count != 0; }));
+}
+
+inline std::size_t region_file::used_sectors() const noexcept {
+    return static_cast<std::size_t>(std::count(used_.begin(), used_.end(), true));
+}
+
+inline std::size_t region_file::slot(const region_key& chunk) const {
+    if (!covers(chunk)) {
+        throw std::out_of_range("chunk lies outside this region file");
+    }
+    const auto size = static_cast<std::int32_t>(header_.region_size);
+    const auto local = [size](std::int32_t value) { return static_cast<std::size_t>(((value % size) + size) % size); };
+    const std::size_t n = header_.region_size;
+    return local(chunk.x) + n * (local(chunk.y) + n * local(chunk.z));
+}
+
+inline std::size_t region_file::data_sector() const noexcept {
+    const std::size_t n = header_.region_size;
+    const std::size_t bytes = sizeof(region_file_header) + n * n * n * sizeof(region_file_entry);
+    return (bytes + header_.sector_size - 1) / header_.sector_size;
+}
+
+inline std::uint32_t region_file::sectors_for(std::size_t bytes) const noexcept {
+    return static_cast<std::uint32_t>((bytes + header_.sector_size - 1) / header_.sector_size);
+}
+
+inline std::uint32_t region_file::allocate(std::uint32_t count) {
+    std::size_t run = 0;
+    for (std::size_t sector = data_sector(); sector < used_.size(); ++sector) {
+        run = used_[sector] ? 0 : run + 1;
+        if (run == count) {
+            return static_cast<std::uint32_t>(sector + 1 - count);
+        }
+    }
+    // Extend the file, reusing a free tail run if there is one.
+    const auto start = used_.size() - run;
+    used_.resize(start + count, false);
+    return static_cast<std::uint32_t>(start);
+}
+
+inline void region_file::mark(std::uint32_t sector, std::uint32_t count, bool used) {
+    if (used_.size() < std::size_t{sector} + count) {
+        used_.resize(std::size_t{sector} + count, false);
+    }
+    std::fill_n(used_.begin() + sector, count, used);
+}
+
+inline void region_file::write_preamble(std::ostream& out, std::span<const region_file_entry> index) const {
+    out.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    out.write(reinterpret_cast<const char*>(index.data()),
+        static_cast<std::streamsize>(index.size() * sizeof(region_file_entry)));
+    const auto padding = data_sector() * header_.sector_size - sizeof(header_) - index.size() * sizeof(region_file_entry);
+    const std::vector<char> zeros(padding, 0);
+    out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+}
+
+inline void region_file::upgrade_version() {
+    if (header_.version >= region_file_version) {
+        return;
+    }
+    // Version 1 entries carry no checksums. Fill them in first and bump the header last, so the file never claims
+    // verified entries it does not have.
+    std::vector<std::byte> payload;
+    for (std::size_t i = 0; i < index_.size(); ++i) {
+        auto& entry = index_[i];
+        if (entry.sector_count == 0) {
+            continue;
+        }
+        payload.resize(entry.size);
+        read_payload(entry, payload);
+        entry.checksum = detail::region_payload_checksum(payload);
+        write_entry(i);
+    }
+    flush();
+    header_.version = region_file_version;
+    stream_.seekp(0);
+    stream_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    if (!stream_) {
+        throw std::runtime_error("failed to upgrade region file header");
+    }
+}
+
+inline void region_file::write_entry(std::size_t index) {
+    stream_.seekp(static_cast<std::streamoff>(sizeof(region_file_header) + index * sizeof(region_file_entry)));
+    stream_.write(reinterpret_cast<const char*>(&index_[index]), sizeof(region_file_entry));
+    if (!stream_) {
+        throw std::runtime_error("failed to write region file index");
+    }
+}
+
+inline void region_file::write_payload(std::uint32_t sector, std::uint32_t count, std::span<const std::byte> payload) {
+    stream_.seekp(static_cast<std::streamoff>(std::uintmax_t{sector} * header_.sector_size));
+    stream_.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    const auto padding = std::size_t{count} * header_.sector_size - payload.size();
+    if (padding > 0) {
+        const std::vector<char> zeros(padding, 0);
+        stream_.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+    if (!stream_) {
+        throw std::runtime_error("failed to write region file payload");
+    }
+}
+
+inline void region_file::read_payload(const region_file_entry& entry, std::span<std::byte> out) {
+    stream_.seekg(static_cast<std::streamoff>(std::uintmax_t{entry.sector} * header_.sector_size));
+    stream_.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!stream_) {
+        stream_.clear();
+        throw std::runtime_error("failed to read region file payload");
+    }
+}
+
+inline void region_file::open_stream() {
+    stream_.open(path_, std::ios::binary | std::ios::in | std::ios::out);
+    if (!stream_) {
+        throw std::runtime_error("failed to open region file");
+    }
+}
+
+inline region_store::region_store(std::filesystem::path directory, region_file_config config)
+    : directory_{std::move(directory)}
+    , config_{config} {
+}
+
+inline std::optional<chunk_storage> region_store::load(const region_key& chunk) {
+    auto& region = region_for(chunk);
+    std::optional<std::vector<std::byte>> payload;
+    {
+        std::scoped_lock lock{region.mutex};
+        payload = file_of(region, chunk).read(chunk);
+    }
+    if (!payload) {
+        return std::nullopt;
+    }
+    return deserialize_chunk(*payload);
+}
+
+inline void region_store::save(const region_key& chunk, const chunk_storage& storage) {
+    auto payload = serialize_chunk(storage);
+    auto& region = region_for(chunk);
+    std::scoped_lock lock{region.mutex};
+    file_of(region, chunk).write(chunk, payload);
+}
+
+inline bool region_store::erase(const region_key& chunk) {
+    auto& region = region_for(chunk);
+    std::scoped_lock lock{region.mutex};
+    return file_of(region, chunk).erase(chunk);
+}
+
+inline void region_store::flush() {
+    std::vector<open_region*> regions;
+    {
+        std::scoped_lock lock{files_mutex_};
+        regions.reserve(files_.size());
+        for (auto& [key, region] : files_) {
+            regions.push_back(region.get());
+        }
+    }
+    for (auto* region : regions) {
+        std::scoped_lock lock{region->mutex};
+        if (region->file) {
+            region->file->flush();
+        }
+    }
+}
+
+inline region_manager::loader_type region_store::loader(chunk_extent extent, region_manager::loader_type fallback) {
+    return [this, extent, fallback = std::move(fallback)](const region_key& key) {
+        if (auto stored = load(key)) {
+            return std::move(*stored);
+        }
+        return fallback ? fallback(key) : chunk_storage{extent};
+    };
+}
+
+inline region_manager::saver_type region_store::saver() {
+    return [this](const region_key& key, const chunk_storage& chunk) { save(key, chunk); };
+}
+
+inline std::filesystem::path region_store::file_path(const region_key& region) const {
+    return directory_ / ("r." + std::to_string(region.x) + '.' + std::to_string(region.y) + '.'
+        + std::to_string(region.z) + ".avr");
+}
+
+inline region_store::open_region& region_store::region_for(const region_key& chunk) {
+    const auto region = region_file::region_of(chunk, config_.region_size);
+    std::scoped_lock lock{files_mutex_};
+    auto& entry = files_[region];
+    if (!entry) {
+        entry = std::make_unique<open_region>();
+    }
+    return *entry;
+}
+
+inline region_file& region_store::file_of(open_region& region, const region_key& chunk) {
+    if (!region.file) {
+        const auto key = region_file::region_of(chunk, config_.region_size);
+        region.file = std::make_unique<region_file>(file_path(key), key, config_);
+    }
+    return *region.file;
+}
+
+} // namespace almond::voxel::serialization
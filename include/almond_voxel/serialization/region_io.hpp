@@ -1,24 +1,37 @@
 #pragma once
 
 #include "almond_voxel/chunk.hpp"
+#include "almond_voxel/parallel/task_pool.hpp"
+#include "almond_voxel/serialization/file_commit.hpp"
+#include "almond_voxel/storage/checksum.hpp"
+#include "almond_voxel/storage/codecs.hpp"
 #include "almond_voxel/world.hpp"
 
+#include <algorithm>
 #include <array>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <span>
 #include <stdexcept>
 #include <string_view>
+#include <system_error>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace almond::voxel::serialization {
 
-constexpr std::uint32_t chunk_version_latest = 3;
+constexpr std::uint32_t chunk_version_latest = 4;
+// Delta payloads (see chunk_delta.hpp) share the v2 header, carry this version and set `chunk_channel_delta`.
+constexpr std::uint32_t chunk_version_delta = 5;
 constexpr std::array<char, 4> chunk_magic{'A', 'V', 'C', 'K'};
 
 struct chunk_header_v1 {
@@ -40,9 +53,38 @@ enum chunk_channel_flags : std::uint32_t {
     chunk_channel_blocklight_cache = 1u << 2u,
     chunk_channel_effect_density = 1u << 3u,
     chunk_channel_effect_velocity = 1u << 4u,
-    chunk_channel_effect_lifetime = 1u << 5u
+    chunk_channel_effect_lifetime = 1u << 5u,
+    chunk_channel_uniform = 1u << 6u,
+    chunk_channel_delta = 1u << 7u
 };
 
+// Payload size following a v2 header. Uniform payloads (version 4+) store a single value per enabled plane.
+[[nodiscard]] inline std::size_t chunk_payload_bytes(std::uint32_t flags, std::size_t count) noexcept {
+    if (flags & chunk_channel_uniform) {
+        count = 1;
+    }
+    std::size_t bytes = count * (sizeof(voxel_id) + 3);
+    if (flags & chunk_channel_materials) {
+        bytes += count * sizeof(material_index);
+    }
+    if (flags & chunk_channel_skylight_cache) {
+        bytes += count * sizeof(float);
+    }
+    if (flags & chunk_channel_blocklight_cache) {
+        bytes += count * sizeof(float);
+    }
+    if (flags & chunk_channel_effect_density) {
+        bytes += count * sizeof(float);
+    }
+    if (flags & chunk_channel_effect_velocity) {
+        bytes += count * sizeof(effects::velocity_sample);
+    }
+    if (flags & chunk_channel_effect_lifetime) {
+        bytes += count * sizeof(float);
+    }
+    return bytes;
+}
+
 struct region_blob {
     region_key key{};
     std::vector<std::byte> payload;
@@ -53,69 +95,188 @@ inline void append_bytes(std::vector<std::byte>& buffer, const void* data, std::
     buffer.insert(buffer.end(), bytes, bytes + size);
 }
 
-inline std::vector<std::byte> serialize_chunk(const chunk_storage& chunk) {
-    const auto extent = chunk.extent();
-    const auto voxel_data = chunk.voxels();
-    const auto sky_data = chunk.skylight();
-    const auto block_data = chunk.blocklight();
-    const auto meta_data = chunk.metadata();
-    const bool has_materials = chunk.materials_enabled();
-    const bool has_high_precision = chunk.high_precision_lighting_enabled();
-    const bool has_effect_density = chunk.effect_density_enabled();
-    const bool has_effect_velocity = chunk.effect_velocity_enabled();
-    const bool has_effect_lifetime = chunk.effect_lifetime_enabled();
+namespace detail {
 
-    chunk_header_v2 header{};
-    header.extent[0] = extent.x;
-    header.extent[1] = extent.y;
-    header.extent[2] = extent.z;
-    if (has_materials) {
-        header.channel_flags |= chunk_channel_materials;
+// Channel flags describing which optional planes a chunk carries.
+[[nodiscard]] inline std::uint32_t chunk_channels(const chunk_storage& chunk) noexcept {
+    std::uint32_t flags = 0;
+    if (chunk.materials_enabled()) {
+        flags |= chunk_channel_materials;
     }
-    if (has_high_precision) {
-        header.channel_flags |= chunk_channel_skylight_cache | chunk_channel_blocklight_cache;
+    if (chunk.high_precision_lighting_enabled()) {
+        flags |= chunk_channel_skylight_cache | chunk_channel_blocklight_cache;
     }
+    if (chunk.effect_density_enabled()) {
+        flags |= chunk_channel_effect_density;
+    }
+    if (chunk.effect_velocity_enabled()) {
+        flags |= chunk_channel_effect_velocity;
+    }
+    if (chunk.effect_lifetime_enabled()) {
+        flags |= chunk_channel_effect_lifetime;
+    }
+    return flags;
+}
+
+inline void reject_delta_payload(const chunk_header_v2& header) {
+    if (header.version == chunk_version_delta || (header.channel_flags & chunk_channel_delta) != 0) {
+        throw std::runtime_error("chunk payload is a delta; apply it with apply_chunk_delta");
+    }
+}
+
+// Decodes the planes following a v2+ header straight into a new chunk. `read(destination, size)` must fill exactly
+// `size` bytes or throw, so stream and span sources share one decoder without staging the payload.
+template <typename Read>
+chunk_storage decode_chunk_body(const chunk_header_v2& header, Read&& read) {
+    const chunk_extent extent{header.extent[0], header.extent[1], header.extent[2]};
+    const auto count = extent.volume();
+    const bool has_materials = (header.channel_flags & chunk_channel_materials) != 0;
+    const bool has_sky_cache = (header.channel_flags & chunk_channel_skylight_cache) != 0;
+    const bool has_block_cache = (header.channel_flags & chunk_channel_blocklight_cache) != 0;
+    const bool has_effect_density = (header.channel_flags & chunk_channel_effect_density) != 0;
+    const bool has_effect_velocity = (header.channel_flags & chunk_channel_effect_velocity) != 0;
+    const bool has_effect_lifetime = (header.channel_flags & chunk_channel_effect_lifetime) != 0;
+    const bool uniform = (header.channel_flags & chunk_channel_uniform) != 0;
+
+    chunk_storage_config config{};
+    config.extent = extent;
+    config.enable_materials = has_materials;
+    config.enable_high_precision_lighting = has_sky_cache || has_block_cache;
+    config.effect_channels = effects::channel::none;
     if (has_effect_density) {
-        header.channel_flags |= chunk_channel_effect_density;
+        config.effect_channels |= effects::channel::density;
     }
     if (has_effect_velocity) {
-        header.channel_flags |= chunk_channel_effect_velocity;
+        config.effect_channels |= effects::channel::velocity;
     }
     if (has_effect_lifetime) {
-        header.channel_flags |= chunk_channel_effect_lifetime;
+        config.effect_channels |= effects::channel::lifetime;
     }
 
-    const auto volume = extent.volume();
-    std::size_t payload_bytes = volume * (sizeof(voxel_id) + 3);
+    chunk_storage chunk{config};
+
+    if (uniform) {
+        chunk_uniform_values values{};
+        const auto read_value = [&read](auto& value) { read(&value, sizeof(value)); };
+        read_value(values.voxel);
+        read_value(values.skylight);
+        read_value(values.blocklight);
+        read_value(values.metadata);
+        if (has_materials) {
+            read_value(values.material);
+        }
+        if (has_sky_cache) {
+            read_value(values.skylight_cache);
+        }
+        if (has_block_cache) {
+            read_value(values.blocklight_cache);
+        }
+        if (has_effect_density) {
+            read_value(values.effect_density);
+        }
+        if (has_effect_velocity) {
+            read_value(values.effect_velocity);
+        }
+        if (has_effect_lifetime) {
+            read_value(values.effect_lifetime);
+        }
+        chunk.fill(values);
+        chunk.mark_dirty(false);
+        return chunk;
+    }
+
+    const auto read_plane = [&read, count](auto view) {
+        using value_type = typename decltype(view)::element_type;
+        read(view.linear().data(), count * sizeof(value_type));
+    };
+
+    read_plane(chunk.voxels());
+    read_plane(chunk.skylight());
+    read_plane(chunk.blocklight());
+    read_plane(chunk.metadata());
     if (has_materials) {
-        payload_bytes += volume * sizeof(material_index);
+        read_plane(chunk.materials());
     }
-    if (has_high_precision) {
-        payload_bytes += volume * sizeof(float) * 2;
+    if (has_sky_cache) {
+        read_plane(chunk.skylight_cache());
+    }
+    if (has_block_cache) {
+        read_plane(chunk.blocklight_cache());
     }
     if (has_effect_density) {
-        payload_bytes += volume * sizeof(float);
+        read_plane(chunk.effect_density());
     }
     if (has_effect_velocity) {
-        payload_bytes += volume * sizeof(effects::velocity_sample);
+        read_plane(chunk.effect_velocity());
     }
     if (has_effect_lifetime) {
-        payload_bytes += volume * sizeof(float);
+        read_plane(chunk.effect_lifetime());
     }
 
+    chunk.mark_dirty(false);
+    return chunk;
+}
+
+} // namespace detail
+
+inline std::vector<std::byte> serialize_chunk(const chunk_storage& chunk) {
+    const auto extent = chunk.extent();
+    const bool has_materials = chunk.materials_enabled();
+    const bool has_high_precision = chunk.high_precision_lighting_enabled();
+    const bool has_effect_density = chunk.effect_density_enabled();
+    const bool has_effect_velocity = chunk.effect_velocity_enabled();
+    const bool has_effect_lifetime = chunk.effect_lifetime_enabled();
+
+    chunk_header_v2 header{};
+    header.extent[0] = extent.x;
+    header.extent[1] = extent.y;
+    header.extent[2] = extent.z;
+    header.channel_flags = detail::chunk_channels(chunk);
+
+    const auto uniform = chunk.uniform_values();
+    if (uniform) {
+        header.channel_flags |= chunk_channel_uniform;
+    }
+
+    const auto volume = extent.volume();
     std::vector<std::byte> buffer;
-    buffer.reserve(sizeof(chunk_header_v2) + payload_bytes);
+    buffer.reserve(sizeof(chunk_header_v2) + chunk_payload_bytes(header.channel_flags, volume));
     append_bytes(buffer, &header, sizeof(header));
 
+    if (uniform) {
+        append_bytes(buffer, &uniform->voxel, sizeof(uniform->voxel));
+        append_bytes(buffer, &uniform->skylight, sizeof(uniform->skylight));
+        append_bytes(buffer, &uniform->blocklight, sizeof(uniform->blocklight));
+        append_bytes(buffer, &uniform->metadata, sizeof(uniform->metadata));
+        if (has_materials) {
+            append_bytes(buffer, &uniform->material, sizeof(uniform->material));
+        }
+        if (has_high_precision) {
+            append_bytes(buffer, &uniform->skylight_cache, sizeof(uniform->skylight_cache));
+            append_bytes(buffer, &uniform->blocklight_cache, sizeof(uniform->blocklight_cache));
+        }
+        if (has_effect_density) {
+            append_bytes(buffer, &uniform->effect_density, sizeof(uniform->effect_density));
+        }
+        if (has_effect_velocity) {
+            append_bytes(buffer, &uniform->effect_velocity, sizeof(uniform->effect_velocity));
+        }
+        if (has_effect_lifetime) {
+            append_bytes(buffer, &uniform->effect_lifetime, sizeof(uniform->effect_lifetime));
+        }
+        return buffer;
+    }
+
     const auto copy_span = [&buffer](auto span) {
         using value_type = typename decltype(span)::value_type;
         append_bytes(buffer, span.data(), span.size() * sizeof(value_type));
     };
 
-    copy_span(voxel_data.linear());
-    copy_span(sky_data.linear());
-    copy_span(block_data.linear());
-    copy_span(meta_data.linear());
+    std::vector<voxel_id> decoded;
+    copy_span(chunk.read_voxels(decoded).linear());
+    copy_span(chunk.skylight().linear());
+    copy_span(chunk.blocklight().linear());
+    copy_span(chunk.metadata().linear());
 
     if (has_materials) {
         copy_span(chunk.materials().linear());
@@ -184,105 +345,19 @@ inline chunk_storage deserialize_chunk(std::span<const std::byte> bytes) {
     if (header_v2.version < 2) {
         throw std::runtime_error("unsupported chunk version");
     }
+    detail::reject_delta_payload(header_v2);
 
     const chunk_extent extent{header_v2.extent[0], header_v2.extent[1], header_v2.extent[2]};
-    const auto count = extent.volume();
-    const bool has_materials = (header_v2.channel_flags & chunk_channel_materials) != 0;
-    const bool has_sky_cache = (header_v2.channel_flags & chunk_channel_skylight_cache) != 0;
-    const bool has_block_cache = (header_v2.channel_flags & chunk_channel_blocklight_cache) != 0;
-    const bool has_effect_density = (header_v2.channel_flags & chunk_channel_effect_density) != 0;
-    const bool has_effect_velocity = (header_v2.channel_flags & chunk_channel_effect_velocity) != 0;
-    const bool has_effect_lifetime = (header_v2.channel_flags & chunk_channel_effect_lifetime) != 0;
-
-    std::size_t required = sizeof(chunk_header_v2) + count * (sizeof(voxel_id) + 3);
-    if (has_materials) {
-        required += count * sizeof(material_index);
-    }
-    if (has_sky_cache) {
-        required += count * sizeof(float);
-    }
-    if (has_block_cache) {
-        required += count * sizeof(float);
-    }
-    if (has_effect_density) {
-        required += count * sizeof(float);
-    }
-    if (has_effect_velocity) {
-        required += count * sizeof(effects::velocity_sample);
-    }
-    if (has_effect_lifetime) {
-        required += count * sizeof(float);
-    }
+    const std::size_t required = sizeof(chunk_header_v2) + chunk_payload_bytes(header_v2.channel_flags, extent.volume());
     if (bytes.size() < required) {
         throw std::runtime_error("chunk payload truncated");
     }
 
-    chunk_storage_config config{};
-    config.extent = extent;
-    config.enable_materials = has_materials;
-    config.enable_high_precision_lighting = has_sky_cache || has_block_cache;
-    config.effect_channels = effects::channel::none;
-    if (has_effect_density) {
-        config.effect_channels |= effects::channel::density;
-    }
-    if (has_effect_velocity) {
-        config.effect_channels |= effects::channel::velocity;
-    }
-    if (has_effect_lifetime) {
-        config.effect_channels |= effects::channel::lifetime;
-    }
-
-    chunk_storage chunk{config};
     const auto* ptr = bytes.data() + sizeof(chunk_header_v2);
-
-    auto copy_into = [&ptr, count](auto view) {
-        using value_type = typename decltype(view)::element_type;
-        std::memcpy(view.linear().data(), ptr, count * sizeof(value_type));
-        ptr += count * sizeof(value_type);
-    };
-
-    copy_into(chunk.voxels());
-    copy_into(chunk.skylight());
-    copy_into(chunk.blocklight());
-    copy_into(chunk.metadata());
-
-    if (has_materials) {
-        auto materials = chunk.materials();
-        std::memcpy(materials.linear().data(), ptr, count * sizeof(material_index));
-        ptr += count * sizeof(material_index);
-    }
-
-    if (config.enable_high_precision_lighting) {
-        if (has_sky_cache) {
-            auto sky_cache = chunk.skylight_cache();
-            std::memcpy(sky_cache.linear().data(), ptr, count * sizeof(float));
-            ptr += count * sizeof(float);
-        }
-        if (has_block_cache) {
-            auto block_cache = chunk.blocklight_cache();
-            std::memcpy(block_cache.linear().data(), ptr, count * sizeof(float));
-            ptr += count * sizeof(float);
-        }
-    }
-
-    if (has_effect_density) {
-        auto density = chunk.effect_density();
-        std::memcpy(density.linear().data(), ptr, count * sizeof(float));
-        ptr += count * sizeof(float);
-    }
-    if (has_effect_velocity) {
-        auto velocity = chunk.effect_velocity();
-        std::memcpy(velocity.linear().data(), ptr, count * sizeof(effects::velocity_sample));
-        ptr += count * sizeof(effects::velocity_sample);
-    }
-    if (has_effect_lifetime) {
-        auto lifetime = chunk.effect_lifetime();
-        std::memcpy(lifetime.linear().data(), ptr, count * sizeof(float));
-        ptr += count * sizeof(float);
-    }
-
-    chunk.mark_dirty(false);
-    return chunk;
+    return detail::decode_chunk_body(header_v2, [&ptr](void* destination, std::size_t size) {
+        std::memcpy(destination, ptr, size);
+        ptr += size;
+    });
 }
 
 inline bool is_legacy_chunk_payload(std::span<const std::byte> bytes) {
@@ -341,36 +416,18 @@ inline chunk_storage deserialize_chunk_from_stream(std::istream& in) {
     std::memcpy(&header_v2, &header_v1, sizeof(header_v1));
     header_v2.version = header_v1.version;
     header_v2.channel_flags = flags;
-
-    const chunk_extent extent{header_v2.extent[0], header_v2.extent[1], header_v2.extent[2]};
-    const auto count = extent.volume();
-    std::size_t payload_bytes = count * (sizeof(voxel_id) + 3);
-    if (flags & chunk_channel_materials) {
-        payload_bytes += count * sizeof(material_index);
-    }
-    if (flags & chunk_channel_skylight_cache) {
-        payload_bytes += count * sizeof(float);
-    }
-    if (flags & chunk_channel_blocklight_cache) {
-        payload_bytes += count * sizeof(float);
-    }
-    if (flags & chunk_channel_effect_density) {
-        payload_bytes += count * sizeof(float);
-    }
-    if (flags & chunk_channel_effect_velocity) {
-        payload_bytes += count * sizeof(effects::velocity_sample);
-    }
-    if (flags & chunk_channel_effect_lifetime) {
-        payload_bytes += count * sizeof(float);
+    if (header_v2.version < 2) {
+        throw std::runtime_error("unsupported chunk version");
     }
+    detail::reject_delta_payload(header_v2);
 
-    std::vector<std::byte> payload(sizeof(chunk_header_v2) + payload_bytes);
-    std::memcpy(payload.data(), &header_v2, sizeof(header_v2));
-    in.read(reinterpret_cast<char*>(payload.data() + sizeof(header_v2)), static_cast<std::streamsize>(payload_bytes));
-    if (!in) {
-        throw std::runtime_error("unable to read chunk payload");
-    }
-    return deserialize_chunk(payload);
+    // Planes stream straight into the chunk instead of being staged in a temporary payload.
+    return detail::decode_chunk_body(header_v2, [&in](void* destination, std::size_t size) {
+        in.read(static_cast<char*>(destination), static_cast<std::streamsize>(size));
+        if (!in) {
+            throw std::runtime_error("unable to read chunk payload");
+        }
+    });
 }
 
 inline region_blob serialize_snapshot(const region_manager::region_snapshot& snapshot) {
@@ -397,44 +454,547 @@ void dump_region(const region_manager& manager, Sink&& sink, bool include_clean
     }
 }
 
-inline auto file_sink(const std::filesystem::path& path) {
-    return [path](const region_blob& blob) {
+// Region streams are sequences of checked records: a 32-byte region_record_header followed by the payload. The header
+// carries a check of its own fields, so a damaged size is caught before anything is allocated, and an XXH64 of the
+// payload. Streams written before checksums were added hold bare (key, u32 size, payload) records; readers still
+// accept them, unverified.
+constexpr std::array<char, 4> region_record_magic{'A', 'V', 'R', 'B'};
+
+struct region_record_header {
+    char magic[4]{region_record_magic[0], region_record_magic[1], region_record_magic[2], region_record_magic[3]};
+    region_key key{};
+    std::uint32_t size{0};
+    std::uint32_t header_check{0};
+    std::uint64_t payload_check{0};
+};
+
+static_assert(sizeof(region_record_header) == 32, "region record header must stay 32 bytes");
+
+enum class region_record_status {
+    ok,
+    // Clean end of stream before the first byte of a record.
+    end,
+    // The stream ended inside a record, as after a crash mid-append.
+    truncated,
+    // A header or payload failed its checksum.
+    corrupt,
+};
+
+namespace detail {
+
+inline std::uint32_t record_header_check(const region_record_header& header) {
+    const auto covered = std::as_bytes(std::span{&header, 1}).first(offsetof(region_record_header, header_check));
+    return static_cast<std::uint32_t>(xxhash64(covered));
+}
+
+inline region_record_header make_record_header(const region_blob& blob) {
+    region_record_header header{};
+    header.key = blob.key;
+    header.size = static_cast<std::uint32_t>(blob.payload.size());
+    header.header_check = record_header_check(header);
+    header.payload_check = xxhash64(blob.payload);
+    return header;
+}
+
+inline bool has_record_magic(const void* bytes) {
+    return std::memcmp(bytes, region_record_magic.data(), region_record_magic.size()) == 0;
+}
+
+inline bool record_header_valid(const region_record_header& header) {
+    return has_record_magic(header.magic) && header.header_check == record_header_check(header);
+}
+
+} // namespace detail
+
+// Writes checked region records to one file through a single handle, so a world save never reopens the file per
+// chunk. Small records (uniform chunks, packed payloads, deltas) are staged in a buffer and written in large sequential
+// blocks; payloads of `direct_write_bytes` or more are written straight from the blob to avoid a second copy. write()
+// may be called from several threads; records from one call are never interleaved.
+//
+// Append mode journals: records land after the existing ones, a crash can only tear the tail record, and commit()
+// syncs what has been written. Otherwise the file is rebuilt in `<path>.tmp` and commit() atomically renames it over
+// `path`, so readers see either the previous save or the complete new one. The destructor commits unless it runs
+// during stack unwinding, in which case a rebuilt file is discarded.
+class region_writer {
+public:
+    static constexpr std::size_t default_buffer_bytes = 1u << 20u;
+    static constexpr std::size_t direct_write_bytes = 64u << 10u;
+
+    explicit region_writer(const std::filesystem::path& path, bool append = true,
+        std::size_t buffer_bytes = default_buffer_bytes);
+    region_writer(const region_writer&) = delete;
+    region_writer& operator=(const region_writer&) = delete;
+    ~region_writer();
+
+    void write(const region_blob& blob);
+    // Hands staged records to the OS without syncing or, for a rebuilt file, publishing them.
+    void flush();
+    void commit();
+
+    [[nodiscard]] std::uint64_t bytes_written() const;
+
+private:
+    void drain_locked();
+
+    std::filesystem::path path_{};
+    // Empty in append mode.
+    std::filesystem::path temporary_{};
+    std::ofstream out_;
+    std::vector<std::byte> buffer_{};
+    std::size_t capacity_{0};
+    std::uint64_t written_{0};
+    bool committed_{false};
+    int uncaught_{std::uncaught_exceptions()};
+    mutable std::mutex mutex_{};
+};
+
+inline region_writer::region_writer(const std::filesystem::path& path, bool append, std::size_t buffer_bytes)
+    : path_{path}
+    , capacity_{std::max<std::size_t>(buffer_bytes, 4096)} {
+    if (path.has_parent_path()) {
         std::filesystem::create_directories(path.parent_path());
-        std::ofstream out(path, std::ios::binary | std::ios::app);
-        if (!out) {
-            throw std::runtime_error("failed to open region file");
+    }
+    if (!append) {
+        temporary_ = path;
+        temporary_ += ".tmp";
+    }
+    out_.open(append ? path_ : temporary_, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    if (!out_) {
+        throw std::runtime_error("failed to open region file");
+    }
+    buffer_.reserve(capacity_);
+}
+
+inline region_writer::~region_writer() {
+    try {
+        if (temporary_.empty()) {
+            flush();
+        } else if (!committed_ && std::uncaught_exceptions() > uncaught_) {
+            out_.close();
+            std::error_code ignored;
+            std::filesystem::remove(temporary_, ignored);
+        } else if (!committed_) {
+            commit();
         }
-        out.write(reinterpret_cast<const char*>(&blob.key), sizeof(blob.key));
-        const std::uint32_t size = static_cast<std::uint32_t>(blob.payload.size());
-        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
-        out.write(reinterpret_cast<const char*>(blob.payload.data()), static_cast<std::streamsize>(blob.payload.size()));
-    };
+    } catch (...) {
+        // Destructors must not throw; call commit() explicitly to observe write errors.
+    }
+}
+
+inline void region_writer::write(const region_blob& blob) {
+    const auto header = detail::make_record_header(blob);
+    const std::size_t record = sizeof(header) + blob.payload.size();
+    std::scoped_lock lock{mutex_};
+    if (committed_) {
+        throw std::logic_error("region writer already committed");
+    }
+    if (buffer_.size() + record > capacity_) {
+        drain_locked();
+    }
+    append_bytes(buffer_, &header, sizeof(header));
+    if (blob.payload.size() >= direct_write_bytes || record > capacity_) {
+        drain_locked();
+        out_.write(reinterpret_cast<const char*>(blob.payload.data()), static_cast<std::streamsize>(header.size));
+        written_ += header.size;
+    } else {
+        append_bytes(buffer_, blob.payload.data(), blob.payload.size());
+    }
+    if (!out_) {
+        throw std::runtime_error("failed to write region file");
+    }
+}
+
+inline void region_writer::flush() {
+    std::scoped_lock lock{mutex_};
+    if (committed_) {
+        return;
+    }
+    drain_locked();
+    out_.flush();
+    if (!out_) {
+        throw std::runtime_error("failed to write region file");
+    }
+}
+
+inline void region_writer::commit() {
+    std::scoped_lock lock{mutex_};
+    if (committed_) {
+        return;
+    }
+    drain_locked();
+    out_.flush();
+    if (!out_) {
+        throw std::runtime_error("failed to write region file");
+    }
+    if (temporary_.empty()) {
+        sync_file(path_);
+        return;
+    }
+    out_.close();
+    commit_file(temporary_, path_);
+    committed_ = true;
+}
+
+inline std::uint64_t region_writer::bytes_written() const {
+    std::scoped_lock lock{mutex_};
+    return written_ + buffer_.size();
+}
+
+inline void region_writer::drain_locked() {
+    if (buffer_.empty()) {
+        return;
+    }
+    out_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    written_ += buffer_.size();
+    buffer_.clear();
+    if (!out_) {
+        throw std::runtime_error("failed to write region file");
+    }
+}
+
+// Appends blobs to `path` through one shared region_writer. Copies of the sink share the handle; the file is flushed
+// when the last copy is destroyed.
+inline auto file_sink(const std::filesystem::path& path) {
+    auto writer = std::make_shared<region_writer>(path);
+    return [writer](const region_blob& blob) { writer->write(blob); };
+}
+
+// Reads the next record into `blob`. On anything but ok, `blob` is unspecified and the stream position is undefined.
+inline region_record_status read_region_record(std::istream& in, region_blob& blob) {
+    region_record_header header{};
+    auto* raw = reinterpret_cast<char*>(&header);
+    in.read(raw, sizeof(header.magic));
+    if (in.gcount() == 0) {
+        return region_record_status::end;
+    }
+    if (!in) {
+        return region_record_status::truncated;
+    }
+    const bool checked = detail::has_record_magic(header.magic);
+    if (checked) {
+        in.read(raw + sizeof(header.magic), sizeof(header) - sizeof(header.magic));
+        if (!in) {
+            return region_record_status::truncated;
+        }
+        if (!detail::record_header_valid(header)) {
+            return region_record_status::corrupt;
+        }
+        blob.key = header.key;
+    } else {
+        // Legacy record: the four bytes already read are key.x.
+        std::memcpy(&blob.key.x, header.magic, sizeof(blob.key.x));
+        in.read(reinterpret_cast<char*>(&blob.key.y), sizeof(blob.key.y));
+        in.read(reinterpret_cast<char*>(&blob.key.z), sizeof(blob.key.z));
+        in.read(reinterpret_cast<char*>(&header.size), sizeof(header.size));
+        if (!in) {
+            return region_record_status::truncated;
+        }
+    }
+    blob.payload.resize(header.size);
+    in.read(reinterpret_cast<char*>(blob.payload.data()), static_cast<std::streamsize>(header.size));
+    if (!in) {
+        return region_record_status::truncated;
+    }
+    if (checked && xxhash64(blob.payload) != header.payload_check) {
+        return region_record_status::corrupt;
+    }
+    return region_record_status::ok;
 }
 
+// Returns std::nullopt at a clean end of stream and throws std::runtime_error on a truncated or corrupt record; use
+// salvage_region_file() to recover what a damaged stream still holds.
 inline std::optional<region_blob> read_region_blob(std::istream& in) {
     region_blob blob;
-    in.read(reinterpret_cast<char*>(&blob.key), sizeof(blob.key));
-    if (!in) {
+    switch (read_region_record(in, blob)) {
+    case region_record_status::ok:
+        return blob;
+    case region_record_status::end:
         return std::nullopt;
+    case region_record_status::truncated:
+        throw std::runtime_error("truncated region record");
+    case region_record_status::corrupt:
+        break;
     }
-    std::uint32_t size = 0;
-    in.read(reinterpret_cast<char*>(&size), sizeof(size));
+    throw std::runtime_error("corrupt region record");
+}
+
+struct region_salvage_report {
+    // Last intact copy of every key, in the order keys first appear.
+    std::vector<region_blob> blobs;
+    std::size_t records{0};
+    // Damaged spans skipped while resynchronising on the record magic, and their total size.
+    std::size_t damaged{0};
+    std::size_t skipped_bytes{0};
+};
+
+// Scans checked records, skipping damage by resynchronising on the next record magic, so an append-mode journal that
+// was torn mid-write or bit-rotted still yields the latest good copy of every chunk. Legacy records cannot be verified
+// and are skipped as damage.
+inline region_salvage_report salvage_region_blobs(std::span<const std::byte> bytes) {
+    region_salvage_report report;
+    std::unordered_map<region_key, std::size_t, region_key_hash> positions;
+    std::size_t offset = 0;
+    bool damaged = false;
+    while (offset < bytes.size()) {
+        const auto remaining = bytes.size() - offset;
+        region_record_header header{};
+        if (remaining >= sizeof(header)) {
+            std::memcpy(&header, bytes.data() + offset, sizeof(header));
+        }
+        if (remaining >= sizeof(header) && detail::record_header_valid(header)
+            && header.size <= remaining - sizeof(header)) {
+            const auto payload = bytes.subspan(offset + sizeof(header), header.size);
+            if (xxhash64(payload) == header.payload_check) {
+                region_blob blob{header.key, std::vector<std::byte>(payload.begin(), payload.end())};
+                const auto [it, inserted] = positions.try_emplace(blob.key, report.blobs.size());
+                if (inserted) {
+                    report.blobs.push_back(std::move(blob));
+                } else {
+                    report.blobs[it->second] = std::move(blob);
+                }
+                ++report.records;
+                offset += sizeof(header) + header.size;
+                damaged = false;
+                continue;
+            }
+        }
+
+        const auto* next = std::search(bytes.data() + offset + 1, bytes.data() + bytes.size(),
+            reinterpret_cast<const std::byte*>(region_record_magic.data()),
+            reinterpret_cast<const std::byte*>(region_record_magic.data()) + region_record_magic.size());
+        const auto skipped = static_cast<std::size_t>(next - (bytes.data() + offset));
+        report.skipped_bytes += skipped;
+        report.damaged += damaged ? 0 : 1;
+        damaged = true;
+        offset += skipped;
+    }
+    return report;
+}
+
+inline region_salvage_report salvage_region_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
     if (!in) {
-        return std::nullopt;
+        throw std::runtime_error("failed to open region file");
     }
-    blob.payload.resize(size);
-    in.read(reinterpret_cast<char*>(blob.payload.data()), static_cast<std::streamsize>(size));
+    std::vector<std::byte> bytes(static_cast<std::size_t>(std::filesystem::file_size(path)));
+    in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
     if (!in) {
-        return std::nullopt;
+        throw std::runtime_error("failed to read region file");
     }
-    return blob;
+    return salvage_region_blobs(bytes);
+}
+
+// Salvages `path` and atomically rewrites it with only the surviving records.
+inline region_salvage_report repair_region_file(const std::filesystem::path& path) {
+    auto report = salvage_region_file(path);
+    region_writer writer{path, false};
+    for (const auto& blob : report.blobs) {
+        writer.write(blob);
+    }
+    writer.commit();
+    return report;
+}
+
+// Packed payloads wrap a serialized chunk in a codec stream: magic, codec id byte, u32 raw size, encoded bytes.
+constexpr std::array<char, 4> packed_chunk_magic{'A', 'V', 'C', 'Z'};
+inline constexpr std::size_t packed_chunk_header = 9;
+
+inline bool is_packed_chunk_payload(std::span<const std::byte> bytes) {
+    return bytes.size() >= packed_chunk_header
+        && std::memcmp(bytes.data(), packed_chunk_magic.data(), packed_chunk_magic.size()) == 0;
+}
+
+inline std::vector<std::byte> pack_chunk_payload(std::span<const std::byte> payload, codec_id codec) {
+    std::vector<std::byte> packed;
+    append_bytes(packed, packed_chunk_magic.data(), packed_chunk_magic.size());
+    packed.push_back(std::byte{0});
+    const auto size = static_cast<std::uint32_t>(payload.size());
+    append_bytes(packed, &size, sizeof(size));
+    const auto used = codec_registry::shared().encode(codec, payload, 1, packed);
+    packed[packed_chunk_magic.size()] = static_cast<std::byte>(used);
+    return packed;
+}
+
+inline std::vector<std::byte> unpack_chunk_payload(std::span<const std::byte> bytes) {
+    if (!is_packed_chunk_payload(bytes)) {
+        throw std::runtime_error("payload is not a packed chunk");
+    }
+    const auto codec = static_cast<codec_id>(std::to_integer<std::uint8_t>(bytes[packed_chunk_magic.size()]));
+    std::uint32_t size = 0;
+    std::memcpy(&size, bytes.data() + packed_chunk_magic.size() + 1, sizeof(size));
+    std::vector<std::byte> payload(size);
+    codec_registry::shared().decode(codec, bytes.subspan(packed_chunk_header), payload, 1);
+    return payload;
+}
+
+// Accepts plain and packed chunk payloads.
+inline chunk_storage deserialize_region_payload(std::span<const std::byte> bytes) {
+    if (is_packed_chunk_payload(bytes)) {
+        return deserialize_chunk(unpack_chunk_payload(bytes));
+    }
+    return deserialize_chunk(bytes);
 }
 
 inline void ingest_blob(region_manager& manager, const region_blob& blob) {
-    chunk_storage chunk = deserialize_chunk(blob.payload);
-    auto& target = manager.assure(blob.key);
-    target = std::move(chunk);
+    auto& target = manager.replace(blob.key, deserialize_region_payload(blob.payload));
     target.mark_dirty(false);
 }
 
+struct batch_io_options {
+    // Chunks serialized or decoded per batch. The next batch runs on the pool while the caller writes or installs the
+    // previous one, so at most two batches are held in memory.
+    std::size_t batch_size{16};
+    // Codec applied to each serialized chunk; `raw` writes plain payloads.
+    codec_id codec{codec_id::raw};
+    bool include_clean{false};
+};
+
+namespace detail {
+
+template <typename Result>
+struct io_batch {
+    explicit io_batch(std::size_t count) : results(count), errors(count), pending{count} {}
+
+    void finish_one() {
+        std::scoped_lock lock{mutex};
+        if (--pending == 0) {
+            finished.notify_all();
+        }
+    }
+
+    void wait() {
+        std::unique_lock lock{mutex};
+        finished.wait(lock, [this] { return pending == 0; });
+    }
+
+    std::vector<Result> results;
+    std::vector<std::exception_ptr> errors;
+    std::size_t pending{0};
+    std::mutex mutex{};
+    std::condition_variable finished{};
+};
+
+// Runs produce(i) for i in [0, count) on the pool, one job per item. Pool jobs must not throw, so failures are kept
+// per item and rethrown by finish_batch().
+template <typename Result, typename Produce>
+std::unique_ptr<io_batch<Result>> launch_batch(parallel::task_pool& pool, std::size_t count, Produce produce) {
+    auto batch = std::make_unique<io_batch<Result>>(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        pool.submit([state = batch.get(), i, produce] {
+            try {
+                state->results[i] = produce(i);
+            } catch (...) {
+                state->errors[i] = std::current_exception();
+            }
+            state->finish_one();
+        });
+    }
+    return batch;
+}
+
+template <typename Result>
+std::vector<Result>& finish_batch(io_batch<Result>& batch) {
+    batch.wait();
+    for (const auto& error : batch.errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return batch.results;
+}
+
+// Waits for an in-flight batch before an exception unwinds past the state its jobs reference.
+template <typename Result>
+struct batch_join {
+    std::unique_ptr<io_batch<Result>>& batch;
+    ~batch_join() {
+        if (batch) {
+            batch->wait();
+        }
+    }
+};
+
+} // namespace detail
+
+// Serializes every dirty (or, with include_clean, every) resident chunk on `pool` and hands the blobs to `sink` on the
+// calling thread in snapshot order. Chunks are copy-on-write snapshots, so editing may continue meanwhile. Must not be
+// called from one of the pool's workers. Returns the number of blobs written.
+template <typename BlobSink>
+std::size_t dump_region_parallel(const region_manager& manager, parallel::task_pool& pool, BlobSink&& sink,
+    const batch_io_options& options = {}) {
+    const auto snapshots = manager.snapshot_loaded(options.include_clean);
+    const auto batch_size = std::max<std::size_t>(options.batch_size, 1);
+    const auto codec = options.codec;
+    const auto launch = [&](std::size_t begin) {
+        const auto* first = snapshots.data() + begin;
+        return detail::launch_batch<region_blob>(pool, std::min(batch_size, snapshots.size() - begin),
+            [first, codec](std::size_t i) {
+                auto blob = serialize_snapshot(first[i]);
+                if (codec != codec_id::raw) {
+                    blob.payload = pack_chunk_payload(blob.payload, codec);
+                }
+                return blob;
+            });
+    };
+
+    std::unique_ptr<detail::io_batch<region_blob>> next;
+    const detail::batch_join<region_blob> join{next};
+    for (std::size_t begin = 0; begin < snapshots.size(); begin += batch_size) {
+        auto current = next ? std::move(next) : launch(begin);
+        if (begin + batch_size < snapshots.size()) {
+            next = launch(begin + batch_size);
+        }
+        for (const auto& blob : detail::finish_batch(*current)) {
+            sink(blob);
+        }
+    }
+    return snapshots.size();
+}
+
+// Reads blobs from `in` in batches, decodes each batch on `pool` while the next one is read, and installs the chunks
+// on the calling thread in file order, so later records for a key win. Must be called from the region manager's owner
+// thread and not from one of the pool's workers. Returns the number of chunks ingested.
+inline std::size_t ingest_parallel(region_manager& manager, parallel::task_pool& pool, std::istream& in,
+    const batch_io_options& options = {}) {
+    const auto batch_size = std::max<std::size_t>(options.batch_size, 1);
+    struct decoded {
+        region_key key{};
+        std::optional<chunk_storage> chunk;
+    };
+    const auto read_batch = [&] {
+        std::vector<region_blob> blobs;
+        blobs.reserve(batch_size);
+        while (blobs.size() < batch_size) {
+            auto blob = read_region_blob(in);
+            if (!blob) {
+                break;
+            }
+            blobs.push_back(std::move(*blob));
+        }
+        return blobs;
+    };
+    const auto launch = [&](const std::vector<region_blob>& blobs) {
+        const auto* first = blobs.data();
+        return detail::launch_batch<decoded>(pool, blobs.size(), [first](std::size_t i) {
+            return decoded{first[i].key, deserialize_region_payload(first[i].payload)};
+        });
+    };
+
+    std::size_t ingested = 0;
+    auto blobs = read_batch();
+    std::unique_ptr<detail::io_batch<decoded>> current;
+    const detail::batch_join<decoded> join{current};
+    while (!blobs.empty()) {
+        current = launch(blobs);
+        auto upcoming = read_batch();
+        for (auto& item : detail::finish_batch(*current)) {
+            manager.replace(item.key, std::move(*item.chunk)).mark_dirty(false);
+            ++ingested;
+        }
+        current.reset();
+        blobs = std::move(upcoming);
+    }
+    return ingested;
+}
+
 } // namespace almond::voxel::serialization
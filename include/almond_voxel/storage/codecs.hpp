@@ -0,0 +1,527 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace almond::voxel {
+
+// Identifies a plane codec inside compressed chunk blobs. Values 0-63 are reserved for built-ins; applications may
+// register their own codecs under any other id except `automatic`, which only selects the smallest built-in output.
+enum class codec_id : std::uint8_t {
+    raw = 0,
+    rle = 1,
+    delta_bitpack = 2,
+    lz = 3,
+    automatic = 0xFF
+};
+
+inline constexpr std::uint8_t first_custom_codec_id = 64;
+
+// Stateless plane codec. `element_size` is the size of one plane cell in bytes; encoders append to `out` and decoders
+// must fill `output` exactly or throw std::runtime_error.
+struct codec {
+    using encode_function = void (*)(std::span<const std::byte> input, std::size_t element_size,
+        std::vector<std::byte>& out);
+    using decode_function = void (*)(std::span<const std::byte> input, std::span<std::byte> output,
+        std::size_t element_size);
+
+    std::string_view name{};
+    encode_function encode{nullptr};
+    decode_function decode{nullptr};
+
+    [[nodiscard]] explicit operator bool() const noexcept { return encode != nullptr && decode != nullptr; }
+};
+
+namespace detail::codecs {
+
+inline void put_varint(std::vector<std::byte>& out, std::uint64_t value) {
+    while (value >= 0x80u) {
+        out.push_back(static_cast<std::byte>((value & 0x7Fu) | 0x80u));
+        value >>= 7u;
+    }
+    out.push_back(static_cast<std::byte>(value));
+}
+
+inline std::uint64_t get_varint(std::span<const std::byte> input, std::size_t& offset) {
+    std::uint64_t value = 0;
+    for (std::uint32_t shift = 0; shift < 64; shift += 7) {
+        if (offset >= input.size()) {
+            throw std::runtime_error("truncated codec stream");
+        }
+        const auto byte = std::to_integer<std::uint64_t>(input[offset++]);
+        value |= (byte & 0x7Fu) << shift;
+        if ((byte & 0x80u) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("malformed codec varint");
+}
+
+inline void check_elements(std::size_t bytes, std::size_t element_size) {
+    if (element_size == 0 || bytes % element_size != 0) {
+        throw std::logic_error("codec input is not a whole number of elements");
+    }
+}
+
+// Extends the `period` bytes at `data` until `total` bytes repeat them, doubling each copy so long runs stay cheap.
+inline void repeat_pattern(std::byte* data, std::size_t period, std::size_t total) noexcept {
+    std::size_t filled = period;
+    while (filled < total) {
+        const auto chunk = std::min(filled - filled % period, total - filled);
+        std::memcpy(data + filled, data, chunk);
+        filled += chunk;
+    }
+}
+
+inline void encode_raw(std::span<const std::byte> input, std::size_t, std::vector<std::byte>& out) {
+    out.insert(out.end(), input.begin(), input.end());
+}
+
+inline void decode_raw(std::span<const std::byte> input, std::span<std::byte> output, std::size_t) {
+    if (input.size() != output.size()) {
+        throw std::runtime_error("raw codec size mismatch");
+    }
+    std::copy(input.begin(), input.end(), output.begin());
+}
+
+// Runs of identical cells: varint run length followed by one cell. The cell compare is instantiated for the common
+// plane widths so the scan stays a plain load-and-compare.
+template <std::size_t Size>
+std::size_t rle_run_end(std::span<const std::byte> input, std::size_t offset, std::size_t element_size) noexcept {
+    const auto size = Size == 0 ? element_size : Size;
+    const auto* cell = input.data() + offset;
+    auto end = offset + size;
+    while (end < input.size() && std::memcmp(input.data() + end, cell, Size == 0 ? element_size : Size) == 0) {
+        end += size;
+    }
+    return end;
+}
+
+inline void encode_rle(std::span<const std::byte> input, std::size_t element_size, std::vector<std::byte>& out) {
+    check_elements(input.size(), element_size);
+    std::size_t offset = 0;
+    while (offset < input.size()) {
+        std::size_t end = 0;
+        switch (element_size) {
+        case 1:
+            end = rle_run_end<1>(input, offset, element_size);
+            break;
+        case 2:
+            end = rle_run_end<2>(input, offset, element_size);
+            break;
+        case 4:
+            end = rle_run_end<4>(input, offset, element_size);
+            break;
+        default:
+            end = rle_run_end<0>(input, offset, element_size);
+            break;
+        }
+        put_varint(out, (end - offset) / element_size);
+        out.insert(out.end(), input.begin() + static_cast<std::ptrdiff_t>(offset),
+            input.begin() + static_cast<std::ptrdiff_t>(offset + element_size));
+        offset = end;
+    }
+}
+
+inline void decode_rle(std::span<const std::byte> input, std::span<std::byte> output, std::size_t element_size) {
+    check_elements(output.size(), element_size);
+    std::size_t in = 0;
+    std::size_t out = 0;
+    while (in < input.size()) {
+        const auto run = get_varint(input, in);
+        if (run == 0 || input.size() - in < element_size || run > (output.size() - out) / element_size) {
+            throw std::runtime_error("malformed rle run");
+        }
+        std::memcpy(output.data() + out, input.data() + in, element_size);
+        in += element_size;
+        repeat_pattern(output.data() + out, element_size, static_cast<std::size_t>(run) * element_size);
+        out += static_cast<std::size_t>(run) * element_size;
+    }
+    if (out != output.size()) {
+        throw std::runtime_error("rle stream shorter than plane");
+    }
+}
+
+// Delta + bit-packing works on 1, 2 or 4 byte words. Multi-word cells (velocity samples) are split into lanes so each
+// word is predicted from the same lane of the previous cell.
+struct word_layout {
+    std::size_t width{1};
+    std::size_t lag{1};
+};
+
+inline word_layout layout_for(std::size_t element_size) noexcept {
+    if (element_size == 1 || element_size == 2 || element_size == 4) {
+        return {element_size, 1};
+    }
+    if (element_size % 4 == 0) {
+        return {4, element_size / 4};
+    }
+    if (element_size % 2 == 0) {
+        return {2, element_size / 2};
+    }
+    return {1, element_size};
+}
+
+inline constexpr std::size_t bitpack_block = 64;
+
+template <typename Word>
+void encode_delta_words(std::span<const std::byte> input, std::size_t lag, std::vector<std::byte>& out) {
+    constexpr std::uint32_t sign_shift = sizeof(Word) * 8 - 1;
+    const auto count = input.size() / sizeof(Word);
+    std::array<Word, bitpack_block> block{};
+    for (std::size_t base = 0; base < count; base += bitpack_block) {
+        const auto size = std::min(bitpack_block, count - base);
+        Word combined = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            const auto index = base + i;
+            Word current{};
+            Word previous{};
+            std::memcpy(&current, input.data() + index * sizeof(Word), sizeof(Word));
+            if (index >= lag) {
+                std::memcpy(&previous, input.data() + (index - lag) * sizeof(Word), sizeof(Word));
+            }
+            const auto delta = static_cast<Word>(current - previous);
+            const auto zigzag = static_cast<Word>(static_cast<Word>(delta << 1u) ^ static_cast<Word>(0u - (delta >> sign_shift)));
+            block[i] = zigzag;
+            combined = static_cast<Word>(combined | zigzag);
+        }
+        const auto bits = static_cast<std::uint32_t>(std::bit_width(combined));
+        out.push_back(static_cast<std::byte>(bits));
+        std::uint64_t accumulator = 0;
+        std::uint32_t pending = 0;
+        for (std::size_t i = 0; i < size && bits != 0; ++i) {
+            accumulator |= static_cast<std::uint64_t>(block[i]) << pending;
+            pending += bits;
+            while (pending >= 8) {
+                out.push_back(static_cast<std::byte>(accumulator & 0xFFu));
+                accumulator >>= 8u;
+                pending -= 8;
+            }
+        }
+        if (pending != 0) {
+            out.push_back(static_cast<std::byte>(accumulator & 0xFFu));
+        }
+    }
+}
+
+template <typename Word>
+void decode_delta_words(std::span<const std::byte> input, std::span<std::byte> output, std::size_t lag) {
+    const auto count = output.size() / sizeof(Word);
+    std::size_t in = 0;
+    for (std::size_t base = 0; base < count; base += bitpack_block) {
+        const auto size = std::min(bitpack_block, count - base);
+        if (in >= input.size()) {
+            throw std::runtime_error("truncated bitpack stream");
+        }
+        const auto bits = std::to_integer<std::uint32_t>(input[in++]);
+        if (bits > sizeof(Word) * 8) {
+            throw std::runtime_error("malformed bitpack width");
+        }
+        if (input.size() - in < (size * bits + 7) / 8) {
+            throw std::runtime_error("truncated bitpack stream");
+        }
+        const std::uint64_t value_mask = bits == 0 ? 0u : (std::uint64_t{1} << bits) - 1u;
+        std::uint64_t accumulator = 0;
+        std::uint32_t available = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            while (available < bits) {
+                accumulator |= std::to_integer<std::uint64_t>(input[in++]) << available;
+                available += 8;
+            }
+            const auto zigzag = static_cast<Word>(accumulator & value_mask);
+            accumulator >>= bits;
+            available -= bits;
+
+            const auto index = base + i;
+            const auto delta = static_cast<Word>((zigzag >> 1u) ^ static_cast<Word>(0u - (zigzag & 1u)));
+            Word previous{};
+            if (index >= lag) {
+                std::memcpy(&previous, output.data() + (index - lag) * sizeof(Word), sizeof(Word));
+            }
+            const auto current = static_cast<Word>(previous + delta);
+            std::memcpy(output.data() + index * sizeof(Word), &current, sizeof(Word));
+        }
+    }
+    if (in != input.size()) {
+        throw std::runtime_error("trailing bitpack data");
+    }
+}
+
+inline void encode_delta_bitpack(std::span<const std::byte> input, std::size_t element_size,
+    std::vector<std::byte>& out) {
+    check_elements(input.size(), element_size);
+    const auto layout = layout_for(element_size);
+    switch (layout.width) {
+    case 4:
+        encode_delta_words<std::uint32_t>(input, layout.lag, out);
+        break;
+    case 2:
+        encode_delta_words<std::uint16_t>(input, layout.lag, out);
+        break;
+    default:
+        encode_delta_words<std::uint8_t>(input, layout.lag, out);
+        break;
+    }
+}
+
+inline void decode_delta_bitpack(std::span<const std::byte> input, std::span<std::byte> output,
+    std::size_t element_size) {
+    check_elements(output.size(), element_size);
+    const auto layout = layout_for(element_size);
+    switch (layout.width) {
+    case 4:
+        decode_delta_words<std::uint32_t>(input, output, layout.lag);
+        break;
+    case 2:
+        decode_delta_words<std::uint16_t>(input, output, layout.lag);
+        break;
+    default:
+        decode_delta_words<std::uint8_t>(input, output, layout.lag);
+        break;
+    }
+}
+
+// Byte-oriented LZ77 in the LZ4 block layout: token (literal length << 4 | match length - 4), extended lengths as
+// 255-continued bytes, literals, then a 16-bit little-endian offset. The last sequence carries literals only.
+inline constexpr std::size_t lz_min_match = 4;
+inline constexpr std::size_t lz_hash_bits = 12;
+inline constexpr std::size_t lz_max_offset = 0xFFFF;
+
+inline std::uint32_t lz_load(const std::byte* data) noexcept {
+    std::uint32_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline void lz_put_length(std::vector<std::byte>& out, std::size_t length) {
+    while (length >= 255) {
+        out.push_back(std::byte{255});
+        length -= 255;
+    }
+    out.push_back(static_cast<std::byte>(length));
+}
+
+inline void lz_emit(std::vector<std::byte>& out, std::span<const std::byte> literals, std::size_t offset,
+    std::size_t match) {
+    const auto literal_code = std::min<std::size_t>(literals.size(), 15);
+    const auto match_code = match == 0 ? 0 : std::min<std::size_t>(match - lz_min_match, 15);
+    out.push_back(static_cast<std::byte>((literal_code << 4u) | match_code));
+    if (literal_code == 15) {
+        lz_put_length(out, literals.size() - 15);
+    }
+    out.insert(out.end(), literals.begin(), literals.end());
+    if (match == 0) {
+        return;
+    }
+    out.push_back(static_cast<std::byte>(offset & 0xFFu));
+    out.push_back(static_cast<std::byte>(offset >> 8u));
+    if (match_code == 15) {
+        lz_put_length(out, match - lz_min_match - 15);
+    }
+}
+
+inline void encode_lz(std::span<const std::byte> input, std::size_t, std::vector<std::byte>& out) {
+    const auto size = input.size();
+    const auto* data = input.data();
+    std::size_t anchor = 0;
+    // Matches never start in the last 12 bytes and never cover the last 5, mirroring LZ4's end-of-block rules.
+    if (size >= 13) {
+        std::vector<std::uint32_t> table(std::size_t{1} << lz_hash_bits, 0);
+        const auto start_limit = size - 12;
+        const auto match_limit = size - 5;
+        std::size_t position = 0;
+        while (position < start_limit) {
+            const auto sequence = lz_load(data + position);
+            const auto hash = (sequence * 2654435761u) >> (32u - lz_hash_bits);
+            const auto candidate = static_cast<std::size_t>(table[hash]);
+            table[hash] = static_cast<std::uint32_t>(position + 1);
+            if (candidate != 0 && position - (candidate - 1) <= lz_max_offset
+                && lz_load(data + candidate - 1) == sequence) {
+                const auto source = candidate - 1;
+                auto length = lz_min_match;
+                while (position + length < match_limit && data[source + length] == data[position + length]) {
+                    ++length;
+                }
+                lz_emit(out, input.subspan(anchor, position - anchor), position - source, length);
+                position += length;
+                anchor = position;
+                continue;
+            }
+            // Skip faster through incompressible stretches.
+            position += 1 + ((position - anchor) >> 6u);
+        }
+    }
+    lz_emit(out, input.subspan(anchor), 0, 0);
+}
+
+inline std::size_t lz_get_length(std::span<const std::byte> input, std::size_t& offset) {
+    std::size_t length = 0;
+    for (;;) {
+        if (offset >= input.size()) {
+            throw std::runtime_error("truncated lz stream");
+        }
+        const auto byte = std::to_integer<std::size_t>(input[offset++]);
+        length += byte;
+        if (byte != 255) {
+            return length;
+        }
+    }
+}
+
+inline void decode_lz(std::span<const std::byte> input, std::span<std::byte> output, std::size_t) {
+    std::size_t in = 0;
+    std::size_t out = 0;
+    while (in < input.size()) {
+        const auto token = std::to_integer<std::size_t>(input[in++]);
+        auto literals = token >> 4u;
+        if (literals == 15) {
+            literals += lz_get_length(input, in);
+        }
+        if (literals > input.size() - in || literals > output.size() - out) {
+            throw std::runtime_error("malformed lz literals");
+        }
+        if (literals > 0) {
+            std::memcpy(output.data() + out, input.data() + in, literals);
+        }
+        in += literals;
+        out += literals;
+        if (in == input.size()) {
+            break;
+        }
+        if (input.size() - in < 2) {
+            throw std::runtime_error("truncated lz stream");
+        }
+        const auto offset = std::to_integer<std::size_t>(input[in]) | (std::to_integer<std::size_t>(input[in + 1]) << 8u);
+        in += 2;
+        auto match = (token & 0x0Fu) + lz_min_match;
+        if ((token & 0x0Fu) == 15) {
+            match += lz_get_length(input, in);
+        }
+        if (offset == 0 || offset > out || match > output.size() - out) {
+            throw std::runtime_error("malformed lz match");
+        }
+        auto* target = output.data() + out;
+        if (offset >= match) {
+            std::memcpy(target, target - offset, match);
+        } else {
+            repeat_pattern(target - offset, offset, offset + match);
+        }
+        out += match;
+    }
+    if (out != output.size()) {
+        throw std::runtime_error("lz stream shorter than plane");
+    }
+}
+
+} // namespace detail::codecs
+
+// Process-wide codec table shared by every chunk. Built-ins are registered on construction; custom codecs are added
+// once at startup and referenced by id from chunk_codec_config, so chunks carry a codec id instead of closures.
+class codec_registry {
+public:
+    codec_registry();
+    codec_registry(const codec_registry&) = delete;
+    codec_registry& operator=(const codec_registry&) = delete;
+
+    [[nodiscard]] static codec_registry& shared();
+
+    void add(codec_id id, codec entry);
+    [[nodiscard]] std::optional<codec> find(codec_id id) const;
+    [[nodiscard]] codec get(codec_id id) const;
+
+    // Appends the encoded plane to `out` and returns the codec actually used. `automatic` tries each built-in and
+    // keeps the smallest stream, falling back to raw when nothing beats it.
+    codec_id encode(codec_id id, std::span<const std::byte> input, std::size_t element_size,
+        std::vector<std::byte>& out) const;
+    void decode(codec_id id, std::span<const std::byte> input, std::span<std::byte> output,
+        std::size_t element_size) const;
+
+private:
+    std::array<codec, 256> codecs_{};
+    mutable std::shared_mutex mutex_{};
+};
+
+inline codec_registry::codec_registry() {
+    using namespace detail::codecs;
+    codecs_[static_cast<std::size_t>(codec_id::raw)] = codec{"raw", &encode_raw, &decode_raw};
+    codecs_[static_cast<std::size_t>(codec_id::rle)] = codec{"rle", &encode_rle, &decode_rle};
+    codecs_[static_cast<std::size_t>(codec_id::delta_bitpack)] =
+        codec{"delta_bitpack", &encode_delta_bitpack, &decode_delta_bitpack};
+    codecs_[static_cast<std::size_t>(codec_id::lz)] = codec{"lz", &encode_lz, &decode_lz};
+}
+
+inline codec_registry& codec_registry::shared() {
+    static codec_registry registry;
+    return registry;
+}
+
+inline void codec_registry::add(codec_id id, codec entry) {
+    if (static_cast<std::uint8_t>(id) < first_custom_codec_id || id == codec_id::automatic) {
+        throw std::logic_error("codec id is reserved");
+    }
+    if (!entry) {
+        throw std::logic_error("codec requires encode and decode functions");
+    }
+    std::unique_lock lock{mutex_};
+    codecs_[static_cast<std::size_t>(id)] = entry;
+}
+
+inline std::optional<codec> codec_registry::find(codec_id id) const {
+    std::shared_lock lock{mutex_};
+    const auto& entry = codecs_[static_cast<std::size_t>(id)];
+    if (!entry) {
+        return std::nullopt;
+    }
+    return entry;
+}
+
+inline codec codec_registry::get(codec_id id) const {
+    auto entry = find(id);
+    if (!entry) {
+        throw std::out_of_range("unknown codec id");
+    }
+    return *entry;
+}
+
+inline codec_id codec_registry::encode(codec_id id, std::span<const std::byte> input, std::size_t element_size,
+    std::vector<std::byte>& out) const {
+    if (id != codec_id::automatic) {
+        get(id).encode(input, element_size, out);
+        return id;
+    }
+    codec_id best = codec_id::raw;
+    std::vector<std::byte> best_stream{};
+    std::vector<std::byte> candidate{};
+    for (const auto option : {codec_id::rle, codec_id::delta_bitpack, codec_id::lz}) {
+        candidate.clear();
+        get(option).encode(input, element_size, candidate);
+        if (candidate.size() < input.size() && (best == codec_id::raw || candidate.size() < best_stream.size())) {
+            best = option;
+            best_stream.swap(candidate);
+        }
+    }
+    if (best == codec_id::raw) {
+        out.insert(out.end(), input.begin(), input.end());
+    } else {
+        out.insert(out.end(), best_stream.begin(), best_stream.end());
+    }
+    return best;
+}
+
+inline void codec_registry::decode(codec_id id, std::span<const std::byte> input, std::span<std::byte> output,
+    std::size_t element_size) const {
+    get(id).decode(input, output, element_size);
+}
+
+} // namespace almond::voxel
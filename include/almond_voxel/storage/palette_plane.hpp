@@ -0,0 +1,247 @@
+#pragma once
+
+#include "almond_voxel/core.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace almond::voxel {
+
+// Palette-compressed voxel plane. Each cell stores an index into a per-plane palette using 0, 1, 2, 4 or 8 bits;
+// once more than 256 distinct ids are present the plane switches to direct 16-bit storage and drops the palette.
+// Index widths always divide 64 so no index straddles a word boundary.
+class palette_plane {
+public:
+    using word_type = std::uint64_t;
+
+    static constexpr std::uint32_t word_bits = 64;
+    static constexpr std::uint32_t max_palette_bits = 8;
+    static constexpr std::uint32_t direct_bits = 16;
+
+    palette_plane() = default;
+    explicit palette_plane(std::size_t count, voxel_id value = voxel_id{});
+
+    [[nodiscard]] static palette_plane from_dense(voxel_cspan<voxel_id> values);
+
+    [[nodiscard]] std::size_t size() const noexcept { return count_; }
+    [[nodiscard]] std::uint32_t bits_per_index() const noexcept { return bits_; }
+    [[nodiscard]] bool direct() const noexcept { return bits_ == direct_bits; }
+    [[nodiscard]] std::span<const voxel_id> palette() const noexcept { return palette_; }
+    [[nodiscard]] std::span<const word_type> words() const noexcept { return words_; }
+
+    [[nodiscard]] voxel_id get(std::size_t index) const noexcept;
+    void set(std::size_t index, voxel_id value);
+    void fill(voxel_id value);
+    void decode(voxel_span<voxel_id> out) const;
+    void compact();
+
+    [[nodiscard]] std::size_t memory_usage() const noexcept {
+        return palette_.capacity() * sizeof(voxel_id) + words_.capacity() * sizeof(word_type);
+    }
+
+private:
+    [[nodiscard]] static std::size_t word_count(std::size_t count, std::uint32_t bits) noexcept;
+    [[nodiscard]] static std::uint32_t bits_for(std::size_t palette_size) noexcept;
+
+    [[nodiscard]] std::uint32_t read_index(std::size_t index) const noexcept;
+    void write_index(std::size_t index, std::uint32_t value) noexcept;
+    [[nodiscard]] std::uint32_t index_of(voxel_id value);
+    void repack(std::uint32_t bits);
+
+    std::size_t count_{0};
+    std::uint32_t bits_{0};
+    std::vector<voxel_id> palette_{};
+    std::vector<word_type> words_{};
+};
+
+inline palette_plane::palette_plane(std::size_t count, voxel_id value)
+    : count_{count}
+    , palette_{value} {
+}
+
+inline palette_plane palette_plane::from_dense(voxel_cspan<voxel_id> values) {
+    palette_plane plane{};
+    plane.count_ = values.size();
+    if (values.empty()) {
+        return plane;
+    }
+
+    std::vector<voxel_id> palette;
+    bool direct = false;
+    voxel_id last = values.front();
+    palette.push_back(last);
+    for (const voxel_id value : values) {
+        if (value == last) {
+            continue;
+        }
+        last = value;
+        if (std::find(palette.begin(), palette.end(), value) == palette.end()) {
+            palette.push_back(value);
+            if (palette.size() > (std::size_t{1} << max_palette_bits)) {
+                direct = true;
+                break;
+            }
+        }
+    }
+
+    if (direct) {
+        plane.bits_ = direct_bits;
+        plane.words_.assign(word_count(plane.count_, direct_bits), word_type{0});
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            plane.write_index(i, values[i]);
+        }
+        return plane;
+    }
+
+    plane.palette_ = std::move(palette);
+    plane.bits_ = bits_for(plane.palette_.size());
+    if (plane.bits_ == 0) {
+        return plane;
+    }
+    plane.words_.assign(word_count(plane.count_, plane.bits_), word_type{0});
+    std::uint32_t last_index = 0;
+    last = plane.palette_.front();
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (values[i] != last) {
+            last = values[i];
+            const auto it = std::find(plane.palette_.begin(), plane.palette_.end(), last);
+            last_index = static_cast<std::uint32_t>(it - plane.palette_.begin());
+        }
+        plane.write_index(i, last_index);
+    }
+    return plane;
+}
+
+inline voxel_id palette_plane::get(std::size_t index) const noexcept {
+    if (direct()) {
+        return static_cast<voxel_id>(read_index(index));
+    }
+    return palette_[read_index(index)];
+}
+
+inline void palette_plane::set(std::size_t index, voxel_id value) {
+    if (index >= count_) {
+        throw std::out_of_range("palette index out of range");
+    }
+    if (direct()) {
+        write_index(index, value);
+        return;
+    }
+    write_index(index, index_of(value));
+}
+
+inline void palette_plane::fill(voxel_id value) {
+    bits_ = 0;
+    palette_.assign(1, value);
+    words_.clear();
+    words_.shrink_to_fit();
+}
+
+inline void palette_plane::decode(voxel_span<voxel_id> out) const {
+    if (out.size() != count_) {
+        throw std::runtime_error("palette decode size mismatch");
+    }
+    if (bits_ == 0) {
+        std::fill(out.begin(), out.end(), palette_.empty() ? voxel_id{} : palette_.front());
+        return;
+    }
+
+    const std::uint32_t per_word = word_bits / bits_;
+    const word_type mask = (word_type{1} << bits_) - 1;
+    std::size_t index = 0;
+    for (const word_type word : words_) {
+        word_type bits = word;
+        for (std::uint32_t slot = 0; slot < per_word && index < count_; ++slot, ++index) {
+            const auto value = static_cast<std::uint32_t>(bits & mask);
+            out[index] = direct() ? static_cast<voxel_id>(value) : palette_[value];
+            bits >>= bits_;
+        }
+    }
+}
+
+inline void palette_plane::compact() {
+    if (count_ == 0) {
+        return;
+    }
+    std::vector<voxel_id> dense(count_);
+    decode(dense);
+    *this = from_dense(dense);
+}
+
+inline std::size_t palette_plane::word_count(std::size_t count, std::uint32_t bits) noexcept {
+    if (bits == 0) {
+        return 0;
+    }
+    const std::size_t per_word = word_bits / bits;
+    return (count + per_word - 1) / per_word;
+}
+
+inline std::uint32_t palette_plane::bits_for(std::size_t palette_size) noexcept {
+    std::uint32_t bits = 0;
+    while ((std::size_t{1} << bits) < palette_size) {
+        bits = bits == 0 ? 1 : bits * 2;
+    }
+    return bits;
+}
+
+inline std::uint32_t palette_plane::read_index(std::size_t index) const noexcept {
+    if (bits_ == 0) {
+        return 0;
+    }
+    const std::uint32_t per_word = word_bits / bits_;
+    const std::size_t word = index / per_word;
+    const std::uint32_t shift = static_cast<std::uint32_t>(index % per_word) * bits_;
+    const word_type mask = (word_type{1} << bits_) - 1;
+    return static_cast<std::uint32_t>((words_[word] >> shift) & mask);
+}
+
+inline void palette_plane::write_index(std::size_t index, std::uint32_t value) noexcept {
+    if (bits_ == 0) {
+        return;
+    }
+    const std::uint32_t per_word = word_bits / bits_;
+    const std::size_t word = index / per_word;
+    const std::uint32_t shift = static_cast<std::uint32_t>(index % per_word) * bits_;
+    const word_type mask = ((word_type{1} << bits_) - 1) << shift;
+    words_[word] = (words_[word] & ~mask) | ((static_cast<word_type>(value) << shift) & mask);
+}
+
+inline std::uint32_t palette_plane::index_of(voxel_id value) {
+    if (const auto it = std::find(palette_.begin(), palette_.end(), value); it != palette_.end()) {
+        return static_cast<std::uint32_t>(it - palette_.begin());
+    }
+
+    if (palette_.size() + 1 > (std::size_t{1} << max_palette_bits)) {
+        repack(direct_bits);
+        return value;
+    }
+
+    palette_.push_back(value);
+    const std::uint32_t required = bits_for(palette_.size());
+    if (required > bits_) {
+        repack(required);
+    }
+    return static_cast<std::uint32_t>(palette_.size() - 1);
+}
+
+inline void palette_plane::repack(std::uint32_t bits) {
+    palette_plane next{};
+    next.count_ = count_;
+    next.bits_ = bits;
+    next.words_.assign(word_count(count_, bits), word_type{0});
+    const bool to_direct = bits == direct_bits;
+    for (std::size_t i = 0; i < count_; ++i) {
+        const std::uint32_t old_index = read_index(i);
+        next.write_index(i, to_direct ? palette_[old_index] : old_index);
+    }
+    if (!to_direct) {
+        next.palette_ = std::move(palette_);
+    }
+    *this = std::move(next);
+}
+
+} // namespace almond::voxel
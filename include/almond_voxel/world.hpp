@@ -2,21 +2,100 @@
 
 #include "almond_voxel/chunk.hpp"
 #include "almond_voxel/navigation/voxel_nav.hpp"
+#include "almond_voxel/parallel/task_pool.hpp"
 #include "almond_voxel/world_fwd.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <deque>
+#include <exception>
 #include <functional>
 #include <limits>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <span>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace almond::voxel {
 
+enum class load_status : std::uint8_t {
+    queued,
+    loading,
+    ready,
+    cancelled,
+    failed
+};
+
+class load_handle;
+
+// Where a region's data currently lives: dense in memory, compressed in memory, or only in the saver's backing store.
+enum class residency_tier : std::uint8_t {
+    hot,
+    warm,
+    cold
+};
+
+// Automatic in-memory compression for resident regions. Idle compression picks unpinned regions that no assure(),
+// request() or task has touched for `idle_ticks` ticks; pressure compression compresses the least recently used
+// regions before any are evicted for exceeding the memory budget. With workers the codecs run on the pool.
+struct compression_policy {
+    std::uint64_t idle_ticks{0};
+    bool compress_under_pressure{false};
+    std::size_t max_per_tick{8};
+    chunk_codec_config codecs{};
+};
+
+namespace detail {
+
+struct load_request {
+    region_key key{};
+    std::atomic<load_status> status{load_status::queued};
+    int priority{0};
+    std::uint64_t sequence{0};
+    std::shared_ptr<chunk_storage> chunk{};
+    std::exception_ptr error{};
+    std::vector<std::function<void(const load_handle&)>> callbacks{};
+};
+
+} // namespace detail
+
+// Shared view of an asynchronous chunk request. Every requester of the same key observes the same handle state.
+class load_handle {
+public:
+    load_handle() = default;
+
+    [[nodiscard]] bool valid() const noexcept { return request_ != nullptr; }
+    [[nodiscard]] region_key key() const noexcept { return request_ ? request_->key : region_key{}; }
+    [[nodiscard]] load_status status() const noexcept {
+        return request_ ? request_->status.load(std::memory_order_acquire) : load_status::cancelled;
+    }
+    [[nodiscard]] bool ready() const noexcept { return status() == load_status::ready; }
+    // Resident chunk once ready, otherwise null.
+    [[nodiscard]] std::shared_ptr<chunk_storage> chunk() const noexcept { return ready() ? request_->chunk : nullptr; }
+    [[nodiscard]] std::exception_ptr error() const noexcept {
+        return status() == load_status::failed ? request_->error : nullptr;
+    }
+
+private:
+    friend class region_manager;
+    explicit load_handle(std::shared_ptr<detail::load_request> request) : request_{std::move(request)} {}
+
+    std::shared_ptr<detail::load_request> request_{};
+};
+
+// Threading model: one owner thread calls the mutating members (assure, request, tick, eviction, pins, policies).
+// Any thread may call find(), tier(), navigation_grid(), for_each_loaded() and snapshot_loaded() concurrently with
+// it, then read the returned chunk under chunk_storage::lock_shared(). Tasks and background compression hold the
+// chunk's exclusive guard, so readers see either the state before or after each task, never a torn one.
+// A task must not lock or replace() its own chunk, nor call snapshot_loaded(); it already owns the guard.
 class region_manager {
 public:
     using chunk_ptr = std::shared_ptr<chunk_storage>;
@@ -25,28 +104,78 @@ public:
     using saver_type = std::function<void(const region_key&, const chunk_storage&)>;
     using task_type = std::function<void(chunk_storage&, const region_key&)>;
     using dirty_observer = std::function<void(const region_key&)>;
+    using dirty_region_observer = std::function<void(const region_key&, const dirty_event&)>;
+    using load_callback = std::function<void(const load_handle&)>;
 
     explicit region_manager(chunk_extent chunk_dimensions = cubic_extent(32));
 
     [[nodiscard]] chunk_extent chunk_dimensions() const noexcept { return chunk_extent_; }
 
+    // Loads synchronously on a miss; never waits for or consumes an outstanding request().
     chunk_storage& assure(const region_key& key);
+    // Queues a background load (deduplicated per key; repeated requests keep the highest priority). Higher priorities
+    // load first. `on_ready` runs on the tick thread once the chunk is resident or the load failed; it never runs for
+    // cancelled requests. Already-resident keys return a ready handle.
+    load_handle request(const region_key& key, int priority = 0, load_callback on_ready = {});
+    // Drops an outstanding request; an in-flight load finishes but its chunk is discarded.
+    bool cancel(const region_key& key);
+    [[nodiscard]] std::size_t pending_loads() const;
+    // Maximum loads in flight on the worker pool, or loads performed per tick() without workers.
+    void set_load_concurrency(std::size_t count);
+    [[nodiscard]] std::size_t load_concurrency() const noexcept { return load_concurrency_; }
+    // Replaces the resident chunk (or inserts one) while keeping dirty tracking attached.
+    chunk_storage& replace(const region_key& key, chunk_storage chunk);
     [[nodiscard]] chunk_ptr find(const region_key& key) const;
 
+    // In worker mode the loader also runs on worker threads for request() and must be thread-safe.
     void set_loader(loader_type loader) { loader_ = std::move(loader); }
     void set_saver(saver_type saver) { saver_ = std::move(saver); }
 
+    // Pinned regions count towards the limit but are never evicted.
     void set_max_resident(std::size_t limit) noexcept;
     [[nodiscard]] std::size_t max_resident() const noexcept { return max_resident_; }
     [[nodiscard]] std::size_t resident() const noexcept { return regions_.size(); }
+    [[nodiscard]] std::size_t pinned_count() const noexcept { return pinned_count_; }
+
+    // Byte budget across resident chunks (0 disables it). Eviction continues until both limits hold.
+    void set_memory_budget(std::size_t bytes);
+    [[nodiscard]] std::size_t memory_budget() const noexcept { return memory_budget_; }
+    [[nodiscard]] std::size_t resident_bytes() const noexcept { return resident_usage_.total(); }
+    // Per-plane totals for telemetry. Regions touched or edited since the last refresh are re-measured on every tick()
+    // and eviction pass; regions with a task in flight are measured once it finishes.
+    [[nodiscard]] const chunk_memory_usage& memory_usage() const noexcept { return resident_usage_; }
+    void refresh_memory_usage();
 
+    // Compressed regions decode transparently on their next access. assure()/find() wait for an in-flight background
+    // compression of that region; references obtained earlier must not be used while tick() may compress the region.
+    void set_compression_policy(const compression_policy& policy);
+    [[nodiscard]] const compression_policy& compression() const noexcept { return compression_policy_; }
+    [[nodiscard]] residency_tier tier(const region_key& key) const;
+
+    // Pinned regions leave the LRU list entirely; pin/unpin/touch/evict are O(1).
     void pin(const region_key& key);
     void unpin(const region_key& key);
 
+    // Thread-safe; tasks may enqueue follow-up work from inside a worker.
     void enqueue_task(const region_key& key, task_type task);
+    // Starts at most `budget` queued tasks and returns how many were started. In worker mode the tasks run on the pool
+    // and their completions are applied by a later tick() or wait_idle().
     std::size_t tick(std::size_t budget = std::numeric_limits<std::size_t>::max());
+    [[nodiscard]] std::size_t pending_tasks() const;
+
+    // Worker mode: 0 runs tasks inline on the tick thread. With workers, tasks on different regions run concurrently,
+    // tasks on the same region never overlap and keep their enqueue order, and a region stays resident while busy.
+    void set_worker_count(std::size_t count);
+    [[nodiscard]] std::size_t worker_count() const noexcept { return pool_ ? pool_->worker_count() : 0; }
+    // Queues `callback` to run on the tick thread when completions are next drained.
+    void post_completion(std::function<void()> callback);
+    // Blocks until every started task has finished, then applies their completions.
+    void wait_idle();
 
-    void add_dirty_observer(dirty_observer observer);
+    // Observers fire when any plane in `planes` is written; navigation rebuilds only follow voxel edits. Writes made
+    // by worker tasks are reported on the tick thread.
+    void add_dirty_observer(dirty_observer observer, chunk_plane planes = chunk_plane::all);
+    void add_dirty_region_observer(dirty_region_observer observer, chunk_plane planes = chunk_plane::all);
 
     void enable_navigation(bool enable = true);
     void set_navigation_build_config(navigation::nav_build_config config);
@@ -60,17 +189,28 @@ public:
     struct region_snapshot {
         region_key key{};
         std::shared_ptr<const chunk_storage> chunk;
+        chunk_plane dirty_planes{chunk_plane::none};
     };
 
+    // Copy-on-write snapshots of the resident chunks, safe to save or mesh on another thread while editing goes on.
     [[nodiscard]] std::vector<region_snapshot> snapshot_loaded(bool include_clean = false) const;
 
     bool unload(const region_key& key);
     void evict_until_within_limit();
 
 private:
+    using lru_list = std::list<region_key>;
+
     struct entry {
         chunk_ptr chunk;
         bool pinned{false};
+        // Position in lru_ while unpinned.
+        lru_list::iterator lru{};
+        chunk_memory_usage usage{};
+        bool usage_stale{false};
+        std::uint64_t last_access{0};
+        // Set once a compression was attempted; cleared on the next touch so incompressible chunks are not retried.
+        bool compression_tried{false};
     };
 
     struct nav_cache_entry {
@@ -78,25 +218,78 @@ private:
         bool dirty{true};
         bool rebuild_pending{false};
         std::size_t revision{0};
+        voxel_bounds pending{};
     };
 
-    chunk_storage& load_or_create(const region_key& key);
+    chunk_ptr load_chunk(const region_key& key) const;
+    chunk_storage& insert_loaded(const region_key& key, chunk_ptr chunk);
+    void pump_loads();
+    void run_loads_inline();
+    void finish_load(const std::shared_ptr<detail::load_request>& request, chunk_ptr chunk, std::exception_ptr error);
+    void attach_dirty_listener(const region_key& key, chunk_storage& chunk);
+    void notify_dirty(const region_key& key, const dirty_event& event);
+    entry& emplace_entry(const region_key& key, chunk_ptr chunk);
+    void erase_entry(std::unordered_map<region_key, entry, region_key_hash>::iterator it);
     void touch(const region_key& key);
+    void touch(const region_key& key, entry& resident);
+    void mark_usage_stale(const region_key& key, entry& resident);
+    void measure(entry& resident);
+    void lru_append(const region_key& key, entry& resident);
+    void lru_remove(entry& resident);
+    void compress_idle();
+    [[nodiscard]] bool compress_under_pressure();
+    void start_compression(const region_key& key, entry& resident);
+    void wait_for_compression(const region_key& key) const;
+    void wait_for_compressions() const;
+    [[nodiscard]] bool over_limit() const noexcept;
+    std::size_t dispatch_tasks(std::size_t budget);
+    void drain_completions();
     void mark_nav_dirty(const region_key& key);
+    void mark_nav_dirty(const region_key& key, const voxel_bounds& bounds);
     void schedule_nav_rebuild(const region_key& key);
+    void rebuild_navigation(const region_key& key, const chunk_storage& chunk);
     void clear_nav_cache(const region_key& key);
 
     chunk_extent chunk_extent_{};
     std::unordered_map<region_key, entry, region_key_hash> regions_{};
-    std::deque<region_key> lru_{};
+    // Held exclusively by the owner thread while inserting or erasing regions and shared by concurrent lookups.
+    mutable std::shared_mutex regions_mutex_{};
+    lru_list lru_{};
+    // First LRU entry not yet considered for idle compression; touched entries move behind it again.
+    lru_list::iterator compress_cursor_{lru_.end()};
+    std::size_t pinned_count_{0};
     std::size_t max_resident_{128};
+    std::size_t memory_budget_{0};
+    chunk_memory_usage resident_usage_{};
+    std::vector<region_key> stale_usage_{};
     loader_type loader_{};
     saver_type saver_{};
+    mutable std::mutex queue_mutex_{};
     std::deque<std::pair<region_key, task_type>> task_queue_{};
-    std::vector<dirty_observer> dirty_observers_{};
+    std::unordered_set<region_key, region_key_hash> active_regions_{};
+    std::unordered_set<region_key, region_key_hash> compressing_{};
+    std::atomic<std::size_t> compressions_in_flight_{0};
+    mutable std::condition_variable compression_done_{};
+    compression_policy compression_policy_{};
+    std::uint64_t tick_count_{0};
+    std::mutex completion_mutex_{};
+    std::vector<region_key> finished_regions_{};
+    std::vector<std::function<void()>> completions_{};
+    std::exception_ptr task_error_{};
+    mutable std::mutex load_mutex_{};
+    std::unordered_map<region_key, std::shared_ptr<detail::load_request>, region_key_hash> loads_{};
+    // Ordered by descending priority, then request order.
+    std::map<std::pair<std::int64_t, std::uint64_t>, std::shared_ptr<detail::load_request>> load_queue_{};
+    std::size_t loads_in_flight_{0};
+    std::size_t load_concurrency_{2};
+    std::uint64_t load_sequence_{0};
+    std::vector<std::pair<dirty_region_observer, chunk_plane>> dirty_observers_{};
+    mutable std::mutex nav_mutex_{};
     navigation::nav_build_config nav_config_{};
     bool navigation_enabled_{false};
     std::unordered_map<region_key, nav_cache_entry, region_key_hash> nav_cache_{};
+    // Declared last so workers are joined before the state they touch is destroyed.
+    std::unique_ptr<parallel::task_pool> pool_{};
 };
 
 inline region_manager::region_manager(chunk_extent chunk_dimensions)
@@ -104,12 +297,109 @@ inline region_manager::region_manager(chunk_extent chunk_dimensions)
 }
 
 inline chunk_storage& region_manager::assure(const region_key& key) {
-    auto& chunk = load_or_create(key);
-    touch(key);
-    return chunk;
+    wait_for_compression(key);
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        touch(key, it->second);
+        return *it->second.chunk;
+    }
+    return insert_loaded(key, load_chunk(key));
+}
+
+inline load_handle region_manager::request(const region_key& key, int priority, load_callback on_ready) {
+    wait_for_compression(key);
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        touch(key, it->second);
+        auto resident = std::make_shared<detail::load_request>();
+        resident->key = key;
+        resident->chunk = it->second.chunk;
+        resident->status.store(load_status::ready, std::memory_order_release);
+        load_handle handle{std::move(resident)};
+        if (on_ready) {
+            post_completion([callback = std::move(on_ready), handle] { callback(handle); });
+        }
+        return handle;
+    }
+
+    std::shared_ptr<detail::load_request> pending;
+    {
+        std::scoped_lock lock{load_mutex_};
+        auto& slot = loads_[key];
+        if (!slot) {
+            slot = std::make_shared<detail::load_request>();
+            slot->key = key;
+            slot->priority = priority;
+            slot->sequence = load_sequence_++;
+            load_queue_.emplace(std::pair{-std::int64_t{priority}, slot->sequence}, slot);
+        } else if (priority > slot->priority && slot->status.load() == load_status::queued) {
+            load_queue_.erase(std::pair{-std::int64_t{slot->priority}, slot->sequence});
+            slot->priority = priority;
+            load_queue_.emplace(std::pair{-std::int64_t{priority}, slot->sequence}, slot);
+        }
+        if (on_ready) {
+            slot->callbacks.push_back(std::move(on_ready));
+        }
+        pending = slot;
+    }
+    if (pool_) {
+        pump_loads();
+    }
+    return load_handle{std::move(pending)};
+}
+
+inline bool region_manager::cancel(const region_key& key) {
+    std::scoped_lock lock{load_mutex_};
+    auto it = loads_.find(key);
+    if (it == loads_.end()) {
+        return false;
+    }
+    auto pending = std::move(it->second);
+    loads_.erase(it);
+    if (pending->status.load() == load_status::queued) {
+        load_queue_.erase(std::pair{-std::int64_t{pending->priority}, pending->sequence});
+    }
+    pending->callbacks.clear();
+    pending->status.store(load_status::cancelled, std::memory_order_release);
+    return true;
+}
+
+inline std::size_t region_manager::pending_loads() const {
+    std::scoped_lock lock{load_mutex_};
+    return loads_.size();
+}
+
+inline void region_manager::set_load_concurrency(std::size_t count) {
+    {
+        std::scoped_lock lock{load_mutex_};
+        load_concurrency_ = std::max<std::size_t>(1, count);
+    }
+    if (pool_) {
+        pump_loads();
+    }
+}
+
+inline chunk_storage& region_manager::replace(const region_key& key, chunk_storage chunk) {
+    wait_for_compression(key);
+    entry* resident = nullptr;
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        resident = &it->second;
+        auto guard = resident->chunk->lock_exclusive();
+        *resident->chunk = std::move(chunk);
+        mark_usage_stale(key, *resident);
+    } else {
+        resident = &emplace_entry(key, std::make_shared<chunk_storage>(std::move(chunk)));
+    }
+    auto& target = *resident->chunk;
+    attach_dirty_listener(key, target);
+    touch(key, *resident);
+    if (navigation_enabled_) {
+        mark_nav_dirty(key);
+    }
+    return target;
 }
 
 inline region_manager::chunk_ptr region_manager::find(const region_key& key) const {
+    wait_for_compression(key);
+    std::shared_lock lock{regions_mutex_};
     if (auto it = regions_.find(key); it != regions_.end()) {
         return it->second.chunk;
     }
@@ -121,52 +411,247 @@ inline void region_manager::set_max_resident(std::size_t limit) noexcept {
     evict_until_within_limit();
 }
 
+inline void region_manager::set_memory_budget(std::size_t bytes) {
+    memory_budget_ = bytes;
+    evict_until_within_limit();
+}
+
+inline void region_manager::refresh_memory_usage() {
+    std::vector<region_key> stale;
+    stale.swap(stale_usage_);
+    for (const auto& key : stale) {
+        auto it = regions_.find(key);
+        if (it == regions_.end() || !it->second.usage_stale) {
+            continue;
+        }
+        if (active_regions_.contains(key)) {
+            // A worker may be resizing planes right now; measure after it finishes.
+            stale_usage_.push_back(key);
+            continue;
+        }
+        measure(it->second);
+    }
+}
+
+inline void region_manager::measure(entry& resident) {
+    resident_usage_ -= resident.usage;
+    resident.usage = resident.chunk->memory_usage();
+    resident_usage_ += resident.usage;
+    resident.usage_stale = false;
+}
+
+inline void region_manager::set_compression_policy(const compression_policy& policy) {
+    compression_policy_ = policy;
+    // Reconsider every unpinned region under the new thresholds.
+    compress_cursor_ = lru_.begin();
+}
+
+inline residency_tier region_manager::tier(const region_key& key) const {
+    wait_for_compression(key);
+    std::shared_lock lock{regions_mutex_};
+    auto it = regions_.find(key);
+    if (it == regions_.end()) {
+        return residency_tier::cold;
+    }
+    return it->second.chunk->compressed() ? residency_tier::warm : residency_tier::hot;
+}
+
+inline bool region_manager::over_limit() const noexcept {
+    return regions_.size() > max_resident_ || (memory_budget_ != 0 && resident_usage_.total() > memory_budget_);
+}
+
 inline void region_manager::pin(const region_key& key) {
-    if (auto it = regions_.find(key); it != regions_.end()) {
-        it->second.pinned = true;
+    auto it = regions_.find(key);
+    if (it == regions_.end() || it->second.pinned) {
+        return;
     }
+    lru_remove(it->second);
+    it->second.pinned = true;
+    ++pinned_count_;
 }
 
 inline void region_manager::unpin(const region_key& key) {
-    if (auto it = regions_.find(key); it != regions_.end()) {
-        it->second.pinned = false;
-        touch(key);
+    auto it = regions_.find(key);
+    if (it == regions_.end() || !it->second.pinned) {
+        return;
     }
+    it->second.pinned = false;
+    lru_append(key, it->second);
+    --pinned_count_;
 }
 
 inline void region_manager::enqueue_task(const region_key& key, task_type task) {
+    std::scoped_lock lock{queue_mutex_};
     task_queue_.emplace_back(key, std::move(task));
 }
 
 inline std::size_t region_manager::tick(std::size_t budget) {
+    ++tick_count_;
     std::size_t processed = 0;
-    while (processed < budget && !task_queue_.empty()) {
-        auto [key, task] = std::move(task_queue_.front());
-        task_queue_.pop_front();
-        auto& chunk = assure(key);
-        if (task) {
-            task(chunk, key);
+    if (pool_) {
+        pump_loads();
+        processed = dispatch_tasks(budget);
+    } else {
+        run_loads_inline();
+        while (processed < budget) {
+            std::pair<region_key, task_type> next;
+            {
+                std::scoped_lock lock{queue_mutex_};
+                if (task_queue_.empty()) {
+                    break;
+                }
+                next = std::move(task_queue_.front());
+                task_queue_.pop_front();
+            }
+            auto& chunk = assure(next.first);
+            if (next.second) {
+                auto guard = chunk.lock_exclusive();
+                next.second(chunk, next.first);
+            }
+            ++processed;
         }
-        ++processed;
     }
+    drain_completions();
+    compress_idle();
     evict_until_within_limit();
     return processed;
 }
 
-inline void region_manager::add_dirty_observer(dirty_observer observer) {
-    dirty_observers_.push_back(std::move(observer));
+inline std::size_t region_manager::pending_tasks() const {
+    std::scoped_lock lock{queue_mutex_};
+    return task_queue_.size() + active_regions_.size();
+}
+
+inline void region_manager::set_worker_count(std::size_t count) {
+    if (pool_) {
+        pool_->wait_idle();
+        pool_.reset();
+    }
+    if (count > 0) {
+        pool_ = std::make_unique<parallel::task_pool>(count);
+    }
+    drain_completions();
+}
+
+inline void region_manager::post_completion(std::function<void()> callback) {
+    if (!callback) {
+        return;
+    }
+    std::scoped_lock lock{completion_mutex_};
+    completions_.push_back(std::move(callback));
+}
+
+inline void region_manager::wait_idle() {
+    if (pool_) {
+        pool_->wait_idle();
+    }
+    drain_completions();
+}
+
+inline std::size_t region_manager::dispatch_tasks(std::size_t budget) {
+    // Free regions whose tasks finished since the last tick so their queued successors can start now.
+    drain_completions();
+
+    std::vector<std::pair<region_key, task_type>> batch;
+    {
+        std::scoped_lock lock{queue_mutex_, load_mutex_};
+        for (auto it = task_queue_.begin(); it != task_queue_.end() && batch.size() < budget;) {
+            // Tasks on a region with an outstanding request wait for it to land instead of loading synchronously.
+            if (active_regions_.contains(it->first) || loads_.contains(it->first)) {
+                ++it;
+                continue;
+            }
+            active_regions_.insert(it->first);
+            batch.push_back(std::move(*it));
+            it = task_queue_.erase(it);
+        }
+    }
+
+    for (std::size_t index = 0; index < batch.size(); ++index) {
+        auto& [key, task] = batch[index];
+        std::shared_ptr<chunk_storage> chunk;
+        try {
+            assure(key);
+            chunk = regions_.at(key).chunk;
+        } catch (...) {
+            // As on the inline path, the task whose region failed to load is dropped and the error leaves tick().
+            // The tasks behind it were never submitted: release their regions and put them back at the front of the
+            // queue, ahead of any later tasks on the same keys.
+            std::scoped_lock lock{queue_mutex_};
+            active_regions_.erase(key);
+            for (std::size_t rest = batch.size(); rest-- > index + 1;) {
+                active_regions_.erase(batch[rest].first);
+                task_queue_.push_front(std::move(batch[rest]));
+            }
+            throw;
+        }
+        pool_->submit([this, key, chunk = std::move(chunk), task = std::move(task)] {
+            try {
+                if (task) {
+                    auto guard = chunk->lock_exclusive();
+                    task(*chunk, key);
+                }
+            } catch (...) {
+                std::scoped_lock lock{completion_mutex_};
+                if (!task_error_) {
+                    task_error_ = std::current_exception();
+                }
+            }
+            std::scoped_lock lock{completion_mutex_};
+            finished_regions_.push_back(key);
+        });
+    }
+    return batch.size();
+}
+
+inline void region_manager::drain_completions() {
+    std::vector<region_key> finished;
+    std::vector<std::function<void()>> callbacks;
+    std::exception_ptr error;
+    {
+        std::scoped_lock lock{completion_mutex_};
+        finished.swap(finished_regions_);
+        callbacks.swap(completions_);
+        error = std::exchange(task_error_, nullptr);
+    }
+    if (!finished.empty()) {
+        std::scoped_lock lock{queue_mutex_};
+        for (const auto& key : finished) {
+            active_regions_.erase(key);
+        }
+    }
+    for (auto& callback : callbacks) {
+        callback();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+inline void region_manager::add_dirty_observer(dirty_observer observer, chunk_plane planes) {
+    if (!observer) {
+        return;
+    }
+    dirty_observers_.emplace_back(
+        [observer = std::move(observer)](const region_key& key, const dirty_event&) { observer(key); }, planes);
+}
+
+inline void region_manager::add_dirty_region_observer(dirty_region_observer observer, chunk_plane planes) {
+    dirty_observers_.emplace_back(std::move(observer), planes);
 }
 
 inline void region_manager::enable_navigation(bool enable) {
     if (navigation_enabled_ == enable) {
         return;
     }
-    navigation_enabled_ = enable;
-    if (!navigation_enabled_) {
+    {
+        std::scoped_lock lock{nav_mutex_};
+        navigation_enabled_ = enable;
         nav_cache_.clear();
+    }
+    if (!navigation_enabled_) {
         return;
     }
-    nav_cache_.clear();
     for (const auto& [key, entry] : regions_) {
         if (entry.chunk) {
             mark_nav_dirty(key);
@@ -175,7 +660,10 @@ inline void region_manager::enable_navigation(bool enable) {
 }
 
 inline void region_manager::set_navigation_build_config(navigation::nav_build_config config) {
-    nav_config_ = std::move(config);
+    {
+        std::scoped_lock lock{nav_mutex_};
+        nav_config_ = std::move(config);
+    }
     if (!navigation_enabled_) {
         return;
     }
@@ -190,6 +678,7 @@ inline std::shared_ptr<const navigation::nav_grid> region_manager::navigation_gr
     if (!navigation_enabled_) {
         return {};
     }
+    std::scoped_lock lock{nav_mutex_};
     if (auto it = nav_cache_.find(key); it != nav_cache_.end()) {
         return it->second.grid;
     }
@@ -210,6 +699,7 @@ inline navigation::stitched_nav_graph region_manager::stitch_navigation(const re
         return stitched;
     }
 
+    std::scoped_lock lock{nav_mutex_};
     const auto add_region = [&](const region_key& key) {
         if (auto it = nav_cache_.find(key); it != nav_cache_.end()) {
             if (it->second.grid) {
@@ -228,6 +718,8 @@ inline navigation::stitched_nav_graph region_manager::stitch_navigation(const re
 }
 
 inline void region_manager::for_each_loaded(const std::function<void(const region_key&, const chunk_storage&)>& visitor) const {
+    wait_for_compressions();
+    std::shared_lock lock{regions_mutex_};
     for (const auto& [key, entry] : regions_) {
         if (entry.chunk) {
             visitor(key, *entry.chunk);
@@ -236,16 +728,21 @@ inline void region_manager::for_each_loaded(const std::function<void(const regio
 }
 
 inline std::vector<region_manager::region_snapshot> region_manager::snapshot_loaded(bool include_clean) const {
+    wait_for_compressions();
+    std::shared_lock lock{regions_mutex_};
     std::vector<region_snapshot> snapshots;
     snapshots.reserve(regions_.size());
     for (const auto& [key, entry] : regions_) {
         if (!entry.chunk) {
             continue;
         }
+        // Copy-on-write snapshots stay consistent while tasks keep editing the live chunks. Tasks mark planes dirty
+        // under the exclusive guard, so dirty() is read under the shared one.
+        auto guard = entry.chunk->lock_shared();
         if (!include_clean && !entry.chunk->dirty()) {
             continue;
         }
-        snapshots.push_back(region_snapshot{key, std::const_pointer_cast<const chunk_storage>(entry.chunk)});
+        snapshots.push_back(region_snapshot{key, entry.chunk->snapshot(), entry.chunk->dirty_planes()});
     }
     return snapshots;
 }
@@ -255,97 +752,398 @@ inline bool region_manager::unload(const region_key& key) {
     if (it == regions_.end()) {
         return false;
     }
-    if (it->second.pinned) {
+    if (it->second.pinned || active_regions_.contains(key)) {
         return false;
     }
     if (it->second.chunk && saver_ && it->second.chunk->dirty()) {
         saver_(key, *it->second.chunk);
     }
     clear_nav_cache(key);
-    regions_.erase(it);
+    erase_entry(it);
     return true;
 }
 
 inline void region_manager::evict_until_within_limit() {
-    while (regions_.size() > max_resident_ && !lru_.empty()) {
-        const auto key = lru_.front();
-        lru_.pop_front();
-        auto it = regions_.find(key);
-        if (it == regions_.end() || it->second.pinned) {
+    refresh_memory_usage();
+    // While pressure compressions are still running, only the chunk-count limit may evict.
+    const bool deferred = compress_under_pressure();
+    // Regions with a task in flight keep their place; only the few busy ones are stepped over.
+    auto cursor = lru_.begin();
+    while ((deferred ? regions_.size() > max_resident_ : over_limit()) && cursor != lru_.end()) {
+        const auto key = *cursor++;
+        if (active_regions_.contains(key)) {
             continue;
         }
+        auto it = regions_.find(key);
         if (it->second.chunk && saver_ && it->second.chunk->dirty()) {
             saver_(key, *it->second.chunk);
         }
         clear_nav_cache(key);
-        regions_.erase(it);
+        erase_entry(it);
     }
 }
 
-inline chunk_storage& region_manager::load_or_create(const region_key& key) {
-    if (auto it = regions_.find(key); it != regions_.end()) {
-        return *it->second.chunk;
-    }
-    chunk_ptr chunk;
+inline region_manager::chunk_ptr region_manager::load_chunk(const region_key& key) const {
     if (loader_) {
-        chunk = std::make_shared<chunk_storage>(loader_(key));
+        return std::make_shared<chunk_storage>(loader_(key));
+    }
+    return std::make_shared<chunk_storage>(chunk_extent_);
+}
+
+inline chunk_storage& region_manager::insert_loaded(const region_key& key, chunk_ptr chunk) {
+    attach_dirty_listener(key, *chunk);
+    auto& resident = emplace_entry(key, std::move(chunk));
+    if (navigation_enabled_) {
+        mark_nav_dirty(key);
+    }
+    return *resident.chunk;
+}
+
+inline region_manager::entry& region_manager::emplace_entry(const region_key& key, chunk_ptr chunk) {
+    std::unique_lock lock{regions_mutex_};
+    auto [it, inserted] = regions_.emplace(key, entry{std::move(chunk), false});
+    lock.unlock();
+    if (inserted) {
+        it->second.last_access = tick_count_;
+        lru_append(key, it->second);
+        it->second.usage = it->second.chunk->memory_usage();
+        resident_usage_ += it->second.usage;
+    }
+    return it->second;
+}
+
+inline void region_manager::erase_entry(std::unordered_map<region_key, entry, region_key_hash>::iterator it) {
+    if (it->second.pinned) {
+        --pinned_count_;
     } else {
-        chunk = std::make_shared<chunk_storage>(chunk_extent_);
+        lru_remove(it->second);
     }
-    if (chunk) {
-        chunk->add_dirty_listener([this, key]() {
-            mark_nav_dirty(key);
-            for (auto& observer : dirty_observers_) {
-                if (observer) {
-                    observer(key);
+    resident_usage_ -= it->second.usage;
+    std::unique_lock lock{regions_mutex_};
+    regions_.erase(it);
+}
+
+inline void region_manager::pump_loads() {
+    for (;;) {
+        std::shared_ptr<detail::load_request> next;
+        {
+            std::scoped_lock lock{load_mutex_};
+            if (loads_in_flight_ >= load_concurrency_ || load_queue_.empty()) {
+                return;
+            }
+            next = std::move(load_queue_.begin()->second);
+            load_queue_.erase(load_queue_.begin());
+            next->status.store(load_status::loading, std::memory_order_release);
+            ++loads_in_flight_;
+        }
+        pool_->submit([this, next = std::move(next)] {
+            chunk_ptr chunk;
+            std::exception_ptr error;
+            if (next->status.load(std::memory_order_acquire) != load_status::cancelled) {
+                try {
+                    chunk = load_chunk(next->key);
+                } catch (...) {
+                    error = std::current_exception();
                 }
             }
+            {
+                std::scoped_lock lock{load_mutex_};
+                --loads_in_flight_;
+            }
+            post_completion([this, next, chunk = std::move(chunk), error]() mutable {
+                finish_load(next, std::move(chunk), error);
+            });
+            pump_loads();
         });
     }
-    auto [it, inserted] = regions_.emplace(key, entry{std::move(chunk), false});
-    (void)inserted;
-    if (navigation_enabled_) {
-        mark_nav_dirty(key);
+}
+
+inline void region_manager::run_loads_inline() {
+    std::vector<std::shared_ptr<detail::load_request>> batch;
+    {
+        std::scoped_lock lock{load_mutex_};
+        while (batch.size() < load_concurrency_ && !load_queue_.empty()) {
+            batch.push_back(std::move(load_queue_.begin()->second));
+            load_queue_.erase(load_queue_.begin());
+            batch.back()->status.store(load_status::loading, std::memory_order_release);
+        }
+    }
+    for (const auto& next : batch) {
+        chunk_ptr chunk;
+        std::exception_ptr error;
+        try {
+            chunk = load_chunk(next->key);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        finish_load(next, std::move(chunk), error);
+    }
+}
+
+inline void region_manager::finish_load(const std::shared_ptr<detail::load_request>& request, chunk_ptr chunk,
+    std::exception_ptr error) {
+    std::vector<load_callback> callbacks;
+    {
+        std::scoped_lock lock{load_mutex_};
+        if (auto it = loads_.find(request->key); it != loads_.end() && it->second == request) {
+            loads_.erase(it);
+        }
+        if (request->status.load() == load_status::cancelled) {
+            return;
+        }
+        callbacks.swap(request->callbacks);
+    }
+
+    if (error) {
+        request->error = error;
+        request->status.store(load_status::failed, std::memory_order_release);
+    } else {
+        // A synchronous assure() may have won the race; keep the resident chunk.
+        if (auto it = regions_.find(request->key); it != regions_.end()) {
+            chunk = it->second.chunk;
+        } else {
+            insert_loaded(request->key, chunk);
+        }
+        touch(request->key);
+        request->chunk = std::move(chunk);
+        request->status.store(load_status::ready, std::memory_order_release);
+    }
+
+    const load_handle handle{request};
+    for (auto& callback : callbacks) {
+        callback(handle);
+    }
+}
+
+inline void region_manager::attach_dirty_listener(const region_key& key, chunk_storage& chunk) {
+    chunk.add_plane_dirty_listener([this, key](const dirty_event& event) {
+        if (pool_ && pool_->on_worker_thread()) {
+            post_completion([this, key, event] { notify_dirty(key, event); });
+            return;
+        }
+        notify_dirty(key, event);
+    });
+}
+
+inline void region_manager::notify_dirty(const region_key& key, const dirty_event& event) {
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        mark_usage_stale(key, it->second);
+    }
+    if (contains(event.planes, chunk_plane::voxels)) {
+        mark_nav_dirty(key, event.bounds);
+    }
+    for (auto& [observer, filter] : dirty_observers_) {
+        if (observer && contains(filter, event.planes)) {
+            observer(key, event);
+        }
     }
-    return *it->second.chunk;
 }
 
 inline void region_manager::touch(const region_key& key) {
-    std::erase(lru_, key);
-    lru_.push_back(key);
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        touch(key, it->second);
+    }
+}
+
+inline void region_manager::touch(const region_key& key, entry& resident) {
+    resident.last_access = tick_count_;
+    resident.compression_tried = false;
+    if (!resident.pinned) {
+        if (compress_cursor_ == resident.lru) {
+            ++compress_cursor_;
+        }
+        lru_.splice(lru_.end(), lru_, resident.lru);
+        if (compress_cursor_ == lru_.end()) {
+            compress_cursor_ = resident.lru;
+        }
+    }
+    // Callers may write through the returned chunk, so its footprint is re-measured on the next refresh.
+    mark_usage_stale(key, resident);
+}
+
+inline void region_manager::lru_append(const region_key& key, entry& resident) {
+    resident.lru = lru_.insert(lru_.end(), key);
+    if (compress_cursor_ == lru_.end()) {
+        compress_cursor_ = resident.lru;
+    }
+}
+
+inline void region_manager::lru_remove(entry& resident) {
+    if (compress_cursor_ == resident.lru) {
+        ++compress_cursor_;
+    }
+    lru_.erase(resident.lru);
+}
+
+inline void region_manager::compress_idle() {
+    if (compression_policy_.idle_ticks == 0) {
+        return;
+    }
+    // The LRU is ordered by last access, so the scan stops at the first region that is still warm.
+    std::size_t started = 0;
+    while (compress_cursor_ != lru_.end() && started < compression_policy_.max_per_tick) {
+        const auto key = *compress_cursor_;
+        auto& resident = regions_.at(key);
+        if (tick_count_ - resident.last_access < compression_policy_.idle_ticks) {
+            break;
+        }
+        ++compress_cursor_;
+        if (resident.compression_tried || active_regions_.contains(key) || resident.chunk->compressed()) {
+            continue;
+        }
+        start_compression(key, resident);
+        ++started;
+    }
+}
+
+inline bool region_manager::compress_under_pressure() {
+    if (!compression_policy_.compress_under_pressure || memory_budget_ == 0) {
+        return false;
+    }
+    std::size_t started = 0;
+    for (auto it = lru_.begin(); it != lru_.end() && resident_usage_.total() > memory_budget_; ++it) {
+        if (pool_ && started >= compression_policy_.max_per_tick) {
+            break;
+        }
+        auto& resident = regions_.at(*it);
+        if (resident.compression_tried || active_regions_.contains(*it) || resident.chunk->compressed()) {
+            continue;
+        }
+        start_compression(*it, resident);
+        ++started;
+    }
+    return compressions_in_flight_.load(std::memory_order_acquire) != 0;
+}
+
+inline void region_manager::start_compression(const region_key& key, entry& resident) {
+    resident.compression_tried = true;
+    if (!pool_) {
+        // A reader still holding the chunk means it is not idle after all.
+        if (auto guard = resident.chunk->try_lock_exclusive(); guard.owns_lock()) {
+            resident.chunk->compress(compression_policy_.codecs);
+        }
+        measure(resident);
+        return;
+    }
+    {
+        std::scoped_lock lock{queue_mutex_};
+        active_regions_.insert(key);
+        compressing_.insert(key);
+    }
+    compressions_in_flight_.fetch_add(1, std::memory_order_acq_rel);
+    pool_->submit([this, key, chunk = resident.chunk, codecs = compression_policy_.codecs] {
+        try {
+            if (auto guard = chunk->try_lock_exclusive(); guard.owns_lock()) {
+                chunk->compress(codecs);
+            }
+        } catch (...) {
+            std::scoped_lock lock{completion_mutex_};
+            if (!task_error_) {
+                task_error_ = std::current_exception();
+            }
+        }
+        {
+            std::scoped_lock lock{completion_mutex_};
+            finished_regions_.push_back(key);
+            completions_.push_back([this, key] {
+                if (auto it = regions_.find(key); it != regions_.end()) {
+                    mark_usage_stale(key, it->second);
+                }
+            });
+        }
+        {
+            std::scoped_lock lock{queue_mutex_};
+            compressing_.erase(key);
+            compressions_in_flight_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        compression_done_.notify_all();
+    });
+}
+
+inline void region_manager::wait_for_compression(const region_key& key) const {
+    if (compressions_in_flight_.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    std::unique_lock lock{queue_mutex_};
+    compression_done_.wait(lock, [&] { return !compressing_.contains(key); });
+}
+
+inline void region_manager::wait_for_compressions() const {
+    if (compressions_in_flight_.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    std::unique_lock lock{queue_mutex_};
+    compression_done_.wait(lock, [&] { return compressing_.empty(); });
+}
+
+inline void region_manager::mark_usage_stale(const region_key& key, entry& resident) {
+    if (!resident.usage_stale) {
+        resident.usage_stale = true;
+        stale_usage_.push_back(key);
+    }
 }
 
 inline void region_manager::mark_nav_dirty(const region_key& key) {
+    mark_nav_dirty(key, voxel_bounds::full(chunk_extent_));
+}
+
+inline void region_manager::mark_nav_dirty(const region_key& key, const voxel_bounds& bounds) {
     if (!navigation_enabled_) {
         return;
     }
-    auto& entry = nav_cache_[key];
-    entry.dirty = true;
+    {
+        std::scoped_lock lock{nav_mutex_};
+        auto& entry = nav_cache_[key];
+        entry.dirty = true;
+        entry.pending.merge(bounds);
+        if (entry.rebuild_pending) {
+            return;
+        }
+        entry.rebuild_pending = true;
+    }
     schedule_nav_rebuild(key);
 }
 
 inline void region_manager::schedule_nav_rebuild(const region_key& key) {
-    if (!navigation_enabled_) {
-        return;
+    enqueue_task(key, [this](chunk_storage& chunk, const region_key& target) { rebuild_navigation(target, chunk); });
+}
+
+inline void region_manager::rebuild_navigation(const region_key& key, const chunk_storage& chunk) {
+    // Claim the pending bounds up front so edits landing mid-build schedule a follow-up rebuild.
+    nav_grid_ptr previous;
+    voxel_bounds pending;
+    navigation::nav_build_config config;
+    {
+        std::scoped_lock lock{nav_mutex_};
+        auto it = nav_cache_.find(key);
+        if (it == nav_cache_.end()) {
+            return;
+        }
+        previous = it->second.grid;
+        pending = std::exchange(it->second.pending, voxel_bounds{});
+        it->second.rebuild_pending = false;
+        config = nav_config_;
     }
-    auto& entry = nav_cache_[key];
-    if (entry.rebuild_pending) {
-        return;
+
+    // Small edits patch a private copy of the previous grid; readers keep their shared snapshot.
+    nav_grid_ptr grid;
+    if (previous && !pending.covers(chunk.extent())) {
+        grid = std::make_shared<navigation::nav_grid>(*previous);
+        navigation::update_nav_grid(*grid, chunk, pending, config);
+    } else {
+        grid = std::make_shared<navigation::nav_grid>(navigation::build_nav_grid(chunk, config));
+    }
+
+    std::scoped_lock lock{nav_mutex_};
+    if (auto it = nav_cache_.find(key); it != nav_cache_.end()) {
+        it->second.grid = std::move(grid);
+        it->second.dirty = it->second.rebuild_pending;
+        ++it->second.revision;
     }
-    entry.rebuild_pending = true;
-    task_queue_.emplace_back(key, [this, key](chunk_storage& chunk, const region_key&) {
-        auto grid = std::make_shared<navigation::nav_grid>(
-            navigation::build_nav_grid(static_cast<const chunk_storage&>(chunk), nav_config_));
-        if (auto it = nav_cache_.find(key); it != nav_cache_.end()) {
-            it->second.grid = std::move(grid);
-            it->second.dirty = false;
-            it->second.rebuild_pending = false;
-            ++it->second.revision;
-        }
-    });
 }
 
 inline void region_manager::clear_nav_cache(const region_key& key) {
+    std::scoped_lock lock{nav_mutex_};
     nav_cache_.erase(key);
 }
 
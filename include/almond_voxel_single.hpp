@@ -14,8 +14,6 @@
 #include <string_view>
 #include <type_traits>
 
-// begin: almond_voxel/world_fwd.hpp
-
 namespace almond::voxel {
 
 using voxel_id = std::uint16_t;
@@ -137,6 +135,75 @@ struct chunk_extent {
     return chunk_extent{edge, edge, edge};
 }
 
+// Half-open voxel box [min, max) in chunk-local coordinates. A default-constructed box is empty.
+struct voxel_bounds {
+    std::array<std::uint32_t, 3> min{0, 0, 0};
+    std::array<std::uint32_t, 3> max{0, 0, 0};
+
+    [[nodiscard]] static constexpr voxel_bounds cell(std::uint32_t px, std::uint32_t py, std::uint32_t pz) noexcept {
+        return voxel_bounds{{px, py, pz}, {px + 1, py + 1, pz + 1}};
+    }
+
+    [[nodiscard]] static constexpr voxel_bounds full(const chunk_extent& extent) noexcept {
+        return voxel_bounds{{0, 0, 0}, {extent.x, extent.y, extent.z}};
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return min[0] >= max[0] || min[1] >= max[1] || min[2] >= max[2];
+    }
+
+    [[nodiscard]] constexpr std::size_t volume() const noexcept {
+        return empty() ? 0
+                       : static_cast<std::size_t>(max[0] - min[0]) * static_cast<std::size_t>(max[1] - min[1])
+                * static_cast<std::size_t>(max[2] - min[2]);
+    }
+
+    [[nodiscard]] constexpr bool contains(std::uint32_t px, std::uint32_t py, std::uint32_t pz) const noexcept {
+        return px >= min[0] && px < max[0] && py >= min[1] && py < max[1] && pz >= min[2] && pz < max[2];
+    }
+
+    [[nodiscard]] constexpr bool intersects(const voxel_bounds& other) const noexcept {
+        return !empty() && !other.empty() && min[0] < other.max[0] && other.min[0] < max[0] && min[1] < other.max[1]
+            && other.min[1] < max[1] && min[2] < other.max[2] && other.min[2] < max[2];
+    }
+
+    [[nodiscard]] constexpr bool covers(const chunk_extent& extent) const noexcept {
+        return min[0] == 0 && min[1] == 0 && min[2] == 0 && max[0] >= extent.x && max[1] >= extent.y && max[2] >= extent.z;
+    }
+
+    constexpr void merge(const voxel_bounds& other) noexcept {
+        if (other.empty()) {
+            return;
+        }
+        if (empty()) {
+            *this = other;
+            return;
+        }
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            min[axis] = min[axis] < other.min[axis] ? min[axis] : other.min[axis];
+            max[axis] = max[axis] > other.max[axis] ? max[axis] : other.max[axis];
+        }
+    }
+
+    // Grows the box by the given amounts below and above on each axis, clamped to the extent.
+    [[nodiscard]] constexpr voxel_bounds expanded(const std::array<std::uint32_t, 3>& below,
+        const std::array<std::uint32_t, 3>& above, const chunk_extent& extent) const noexcept {
+        if (empty()) {
+            return *this;
+        }
+        const auto dims = extent.to_array();
+        voxel_bounds result{};
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            result.min[axis] = min[axis] > below[axis] ? min[axis] - below[axis] : 0;
+            const std::uint32_t grown = max[axis] + above[axis];
+            result.max[axis] = grown < dims[axis] ? grown : dims[axis];
+        }
+        return result;
+    }
+
+    [[nodiscard]] constexpr bool operator==(const voxel_bounds&) const noexcept = default;
+};
+
 template <typename T>
 using voxel_span = std::span<T>;
 
@@ -208,6 +275,54 @@ template <typename Element>
 } // namespace almond::voxel
 // end: almond_voxel/core.hpp
 
+// begin: almond_voxel/effects/effect_channels.hpp
+
+
+#include <array>
+#include <cstdint>
+
+namespace almond::voxel::effects {
+
+enum class channel : std::uint32_t {
+    none = 0u,
+    density = 1u << 0u,
+    velocity = 1u << 1u,
+    lifetime = 1u << 2u,
+    all = density | velocity | lifetime
+};
+
+constexpr channel operator|(channel lhs, channel rhs) noexcept {
+    return static_cast<channel>(static_cast<std::uint32_t>(lhs) | static_cast<std::uint32_t>(rhs));
+}
+
+constexpr channel operator&(channel lhs, channel rhs) noexcept {
+    return static_cast<channel>(static_cast<std::uint32_t>(lhs) & static_cast<std::uint32_t>(rhs));
+}
+
+constexpr channel operator~(channel value) noexcept {
+    return static_cast<channel>(~static_cast<std::uint32_t>(value));
+}
+
+constexpr channel& operator|=(channel& lhs, channel rhs) noexcept {
+    lhs = lhs | rhs;
+    return lhs;
+}
+
+constexpr bool contains(channel flags, channel value) noexcept {
+    return (flags & value) != channel::none;
+}
+
+struct velocity_sample {
+    float x{0.0f};
+    float y{0.0f};
+    float z{0.0f};
+
+    [[nodiscard]] constexpr std::array<float, 3> to_array() const noexcept { return {x, y, z}; }
+};
+
+} // namespace almond::voxel::effects
+// end: almond_voxel/effects/effect_channels.hpp
+
 // begin: almond_voxel/material/voxel_material.hpp
 
 #include <array>
@@ -249,1533 +364,2310 @@ struct voxel_material {
 } // namespace almond::voxel
 // end: almond_voxel/material/voxel_material.hpp
 
-// begin: almond_voxel/chunk.hpp
-
+// begin: almond_voxel/storage/codecs.hpp
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cstddef>
-#include <functional>
+#include <cstdint>
+#include <cstring>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <span>
 #include <stdexcept>
-#include <utility>
+#include <string_view>
 #include <vector>
 
-namespace almond::voxel::effects {
+namespace almond::voxel {
 
-enum class channel : std::uint32_t {
-    none = 0u,
-    density = 1u << 0u,
-    velocity = 1u << 1u,
-    lifetime = 1u << 2u,
-    all = density | velocity | lifetime
+// Identifies a plane codec inside compressed chunk blobs. Values 0-63 are reserved for built-ins; applications may
+// register their own codecs under any other id except `automatic`, which only selects the smallest built-in output.
+enum class codec_id : std::uint8_t {
+    raw = 0,
+    rle = 1,
+    delta_bitpack = 2,
+    lz = 3,
+    automatic = 0xFF
 };
 
-constexpr channel operator|(channel lhs, channel rhs) noexcept {
-    return static_cast<channel>(static_cast<std::uint32_t>(lhs) | static_cast<std::uint32_t>(rhs));
-}
+inline constexpr std::uint8_t first_custom_codec_id = 64;
 
-constexpr channel operator&(channel lhs, channel rhs) noexcept {
-    return static_cast<channel>(static_cast<std::uint32_t>(lhs) & static_cast<std::uint32_t>(rhs));
+// Stateless plane codec. `element_size` is the size of one plane cell in bytes; encoders append to `out` and decoders
+// must fill `output` exactly or throw std::runtime_error.
+struct codec {
+    using encode_function = void (*)(std::span<const std::byte> input, std::size_t element_size,
+        std::vector<std::byte>& out);
+    using decode_function = void (*)(std::span<const std::byte> input, std::span<std::byte> output,
+        std::size_t element_size);
+
+    std::string_view name{};
+    encode_function encode{nullptr};
+    decode_function decode{nullptr};
+
+    [[nodiscard]] explicit operator bool() const noexcept { return encode != nullptr && decode != nullptr; }
+};
+
+namespace detail::codecs {
+
+inline void put_varint(std::vector<std::byte>& out, std::uint64_t value) {
+    while (value >= 0x80u) {
+        out.push_back(static_cast<std::byte>((value & 0x7Fu) | 0x80u));
+        value >>= 7u;
+    }
+    out.push_back(static_cast<std::byte>(value));
 }
 
-constexpr channel operator~(channel value) noexcept {
-    return static_cast<channel>(~static_cast<std::uint32_t>(value));
+inline std::uint64_t get_varint(std::span<const std::byte> input, std::size_t& offset) {
+    std::uint64_t value = 0;
+    for (std::uint32_t shift = 0; shift < 64; shift += 7) {
+        if (offset >= input.size()) {
+            throw std::runtime_error("truncated codec stream");
+        }
+        const auto byte = std::to_integer<std::uint64_t>(input[offset++]);
+        value |= (byte & 0x7Fu) << shift;
+        if ((byte & 0x80u) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("malformed codec varint");
 }
 
-constexpr channel& operator|=(channel& lhs, channel rhs) noexcept {
-    lhs = lhs | rhs;
-    return lhs;
+inline void check_elements(std::size_t bytes, std::size_t element_size) {
+    if (element_size == 0 || bytes % element_size != 0) {
+        throw std::logic_error("codec input is not a whole number of elements");
+    }
 }
 
-constexpr bool contains(channel flags, channel value) noexcept {
-    return (flags & value) != channel::none;
+// Extends the `period` bytes at `data` until `total` bytes repeat them, doubling each copy so long runs stay cheap.
+inline void repeat_pattern(std::byte* data, std::size_t period, std::size_t total) noexcept {
+    std::size_t filled = period;
+    while (filled < total) {
+        const auto chunk = std::min(filled - filled % period, total - filled);
+        std::memcpy(data + filled, data, chunk);
+        filled += chunk;
+    }
 }
 
-struct velocity_sample {
-    float x{0.0f};
-    float y{0.0f};
-    float z{0.0f};
-};
+inline void encode_raw(std::span<const std::byte> input, std::size_t, std::vector<std::byte>& out) {
+    out.insert(out.end(), input.begin(), input.end());
+}
 
-} // namespace almond::voxel::effects
+inline void decode_raw(std::span<const std::byte> input, std::span<std::byte> output, std::size_t) {
+    if (input.size() != output.size()) {
+        throw std::runtime_error("raw codec size mismatch");
+    }
+    std::copy(input.begin(), input.end(), output.begin());
+}
 
-namespace almond::voxel {
+// Runs of identical cells: varint run length followed by one cell. The cell compare is instantiated for the common
+// plane widths so the scan stays a plain load-and-compare.
+template <std::size_t Size>
+std::size_t rle_run_end(std::span<const std::byte> input, std::size_t offset, std::size_t element_size) noexcept {
+    const auto size = Size == 0 ? element_size : Size;
+    const auto* cell = input.data() + offset;
+    auto end = offset + size;
+    while (end < input.size() && std::memcmp(input.data() + end, cell, Size == 0 ? element_size : Size) == 0) {
+        end += size;
+    }
+    return end;
+}
 
-struct chunk_storage_config {
-    chunk_extent extent{cubic_extent(32)};
-    bool enable_materials{false};
-    bool enable_high_precision_lighting{false};
-    effects::channel effect_channels{effects::channel::none};
-};
+inline void encode_rle(std::span<const std::byte> input, std::size_t element_size, std::vector<std::byte>& out) {
+    check_elements(input.size(), element_size);
+    std::size_t offset = 0;
+    while (offset < input.size()) {
+        std::size_t end = 0;
+        switch (element_size) {
+        case 1:
+            end = rle_run_end<1>(input, offset, element_size);
+            break;
+        case 2:
+            end = rle_run_end<2>(input, offset, element_size);
+            break;
+        case 4:
+            end = rle_run_end<4>(input, offset, element_size);
+            break;
+        default:
+            end = rle_run_end<0>(input, offset, element_size);
+            break;
+        }
+        put_varint(out, (end - offset) / element_size);
+        out.insert(out.end(), input.begin() + static_cast<std::ptrdiff_t>(offset),
+            input.begin() + static_cast<std::ptrdiff_t>(offset + element_size));
+        offset = end;
+    }
+}
 
-class chunk_storage {
-public:
-    using byte_vector = std::vector<std::byte>;
-    struct planes_view {
-        voxel_span<voxel_id> voxels{};
-        voxel_span<std::uint8_t> skylight{};
-        voxel_span<std::uint8_t> blocklight{};
-        voxel_span<std::uint8_t> metadata{};
-        voxel_span<material_index> materials{};
-        std::span<float> skylight_cache{};
-        std::span<float> blocklight_cache{};
-        voxel_span<float> effect_density{};
-        voxel_span<effects::velocity_sample> effect_velocity{};
-        voxel_span<float> effect_lifetime{};
-    };
-    struct const_planes_view {
-        voxel_cspan<voxel_id> voxels{};
-        voxel_cspan<std::uint8_t> skylight{};
-        voxel_cspan<std::uint8_t> blocklight{};
-        voxel_cspan<std::uint8_t> metadata{};
-        std::span<const material_index> materials{};
-        std::span<const float> skylight_cache{};
-        std::span<const float> blocklight_cache{};
-        voxel_cspan<float> effect_density{};
-        voxel_cspan<effects::velocity_sample> effect_velocity{};
-        voxel_cspan<float> effect_lifetime{};
-    };
-    using compress_callback = std::function<byte_vector(const const_planes_view&)>;
-    using decompress_callback = std::function<void(const planes_view&, std::span<const std::byte>)>;
-    using dirty_listener = std::function<void()>;
+inline void decode_rle(std::span<const std::byte> input, std::span<std::byte> output, std::size_t element_size) {
+    check_elements(output.size(), element_size);
+    std::size_t in = 0;
+    std::size_t out = 0;
+    while (in < input.size()) {
+        const auto run = get_varint(input, in);
+        if (run == 0 || input.size() - in < element_size || run > (output.size() - out) / element_size) {
+            throw std::runtime_error("malformed rle run");
+        }
+        std::memcpy(output.data() + out, input.data() + in, element_size);
+        in += element_size;
+        repeat_pattern(output.data() + out, element_size, static_cast<std::size_t>(run) * element_size);
+        out += static_cast<std::size_t>(run) * element_size;
+    }
+    if (out != output.size()) {
+        throw std::runtime_error("rle stream shorter than plane");
+    }
+}
 
-    explicit chunk_storage(chunk_extent extent = cubic_extent(32));
-    explicit chunk_storage(chunk_storage_config config);
-    chunk_storage(const chunk_storage&) = delete;
-    chunk_storage& operator=(const chunk_storage&) = delete;
-    chunk_storage(chunk_storage&& other) noexcept;
-    chunk_storage& operator=(chunk_storage&& other) noexcept;
+// Delta + bit-packing works on 1, 2 or 4 byte words. Multi-word cells (velocity samples) are split into lanes so each
+// word is predicted from the same lane of the previous cell.
+struct word_layout {
+    std::size_t width{1};
+    std::size_t lag{1};
+};
 
-    [[nodiscard]] chunk_extent extent() const noexcept { return extent_; }
-    [[nodiscard]] std::size_t volume() const noexcept { return extent_.volume(); }
+inline word_layout layout_for(std::size_t element_size) noexcept {
+    if (element_size == 1 || element_size == 2 || element_size == 4) {
+        return {element_size, 1};
+    }
+    if (element_size % 4 == 0) {
+        return {4, element_size / 4};
+    }
+    if (element_size % 2 == 0) {
+        return {2, element_size / 2};
+    }
+    return {1, element_size};
+}
 
-    [[nodiscard]] span3d<voxel_id> voxels() noexcept;
-    [[nodiscard]] span3d<const voxel_id> voxels() const noexcept;
+inline constexpr std::size_t bitpack_block = 64;
 
-    [[nodiscard]] span3d<std::uint8_t> skylight() noexcept;
-    [[nodiscard]] span3d<const std::uint8_t> skylight() const noexcept;
+template <typename Word>
+void encode_delta_words(std::span<const std::byte> input, std::size_t lag, std::vector<std::byte>& out) {
+    constexpr std::uint32_t sign_shift = sizeof(Word) * 8 - 1;
+    const auto count = input.size() / sizeof(Word);
+    std::array<Word, bitpack_block> block{};
+    for (std::size_t base = 0; base < count; base += bitpack_block) {
+        const auto size = std::min(bitpack_block, count - base);
+        Word combined = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            const auto index = base + i;
+            Word current{};
+            Word previous{};
+            std::memcpy(&current, input.data() + index * sizeof(Word), sizeof(Word));
+            if (index >= lag) {
+                std::memcpy(&previous, input.data() + (index - lag) * sizeof(Word), sizeof(Word));
+            }
+            const auto delta = static_cast<Word>(current - previous);
+            const auto zigzag = static_cast<Word>(static_cast<Word>(delta << 1u) ^ static_cast<Word>(0u - (delta >> sign_shift)));
+            block[i] = zigzag;
+            combined = static_cast<Word>(combined | zigzag);
+        }
+        const auto bits = static_cast<std::uint32_t>(std::bit_width(combined));
+        out.push_back(static_cast<std::byte>(bits));
+        std::uint64_t accumulator = 0;
+        std::uint32_t pending = 0;
+        for (std::size_t i = 0; i < size && bits != 0; ++i) {
+            accumulator |= static_cast<std::uint64_t>(block[i]) << pending;
+            pending += bits;
+            while (pending >= 8) {
+                out.push_back(static_cast<std::byte>(accumulator & 0xFFu));
+                accumulator >>= 8u;
+                pending -= 8;
+            }
+        }
+        if (pending != 0) {
+            out.push_back(static_cast<std::byte>(accumulator & 0xFFu));
+        }
+    }
+}
 
-    [[nodiscard]] span3d<std::uint8_t> blocklight() noexcept;
-    [[nodiscard]] span3d<const std::uint8_t> blocklight() const noexcept;
+template <typename Word>
+void decode_delta_words(std::span<const std::byte> input, std::span<std::byte> output, std::size_t lag) {
+    const auto count = output.size() / sizeof(Word);
+    std::size_t in = 0;
+    for (std::size_t base = 0; base < count; base += bitpack_block) {
+        const auto size = std::min(bitpack_block, count - base);
+        if (in >= input.size()) {
+            throw std::runtime_error("truncated bitpack stream");
+        }
+        const auto bits = std::to_integer<std::uint32_t>(input[in++]);
+        if (bits > sizeof(Word) * 8) {
+            throw std::runtime_error("malformed bitpack width");
+        }
+        if (input.size() - in < (size * bits + 7) / 8) {
+            throw std::runtime_error("truncated bitpack stream");
+        }
+        const std::uint64_t value_mask = bits == 0 ? 0u : (std::uint64_t{1} << bits) - 1u;
+        std::uint64_t accumulator = 0;
+        std::uint32_t available = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            while (available < bits) {
+                accumulator |= std::to_integer<std::uint64_t>(input[in++]) << available;
+                available += 8;
+            }
+            const auto zigzag = static_cast<Word>(accumulator & value_mask);
+            accumulator >>= bits;
+            available -= bits;
+
+            const auto index = base + i;
+            const auto delta = static_cast<Word>((zigzag >> 1u) ^ static_cast<Word>(0u - (zigzag & 1u)));
+            Word previous{};
+            if (index >= lag) {
+                std::memcpy(&previous, output.data() + (index - lag) * sizeof(Word), sizeof(Word));
+            }
+            const auto current = static_cast<Word>(previous + delta);
+            std::memcpy(output.data() + index * sizeof(Word), &current, sizeof(Word));
+        }
+    }
+    if (in != input.size()) {
+        throw std::runtime_error("trailing bitpack data");
+    }
+}
 
-    [[nodiscard]] span3d<std::uint8_t> metadata() noexcept;
-    [[nodiscard]] span3d<const std::uint8_t> metadata() const noexcept;
+inline void encode_delta_bitpack(std::span<const std::byte> input, std::size_t element_size,
+    std::vector<std::byte>& out) {
+    check_elements(input.size(), element_size);
+    const auto layout = layout_for(element_size);
+    switch (layout.width) {
+    case 4:
+        encode_delta_words<std::uint32_t>(input, layout.lag, out);
+        break;
+    case 2:
+        encode_delta_words<std::uint16_t>(input, layout.lag, out);
+        break;
+    default:
+        encode_delta_words<std::uint8_t>(input, layout.lag, out);
+        break;
+    }
+}
 
-    [[nodiscard]] bool materials_enabled() const noexcept { return materials_enabled_; }
-    [[nodiscard]] span3d<material_index> materials();
-    [[nodiscard]] span3d<const material_index> materials() const;
+inline void decode_delta_bitpack(std::span<const std::byte> input, std::span<std::byte> output,
+    std::size_t element_size) {
+    check_elements(output.size(), element_size);
+    const auto layout = layout_for(element_size);
+    switch (layout.width) {
+    case 4:
+        decode_delta_words<std::uint32_t>(input, output, layout.lag);
+        break;
+    case 2:
+        decode_delta_words<std::uint16_t>(input, output, layout.lag);
+        break;
+    default:
+        decode_delta_words<std::uint8_t>(input, output, layout.lag);
+        break;
+    }
+}
 
-    [[nodiscard]] bool high_precision_lighting_enabled() const noexcept { return high_precision_lighting_enabled_; }
-    [[nodiscard]] span3d<float> skylight_cache();
-    [[nodiscard]] span3d<const float> skylight_cache() const;
-    [[nodiscard]] span3d<float> blocklight_cache();
-    [[nodiscard]] span3d<const float> blocklight_cache() const;
+// Byte-oriented LZ77 in the LZ4 block layout: token (literal length << 4 | match length - 4), extended lengths as
+// 255-continued bytes, literals, then a 16-bit little-endian offset. The last sequence carries literals only.
+inline constexpr std::size_t lz_min_match = 4;
+inline constexpr std::size_t lz_hash_bits = 12;
+inline constexpr std::size_t lz_max_offset = 0xFFFF;
 
-    [[nodiscard]] effects::channel effect_channels() const noexcept { return effect_channels_; }
-    void set_effect_channels(effects::channel channels);
-    void enable_effect_channels(effects::channel channels);
+inline std::uint32_t lz_load(const std::byte* data) noexcept {
+    std::uint32_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
 
-    [[nodiscard]] bool effect_density_enabled() const noexcept;
-    [[nodiscard]] bool effect_velocity_enabled() const noexcept;
-    [[nodiscard]] bool effect_lifetime_enabled() const noexcept;
+inline void lz_put_length(std::vector<std::byte>& out, std::size_t length) {
+    while (length >= 255) {
+        out.push_back(std::byte{255});
+        length -= 255;
+    }
+    out.push_back(static_cast<std::byte>(length));
+}
 
-    [[nodiscard]] span3d<float> effect_density();
-    [[nodiscard]] span3d<const float> effect_density() const;
-    [[nodiscard]] span3d<effects::velocity_sample> effect_velocity();
-    [[nodiscard]] span3d<const effects::velocity_sample> effect_velocity() const;
-    [[nodiscard]] span3d<float> effect_lifetime();
-    [[nodiscard]] span3d<const float> effect_lifetime() const;
+inline void lz_emit(std::vector<std::byte>& out, std::span<const std::byte> literals, std::size_t offset,
+    std::size_t match) {
+    const auto literal_code = std::min<std::size_t>(literals.size(), 15);
+    const auto match_code = match == 0 ? 0 : std::min<std::size_t>(match - lz_min_match, 15);
+    out.push_back(static_cast<std::byte>((literal_code << 4u) | match_code));
+    if (literal_code == 15) {
+        lz_put_length(out, literals.size() - 15);
+    }
+    out.insert(out.end(), literals.begin(), literals.end());
+    if (match == 0) {
+        return;
+    }
+    out.push_back(static_cast<std::byte>(offset & 0xFFu));
+    out.push_back(static_cast<std::byte>(offset >> 8u));
+    if (match_code == 15) {
+        lz_put_length(out, match - lz_min_match - 15);
+    }
+}
+
+inline void encode_lz(std::span<const std::byte> input, std::size_t, std::vector<std::byte>& out) {
+    const auto size = input.size();
+    const auto* data = input.data();
+    std::size_t anchor = 0;
+    // Matches never start in the last 12 bytes and never cover the last 5, mirroring LZ4's end-of-block rules.
+    if (size >= 13) {
+        std::vector<std::uint32_t> table(std::size_t{1} << lz_hash_bits, 0);
+        const auto start_limit = size - 12;
+        const auto match_limit = size - 5;
+        std::size_t position = 0;
+        while (position < start_limit) {
+            const auto sequence = lz_load(data + position);
+            const auto hash = (sequence * 2654435761u) >> (32u - lz_hash_bits);
+            const auto candidate = static_cast<std::size_t>(table[hash]);
+            table[hash] = static_cast<std::uint32_t>(position + 1);
+            if (candidate != 0 && position - (candidate - 1) <= lz_max_offset
+                && lz_load(data + candidate - 1) == sequence) {
+                const auto source = candidate - 1;
+                auto length = lz_min_match;
+                while (position + length < match_limit && data[source + length] == data[position + length]) {
+                    ++length;
+                }
+                lz_emit(out, input.subspan(anchor, position - anchor), position - source, length);
+                position += length;
+                anchor = position;
+                continue;
+            }
+            // Skip faster through incompressible stretches.
+            position += 1 + ((position - anchor) >> 6u);
+        }
+    }
+    lz_emit(out, input.subspan(anchor), 0, 0);
+}
 
-    void fill(voxel_id voxel, std::uint8_t sky_level = 0, std::uint8_t block_level = 0, std::uint8_t meta = 0,
-        material_index material = invalid_material_index, float sky_cache = 0.0f, float block_cache = 0.0f);
-    void assign_voxels(voxel_cspan<voxel_id> data);
+inline std::size_t lz_get_length(std::span<const std::byte> input, std::size_t& offset) {
+    std::size_t length = 0;
+    for (;;) {
+        if (offset >= input.size()) {
+            throw std::runtime_error("truncated lz stream");
+        }
+        const auto byte = std::to_integer<std::size_t>(input[offset++]);
+        length += byte;
+        if (byte != 255) {
+            return length;
+        }
+    }
+}
 
-    void set_compression_hooks(compress_callback compressor, decompress_callback decompressor = {});
-    void request_compression() noexcept { compression_requested_ = true; }
-    [[nodiscard]] bool flush_compression();
-    [[nodiscard]] bool decompress();
-
-    [[nodiscard]] bool compressed() const noexcept { return compressed_; }
-    [[nodiscard]] std::span<const std::byte> compressed_blob() const noexcept { return compressed_blob_; }
-
-    void clear_compression() {
-        compression_requested_ = false;
-        compressed_ = false;
-        compressed_blob_.clear();
+inline void decode_lz(std::span<const std::byte> input, std::span<std::byte> output, std::size_t) {
+    std::size_t in = 0;
+    std::size_t out = 0;
+    while (in < input.size()) {
+        const auto token = std::to_integer<std::size_t>(input[in++]);
+        auto literals = token >> 4u;
+        if (literals == 15) {
+            literals += lz_get_length(input, in);
+        }
+        if (literals > input.size() - in || literals > output.size() - out) {
+            throw std::runtime_error("malformed lz literals");
+        }
+        if (literals > 0) {
+            std::memcpy(output.data() + out, input.data() + in, literals);
+        }
+        in += literals;
+        out += literals;
+        if (in == input.size()) {
+            break;
+        }
+        if (input.size() - in < 2) {
+            throw std::runtime_error("truncated lz stream");
+        }
+        const auto offset = std::to_integer<std::size_t>(input[in]) | (std::to_integer<std::size_t>(input[in + 1]) << 8u);
+        in += 2;
+        auto match = (token & 0x0Fu) + lz_min_match;
+        if ((token & 0x0Fu) == 15) {
+            match += lz_get_length(input, in);
+        }
+        if (offset == 0 || offset > out || match > output.size() - out) {
+            throw std::runtime_error("malformed lz match");
+        }
+        auto* target = output.data() + out;
+        if (offset >= match) {
+            std::memcpy(target, target - offset, match);
+        } else {
+            repeat_pattern(target - offset, offset, offset + match);
+        }
+        out += match;
+    }
+    if (out != output.size()) {
+        throw std::runtime_error("lz stream shorter than plane");
     }
+}
 
-    void mark_dirty(bool value = true) noexcept;
-    [[nodiscard]] bool dirty() const noexcept { return dirty_; }
+} // namespace detail::codecs
 
-    void add_dirty_listener(dirty_listener listener);
-    void clear_dirty_listeners();
+// Process-wide codec table shared by every chunk. Built-ins are registered on construction; custom codecs are added
+// once at startup and referenced by id from chunk_codec_config, so chunks carry a codec id instead of closures.
+class codec_registry {
+public:
+    codec_registry();
+    codec_registry(const codec_registry&) = delete;
+    codec_registry& operator=(const codec_registry&) = delete;
 
-private:
-    void ensure_capacity();
-    [[nodiscard]] planes_view make_planes_view() noexcept;
-    [[nodiscard]] const_planes_view make_const_planes_view() const noexcept;
-    void ensure_decompressed();
-    void decompress_locked();
+    [[nodiscard]] static codec_registry& shared();
 
-    chunk_extent extent_{};
-    std::vector<voxel_id> voxels_{};
-    std::vector<std::uint8_t> skylight_{};
-    std::vector<std::uint8_t> blocklight_{};
-    std::vector<std::uint8_t> metadata_{};
-    bool materials_enabled_{false};
-    bool high_precision_lighting_enabled_{false};
-    effects::channel effect_channels_{effects::channel::none};
-    std::vector<material_index> materials_{};
-    std::vector<float> skylight_cache_{};
-    std::vector<float> blocklight_cache_{};
-    std::vector<float> effect_density_{};
-    std::vector<effects::velocity_sample> effect_velocity_{};
-    std::vector<float> effect_lifetime_{};
+    void add(codec_id id, codec entry);
+    [[nodiscard]] std::optional<codec> find(codec_id id) const;
+    [[nodiscard]] codec get(codec_id id) const;
 
-    compress_callback compress_{};
-    decompress_callback decompress_{};
+    // Appends the encoded plane to `out` and returns the codec actually used. `automatic` tries each built-in and
+    // keeps the smallest stream, falling back to raw when nothing beats it.
+    codec_id encode(codec_id id, std::span<const std::byte> input, std::size_t element_size,
+        std::vector<std::byte>& out) const;
+    void decode(codec_id id, std::span<const std::byte> input, std::span<std::byte> output,
+        std::size_t element_size) const;
 
-    bool dirty_{false};
-    bool compression_requested_{false};
-    bool compressed_{false};
-    byte_vector compressed_blob_{};
-    std::mutex compression_mutex_{};
-    std::vector<dirty_listener> dirty_listeners_{};
+private:
+    std::array<codec, 256> codecs_{};
+    mutable std::shared_mutex mutex_{};
 };
 
-inline chunk_storage::chunk_storage(chunk_extent extent)
-    : chunk_storage(chunk_storage_config{extent}) {
+inline codec_registry::codec_registry() {
+    using namespace detail::codecs;
+    codecs_[static_cast<std::size_t>(codec_id::raw)] = codec{"raw", &encode_raw, &decode_raw};
+    codecs_[static_cast<std::size_t>(codec_id::rle)] = codec{"rle", &encode_rle, &decode_rle};
+    codecs_[static_cast<std::size_t>(codec_id::delta_bitpack)] =
+        codec{"delta_bitpack", &encode_delta_bitpack, &decode_delta_bitpack};
+    codecs_[static_cast<std::size_t>(codec_id::lz)] = codec{"lz", &encode_lz, &decode_lz};
 }
 
-inline chunk_storage::chunk_storage(chunk_storage_config config)
-    : extent_{config.extent}
-    , materials_enabled_{config.enable_materials}
-    , high_precision_lighting_enabled_{config.enable_high_precision_lighting}
-    , effect_channels_{config.effect_channels} {
-    ensure_capacity();
+inline codec_registry& codec_registry::shared() {
+    static codec_registry registry;
+    return registry;
 }
 
-inline chunk_storage::chunk_storage(chunk_storage&& other) noexcept
-    : extent_{other.extent_}
-    , voxels_{std::move(other.voxels_)}
-    , skylight_{std::move(other.skylight_)}
-    , blocklight_{std::move(other.blocklight_)}
-    , metadata_{std::move(other.metadata_)}
-    , materials_enabled_{other.materials_enabled_}
-    , high_precision_lighting_enabled_{other.high_precision_lighting_enabled_}
-    , effect_channels_{other.effect_channels_}
-    , materials_{std::move(other.materials_)}
-    , skylight_cache_{std::move(other.skylight_cache_)}
-    , blocklight_cache_{std::move(other.blocklight_cache_)}
-    , effect_density_{std::move(other.effect_density_)}
-    , effect_velocity_{std::move(other.effect_velocity_)}
-    , effect_lifetime_{std::move(other.effect_lifetime_)}
-    , compress_{std::move(other.compress_)}
-    , decompress_{std::move(other.decompress_)}
-    , dirty_{other.dirty_}
-    , compression_requested_{other.compression_requested_}
-    , compressed_{other.compressed_}
-    , compressed_blob_{std::move(other.compressed_blob_)}
-    , dirty_listeners_{std::move(other.dirty_listeners_)} {
-    other.extent_ = chunk_extent{};
-    other.materials_enabled_ = false;
-    other.high_precision_lighting_enabled_ = false;
-    other.effect_channels_ = effects::channel::none;
-    other.materials_.clear();
-    other.skylight_cache_.clear();
-    other.blocklight_cache_.clear();
-    other.effect_density_.clear();
-    other.effect_velocity_.clear();
-    other.effect_lifetime_.clear();
-    other.dirty_ = false;
-    other.compression_requested_ = false;
-    other.compressed_ = false;
-    other.dirty_listeners_.clear();
+inline void codec_registry::add(codec_id id, codec entry) {
+    if (static_cast<std::uint8_t>(id) < first_custom_codec_id || id == codec_id::automatic) {
+        throw std::logic_error("codec id is reserved");
+    }
+    if (!entry) {
+        throw std::logic_error("codec requires encode and decode functions");
+    }
+    std::unique_lock lock{mutex_};
+    codecs_[static_cast<std::size_t>(id)] = entry;
 }
 
-inline chunk_storage& chunk_storage::operator=(chunk_storage&& other) noexcept {
-    if (this != &other) {
-        std::scoped_lock lock{compression_mutex_, other.compression_mutex_};
-        extent_ = other.extent_;
-        voxels_ = std::move(other.voxels_);
-        skylight_ = std::move(other.skylight_);
-        blocklight_ = std::move(other.blocklight_);
-        metadata_ = std::move(other.metadata_);
-        materials_enabled_ = other.materials_enabled_;
-        high_precision_lighting_enabled_ = other.high_precision_lighting_enabled_;
-        effect_channels_ = other.effect_channels_;
-        materials_ = std::move(other.materials_);
-        skylight_cache_ = std::move(other.skylight_cache_);
-        blocklight_cache_ = std::move(other.blocklight_cache_);
-        effect_density_ = std::move(other.effect_density_);
-        effect_velocity_ = std::move(other.effect_velocity_);
-        effect_lifetime_ = std::move(other.effect_lifetime_);
-        compress_ = std::move(other.compress_);
-        decompress_ = std::move(other.decompress_);
-        dirty_ = other.dirty_;
-        compression_requested_ = other.compression_requested_;
-        compressed_ = other.compressed_;
-        compressed_blob_ = std::move(other.compressed_blob_);
-        dirty_listeners_ = std::move(other.dirty_listeners_);
+inline std::optional<codec> codec_registry::find(codec_id id) const {
+    std::shared_lock lock{mutex_};
+    const auto& entry = codecs_[static_cast<std::size_t>(id)];
+    if (!entry) {
+        return std::nullopt;
+    }
+    return entry;
+}
 
-        other.extent_ = chunk_extent{};
-        other.materials_enabled_ = false;
-        other.high_precision_lighting_enabled_ = false;
-        other.effect_channels_ = effects::channel::none;
-        other.materials_.clear();
-        other.skylight_cache_.clear();
-        other.blocklight_cache_.clear();
-        other.effect_density_.clear();
-        other.effect_velocity_.clear();
-        other.effect_lifetime_.clear();
-        other.dirty_ = false;
-        other.compression_requested_ = false;
-        other.compressed_ = false;
-        other.compressed_blob_.clear();
-        other.compress_ = {};
-        other.decompress_ = {};
-        other.dirty_listeners_.clear();
+inline codec codec_registry::get(codec_id id) const {
+    auto entry = find(id);
+    if (!entry) {
+        throw std::out_of_range("unknown codec id");
     }
-    return *this;
+    return *entry;
 }
 
-inline void chunk_storage::mark_dirty(bool value) noexcept {
-    const bool notify = value;
-    if (dirty_ != value) {
-        dirty_ = value;
-    }
-    if (notify && !dirty_listeners_.empty()) {
-        for (auto& listener : dirty_listeners_) {
-            if (listener) {
-                listener();
-            }
+inline codec_id codec_registry::encode(codec_id id, std::span<const std::byte> input, std::size_t element_size,
+    std::vector<std::byte>& out) const {
+    if (id != codec_id::automatic) {
+        get(id).encode(input, element_size, out);
+        return id;
+    }
+    codec_id best = codec_id::raw;
+    std::vector<std::byte> best_stream{};
+    std::vector<std::byte> candidate{};
+    for (const auto option : {codec_id::rle, codec_id::delta_bitpack, codec_id::lz}) {
+        candidate.clear();
+        get(option).encode(input, element_size, candidate);
+        if (candidate.size() < input.size() && (best == codec_id::raw || candidate.size() < best_stream.size())) {
+            best = option;
+            best_stream.swap(candidate);
         }
     }
+    if (best == codec_id::raw) {
+        out.insert(out.end(), input.begin(), input.end());
+    } else {
+        out.insert(out.end(), best_stream.begin(), best_stream.end());
+    }
+    return best;
 }
 
-inline void chunk_storage::add_dirty_listener(dirty_listener listener) {
-    dirty_listeners_.push_back(std::move(listener));
+inline void codec_registry::decode(codec_id id, std::span<const std::byte> input, std::span<std::byte> output,
+    std::size_t element_size) const {
+    get(id).decode(input, output, element_size);
 }
 
-inline void chunk_storage::clear_dirty_listeners() {
-    dirty_listeners_.clear();
-}
+} // namespace almond::voxel
+// end: almond_voxel/storage/codecs.hpp
 
-inline span3d<voxel_id> chunk_storage::voxels() noexcept {
-    ensure_decompressed();
-    mark_dirty();
-    return make_span3d(voxels_.data(), extent_);
-}
+// begin: almond_voxel/storage/palette_plane.hpp
 
-inline span3d<const voxel_id> chunk_storage::voxels() const noexcept {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    return make_span3d(voxels_.data(), extent_);
-}
 
-inline span3d<std::uint8_t> chunk_storage::skylight() noexcept {
-    ensure_decompressed();
-    mark_dirty();
-    return make_span3d(skylight_.data(), extent_);
-}
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
 
-inline span3d<const std::uint8_t> chunk_storage::skylight() const noexcept {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    return make_span3d(skylight_.data(), extent_);
-}
+namespace almond::voxel {
 
-inline span3d<std::uint8_t> chunk_storage::blocklight() noexcept {
-    ensure_decompressed();
-    mark_dirty();
-    return make_span3d(blocklight_.data(), extent_);
-}
+// Palette-compressed voxel plane. Each cell stores an index into a per-plane palette using 0, 1, 2, 4 or 8 bits;
+// once more than 256 distinct ids are present the plane switches to direct 16-bit storage and drops the palette.
+// Index widths always divide 64 so no index straddles a word boundary.
+class palette_plane {
+public:
+    using word_type = std::uint64_t;
 
-inline span3d<const std::uint8_t> chunk_storage::blocklight() const noexcept {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    return make_span3d(blocklight_.data(), extent_);
-}
+    static constexpr std::uint32_t word_bits = 64;
+    static constexpr std::uint32_t max_palette_bits = 8;
+    static constexpr std::uint32_t direct_bits = 16;
 
-inline span3d<std::uint8_t> chunk_storage::metadata() noexcept {
-    ensure_decompressed();
-    mark_dirty();
-    return make_span3d(metadata_.data(), extent_);
-}
+    palette_plane() = default;
+    explicit palette_plane(std::size_t count, voxel_id value = voxel_id{});
 
-inline span3d<const std::uint8_t> chunk_storage::metadata() const noexcept {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    return make_span3d(metadata_.data(), extent_);
-}
+    [[nodiscard]] static palette_plane from_dense(voxel_cspan<voxel_id> values);
 
-inline span3d<material_index> chunk_storage::materials() {
-    ensure_decompressed();
-    if (!materials_enabled_) {
-        throw std::logic_error("material plane is disabled");
-    }
-    mark_dirty();
-    return make_span3d(materials_.data(), extent_);
-}
+    [[nodiscard]] std::size_t size() const noexcept { return count_; }
+    [[nodiscard]] std::uint32_t bits_per_index() const noexcept { return bits_; }
+    [[nodiscard]] bool direct() const noexcept { return bits_ == direct_bits; }
+    [[nodiscard]] std::span<const voxel_id> palette() const noexcept { return palette_; }
+    [[nodiscard]] std::span<const word_type> words() const noexcept { return words_; }
 
-inline span3d<const material_index> chunk_storage::materials() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    if (!materials_enabled_) {
-        throw std::logic_error("material plane is disabled");
-    }
-    return make_span3d(materials_.data(), extent_);
-}
+    [[nodiscard]] voxel_id get(std::size_t index) const noexcept;
+    void set(std::size_t index, voxel_id value);
+    void fill(voxel_id value);
+    void decode(voxel_span<voxel_id> out) const;
+    void compact();
 
-inline span3d<float> chunk_storage::skylight_cache() {
-    ensure_decompressed();
-    if (!high_precision_lighting_enabled_) {
-        throw std::logic_error("high precision lighting cache is disabled");
+    [[nodiscard]] std::size_t memory_usage() const noexcept {
+        return palette_.capacity() * sizeof(voxel_id) + words_.capacity() * sizeof(word_type);
     }
-    mark_dirty();
-    return make_span3d(skylight_cache_.data(), extent_);
+
+private:
+    [[nodiscard]] static std::size_t word_count(std::size_t count, std::uint32_t bits) noexcept;
+    [[nodiscard]] static std::uint32_t bits_for(std::size_t palette_size) noexcept;
+
+    [[nodiscard]] std::uint32_t read_index(std::size_t index) const noexcept;
+    void write_index(std::size_t index, std::uint32_t value) noexcept;
+    [[nodiscard]] std::uint32_t index_of(voxel_id value);
+    void repack(std::uint32_t bits);
+
+    std::size_t count_{0};
+    std::uint32_t bits_{0};
+    std::vector<voxel_id> palette_{};
+    std::vector<word_type> words_{};
+};
+
+inline palette_plane::palette_plane(std::size_t count, voxel_id value)
+    : count_{count}
+    , palette_{value} {
 }
 
-inline span3d<const float> chunk_storage::skylight_cache() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    if (!high_precision_lighting_enabled_) {
-        throw std::logic_error("high precision lighting cache is disabled");
+inline palette_plane palette_plane::from_dense(voxel_cspan<voxel_id> values) {
+    palette_plane plane{};
+    plane.count_ = values.size();
+    if (values.empty()) {
+        return plane;
     }
-    return make_span3d(skylight_cache_.data(), extent_);
-}
 
-inline span3d<float> chunk_storage::blocklight_cache() {
-    ensure_decompressed();
-    if (!high_precision_lighting_enabled_) {
-        throw std::logic_error("high precision lighting cache is disabled");
+    std::vector<voxel_id> palette;
+    bool direct = false;
+    voxel_id last = values.front();
+    palette.push_back(last);
+    for (const voxel_id value : values) {
+        if (value == last) {
+            continue;
+        }
+        last = value;
+        if (std::find(palette.begin(), palette.end(), value) == palette.end()) {
+            palette.push_back(value);
+            if (palette.size() > (std::size_t{1} << max_palette_bits)) {
+                direct = true;
+                break;
+            }
+        }
     }
-    mark_dirty();
-    return make_span3d(blocklight_cache_.data(), extent_);
-}
 
-inline span3d<const float> chunk_storage::blocklight_cache() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    if (!high_precision_lighting_enabled_) {
-        throw std::logic_error("high precision lighting cache is disabled");
+    if (direct) {
+        plane.bits_ = direct_bits;
+        plane.words_.assign(word_count(plane.count_, direct_bits), word_type{0});
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            plane.write_index(i, values[i]);
+        }
+        return plane;
+    }
+
+    plane.palette_ = std::move(palette);
+    plane.bits_ = bits_for(plane.palette_.size());
+    if (plane.bits_ == 0) {
+        return plane;
+    }
+    plane.words_.assign(word_count(plane.count_, plane.bits_), word_type{0});
+    std::uint32_t last_index = 0;
+    last = plane.palette_.front();
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (values[i] != last) {
+            last = values[i];
+            const auto it = std::find(plane.palette_.begin(), plane.palette_.end(), last);
+            last_index = static_cast<std::uint32_t>(it - plane.palette_.begin());
+        }
+        plane.write_index(i, last_index);
     }
-    return make_span3d(blocklight_cache_.data(), extent_);
+    return plane;
 }
 
-inline bool chunk_storage::effect_density_enabled() const noexcept {
-    return effects::contains(effect_channels_, effects::channel::density);
+inline voxel_id palette_plane::get(std::size_t index) const noexcept {
+    if (direct()) {
+        return static_cast<voxel_id>(read_index(index));
+    }
+    return palette_[read_index(index)];
 }
 
-inline bool chunk_storage::effect_velocity_enabled() const noexcept {
-    return effects::contains(effect_channels_, effects::channel::velocity);
+inline void palette_plane::set(std::size_t index, voxel_id value) {
+    if (index >= count_) {
+        throw std::out_of_range("palette index out of range");
+    }
+    if (direct()) {
+        write_index(index, value);
+        return;
+    }
+    write_index(index, index_of(value));
 }
 
-inline bool chunk_storage::effect_lifetime_enabled() const noexcept {
-    return effects::contains(effect_channels_, effects::channel::lifetime);
+inline void palette_plane::fill(voxel_id value) {
+    bits_ = 0;
+    palette_.assign(1, value);
+    words_.clear();
+    words_.shrink_to_fit();
 }
 
-inline void chunk_storage::set_effect_channels(effects::channel channels) {
-    ensure_decompressed();
-    if (effect_channels_ == channels) {
-        return;
+inline void palette_plane::decode(voxel_span<voxel_id> out) const {
+    if (out.size() != count_) {
+        throw std::runtime_error("palette decode size mismatch");
     }
-    const effects::channel previous = effect_channels_;
-    effect_channels_ = channels;
-    const auto count = extent_.volume();
-
-    if (effects::contains(channels, effects::channel::density)) {
-        if (!effects::contains(previous, effects::channel::density)) {
-            effect_density_.assign(count, 0.0f);
-        } else if (effect_density_.size() != count) {
-            effect_density_.resize(count, 0.0f);
-        }
-    } else {
-        effect_density_.clear();
+    if (bits_ == 0) {
+        std::fill(out.begin(), out.end(), palette_.empty() ? voxel_id{} : palette_.front());
+        return;
     }
 
-    if (effects::contains(channels, effects::channel::velocity)) {
-        if (!effects::contains(previous, effects::channel::velocity)) {
-            effect_velocity_.assign(count, effects::velocity_sample{});
-        } else if (effect_velocity_.size() != count) {
-            effect_velocity_.resize(count, effects::velocity_sample{});
+    const std::uint32_t per_word = word_bits / bits_;
+    const word_type mask = (word_type{1} << bits_) - 1;
+    std::size_t index = 0;
+    for (const word_type word : words_) {
+        word_type bits = word;
+        for (std::uint32_t slot = 0; slot < per_word && index < count_; ++slot, ++index) {
+            const auto value = static_cast<std::uint32_t>(bits & mask);
+            out[index] = direct() ? static_cast<voxel_id>(value) : palette_[value];
+            bits >>= bits_;
         }
-    } else {
-        effect_velocity_.clear();
     }
+}
 
-    if (effects::contains(channels, effects::channel::lifetime)) {
-        if (!effects::contains(previous, effects::channel::lifetime)) {
-            effect_lifetime_.assign(count, 0.0f);
-        } else if (effect_lifetime_.size() != count) {
-            effect_lifetime_.resize(count, 0.0f);
-        }
-    } else {
-        effect_lifetime_.clear();
+inline void palette_plane::compact() {
+    if (count_ == 0) {
+        return;
     }
-
-    mark_dirty();
+    std::vector<voxel_id> dense(count_);
+    decode(dense);
+    *this = from_dense(dense);
 }
 
-inline void chunk_storage::enable_effect_channels(effects::channel channels) {
-    set_effect_channels(effect_channels_ | channels);
+inline std::size_t palette_plane::word_count(std::size_t count, std::uint32_t bits) noexcept {
+    if (bits == 0) {
+        return 0;
+    }
+    const std::size_t per_word = word_bits / bits;
+    return (count + per_word - 1) / per_word;
 }
 
-inline span3d<float> chunk_storage::effect_density() {
-    ensure_decompressed();
-    if (!effect_density_enabled()) {
-        throw std::logic_error("effect density channel is disabled");
+inline std::uint32_t palette_plane::bits_for(std::size_t palette_size) noexcept {
+    std::uint32_t bits = 0;
+    while ((std::size_t{1} << bits) < palette_size) {
+        bits = bits == 0 ? 1 : bits * 2;
     }
-    mark_dirty();
-    return make_span3d(effect_density_.data(), extent_);
+    return bits;
 }
 
-inline span3d<const float> chunk_storage::effect_density() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    if (!effect_density_enabled()) {
-        throw std::logic_error("effect density channel is disabled");
+inline std::uint32_t palette_plane::read_index(std::size_t index) const noexcept {
+    if (bits_ == 0) {
+        return 0;
     }
-    return make_span3d(effect_density_.data(), extent_);
+    const std::uint32_t per_word = word_bits / bits_;
+    const std::size_t word = index / per_word;
+    const std::uint32_t shift = static_cast<std::uint32_t>(index % per_word) * bits_;
+    const word_type mask = (word_type{1} << bits_) - 1;
+    return static_cast<std::uint32_t>((words_[word] >> shift) & mask);
 }
 
-inline span3d<effects::velocity_sample> chunk_storage::effect_velocity() {
-    ensure_decompressed();
-    if (!effect_velocity_enabled()) {
-        throw std::logic_error("effect velocity channel is disabled");
+inline void palette_plane::write_index(std::size_t index, std::uint32_t value) noexcept {
+    if (bits_ == 0) {
+        return;
     }
-    mark_dirty();
-    return make_span3d(effect_velocity_.data(), extent_);
+    const std::uint32_t per_word = word_bits / bits_;
+    const std::size_t word = index / per_word;
+    const std::uint32_t shift = static_cast<std::uint32_t>(index % per_word) * bits_;
+    const word_type mask = ((word_type{1} << bits_) - 1) << shift;
+    words_[word] = (words_[word] & ~mask) | ((static_cast<word_type>(value) << shift) & mask);
 }
 
-inline span3d<const effects::velocity_sample> chunk_storage::effect_velocity() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    if (!effect_velocity_enabled()) {
-        throw std::logic_error("effect velocity channel is disabled");
+inline std::uint32_t palette_plane::index_of(voxel_id value) {
+    if (const auto it = std::find(palette_.begin(), palette_.end(), value); it != palette_.end()) {
+        return static_cast<std::uint32_t>(it - palette_.begin());
     }
-    return make_span3d(effect_velocity_.data(), extent_);
-}
 
-inline span3d<float> chunk_storage::effect_lifetime() {
-    ensure_decompressed();
-    if (!effect_lifetime_enabled()) {
-        throw std::logic_error("effect lifetime channel is disabled");
+    if (palette_.size() + 1 > (std::size_t{1} << max_palette_bits)) {
+        repack(direct_bits);
+        return value;
     }
-    mark_dirty();
-    return make_span3d(effect_lifetime_.data(), extent_);
-}
 
-inline span3d<const float> chunk_storage::effect_lifetime() const {
-    const_cast<chunk_storage*>(this)->ensure_decompressed();
-    if (!effect_lifetime_enabled()) {
-        throw std::logic_error("effect lifetime channel is disabled");
+    palette_.push_back(value);
+    const std::uint32_t required = bits_for(palette_.size());
+    if (required > bits_) {
+        repack(required);
     }
-    return make_span3d(effect_lifetime_.data(), extent_);
+    return static_cast<std::uint32_t>(palette_.size() - 1);
 }
 
-inline void chunk_storage::fill(voxel_id voxel, std::uint8_t sky_level, std::uint8_t block_level, std::uint8_t meta,
-    material_index material, float sky_cache, float block_cache) {
-    ensure_decompressed();
-    std::fill(voxels_.begin(), voxels_.end(), voxel);
-    std::fill(skylight_.begin(), skylight_.end(), sky_level);
-    std::fill(blocklight_.begin(), blocklight_.end(), block_level);
-    std::fill(metadata_.begin(), metadata_.end(), meta);
-    if (materials_enabled_) {
-        std::fill(materials_.begin(), materials_.end(), material);
-    }
-    if (high_precision_lighting_enabled_) {
-        std::fill(skylight_cache_.begin(), skylight_cache_.end(), sky_cache);
-        std::fill(blocklight_cache_.begin(), blocklight_cache_.end(), block_cache);
-    }
-    if (effect_density_enabled()) {
-        std::fill(effect_density_.begin(), effect_density_.end(), 0.0f);
-    }
-    if (effect_velocity_enabled()) {
-        std::fill(effect_velocity_.begin(), effect_velocity_.end(), effects::velocity_sample{});
+inline void palette_plane::repack(std::uint32_t bits) {
+    palette_plane next{};
+    next.count_ = count_;
+    next.bits_ = bits;
+    next.words_.assign(word_count(count_, bits), word_type{0});
+    const bool to_direct = bits == direct_bits;
+    for (std::size_t i = 0; i < count_; ++i) {
+        const std::uint32_t old_index = read_index(i);
+        next.write_index(i, to_direct ? palette_[old_index] : old_index);
     }
-    if (effect_lifetime_enabled()) {
-        std::fill(effect_lifetime_.begin(), effect_lifetime_.end(), 0.0f);
+    if (!to_direct) {
+        next.palette_ = std::move(palette_);
     }
-    mark_dirty();
+    *this = std::move(next);
 }
 
-inline void chunk_storage::assign_voxels(voxel_cspan<voxel_id> data) {
-    ensure_decompressed();
-    if (data.size() != voxels_.size()) {
-        throw std::runtime_error("voxel data size mismatch");
-    }
-    std::copy(data.begin(), data.end(), voxels_.begin());
-    mark_dirty();
-}
+} // namespace almond::voxel
+// end: almond_voxel/storage/palette_plane.hpp
 
-inline void chunk_storage::set_compression_hooks(compress_callback compressor, decompress_callback decompressor) {
-    std::scoped_lock lock{compression_mutex_};
-    compress_ = std::move(compressor);
-    decompress_ = std::move(decompressor);
-}
+// begin: almond_voxel/chunk.hpp
 
-inline bool chunk_storage::flush_compression() {
-    std::scoped_lock lock{compression_mutex_};
-    if (!compression_requested_ || !compress_) {
-        return false;
-    }
-    decompress_locked();
-    const auto view = make_const_planes_view();
-    compressed_blob_ = compress_(view);
-    compression_requested_ = false;
-    compressed_ = true;
-    return true;
-}
 
-inline bool chunk_storage::decompress() {
-    std::scoped_lock lock{compression_mutex_};
-    if (!compressed_ || compressed_blob_.empty()) {
-        return false;
-    }
-    decompress_locked();
-    return true;
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel {
+
+enum class voxel_layout : std::uint8_t {
+    dense,
+    palette
+};
+
+// Bit flags naming the individual chunk planes. Used for per-plane dirty tracking and listener filters.
+enum class chunk_plane : std::uint32_t {
+    none = 0u,
+    voxels = 1u << 0u,
+    skylight = 1u << 1u,
+    blocklight = 1u << 2u,
+    metadata = 1u << 3u,
+    materials = 1u << 4u,
+    skylight_cache = 1u << 5u,
+    blocklight_cache = 1u << 6u,
+    effect_density = 1u << 7u,
+    effect_velocity = 1u << 8u,
+    effect_lifetime = 1u << 9u,
+    lighting = skylight | blocklight | skylight_cache | blocklight_cache,
+    effects = effect_density | effect_velocity | effect_lifetime,
+    all = voxels | lighting | metadata | materials | effects
+};
+
+constexpr chunk_plane operator|(chunk_plane lhs, chunk_plane rhs) noexcept {
+    return static_cast<chunk_plane>(static_cast<std::uint32_t>(lhs) | static_cast<std::uint32_t>(rhs));
 }
 
-inline void chunk_storage::ensure_capacity() {
-    const auto count = extent_.volume();
-    voxels_.assign(count, voxel_id{});
-    skylight_.assign(count, std::uint8_t{});
-    blocklight_.assign(count, std::uint8_t{});
-    metadata_.assign(count, std::uint8_t{});
-    if (materials_enabled_) {
-        materials_.assign(count, invalid_material_index);
-    } else {
-        materials_.clear();
-    }
-    if (high_precision_lighting_enabled_) {
-        skylight_cache_.assign(count, 0.0f);
-        blocklight_cache_.assign(count, 0.0f);
-    } else {
-        skylight_cache_.clear();
-        blocklight_cache_.clear();
-    }
-    if (effect_density_enabled()) {
-        effect_density_.assign(count, 0.0f);
-    } else {
-        effect_density_.clear();
-    }
-    if (effect_velocity_enabled()) {
-        effect_velocity_.assign(count, effects::velocity_sample{});
-    } else {
-        effect_velocity_.clear();
-    }
-    if (effect_lifetime_enabled()) {
-        effect_lifetime_.assign(count, 0.0f);
-    } else {
-        effect_lifetime_.clear();
-    }
+constexpr chunk_plane operator&(chunk_plane lhs, chunk_plane rhs) noexcept {
+    return static_cast<chunk_plane>(static_cast<std::uint32_t>(lhs) & static_cast<std::uint32_t>(rhs));
 }
 
-inline chunk_storage::planes_view chunk_storage::make_planes_view() noexcept {
-    planes_view view{};
-    view.voxels = make_span3d(voxels_.data(), extent_).linear();
-    view.skylight = make_span3d(skylight_.data(), extent_).linear();
-    view.blocklight = make_span3d(blocklight_.data(), extent_).linear();
-    view.metadata = make_span3d(metadata_.data(), extent_).linear();
-    if (materials_enabled_) {
-        view.materials = make_span3d(materials_.data(), extent_).linear();
-    }
-    if (high_precision_lighting_enabled_) {
-        view.skylight_cache = make_span3d(skylight_cache_.data(), extent_).linear();
-        view.blocklight_cache = make_span3d(blocklight_cache_.data(), extent_).linear();
-    }
-    if (effect_density_enabled()) {
-        view.effect_density = make_span3d(effect_density_.data(), extent_).linear();
-    }
-    if (effect_velocity_enabled()) {
-        view.effect_velocity = make_span3d(effect_velocity_.data(), extent_).linear();
-    }
-    if (effect_lifetime_enabled()) {
-        view.effect_lifetime = make_span3d(effect_lifetime_.data(), extent_).linear();
-    }
-    return view;
+constexpr chunk_plane operator~(chunk_plane value) noexcept {
+    return static_cast<chunk_plane>(~static_cast<std::uint32_t>(value));
 }
 
-inline chunk_storage::const_planes_view chunk_storage::make_const_planes_view() const noexcept {
-    const_planes_view view{};
-    view.voxels = make_span3d(voxels_.data(), extent_).linear();
-    view.skylight = make_span3d(skylight_.data(), extent_).linear();
-    view.blocklight = make_span3d(blocklight_.data(), extent_).linear();
-    view.metadata = make_span3d(metadata_.data(), extent_).linear();
-    if (materials_enabled_) {
-        view.materials = make_span3d(materials_.data(), extent_).linear();
-    }
-    if (high_precision_lighting_enabled_) {
-        view.skylight_cache = make_span3d(skylight_cache_.data(), extent_).linear();
-        view.blocklight_cache = make_span3d(blocklight_cache_.data(), extent_).linear();
-    }
-    if (effect_density_enabled()) {
-        view.effect_density = make_span3d(effect_density_.data(), extent_).linear();
-    }
-    if (effect_velocity_enabled()) {
-        view.effect_velocity = make_span3d(effect_velocity_.data(), extent_).linear();
-    }
-    if (effect_lifetime_enabled()) {
-        view.effect_lifetime = make_span3d(effect_lifetime_.data(), extent_).linear();
-    }
-    return view;
+constexpr chunk_plane& operator|=(chunk_plane& lhs, chunk_plane rhs) noexcept {
+    lhs = lhs | rhs;
+    return lhs;
 }
 
-inline void chunk_storage::ensure_decompressed() {
-    if (compressed_) {
-        std::scoped_lock lock{compression_mutex_};
-        decompress_locked();
-    }
+constexpr chunk_plane& operator&=(chunk_plane& lhs, chunk_plane rhs) noexcept {
+    lhs = lhs & rhs;
+    return lhs;
 }
 
-inline void chunk_storage::decompress_locked() {
-    if (!compressed_ || compressed_blob_.empty()) {
-        return;
-    }
-    if (decompress_) {
-        decompress_(make_planes_view(), compressed_blob_);
-    }
-    compressed_blob_.clear();
-    compressed_ = false;
+constexpr bool contains(chunk_plane flags, chunk_plane value) noexcept {
+    return (flags & value) != chunk_plane::none;
 }
 
-} // namespace almond::voxel
-// end: almond_voxel/chunk.hpp
+inline constexpr std::size_t chunk_plane_count = 10;
 
-namespace almond::voxel {
+// Bytes held by a chunk, split per plane. `overhead` covers the chunk object and its listener table.
+struct chunk_memory_usage {
+    std::array<std::size_t, chunk_plane_count> planes{};
+    std::size_t compressed{0};
+    std::size_t overhead{0};
 
-struct region_key {
-    std::int32_t x{0};
-    std::int32_t y{0};
-    std::int32_t z{0};
+    [[nodiscard]] constexpr std::size_t bytes(chunk_plane mask) const noexcept {
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < chunk_plane_count; ++i) {
+            if (contains(mask, static_cast<chunk_plane>(1u << i))) {
+                sum += planes[i];
+            }
+        }
+        return sum;
+    }
 
-    [[nodiscard]] friend constexpr bool operator==(const region_key& lhs, const region_key& rhs) noexcept = default;
-};
+    [[nodiscard]] constexpr std::size_t total() const noexcept { return bytes(chunk_plane::all) + compressed + overhead; }
 
-struct region_key_hash {
-    [[nodiscard]] std::size_t operator()(const region_key& key) const noexcept {
-        std::uint64_t hx = static_cast<std::uint64_t>(key.x);
-        std::uint64_t hy = static_cast<std::uint64_t>(key.y);
-        std::uint64_t hz = static_cast<std::uint64_t>(key.z);
-        std::uint64_t hash = hx * 0x9E3779B185EBCA87ull;
-        hash ^= hy + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
-        hash ^= hz + 0xC2B2AE3D27D4EB4Full + (hash << 6) + (hash >> 2);
-        return static_cast<std::size_t>(hash);
+    constexpr chunk_memory_usage& operator+=(const chunk_memory_usage& other) noexcept {
+        for (std::size_t i = 0; i < chunk_plane_count; ++i) {
+            planes[i] += other.planes[i];
+        }
+        compressed += other.compressed;
+        overhead += other.overhead;
+        return *this;
+    }
+
+    constexpr chunk_memory_usage& operator-=(const chunk_memory_usage& other) noexcept {
+        for (std::size_t i = 0; i < chunk_plane_count; ++i) {
+            planes[i] -= other.planes[i];
+        }
+        compressed -= other.compressed;
+        overhead -= other.overhead;
+        return *this;
     }
 };
 
-} // namespace almond::voxel
+// Codec used for each plane when a chunk compresses itself with the shared codec registry. The defaults favour fast
+// decoding: RLE for the integer planes, where terrain forms long runs along x, and delta + bit-packing for the float
+// planes. Switch noisy planes to `lz` or let `automatic` pick per plane at a higher encode cost.
+struct chunk_codec_config {
+    std::array<codec_id, chunk_plane_count> planes{codec_id::rle, codec_id::rle, codec_id::rle, codec_id::rle,
+        codec_id::rle, codec_id::delta_bitpack, codec_id::delta_bitpack, codec_id::delta_bitpack,
+        codec_id::delta_bitpack, codec_id::delta_bitpack};
 
-// end: almond_voxel/world_fwd.hpp
+    [[nodiscard]] constexpr codec_id codec_for(chunk_plane plane) const noexcept {
+        return planes[static_cast<std::size_t>(std::countr_zero(static_cast<std::uint32_t>(plane)))];
+    }
 
-// begin: almond_voxel/navigation/voxel_nav.hpp
+    constexpr chunk_codec_config& set(chunk_plane mask, codec_id id) noexcept {
+        for (std::size_t i = 0; i < chunk_plane_count; ++i) {
+            if (contains(mask, static_cast<chunk_plane>(1u << i))) {
+                planes[i] = id;
+            }
+        }
+        return *this;
+    }
+};
 
+// Describes one write to a chunk: which planes changed and the voxel box that contains the change.
+struct dirty_event {
+    chunk_plane planes{chunk_plane::none};
+    voxel_bounds bounds{};
+};
 
-#include <algorithm>
-#include <array>
-#include <cmath>
-#include <cstddef>
-#include <cstdint>
-#include <functional>
-#include <limits>
-#include <memory>
-#include <optional>
-#include <queue>
-#include <utility>
-#include <vector>
+struct chunk_storage_config {
+    chunk_extent extent{cubic_extent(32)};
+    voxel_layout layout{voxel_layout::dense};
+    bool enable_materials{false};
+    bool enable_high_precision_lighting{false};
+    effects::channel effect_channels{effects::channel::none};
+};
 
-namespace almond::voxel {
+// One value per plane, describing a chunk whose planes are all uniform.
+struct chunk_uniform_values {
+    voxel_id voxel{};
+    std::uint8_t skylight{0};
+    std::uint8_t blocklight{0};
+    std::uint8_t metadata{0};
+    material_index material{invalid_material_index};
+    float skylight_cache{0.0f};
+    float blocklight_cache{0.0f};
+    float effect_density{0.0f};
+    effects::velocity_sample effect_velocity{};
+    float effect_lifetime{0.0f};
+};
 
-struct region_key;
+// The planes of a chunk that currently hold a single value, and those values. Fields of other planes are unset.
+struct chunk_uniform_planes {
+    chunk_plane planes{chunk_plane::none};
+    chunk_uniform_values values{};
+};
 
-namespace navigation {
+namespace detail {
 
-using nav_node_index = std::size_t;
+// Shared handle to one plane buffer. Snapshots share buffers with their chunk, and write() clones a buffer that someone
+// else still references, so a writer never disturbs a snapshot and untouched planes are never copied. An empty handle
+// reads as a default-constructed value.
+template <typename T>
+class cow_value {
+public:
+    cow_value() = default;
+    explicit cow_value(T value) : value_{std::make_shared<T>(std::move(value))} {}
+
+    [[nodiscard]] const T& operator*() const noexcept { return value_ ? *value_ : empty(); }
+    [[nodiscard]] const T* operator->() const noexcept { return &**this; }
+    [[nodiscard]] bool shared() const noexcept { return value_.use_count() > 1; }
+
+    [[nodiscard]] T& write() {
+        if (!value_) {
+            value_ = std::make_shared<T>();
+        } else if (value_.use_count() > 1) {
+            value_ = std::make_shared<T>(*value_);
+        }
+        return *value_;
+    }
 
-struct nav_neighbor_config {
-    float horizontal_cost{1.0f};
-    float vertical_cost{1.0f};
-    std::uint32_t max_step_height{1};
-};
+    void assign(T value) {
+        if (value_ && value_.use_count() == 1) {
+            *value_ = std::move(value);
+        } else {
+            value_ = std::make_shared<T>(std::move(value));
+        }
+    }
 
-struct nav_build_config {
-    std::uint32_t clearance{2};
-    nav_neighbor_config neighbor{};
-    std::function<bool(voxel_id)> is_solid{
-        [](voxel_id id) { return id != voxel_id{}; }
-    };
-    std::function<float(const chunk_storage&, std::uint32_t, std::uint32_t, std::uint32_t)> sample_cost{
-        [](const chunk_storage&, std::uint32_t, std::uint32_t, std::uint32_t) { return 1.0f; }
-    };
-};
+    void reset() noexcept { value_.reset(); }
 
-struct nav_cell {
-    bool walkable{false};
-    float traversal_cost{1.0f};
+private:
+    [[nodiscard]] static const T& empty() noexcept {
+        static const T value{};
+        return value;
+    }
+
+    std::shared_ptr<T> value_{};
 };
 
-struct nav_grid {
-    chunk_extent extent{};
-    std::vector<nav_cell> cells{};
+// Plane storage that holds a single value until a dense array is needed. A read-only materialisation keeps the
+// uniform value valid so consumers can keep short-circuiting until the first mutable access.
+template <typename T>
+class lazy_plane {
+public:
+    using value_type = T;
 
-    [[nodiscard]] std::size_t size() const noexcept { return cells.size(); }
+    [[nodiscard]] bool uniform() const noexcept { return value_valid_; }
+    [[nodiscard]] bool materialised() const noexcept { return !data_->empty(); }
+    [[nodiscard]] const T& value() const noexcept { return value_; }
+    [[nodiscard]] const T* data() const noexcept { return data_->data(); }
 
-    [[nodiscard]] bool contains(std::uint32_t x, std::uint32_t y, std::uint32_t z) const noexcept {
-        return extent.contains(x, y, z);
+    void reset(T value = T{}) {
+        data_.reset();
+        value_ = value;
+        value_valid_ = true;
     }
 
-    [[nodiscard]] nav_node_index index(std::uint32_t x, std::uint32_t y, std::uint32_t z) const noexcept {
-        return static_cast<nav_node_index>(x)
-            + static_cast<nav_node_index>(extent.x) * (static_cast<nav_node_index>(y)
-                + static_cast<nav_node_index>(extent.y) * static_cast<nav_node_index>(z));
+    void fill(T value) {
+        if (data_.shared()) {
+            data_.assign(std::vector<T>(data_->size(), value));
+        } else if (!data_->empty()) {
+            auto& data = data_.write();
+            std::fill(data.begin(), data.end(), value);
+        }
+        value_ = value;
+        value_valid_ = true;
     }
 
-    [[nodiscard]] std::array<std::uint32_t, 3> coordinates(nav_node_index node) const noexcept {
-        const auto xy = static_cast<nav_node_index>(extent.x) * static_cast<nav_node_index>(extent.y);
-        const auto z = static_cast<std::uint32_t>(node / xy);
-        const auto rem = node % xy;
-        const auto y = static_cast<std::uint32_t>(rem / extent.x);
-        const auto x = static_cast<std::uint32_t>(rem % extent.x);
-        return {x, y, z};
+    [[nodiscard]] const T* read(std::size_t count) {
+        materialise(count);
+        return data_->data();
     }
 
-    [[nodiscard]] bool walkable(nav_node_index node) const noexcept {
-        return node < cells.size() && cells[node].walkable;
+    [[nodiscard]] T* write(std::size_t count) {
+        materialise(count);
+        value_valid_ = false;
+        return data_.write().data();
     }
 
-    [[nodiscard]] bool walkable(std::uint32_t x, std::uint32_t y, std::uint32_t z) const noexcept {
-        if (!contains(x, y, z)) {
+    bool release() {
+        if (!value_valid_ || data_->empty()) {
             return false;
         }
-        return walkable(index(x, y, z));
+        data_.reset();
+        return true;
     }
 
-    [[nodiscard]] float cost(nav_node_index node) const noexcept {
-        return node < cells.size() ? cells[node].traversal_cost : 1.0f;
+    [[nodiscard]] std::size_t memory_usage() const noexcept { return data_->capacity() * sizeof(T); }
+
+    // Drops the dense array once a codec has encoded it; the plane is only read again after restore().
+    void discard() noexcept { data_.reset(); }
+
+    void restore(std::vector<T> data) {
+        data_.assign(std::move(data));
+        value_valid_ = false;
     }
-};
 
-[[nodiscard]] nav_grid build_nav_grid(const chunk_storage& chunk, const nav_build_config& config = {});
+private:
+    void materialise(std::size_t count) {
+        if (data_->empty() && count != 0) {
+            data_.assign(std::vector<T>(count, value_));
+        }
+    }
 
-struct nav_edge {
-    nav_node_index node{std::numeric_limits<nav_node_index>::max()};
-    float cost{std::numeric_limits<float>::infinity()};
+    cow_value<std::vector<T>> data_{};
+    T value_{};
+    bool value_valid_{true};
 };
 
-using neighbor_list = std::vector<nav_edge>;
+} // namespace detail
 
-void for_each_neighbor(const nav_grid& grid, nav_node_index node, const nav_neighbor_config& config,
-    const std::function<void(nav_edge)>& visitor);
+class chunk_storage {
+public:
+    using byte_vector = std::vector<std::byte>;
+    struct planes_view {
+        voxel_span<voxel_id> voxels{};
+        voxel_span<std::uint8_t> skylight{};
+        voxel_span<std::uint8_t> blocklight{};
+        voxel_span<std::uint8_t> metadata{};
+        voxel_span<material_index> materials{};
+        std::span<float> skylight_cache{};
+        std::span<float> blocklight_cache{};
+        voxel_span<float> effect_density{};
+        voxel_span<effects::velocity_sample> effect_velocity{};
+        voxel_span<float> effect_lifetime{};
+    };
+    struct const_planes_view {
+        voxel_cspan<voxel_id> voxels{};
+        voxel_cspan<std::uint8_t> skylight{};
+        voxel_cspan<std::uint8_t> blocklight{};
+        voxel_cspan<std::uint8_t> metadata{};
+        std::span<const material_index> materials{};
+        std::span<const float> skylight_cache{};
+        std::span<const float> blocklight_cache{};
+        voxel_cspan<float> effect_density{};
+        voxel_cspan<effects::velocity_sample> effect_velocity{};
+        voxel_cspan<float> effect_lifetime{};
+    };
+    using compress_callback = std::function<byte_vector(const const_planes_view&)>;
+    using decompress_callback = std::function<void(const planes_view&, std::span<const std::byte>)>;
+    using dirty_listener = std::function<void()>;
+    using plane_dirty_listener = std::function<void(const dirty_event&)>;
 
-[[nodiscard]] neighbor_list neighbors(const nav_grid& grid, nav_node_index node, const nav_neighbor_config& config = {});
+    // Batches writes so listeners fire once with the union of touched planes when the scope commits or ends.
+    // Const accessors never mark the chunk dirty; non-const accessors mark only their own plane.
+    class write_scope {
+    public:
+        explicit write_scope(chunk_storage& chunk) noexcept;
+        write_scope(const write_scope&) = delete;
+        write_scope& operator=(const write_scope&) = delete;
+        ~write_scope() { commit(); }
 
-struct nav_path {
-    std::vector<nav_node_index> nodes{};
-    float total_cost{std::numeric_limits<float>::infinity()};
-};
+        [[nodiscard]] chunk_storage& chunk() const noexcept { return *chunk_; }
+        [[nodiscard]] chunk_storage* operator->() const noexcept { return chunk_; }
 
-[[nodiscard]] std::optional<nav_path> a_star(const nav_grid& grid, nav_node_index start, nav_node_index goal,
-    const nav_neighbor_config& config = {});
+        void commit() noexcept;
 
-struct flow_field {
-    static constexpr nav_node_index invalid_node = std::numeric_limits<nav_node_index>::max();
+    private:
+        chunk_storage* chunk_{nullptr};
+        bool open_{true};
+    };
 
-    chunk_extent extent{};
-    std::vector<nav_node_index> next{};
-    std::vector<float> distance{};
-};
+    explicit chunk_storage(chunk_extent extent = cubic_extent(32));
+    explicit chunk_storage(chunk_storage_config config);
+    chunk_storage(const chunk_storage&) = delete;
+    chunk_storage& operator=(const chunk_storage&) = delete;
+    chunk_storage(chunk_storage&& other) noexcept;
+    chunk_storage& operator=(chunk_storage&& other) noexcept;
 
-[[nodiscard]] flow_field compute_flow_field(const nav_grid& grid, nav_node_index goal, const nav_neighbor_config& config = {});
+    [[nodiscard]] chunk_extent extent() const noexcept { return extent_; }
+    [[nodiscard]] std::size_t volume() const noexcept { return extent_.volume(); }
 
-[[nodiscard]] std::vector<nav_node_index> follow_flow(const flow_field& field, nav_node_index start,
-    std::size_t max_steps = 1024);
+    [[nodiscard]] span3d<voxel_id> voxels();
+    [[nodiscard]] span3d<const voxel_id> voxels() const;
+
+    // Palette-aware access. The dense voxel array is only materialised by voxels(); these helpers read and write the
+    // packed palette directly while the chunk is compacted. On a palette chunk, voxels() const keeps a decoded copy
+    // beside the palette until the next set_voxel, which edits the palette and drops the copy. Read-only passes that
+    // should not leave a copy behind use read_voxels(), which decodes into the caller's scratch, or copy_voxel_row().
+    [[nodiscard]] voxel_layout layout() const noexcept;
+    [[nodiscard]] const palette_plane* palette() const noexcept { return palette_valid_ ? &*palette_ : nullptr; }
+    [[nodiscard]] voxel_id voxel_at(std::uint32_t x, std::uint32_t y, std::uint32_t z) const;
+    bool set_voxel(std::uint32_t x, std::uint32_t y, std::uint32_t z, voxel_id id);
+    void copy_voxels(voxel_span<voxel_id> out) const;
+    // Copies out.size() voxels along x starting at (x, y, z).
+    void copy_voxel_row(std::uint32_t x, std::uint32_t y, std::uint32_t z, voxel_span<voxel_id> out) const;
+    // The dense array when the chunk has one, otherwise the palette decoded into `scratch`.
+    [[nodiscard]] span3d<const voxel_id> read_voxels(std::vector<voxel_id>& scratch) const;
+    bool compact_voxels();
+
+    // Uniform chunks keep one value per plane and allocate nothing until the first write. Read-only consumers can test
+    // uniform_voxel() before calling voxels() to avoid materialising a dense plane.
+    [[nodiscard]] std::optional<voxel_id> uniform_voxel() const noexcept;
+    [[nodiscard]] std::optional<std::uint8_t> uniform_skylight() const noexcept;
+    [[nodiscard]] std::optional<std::uint8_t> uniform_blocklight() const noexcept;
+    [[nodiscard]] bool uniform() const noexcept;
+    [[nodiscard]] std::optional<chunk_uniform_values> uniform_values() const noexcept;
+    [[nodiscard]] chunk_uniform_planes uniform_planes() const noexcept;
+    bool release_uniform_planes();
+
+    // Heap bytes currently held, per plane. Uniform planes that were never materialised cost nothing.
+    [[nodiscard]] chunk_memory_usage memory_usage() const noexcept;
+
+    [[nodiscard]] span3d<std::uint8_t> skylight();
+    [[nodiscard]] span3d<const std::uint8_t> skylight() const;
+
+    [[nodiscard]] span3d<std::uint8_t> blocklight();
+    [[nodiscard]] span3d<const std::uint8_t> blocklight() const;
+
+    [[nodiscard]] span3d<std::uint8_t> metadata();
+    [[nodiscard]] span3d<const std::uint8_t> metadata() const;
 
-struct nav_region_view {
-    region_key key{};
-    std::shared_ptr<const nav_grid> grid;
-};
+    [[nodiscard]] bool materials_enabled() const noexcept { return materials_enabled_; }
+    [[nodiscard]] span3d<material_index> materials();
+    [[nodiscard]] span3d<const material_index> materials() const;
 
-struct nav_bridge {
-    region_key from_region{};
-    nav_node_index from_node{flow_field::invalid_node};
-    region_key to_region{};
-    nav_node_index to_node{flow_field::invalid_node};
-    float cost{std::numeric_limits<float>::infinity()};
-};
+    [[nodiscard]] bool high_precision_lighting_enabled() const noexcept { return high_precision_lighting_enabled_; }
+    [[nodiscard]] span3d<float> skylight_cache();
+    [[nodiscard]] span3d<const float> skylight_cache() const;
+    [[nodiscard]] span3d<float> blocklight_cache();
+    [[nodiscard]] span3d<const float> blocklight_cache() const;
 
-struct stitched_nav_graph {
-    std::vector<nav_region_view> regions{};
-    std::vector<nav_bridge> bridges{};
-};
+    [[nodiscard]] effects::channel effect_channels() const noexcept { return effect_channels_; }
+    void set_effect_channels(effects::channel channels);
+    void enable_effect_channels(effects::channel channels);
 
-void stitch_neighbor_regions(const nav_neighbor_config& neighbor, chunk_extent extent, stitched_nav_graph& stitched);
+    [[nodiscard]] bool effect_density_enabled() const noexcept;
+    [[nodiscard]] bool effect_velocity_enabled() const noexcept;
+    [[nodiscard]] bool effect_lifetime_enabled() const noexcept;
 
-} // namespace navigation
+    [[nodiscard]] span3d<float> effect_density();
+    [[nodiscard]] span3d<const float> effect_density() const;
+    [[nodiscard]] span3d<effects::velocity_sample> effect_velocity();
+    [[nodiscard]] span3d<const effects::velocity_sample> effect_velocity() const;
+    [[nodiscard]] span3d<float> effect_lifetime();
+    [[nodiscard]] span3d<const float> effect_lifetime() const;
 
-} // namespace almond::voxel
+    void fill(voxel_id voxel, std::uint8_t sky_level = 0, std::uint8_t block_level = 0, std::uint8_t meta = 0,
+        material_index material = invalid_material_index, float sky_cache = 0.0f, float block_cache = 0.0f);
+    void fill(const chunk_uniform_values& values);
+    void assign_voxels(voxel_cspan<voxel_id> data);
 
-namespace almond::voxel::navigation {
+    // Built-in compression encodes every non-uniform plane through codec_registry::shared() and releases the dense
+    // arrays; the first access decodes them again. Palette-packed voxels stay packed. flush_compression() uses the
+    // built-in codecs unless custom hooks are installed.
+    bool compress(const chunk_codec_config& config);
+    bool compress() { return compress(codec_config_); }
+    void set_codec_config(const chunk_codec_config& config) noexcept { codec_config_ = config; }
+    [[nodiscard]] const chunk_codec_config& codec_config() const noexcept { return codec_config_; }
 
-inline nav_grid build_nav_grid(const chunk_storage& chunk, const nav_build_config& config) {
-    nav_grid grid;
-    grid.extent = chunk.extent();
-    grid.cells.resize(grid.extent.volume());
+    void set_compression_hooks(compress_callback compressor, decompress_callback decompressor = {});
+    void request_compression() noexcept { compression_requested_ = true; }
+    [[nodiscard]] bool flush_compression();
+    [[nodiscard]] bool decompress();
 
-    const auto voxels = chunk.voxels();
-    const std::uint32_t clearance = std::max<std::uint32_t>(1, config.clearance);
+    [[nodiscard]] bool compressed() const noexcept { return compressed_.load(std::memory_order_acquire); }
+    [[nodiscard]] std::span<const std::byte> compressed_blob() const noexcept { return *compressed_blob_; }
 
-    for (std::uint32_t z = 0; z < grid.extent.z; ++z) {
-        for (std::uint32_t y = 0; y < grid.extent.y; ++y) {
-            for (std::uint32_t x = 0; x < grid.extent.x; ++x) {
-                const auto idx = grid.index(x, y, z);
-                bool open = true;
-                for (std::uint32_t h = 0; h < clearance; ++h) {
-                    const std::uint32_t sample_y = y + h;
-                    if (sample_y >= grid.extent.y) {
-                        break;
-                    }
-                    if (config.is_solid(voxels(x, sample_y, z))) {
-                        open = false;
-                        break;
-                    }
-                }
-                if (!open) {
-                    continue;
-                }
-                const bool supported = (y == 0) || config.is_solid(voxels(x, y - 1, z));
-                if (!supported) {
-                    continue;
-                }
-                grid.cells[idx].walkable = true;
-                grid.cells[idx].traversal_cost = config.sample_cost(chunk, x, y, z);
-            }
-        }
+    // Drops the compressed blob. Blobs from custom hooks are discarded as-is; built-in blobs are decoded first because
+    // they own the only copy of their planes.
+    void clear_compression();
+
+    [[nodiscard]] write_scope edit() noexcept { return write_scope{*this}; }
+
+    // Cooperative guards for sharing one chunk between threads. Any number of threads may read through const
+    // accessors while holding a shared guard; writes, compression, fills and moves need the exclusive guard. Const
+    // accessors stay safe under a shared guard because lazy materialisation and decompression run under an internal
+    // mutex. Spans returned by const accessors are valid until the next exclusive section.
+    using shared_guard = std::shared_lock<std::shared_mutex>;
+    using exclusive_guard = std::unique_lock<std::shared_mutex>;
+    [[nodiscard]] shared_guard lock_shared() const { return shared_guard{access_mutex_}; }
+    [[nodiscard]] exclusive_guard lock_exclusive() const { return exclusive_guard{access_mutex_}; }
+    [[nodiscard]] exclusive_guard try_lock_exclusive() const { return exclusive_guard{access_mutex_, std::try_to_lock}; }
+
+    // Frozen copy of the current planes in O(1). Plane buffers stay shared until either side writes one, and only that
+    // plane is cloned. Dirty state, codec settings and compression hooks carry over; listeners do not. Take snapshots
+    // under at least a shared guard when other threads may be writing.
+    [[nodiscard]] std::shared_ptr<const chunk_storage> snapshot() const;
+
+    // mark_dirty(false) clears every plane without notifying listeners.
+    void mark_dirty(bool value = true) noexcept;
+    void mark_dirty(chunk_plane planes) noexcept;
+    void mark_dirty(chunk_plane planes, const voxel_bounds& bounds) noexcept;
+    void clear_dirty(chunk_plane planes = chunk_plane::all) noexcept;
+    [[nodiscard]] bool dirty() const noexcept { return dirty_planes_ != chunk_plane::none; }
+    [[nodiscard]] chunk_plane dirty_planes() const noexcept { return dirty_planes_; }
+
+    // Increments on every committed write notification and survives clear_dirty(), so a saved snapshot's revision
+    // names the baseline a later delta was taken against.
+    [[nodiscard]] std::uint64_t revision() const noexcept { return revision_; }
+
+    // Union of every box written since the last clear. set_voxel contributes a single cell; span accessors and fills
+    // contribute the whole extent.
+    [[nodiscard]] const voxel_bounds& dirty_bounds() const noexcept { return dirty_bounds_; }
+    void clear_dirty_bounds() noexcept { dirty_bounds_ = voxel_bounds{}; }
+
+    void add_dirty_listener(dirty_listener listener);
+    void add_plane_dirty_listener(plane_dirty_listener listener, chunk_plane filter = chunk_plane::all);
+    void clear_dirty_listeners();
+
+private:
+    void reset_planes();
+    [[nodiscard]] std::size_t linear_index(std::uint32_t x, std::uint32_t y, std::uint32_t z) const noexcept {
+        return span3d<const voxel_id>{nullptr, extent_}.index(x, y, z);
+    }
+    [[nodiscard]] std::optional<voxel_id> uniform_voxel_locked() const noexcept;
+    [[nodiscard]] bool uniform_locked() const noexcept;
+    void ensure_dense_voxels() const;
+    [[nodiscard]] planes_view make_planes_view() const;
+    [[nodiscard]] const_planes_view make_const_planes_view() const;
+    void ensure_decompressed() const;
+    void decompress_locked() const;
+    template <typename T>
+    [[nodiscard]] const T* read_plane(detail::lazy_plane<T>& plane) const;
+    bool compress_locked(const chunk_codec_config& config);
+    void decode_planes_locked() const;
+    template <typename Fn>
+    void for_each_lazy_plane(Fn&& fn) const;
+
+    // Plane storage is mutable because const readers materialise uniform planes and decode compressed blobs on demand;
+    // those transitions happen under state_mutex_ so concurrent readers never observe them half done.
+    chunk_extent extent_{};
+    voxel_layout preferred_layout_{voxel_layout::dense};
+    mutable detail::cow_value<std::vector<voxel_id>> voxels_{};
+    mutable detail::cow_value<palette_plane> palette_{};
+    mutable bool palette_valid_{false};
+    mutable detail::lazy_plane<std::uint8_t> skylight_{};
+    mutable detail::lazy_plane<std::uint8_t> blocklight_{};
+    mutable detail::lazy_plane<std::uint8_t> metadata_{};
+    bool materials_enabled_{false};
+    bool high_precision_lighting_enabled_{false};
+    effects::channel effect_channels_{effects::channel::none};
+    mutable detail::lazy_plane<material_index> materials_{};
+    mutable detail::lazy_plane<float> skylight_cache_{};
+    mutable detail::lazy_plane<float> blocklight_cache_{};
+    mutable detail::lazy_plane<float> effect_density_{};
+    mutable detail::lazy_plane<effects::velocity_sample> effect_velocity_{};
+    mutable detail::lazy_plane<float> effect_lifetime_{};
+
+    compress_callback compress_{};
+    decompress_callback decompress_{};
+
+    struct dirty_subscription {
+        plane_dirty_listener listener;
+        chunk_plane filter{chunk_plane::all};
+    };
+
+    chunk_plane dirty_planes_{chunk_plane::none};
+    chunk_plane pending_planes_{chunk_plane::none};
+    voxel_bounds dirty_bounds_{};
+    voxel_bounds pending_bounds_{};
+    std::uint32_t write_depth_{0};
+    std::uint64_t revision_{0};
+    bool compression_requested_{false};
+    mutable std::atomic<bool> compressed_{false};
+    mutable bool codec_blob_{false};
+    chunk_codec_config codec_config_{};
+    mutable detail::cow_value<byte_vector> compressed_blob_{};
+    mutable std::mutex state_mutex_{};
+    mutable std::shared_mutex access_mutex_{};
+    std::vector<dirty_subscription> dirty_listeners_{};
+};
+
+inline chunk_storage::chunk_storage(chunk_extent extent)
+    : chunk_storage(chunk_storage_config{extent}) {
+}
+
+inline chunk_storage::chunk_storage(chunk_storage_config config)
+    : extent_{config.extent}
+    , preferred_layout_{config.layout}
+    , materials_enabled_{config.enable_materials}
+    , high_precision_lighting_enabled_{config.enable_high_precision_lighting}
+    , effect_channels_{config.effect_channels} {
+    reset_planes();
+}
+
+inline chunk_storage::chunk_storage(chunk_storage&& other) noexcept
+    : extent_{other.extent_}
+    , preferred_layout_{other.preferred_layout_}
+    , voxels_{std::move(other.voxels_)}
+    , palette_{std::move(other.palette_)}
+    , palette_valid_{other.palette_valid_}
+    , skylight_{std::move(other.skylight_)}
+    , blocklight_{std::move(other.blocklight_)}
+    , metadata_{std::move(other.metadata_)}
+    , materials_enabled_{other.materials_enabled_}
+    , high_precision_lighting_enabled_{other.high_precision_lighting_enabled_}
+    , effect_channels_{other.effect_channels_}
+    , materials_{std::move(other.materials_)}
+    , skylight_cache_{std::move(other.skylight_cache_)}
+    , blocklight_cache_{std::move(other.blocklight_cache_)}
+    , effect_density_{std::move(other.effect_density_)}
+    , effect_velocity_{std::move(other.effect_velocity_)}
+    , effect_lifetime_{std::move(other.effect_lifetime_)}
+    , compress_{std::move(other.compress_)}
+    , decompress_{std::move(other.decompress_)}
+    , dirty_planes_{other.dirty_planes_}
+    , pending_planes_{other.pending_planes_}
+    , dirty_bounds_{other.dirty_bounds_}
+    , pending_bounds_{other.pending_bounds_}
+    , write_depth_{other.write_depth_}
+    , revision_{other.revision_}
+    , compression_requested_{other.compression_requested_}
+    , compressed_{other.compressed_.load()}
+    , codec_blob_{other.codec_blob_}
+    , codec_config_{other.codec_config_}
+    , compressed_blob_{std::move(other.compressed_blob_)}
+    , dirty_listeners_{std::move(other.dirty_listeners_)} {
+    other.extent_ = chunk_extent{};
+    other.palette_valid_ = false;
+    other.materials_enabled_ = false;
+    other.high_precision_lighting_enabled_ = false;
+    other.effect_channels_ = effects::channel::none;
+    other.materials_.reset(invalid_material_index);
+    other.skylight_cache_.reset();
+    other.blocklight_cache_.reset();
+    other.effect_density_.reset();
+    other.effect_velocity_.reset();
+    other.effect_lifetime_.reset();
+    other.dirty_planes_ = chunk_plane::none;
+    other.pending_planes_ = chunk_plane::none;
+    other.dirty_bounds_ = voxel_bounds{};
+    other.pending_bounds_ = voxel_bounds{};
+    other.write_depth_ = 0;
+    other.compression_requested_ = false;
+    other.compressed_.store(false);
+    other.codec_blob_ = false;
+    other.dirty_listeners_.clear();
+}
+
+inline chunk_storage& chunk_storage::operator=(chunk_storage&& other) noexcept {
+    if (this != &other) {
+        std::scoped_lock lock{state_mutex_, other.state_mutex_};
+        extent_ = other.extent_;
+        preferred_layout_ = other.preferred_layout_;
+        voxels_ = std::move(other.voxels_);
+        palette_ = std::move(other.palette_);
+        palette_valid_ = other.palette_valid_;
+        skylight_ = std::move(other.skylight_);
+        blocklight_ = std::move(other.blocklight_);
+        metadata_ = std::move(other.metadata_);
+        materials_enabled_ = other.materials_enabled_;
+        high_precision_lighting_enabled_ = other.high_precision_lighting_enabled_;
+        effect_channels_ = other.effect_channels_;
+        materials_ = std::move(other.materials_);
+        skylight_cache_ = std::move(other.skylight_cache_);
+        blocklight_cache_ = std::move(other.blocklight_cache_);
+        effect_density_ = std::move(other.effect_density_);
+        effect_velocity_ = std::move(other.effect_velocity_);
+        effect_lifetime_ = std::move(other.effect_lifetime_);
+        compress_ = std::move(other.compress_);
+        decompress_ = std::move(other.decompress_);
+        dirty_planes_ = other.dirty_planes_;
+        pending_planes_ = other.pending_planes_;
+        dirty_bounds_ = other.dirty_bounds_;
+        pending_bounds_ = other.pending_bounds_;
+        write_depth_ = other.write_depth_;
+        revision_ = other.revision_;
+        compression_requested_ = other.compression_requested_;
+        compressed_.store(other.compressed_.load());
+        codec_blob_ = other.codec_blob_;
+        codec_config_ = other.codec_config_;
+        compressed_blob_ = std::move(other.compressed_blob_);
+        dirty_listeners_ = std::move(other.dirty_listeners_);
+
+        other.extent_ = chunk_extent{};
+        other.palette_valid_ = false;
+        other.materials_enabled_ = false;
+        other.high_precision_lighting_enabled_ = false;
+        other.effect_channels_ = effects::channel::none;
+        other.materials_.reset(invalid_material_index);
+        other.skylight_cache_.reset();
+        other.blocklight_cache_.reset();
+        other.effect_density_.reset();
+        other.effect_velocity_.reset();
+        other.effect_lifetime_.reset();
+        other.dirty_planes_ = chunk_plane::none;
+        other.pending_planes_ = chunk_plane::none;
+        other.dirty_bounds_ = voxel_bounds{};
+        other.pending_bounds_ = voxel_bounds{};
+        other.write_depth_ = 0;
+        other.compression_requested_ = false;
+        other.compressed_.store(false);
+        other.codec_blob_ = false;
+        other.compressed_blob_.reset();
+        other.compress_ = {};
+        other.decompress_ = {};
+        other.dirty_listeners_.clear();
     }
+    return *this;
+}
 
-    return grid;
+inline std::shared_ptr<const chunk_storage> chunk_storage::snapshot() const {
+    auto copy = std::make_shared<chunk_storage>(chunk_storage_config{extent_, preferred_layout_, materials_enabled_,
+        high_precision_lighting_enabled_, effect_channels_});
+    std::scoped_lock lock{state_mutex_};
+    copy->voxels_ = voxels_;
+    copy->palette_ = palette_;
+    copy->palette_valid_ = palette_valid_;
+    copy->skylight_ = skylight_;
+    copy->blocklight_ = blocklight_;
+    copy->metadata_ = metadata_;
+    copy->materials_ = materials_;
+    copy->skylight_cache_ = skylight_cache_;
+    copy->blocklight_cache_ = blocklight_cache_;
+    copy->effect_density_ = effect_density_;
+    copy->effect_velocity_ = effect_velocity_;
+    copy->effect_lifetime_ = effect_lifetime_;
+    copy->compress_ = compress_;
+    copy->decompress_ = decompress_;
+    copy->dirty_planes_ = dirty_planes_;
+    copy->dirty_bounds_ = dirty_bounds_;
+    copy->revision_ = revision_;
+    copy->compressed_.store(compressed_.load());
+    copy->codec_blob_ = codec_blob_;
+    copy->codec_config_ = codec_config_;
+    copy->compressed_blob_ = compressed_blob_;
+    return copy;
+}
+
+inline chunk_storage::write_scope::write_scope(chunk_storage& chunk) noexcept
+    : chunk_{&chunk} {
+    ++chunk_->write_depth_;
+}
+
+inline void chunk_storage::write_scope::commit() noexcept {
+    if (!open_) {
+        return;
+    }
+    open_ = false;
+    if (--chunk_->write_depth_ == 0 && chunk_->pending_planes_ != chunk_plane::none) {
+        const chunk_plane planes = chunk_->pending_planes_;
+        const voxel_bounds bounds = chunk_->pending_bounds_;
+        chunk_->pending_planes_ = chunk_plane::none;
+        chunk_->pending_bounds_ = voxel_bounds{};
+        chunk_->mark_dirty(planes, bounds);
+    }
 }
 
-inline void for_each_neighbor(const nav_grid& grid, nav_node_index node, const nav_neighbor_config& config,
-    const std::function<void(nav_edge)>& visitor) {
-    if (!grid.walkable(node)) {
+inline void chunk_storage::mark_dirty(bool value) noexcept {
+    if (!value) {
+        dirty_planes_ = chunk_plane::none;
+        pending_planes_ = chunk_plane::none;
+        dirty_bounds_ = voxel_bounds{};
+        pending_bounds_ = voxel_bounds{};
         return;
     }
+    mark_dirty(chunk_plane::all);
+}
 
-    const auto [x, y, z] = grid.coordinates(node);
-    const std::array<std::array<int, 3>, 6> offsets{ {{{1, 0, 0}}, {{-1, 0, 0}}, {{0, 1, 0}}, {{0, -1, 0}}, {{0, 0, 1}}, {{0, 0, -1}}} };
+inline void chunk_storage::mark_dirty(chunk_plane planes) noexcept {
+    mark_dirty(planes, voxel_bounds::full(extent_));
+}
 
-    for (const auto& offset : offsets) {
-        const int nx = static_cast<int>(x) + offset[0];
-        const int ny = static_cast<int>(y) + offset[1];
-        const int nz = static_cast<int>(z) + offset[2];
-        if (nx < 0 || ny < 0 || nz < 0) {
-            continue;
-        }
-        const auto ux = static_cast<std::uint32_t>(nx);
-        const auto uy = static_cast<std::uint32_t>(ny);
-        const auto uz = static_cast<std::uint32_t>(nz);
-        if (!grid.contains(ux, uy, uz)) {
-            continue;
-        }
-        if (std::abs(static_cast<int>(uy) - static_cast<int>(y)) > static_cast<int>(config.max_step_height)) {
-            continue;
-        }
-        const auto neighbor_idx = grid.index(ux, uy, uz);
-        if (!grid.walkable(neighbor_idx)) {
-            continue;
-        }
-        float movement_cost = config.horizontal_cost;
-        if (offset[1] != 0) {
-            movement_cost = config.vertical_cost * static_cast<float>(std::abs(offset[1]));
+inline void chunk_storage::mark_dirty(chunk_plane planes, const voxel_bounds& bounds) noexcept {
+    if (planes == chunk_plane::none || bounds.empty()) {
+        return;
+    }
+    if (write_depth_ > 0) {
+        pending_planes_ |= planes;
+        pending_bounds_.merge(bounds);
+        return;
+    }
+    dirty_planes_ |= planes;
+    dirty_bounds_.merge(bounds);
+    ++revision_;
+    const dirty_event event{planes, bounds};
+    for (auto& subscription : dirty_listeners_) {
+        if (subscription.listener && contains(subscription.filter, planes)) {
+            subscription.listener(event);
         }
-        const float weight = 0.5f * (grid.cost(node) + grid.cost(neighbor_idx));
-        visitor(nav_edge{neighbor_idx, movement_cost * weight});
     }
 }
 
-inline neighbor_list neighbors(const nav_grid& grid, nav_node_index node, const nav_neighbor_config& config) {
-    neighbor_list result;
-    for_each_neighbor(grid, node, config, [&result](nav_edge edge) {
-        result.push_back(edge);
-    });
-    return result;
+inline void chunk_storage::clear_dirty(chunk_plane planes) noexcept {
+    dirty_planes_ &= ~planes;
+    if (dirty_planes_ == chunk_plane::none) {
+        dirty_bounds_ = voxel_bounds{};
+    }
 }
 
-inline float heuristic_distance(const nav_grid& grid, nav_node_index node, nav_node_index goal,
-    const nav_neighbor_config& config) {
-    const auto [x1, y1, z1] = grid.coordinates(node);
-    const auto [x2, y2, z2] = grid.coordinates(goal);
-    const float dx = static_cast<float>(std::abs(static_cast<int>(x1) - static_cast<int>(x2)));
-    const float dy = static_cast<float>(std::abs(static_cast<int>(y1) - static_cast<int>(y2)));
-    const float dz = static_cast<float>(std::abs(static_cast<int>(z1) - static_cast<int>(z2)));
-    return (dx + dz) * config.horizontal_cost + dy * config.vertical_cost;
+inline void chunk_storage::add_dirty_listener(dirty_listener listener) {
+    if (!listener) {
+        return;
+    }
+    dirty_listeners_.push_back(dirty_subscription{
+        [listener = std::move(listener)](const dirty_event&) { listener(); }, chunk_plane::all});
 }
 
-inline std::optional<nav_path> a_star(const nav_grid& grid, nav_node_index start, nav_node_index goal,
-    const nav_neighbor_config& config) {
-    if (!grid.walkable(start) || !grid.walkable(goal)) {
-        return std::nullopt;
-    }
+inline void chunk_storage::add_plane_dirty_listener(plane_dirty_listener listener, chunk_plane filter) {
+    dirty_listeners_.push_back(dirty_subscription{std::move(listener), filter});
+}
 
-    struct frontier_node {
-        nav_node_index node;
-        float priority;
-        float cost;
-    };
+inline void chunk_storage::clear_dirty_listeners() {
+    dirty_listeners_.clear();
+}
 
-    struct compare {
-        bool operator()(const frontier_node& lhs, const frontier_node& rhs) const noexcept {
-            return lhs.priority > rhs.priority;
-        }
-    };
+inline span3d<voxel_id> chunk_storage::voxels() {
+    ensure_decompressed();
+    ensure_dense_voxels();
+    palette_valid_ = false;
+    mark_dirty(chunk_plane::voxels);
+    return make_span3d(voxels_.write().data(), extent_);
+}
 
-    std::priority_queue<frontier_node, std::vector<frontier_node>, compare> frontier;
-    std::vector<float> g_score(grid.size(), std::numeric_limits<float>::infinity());
-    std::vector<nav_node_index> came_from(grid.size(), flow_field::invalid_node);
+inline span3d<const voxel_id> chunk_storage::voxels() const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    ensure_dense_voxels();
+    return make_span3d(voxels_->data(), extent_);
+}
 
-    g_score[start] = 0.0f;
-    frontier.push(frontier_node{start, heuristic_distance(grid, start, goal, config), 0.0f});
+inline voxel_layout chunk_storage::layout() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    return voxels_->empty() && palette_valid_ ? voxel_layout::palette : voxel_layout::dense;
+}
 
-    while (!frontier.empty()) {
-        const auto current = frontier.top();
-        frontier.pop();
+inline voxel_id chunk_storage::voxel_at(std::uint32_t x, std::uint32_t y, std::uint32_t z) const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    const auto index = linear_index(x, y, z);
+    // A valid palette is authoritative even when the dense array has been materialised alongside it.
+    if (palette_valid_) {
+        return palette_->get(index);
+    }
+    return voxels_->empty() ? voxel_id{} : (*voxels_)[index];
+}
 
-        if (current.node == goal) {
-            nav_path path;
-            path.total_cost = current.cost;
-            nav_node_index node_it = goal;
-            while (node_it != flow_field::invalid_node) {
-                path.nodes.push_back(node_it);
-                if (node_it == start) {
-                    break;
-                }
-                node_it = came_from[node_it];
-            }
-            std::reverse(path.nodes.begin(), path.nodes.end());
-            return path;
+inline bool chunk_storage::set_voxel(std::uint32_t x, std::uint32_t y, std::uint32_t z, voxel_id id) {
+    if (!extent_.contains(x, y, z)) {
+        return false;
+    }
+    const auto index = linear_index(x, y, z);
+    if (voxel_at(x, y, z) == id) {
+        return true;
+    }
+    if (palette_valid_ && preferred_layout_ == voxel_layout::palette) {
+        // Any dense array is a copy decoded by a const read; drop it rather than letting the edit leave the chunk dense.
+        palette_.write().set(index, id);
+        voxels_.reset();
+        mark_dirty(chunk_plane::voxels, voxel_bounds::cell(x, y, z));
+        return true;
+    }
+    if (voxels_->empty() && preferred_layout_ == voxel_layout::dense) {
+        ensure_dense_voxels();
+    }
+    if (!voxels_->empty()) {
+        voxels_.write()[index] = id;
+        palette_valid_ = false;
+    } else if (palette_valid_) {
+        palette_.write().set(index, id);
+    } else {
+        return false;
+    }
+    mark_dirty(chunk_plane::voxels, voxel_bounds::cell(x, y, z));
+    return true;
+}
+
+inline void chunk_storage::copy_voxels(voxel_span<voxel_id> out) const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    if (out.size() != extent_.volume()) {
+        throw std::runtime_error("voxel data size mismatch");
+    }
+    if (palette_valid_) {
+        palette_->decode(out);
+    } else if (!voxels_->empty()) {
+        std::copy(voxels_->begin(), voxels_->end(), out.begin());
+    }
+}
+
+inline void chunk_storage::copy_voxel_row(std::uint32_t x, std::uint32_t y, std::uint32_t z,
+    voxel_span<voxel_id> out) const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    if (out.empty()) {
+        return;
+    }
+    if (!extent_.contains(x + static_cast<std::uint32_t>(out.size()) - 1, y, z)) {
+        throw std::out_of_range("voxel row lies outside the chunk");
+    }
+    const auto start = linear_index(x, y, z);
+    if (palette_valid_) {
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            out[i] = palette_->get(start + i);
         }
+    } else if (!voxels_->empty()) {
+        std::copy_n(voxels_->begin() + static_cast<std::ptrdiff_t>(start), out.size(), out.begin());
+    } else {
+        std::fill(out.begin(), out.end(), voxel_id{});
+    }
+}
 
-        for_each_neighbor(grid, current.node, config, [&](nav_edge edge) {
-            const float tentative = g_score[current.node] + edge.cost;
-            if (tentative + 1e-6f < g_score[edge.node]) {
-                g_score[edge.node] = tentative;
-                came_from[edge.node] = current.node;
-                const float priority = tentative + heuristic_distance(grid, edge.node, goal, config);
-                frontier.push(frontier_node{edge.node, priority, tentative});
-            }
-        });
+inline span3d<const voxel_id> chunk_storage::read_voxels(std::vector<voxel_id>& scratch) const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    if (!voxels_->empty()) {
+        return make_span3d(voxels_->data(), extent_);
+    }
+    scratch.resize(extent_.volume());
+    if (palette_valid_) {
+        palette_->decode(scratch);
+    } else {
+        std::fill(scratch.begin(), scratch.end(), voxel_id{});
     }
+    return make_span3d(static_cast<const voxel_id*>(scratch.data()), extent_);
+}
 
-    return std::nullopt;
+inline bool chunk_storage::compact_voxels() {
+    ensure_decompressed();
+    if (voxels_->empty()) {
+        return palette_valid_;
+    }
+    if (!palette_valid_) {
+        palette_.assign(palette_plane::from_dense(*voxels_));
+        palette_valid_ = true;
+    }
+    voxels_.reset();
+    return true;
 }
 
-inline flow_field compute_flow_field(const nav_grid& grid, nav_node_index goal, const nav_neighbor_config& config) {
-    flow_field field;
-    field.extent = grid.extent;
-    field.next.assign(grid.size(), flow_field::invalid_node);
-    field.distance.assign(grid.size(), std::numeric_limits<float>::infinity());
+inline std::optional<voxel_id> chunk_storage::uniform_voxel() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    return uniform_voxel_locked();
+}
 
-    if (!grid.walkable(goal)) {
-        return field;
+inline std::optional<voxel_id> chunk_storage::uniform_voxel_locked() const noexcept {
+    if (compressed() || !palette_valid_ || palette_->bits_per_index() != 0 || palette_->palette().empty()) {
+        return std::nullopt;
     }
+    return palette_->palette().front();
+}
 
-    struct queue_node {
-        nav_node_index node;
-        float cost;
-    };
+inline std::optional<std::uint8_t> chunk_storage::uniform_skylight() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    return skylight_.uniform() ? std::optional<std::uint8_t>{skylight_.value()} : std::nullopt;
+}
 
-    struct compare {
-        bool operator()(const queue_node& lhs, const queue_node& rhs) const noexcept {
-            return lhs.cost > rhs.cost;
+inline std::optional<std::uint8_t> chunk_storage::uniform_blocklight() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    return blocklight_.uniform() ? std::optional<std::uint8_t>{blocklight_.value()} : std::nullopt;
+}
+
+inline bool chunk_storage::uniform() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    return uniform_locked();
+}
+
+inline bool chunk_storage::uniform_locked() const noexcept {
+    return uniform_voxel_locked().has_value() && skylight_.uniform() && blocklight_.uniform() && metadata_.uniform()
+        && materials_.uniform() && skylight_cache_.uniform() && blocklight_cache_.uniform()
+        && effect_density_.uniform() && effect_velocity_.uniform() && effect_lifetime_.uniform();
+}
+
+inline std::optional<chunk_uniform_values> chunk_storage::uniform_values() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    if (!uniform_locked()) {
+        return std::nullopt;
+    }
+    chunk_uniform_values values{};
+    values.voxel = *uniform_voxel_locked();
+    values.skylight = skylight_.value();
+    values.blocklight = blocklight_.value();
+    values.metadata = metadata_.value();
+    values.material = materials_.value();
+    values.skylight_cache = skylight_cache_.value();
+    values.blocklight_cache = blocklight_cache_.value();
+    values.effect_density = effect_density_.value();
+    values.effect_velocity = effect_velocity_.value();
+    values.effect_lifetime = effect_lifetime_.value();
+    return values;
+}
+
+inline chunk_uniform_planes chunk_storage::uniform_planes() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    chunk_uniform_planes result{};
+    if (const auto voxel = uniform_voxel_locked()) {
+        result.planes |= chunk_plane::voxels;
+        result.values.voxel = *voxel;
+    }
+    const auto take = [&](chunk_plane plane, const auto& source, auto& value) {
+        if (source.uniform()) {
+            result.planes |= plane;
+            value = source.value();
         }
     };
+    take(chunk_plane::skylight, skylight_, result.values.skylight);
+    take(chunk_plane::blocklight, blocklight_, result.values.blocklight);
+    take(chunk_plane::metadata, metadata_, result.values.metadata);
+    take(chunk_plane::materials, materials_, result.values.material);
+    take(chunk_plane::skylight_cache, skylight_cache_, result.values.skylight_cache);
+    take(chunk_plane::blocklight_cache, blocklight_cache_, result.values.blocklight_cache);
+    take(chunk_plane::effect_density, effect_density_, result.values.effect_density);
+    take(chunk_plane::effect_velocity, effect_velocity_, result.values.effect_velocity);
+    take(chunk_plane::effect_lifetime, effect_lifetime_, result.values.effect_lifetime);
+    return result;
+}
 
-    std::priority_queue<queue_node, std::vector<queue_node>, compare> queue;
-    queue.push(queue_node{goal, 0.0f});
-    field.distance[goal] = 0.0f;
-    field.next[goal] = goal;
+inline bool chunk_storage::release_uniform_planes() {
+    ensure_decompressed();
+    bool released = false;
+    if (uniform_voxel() && !voxels_->empty()) {
+        voxels_.reset();
+        released = true;
+    }
+    released = skylight_.release() || released;
+    released = blocklight_.release() || released;
+    released = metadata_.release() || released;
+    released = materials_.release() || released;
+    released = skylight_cache_.release() || released;
+    released = blocklight_cache_.release() || released;
+    released = effect_density_.release() || released;
+    released = effect_velocity_.release() || released;
+    released = effect_lifetime_.release() || released;
+    return released;
+}
+
+inline chunk_memory_usage chunk_storage::memory_usage() const noexcept {
+    std::scoped_lock lock{state_mutex_};
+    chunk_memory_usage usage{};
+    const auto slot = [&](chunk_plane plane) -> std::size_t& {
+        return usage.planes[static_cast<std::size_t>(std::countr_zero(static_cast<std::uint32_t>(plane)))];
+    };
+    slot(chunk_plane::voxels) = voxels_->capacity() * sizeof(voxel_id) + palette_->memory_usage();
+    slot(chunk_plane::skylight) = skylight_.memory_usage();
+    slot(chunk_plane::blocklight) = blocklight_.memory_usage();
+    slot(chunk_plane::metadata) = metadata_.memory_usage();
+    slot(chunk_plane::materials) = materials_.memory_usage();
+    slot(chunk_plane::skylight_cache) = skylight_cache_.memory_usage();
+    slot(chunk_plane::blocklight_cache) = blocklight_cache_.memory_usage();
+    slot(chunk_plane::effect_density) = effect_density_.memory_usage();
+    slot(chunk_plane::effect_velocity) = effect_velocity_.memory_usage();
+    slot(chunk_plane::effect_lifetime) = effect_lifetime_.memory_usage();
+    usage.compressed = compressed_blob_->capacity();
+    usage.overhead = sizeof(chunk_storage) + dirty_listeners_.capacity() * sizeof(dirty_subscription);
+    return usage;
+}
+
+inline span3d<std::uint8_t> chunk_storage::skylight() {
+    ensure_decompressed();
+    mark_dirty(chunk_plane::skylight);
+    return make_span3d(skylight_.write(volume()), extent_);
+}
 
-    while (!queue.empty()) {
-        const auto current = queue.top();
-        queue.pop();
-        if (current.cost > field.distance[current.node] + 1e-6f) {
-            continue;
-        }
+inline span3d<const std::uint8_t> chunk_storage::skylight() const {
+    return make_span3d(read_plane(skylight_), extent_);
+}
 
-        for_each_neighbor(grid, current.node, config, [&](nav_edge edge) {
-            const float candidate = current.cost + edge.cost;
-            if (candidate + 1e-6f < field.distance[edge.node]) {
-                field.distance[edge.node] = candidate;
-                field.next[edge.node] = current.node;
-                queue.push(queue_node{edge.node, candidate});
-            }
-        });
-    }
+inline span3d<std::uint8_t> chunk_storage::blocklight() {
+    ensure_decompressed();
+    mark_dirty(chunk_plane::blocklight);
+    return make_span3d(blocklight_.write(volume()), extent_);
+}
 
-    return field;
+inline span3d<const std::uint8_t> chunk_storage::blocklight() const {
+    return make_span3d(read_plane(blocklight_), extent_);
 }
 
-inline std::vector<nav_node_index> follow_flow(const flow_field& field, nav_node_index start, std::size_t max_steps) {
-    std::vector<nav_node_index> path;
-    if (start >= field.next.size()) {
-        return path;
-    }
+inline span3d<std::uint8_t> chunk_storage::metadata() {
+    ensure_decompressed();
+    mark_dirty(chunk_plane::metadata);
+    return make_span3d(metadata_.write(volume()), extent_);
+}
 
-    nav_node_index current = start;
-    for (std::size_t i = 0; i < max_steps; ++i) {
-        path.push_back(current);
-        const nav_node_index next = field.next[current];
-        if (next == flow_field::invalid_node) {
-            path.clear();
-            return path;
-        }
-        if (next == current) {
-            break;
-        }
-        current = next;
-    }
-    return path;
+inline span3d<const std::uint8_t> chunk_storage::metadata() const {
+    return make_span3d(read_plane(metadata_), extent_);
 }
 
-inline void stitch_pair(const nav_neighbor_config& neighbor, chunk_extent extent, const nav_region_view& from,
-    const nav_region_view& to, stitched_nav_graph& stitched) {
-    const int dx = to.key.x - from.key.x;
-    const int dy = to.key.y - from.key.y;
-    const int dz = to.key.z - from.key.z;
-    const int manhattan = std::abs(dx) + std::abs(dy) + std::abs(dz);
-    if (manhattan != 1 || !from.grid || !to.grid) {
-        return;
+inline span3d<material_index> chunk_storage::materials() {
+    ensure_decompressed();
+    if (!materials_enabled_) {
+        throw std::logic_error("material plane is disabled");
     }
+    mark_dirty(chunk_plane::materials);
+    return make_span3d(materials_.write(volume()), extent_);
+}
 
-    const auto add_bridge = [&](std::uint32_t fx, std::uint32_t fy, std::uint32_t fz, std::uint32_t tx, std::uint32_t ty,
-                                 std::uint32_t tz) {
-        const auto from_index = from.grid->index(fx, fy, fz);
-        const auto to_index = to.grid->index(tx, ty, tz);
-        if (!from.grid->walkable(from_index) || !to.grid->walkable(to_index)) {
-            return;
-        }
-        if (std::abs(static_cast<int>(ty) - static_cast<int>(fy)) > static_cast<int>(neighbor.max_step_height)) {
-            return;
-        }
-        float movement_cost = neighbor.horizontal_cost;
-        const int vertical_delta = static_cast<int>(ty) - static_cast<int>(fy);
-        if (dy != 0) {
-            movement_cost = neighbor.vertical_cost * static_cast<float>(std::abs(dy));
-        }
-        if (vertical_delta != 0) {
-            movement_cost += neighbor.vertical_cost * static_cast<float>(std::abs(vertical_delta));
-        }
-        const float weight = 0.5f * (from.grid->cost(from_index) + to.grid->cost(to_index));
-        stitched.bridges.push_back(nav_bridge{from.key, from_index, to.key, to_index, movement_cost * weight});
-    };
+inline span3d<const material_index> chunk_storage::materials() const {
+    if (!materials_enabled_) {
+        throw std::logic_error("material plane is disabled");
+    }
+    return make_span3d(read_plane(materials_), extent_);
+}
 
-    if (dx != 0) {
-        const std::uint32_t fx = dx > 0 ? extent.x - 1 : 0;
-        const std::uint32_t tx = dx > 0 ? 0 : extent.x - 1;
-        for (std::uint32_t y = 0; y < extent.y; ++y) {
-            for (std::uint32_t z = 0; z < extent.z; ++z) {
-                for (int dy_off = -static_cast<int>(neighbor.max_step_height);
-                     dy_off <= static_cast<int>(neighbor.max_step_height); ++dy_off) {
-                    const int ty = static_cast<int>(y) + dy_off;
-                    if (ty < 0 || ty >= static_cast<int>(extent.y)) {
-                        continue;
-                    }
-                    add_bridge(fx, y, z, tx, static_cast<std::uint32_t>(ty), z);
-                }
-            }
-        }
-        return;
+inline span3d<float> chunk_storage::skylight_cache() {
+    ensure_decompressed();
+    if (!high_precision_lighting_enabled_) {
+        throw std::logic_error("high precision lighting cache is disabled");
     }
+    mark_dirty(chunk_plane::skylight_cache);
+    return make_span3d(skylight_cache_.write(volume()), extent_);
+}
 
-    if (dz != 0) {
-        const std::uint32_t fz = dz > 0 ? extent.z - 1 : 0;
-        const std::uint32_t tz = dz > 0 ? 0 : extent.z - 1;
-        for (std::uint32_t y = 0; y < extent.y; ++y) {
-            for (std::uint32_t x = 0; x < extent.x; ++x) {
-                for (int dy_off = -static_cast<int>(neighbor.max_step_height);
-                     dy_off <= static_cast<int>(neighbor.max_step_height); ++dy_off) {
-                    const int ty = static_cast<int>(y) + dy_off;
-                    if (ty < 0 || ty >= static_cast<int>(extent.y)) {
-                        continue;
-                    }
-                    add_bridge(x, y, fz, x, static_cast<std::uint32_t>(ty), tz);
-                }
-            }
-        }
-        return;
+inline span3d<const float> chunk_storage::skylight_cache() const {
+    if (!high_precision_lighting_enabled_) {
+        throw std::logic_error("high precision lighting cache is disabled");
     }
+    return make_span3d(read_plane(skylight_cache_), extent_);
+}
 
-    if (dy != 0) {
-        const std::uint32_t fy = dy > 0 ? extent.y - 1 : 0;
-        const std::uint32_t ty = dy > 0 ? 0 : extent.y - 1;
-        for (std::uint32_t x = 0; x < extent.x; ++x) {
-            for (std::uint32_t z = 0; z < extent.z; ++z) {
-                add_bridge(x, fy, z, x, ty, z);
-            }
-        }
+inline span3d<float> chunk_storage::blocklight_cache() {
+    ensure_decompressed();
+    if (!high_precision_lighting_enabled_) {
+        throw std::logic_error("high precision lighting cache is disabled");
     }
+    mark_dirty(chunk_plane::blocklight_cache);
+    return make_span3d(blocklight_cache_.write(volume()), extent_);
 }
 
-inline void stitch_neighbor_regions(const nav_neighbor_config& neighbor, chunk_extent extent, stitched_nav_graph& stitched) {
-    for (std::size_t i = 0; i < stitched.regions.size(); ++i) {
-        for (std::size_t j = i + 1; j < stitched.regions.size(); ++j) {
-            stitch_pair(neighbor, extent, stitched.regions[i], stitched.regions[j], stitched);
-            stitch_pair(neighbor, extent, stitched.regions[j], stitched.regions[i], stitched);
-        }
+inline span3d<const float> chunk_storage::blocklight_cache() const {
+    if (!high_precision_lighting_enabled_) {
+        throw std::logic_error("high precision lighting cache is disabled");
     }
+    return make_span3d(read_plane(blocklight_cache_), extent_);
 }
 
-} // namespace almond::voxel::navigation
+inline bool chunk_storage::effect_density_enabled() const noexcept {
+    return effects::contains(effect_channels_, effects::channel::density);
+}
 
-// end: almond_voxel/navigation/voxel_nav.hpp
+inline bool chunk_storage::effect_velocity_enabled() const noexcept {
+    return effects::contains(effect_channels_, effects::channel::velocity);
+}
 
-// begin: almond_voxel/world.hpp
+inline bool chunk_storage::effect_lifetime_enabled() const noexcept {
+    return effects::contains(effect_channels_, effects::channel::lifetime);
+}
 
+inline void chunk_storage::set_effect_channels(effects::channel channels) {
+    ensure_decompressed();
+    if (effect_channels_ == channels) {
+        return;
+    }
+    const effects::channel previous = effect_channels_;
+    effect_channels_ = channels;
 
-#include <algorithm>
-#include <cstdint>
-#include <deque>
-#include <functional>
-#include <limits>
-#include <memory>
-#include <span>
-#include <unordered_map>
-#include <utility>
-#include <vector>
-
-namespace almond::voxel {
-
-class region_manager {
-public:
-    using chunk_ptr = std::shared_ptr<chunk_storage>;
-    using nav_grid_ptr = std::shared_ptr<navigation::nav_grid>;
-    using loader_type = std::function<chunk_storage(const region_key&)>;
-    using saver_type = std::function<void(const region_key&, const chunk_storage&)>;
-    using task_type = std::function<void(chunk_storage&, const region_key&)>;
-    using dirty_observer = std::function<void(const region_key&)>;
-
-    explicit region_manager(chunk_extent chunk_dimensions = cubic_extent(32));
-
-    [[nodiscard]] chunk_extent chunk_dimensions() const noexcept { return chunk_extent_; }
-
-    chunk_storage& assure(const region_key& key);
-    [[nodiscard]] chunk_ptr find(const region_key& key) const;
-
-    void set_loader(loader_type loader) { loader_ = std::move(loader); }
-    void set_saver(saver_type saver) { saver_ = std::move(saver); }
-
-    void set_max_resident(std::size_t limit) noexcept;
-    [[nodiscard]] std::size_t max_resident() const noexcept { return max_resident_; }
-    [[nodiscard]] std::size_t resident() const noexcept { return regions_.size(); }
-
-    void pin(const region_key& key);
-    void unpin(const region_key& key);
-
-    void enqueue_task(const region_key& key, task_type task);
-    std::size_t tick(std::size_t budget = std::numeric_limits<std::size_t>::max());
-
-    void add_dirty_observer(dirty_observer observer);
-
-    void enable_navigation(bool enable = true);
-    void set_navigation_build_config(navigation::nav_build_config config);
-    [[nodiscard]] std::shared_ptr<const navigation::nav_grid> navigation_grid(const region_key& key) const;
-    void request_navigation_rebuild(const region_key& key);
-    [[nodiscard]] navigation::stitched_nav_graph stitch_navigation(const region_key& origin,
-        std::span<const region_key> neighbors) const;
-
-    void for_each_loaded(const std::function<void(const region_key&, const chunk_storage&)>& visitor) const;
-
-    struct region_snapshot {
-        region_key key{};
-        std::shared_ptr<const chunk_storage> chunk;
-    };
-
-    [[nodiscard]] std::vector<region_snapshot> snapshot_loaded(bool include_clean = false) const;
-
-    bool unload(const region_key& key);
-    void evict_until_within_limit();
-
-private:
-    struct entry {
-        chunk_ptr chunk;
-        bool pinned{false};
-    };
-
-    struct nav_cache_entry {
-        nav_grid_ptr grid;
-        bool dirty{true};
-        bool rebuild_pending{false};
-        std::size_t revision{0};
-    };
-
-    chunk_storage& load_or_create(const region_key& key);
-    void touch(const region_key& key);
-    void mark_nav_dirty(const region_key& key);
-    void schedule_nav_rebuild(const region_key& key);
-    void clear_nav_cache(const region_key& key);
-
-    chunk_extent chunk_extent_{};
-    std::unordered_map<region_key, entry, region_key_hash> regions_{};
-    std::deque<region_key> lru_{};
-    std::size_t max_resident_{128};
-    loader_type loader_{};
-    saver_type saver_{};
-    std::deque<std::pair<region_key, task_type>> task_queue_{};
-    std::vector<dirty_observer> dirty_observers_{};
-    navigation::nav_build_config nav_config_{};
-    bool navigation_enabled_{false};
-    std::unordered_map<region_key, nav_cache_entry, region_key_hash> nav_cache_{};
-};
+    if (!effects::contains(channels, effects::channel::density) || !effects::contains(previous, effects::channel::density)) {
+        effect_density_.reset(0.0f);
+    }
+    if (!effects::contains(channels, effects::channel::velocity)
+        || !effects::contains(previous, effects::channel::velocity)) {
+        effect_velocity_.reset(effects::velocity_sample{});
+    }
+    if (!effects::contains(channels, effects::channel::lifetime)
+        || !effects::contains(previous, effects::channel::lifetime)) {
+        effect_lifetime_.reset(0.0f);
+    }
 
-inline region_manager::region_manager(chunk_extent chunk_dimensions)
-    : chunk_extent_{chunk_dimensions} {
+    mark_dirty(chunk_plane::effects);
 }
 
-inline chunk_storage& region_manager::assure(const region_key& key) {
-    auto& chunk = load_or_create(key);
-    touch(key);
-    return chunk;
+inline void chunk_storage::enable_effect_channels(effects::channel channels) {
+    set_effect_channels(effect_channels_ | channels);
 }
 
-inline region_manager::chunk_ptr region_manager::find(const region_key& key) const {
-    if (auto it = regions_.find(key); it != regions_.end()) {
-        return it->second.chunk;
+inline span3d<float> chunk_storage::effect_density() {
+    ensure_decompressed();
+    if (!effect_density_enabled()) {
+        throw std::logic_error("effect density channel is disabled");
     }
-    return {};
-}
-
-inline void region_manager::set_max_resident(std::size_t limit) noexcept {
-    max_resident_ = limit;
-    evict_until_within_limit();
+    mark_dirty(chunk_plane::effect_density);
+    return make_span3d(effect_density_.write(volume()), extent_);
 }
 
-inline void region_manager::pin(const region_key& key) {
-    if (auto it = regions_.find(key); it != regions_.end()) {
-        it->second.pinned = true;
+inline span3d<const float> chunk_storage::effect_density() const {
+    if (!effect_density_enabled()) {
+        throw std::logic_error("effect density channel is disabled");
     }
+    return make_span3d(read_plane(effect_density_), extent_);
 }
 
-inline void region_manager::unpin(const region_key& key) {
-    if (auto it = regions_.find(key); it != regions_.end()) {
-        it->second.pinned = false;
-        touch(key);
+inline span3d<effects::velocity_sample> chunk_storage::effect_velocity() {
+    ensure_decompressed();
+    if (!effect_velocity_enabled()) {
+        throw std::logic_error("effect velocity channel is disabled");
     }
+    mark_dirty(chunk_plane::effect_velocity);
+    return make_span3d(effect_velocity_.write(volume()), extent_);
 }
 
-inline void region_manager::enqueue_task(const region_key& key, task_type task) {
-    task_queue_.emplace_back(key, std::move(task));
+inline span3d<const effects::velocity_sample> chunk_storage::effect_velocity() const {
+    if (!effect_velocity_enabled()) {
+        throw std::logic_error("effect velocity channel is disabled");
+    }
+    return make_span3d(read_plane(effect_velocity_), extent_);
 }
 
-inline std::size_t region_manager::tick(std::size_t budget) {
-    std::size_t processed = 0;
-    while (processed < budget && !task_queue_.empty()) {
-        auto [key, task] = std::move(task_queue_.front());
-        task_queue_.pop_front();
-        auto& chunk = assure(key);
-        if (task) {
-            task(chunk, key);
-        }
-        ++processed;
+inline span3d<float> chunk_storage::effect_lifetime() {
+    ensure_decompressed();
+    if (!effect_lifetime_enabled()) {
+        throw std::logic_error("effect lifetime channel is disabled");
     }
-    evict_until_within_limit();
-    return processed;
+    mark_dirty(chunk_plane::effect_lifetime);
+    return make_span3d(effect_lifetime_.write(volume()), extent_);
 }
 
-inline void region_manager::add_dirty_observer(dirty_observer observer) {
-    dirty_observers_.push_back(std::move(observer));
+inline span3d<const float> chunk_storage::effect_lifetime() const {
+    if (!effect_lifetime_enabled()) {
+        throw std::logic_error("effect lifetime channel is disabled");
+    }
+    return make_span3d(read_plane(effect_lifetime_), extent_);
 }
 
-inline void region_manager::enable_navigation(bool enable) {
-    if (navigation_enabled_ == enable) {
-        return;
+inline void chunk_storage::fill(voxel_id voxel, std::uint8_t sky_level, std::uint8_t block_level, std::uint8_t meta,
+    material_index material, float sky_cache, float block_cache) {
+    chunk_uniform_values values{};
+    values.voxel = voxel;
+    values.skylight = sky_level;
+    values.blocklight = block_level;
+    values.metadata = meta;
+    values.material = material;
+    values.skylight_cache = sky_cache;
+    values.blocklight_cache = block_cache;
+    fill(values);
+}
+
+inline void chunk_storage::fill(const chunk_uniform_values& values) {
+    ensure_decompressed();
+    palette_.assign(palette_plane{extent_.volume(), values.voxel});
+    palette_valid_ = true;
+    if (voxels_.shared()) {
+        voxels_.assign(std::vector<voxel_id>(voxels_->size(), values.voxel));
+    } else if (!voxels_->empty()) {
+        auto& dense = voxels_.write();
+        std::fill(dense.begin(), dense.end(), values.voxel);
+    }
+    skylight_.fill(values.skylight);
+    blocklight_.fill(values.blocklight);
+    metadata_.fill(values.metadata);
+    if (materials_enabled_) {
+        materials_.fill(values.material);
     }
-    navigation_enabled_ = enable;
-    if (!navigation_enabled_) {
-        nav_cache_.clear();
-        return;
+    if (high_precision_lighting_enabled_) {
+        skylight_cache_.fill(values.skylight_cache);
+        blocklight_cache_.fill(values.blocklight_cache);
     }
-    nav_cache_.clear();
-    for (const auto& [key, entry] : regions_) {
-        if (entry.chunk) {
-            mark_nav_dirty(key);
-        }
+    if (effect_density_enabled()) {
+        effect_density_.fill(values.effect_density);
     }
-}
-
-inline void region_manager::set_navigation_build_config(navigation::nav_build_config config) {
-    nav_config_ = std::move(config);
-    if (!navigation_enabled_) {
-        return;
+    if (effect_velocity_enabled()) {
+        effect_velocity_.fill(values.effect_velocity);
     }
-    for (const auto& [key, entry] : regions_) {
-        if (entry.chunk) {
-            mark_nav_dirty(key);
-        }
+    if (effect_lifetime_enabled()) {
+        effect_lifetime_.fill(values.effect_lifetime);
     }
+    mark_dirty(chunk_plane::all);
 }
 
-inline std::shared_ptr<const navigation::nav_grid> region_manager::navigation_grid(const region_key& key) const {
-    if (!navigation_enabled_) {
-        return {};
+inline void chunk_storage::assign_voxels(voxel_cspan<voxel_id> data) {
+    ensure_decompressed();
+    if (data.size() != extent_.volume()) {
+        throw std::runtime_error("voxel data size mismatch");
     }
-    if (auto it = nav_cache_.find(key); it != nav_cache_.end()) {
-        return it->second.grid;
+    if (voxels_->empty() && preferred_layout_ == voxel_layout::palette) {
+        palette_.assign(palette_plane::from_dense(data));
+        palette_valid_ = true;
+    } else {
+        voxels_.assign(std::vector<voxel_id>(data.begin(), data.end()));
+        palette_valid_ = false;
     }
-    return {};
+    mark_dirty(chunk_plane::voxels);
 }
 
-inline void region_manager::request_navigation_rebuild(const region_key& key) {
-    if (!navigation_enabled_) {
-        return;
-    }
-    mark_nav_dirty(key);
+inline void chunk_storage::set_compression_hooks(compress_callback compressor, decompress_callback decompressor) {
+    std::scoped_lock lock{state_mutex_};
+    compress_ = std::move(compressor);
+    decompress_ = std::move(decompressor);
 }
 
-inline navigation::stitched_nav_graph region_manager::stitch_navigation(const region_key& origin,
-    std::span<const region_key> neighbors) const {
-    navigation::stitched_nav_graph stitched;
-    if (!navigation_enabled_) {
-        return stitched;
+inline bool chunk_storage::compress(const chunk_codec_config& config) {
+    std::scoped_lock lock{state_mutex_};
+    if (compressed_) {
+        return false;
     }
+    compression_requested_ = false;
+    return compress_locked(config);
+}
 
-    const auto add_region = [&](const region_key& key) {
-        if (auto it = nav_cache_.find(key); it != nav_cache_.end()) {
-            if (it->second.grid) {
-                stitched.regions.push_back(navigation::nav_region_view{key, it->second.grid});
-            }
-        }
-    };
-
-    add_region(origin);
-    for (const auto& neighbor : neighbors) {
-        add_region(neighbor);
+inline bool chunk_storage::flush_compression() {
+    std::scoped_lock lock{state_mutex_};
+    if (!compression_requested_) {
+        return false;
     }
-
-    navigation::stitch_neighbor_regions(nav_config_.neighbor, chunk_extent_, stitched);
-    return stitched;
+    if (!compress_) {
+        compression_requested_ = false;
+        return compressed_ || compress_locked(codec_config_);
+    }
+    decompress_locked();
+    const auto view = make_const_planes_view();
+    compressed_blob_.assign(compress_(view));
+    compression_requested_ = false;
+    compressed_ = true;
+    return true;
 }
 
-inline void region_manager::for_each_loaded(const std::function<void(const region_key&, const chunk_storage&)>& visitor) const {
-    for (const auto& [key, entry] : regions_) {
-        if (entry.chunk) {
-            visitor(key, *entry.chunk);
-        }
+inline bool chunk_storage::decompress() {
+    std::scoped_lock lock{state_mutex_};
+    if (!compressed_ || compressed_blob_->empty()) {
+        return false;
     }
+    decompress_locked();
+    return true;
 }
 
-inline std::vector<region_manager::region_snapshot> region_manager::snapshot_loaded(bool include_clean) const {
-    std::vector<region_snapshot> snapshots;
-    snapshots.reserve(regions_.size());
-    for (const auto& [key, entry] : regions_) {
-        if (!entry.chunk) {
-            continue;
-        }
-        if (!include_clean && !entry.chunk->dirty()) {
-            continue;
-        }
-        snapshots.push_back(region_snapshot{key, std::const_pointer_cast<const chunk_storage>(entry.chunk)});
+inline void chunk_storage::clear_compression() {
+    std::scoped_lock lock{state_mutex_};
+    if (codec_blob_) {
+        decompress_locked();
     }
-    return snapshots;
+    compression_requested_ = false;
+    compressed_ = false;
+    compressed_blob_.reset();
 }
 
-inline bool region_manager::unload(const region_key& key) {
-    auto it = regions_.find(key);
-    if (it == regions_.end()) {
-        return false;
+inline void chunk_storage::reset_planes() {
+    const auto count = extent_.volume();
+    voxels_.reset();
+    palette_.assign(palette_plane{count, voxel_id{}});
+    palette_valid_ = true;
+    skylight_.reset();
+    blocklight_.reset();
+    metadata_.reset();
+    materials_.reset(invalid_material_index);
+    skylight_cache_.reset(0.0f);
+    blocklight_cache_.reset(0.0f);
+    effect_density_.reset(0.0f);
+    effect_velocity_.reset(effects::velocity_sample{});
+    effect_lifetime_.reset(0.0f);
+}
+
+inline chunk_storage::planes_view chunk_storage::make_planes_view() const {
+    const auto count = volume();
+    ensure_dense_voxels();
+    palette_valid_ = false;
+    planes_view view{};
+    auto& dense = voxels_.write();
+    view.voxels = voxel_span<voxel_id>{dense.data(), dense.size()};
+    view.skylight = voxel_span<std::uint8_t>{skylight_.write(count), count};
+    view.blocklight = voxel_span<std::uint8_t>{blocklight_.write(count), count};
+    view.metadata = voxel_span<std::uint8_t>{metadata_.write(count), count};
+    if (materials_enabled_) {
+        view.materials = voxel_span<material_index>{materials_.write(count), count};
     }
-    if (it->second.pinned) {
-        return false;
+    if (high_precision_lighting_enabled_) {
+        view.skylight_cache = std::span<float>{skylight_cache_.write(count), count};
+        view.blocklight_cache = std::span<float>{blocklight_cache_.write(count), count};
     }
-    if (it->second.chunk && saver_ && it->second.chunk->dirty()) {
-        saver_(key, *it->second.chunk);
+    if (effect_density_enabled()) {
+        view.effect_density = voxel_span<float>{effect_density_.write(count), count};
     }
-    clear_nav_cache(key);
-    regions_.erase(it);
-    return true;
-}
-
-inline void region_manager::evict_until_within_limit() {
-    while (regions_.size() > max_resident_ && !lru_.empty()) {
-        const auto key = lru_.front();
-        lru_.pop_front();
-        auto it = regions_.find(key);
-        if (it == regions_.end() || it->second.pinned) {
-            continue;
-        }
-        if (it->second.chunk && saver_ && it->second.chunk->dirty()) {
-            saver_(key, *it->second.chunk);
-        }
-        clear_nav_cache(key);
-        regions_.erase(it);
+    if (effect_velocity_enabled()) {
+        view.effect_velocity = voxel_span<effects::velocity_sample>{effect_velocity_.write(count), count};
     }
+    if (effect_lifetime_enabled()) {
+        view.effect_lifetime = voxel_span<float>{effect_lifetime_.write(count), count};
+    }
+    return view;
 }
 
-inline chunk_storage& region_manager::load_or_create(const region_key& key) {
-    if (auto it = regions_.find(key); it != regions_.end()) {
-        return *it->second.chunk;
+inline chunk_storage::const_planes_view chunk_storage::make_const_planes_view() const {
+    const auto count = volume();
+    ensure_dense_voxels();
+    const_planes_view view{};
+    view.voxels = voxel_cspan<voxel_id>{voxels_->data(), voxels_->size()};
+    view.skylight = voxel_cspan<std::uint8_t>{skylight_.read(count), count};
+    view.blocklight = voxel_cspan<std::uint8_t>{blocklight_.read(count), count};
+    view.metadata = voxel_cspan<std::uint8_t>{metadata_.read(count), count};
+    if (materials_enabled_) {
+        view.materials = std::span<const material_index>{materials_.read(count), count};
     }
-    chunk_ptr chunk;
-    if (loader_) {
-        chunk = std::make_shared<chunk_storage>(loader_(key));
-    } else {
-        chunk = std::make_shared<chunk_storage>(chunk_extent_);
+    if (high_precision_lighting_enabled_) {
+        view.skylight_cache = std::span<const float>{skylight_cache_.read(count), count};
+        view.blocklight_cache = std::span<const float>{blocklight_cache_.read(count), count};
     }
-    if (chunk) {
-        chunk->add_dirty_listener([this, key]() {
-            mark_nav_dirty(key);
-            for (auto& observer : dirty_observers_) {
-                if (observer) {
-                    observer(key);
-                }
-            }
-        });
+    if (effect_density_enabled()) {
+        view.effect_density = voxel_cspan<float>{effect_density_.read(count), count};
     }
-    auto [it, inserted] = regions_.emplace(key, entry{std::move(chunk), false});
-    (void)inserted;
-    if (navigation_enabled_) {
-        mark_nav_dirty(key);
+    if (effect_velocity_enabled()) {
+        view.effect_velocity = voxel_cspan<effects::velocity_sample>{effect_velocity_.read(count), count};
+    }
+    if (effect_lifetime_enabled()) {
+        view.effect_lifetime = voxel_cspan<float>{effect_lifetime_.read(count), count};
     }
-    return *it->second.chunk;
+    return view;
 }
 
-inline void region_manager::touch(const region_key& key) {
-    std::erase(lru_, key);
-    lru_.push_back(key);
+template <typename T>
+inline const T* chunk_storage::read_plane(detail::lazy_plane<T>& plane) const {
+    std::scoped_lock lock{state_mutex_};
+    decompress_locked();
+    return plane.read(volume());
 }
 
-inline void region_manager::mark_nav_dirty(const region_key& key) {
-    if (!navigation_enabled_) {
-        return;
+inline void chunk_storage::ensure_decompressed() const {
+    if (compressed_.load(std::memory_order_acquire)) {
+        std::scoped_lock lock{state_mutex_};
+        decompress_locked();
     }
-    auto& entry = nav_cache_[key];
-    entry.dirty = true;
-    schedule_nav_rebuild(key);
 }
 
-inline void region_manager::schedule_nav_rebuild(const region_key& key) {
-    if (!navigation_enabled_) {
+inline void chunk_storage::ensure_dense_voxels() const {
+    if (!voxels_->empty() || !palette_valid_) {
         return;
     }
-    auto& entry = nav_cache_[key];
-    if (entry.rebuild_pending) {
+    auto& dense = voxels_.write();
+    dense.resize(palette_->size());
+    palette_->decode(dense);
+}
+
+inline void chunk_storage::decompress_locked() const {
+    if (!compressed_ || compressed_blob_->empty()) {
         return;
     }
-    entry.rebuild_pending = true;
-    task_queue_.emplace_back(key, [this, key](chunk_storage& chunk, const region_key&) {
-        auto grid = std::make_shared<navigation::nav_grid>(
-            navigation::build_nav_grid(static_cast<const chunk_storage&>(chunk), nav_config_));
-        if (auto it = nav_cache_.find(key); it != nav_cache_.end()) {
-            it->second.grid = std::move(grid);
-            it->second.dirty = false;
-            it->second.rebuild_pending = false;
-            ++it->second.revision;
+    if (codec_blob_) {
+        decode_planes_locked();
+    } else if (decompress_) {
+        decompress_(make_planes_view(), *compressed_blob_);
+    }
+    compressed_blob_.reset();
+    compressed_ = false;
+    codec_blob_ = false;
+}
+
+template <typename Fn>
+inline void chunk_storage::for_each_lazy_plane(Fn&& fn) const {
+    fn(chunk_plane::skylight, skylight_);
+    fn(chunk_plane::blocklight, blocklight_);
+    fn(chunk_plane::metadata, metadata_);
+    fn(chunk_plane::materials, materials_);
+    fn(chunk_plane::skylight_cache, skylight_cache_);
+    fn(chunk_plane::blocklight_cache, blocklight_cache_);
+    fn(chunk_plane::effect_density, effect_density_);
+    fn(chunk_plane::effect_velocity, effect_velocity_);
+    fn(chunk_plane::effect_lifetime, effect_lifetime_);
+}
+
+namespace detail {
+
+// Built-in blob layout: version byte, then one record per encoded plane: plane index, codec id, u32 payload size
+// (little endian), payload. Planes without a record were uniform or palette-packed and stayed resident.
+inline constexpr std::uint8_t codec_blob_version = 1;
+inline constexpr std::size_t codec_record_header = 6;
+
+inline std::size_t plane_index(chunk_plane plane) noexcept {
+    return static_cast<std::size_t>(std::countr_zero(static_cast<std::uint32_t>(plane)));
+}
+
+} // namespace detail
+
+inline bool chunk_storage::compress_locked(const chunk_codec_config& config) {
+    const auto& registry = codec_registry::shared();
+    byte_vector blob{std::byte{detail::codec_blob_version}};
+    const auto append = [&](chunk_plane plane, std::span<const std::byte> bytes, std::size_t element_size) {
+        const auto header = blob.size();
+        blob.resize(header + detail::codec_record_header);
+        const auto id = registry.encode(config.codec_for(plane), bytes, element_size, blob);
+        const auto size = static_cast<std::uint32_t>(blob.size() - header - detail::codec_record_header);
+        blob[header] = static_cast<std::byte>(detail::plane_index(plane));
+        blob[header + 1] = static_cast<std::byte>(id);
+        for (std::size_t i = 0; i < 4; ++i) {
+            blob[header + 2 + i] = static_cast<std::byte>((size >> (8 * i)) & 0xFFu);
+        }
+    };
+
+    const bool encode_voxels = !voxels_->empty() && !palette_valid_;
+    if (encode_voxels) {
+        append(chunk_plane::voxels, std::as_bytes(std::span<const voxel_id>{*voxels_}), sizeof(voxel_id));
+    }
+    for_each_lazy_plane([&](chunk_plane plane, auto& lazy) {
+        using value_type = typename std::remove_cvref_t<decltype(lazy)>::value_type;
+        if (!lazy.uniform() && lazy.materialised()) {
+            append(plane, std::as_bytes(std::span<const value_type>{lazy.data(), volume()}), sizeof(value_type));
+        }
+    });
+
+    // Encoding is done; only now drop the dense arrays so a throwing codec leaves the chunk untouched.
+    if (palette_valid_ || encode_voxels) {
+        voxels_.reset();
+    }
+    if (encode_voxels) {
+        palette_.reset();
+    }
+    for_each_lazy_plane([](chunk_plane, auto& lazy) {
+        if (lazy.uniform()) {
+            lazy.release();
+        } else {
+            lazy.discard();
         }
     });
+    if (blob.size() == 1) {
+        return false;
+    }
+    blob.shrink_to_fit();
+    compressed_blob_.assign(std::move(blob));
+    compressed_ = true;
+    codec_blob_ = true;
+    return true;
 }
 
-inline void region_manager::clear_nav_cache(const region_key& key) {
-    nav_cache_.erase(key);
+inline void chunk_storage::decode_planes_locked() const {
+    struct record {
+        bool present{false};
+        codec_id id{codec_id::raw};
+        std::span<const std::byte> payload{};
+    };
+
+    const std::span<const std::byte> blob{*compressed_blob_};
+    if (blob.empty() || std::to_integer<std::uint8_t>(blob[0]) != detail::codec_blob_version) {
+        throw std::runtime_error("unsupported chunk codec blob");
+    }
+    std::array<record, chunk_plane_count> records{};
+    std::size_t offset = 1;
+    while (offset < blob.size()) {
+        if (blob.size() - offset < detail::codec_record_header) {
+            throw std::runtime_error("truncated chunk codec blob");
+        }
+        const auto index = std::to_integer<std::size_t>(blob[offset]);
+        const auto id = static_cast<codec_id>(std::to_integer<std::uint8_t>(blob[offset + 1]));
+        std::size_t size = 0;
+        for (std::size_t i = 0; i < 4; ++i) {
+            size |= std::to_integer<std::size_t>(blob[offset + 2 + i]) << (8 * i);
+        }
+        offset += detail::codec_record_header;
+        if (index >= chunk_plane_count || size > blob.size() - offset) {
+            throw std::runtime_error("malformed chunk codec blob");
+        }
+        records[index] = record{true, id, blob.subspan(offset, size)};
+        offset += size;
+    }
+
+    const auto& registry = codec_registry::shared();
+    const auto count = volume();
+    const auto& voxel_record = records[detail::plane_index(chunk_plane::voxels)];
+    if (voxel_record.present) {
+        std::vector<voxel_id> values(count);
+        registry.decode(voxel_record.id, voxel_record.payload, std::as_writable_bytes(std::span{values}),
+            sizeof(voxel_id));
+        voxels_.assign(std::move(values));
+        palette_valid_ = false;
+    }
+    for_each_lazy_plane([&](chunk_plane plane, auto& lazy) {
+        using value_type = typename std::remove_cvref_t<decltype(lazy)>::value_type;
+        const auto& entry = records[detail::plane_index(plane)];
+        if (!entry.present) {
+            return;
+        }
+        std::vector<value_type> values(count);
+        registry.decode(entry.id, entry.payload, std::as_writable_bytes(std::span{values}), sizeof(value_type));
+        lazy.restore(std::move(values));
+    });
 }
 
 } // namespace almond::voxel
-// end: almond_voxel/world.hpp
+// end: almond_voxel/chunk.hpp
 
 // begin: almond_voxel/effects/particle_emitter.hpp
 
+
 #include <algorithm>
 #include <array>
 #include <cstddef>
@@ -1799,7 +2691,11 @@ inline bool stamp_emitter(chunk_storage& chunk, const std::array<std::uint32_t,
     if (!chunk.effect_density_enabled() || !chunk.effect_velocity_enabled() || !chunk.effect_lifetime_enabled()) {
         return false;
     }
+    if (!chunk.extent().contains(local[0], local[1], local[2])) {
+        return false;
+    }
 
+    auto scope = chunk.edit();
     auto density = chunk.effect_density();
     if (!density.contains(local[0], local[1], local[2])) {
         return false;
@@ -1832,6 +2728,28 @@ inline bool simulate_decay(chunk_storage& chunk, decay_settings settings) {
         return false;
     }
 
+    // Settled chunks are left untouched so idle emitters do not keep marking effect planes dirty.
+    const auto& settled = chunk;
+    const auto settled_lifetime = settled.effect_lifetime().linear();
+    const auto settled_density = chunk.effect_density_enabled() ? settled.effect_density().linear() : voxel_cspan<float>{};
+    const auto settled_velocity = chunk.effect_velocity_enabled() ? settled.effect_velocity().linear()
+                                                                  : voxel_cspan<velocity_sample>{};
+    bool pending = false;
+    for (std::size_t i = 0; i < settled_lifetime.size() && !pending; ++i) {
+        if (settled_lifetime[i] > 0.0f) {
+            pending = true;
+        } else if (!settled_density.empty() && settled_density[i] != 0.0f) {
+            pending = true;
+        } else if (!settled_velocity.empty()
+            && (settled_velocity[i].x != 0.0f || settled_velocity[i].y != 0.0f || settled_velocity[i].z != 0.0f)) {
+            pending = true;
+        }
+    }
+    if (!pending) {
+        return false;
+    }
+
+    auto scope = chunk.edit();
     auto lifetime = chunk.effect_lifetime();
     auto lifetime_linear = lifetime.linear();
 
@@ -1882,882 +2800,3575 @@ inline bool simulate_decay(chunk_storage& chunk, decay_settings settings) {
 }
 
 } // namespace almond::voxel::effects
-
 // end: almond_voxel/effects/particle_emitter.hpp
 
-// begin: almond_voxel/editing/voxel_editing.hpp
+// begin: almond_voxel/world_fwd.hpp
+
+#include <cstdint>
+
+namespace almond::voxel {
+
+struct region_key {
+    std::int32_t x{0};
+    std::int32_t y{0};
+    std::int32_t z{0};
+
+    [[nodiscard]] friend constexpr bool operator==(const region_key& lhs, const region_key& rhs) noexcept = default;
+};
+
+struct region_key_hash {
+    [[nodiscard]] std::size_t operator()(const region_key& key) const noexcept {
+        std::uint64_t hx = static_cast<std::uint64_t>(key.x);
+        std::uint64_t hy = static_cast<std::uint64_t>(key.y);
+        std::uint64_t hz = static_cast<std::uint64_t>(key.z);
+        std::uint64_t hash = hx * 0x9E3779B185EBCA87ull;
+        hash ^= hy + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+        hash ^= hz + 0xC2B2AE3D27D4EB4Full + (hash << 6) + (hash >> 2);
+        return static_cast<std::size_t>(hash);
+    }
+};
+
+} // namespace almond::voxel
+// end: almond_voxel/world_fwd.hpp
+
+// begin: almond_voxel/navigation/voxel_nav.hpp
 
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <queue>
 #include <utility>
+#include <vector>
 
-namespace almond::voxel::editing {
+namespace almond::voxel {
 
-struct world_position {
-    std::int64_t x{0};
-    std::int64_t y{0};
-    std::int64_t z{0};
-};
+namespace navigation {
 
-struct chunk_coordinates {
-    region_key region{};
-    std::array<std::uint32_t, 3> local{};
+using nav_node_index = std::size_t;
+
+struct nav_neighbor_config {
+    float horizontal_cost{1.0f};
+    float vertical_cost{1.0f};
+    std::uint32_t max_step_height{1};
 };
 
-namespace detail {
+struct nav_build_config {
+    std::uint32_t clearance{2};
+    nav_neighbor_config neighbor{};
+    std::function<bool(voxel_id)> is_solid{
+        [](voxel_id id) { return id != voxel_id{}; }
+    };
+    std::function<float(const chunk_storage&, std::uint32_t, std::uint32_t, std::uint32_t)> sample_cost{
+        [](const chunk_storage&, std::uint32_t, std::uint32_t, std::uint32_t) { return 1.0f; }
+    };
+};
 
-inline std::pair<std::int32_t, std::uint32_t> floor_divmod(std::int64_t value, std::uint32_t divisor) {
-    const std::int64_t denom = static_cast<std::int64_t>(divisor);
-    std::int64_t quotient = value / denom;
-    std::int64_t remainder = value % denom;
-    if (remainder < 0) {
-        remainder += denom;
-        --quotient;
-    }
-    return {static_cast<std::int32_t>(quotient), static_cast<std::uint32_t>(remainder)};
-}
+struct nav_cell {
+    bool walkable{false};
+    float traversal_cost{1.0f};
+};
 
-} // namespace detail
+struct nav_grid {
+    chunk_extent extent{};
+    std::vector<nav_cell> cells{};
 
-inline chunk_coordinates split_world_position(const world_position& position, const chunk_extent& extent) {
-    auto [rx, lx] = detail::floor_divmod(position.x, extent.x);
-    auto [ry, ly] = detail::floor_divmod(position.y, extent.y);
-    auto [rz, lz] = detail::floor_divmod(position.z, extent.z);
-    chunk_coordinates coords{};
-    coords.region = region_key{rx, ry, rz};
-    coords.local = {lx, ly, lz};
-    return coords;
-}
+    [[nodiscard]] std::size_t size() const noexcept { return cells.size(); }
 
-inline std::size_t linear_index(const chunk_extent& extent, const std::array<std::uint32_t, 3>& local) {
-    return static_cast<std::size_t>(local[0])
-        + static_cast<std::size_t>(extent.x) * (static_cast<std::size_t>(local[1])
-              + static_cast<std::size_t>(extent.y) * static_cast<std::size_t>(local[2]));
-}
+    [[nodiscard]] bool contains(std::uint32_t x, std::uint32_t y, std::uint32_t z) const noexcept {
+        return extent.contains(x, y, z);
+    }
 
-inline bool set_voxel(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local, voxel_id id) {
-    auto vox = chunk.voxels();
-    if (!vox.contains(local[0], local[1], local[2])) {
-        return false;
+    [[nodiscard]] nav_node_index index(std::uint32_t x, std::uint32_t y, std::uint32_t z) const noexcept {
+        return static_cast<nav_node_index>(x)
+            + static_cast<nav_node_index>(extent.x) * (static_cast<nav_node_index>(y)
+                + static_cast<nav_node_index>(extent.y) * static_cast<nav_node_index>(z));
     }
-    vox(local[0], local[1], local[2]) = id;
-    return true;
-}
 
-inline bool clear_voxel(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local) {
-    return set_voxel(chunk, local, voxel_id{});
-}
+    [[nodiscard]] std::array<std::uint32_t, 3> coordinates(nav_node_index node) const noexcept {
+        const auto xy = static_cast<nav_node_index>(extent.x) * static_cast<nav_node_index>(extent.y);
+        const auto z = static_cast<std::uint32_t>(node / xy);
+        const auto rem = node % xy;
+        const auto y = static_cast<std::uint32_t>(rem / extent.x);
+        const auto x = static_cast<std::uint32_t>(rem % extent.x);
+        return {x, y, z};
+    }
 
-inline bool set_effect_density(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local, float value) {
-    chunk.enable_effect_channels(effects::channel::density);
-    auto density = chunk.effect_density();
-    if (!density.contains(local[0], local[1], local[2])) {
-        return false;
+    [[nodiscard]] bool walkable(nav_node_index node) const noexcept {
+        return node < cells.size() && cells[node].walkable;
     }
-    density(local[0], local[1], local[2]) = value;
-    return true;
-}
 
-inline bool set_effect_velocity(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local,
-    const effects::velocity_sample& value) {
-    chunk.enable_effect_channels(effects::channel::velocity);
-    auto velocity = chunk.effect_velocity();
-    if (!velocity.contains(local[0], local[1], local[2])) {
-        return false;
+    [[nodiscard]] bool walkable(std::uint32_t x, std::uint32_t y, std::uint32_t z) const noexcept {
+        if (!contains(x, y, z)) {
+            return false;
+        }
+        return walkable(index(x, y, z));
     }
-    velocity(local[0], local[1], local[2]) = value;
-    return true;
-}
 
-inline bool set_effect_lifetime(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local, float value) {
-    chunk.enable_effect_channels(effects::channel::lifetime);
-    auto lifetime = chunk.effect_lifetime();
-    if (!lifetime.contains(local[0], local[1], local[2])) {
-        return false;
+    [[nodiscard]] float cost(nav_node_index node) const noexcept {
+        return node < cells.size() ? cells[node].traversal_cost : 1.0f;
     }
-    lifetime(local[0], local[1], local[2]) = value;
-    return true;
-}
+};
 
-inline bool set_voxel(region_manager& regions, const world_position& position, voxel_id id) {
-    const auto coords = split_world_position(position, regions.chunk_dimensions());
-    auto& chunk = regions.assure(coords.region);
-    return set_voxel(chunk, coords.local, id);
-}
-
-inline bool clear_voxel(region_manager& regions, const world_position& position) {
-    return set_voxel(regions, position, voxel_id{});
-}
-
-inline bool toggle_voxel(region_manager& regions, const world_position& position, voxel_id on_value) {
-    const auto coords = split_world_position(position, regions.chunk_dimensions());
-    auto& chunk = regions.assure(coords.region);
-    auto vox = chunk.voxels();
-    if (!vox.contains(coords.local[0], coords.local[1], coords.local[2])) {
-        return false;
-    }
-    voxel_id& value = vox(coords.local[0], coords.local[1], coords.local[2]);
-    value = value == voxel_id{} ? on_value : voxel_id{};
-    return true;
-}
-
-inline bool paint_particle_emitter(region_manager& regions, const world_position& position,
-    const effects::particle_emitter_brush& brush, effects::decay_settings decay = {}) {
-    const auto coords = split_world_position(position, regions.chunk_dimensions());
-    auto& chunk = regions.assure(coords.region);
-    chunk.enable_effect_channels(effects::channel::density | effects::channel::velocity | effects::channel::lifetime);
-    if (!effects::stamp_emitter(chunk, coords.local, brush)) {
-        return false;
-    }
+[[nodiscard]] nav_grid build_nav_grid(const chunk_storage& chunk, const nav_build_config& config = {});
 
-    auto manager = &regions;
-    auto recurring = std::make_shared<region_manager::task_type>();
-    *recurring = [manager, decay, recurring](chunk_storage& chunk_ref, const region_key& key) {
-        if (effects::simulate_decay(chunk_ref, decay)) {
-            manager->enqueue_task(key, *recurring);
-        }
-    };
-    manager->enqueue_task(coords.region, *recurring);
-    return true;
-}
+// Re-evaluates only the cells whose walkability can depend on voxels inside `dirty` (the box grown by the clearance
+// below and one cell above). `sample_cost` is assumed to depend on the voxel column at the evaluated cell.
+void update_nav_grid(nav_grid& grid, const chunk_storage& chunk, const voxel_bounds& dirty,
+    const nav_build_config& config = {});
 
-} // namespace almond::voxel::editing
-// end: almond_voxel/editing/voxel_editing.hpp
+struct nav_edge {
+    nav_node_index node{std::numeric_limits<nav_node_index>::max()};
+    float cost{std::numeric_limits<float>::infinity()};
+};
 
-// begin: almond_voxel/generation/noise.hpp
+using neighbor_list = std::vector<nav_edge>;
 
+void for_each_neighbor(const nav_grid& grid, nav_node_index node, const nav_neighbor_config& config,
+    const std::function<void(nav_edge)>& visitor);
 
-#include <algorithm>
-#include <cmath>
-#include <cstdint>
-#include <vector>
+[[nodiscard]] neighbor_list neighbors(const nav_grid& grid, nav_node_index node, const nav_neighbor_config& config = {});
 
-namespace almond::voxel::generation {
+struct nav_path {
+    std::vector<nav_node_index> nodes{};
+    float total_cost{std::numeric_limits<float>::infinity()};
+};
 
-class value_noise {
-public:
-    explicit value_noise(std::uint64_t seed = 0, double frequency = 1.0, std::size_t octaves = 4, double persistence = 0.5) noexcept
-        : seed_{seed}
-        , frequency_{frequency}
-        , octaves_{octaves}
-        , persistence_{persistence} {
-    }
+[[nodiscard]] std::optional<nav_path> a_star(const nav_grid& grid, nav_node_index start, nav_node_index goal,
+    const nav_neighbor_config& config = {});
 
-    [[nodiscard]] double sample(double x, double y, double z = 0.0) const noexcept {
-        double amplitude = 1.0;
-        double frequency = frequency_;
-        double sum = 0.0;
-        double max_amplitude = 0.0;
-        for (std::size_t octave = 0; octave < octaves_; ++octave) {
-            sum += amplitude * gradient_noise(x * frequency, y * frequency, z * frequency);
-            max_amplitude += amplitude;
-            amplitude *= persistence_;
-            frequency *= 2.0;
-        }
-        if (max_amplitude == 0.0) {
-            return 0.0;
-        }
-        return sum / max_amplitude;
-    }
+struct flow_field {
+    static constexpr nav_node_index invalid_node = std::numeric_limits<nav_node_index>::max();
 
-private:
-    [[nodiscard]] double gradient_noise(double x, double y, double z) const noexcept {
-        const auto xi = static_cast<std::int64_t>(std::floor(x));
-        const auto yi = static_cast<std::int64_t>(std::floor(y));
-        const auto zi = static_cast<std::int64_t>(std::floor(z));
-        const double xf = x - static_cast<double>(xi);
-        const double yf = y - static_cast<double>(yi);
-        const double zf = z - static_cast<double>(zi);
+    chunk_extent extent{};
+    std::vector<nav_node_index> next{};
+    std::vector<float> distance{};
+};
 
-        const double u = fade(xf);
-        const double v = fade(yf);
-        const double w = fade(zf);
+[[nodiscard]] flow_field compute_flow_field(const nav_grid& grid, nav_node_index goal, const nav_neighbor_config& config = {});
 
-        const double c000 = grad(hash(xi, yi, zi), xf, yf, zf);
-        const double c100 = grad(hash(xi + 1, yi, zi), xf - 1.0, yf, zf);
-        const double c010 = grad(hash(xi, yi + 1, zi), xf, yf - 1.0, zf);
-        const double c110 = grad(hash(xi + 1, yi + 1, zi), xf - 1.0, yf - 1.0, zf);
-        const double c001 = grad(hash(xi, yi, zi + 1), xf, yf, zf - 1.0);
-        const double c101 = grad(hash(xi + 1, yi, zi + 1), xf - 1.0, yf, zf - 1.0);
-        const double c011 = grad(hash(xi, yi + 1, zi + 1), xf, yf - 1.0, zf - 1.0);
-        const double c111 = grad(hash(xi + 1, yi + 1, zi + 1), xf - 1.0, yf - 1.0, zf - 1.0);
+[[nodiscard]] std::vector<nav_node_index> follow_flow(const flow_field& field, nav_node_index start,
+    std::size_t max_steps = 1024);
 
-        const double x00 = lerp(c000, c100, u);
-        const double x10 = lerp(c010, c110, u);
-        const double x01 = lerp(c001, c101, u);
-        const double x11 = lerp(c011, c111, u);
+struct nav_region_view {
+    region_key key{};
+    std::shared_ptr<const nav_grid> grid;
+};
 
-        const double y0 = lerp(x00, x10, v);
-        const double y1 = lerp(x01, x11, v);
+struct nav_bridge {
+    region_key from_region{};
+    nav_node_index from_node{flow_field::invalid_node};
+    region_key to_region{};
+    nav_node_index to_node{flow_field::invalid_node};
+    float cost{std::numeric_limits<float>::infinity()};
+};
 
-        return lerp(y0, y1, w);
-    }
+struct stitched_nav_graph {
+    std::vector<nav_region_view> regions{};
+    std::vector<nav_bridge> bridges{};
+};
 
-    [[nodiscard]] static constexpr double fade(double t) noexcept {
-        return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
-    }
+void stitch_neighbor_regions(const nav_neighbor_config& neighbor, chunk_extent extent, stitched_nav_graph& stitched);
 
-    [[nodiscard]] static constexpr double lerp(double a, double b, double t) noexcept {
-        return a + t * (b - a);
-    }
+} // namespace navigation
 
-    [[nodiscard]] double grad(std::uint64_t hash_value, double x, double y, double z) const noexcept {
-        const std::uint64_t h = hash_value & 15ull;
-        const double u = h < 8ull ? x : y;
-        const double v = h < 4ull ? y : (h == 12ull || h == 14ull ? x : z);
-        const double first = (h & 1ull) == 0ull ? u : -u;
-        const double second = (h & 2ull) == 0ull ? v : -v;
-        return first + second;
-    }
+} // namespace almond::voxel
 
-    [[nodiscard]] std::uint64_t hash(std::int64_t x, std::int64_t y, std::int64_t z) const noexcept {
-        std::uint64_t h = seed_;
-        h ^= static_cast<std::uint64_t>(x) * 0x9E3779B185EBCA87ull;
-        h ^= static_cast<std::uint64_t>(y) * 0xC2B2AE3D27D4EB4Full;
-        h ^= static_cast<std::uint64_t>(z) * 0x165667B19E3779F9ull;
-        h ^= (h >> 33);
-        h *= 0xff51afd7ed558ccdull;
-        h ^= (h >> 33);
-        h *= 0xc4ceb9fe1a85ec53ull;
-        h ^= (h >> 33);
-        return h;
-    }
+// Implementation
 
-    std::uint64_t seed_;
-    double frequency_;
-    std::size_t octaves_;
-    double persistence_;
-};
+namespace almond::voxel::navigation {
 
-struct palette_entry {
-    double threshold{0.0};
-    voxel_id id{0};
-};
+namespace detail {
 
-class palette_builder {
-public:
-    palette_builder& add(double threshold, voxel_id id) {
-        entries_.push_back(palette_entry{threshold, id});
-        std::sort(entries_.begin(), entries_.end(), [](const auto& lhs, const auto& rhs) {
-            return lhs.threshold < rhs.threshold;
-        });
-        return *this;
-    }
+inline void evaluate_nav_cells(nav_grid& grid, const chunk_storage& chunk, const nav_build_config& config,
+    const voxel_bounds& region) {
+    const auto voxels = chunk.voxels();
+    const std::uint32_t clearance = std::max<std::uint32_t>(1, config.clearance);
 
-    [[nodiscard]] voxel_id choose(double value) const noexcept {
-        if (entries_.empty()) {
-            return voxel_id{};
-        }
-        for (const auto& entry : entries_) {
-            if (value <= entry.threshold) {
-                return entry.id;
+    for (std::uint32_t z = region.min[2]; z < region.max[2]; ++z) {
+        for (std::uint32_t y = region.min[1]; y < region.max[1]; ++y) {
+            for (std::uint32_t x = region.min[0]; x < region.max[0]; ++x) {
+                auto& cell = grid.cells[grid.index(x, y, z)];
+                cell = nav_cell{};
+                bool open = true;
+                for (std::uint32_t h = 0; h < clearance; ++h) {
+                    const std::uint32_t sample_y = y + h;
+                    if (sample_y >= grid.extent.y) {
+                        break;
+                    }
+                    if (config.is_solid(voxels(x, sample_y, z))) {
+                        open = false;
+                        break;
+                    }
+                }
+                if (!open) {
+                    continue;
+                }
+                const bool supported = (y == 0) || config.is_solid(voxels(x, y - 1, z));
+                if (!supported) {
+                    continue;
+                }
+                cell.walkable = true;
+                cell.traversal_cost = config.sample_cost(chunk, x, y, z);
             }
         }
-        return entries_.back().id;
     }
+}
 
-    [[nodiscard]] const std::vector<palette_entry>& entries() const noexcept { return entries_; }
-
-private:
-    std::vector<palette_entry> entries_{};
-};
+} // namespace detail
 
-[[nodiscard]] inline double remap(double value, double min, double max) noexcept {
-    if (min == max) {
-        return 0.0;
-    }
-    const double clamped = std::clamp(value, min, max);
-    return (clamped - min) / (max - min);
-}
+inline nav_grid build_nav_grid(const chunk_storage& chunk, const nav_build_config& config) {
+    nav_grid grid;
+    grid.extent = chunk.extent();
+    grid.cells.resize(grid.extent.volume());
 
-template <typename OutputIt>
-void sample_heightmap(const value_noise& noise, const chunk_extent& extent, double scale, OutputIt out) {
-    const auto dims = extent.to_array();
-    for (std::uint32_t z = 0; z < dims[2]; ++z) {
-        for (std::uint32_t x = 0; x < dims[0]; ++x) {
-            const double nx = static_cast<double>(x) / static_cast<double>(dims[0]);
-            const double nz = static_cast<double>(z) / static_cast<double>(dims[2]);
-            *out++ = noise.sample(nx * scale, nz * scale);
+    if (const auto uniform = chunk.uniform_voxel()) {
+        // Solid chunks have no open cells; open chunks are only supported on their floor layer.
+        if (config.is_solid(*uniform) || grid.extent.y == 0) {
+            return grid;
+        }
+        for (std::uint32_t z = 0; z < grid.extent.z; ++z) {
+            for (std::uint32_t x = 0; x < grid.extent.x; ++x) {
+                auto& cell = grid.cells[grid.index(x, 0, z)];
+                cell.walkable = true;
+                cell.traversal_cost = config.sample_cost(chunk, x, 0, z);
+            }
         }
+        return grid;
     }
+
+    detail::evaluate_nav_cells(grid, chunk, config, voxel_bounds::full(grid.extent));
+    return grid;
 }
 
-template <typename Range>
-[[nodiscard]] std::vector<voxel_id> build_palette(const Range& samples, const palette_builder& palette) {
-    std::vector<voxel_id> result;
-    result.reserve(samples.size());
-    if (samples.empty()) {
-        return result;
+inline void update_nav_grid(nav_grid& grid, const chunk_storage& chunk, const voxel_bounds& dirty,
+    const nav_build_config& config) {
+    if (grid.extent != chunk.extent() || grid.cells.size() != grid.extent.volume() || chunk.uniform_voxel()) {
+        grid = build_nav_grid(chunk, config);
+        return;
     }
-    const auto [min_it, max_it] = std::minmax_element(samples.begin(), samples.end());
-    const double min_v = *min_it;
-    const double max_v = *max_it;
-    for (const auto& value : samples) {
-        result.push_back(palette.choose(remap(value, min_v, max_v)));
+    const std::uint32_t clearance = std::max<std::uint32_t>(1, config.clearance);
+    const auto region = dirty.expanded({0, clearance - 1, 0}, {0, 1, 0}, grid.extent);
+    if (region.empty()) {
+        return;
     }
-    return result;
+    detail::evaluate_nav_cells(grid, chunk, config, region);
 }
 
-} // namespace almond::voxel::generation
-// end: almond_voxel/generation/noise.hpp
+inline void for_each_neighbor(const nav_grid& grid, nav_node_index node, const nav_neighbor_config& config,
+    const std::function<void(nav_edge)>& visitor) {
+    if (!grid.walkable(node)) {
+        return;
+    }
 
-// begin: almond_voxel/meshing/mesh_types.hpp
-
-
-#include <array>
-#include <cstdint>
-#include <vector>
+    const auto [x, y, z] = grid.coordinates(node);
+    const std::array<std::array<int, 3>, 6> offsets{ {{{1, 0, 0}}, {{-1, 0, 0}}, {{0, 1, 0}}, {{0, -1, 0}}, {{0, 0, 1}}, {{0, 0, -1}}} };
 
-namespace almond::voxel::meshing {
+    for (const auto& offset : offsets) {
+        const int nx = static_cast<int>(x) + offset[0];
+        const int ny = static_cast<int>(y) + offset[1];
+        const int nz = static_cast<int>(z) + offset[2];
+        if (nx < 0 || ny < 0 || nz < 0) {
+            continue;
+        }
+        const auto ux = static_cast<std::uint32_t>(nx);
+        const auto uy = static_cast<std::uint32_t>(ny);
+        const auto uz = static_cast<std::uint32_t>(nz);
+        if (!grid.contains(ux, uy, uz)) {
+            continue;
+        }
+        if (std::abs(static_cast<int>(uy) - static_cast<int>(y)) > static_cast<int>(config.max_step_height)) {
+            continue;
+        }
+        const auto neighbor_idx = grid.index(ux, uy, uz);
+        if (!grid.walkable(neighbor_idx)) {
+            continue;
+        }
+        float movement_cost = config.horizontal_cost;
+        if (offset[1] != 0) {
+            movement_cost = config.vertical_cost * static_cast<float>(std::abs(offset[1]));
+        }
+        const float weight = 0.5f * (grid.cost(node) + grid.cost(neighbor_idx));
+        visitor(nav_edge{neighbor_idx, movement_cost * weight});
+    }
+}
 
-struct vertex {
-    std::array<float, 3> position{};
-    std::array<float, 3> normal{};
-    std::array<float, 2> uv{};
-    voxel_id id{0};
-};
+inline neighbor_list neighbors(const nav_grid& grid, nav_node_index node, const nav_neighbor_config& config) {
+    neighbor_list result;
+    for_each_neighbor(grid, node, config, [&result](nav_edge edge) {
+        result.push_back(edge);
+    });
+    return result;
+}
 
-struct mesh_result {
-    std::vector<vertex> vertices;
-    std::vector<std::uint32_t> indices;
-};
+inline float heuristic_distance(const nav_grid& grid, nav_node_index node, nav_node_index goal,
+    const nav_neighbor_config& config) {
+    const auto [x1, y1, z1] = grid.coordinates(node);
+    const auto [x2, y2, z2] = grid.coordinates(goal);
+    const float dx = static_cast<float>(std::abs(static_cast<int>(x1) - static_cast<int>(x2)));
+    const float dy = static_cast<float>(std::abs(static_cast<int>(y1) - static_cast<int>(y2)));
+    const float dz = static_cast<float>(std::abs(static_cast<int>(z1) - static_cast<int>(z2)));
+    return (dx + dz) * config.horizontal_cost + dy * config.vertical_cost;
+}
 
-} // namespace almond::voxel::meshing
-// end: almond_voxel/meshing/mesh_types.hpp
+inline std::optional<nav_path> a_star(const nav_grid& grid, nav_node_index start, nav_node_index goal,
+    const nav_neighbor_config& config) {
+    if (!grid.walkable(start) || !grid.walkable(goal)) {
+        return std::nullopt;
+    }
 
-// begin: almond_voxel/meshing/neighbors.hpp
+    struct frontier_node {
+        nav_node_index node;
+        float priority;
+        float cost;
+    };
 
+    struct compare {
+        bool operator()(const frontier_node& lhs, const frontier_node& rhs) const noexcept {
+            return lhs.priority > rhs.priority;
+        }
+    };
 
-#include <array>
-#include <cstddef>
-#include <cstdint>
+    std::priority_queue<frontier_node, std::vector<frontier_node>, compare> frontier;
+    std::vector<float> g_score(grid.size(), std::numeric_limits<float>::infinity());
+    std::vector<nav_node_index> came_from(grid.size(), flow_field::invalid_node);
 
-namespace almond::voxel::meshing {
+    g_score[start] = 0.0f;
+    frontier.push(frontier_node{start, heuristic_distance(grid, start, goal, config), 0.0f});
 
-struct chunk_neighbors {
-    const chunk_storage* pos_x{nullptr};
-    const chunk_storage* neg_x{nullptr};
-    const chunk_storage* pos_y{nullptr};
-    const chunk_storage* neg_y{nullptr};
-    const chunk_storage* pos_z{nullptr};
-    const chunk_storage* neg_z{nullptr};
+    while (!frontier.empty()) {
+        const auto current = frontier.top();
+        frontier.pop();
 
-    [[nodiscard]] const chunk_storage* get(block_face face) const noexcept {
-        switch (face) {
-        case block_face::pos_x:
-            return pos_x;
-        case block_face::neg_x:
-            return neg_x;
-        case block_face::pos_y:
-            return pos_y;
-        case block_face::neg_y:
-            return neg_y;
-        case block_face::pos_z:
-            return pos_z;
-        case block_face::neg_z:
-        default:
-            return neg_z;
+        if (current.node == goal) {
+            nav_path path;
+            path.total_cost = current.cost;
+            nav_node_index node_it = goal;
+            while (node_it != flow_field::invalid_node) {
+                path.nodes.push_back(node_it);
+                if (node_it == start) {
+                    break;
+                }
+                node_it = came_from[node_it];
+            }
+            std::reverse(path.nodes.begin(), path.nodes.end());
+            return path;
         }
+
+        for_each_neighbor(grid, current.node, config, [&](nav_edge edge) {
+            const float tentative = g_score[current.node] + edge.cost;
+            if (tentative + 1e-6f < g_score[edge.node]) {
+                g_score[edge.node] = tentative;
+                came_from[edge.node] = current.node;
+                const float priority = tentative + heuristic_distance(grid, edge.node, goal, config);
+                frontier.push(frontier_node{edge.node, priority, tentative});
+            }
+        });
     }
-};
 
-namespace detail {
+    return std::nullopt;
+}
 
-struct neighbor_view {
-    span3d<const voxel_id> voxels{};
-    chunk_extent extent{};
-    bool available{false};
-};
+inline flow_field compute_flow_field(const nav_grid& grid, nav_node_index goal, const nav_neighbor_config& config) {
+    flow_field field;
+    field.extent = grid.extent;
+    field.next.assign(grid.size(), flow_field::invalid_node);
+    field.distance.assign(grid.size(), std::numeric_limits<float>::infinity());
 
-inline std::array<neighbor_view, block_face_count> load_neighbor_views(const chunk_neighbors& neighbors) {
-    std::array<neighbor_view, block_face_count> result{};
+    if (!grid.walkable(goal)) {
+        return field;
+    }
 
-    const auto assign = [&](block_face face, const chunk_storage* storage) {
-        if (storage == nullptr) {
-            return;
-        }
-        auto& entry = result[static_cast<std::size_t>(face)];
-        entry.voxels = storage->voxels();
-        entry.extent = storage->extent();
-        entry.available = true;
+    struct queue_node {
+        nav_node_index node;
+        float cost;
     };
 
-    assign(block_face::pos_x, neighbors.pos_x);
-    assign(block_face::neg_x, neighbors.neg_x);
-    assign(block_face::pos_y, neighbors.pos_y);
-    assign(block_face::neg_y, neighbors.neg_y);
-    assign(block_face::pos_z, neighbors.pos_z);
-    assign(block_face::neg_z, neighbors.neg_z);
-
-    return result;
-}
-
-inline bool remap_to_neighbor_coords(const chunk_extent& extent, std::array<std::ptrdiff_t, 3>& coord,
-    const std::array<neighbor_view, block_face_count>& neighbors, const neighbor_view*& out_view) {
-    const std::array<std::ptrdiff_t, 3> dims{
-        static_cast<std::ptrdiff_t>(extent.x),
-        static_cast<std::ptrdiff_t>(extent.y),
-        static_cast<std::ptrdiff_t>(extent.z)
+    struct compare {
+        bool operator()(const queue_node& lhs, const queue_node& rhs) const noexcept {
+            return lhs.cost > rhs.cost;
+        }
     };
 
-    int out_of_bounds_axes = 0;
-    block_face face = block_face::pos_x;
-
-    if (coord[0] < 0) {
-        face = block_face::neg_x;
-        ++out_of_bounds_axes;
-    } else if (coord[0] >= dims[0]) {
-        face = block_face::pos_x;
-        ++out_of_bounds_axes;
-    }
+    std::priority_queue<queue_node, std::vector<queue_node>, compare> queue;
+    queue.push(queue_node{goal, 0.0f});
+    field.distance[goal] = 0.0f;
+    field.next[goal] = goal;
 
-    if (coord[1] < 0) {
-        face = block_face::neg_y;
-        ++out_of_bounds_axes;
-    } else if (coord[1] >= dims[1]) {
-        face = block_face::pos_y;
-        ++out_of_bounds_axes;
-    }
+    while (!queue.empty()) {
+        const auto current = queue.top();
+        queue.pop();
+        if (current.cost > field.distance[current.node] + 1e-6f) {
+            continue;
+        }
 
-    if (coord[2] < 0) {
-        face = block_face::neg_z;
-        ++out_of_bounds_axes;
-    } else if (coord[2] >= dims[2]) {
-        face = block_face::pos_z;
-        ++out_of_bounds_axes;
+        for_each_neighbor(grid, current.node, config, [&](nav_edge edge) {
+            const float candidate = current.cost + edge.cost;
+            if (candidate + 1e-6f < field.distance[edge.node]) {
+                field.distance[edge.node] = candidate;
+                field.next[edge.node] = current.node;
+                queue.push(queue_node{edge.node, candidate});
+            }
+        });
     }
 
-    if (out_of_bounds_axes != 1) {
-        return false;
-    }
+    return field;
+}
 
-    const auto index = static_cast<std::size_t>(face);
-    const auto& view = neighbors[index];
-    if (!view.available) {
-        return false;
+inline std::vector<nav_node_index> follow_flow(const flow_field& field, nav_node_index start, std::size_t max_steps) {
+    std::vector<nav_node_index> path;
+    if (start >= field.next.size()) {
+        return path;
     }
 
-    switch (face) {
-    case block_face::neg_x:
-        coord[0] += static_cast<std::ptrdiff_t>(view.extent.x);
-        break;
-    case block_face::pos_x:
-        coord[0] -= dims[0];
-        break;
-    case block_face::neg_y:
-        coord[1] += static_cast<std::ptrdiff_t>(view.extent.y);
-        break;
-    case block_face::pos_y:
-        coord[1] -= dims[1];
-        break;
-    case block_face::neg_z:
-        coord[2] += static_cast<std::ptrdiff_t>(view.extent.z);
-        break;
-    case block_face::pos_z:
-        coord[2] -= dims[2];
-        break;
+    nav_node_index current = start;
+    for (std::size_t i = 0; i < max_steps; ++i) {
+        path.push_back(current);
+        const nav_node_index next = field.next[current];
+        if (next == flow_field::invalid_node) {
+            path.clear();
+            return path;
+        }
+        if (next == current) {
+            break;
+        }
+        current = next;
     }
+    return path;
+}
 
-    if (coord[0] < 0 || coord[0] >= static_cast<std::ptrdiff_t>(view.extent.x) || coord[1] < 0
-        || coord[1] >= static_cast<std::ptrdiff_t>(view.extent.y) || coord[2] < 0
-        || coord[2] >= static_cast<std::ptrdiff_t>(view.extent.z)) {
-        return false;
+inline void stitch_pair(const nav_neighbor_config& neighbor, chunk_extent extent, const nav_region_view& from,
+    const nav_region_view& to, stitched_nav_graph& stitched) {
+    const int dx = to.key.x - from.key.x;
+    const int dy = to.key.y - from.key.y;
+    const int dz = to.key.z - from.key.z;
+    const int manhattan = std::abs(dx) + std::abs(dy) + std::abs(dz);
+    if (manhattan != 1 || !from.grid || !to.grid) {
+        return;
     }
 
-    out_view = &view;
-    return true;
-}
+    const auto add_bridge = [&](std::uint32_t fx, std::uint32_t fy, std::uint32_t fz, std::uint32_t tx, std::uint32_t ty,
+                                 std::uint32_t tz) {
+        const auto from_index = from.grid->index(fx, fy, fz);
+        const auto to_index = to.grid->index(tx, ty, tz);
+        if (!from.grid->walkable(from_index) || !to.grid->walkable(to_index)) {
+            return;
+        }
+        if (std::abs(static_cast<int>(ty) - static_cast<int>(fy)) > static_cast<int>(neighbor.max_step_height)) {
+            return;
+        }
+        float movement_cost = neighbor.horizontal_cost;
+        const int vertical_delta = static_cast<int>(ty) - static_cast<int>(fy);
+        if (dy != 0) {
+            movement_cost = neighbor.vertical_cost * static_cast<float>(std::abs(dy));
+        }
+        if (vertical_delta != 0) {
+            movement_cost += neighbor.vertical_cost * static_cast<float>(std::abs(vertical_delta));
+        }
+        const float weight = 0.5f * (from.grid->cost(from_index) + to.grid->cost(to_index));
+        stitched.bridges.push_back(nav_bridge{from.key, from_index, to.key, to_index, movement_cost * weight});
+    };
 
-} // namespace detail
+    if (dx != 0) {
+        const std::uint32_t fx = dx > 0 ? extent.x - 1 : 0;
+        const std::uint32_t tx = dx > 0 ? 0 : extent.x - 1;
+        for (std::uint32_t y = 0; y < extent.y; ++y) {
+            for (std::uint32_t z = 0; z < extent.z; ++z) {
+                for (int dy_off = -static_cast<int>(neighbor.max_step_height);
+                     dy_off <= static_cast<int>(neighbor.max_step_height); ++dy_off) {
+                    const int ty = static_cast<int>(y) + dy_off;
+                    if (ty < 0 || ty >= static_cast<int>(extent.y)) {
+                        continue;
+                    }
+                    add_bridge(fx, y, z, tx, static_cast<std::uint32_t>(ty), z);
+                }
+            }
+        }
+        return;
+    }
 
-} // namespace almond::voxel::meshing
-// end: almond_voxel/meshing/neighbors.hpp
+    if (dz != 0) {
+        const std::uint32_t fz = dz > 0 ? extent.z - 1 : 0;
+        const std::uint32_t tz = dz > 0 ? 0 : extent.z - 1;
+        for (std::uint32_t y = 0; y < extent.y; ++y) {
+            for (std::uint32_t x = 0; x < extent.x; ++x) {
+                for (int dy_off = -static_cast<int>(neighbor.max_step_height);
+                     dy_off <= static_cast<int>(neighbor.max_step_height); ++dy_off) {
+                    const int ty = static_cast<int>(y) + dy_off;
+                    if (ty < 0 || ty >= static_cast<int>(extent.y)) {
+                        continue;
+                    }
+                    add_bridge(x, y, fz, x, static_cast<std::uint32_t>(ty), tz);
+                }
+            }
+        }
+        return;
+    }
 
-// begin: almond_voxel/meshing/greedy_mesher.hpp
+    if (dy != 0) {
+        const std::uint32_t fy = dy > 0 ? extent.y - 1 : 0;
+        const std::uint32_t ty = dy > 0 ? 0 : extent.y - 1;
+        for (std::uint32_t x = 0; x < extent.x; ++x) {
+            for (std::uint32_t z = 0; z < extent.z; ++z) {
+                add_bridge(x, fy, z, x, ty, z);
+            }
+        }
+    }
+}
+
+inline void stitch_neighbor_regions(const nav_neighbor_config& neighbor, chunk_extent extent, stitched_nav_graph& stitched) {
+    for (std::size_t i = 0; i < stitched.regions.size(); ++i) {
+        for (std::size_t j = i + 1; j < stitched.regions.size(); ++j) {
+            stitch_pair(neighbor, extent, stitched.regions[i], stitched.regions[j], stitched);
+            stitch_pair(neighbor, extent, stitched.regions[j], stitched.regions[i], stitched);
+        }
+    }
+}
 
+} // namespace almond::voxel::navigation
+// end: almond_voxel/navigation/voxel_nav.hpp
 
-#include <array>
+// begin: almond_voxel/parallel/task_pool.hpp
+
+#include <algorithm>
+#include <condition_variable>
 #include <cstddef>
-#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <utility>
 #include <vector>
 
-namespace almond::voxel::meshing {
-
-template <typename IsOpaque, typename NeighborOpaque>
-[[nodiscard]] mesh_result greedy_mesh_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
-    NeighborOpaque&& neighbor_opaque) {
-    mesh_result result;
-    const auto extent = chunk.extent();
-    const auto dims = extent.to_array();
-    const auto voxels = chunk.voxels();
+namespace almond::voxel::parallel {
 
-    struct mask_cell {
-        bool filled{false};
-        voxel_id id{0};
-    };
+class task_pool;
 
-    const std::array faces{block_face::pos_x, block_face::neg_x, block_face::pos_y, block_face::neg_y, block_face::pos_z, block_face::neg_z};
-    constexpr float vertical_face_bias = 0.001f;
+namespace detail {
 
-    for (auto face : faces) {
-        const std::size_t axis = static_cast<std::size_t>(axis_of(face));
-        const int sign = axis_sign(face);
-        const std::size_t u_axis = (axis + 1) % 3;
-        const std::size_t v_axis = (axis + 2) % 3;
-        const std::size_t du = dims[u_axis];
-        const std::size_t dv = dims[v_axis];
+inline thread_local const task_pool* current_pool = nullptr;
+inline thread_local std::size_t current_worker = 0;
 
-        std::vector<mask_cell> mask(du * dv);
+} // namespace detail
 
-        for (std::size_t plane = 0; plane < dims[axis]; ++plane) {
-            std::fill(mask.begin(), mask.end(), mask_cell{});
+// Fixed-size worker pool with one deque per worker. Workers pop their own newest job first and steal the oldest job
+// from other workers when idle. Jobs submitted from a worker land on that worker's deque; external submissions are
+// spread round-robin. Jobs must not throw.
+class task_pool {
+public:
+    using job = std::function<void()>;
 
-            for (std::size_t v = 0; v < dv; ++v) {
-                for (std::size_t u = 0; u < du; ++u) {
-                    const std::size_t idx = u + v * du;
-                    std::array<std::size_t, 3> pos{};
-                    pos[axis] = plane;
-                    pos[u_axis] = u;
-                    pos[v_axis] = v;
+    explicit task_pool(std::size_t worker_count = default_worker_count());
+    task_pool(const task_pool&) = delete;
+    task_pool& operator=(const task_pool&) = delete;
+    ~task_pool();
 
-                    const voxel_id current = voxels(pos[0], pos[1], pos[2]);
-                    if (!is_opaque(current)) {
-                        continue;
-                    }
+    [[nodiscard]] static std::size_t default_worker_count() noexcept {
+        return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
 
-                    bool neighbor_inside = true;
-                    std::array<std::size_t, 3> neighbor = pos;
-                    if (sign > 0) {
-                        neighbor[axis] = pos[axis] + 1;
-                        neighbor_inside = neighbor[axis] < dims[axis];
-                    } else {
-                        neighbor_inside = pos[axis] > 0;
-                        if (neighbor_inside) {
-                            neighbor[axis] = pos[axis] - 1;
-                        }
-                    }
+    [[nodiscard]] std::size_t worker_count() const noexcept { return threads_.size(); }
+    [[nodiscard]] bool on_worker_thread() const noexcept { return detail::current_pool == this; }
+    // Index in [0, worker_count()) of the calling worker, for per-worker scratch. Only meaningful on_worker_thread().
+    [[nodiscard]] std::size_t worker_index() const noexcept { return detail::current_worker; }
 
-                    bool neighbor_solid = false;
-                    if (neighbor_inside) {
-                        neighbor_solid = is_opaque(voxels(neighbor[0], neighbor[1], neighbor[2]));
-                    } else {
-                        std::array<std::ptrdiff_t, 3> neighbor_local{
-                            static_cast<std::ptrdiff_t>(pos[0]),
-                            static_cast<std::ptrdiff_t>(pos[1]),
-                            static_cast<std::ptrdiff_t>(pos[2])
-                        };
-                        neighbor_local[axis] += sign;
-                        neighbor_solid = neighbor_opaque(neighbor_local);
-                    }
+    void submit(job work);
 
-                    if (!neighbor_solid) {
-                        mask[idx] = mask_cell{true, current};
-                    }
-                }
-            }
+    // Blocks until every submitted job has finished. Must not be called from a worker thread.
+    void wait_idle();
 
-            for (std::size_t v = 0; v < dv; ++v) {
-                for (std::size_t u = 0; u < du; ++u) {
-                    const std::size_t idx = u + v * du;
-                    auto& cell = mask[idx];
-                    if (!cell.filled) {
-                        continue;
-                    }
+private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<job> jobs;
+    };
 
-                    std::size_t width = 1;
-                    while (u + width < du) {
-                        const auto& next = mask[idx + width];
-                        if (!next.filled || next.id != cell.id) {
-                            break;
-                        }
-                        ++width;
-                    }
+    void run(std::size_t index);
+    [[nodiscard]] bool try_pop(std::size_t index, job& out);
+
+    std::vector<std::unique_ptr<worker_queue>> queues_{};
+    std::vector<std::thread> threads_{};
+    std::mutex state_mutex_{};
+    std::condition_variable wake_{};
+    std::condition_variable idle_{};
+    std::size_t queued_{0};
+    std::size_t running_{0};
+    std::size_t next_queue_{0};
+    bool stopping_{false};
+};
 
-                    std::size_t height = 1;
-                    bool stop = false;
-                    while (v + height < dv && !stop) {
-                        for (std::size_t x = 0; x < width; ++x) {
-                            const auto& next = mask[idx + x + height * du];
-                            if (!next.filled || next.id != cell.id) {
-                                stop = true;
-                                break;
-                            }
-                        }
-                        if (!stop) {
-                            ++height;
-                        }
-                    }
+inline task_pool::task_pool(std::size_t worker_count) {
+    worker_count = std::max<std::size_t>(1, worker_count);
+    queues_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        queues_.push_back(std::make_unique<worker_queue>());
+    }
+    threads_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        threads_.emplace_back([this, i] { run(i); });
+    }
+}
 
-                    float axis_coord = static_cast<float>(plane + (sign > 0 ? 1 : 0));
-                    if (axis == 2) {
-                        axis_coord += sign > 0 ? vertical_face_bias : -vertical_face_bias;
-                    }
-                    std::array<float, 3> base{0.0f, 0.0f, 0.0f};
-                    base[axis] = axis_coord;
-                    base[u_axis] = static_cast<float>(u);
-                    base[v_axis] = static_cast<float>(v);
-
-                    std::array<float, 3> du_vec{0.0f, 0.0f, 0.0f};
-                    du_vec[u_axis] = static_cast<float>(width);
-                    std::array<float, 3> dv_vec{0.0f, 0.0f, 0.0f};
-                    dv_vec[v_axis] = static_cast<float>(height);
-
-                    std::array<std::array<float, 3>, 4> corners{
-                        base,
-                        std::array<float, 3>{base[0] + du_vec[0], base[1] + du_vec[1], base[2] + du_vec[2]},
-                        std::array<float, 3>{base[0] + du_vec[0] + dv_vec[0], base[1] + du_vec[1] + dv_vec[1], base[2] + du_vec[2] + dv_vec[2]},
-                        std::array<float, 3>{base[0] + dv_vec[0], base[1] + dv_vec[1], base[2] + dv_vec[2]}
-                    };
+inline task_pool::~task_pool() {
+    {
+        std::scoped_lock lock{state_mutex_};
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
 
-                    std::array<std::array<float, 2>, 4> uv{
-                        std::array<float, 2>{0.0f, 0.0f},
-                        std::array<float, 2>{static_cast<float>(width), 0.0f},
-                        std::array<float, 2>{static_cast<float>(width), static_cast<float>(height)},
-                        std::array<float, 2>{0.0f, static_cast<float>(height)}
-                    };
+inline void task_pool::submit(job work) {
+    std::size_t target = 0;
+    if (on_worker_thread()) {
+        target = detail::current_worker;
+    } else {
+        std::scoped_lock lock{state_mutex_};
+        target = next_queue_++ % queues_.size();
+    }
+    {
+        auto& queue = *queues_[target];
+        std::scoped_lock lock{queue.mutex};
+        queue.jobs.push_back(std::move(work));
+    }
+    {
+        std::scoped_lock lock{state_mutex_};
+        ++queued_;
+    }
+    wake_.notify_one();
+}
 
-                    const auto normal_i = face_normal(face);
-                    const std::array<float, 3> normal{static_cast<float>(normal_i[0]), static_cast<float>(normal_i[1]), static_cast<float>(normal_i[2])};
+inline void task_pool::wait_idle() {
+    std::unique_lock lock{state_mutex_};
+    idle_.wait(lock, [this] { return queued_ == 0 && running_ == 0; });
+}
 
-                    const auto base_index = static_cast<std::uint32_t>(result.vertices.size());
-                    for (std::size_t i = 0; i < 4; ++i) {
-                        result.vertices.push_back(vertex{corners[i], normal, uv[i], cell.id});
-                    }
+inline void task_pool::run(std::size_t index) {
+    detail::current_pool = this;
+    detail::current_worker = index;
+    for (;;) {
+        {
+            std::unique_lock lock{state_mutex_};
+            wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+            if (queued_ == 0) {
+                return;
+            }
+            // Reserve one queued job; it is already visible in some deque because submit pushes before counting.
+            --queued_;
+            ++running_;
+        }
 
-                    if (sign > 0) {
-                        result.indices.insert(result.indices.end(), {base_index, base_index + 1, base_index + 2, base_index, base_index + 2, base_index + 3});
-                    } else {
-                        result.indices.insert(result.indices.end(), {base_index, base_index + 2, base_index + 1, base_index, base_index + 3, base_index + 2});
-                    }
+        job work;
+        while (!try_pop(index, work)) {
+            std::this_thread::yield();
+        }
+        work();
+        // Release captured state before reporting idle so waiters observe fully finished jobs.
+        work = nullptr;
 
-                    for (std::size_t dy = 0; dy < height; ++dy) {
-                        for (std::size_t dx = 0; dx < width; ++dx) {
-                            mask[u + dx + (v + dy) * du].filled = false;
-                        }
-                    }
-                }
+        {
+            std::scoped_lock lock{state_mutex_};
+            --running_;
+            if (queued_ == 0 && running_ == 0) {
+                idle_.notify_all();
             }
         }
     }
-
-    return result;
 }
 
-template <typename IsOpaque>
-[[nodiscard]] mesh_result greedy_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
-    IsOpaque&& is_opaque) {
-    const auto neighbor_views = detail::load_neighbor_views(neighbors);
-    auto neighbor_sampler = [&, dims = chunk.extent()](const std::array<std::ptrdiff_t, 3>& coord) {
-        std::array<std::ptrdiff_t, 3> local = coord;
-        const detail::neighbor_view* view = nullptr;
-        if (!detail::remap_to_neighbor_coords(dims, local, neighbor_views, view)) {
-            return false;
+inline bool task_pool::try_pop(std::size_t index, job& out) {
+    {
+        auto& own = *queues_[index];
+        std::scoped_lock lock{own.mutex};
+        if (!own.jobs.empty()) {
+            out = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+    for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+        auto& victim = *queues_[(index + offset) % queues_.size()];
+        std::scoped_lock lock{victim.mutex};
+        if (!victim.jobs.empty()) {
+            out = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
         }
+    }
+    return false;
+}
 
-        return is_opaque(view->voxels(static_cast<std::size_t>(local[0]), static_cast<std::size_t>(local[1]),
-            static_cast<std::size_t>(local[2])));
-    };
+} // namespace almond::voxel::parallel
+// end: almond_voxel/parallel/task_pool.hpp
 
-    return greedy_mesh_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), neighbor_sampler);
-}
+// begin: almond_voxel/world.hpp
 
-inline mesh_result greedy_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors) {
-    return greedy_mesh_with_neighbor_chunks(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
-}
 
-template <typename IsOpaque>
-[[nodiscard]] mesh_result greedy_mesh(const chunk_storage& chunk, IsOpaque&& is_opaque) {
-    auto neighbor = [](const std::array<std::ptrdiff_t, 3>&) { return false; };
-    return greedy_mesh_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), neighbor);
-}
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
-inline mesh_result greedy_mesh(const chunk_storage& chunk) {
-    return greedy_mesh(chunk, [](voxel_id id) { return id != voxel_id{}; });
-}
+namespace almond::voxel {
 
-} // namespace almond::voxel::meshing
-// end: almond_voxel/meshing/greedy_mesher.hpp
+enum class load_status : std::uint8_t {
+    queued,
+    loading,
+    ready,
+    cancelled,
+    failed
+};
 
-// begin: almond_voxel/meshing/marching_cubes_tables.hpp
+class load_handle;
 
-#include <array>
-#include <cstdint>
+// Where a region's data currently lives: dense in memory, compressed in memory, or only in the saver's backing store.
+enum class residency_tier : std::uint8_t {
+    hot,
+    warm,
+    cold
+};
 
-namespace almond::voxel::meshing::detail {
+// Automatic in-memory compression for resident regions. Idle compression picks unpinned regions that no assure(),
+// request() or task has touched for `idle_ticks` ticks; pressure compression compresses the least recently used
+// regions before any are evicted for exceeding the memory budget. With workers the codecs run on the pool.
+struct compression_policy {
+    std::uint64_t idle_ticks{0};
+    bool compress_under_pressure{false};
+    std::size_t max_per_tick{8};
+    chunk_codec_config codecs{};
+};
 
-    inline constexpr std::array<int, 256> mc_edge_table{
-        0x000, 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
-        0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
-        0x190, 0x099, 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
-        0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
-        0x230, 0x339, 0x033, 0x13a, 0x636, 0x73f, 0x435, 0x53c,
-        0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
-        0x3a0, 0x2a9, 0x1a3, 0x0aa, 0x7a6, 0x6af, 0x5a5, 0x4ac,
-        0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
-        0x460, 0x569, 0x663, 0x76a, 0x066, 0x16f, 0x265, 0x36c,
-        0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
-        0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0x0ff, 0x3f5, 0x2fc,
-        0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
-        0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x055, 0x15c,
-        0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
-        0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0x0cc,
-        0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
-        0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
-        0x0cc, 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
-        0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
-        0x15c, 0x055, 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
-        0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
-        0x2fc, 0x3f5, 0x0ff, 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
-        0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
-        0x36c, 0x265, 0x16f, 0x066, 0x76a, 0x663, 0x569, 0x460,
-        0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
-        0x4ac, 0x5a5, 0x6af, 0x7a6, 0x0aa, 0x1a3, 0x2a9, 0x3a0,
-        0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
-        0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x033, 0x339, 0x230,
-        0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
-        0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x099, 0x190,
-        0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
-        0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x000
+namespace detail {
+
+struct load_request {
+    region_key key{};
+    std::atomic<load_status> status{load_status::queued};
+    int priority{0};
+    std::uint64_t sequence{0};
+    std::shared_ptr<chunk_storage> chunk{};
+    std::exception_ptr error{};
+    std::vector<std::function<void(const load_handle&)>> callbacks{};
+};
+
+} // namespace detail
+
+// Shared view of an asynchronous chunk request. Every requester of the same key observes the same handle state.
+class load_handle {
+public:
+    load_handle() = default;
+
+    [[nodiscard]] bool valid() const noexcept { return request_ != nullptr; }
+    [[nodiscard]] region_key key() const noexcept { return request_ ? request_->key : region_key{}; }
+    [[nodiscard]] load_status status() const noexcept {
+        return request_ ? request_->status.load(std::memory_order_acquire) : load_status::cancelled;
+    }
+    [[nodiscard]] bool ready() const noexcept { return status() == load_status::ready; }
+    // Resident chunk once ready, otherwise null.
+    [[nodiscard]] std::shared_ptr<chunk_storage> chunk() const noexcept { return ready() ? request_->chunk : nullptr; }
+    [[nodiscard]] std::exception_ptr error() const noexcept {
+        return status() == load_status::failed ? request_->error : nullptr;
+    }
+
+private:
+    friend class region_manager;
+    explicit load_handle(std::shared_ptr<detail::load_request> request) : request_{std::move(request)} {}
+
+    std::shared_ptr<detail::load_request> request_{};
+};
+
+// Threading model: one owner thread calls the mutating members (assure, request, tick, eviction, pins, policies).
+// Any thread may call find(), tier(), navigation_grid(), for_each_loaded() and snapshot_loaded() concurrently with
+// it, then read the returned chunk under chunk_storage::lock_shared(). Tasks and background compression hold the
+// chunk's exclusive guard, so readers see either the state before or after each task, never a torn one.
+// A task must not lock or replace() its own chunk, nor call snapshot_loaded(); it already owns the guard.
+class region_manager {
+public:
+    using chunk_ptr = std::shared_ptr<chunk_storage>;
+    using nav_grid_ptr = std::shared_ptr<navigation::nav_grid>;
+    using loader_type = std::function<chunk_storage(const region_key&)>;
+    using saver_type = std::function<void(const region_key&, const chunk_storage&)>;
+    using task_type = std::function<void(chunk_storage&, const region_key&)>;
+    using dirty_observer = std::function<void(const region_key&)>;
+    using dirty_region_observer = std::function<void(const region_key&, const dirty_event&)>;
+    using load_callback = std::function<void(const load_handle&)>;
+
+    explicit region_manager(chunk_extent chunk_dimensions = cubic_extent(32));
+
+    [[nodiscard]] chunk_extent chunk_dimensions() const noexcept { return chunk_extent_; }
+
+    // Loads synchronously on a miss; never waits for or consumes an outstanding request().
+    chunk_storage& assure(const region_key& key);
+    // Queues a background load (deduplicated per key; repeated requests keep the highest priority). Higher priorities
+    // load first. `on_ready` runs on the tick thread once the chunk is resident or the load failed; it never runs for
+    // cancelled requests. Already-resident keys return a ready handle.
+    load_handle request(const region_key& key, int priority = 0, load_callback on_ready = {});
+    // Drops an outstanding request; an in-flight load finishes but its chunk is discarded.
+    bool cancel(const region_key& key);
+    [[nodiscard]] std::size_t pending_loads() const;
+    // Maximum loads in flight on the worker pool, or loads performed per tick() without workers.
+    void set_load_concurrency(std::size_t count);
+    [[nodiscard]] std::size_t load_concurrency() const noexcept { return load_concurrency_; }
+    // Replaces the resident chunk (or inserts one) while keeping dirty tracking attached.
+    chunk_storage& replace(const region_key& key, chunk_storage chunk);
+    [[nodiscard]] chunk_ptr find(const region_key& key) const;
+
+    // In worker mode the loader also runs on worker threads for request() and must be thread-safe.
+    void set_loader(loader_type loader) { loader_ = std::move(loader); }
+    void set_saver(saver_type saver) { saver_ = std::move(saver); }
+
+    // Pinned regions count towards the limit but are never evicted.
+    void set_max_resident(std::size_t limit) noexcept;
+    [[nodiscard]] std::size_t max_resident() const noexcept { return max_resident_; }
+    [[nodiscard]] std::size_t resident() const noexcept { return regions_.size(); }
+    [[nodiscard]] std::size_t pinned_count() const noexcept { return pinned_count_; }
+
+    // Byte budget across resident chunks (0 disables it). Eviction continues until both limits hold.
+    void set_memory_budget(std::size_t bytes);
+    [[nodiscard]] std::size_t memory_budget() const noexcept { return memory_budget_; }
+    [[nodiscard]] std::size_t resident_bytes() const noexcept { return resident_usage_.total(); }
+    // Per-plane totals for telemetry. Regions touched or edited since the last refresh are re-measured on every tick()
+    // and eviction pass; regions with a task in flight are measured once it finishes.
+    [[nodiscard]] const chunk_memory_usage& memory_usage() const noexcept { return resident_usage_; }
+    void refresh_memory_usage();
+
+    // Compressed regions decode transparently on their next access. assure()/find() wait for an in-flight background
+    // compression of that region; references obtained earlier must not be used while tick() may compress the region.
+    void set_compression_policy(const compression_policy& policy);
+    [[nodiscard]] const compression_policy& compression() const noexcept { return compression_policy_; }
+    [[nodiscard]] residency_tier tier(const region_key& key) const;
+
+    // Pinned regions leave the LRU list entirely; pin/unpin/touch/evict are O(1).
+    void pin(const region_key& key);
+    void unpin(const region_key& key);
+
+    // Thread-safe; tasks may enqueue follow-up work from inside a worker.
+    void enqueue_task(const region_key& key, task_type task);
+    // Starts at most `budget` queued tasks and returns how many were started. In worker mode the tasks run on the pool
+    // and their completions are applied by a later tick() or wait_idle().
+    std::size_t tick(std::size_t budget = std::numeric_limits<std::size_t>::max());
+    [[nodiscard]] std::size_t pending_tasks() const;
+
+    // Worker mode: 0 runs tasks inline on the tick thread. With workers, tasks on different regions run concurrently,
+    // tasks on the same region never overlap and keep their enqueue order, and a region stays resident while busy.
+    void set_worker_count(std::size_t count);
+    [[nodiscard]] std::size_t worker_count() const noexcept { return pool_ ? pool_->worker_count() : 0; }
+    // Queues `callback` to run on the tick thread when completions are next drained.
+    void post_completion(std::function<void()> callback);
+    // Blocks until every started task has finished, then applies their completions.
+    void wait_idle();
+
+    // Observers fire when any plane in `planes` is written; navigation rebuilds only follow voxel edits. Writes made
+    // by worker tasks are reported on the tick thread.
+    void add_dirty_observer(dirty_observer observer, chunk_plane planes = chunk_plane::all);
+    void add_dirty_region_observer(dirty_region_observer observer, chunk_plane planes = chunk_plane::all);
+
+    void enable_navigation(bool enable = true);
+    void set_navigation_build_config(navigation::nav_build_config config);
+    [[nodiscard]] std::shared_ptr<const navigation::nav_grid> navigation_grid(const region_key& key) const;
+    void request_navigation_rebuild(const region_key& key);
+    [[nodiscard]] navigation::stitched_nav_graph stitch_navigation(const region_key& origin,
+        std::span<const region_key> neighbors) const;
+
+    void for_each_loaded(const std::function<void(const region_key&, const chunk_storage&)>& visitor) const;
+
+    struct region_snapshot {
+        region_key key{};
+        std::shared_ptr<const chunk_storage> chunk;
+        chunk_plane dirty_planes{chunk_plane::none};
     };
 
-    inline constexpr std::array<std::array<int, 32>, 256> mc_triangle_table
+    // Copy-on-write snapshots of the resident chunks, safe to save or mesh on another thread while editing goes on.
+    [[nodiscard]] std::vector<region_snapshot> snapshot_loaded(bool include_clean = false) const;
+
+    bool unload(const region_key& key);
+    void evict_until_within_limit();
+
+private:
+    using lru_list = std::list<region_key>;
+
+    struct entry {
+        chunk_ptr chunk;
+        bool pinned{false};
+        // Position in lru_ while unpinned.
+        lru_list::iterator lru{};
+        chunk_memory_usage usage{};
+        bool usage_stale{false};
+        std::uint64_t last_access{0};
+        // Set once a compression was attempted; cleared on the next touch so incompressible chunks are not retried.
+        bool compression_tried{false};
+    };
+
+    struct nav_cache_entry {
+        nav_grid_ptr grid;
+        bool dirty{true};
+        bool rebuild_pending{false};
+        std::size_t revision{0};
+        voxel_bounds pending{};
+    };
+
+    chunk_ptr load_chunk(const region_key& key) const;
+    chunk_storage& insert_loaded(const region_key& key, chunk_ptr chunk);
+    void pump_loads();
+    void run_loads_inline();
+    void finish_load(const std::shared_ptr<detail::load_request>& request, chunk_ptr chunk, std::exception_ptr error);
+    void attach_dirty_listener(const region_key& key, chunk_storage& chunk);
+    void notify_dirty(const region_key& key, const dirty_event& event);
+    entry& emplace_entry(const region_key& key, chunk_ptr chunk);
+    void erase_entry(std::unordered_map<region_key, entry, region_key_hash>::iterator it);
+    void touch(const region_key& key);
+    void touch(const region_key& key, entry& resident);
+    void mark_usage_stale(const region_key& key, entry& resident);
+    void measure(entry& resident);
+    void lru_append(const region_key& key, entry& resident);
+    void lru_remove(entry& resident);
+    void compress_idle();
+    [[nodiscard]] bool compress_under_pressure();
+    void start_compression(const region_key& key, entry& resident);
+    void wait_for_compression(const region_key& key) const;
+    void wait_for_compressions() const;
+    [[nodiscard]] bool over_limit() const noexcept;
+    std::size_t dispatch_tasks(std::size_t budget);
+    void drain_completions();
+    void mark_nav_dirty(const region_key& key);
+    void mark_nav_dirty(const region_key& key, const voxel_bounds& bounds);
+    void schedule_nav_rebuild(const region_key& key);
+    void rebuild_navigation(const region_key& key, const chunk_storage& chunk);
+    void clear_nav_cache(const region_key& key);
+
+    chunk_extent chunk_extent_{};
+    std::unordered_map<region_key, entry, region_key_hash> regions_{};
+    // Held exclusively by the owner thread while inserting or erasing regions and shared by concurrent lookups.
+    mutable std::shared_mutex regions_mutex_{};
+    lru_list lru_{};
+    // First LRU entry not yet considered for idle compression; touched entries move behind it again.
+    lru_list::iterator compress_cursor_{lru_.end()};
+    std::size_t pinned_count_{0};
+    std::size_t max_resident_{128};
+    std::size_t memory_budget_{0};
+    chunk_memory_usage resident_usage_{};
+    std::vector<region_key> stale_usage_{};
+    loader_type loader_{};
+    saver_type saver_{};
+    mutable std::mutex queue_mutex_{};
+    std::deque<std::pair<region_key, task_type>> task_queue_{};
+    std::unordered_set<region_key, region_key_hash> active_regions_{};
+    std::unordered_set<region_key, region_key_hash> compressing_{};
+    std::atomic<std::size_t> compressions_in_flight_{0};
+    mutable std::condition_variable compression_done_{};
+    compression_policy compression_policy_{};
+    std::uint64_t tick_count_{0};
+    std::mutex completion_mutex_{};
+    std::vector<region_key> finished_regions_{};
+    std::vector<std::function<void()>> completions_{};
+    std::exception_ptr task_error_{};
+    mutable std::mutex load_mutex_{};
+    std::unordered_map<region_key, std::shared_ptr<detail::load_request>, region_key_hash> loads_{};
+    // Ordered by descending priority, then request order.
+    std::map<std::pair<std::int64_t, std::uint64_t>, std::shared_ptr<detail::load_request>> load_queue_{};
+    std::size_t loads_in_flight_{0};
+    std::size_t load_concurrency_{2};
+    std::uint64_t load_sequence_{0};
+    std::vector<std::pair<dirty_region_observer, chunk_plane>> dirty_observers_{};
+    mutable std::mutex nav_mutex_{};
+    navigation::nav_build_config nav_config_{};
+    bool navigation_enabled_{false};
+    std::unordered_map<region_key, nav_cache_entry, region_key_hash> nav_cache_{};
+    // Declared last so workers are joined before the state they touch is destroyed.
+    std::unique_ptr<parallel::task_pool> pool_{};
+};
+
+inline region_manager::region_manager(chunk_extent chunk_dimensions)
+    : chunk_extent_{chunk_dimensions} {
+}
+
+inline chunk_storage& region_manager::assure(const region_key& key) {
+    wait_for_compression(key);
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        touch(key, it->second);
+        return *it->second.chunk;
+    }
+    return insert_loaded(key, load_chunk(key));
+}
+
+inline load_handle region_manager::request(const region_key& key, int priority, load_callback on_ready) {
+    wait_for_compression(key);
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        touch(key, it->second);
+        auto resident = std::make_shared<detail::load_request>();
+        resident->key = key;
+        resident->chunk = it->second.chunk;
+        resident->status.store(load_status::ready, std::memory_order_release);
+        load_handle handle{std::move(resident)};
+        if (on_ready) {
+            post_completion([callback = std::move(on_ready), handle] { callback(handle); });
+        }
+        return handle;
+    }
+
+    std::shared_ptr<detail::load_request> pending;
     {
-        {
-            {{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1}},
-            {{3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1}},
-            {{3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1}},
-            {{3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1}},
-            {{2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1}},
-            {{8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1}},
-            {{4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1}},
-            {{3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1}},
-            {{4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1}},
-            {{4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1}},
-            {{5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1}},
-            {{2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1}},
-            {{9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1}},
-            {{2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1}},
-            {{10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1}},
-            {{4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1}},
-            {{5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1}},
-            {{5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1}},
-            {{10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1}},
-            {{8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1}},
-            {{2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1}},
-            {{7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1}},
-            {{2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1}},
-            {{11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1}},
-            {{5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1}},
-            {{11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1}},
-            {{11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1}},
-            {{9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1}},
-            {{5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1}},
-            {{2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1}},
-            {{5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1}},
-            {{6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1}},
-            {{3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1}},
-            {{6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1}},
-            {{5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1}},
-            {{10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1}},
-            {{6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1}},
-            {{8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1}},
-            {{7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1}},
-            {{3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1}},
-            {{5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1}},
-            {{0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1}},
-            {{9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1}},
-            {{8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1}},
-            {{5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1}},
-            {{0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1}},
-            {{6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1}},
-            {{10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1}},
-            {{10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1}},
-            {{8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1}},
-            {{1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1}},
-            {{3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1}},
-            {{0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1}},
-            {{10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1}},
-            {{3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1}},
-            {{6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1}},
-            {{9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1}},
-            {{8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1}},
-            {{3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1}},
-            {{6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1}},
-            {{10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1}},
-            {{10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1}},
-            {{1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1}},
-            {{2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1}},
-            {{7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1}},
-            {{7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1}},
-            {{2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1}},
-            {{1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1}},
-            {{11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1}},
-            {{8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1}},
-            {{0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1}},
-            {{7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
-            {{8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1}},
+        std::scoped_lock lock{load_mutex_};
+        auto& slot = loads_[key];
+        if (!slot) {
+            slot = std::make_shared<detail::load_request>();
+            slot->key = key;
+            slot->priority = priority;
+            slot->sequence = load_sequence_++;
+            load_queue_.emplace(std::pair{-std::int64_t{priority}, slot->sequence}, slot);
+        } else if (priority > slot->priority && slot->status.load() == load_status::queued) {
+            load_queue_.erase(std::pair{-std::int64_t{slot->priority}, slot->sequence});
+            slot->priority = priority;
+            load_queue_.emplace(std::pair{-std::int64_t{priority}, slot->sequence}, slot);
+        }
+        if (on_ready) {
+            slot->callbacks.push_back(std::move(on_ready));
+        }
+        pending = slot;
+    }
+    if (pool_) {
+        pump_loads();
+    }
+    return load_handle{std::move(pending)};
+}
+
+inline bool region_manager::cancel(const region_key& key) {
+    std::scoped_lock lock{load_mutex_};
+    auto it = loads_.find(key);
+    if (it == loads_.end()) {
+        return false;
+    }
+    auto pending = std::move(it->second);
+    loads_.erase(it);
+    if (pending->status.load() == load_status::queued) {
+        load_queue_.erase(std::pair{-std::int64_t{pending->priority}, pending->sequence});
+    }
+    pending->callbacks.clear();
+    pending->status.store(load_status::cancelled, std::memory_order_release);
+    return true;
+}
+
+inline std::size_t region_manager::pending_loads() const {
+    std::scoped_lock lock{load_mutex_};
+    return loads_.size();
+}
+
+inline void region_manager::set_load_concurrency(std::size_t count) {
+    {
+        std::scoped_lock lock{load_mutex_};
+        load_concurrency_ = std::max<std::size_t>(1, count);
+    }
+    if (pool_) {
+        pump_loads();
+    }
+}
+
+inline chunk_storage& region_manager::replace(const region_key& key, chunk_storage chunk) {
+    wait_for_compression(key);
+    entry* resident = nullptr;
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        resident = &it->second;
+        auto guard = resident->chunk->lock_exclusive();
+        *resident->chunk = std::move(chunk);
+        mark_usage_stale(key, *resident);
+    } else {
+        resident = &emplace_entry(key, std::make_shared<chunk_storage>(std::move(chunk)));
+    }
+    auto& target = *resident->chunk;
+    attach_dirty_listener(key, target);
+    touch(key, *resident);
+    if (navigation_enabled_) {
+        mark_nav_dirty(key);
+    }
+    return target;
+}
+
+inline region_manager::chunk_ptr region_manager::find(const region_key& key) const {
+    wait_for_compression(key);
+    std::shared_lock lock{regions_mutex_};
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        return it->second.chunk;
+    }
+    return {};
+}
+
+inline void region_manager::set_max_resident(std::size_t limit) noexcept {
+    max_resident_ = limit;
+    evict_until_within_limit();
+}
+
+inline void region_manager::set_memory_budget(std::size_t bytes) {
+    memory_budget_ = bytes;
+    evict_until_within_limit();
+}
+
+inline void region_manager::refresh_memory_usage() {
+    std::vector<region_key> stale;
+    stale.swap(stale_usage_);
+    for (const auto& key : stale) {
+        auto it = regions_.find(key);
+        if (it == regions_.end() || !it->second.usage_stale) {
+            continue;
+        }
+        if (active_regions_.contains(key)) {
+            // A worker may be resizing planes right now; measure after it finishes.
+            stale_usage_.push_back(key);
+            continue;
+        }
+        measure(it->second);
+    }
+}
+
+inline void region_manager::measure(entry& resident) {
+    resident_usage_ -= resident.usage;
+    resident.usage = resident.chunk->memory_usage();
+    resident_usage_ += resident.usage;
+    resident.usage_stale = false;
+}
+
+inline void region_manager::set_compression_policy(const compression_policy& policy) {
+    compression_policy_ = policy;
+    // Reconsider every unpinned region under the new thresholds.
+    compress_cursor_ = lru_.begin();
+}
+
+inline residency_tier region_manager::tier(const region_key& key) const {
+    wait_for_compression(key);
+    std::shared_lock lock{regions_mutex_};
+    auto it = regions_.find(key);
+    if (it == regions_.end()) {
+        return residency_tier::cold;
+    }
+    return it->second.chunk->compressed() ? residency_tier::warm : residency_tier::hot;
+}
+
+inline bool region_manager::over_limit() const noexcept {
+    return regions_.size() > max_resident_ || (memory_budget_ != 0 && resident_usage_.total() > memory_budget_);
+}
+
+inline void region_manager::pin(const region_key& key) {
+    auto it = regions_.find(key);
+    if (it == regions_.end() || it->second.pinned) {
+        return;
+    }
+    lru_remove(it->second);
+    it->second.pinned = true;
+    ++pinned_count_;
+}
+
+inline void region_manager::unpin(const region_key& key) {
+    auto it = regions_.find(key);
+    if (it == regions_.end() || !it->second.pinned) {
+        return;
+    }
+    it->second.pinned = false;
+    lru_append(key, it->second);
+    --pinned_count_;
+}
+
+inline void region_manager::enqueue_task(const region_key& key, task_type task) {
+    std::scoped_lock lock{queue_mutex_};
+    task_queue_.emplace_back(key, std::move(task));
+}
+
+inline std::size_t region_manager::tick(std::size_t budget) {
+    ++tick_count_;
+    std::size_t processed = 0;
+    if (pool_) {
+        pump_loads();
+        processed = dispatch_tasks(budget);
+    } else {
+        run_loads_inline();
+        while (processed < budget) {
+            std::pair<region_key, task_type> next;
+            {
+                std::scoped_lock lock{queue_mutex_};
+                if (task_queue_.empty()) {
+                    break;
+                }
+                next = std::move(task_queue_.front());
+                task_queue_.pop_front();
+            }
+            auto& chunk = assure(next.first);
+            if (next.second) {
+                auto guard = chunk.lock_exclusive();
+                next.second(chunk, next.first);
+            }
+            ++processed;
+        }
+    }
+    drain_completions();
+    compress_idle();
+    evict_until_within_limit();
+    return processed;
+}
+
+inline std::size_t region_manager::pending_tasks() const {
+    std::scoped_lock lock{queue_mutex_};
+    return task_queue_.size() + active_regions_.size();
+}
+
+inline void region_manager::set_worker_count(std::size_t count) {
+    if (pool_) {
+        pool_->wait_idle();
+        pool_.reset();
+    }
+    if (count > 0) {
+        pool_ = std::make_unique<parallel::task_pool>(count);
+    }
+    drain_completions();
+}
+
+inline void region_manager::post_completion(std::function<void()> callback) {
+    if (!callback) {
+        return;
+    }
+    std::scoped_lock lock{completion_mutex_};
+    completions_.push_back(std::move(callback));
+}
+
+inline void region_manager::wait_idle() {
+    if (pool_) {
+        pool_->wait_idle();
+    }
+    drain_completions();
+}
+
+inline std::size_t region_manager::dispatch_tasks(std::size_t budget) {
+    // Free regions whose tasks finished since the last tick so their queued successors can start now.
+    drain_completions();
+
+    std::vector<std::pair<region_key, task_type>> batch;
+    {
+        std::scoped_lock lock{queue_mutex_, load_mutex_};
+        for (auto it = task_queue_.begin(); it != task_queue_.end() && batch.size() < budget;) {
+            // Tasks on a region with an outstanding request wait for it to land instead of loading synchronously.
+            if (active_regions_.contains(it->first) || loads_.contains(it->first)) {
+                ++it;
+                continue;
+            }
+            active_regions_.insert(it->first);
+            batch.push_back(std::move(*it));
+            it = task_queue_.erase(it);
+        }
+    }
+
+    for (std::size_t index = 0; index < batch.size(); ++index) {
+        auto& [key, task] = batch[index];
+        std::shared_ptr<chunk_storage> chunk;
+        try {
+            assure(key);
+            chunk = regions_.at(key).chunk;
+        } catch (...) {
+            // As on the inline path, the task whose region failed to load is dropped and the error leaves tick().
+            // The tasks behind it were never submitted: release their regions and put them back at the front of the
+            // queue, ahead of any later tasks on the same keys.
+            std::scoped_lock lock{queue_mutex_};
+            active_regions_.erase(key);
+            for (std::size_t rest = batch.size(); rest-- > index + 1;) {
+                active_regions_.erase(batch[rest].first);
+                task_queue_.push_front(std::move(batch[rest]));
+            }
+            throw;
+        }
+        pool_->submit([this, key, chunk = std::move(chunk), task = std::move(task)] {
+            try {
+                if (task) {
+                    auto guard = chunk->lock_exclusive();
+                    task(*chunk, key);
+                }
+            } catch (...) {
+                std::scoped_lock lock{completion_mutex_};
+                if (!task_error_) {
+                    task_error_ = std::current_exception();
+                }
+            }
+            std::scoped_lock lock{completion_mutex_};
+            finished_regions_.push_back(key);
+        });
+    }
+    return batch.size();
+}
+
+inline void region_manager::drain_completions() {
+    std::vector<region_key> finished;
+    std::vector<std::function<void()>> callbacks;
+    std::exception_ptr error;
+    {
+        std::scoped_lock lock{completion_mutex_};
+        finished.swap(finished_regions_);
+        callbacks.swap(completions_);
+        error = std::exchange(task_error_, nullptr);
+    }
+    if (!finished.empty()) {
+        std::scoped_lock lock{queue_mutex_};
+        for (const auto& key : finished) {
+            active_regions_.erase(key);
+        }
+    }
+    for (auto& callback : callbacks) {
+        callback();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+inline void region_manager::add_dirty_observer(dirty_observer observer, chunk_plane planes) {
+    if (!observer) {
+        return;
+    }
+    dirty_observers_.emplace_back(
+        [observer = std::move(observer)](const region_key& key, const dirty_event&) { observer(key); }, planes);
+}
+
+inline void region_manager::add_dirty_region_observer(dirty_region_observer observer, chunk_plane planes) {
+    dirty_observers_.emplace_back(std::move(observer), planes);
+}
+
+inline void region_manager::enable_navigation(bool enable) {
+    if (navigation_enabled_ == enable) {
+        return;
+    }
+    {
+        std::scoped_lock lock{nav_mutex_};
+        navigation_enabled_ = enable;
+        nav_cache_.clear();
+    }
+    if (!navigation_enabled_) {
+        return;
+    }
+    for (const auto& [key, entry] : regions_) {
+        if (entry.chunk) {
+            mark_nav_dirty(key);
+        }
+    }
+}
+
+inline void region_manager::set_navigation_build_config(navigation::nav_build_config config) {
+    {
+        std::scoped_lock lock{nav_mutex_};
+        nav_config_ = std::move(config);
+    }
+    if (!navigation_enabled_) {
+        return;
+    }
+    for (const auto& [key, entry] : regions_) {
+        if (entry.chunk) {
+            mark_nav_dirty(key);
+        }
+    }
+}
+
+inline std::shared_ptr<const navigation::nav_grid> region_manager::navigation_grid(const region_key& key) const {
+    if (!navigation_enabled_) {
+        return {};
+    }
+    std::scoped_lock lock{nav_mutex_};
+    if (auto it = nav_cache_.find(key); it != nav_cache_.end()) {
+        return it->second.grid;
+    }
+    return {};
+}
+
+inline void region_manager::request_navigation_rebuild(const region_key& key) {
+    if (!navigation_enabled_) {
+        return;
+    }
+    mark_nav_dirty(key);
+}
+
+inline navigation::stitched_nav_graph region_manager::stitch_navigation(const region_key& origin,
+    std::span<const region_key> neighbors) const {
+    navigation::stitched_nav_graph stitched;
+    if (!navigation_enabled_) {
+        return stitched;
+    }
+
+    std::scoped_lock lock{nav_mutex_};
+    const auto add_region = [&](const region_key& key) {
+        if (auto it = nav_cache_.find(key); it != nav_cache_.end()) {
+            if (it->second.grid) {
+                stitched.regions.push_back(navigation::nav_region_view{key, it->second.grid});
+            }
+        }
+    };
+
+    add_region(origin);
+    for (const auto& neighbor : neighbors) {
+        add_region(neighbor);
+    }
+
+    navigation::stitch_neighbor_regions(nav_config_.neighbor, chunk_extent_, stitched);
+    return stitched;
+}
+
+inline void region_manager::for_each_loaded(const std::function<void(const region_key&, const chunk_storage&)>& visitor) const {
+    wait_for_compressions();
+    std::shared_lock lock{regions_mutex_};
+    for (const auto& [key, entry] : regions_) {
+        if (entry.chunk) {
+            visitor(key, *entry.chunk);
+        }
+    }
+}
+
+inline std::vector<region_manager::region_snapshot> region_manager::snapshot_loaded(bool include_clean) const {
+    wait_for_compressions();
+    std::shared_lock lock{regions_mutex_};
+    std::vector<region_snapshot> snapshots;
+    snapshots.reserve(regions_.size());
+    for (const auto& [key, entry] : regions_) {
+        if (!entry.chunk) {
+            continue;
+        }
+        // Copy-on-write snapshots stay consistent while tasks keep editing the live chunks. Tasks mark planes dirty
+        // under the exclusive guard, so dirty() is read under the shared one.
+        auto guard = entry.chunk->lock_shared();
+        if (!include_clean && !entry.chunk->dirty()) {
+            continue;
+        }
+        snapshots.push_back(region_snapshot{key, entry.chunk->snapshot(), entry.chunk->dirty_planes()});
+    }
+    return snapshots;
+}
+
+inline bool region_manager::unload(const region_key& key) {
+    auto it = regions_.find(key);
+    if (it == regions_.end()) {
+        return false;
+    }
+    if (it->second.pinned || active_regions_.contains(key)) {
+        return false;
+    }
+    if (it->second.chunk && saver_ && it->second.chunk->dirty()) {
+        saver_(key, *it->second.chunk);
+    }
+    clear_nav_cache(key);
+    erase_entry(it);
+    return true;
+}
+
+inline void region_manager::evict_until_within_limit() {
+    refresh_memory_usage();
+    // While pressure compressions are still running, only the chunk-count limit may evict.
+    const bool deferred = compress_under_pressure();
+    // Regions with a task in flight keep their place; only the few busy ones are stepped over.
+    auto cursor = lru_.begin();
+    while ((deferred ? regions_.size() > max_resident_ : over_limit()) && cursor != lru_.end()) {
+        const auto key = *cursor++;
+        if (active_regions_.contains(key)) {
+            continue;
+        }
+        auto it = regions_.find(key);
+        if (it->second.chunk && saver_ && it->second.chunk->dirty()) {
+            saver_(key, *it->second.chunk);
+        }
+        clear_nav_cache(key);
+        erase_entry(it);
+    }
+}
+
+inline region_manager::chunk_ptr region_manager::load_chunk(const region_key& key) const {
+    if (loader_) {
+        return std::make_shared<chunk_storage>(loader_(key));
+    }
+    return std::make_shared<chunk_storage>(chunk_extent_);
+}
+
+inline chunk_storage& region_manager::insert_loaded(const region_key& key, chunk_ptr chunk) {
+    attach_dirty_listener(key, *chunk);
+    auto& resident = emplace_entry(key, std::move(chunk));
+    if (navigation_enabled_) {
+        mark_nav_dirty(key);
+    }
+    return *resident.chunk;
+}
+
+inline region_manager::entry& region_manager::emplace_entry(const region_key& key, chunk_ptr chunk) {
+    std::unique_lock lock{regions_mutex_};
+    auto [it, inserted] = regions_.emplace(key, entry{std::move(chunk), false});
+    lock.unlock();
+    if (inserted) {
+        it->second.last_access = tick_count_;
+        lru_append(key, it->second);
+        it->second.usage = it->second.chunk->memory_usage();
+        resident_usage_ += it->second.usage;
+    }
+    return it->second;
+}
+
+inline void region_manager::erase_entry(std::unordered_map<region_key, entry, region_key_hash>::iterator it) {
+    if (it->second.pinned) {
+        --pinned_count_;
+    } else {
+        lru_remove(it->second);
+    }
+    resident_usage_ -= it->second.usage;
+    std::unique_lock lock{regions_mutex_};
+    regions_.erase(it);
+}
+
+inline void region_manager::pump_loads() {
+    for (;;) {
+        std::shared_ptr<detail::load_request> next;
+        {
+            std::scoped_lock lock{load_mutex_};
+            if (loads_in_flight_ >= load_concurrency_ || load_queue_.empty()) {
+                return;
+            }
+            next = std::move(load_queue_.begin()->second);
+            load_queue_.erase(load_queue_.begin());
+            next->status.store(load_status::loading, std::memory_order_release);
+            ++loads_in_flight_;
+        }
+        pool_->submit([this, next = std::move(next)] {
+            chunk_ptr chunk;
+            std::exception_ptr error;
+            if (next->status.load(std::memory_order_acquire) != load_status::cancelled) {
+                try {
+                    chunk = load_chunk(next->key);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            {
+                std::scoped_lock lock{load_mutex_};
+                --loads_in_flight_;
+            }
+            post_completion([this, next, chunk = std::move(chunk), error]() mutable {
+                finish_load(next, std::move(chunk), error);
+            });
+            pump_loads();
+        });
+    }
+}
+
+inline void region_manager::run_loads_inline() {
+    std::vector<std::shared_ptr<detail::load_request>> batch;
+    {
+        std::scoped_lock lock{load_mutex_};
+        while (batch.size() < load_concurrency_ && !load_queue_.empty()) {
+            batch.push_back(std::move(load_queue_.begin()->second));
+            load_queue_.erase(load_queue_.begin());
+            batch.back()->status.store(load_status::loading, std::memory_order_release);
+        }
+    }
+    for (const auto& next : batch) {
+        chunk_ptr chunk;
+        std::exception_ptr error;
+        try {
+            chunk = load_chunk(next->key);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        finish_load(next, std::move(chunk), error);
+    }
+}
+
+inline void region_manager::finish_load(const std::shared_ptr<detail::load_request>& request, chunk_ptr chunk,
+    std::exception_ptr error) {
+    std::vector<load_callback> callbacks;
+    {
+        std::scoped_lock lock{load_mutex_};
+        if (auto it = loads_.find(request->key); it != loads_.end() && it->second == request) {
+            loads_.erase(it);
+        }
+        if (request->status.load() == load_status::cancelled) {
+            return;
+        }
+        callbacks.swap(request->callbacks);
+    }
+
+    if (error) {
+        request->error = error;
+        request->status.store(load_status::failed, std::memory_order_release);
+    } else {
+        // A synchronous assure() may have won the race; keep the resident chunk.
+        if (auto it = regions_.find(request->key); it != regions_.end()) {
+            chunk = it->second.chunk;
+        } else {
+            insert_loaded(request->key, chunk);
+        }
+        touch(request->key);
+        request->chunk = std::move(chunk);
+        request->status.store(load_status::ready, std::memory_order_release);
+    }
+
+    const load_handle handle{request};
+    for (auto& callback : callbacks) {
+        callback(handle);
+    }
+}
+
+inline void region_manager::attach_dirty_listener(const region_key& key, chunk_storage& chunk) {
+    chunk.add_plane_dirty_listener([this, key](const dirty_event& event) {
+        if (pool_ && pool_->on_worker_thread()) {
+            post_completion([this, key, event] { notify_dirty(key, event); });
+            return;
+        }
+        notify_dirty(key, event);
+    });
+}
+
+inline void region_manager::notify_dirty(const region_key& key, const dirty_event& event) {
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        mark_usage_stale(key, it->second);
+    }
+    if (contains(event.planes, chunk_plane::voxels)) {
+        mark_nav_dirty(key, event.bounds);
+    }
+    for (auto& [observer, filter] : dirty_observers_) {
+        if (observer && contains(filter, event.planes)) {
+            observer(key, event);
+        }
+    }
+}
+
+inline void region_manager::touch(const region_key& key) {
+    if (auto it = regions_.find(key); it != regions_.end()) {
+        touch(key, it->second);
+    }
+}
+
+inline void region_manager::touch(const region_key& key, entry& resident) {
+    resident.last_access = tick_count_;
+    resident.compression_tried = false;
+    if (!resident.pinned) {
+        if (compress_cursor_ == resident.lru) {
+            ++compress_cursor_;
+        }
+        lru_.splice(lru_.end(), lru_, resident.lru);
+        if (compress_cursor_ == lru_.end()) {
+            compress_cursor_ = resident.lru;
+        }
+    }
+    // Callers may write through the returned chunk, so its footprint is re-measured on the next refresh.
+    mark_usage_stale(key, resident);
+}
+
+inline void region_manager::lru_append(const region_key& key, entry& resident) {
+    resident.lru = lru_.insert(lru_.end(), key);
+    if (compress_cursor_ == lru_.end()) {
+        compress_cursor_ = resident.lru;
+    }
+}
+
+inline void region_manager::lru_remove(entry& resident) {
+    if (compress_cursor_ == resident.lru) {
+        ++compress_cursor_;
+    }
+    lru_.erase(resident.lru);
+}
+
+inline void region_manager::compress_idle() {
+    if (compression_policy_.idle_ticks == 0) {
+        return;
+    }
+    // The LRU is ordered by last access, so the scan stops at the first region that is still warm.
+    std::size_t started = 0;
+    while (compress_cursor_ != lru_.end() && started < compression_policy_.max_per_tick) {
+        const auto key = *compress_cursor_;
+        auto& resident = regions_.at(key);
+        if (tick_count_ - resident.last_access < compression_policy_.idle_ticks) {
+            break;
+        }
+        ++compress_cursor_;
+        if (resident.compression_tried || active_regions_.contains(key) || resident.chunk->compressed()) {
+            continue;
+        }
+        start_compression(key, resident);
+        ++started;
+    }
+}
+
+inline bool region_manager::compress_under_pressure() {
+    if (!compression_policy_.compress_under_pressure || memory_budget_ == 0) {
+        return false;
+    }
+    std::size_t started = 0;
+    for (auto it = lru_.begin(); it != lru_.end() && resident_usage_.total() > memory_budget_; ++it) {
+        if (pool_ && started >= compression_policy_.max_per_tick) {
+            break;
+        }
+        auto& resident = regions_.at(*it);
+        if (resident.compression_tried || active_regions_.contains(*it) || resident.chunk->compressed()) {
+            continue;
+        }
+        start_compression(*it, resident);
+        ++started;
+    }
+    return compressions_in_flight_.load(std::memory_order_acquire) != 0;
+}
+
+inline void region_manager::start_compression(const region_key& key, entry& resident) {
+    resident.compression_tried = true;
+    if (!pool_) {
+        // A reader still holding the chunk means it is not idle after all.
+        if (auto guard = resident.chunk->try_lock_exclusive(); guard.owns_lock()) {
+            resident.chunk->compress(compression_policy_.codecs);
+        }
+        measure(resident);
+        return;
+    }
+    {
+        std::scoped_lock lock{queue_mutex_};
+        active_regions_.insert(key);
+        compressing_.insert(key);
+    }
+    compressions_in_flight_.fetch_add(1, std::memory_order_acq_rel);
+    pool_->submit([this, key, chunk = resident.chunk, codecs = compression_policy_.codecs] {
+        try {
+            if (auto guard = chunk->try_lock_exclusive(); guard.owns_lock()) {
+                chunk->compress(codecs);
+            }
+        } catch (...) {
+            std::scoped_lock lock{completion_mutex_};
+            if (!task_error_) {
+                task_error_ = std::current_exception();
+            }
+        }
+        {
+            std::scoped_lock lock{completion_mutex_};
+            finished_regions_.push_back(key);
+            completions_.push_back([this, key] {
+                if (auto it = regions_.find(key); it != regions_.end()) {
+                    mark_usage_stale(key, it->second);
+                }
+            });
+        }
+        {
+            std::scoped_lock lock{queue_mutex_};
+            compressing_.erase(key);
+            compressions_in_flight_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        compression_done_.notify_all();
+    });
+}
+
+inline void region_manager::wait_for_compression(const region_key& key) const {
+    if (compressions_in_flight_.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    std::unique_lock lock{queue_mutex_};
+    compression_done_.wait(lock, [&] { return !compressing_.contains(key); });
+}
+
+inline void region_manager::wait_for_compressions() const {
+    if (compressions_in_flight_.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    std::unique_lock lock{queue_mutex_};
+    compression_done_.wait(lock, [&] { return compressing_.empty(); });
+}
+
+inline void region_manager::mark_usage_stale(const region_key& key, entry& resident) {
+    if (!resident.usage_stale) {
+        resident.usage_stale = true;
+        stale_usage_.push_back(key);
+    }
+}
+
+inline void region_manager::mark_nav_dirty(const region_key& key) {
+    mark_nav_dirty(key, voxel_bounds::full(chunk_extent_));
+}
+
+inline void region_manager::mark_nav_dirty(const region_key& key, const voxel_bounds& bounds) {
+    if (!navigation_enabled_) {
+        return;
+    }
+    {
+        std::scoped_lock lock{nav_mutex_};
+        auto& entry = nav_cache_[key];
+        entry.dirty = true;
+        entry.pending.merge(bounds);
+        if (entry.rebuild_pending) {
+            return;
+        }
+        entry.rebuild_pending = true;
+    }
+    schedule_nav_rebuild(key);
+}
+
+inline void region_manager::schedule_nav_rebuild(const region_key& key) {
+    enqueue_task(key, [this](chunk_storage& chunk, const region_key& target) { rebuild_navigation(target, chunk); });
+}
+
+inline void region_manager::rebuild_navigation(const region_key& key, const chunk_storage& chunk) {
+    // Claim the pending bounds up front so edits landing mid-build schedule a follow-up rebuild.
+    nav_grid_ptr previous;
+    voxel_bounds pending;
+    navigation::nav_build_config config;
+    {
+        std::scoped_lock lock{nav_mutex_};
+        auto it = nav_cache_.find(key);
+        if (it == nav_cache_.end()) {
+            return;
+        }
+        previous = it->second.grid;
+        pending = std::exchange(it->second.pending, voxel_bounds{});
+        it->second.rebuild_pending = false;
+        config = nav_config_;
+    }
+
+    // Small edits patch a private copy of the previous grid; readers keep their shared snapshot.
+    nav_grid_ptr grid;
+    if (previous && !pending.covers(chunk.extent())) {
+        grid = std::make_shared<navigation::nav_grid>(*previous);
+        navigation::update_nav_grid(*grid, chunk, pending, config);
+    } else {
+        grid = std::make_shared<navigation::nav_grid>(navigation::build_nav_grid(chunk, config));
+    }
+
+    std::scoped_lock lock{nav_mutex_};
+    if (auto it = nav_cache_.find(key); it != nav_cache_.end()) {
+        it->second.grid = std::move(grid);
+        it->second.dirty = it->second.rebuild_pending;
+        ++it->second.revision;
+    }
+}
+
+inline void region_manager::clear_nav_cache(const region_key& key) {
+    std::scoped_lock lock{nav_mutex_};
+    nav_cache_.erase(key);
+}
+
+} // namespace almond::voxel
+// end: almond_voxel/world.hpp
+
+// begin: almond_voxel/editing/voxel_editing.hpp
+
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+namespace almond::voxel::editing {
+
+struct world_position {
+    std::int64_t x{0};
+    std::int64_t y{0};
+    std::int64_t z{0};
+};
+
+struct chunk_coordinates {
+    region_key region{};
+    std::array<std::uint32_t, 3> local{};
+};
+
+namespace detail {
+
+inline std::pair<std::int32_t, std::uint32_t> floor_divmod(std::int64_t value, std::uint32_t divisor) {
+    const std::int64_t denom = static_cast<std::int64_t>(divisor);
+    std::int64_t quotient = value / denom;
+    std::int64_t remainder = value % denom;
+    if (remainder < 0) {
+        remainder += denom;
+        --quotient;
+    }
+    return {static_cast<std::int32_t>(quotient), static_cast<std::uint32_t>(remainder)};
+}
+
+// Re-enqueues a copy of itself while particles remain alive.
+struct decay_task {
+    region_manager* manager{nullptr};
+    effects::decay_settings decay{};
+
+    void operator()(chunk_storage& chunk, const region_key& key) const {
+        if (effects::simulate_decay(chunk, decay)) {
+            manager->enqueue_task(key, *this);
+        }
+    }
+};
+
+} // namespace detail
+
+inline chunk_coordinates split_world_position(const world_position& position, const chunk_extent& extent) {
+    auto [rx, lx] = detail::floor_divmod(position.x, extent.x);
+    auto [ry, ly] = detail::floor_divmod(position.y, extent.y);
+    auto [rz, lz] = detail::floor_divmod(position.z, extent.z);
+    chunk_coordinates coords{};
+    coords.region = region_key{rx, ry, rz};
+    coords.local = {lx, ly, lz};
+    return coords;
+}
+
+inline std::size_t linear_index(const chunk_extent& extent, const std::array<std::uint32_t, 3>& local) {
+    return static_cast<std::size_t>(local[0])
+        + static_cast<std::size_t>(extent.x) * (static_cast<std::size_t>(local[1])
+              + static_cast<std::size_t>(extent.y) * static_cast<std::size_t>(local[2]));
+}
+
+inline bool set_voxel(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local, voxel_id id) {
+    return chunk.set_voxel(local[0], local[1], local[2], id);
+}
+
+inline bool clear_voxel(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local) {
+    return set_voxel(chunk, local, voxel_id{});
+}
+
+inline bool set_effect_density(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local, float value) {
+    chunk.enable_effect_channels(effects::channel::density);
+    auto density = chunk.effect_density();
+    if (!density.contains(local[0], local[1], local[2])) {
+        return false;
+    }
+    density(local[0], local[1], local[2]) = value;
+    return true;
+}
+
+inline bool set_effect_velocity(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local,
+    const effects::velocity_sample& value) {
+    chunk.enable_effect_channels(effects::channel::velocity);
+    auto velocity = chunk.effect_velocity();
+    if (!velocity.contains(local[0], local[1], local[2])) {
+        return false;
+    }
+    velocity(local[0], local[1], local[2]) = value;
+    return true;
+}
+
+inline bool set_effect_lifetime(chunk_storage& chunk, const std::array<std::uint32_t, 3>& local, float value) {
+    chunk.enable_effect_channels(effects::channel::lifetime);
+    auto lifetime = chunk.effect_lifetime();
+    if (!lifetime.contains(local[0], local[1], local[2])) {
+        return false;
+    }
+    lifetime(local[0], local[1], local[2]) = value;
+    return true;
+}
+
+inline bool set_voxel(region_manager& regions, const world_position& position, voxel_id id) {
+    const auto coords = split_world_position(position, regions.chunk_dimensions());
+    auto& chunk = regions.assure(coords.region);
+    return set_voxel(chunk, coords.local, id);
+}
+
+inline bool clear_voxel(region_manager& regions, const world_position& position) {
+    return set_voxel(regions, position, voxel_id{});
+}
+
+inline bool toggle_voxel(region_manager& regions, const world_position& position, voxel_id on_value) {
+    const auto coords = split_world_position(position, regions.chunk_dimensions());
+    auto& chunk = regions.assure(coords.region);
+    if (!chunk.extent().contains(coords.local[0], coords.local[1], coords.local[2])) {
+        return false;
+    }
+    const voxel_id value = chunk.voxel_at(coords.local[0], coords.local[1], coords.local[2]);
+    return chunk.set_voxel(coords.local[0], coords.local[1], coords.local[2], value == voxel_id{} ? on_value : voxel_id{});
+}
+
+inline bool paint_particle_emitter(region_manager& regions, const world_position& position,
+    const effects::particle_emitter_brush& brush, effects::decay_settings decay = {}) {
+    const auto coords = split_world_position(position, regions.chunk_dimensions());
+    auto& chunk = regions.assure(coords.region);
+    chunk.enable_effect_channels(effects::channel::density | effects::channel::velocity | effects::channel::lifetime);
+    if (!effects::stamp_emitter(chunk, coords.local, brush)) {
+        return false;
+    }
+
+    regions.enqueue_task(coords.region, detail::decay_task{&regions, decay});
+    return true;
+}
+
+} // namespace almond::voxel::editing
+// end: almond_voxel/editing/voxel_editing.hpp
+
+// begin: almond_voxel/generation/noise.hpp
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace almond::voxel::generation {
+
+class value_noise {
+public:
+    explicit value_noise(std::uint64_t seed = 0, double frequency = 1.0, std::size_t octaves = 4, double persistence = 0.5) noexcept
+        : seed_{seed}
+        , frequency_{frequency}
+        , octaves_{octaves}
+        , persistence_{persistence} {
+    }
+
+    [[nodiscard]] double sample(double x, double y, double z = 0.0) const noexcept {
+        double amplitude = 1.0;
+        double frequency = frequency_;
+        double sum = 0.0;
+        double max_amplitude = 0.0;
+        for (std::size_t octave = 0; octave < octaves_; ++octave) {
+            sum += amplitude * gradient_noise(x * frequency, y * frequency, z * frequency);
+            max_amplitude += amplitude;
+            amplitude *= persistence_;
+            frequency *= 2.0;
+        }
+        if (max_amplitude == 0.0) {
+            return 0.0;
+        }
+        return sum / max_amplitude;
+    }
+
+private:
+    [[nodiscard]] double gradient_noise(double x, double y, double z) const noexcept {
+        const auto xi = static_cast<std::int64_t>(std::floor(x));
+        const auto yi = static_cast<std::int64_t>(std::floor(y));
+        const auto zi = static_cast<std::int64_t>(std::floor(z));
+        const double xf = x - static_cast<double>(xi);
+        const double yf = y - static_cast<double>(yi);
+        const double zf = z - static_cast<double>(zi);
+
+        const double u = fade(xf);
+        const double v = fade(yf);
+        const double w = fade(zf);
+
+        const double c000 = grad(hash(xi, yi, zi), xf, yf, zf);
+        const double c100 = grad(hash(xi + 1, yi, zi), xf - 1.0, yf, zf);
+        const double c010 = grad(hash(xi, yi + 1, zi), xf, yf - 1.0, zf);
+        const double c110 = grad(hash(xi + 1, yi + 1, zi), xf - 1.0, yf - 1.0, zf);
+        const double c001 = grad(hash(xi, yi, zi + 1), xf, yf, zf - 1.0);
+        const double c101 = grad(hash(xi + 1, yi, zi + 1), xf - 1.0, yf, zf - 1.0);
+        const double c011 = grad(hash(xi, yi + 1, zi + 1), xf, yf - 1.0, zf - 1.0);
+        const double c111 = grad(hash(xi + 1, yi + 1, zi + 1), xf - 1.0, yf - 1.0, zf - 1.0);
+
+        const double x00 = lerp(c000, c100, u);
+        const double x10 = lerp(c010, c110, u);
+        const double x01 = lerp(c001, c101, u);
+        const double x11 = lerp(c011, c111, u);
+
+        const double y0 = lerp(x00, x10, v);
+        const double y1 = lerp(x01, x11, v);
+
+        return lerp(y0, y1, w);
+    }
+
+    [[nodiscard]] static constexpr double fade(double t) noexcept {
+        return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+    }
+
+    [[nodiscard]] static constexpr double lerp(double a, double b, double t) noexcept {
+        return a + t * (b - a);
+    }
+
+    [[nodiscard]] double grad(std::uint64_t hash_value, double x, double y, double z) const noexcept {
+        const std::uint64_t h = hash_value & 15ull;
+        const double u = h < 8ull ? x : y;
+        const double v = h < 4ull ? y : (h == 12ull || h == 14ull ? x : z);
+        const double first = (h & 1ull) == 0ull ? u : -u;
+        const double second = (h & 2ull) == 0ull ? v : -v;
+        return first + second;
+    }
+
+    [[nodiscard]] std::uint64_t hash(std::int64_t x, std::int64_t y, std::int64_t z) const noexcept {
+        std::uint64_t h = seed_;
+        h ^= static_cast<std::uint64_t>(x) * 0x9E3779B185EBCA87ull;
+        h ^= static_cast<std::uint64_t>(y) * 0xC2B2AE3D27D4EB4Full;
+        h ^= static_cast<std::uint64_t>(z) * 0x165667B19E3779F9ull;
+        h ^= (h >> 33);
+        h *= 0xff51afd7ed558ccdull;
+        h ^= (h >> 33);
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= (h >> 33);
+        return h;
+    }
+
+    std::uint64_t seed_;
+    double frequency_;
+    std::size_t octaves_;
+    double persistence_;
+};
+
+struct palette_entry {
+    double threshold{0.0};
+    voxel_id id{0};
+};
+
+class palette_builder {
+public:
+    palette_builder& add(double threshold, voxel_id id) {
+        entries_.push_back(palette_entry{threshold, id});
+        std::sort(entries_.begin(), entries_.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.threshold < rhs.threshold;
+        });
+        return *this;
+    }
+
+    [[nodiscard]] voxel_id choose(double value) const noexcept {
+        if (entries_.empty()) {
+            return voxel_id{};
+        }
+        for (const auto& entry : entries_) {
+            if (value <= entry.threshold) {
+                return entry.id;
+            }
+        }
+        return entries_.back().id;
+    }
+
+    [[nodiscard]] const std::vector<palette_entry>& entries() const noexcept { return entries_; }
+
+private:
+    std::vector<palette_entry> entries_{};
+};
+
+[[nodiscard]] inline double remap(double value, double min, double max) noexcept {
+    if (min == max) {
+        return 0.0;
+    }
+    const double clamped = std::clamp(value, min, max);
+    return (clamped - min) / (max - min);
+}
+
+template <typename OutputIt>
+void sample_heightmap(const value_noise& noise, const chunk_extent& extent, double scale, OutputIt out) {
+    const auto dims = extent.to_array();
+    for (std::uint32_t z = 0; z < dims[2]; ++z) {
+        for (std::uint32_t x = 0; x < dims[0]; ++x) {
+            const double nx = static_cast<double>(x) / static_cast<double>(dims[0]);
+            const double nz = static_cast<double>(z) / static_cast<double>(dims[2]);
+            *out++ = noise.sample(nx * scale, nz * scale);
+        }
+    }
+}
+
+template <typename Range>
+[[nodiscard]] std::vector<voxel_id> build_palette(const Range& samples, const palette_builder& palette) {
+    std::vector<voxel_id> result;
+    result.reserve(samples.size());
+    if (samples.empty()) {
+        return result;
+    }
+    const auto [min_it, max_it] = std::minmax_element(samples.begin(), samples.end());
+    const double min_v = *min_it;
+    const double max_v = *max_it;
+    for (const auto& value : samples) {
+        result.push_back(palette.choose(remap(value, min_v, max_v)));
+    }
+    return result;
+}
+
+} // namespace almond::voxel::generation
+// end: almond_voxel/generation/noise.hpp
+
+// begin: almond_voxel/meshing/neighbors.hpp
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace almond::voxel::meshing {
+
+struct chunk_neighbors {
+    const chunk_storage* pos_x{nullptr};
+    const chunk_storage* neg_x{nullptr};
+    const chunk_storage* pos_y{nullptr};
+    const chunk_storage* neg_y{nullptr};
+    const chunk_storage* pos_z{nullptr};
+    const chunk_storage* neg_z{nullptr};
+
+    [[nodiscard]] const chunk_storage* get(block_face face) const noexcept {
+        switch (face) {
+        case block_face::pos_x:
+            return pos_x;
+        case block_face::neg_x:
+            return neg_x;
+        case block_face::pos_y:
+            return pos_y;
+        case block_face::neg_y:
+            return neg_y;
+        case block_face::pos_z:
+            return pos_z;
+        case block_face::neg_z:
+        default:
+            return neg_z;
+        }
+    }
+};
+
+// Faces whose neighboring chunk mesh can change after edits inside `dirty`: only edits on the boundary layer are
+// visible across a chunk border, so interior edits only require the owning chunk to be remeshed.
+[[nodiscard]] inline std::array<bool, block_face_count> touched_neighbor_faces(const voxel_bounds& dirty,
+    const chunk_extent& extent) noexcept {
+    std::array<bool, block_face_count> result{};
+    if (dirty.empty()) {
+        return result;
+    }
+    result[static_cast<std::size_t>(block_face::neg_x)] = dirty.min[0] == 0;
+    result[static_cast<std::size_t>(block_face::pos_x)] = dirty.max[0] >= extent.x;
+    result[static_cast<std::size_t>(block_face::neg_y)] = dirty.min[1] == 0;
+    result[static_cast<std::size_t>(block_face::pos_y)] = dirty.max[1] >= extent.y;
+    result[static_cast<std::size_t>(block_face::neg_z)] = dirty.min[2] == 0;
+    result[static_cast<std::size_t>(block_face::pos_z)] = dirty.max[2] >= extent.z;
+    return result;
+}
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/neighbors.hpp
+
+// begin: almond_voxel/meshing/apron.hpp
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+// The 26 chunks around a centre chunk, addressed by their offset in {-1, 0, 1} per axis. Slot (0, 0, 0) is unused; the
+// centre chunk is passed separately. Empty slots are missing neighbours.
+struct chunk_neighborhood {
+    std::array<const chunk_storage*, 27> chunks{};
+
+    [[nodiscard]] static constexpr std::size_t slot(int dx, int dy, int dz) noexcept {
+        return static_cast<std::size_t>((dx + 1) + 3 * ((dy + 1) + 3 * (dz + 1)));
+    }
+
+    [[nodiscard]] const chunk_storage* at(int dx, int dy, int dz) const noexcept { return chunks[slot(dx, dy, dz)]; }
+    void set(int dx, int dy, int dz, const chunk_storage* chunk) noexcept { chunks[slot(dx, dy, dz)] = chunk; }
+
+    // Face neighbours only; edge and corner slots stay missing.
+    [[nodiscard]] static chunk_neighborhood from_faces(const chunk_neighbors& neighbors) noexcept {
+        chunk_neighborhood result{};
+        result.set(1, 0, 0, neighbors.pos_x);
+        result.set(-1, 0, 0, neighbors.neg_x);
+        result.set(0, 1, 0, neighbors.pos_y);
+        result.set(0, -1, 0, neighbors.neg_y);
+        result.set(0, 0, 1, neighbors.pos_z);
+        result.set(0, 0, -1, neighbors.neg_z);
+        return result;
+    }
+};
+
+// Copy of one plane of a chunk padded by an apron taken from its neighbours, one voxel wide unless resize() asks for
+// more, so a kernel can read any voxel in [-apron, extent + apron) on every axis, edges and corners included, without
+// bounds tests or neighbour lookups. Neighbours must share the centre's extent; others count as missing. The buffer
+// keeps its capacity across resize(), so a grid reused between chunks of one size allocates once.
+template <typename T>
+class padded_grid {
+public:
+    padded_grid() = default;
+
+    void resize(chunk_extent extent, std::uint32_t apron = 1) {
+        extent_ = extent;
+        apron_ = apron;
+        stride_y_ = static_cast<std::size_t>(extent.x) + 2 * apron;
+        stride_z_ = stride_y_ * (static_cast<std::size_t>(extent.y) + 2 * apron);
+        data_.resize(stride_z_ * (static_cast<std::size_t>(extent.z) + 2 * apron));
+    }
+
+    // Extent of the centre chunk; the grid itself spans extent + 2 * apron() on each axis.
+    [[nodiscard]] chunk_extent extent() const noexcept { return extent_; }
+    [[nodiscard]] std::uint32_t apron() const noexcept { return apron_; }
+    [[nodiscard]] chunk_extent padded_extent() const noexcept {
+        return chunk_extent{extent_.x + 2 * apron_, extent_.y + 2 * apron_, extent_.z + 2 * apron_};
+    }
+
+    // Linear index of chunk-local (x, y, z); each coordinate may reach apron() voxels outside the chunk. Adding
+    // offset() to an index steps to a neighbouring voxel.
+    [[nodiscard]] std::size_t index(std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t z) const noexcept {
+        const auto a = static_cast<std::ptrdiff_t>(apron_);
+        return static_cast<std::size_t>(x + a) + stride_y_ * static_cast<std::size_t>(y + a)
+            + stride_z_ * static_cast<std::size_t>(z + a);
+    }
+    [[nodiscard]] std::ptrdiff_t offset(int dx, int dy, int dz) const noexcept {
+        return dx + static_cast<std::ptrdiff_t>(stride_y_) * dy + static_cast<std::ptrdiff_t>(stride_z_) * dz;
+    }
+
+    [[nodiscard]] const T& operator()(std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t z) const noexcept {
+        return data_[index(x, y, z)];
+    }
+    [[nodiscard]] T& operator()(std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t z) noexcept {
+        return data_[index(x, y, z)];
+    }
+    [[nodiscard]] const T& operator[](std::size_t index) const noexcept { return data_[index]; }
+
+    // The whole padded box, with chunk-local (x, y, z) at padded (x + apron, y + apron, z + apron).
+    [[nodiscard]] span3d<const T> padded() const noexcept { return make_span3d(data_.data(), padded_extent()); }
+    [[nodiscard]] span3d<T> padded() noexcept { return make_span3d(data_.data(), padded_extent()); }
+
+private:
+    std::vector<T> data_{};
+    chunk_extent extent_{0, 0, 0};
+    std::uint32_t apron_{1};
+    std::size_t stride_y_{0};
+    std::size_t stride_z_{0};
+};
+
+namespace detail {
+
+// Walks the 27 blocks of the padded box. Each block is the centre chunk, one face slab, one edge bar or one corner box
+// of a neighbour, `apron` voxels thick across the seam; `copy_block(chunk, source_min, dest_min, size)` copies it row
+// by row along x. A neighbour whose extent differs from the centre is read in its own coordinates: across the seam the
+// apron comes from its near side, along the seam cells share their coordinates, and whatever lies outside its extent
+// is filled with `missing`, as are missing neighbours. Without `include_center` only the apron shell is written and the
+// centre cells keep whatever the buffer held.
+template <typename T, typename CopyBlock>
+void fill_apron_blocks(const chunk_storage& center, const chunk_neighborhood& neighborhood, padded_grid<T>& out,
+    const T& missing, CopyBlock&& copy_block, bool include_center = true, std::uint32_t apron = 1) {
+    const auto extent = center.extent();
+    out.resize(extent, apron);
+    const auto dims = extent.to_array();
+
+    const auto fill_missing = [&](const std::array<std::ptrdiff_t, 3>& dest_min,
+        const std::array<std::uint32_t, 3>& size) {
+        for (std::uint32_t z = 0; z < size[2]; ++z) {
+            for (std::uint32_t y = 0; y < size[1]; ++y) {
+                auto* row = &out(dest_min[0], dest_min[1] + y, dest_min[2] + z);
+                std::fill(row, row + size[0], missing);
+            }
+        }
+    };
+
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (!include_center && dx == 0 && dy == 0 && dz == 0) {
+                    continue;
+                }
+                const std::array<int, 3> delta{dx, dy, dz};
+                std::array<std::ptrdiff_t, 3> dest_min{};
+                std::array<std::uint32_t, 3> size{};
+                for (std::size_t axis = 0; axis < 3; ++axis) {
+                    const auto n = dims[axis];
+                    dest_min[axis] = delta[axis] < 0 ? -static_cast<std::ptrdiff_t>(apron)
+                        : delta[axis] > 0       ? static_cast<std::ptrdiff_t>(n)
+                                                : 0;
+                    size[axis] = delta[axis] == 0 ? n : apron;
+                }
+                if (size[0] == 0 || size[1] == 0 || size[2] == 0) {
+                    continue;
+                }
+
+                const chunk_storage* chunk = dx == 0 && dy == 0 && dz == 0 ? &center : neighborhood.at(dx, dy, dz);
+                if (chunk == nullptr) {
+                    fill_missing(dest_min, size);
+                    continue;
+                }
+
+                // Clip the block to the cells the chunk actually has; the block offsets [lo, hi) per axis map to
+                // chunk coordinates start + offset.
+                const auto source_dims = chunk->extent().to_array();
+                std::array<std::uint32_t, 3> source_min{};
+                std::array<std::ptrdiff_t, 3> copy_dest{};
+                std::array<std::uint32_t, 3> copy_size{};
+                bool partial = false;
+                for (std::size_t axis = 0; axis < 3; ++axis) {
+                    const auto available = static_cast<std::ptrdiff_t>(source_dims[axis]);
+                    const std::ptrdiff_t start = delta[axis] < 0 ? available - static_cast<std::ptrdiff_t>(apron) : 0;
+                    const std::ptrdiff_t lo = std::max<std::ptrdiff_t>(0, -start);
+                    const std::ptrdiff_t hi = std::clamp<std::ptrdiff_t>(available - start, lo, size[axis]);
+                    source_min[axis] = static_cast<std::uint32_t>(start + lo);
+                    copy_dest[axis] = dest_min[axis] + lo;
+                    copy_size[axis] = static_cast<std::uint32_t>(hi - lo);
+                    partial = partial || copy_size[axis] != size[axis];
+                }
+                if (partial) {
+                    fill_missing(dest_min, size);
+                }
+                if (copy_size[0] != 0 && copy_size[1] != 0 && copy_size[2] != 0) {
+                    copy_block(*chunk, source_min, copy_dest, copy_size);
+                }
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+// Builds the padded copy of the plane returned by `plane(const chunk_storage&)` as span3d<const T>, for example
+// skylight(). Chunks for which `uniform(const chunk_storage&)` returns a value, such as uniform_skylight(), are filled
+// with it instead of materialising their plane. Interior rows are bulk copies; apron cells of missing neighbours read
+// `missing`.
+template <typename T, typename Plane, typename Uniform>
+void build_plane_apron(const chunk_storage& center, const chunk_neighborhood& neighborhood, padded_grid<T>& out,
+    Plane&& plane, Uniform&& uniform, std::type_identity_t<T> missing) {
+    detail::fill_apron_blocks(center, neighborhood, out, missing,
+        [&](const chunk_storage& chunk, const std::array<std::uint32_t, 3>& source_min,
+            const std::array<std::ptrdiff_t, 3>& dest_min, const std::array<std::uint32_t, 3>& size) {
+            const std::optional<T> uniform_value = uniform(chunk);
+            span3d<const T> source{};
+            if (!uniform_value) {
+                source = plane(chunk);
+            }
+            for (std::uint32_t z = 0; z < size[2]; ++z) {
+                for (std::uint32_t y = 0; y < size[1]; ++y) {
+                    auto* dest = &out(dest_min[0], dest_min[1] + y, dest_min[2] + z);
+                    if (uniform_value) {
+                        std::fill(dest, dest + size[0], *uniform_value);
+                        continue;
+                    }
+                    const auto* row = &source(source_min[0], source_min[1] + y, source_min[2] + z);
+                    std::copy(row, row + size[0], dest);
+                }
+            }
+        });
+}
+
+template <typename T, typename Plane>
+void build_plane_apron(const chunk_storage& center, const chunk_neighborhood& neighborhood, padded_grid<T>& out,
+    Plane&& plane, std::type_identity_t<T> missing = T{}) {
+    build_plane_apron(center, neighborhood, out, std::forward<Plane>(plane),
+        [](const chunk_storage&) { return std::optional<T>{}; }, missing);
+}
+
+namespace detail {
+
+template <typename T, typename Convert>
+void fill_voxel_blocks(const chunk_storage& center, const chunk_neighborhood& neighborhood, padded_grid<T>& out,
+    Convert& convert, const T& missing, bool include_center, std::uint32_t apron = 1) {
+    std::vector<voxel_id> row;
+    fill_apron_blocks(center, neighborhood, out, missing,
+        [&](const chunk_storage& chunk, const std::array<std::uint32_t, 3>& source_min,
+            const std::array<std::ptrdiff_t, 3>& dest_min, const std::array<std::uint32_t, 3>& size) {
+            const auto uniform = chunk.uniform_voxel();
+            const std::optional<T> uniform_value = uniform ? std::optional<T>{convert(*uniform)} : std::nullopt;
+            for (std::uint32_t z = 0; z < size[2]; ++z) {
+                for (std::uint32_t y = 0; y < size[1]; ++y) {
+                    auto* dest = &out(dest_min[0], dest_min[1] + y, dest_min[2] + z);
+                    if (uniform_value) {
+                        std::fill(dest, dest + size[0], *uniform_value);
+                        continue;
+                    }
+                    // Rows are read through the palette, so compacted chunks are never expanded to a dense plane.
+                    if constexpr (std::is_same_v<std::remove_cvref_t<Convert>, std::identity>) {
+                        chunk.copy_voxel_row(source_min[0], source_min[1] + y, source_min[2] + z,
+                            voxel_span<voxel_id>{dest, size[0]});
+                    } else {
+                        row.resize(size[0]);
+                        chunk.copy_voxel_row(source_min[0], source_min[1] + y, source_min[2] + z, row);
+                        std::transform(row.begin(), row.end(), dest, convert);
+                    }
+                }
+            }
+        },
+        include_center, apron);
+}
+
+} // namespace detail
+
+// Builds a padded grid of `convert(voxel_id)` values, such as opacity or density, in one pass over the voxel planes.
+// Uniform chunks are converted once and filled without materialising their voxels. `apron` widens the border for
+// kernels that reach further than one voxel.
+template <typename T, typename Convert>
+void build_voxel_apron(const chunk_storage& center, const chunk_neighborhood& neighborhood, padded_grid<T>& out,
+    Convert&& convert, std::type_identity_t<T> missing, std::uint32_t apron = 1) {
+    detail::fill_voxel_blocks(center, neighborhood, out, convert, missing, true, apron);
+}
+
+// Padded copy of the voxel ids; apron cells of missing neighbours read `missing` (air by default).
+inline void build_voxel_apron(const chunk_storage& center, const chunk_neighborhood& neighborhood,
+    padded_grid<voxel_id>& out, voxel_id missing = voxel_id{}) {
+    build_voxel_apron(center, neighborhood, out, std::identity{}, missing);
+}
+
+namespace detail {
+
+// Opacity of a chunk padded with its neighbours' boundary layers, read by the blocky meshers' neighbour-aware entry
+// points. Missing neighbours are transparent. Lit meshing needs the full grid for ambient occlusion; unlit meshing
+// only samples across the chunk faces, so build_opacity_shell converts just the apron and leaves the centre unset.
+template <typename IsOpaque>
+void build_opacity_apron(const chunk_storage& chunk, const chunk_neighborhood& neighborhood, IsOpaque& is_opaque,
+    padded_grid<std::uint8_t>& out, bool include_center = true) {
+    auto convert = [&is_opaque](voxel_id id) { return static_cast<std::uint8_t>(is_opaque(id) ? 1u : 0u); };
+    fill_voxel_blocks(chunk, neighborhood, out, convert, std::uint8_t{0}, include_center);
+}
+
+template <typename IsOpaque>
+void build_opacity_shell(const chunk_storage& chunk, const chunk_neighborhood& neighborhood, IsOpaque& is_opaque,
+    padded_grid<std::uint8_t>& out) {
+    build_opacity_apron(chunk, neighborhood, is_opaque, out, false);
+}
+
+} // namespace detail
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/apron.hpp
+
+// begin: almond_voxel/meshing/mesh_types.hpp
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+// Lighting baked at one blocky vertex. `occlusion` follows the three-neighbour corner rule: 0 when the corner is open,
+// 3 when both side voxels are solid. `skylight` and `blocklight` are smooth light levels in sixteenths (0..240),
+// averaged over the open cells that touch the corner in front of the face. All zero unless lighting was requested.
+struct vertex_shade {
+    std::uint8_t occlusion{0};
+    std::uint8_t skylight{0};
+    std::uint8_t blocklight{0};
+
+    [[nodiscard]] constexpr bool operator==(const vertex_shade&) const noexcept = default;
+};
+
+struct vertex {
+    std::array<float, 3> position{};
+    std::array<float, 3> normal{};
+    std::array<float, 2> uv{};
+    voxel_id id{0};
+    vertex_shade shade{};
+};
+
+// Per-vertex lighting the blocky meshers bake while meshing. Both are off by default; see vertex_shade.
+struct mesh_lighting_config {
+    bool ambient_occlusion{false};
+    bool smooth_light{false};
+
+    [[nodiscard]] constexpr bool enabled() const noexcept { return ambient_occlusion || smooth_light; }
+};
+
+struct mesh_result {
+    std::vector<vertex> vertices;
+    std::vector<std::uint32_t> indices;
+};
+
+// Face rectangle emitted by the blocky meshers' *_quads functions. `origin` is the voxel cell at the rectangle's
+// minimum corner; `width` and `height` extend along the face's u = (axis + 1) % 3 and v = (axis + 2) % 3 axes. `shade`
+// holds the corners (0, 0), (w, 0), (w, h), (0, h) in (u, v); the greedy meshers only merge faces whose shades match.
+struct quad {
+    block_face face{block_face::pos_x};
+    std::array<std::uint32_t, 3> origin{};
+    std::uint32_t width{1};
+    std::uint32_t height{1};
+    voxel_id id{0};
+    std::array<vertex_shade, 4> shade{};
+};
+
+namespace detail {
+
+// Calls `emit(const vertex&)` for the corners of `q` in order, so callers can write them straight to their storage.
+template <typename Emit>
+void for_each_quad_corner(const quad& q, Emit&& emit) {
+    constexpr float vertical_face_bias = 0.001f;
+    const std::size_t axis = static_cast<std::size_t>(axis_of(q.face));
+    const int sign = axis_sign(q.face);
+    const std::size_t u_axis = (axis + 1) % 3;
+    const std::size_t v_axis = (axis + 2) % 3;
+
+    std::array<float, 3> base{};
+    base[axis] = static_cast<float>(q.origin[axis] + (sign > 0 ? 1u : 0u));
+    if (axis == 2) {
+        base[axis] += sign > 0 ? vertical_face_bias : -vertical_face_bias;
+    }
+    base[u_axis] = static_cast<float>(q.origin[u_axis]);
+    base[v_axis] = static_cast<float>(q.origin[v_axis]);
+    const auto width = static_cast<float>(q.width);
+    const auto height = static_cast<float>(q.height);
+
+    const auto normal_i = face_normal(q.face);
+    const std::array<float, 3> normal{static_cast<float>(normal_i[0]), static_cast<float>(normal_i[1]),
+        static_cast<float>(normal_i[2])};
+    const std::array<std::array<float, 2>, 4> offsets{
+        std::array<float, 2>{0.0f, 0.0f},
+        std::array<float, 2>{width, 0.0f},
+        std::array<float, 2>{width, height},
+        std::array<float, 2>{0.0f, height},
+    };
+
+    for (std::size_t i = 0; i < offsets.size(); ++i) {
+        auto position = base;
+        position[u_axis] += offsets[i][0];
+        position[v_axis] += offsets[i][1];
+        emit(vertex{position, normal, offsets[i], q.id, q.shade[i]});
+    }
+}
+
+} // namespace detail
+
+// Float corners of `q`, running (0, 0), (w, 0), (w, h), (0, h) in (u, v) with matching uvs. z faces are nudged outwards
+// by a small bias so stacked chunks do not z-fight.
+[[nodiscard]] inline std::array<vertex, 4> quad_vertices(const quad& q) {
+    std::array<vertex, 4> corners{};
+    std::size_t i = 0;
+    detail::for_each_quad_corner(q, [&](const vertex& corner) { corners[i++] = corner; });
+    return corners;
+}
+
+// Two triangles over four corners starting at `base_index`, wound to face along `face`.
+[[nodiscard]] constexpr std::array<std::uint32_t, 6> quad_indices(std::uint32_t base_index, block_face face) noexcept {
+    if (axis_sign(face) > 0) {
+        return {base_index, base_index + 1, base_index + 2, base_index, base_index + 2, base_index + 3};
+    }
+    return {base_index, base_index + 2, base_index + 1, base_index, base_index + 3, base_index + 2};
+}
+
+// As above, but split along the diagonal that keeps ambient occlusion from interpolating anisotropically: when corners
+// 0 and 2 are darker than corners 1 and 3, the quad is cut from corner 1 to corner 3 instead.
+[[nodiscard]] constexpr std::array<std::uint32_t, 6> quad_indices(std::uint32_t base_index, const quad& q) noexcept {
+    const auto& shade = q.shade;
+    if (shade[0].occlusion + shade[2].occlusion <= shade[1].occlusion + shade[3].occlusion) {
+        return quad_indices(base_index, q.face);
+    }
+    if (axis_sign(q.face) > 0) {
+        return {base_index + 1, base_index + 2, base_index + 3, base_index + 1, base_index + 3, base_index};
+    }
+    return {base_index + 1, base_index + 3, base_index + 2, base_index + 1, base_index, base_index + 3};
+}
+
+// Appends `q` as four float vertices and two triangles facing along its normal.
+inline void append_quad(mesh_result& mesh, const quad& q) {
+    const auto base_index = static_cast<std::uint32_t>(mesh.vertices.size());
+    detail::for_each_quad_corner(q, [&mesh](const vertex& corner) { mesh.vertices.push_back(corner); });
+    const auto indices = quad_indices(base_index, q);
+    mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+}
+
+namespace detail {
+
+struct greedy_mask_cell {
+    bool filled{false};
+    voxel_id id{0};
+    std::array<vertex_shade, 4> shade{};
+};
+
+} // namespace detail
+
+// Working memory for the blocky meshers. Passing the same scratch to successive *_quads calls reuses its buffers, so
+// once they have grown to the largest chunk seen, meshing allocates nothing.
+struct mesher_scratch {
+    // Palette chunks are decoded here for one call instead of keeping a dense copy beside their palette.
+    std::vector<voxel_id> voxels;
+    std::vector<detail::greedy_mask_cell> mask;
+    std::vector<std::uint64_t> rows;
+    std::vector<std::uint64_t> plane_rows;
+    std::vector<std::uint64_t> x_planes;
+    std::vector<quad> quads;
+    // Neighbour-aware entry points pad the chunk with its neighbours' boundary layers before meshing.
+    padded_grid<std::uint8_t> opacity;
+    padded_grid<float> density;
+    padded_grid<std::uint8_t> skylight;
+    padded_grid<std::uint8_t> blocklight;
+    // Marching cubes keeps a ring of density slices, the shared edge vertices of one slab, and the vertices that the
+    // triangle form expands; level-of-detail meshing resamples the chunk into `lod_density`, and stitching chains the
+    // face crossings of one coarse cell into `lod_polyline` before filling the gap polygon.
+    std::vector<float> density_slices;
+    std::vector<std::uint32_t> edge_vertices;
+    std::vector<vertex> smooth_vertices;
+    std::vector<float> lod_density;
+    std::vector<std::array<std::size_t, 2>> lod_segments;
+    std::vector<std::size_t> lod_polyline;
+    std::vector<vertex> lod_polygon;
+    std::vector<std::uint32_t> lod_polygon_indices;
+};
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/mesh_types.hpp
+
+// begin: almond_voxel/meshing/vertex_shading.hpp
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace almond::voxel::meshing {
+
+// Light levels assumed for missing neighbours when baking smooth light: open sky, no block light.
+inline constexpr std::uint8_t missing_neighbor_skylight = 15;
+inline constexpr std::uint8_t missing_neighbor_blocklight = 0;
+
+namespace detail {
+
+// Shader for meshers that bake no lighting; every corner keeps the default vertex_shade.
+struct no_shading {
+    [[nodiscard]] constexpr std::array<vertex_shade, 4> operator()(block_face, std::uint32_t, std::uint32_t,
+        std::uint32_t) const noexcept {
+        return {};
+    }
+};
+
+// Bakes the corner shades of a voxel face from padded opacity and light grids built for the same chunk. Every sample
+// lies in the cell layer in front of the face, so faces on the chunk boundary read the apron and seam with their
+// neighbours.
+class face_shader {
+public:
+    face_shader(const padded_grid<std::uint8_t>& opacity, const padded_grid<std::uint8_t>& skylight,
+        const padded_grid<std::uint8_t>& blocklight, const mesh_lighting_config& lighting) noexcept
+        : opacity_{opacity}, skylight_{skylight}, blocklight_{blocklight}, lighting_{lighting} {}
+
+    [[nodiscard]] std::array<vertex_shade, 4> operator()(block_face face, std::uint32_t x, std::uint32_t y,
+        std::uint32_t z) const noexcept {
+        const auto axis = static_cast<std::size_t>(axis_of(face));
+        std::array<std::ptrdiff_t, 3> front{x, y, z};
+        front[axis] += axis_sign(face);
+        std::array<int, 3> u{};
+        std::array<int, 3> v{};
+        u[(axis + 1) % 3] = 1;
+        v[(axis + 2) % 3] = 1;
+        const auto base = static_cast<std::ptrdiff_t>(opacity_.index(front[0], front[1], front[2]));
+        const auto step_u = opacity_.offset(u[0], u[1], u[2]);
+        const auto step_v = opacity_.offset(v[0], v[1], v[2]);
+
+        // Corners in quad order: (0, 0), (w, 0), (w, h), (0, h).
+        constexpr std::array<std::array<std::ptrdiff_t, 2>, 4> signs{{{-1, -1}, {1, -1}, {1, 1}, {-1, 1}}};
+        std::array<vertex_shade, 4> result{};
+        for (std::size_t i = 0; i < signs.size(); ++i) {
+            const auto side_u = static_cast<std::size_t>(base + signs[i][0] * step_u);
+            const auto side_v = static_cast<std::size_t>(base + signs[i][1] * step_v);
+            const auto corner = static_cast<std::size_t>(base + signs[i][0] * step_u + signs[i][1] * step_v);
+            const bool solid_u = opacity_[side_u] != 0;
+            const bool solid_v = opacity_[side_v] != 0;
+            // Light cannot leak through a corner whose two sides are solid.
+            const bool solid_corner = opacity_[corner] != 0 || (solid_u && solid_v);
+
+            if (lighting_.ambient_occlusion) {
+                result[i].occlusion = static_cast<std::uint8_t>(solid_u && solid_v
+                        ? 3
+                        : int{solid_u} + int{solid_v} + int{solid_corner});
+            }
+            if (lighting_.smooth_light) {
+                const std::array<std::size_t, 4> cells{static_cast<std::size_t>(base), side_u, side_v, corner};
+                const std::array<bool, 4> open{true, !solid_u, !solid_v, !solid_corner};
+                result[i].skylight = smooth(skylight_, cells, open);
+                result[i].blocklight = smooth(blocklight_, cells, open);
+            }
+        }
+        return result;
+    }
+
+private:
+    // Average level of the open cells in sixteenths of a level, rounded to nearest.
+    [[nodiscard]] static std::uint8_t smooth(const padded_grid<std::uint8_t>& light,
+        const std::array<std::size_t, 4>& cells, const std::array<bool, 4>& open) noexcept {
+        unsigned sum = 0;
+        unsigned count = 0;
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            if (open[i]) {
+                sum += light[cells[i]];
+                ++count;
+            }
+        }
+        const unsigned level = (sum * 16u + count / 2u) / count;
+        return static_cast<std::uint8_t>(level < 240u ? level : 240u);
+    }
+
+    const padded_grid<std::uint8_t>& opacity_;
+    const padded_grid<std::uint8_t>& skylight_;
+    const padded_grid<std::uint8_t>& blocklight_;
+    mesh_lighting_config lighting_;
+};
+
+// Builds the light grids `lighting` needs in `scratch` next to an opacity grid that is already built, and returns a
+// shader over them. Uniform light planes are filled without being materialised.
+[[nodiscard]] inline face_shader prepare_face_shader(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, const mesh_lighting_config& lighting, mesher_scratch& scratch) {
+    if (lighting.smooth_light) {
+        build_plane_apron(chunk, neighborhood, scratch.skylight,
+            [](const chunk_storage& source) { return source.skylight(); },
+            [](const chunk_storage& source) { return source.uniform_skylight(); }, missing_neighbor_skylight);
+        build_plane_apron(chunk, neighborhood, scratch.blocklight,
+            [](const chunk_storage& source) { return source.blocklight(); },
+            [](const chunk_storage& source) { return source.uniform_blocklight(); }, missing_neighbor_blocklight);
+    }
+    return face_shader{scratch.opacity, scratch.skylight, scratch.blocklight, lighting};
+}
+
+} // namespace detail
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/vertex_shading.hpp
+
+// begin: almond_voxel/meshing/greedy_mesher.hpp
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+namespace detail {
+
+// `shade(face, x, y, z)` returns the corner shades of one voxel face; faces only merge when their shades match.
+template <typename IsOpaque, typename NeighborOpaque, typename Shade, typename QuadSink>
+void greedy_quads(const chunk_storage& chunk, IsOpaque&& is_opaque, NeighborOpaque&& neighbor_opaque,
+    const Shade& shade, QuadSink&& sink, mesher_scratch& scratch) {
+    const auto extent = chunk.extent();
+    const auto dims = extent.to_array();
+
+    // Uniform chunks only expose their boundary planes; empty ones produce nothing.
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_opaque(*uniform)) {
+        return;
+    }
+    span3d<const voxel_id> voxels{};
+    if (!uniform) {
+        voxels = chunk.read_voxels(scratch.voxels);
+    }
+    const auto sample = [&](std::size_t x, std::size_t y, std::size_t z) {
+        return uniform ? *uniform : voxels(x, y, z);
+    };
+
+    using mask_cell = detail::greedy_mask_cell;
+    auto& mask = scratch.mask;
+
+    const std::array faces{block_face::pos_x, block_face::neg_x, block_face::pos_y, block_face::neg_y, block_face::pos_z, block_face::neg_z};
+
+    for (auto face : faces) {
+        const std::size_t axis = static_cast<std::size_t>(axis_of(face));
+        const int sign = axis_sign(face);
+        const std::size_t u_axis = (axis + 1) % 3;
+        const std::size_t v_axis = (axis + 2) % 3;
+        const std::size_t du = dims[u_axis];
+        const std::size_t dv = dims[v_axis];
+
+        if (dims[axis] == 0) {
+            continue;
+        }
+        mask.resize(du * dv);
+        const std::size_t first_plane = uniform && sign > 0 ? dims[axis] - 1 : 0;
+        const std::size_t last_plane = uniform && sign < 0 ? 1 : dims[axis];
+
+        for (std::size_t plane = first_plane; plane < last_plane; ++plane) {
+            std::fill(mask.begin(), mask.end(), mask_cell{});
+
+            for (std::size_t v = 0; v < dv; ++v) {
+                for (std::size_t u = 0; u < du; ++u) {
+                    const std::size_t idx = u + v * du;
+                    std::array<std::size_t, 3> pos{};
+                    pos[axis] = plane;
+                    pos[u_axis] = u;
+                    pos[v_axis] = v;
+
+                    const voxel_id current = sample(pos[0], pos[1], pos[2]);
+                    if (!is_opaque(current)) {
+                        continue;
+                    }
+
+                    bool neighbor_inside = true;
+                    std::array<std::size_t, 3> neighbor = pos;
+                    if (sign > 0) {
+                        neighbor[axis] = pos[axis] + 1;
+                        neighbor_inside = neighbor[axis] < dims[axis];
+                    } else {
+                        neighbor_inside = pos[axis] > 0;
+                        if (neighbor_inside) {
+                            neighbor[axis] = pos[axis] - 1;
+                        }
+                    }
+
+                    bool neighbor_solid = false;
+                    if (neighbor_inside) {
+                        neighbor_solid = is_opaque(sample(neighbor[0], neighbor[1], neighbor[2]));
+                    } else {
+                        std::array<std::ptrdiff_t, 3> neighbor_local{
+                            static_cast<std::ptrdiff_t>(pos[0]),
+                            static_cast<std::ptrdiff_t>(pos[1]),
+                            static_cast<std::ptrdiff_t>(pos[2])
+                        };
+                        neighbor_local[axis] += sign;
+                        neighbor_solid = neighbor_opaque(neighbor_local);
+                    }
+
+                    if (!neighbor_solid) {
+                        mask[idx] = mask_cell{true, current,
+                            shade(face, static_cast<std::uint32_t>(pos[0]), static_cast<std::uint32_t>(pos[1]),
+                                static_cast<std::uint32_t>(pos[2]))};
+                    }
+                }
+            }
+
+            for (std::size_t v = 0; v < dv; ++v) {
+                for (std::size_t u = 0; u < du; ++u) {
+                    const std::size_t idx = u + v * du;
+                    auto& cell = mask[idx];
+                    if (!cell.filled) {
+                        continue;
+                    }
+
+                    std::size_t width = 1;
+                    while (u + width < du) {
+                        const auto& next = mask[idx + width];
+                        if (!next.filled || next.id != cell.id || next.shade != cell.shade) {
+                            break;
+                        }
+                        ++width;
+                    }
+
+                    std::size_t height = 1;
+                    bool stop = false;
+                    while (v + height < dv && !stop) {
+                        for (std::size_t x = 0; x < width; ++x) {
+                            const auto& next = mask[idx + x + height * du];
+                            if (!next.filled || next.id != cell.id || next.shade != cell.shade) {
+                                stop = true;
+                                break;
+                            }
+                        }
+                        if (!stop) {
+                            ++height;
+                        }
+                    }
+
+                    quad merged{face, {}, static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height), cell.id,
+                        cell.shade};
+                    merged.origin[axis] = static_cast<std::uint32_t>(plane);
+                    merged.origin[u_axis] = static_cast<std::uint32_t>(u);
+                    merged.origin[v_axis] = static_cast<std::uint32_t>(v);
+                    sink(merged);
+
+                    for (std::size_t dy = 0; dy < height; ++dy) {
+                        for (std::size_t dx = 0; dx < width; ++dx) {
+                            mask[u + dx + (v + dy) * du].filled = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+// Emits merged face rectangles to `sink(const quad&)`; greedy_mesh_with_neighbors turns them into float vertices and
+// packed_mesh.hpp provides compact sinks. The face mask lives in `scratch`.
+template <typename IsOpaque, typename NeighborOpaque, typename QuadSink>
+void greedy_quads_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque, NeighborOpaque&& neighbor_opaque,
+    QuadSink&& sink, mesher_scratch& scratch) {
+    detail::greedy_quads(chunk, std::forward<IsOpaque>(is_opaque), std::forward<NeighborOpaque>(neighbor_opaque),
+        detail::no_shading{}, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque, typename NeighborOpaque, typename QuadSink>
+void greedy_quads_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque, NeighborOpaque&& neighbor_opaque,
+    QuadSink&& sink) {
+    mesher_scratch scratch;
+    greedy_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), std::forward<NeighborOpaque>(neighbor_opaque),
+        std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque, typename NeighborOpaque>
+[[nodiscard]] mesh_result greedy_mesh_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
+    NeighborOpaque&& neighbor_opaque) {
+    mesh_result result;
+    greedy_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), std::forward<NeighborOpaque>(neighbor_opaque),
+        [&result](const quad& q) { append_quad(result, q); });
+    return result;
+}
+
+// Meshes against all 26 neighbours and bakes the lighting requested in `lighting` into each quad's shade, so ambient
+// occlusion and smooth light seam across chunk faces, edges and corners. Lit faces only merge with faces of the same
+// shade, so lighting costs quads. Padded grids live in `scratch`.
+template <typename IsOpaque, typename QuadSink>
+void greedy_quads_with_neighborhood(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting, QuadSink&& sink, mesher_scratch& scratch) {
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_opaque(*uniform)) {
+        return;
+    }
+    // Unlit meshing only samples the apron; ambient occlusion also reads the centre cells.
+    auto& opacity = scratch.opacity;
+    detail::build_opacity_apron(chunk, neighborhood, is_opaque, opacity, lighting.enabled());
+    auto neighbor_sampler = [&opacity](const std::array<std::ptrdiff_t, 3>& coord) {
+        return opacity(coord[0], coord[1], coord[2]) != 0;
+    };
+
+    if (!lighting.enabled()) {
+        detail::greedy_quads(chunk, is_opaque, neighbor_sampler, detail::no_shading{}, std::forward<QuadSink>(sink),
+            scratch);
+        return;
+    }
+    const auto shader = detail::prepare_face_shader(chunk, neighborhood, lighting, scratch);
+    detail::greedy_quads(chunk, is_opaque, neighbor_sampler, shader, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result greedy_mesh_with_neighborhood(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, IsOpaque&& is_opaque, const mesh_lighting_config& lighting = {}) {
+    mesh_result result;
+    mesher_scratch scratch;
+    greedy_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [&result](const quad& q) { append_quad(result, q); }, scratch);
+    return result;
+}
+
+inline mesh_result greedy_mesh_with_neighborhood(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    const mesh_lighting_config& lighting = {}) {
+    return greedy_mesh_with_neighborhood(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; }, lighting);
+}
+
+template <typename IsOpaque, typename QuadSink>
+void greedy_quads_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque, QuadSink&& sink, mesher_scratch& scratch) {
+    greedy_quads_with_neighborhood(chunk, chunk_neighborhood::from_faces(neighbors), std::forward<IsOpaque>(is_opaque),
+        mesh_lighting_config{}, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque, typename QuadSink>
+void greedy_quads_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque, QuadSink&& sink) {
+    mesher_scratch scratch;
+    greedy_quads_with_neighbor_chunks(chunk, neighbors, std::forward<IsOpaque>(is_opaque),
+        std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result greedy_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque) {
+    mesh_result result;
+    greedy_quads_with_neighbor_chunks(chunk, neighbors, std::forward<IsOpaque>(is_opaque),
+        [&result](const quad& q) { append_quad(result, q); });
+    return result;
+}
+
+inline mesh_result greedy_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors) {
+    return greedy_mesh_with_neighbor_chunks(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result greedy_mesh(const chunk_storage& chunk, IsOpaque&& is_opaque) {
+    auto neighbor = [](const std::array<std::ptrdiff_t, 3>&) { return false; };
+    return greedy_mesh_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), neighbor);
+}
+
+inline mesh_result greedy_mesh(const chunk_storage& chunk) {
+    return greedy_mesh(chunk, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/greedy_mesher.hpp
+
+// begin: almond_voxel/meshing/binary_greedy_mesher.hpp
+
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+// Largest chunk extent along x and y that the bitmask mesher handles; larger chunks fall back to greedy_mesh.
+inline constexpr std::uint32_t binary_mesh_max_extent = 64;
+
+namespace detail {
+
+[[nodiscard]] constexpr std::uint64_t low_bits(std::size_t count) noexcept {
+    return count >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << count) - 1;
+}
+
+// Greedy rectangle merge over one face plane. rows[v] holds the visible cells of row v as bits along u and is consumed.
+// Runs grow along u first, then along v while the next row covers the whole run with the same id. `id_at(u, v)` is
+// only consulted when the chunk may hold more than one opaque voxel id.
+template <typename IdAt, typename Emit>
+void merge_binary_plane(std::span<std::uint64_t> rows, bool mixed, voxel_id single_id, IdAt&& id_at, Emit&& emit) {
+    for (std::size_t v = 0; v < rows.size(); ++v) {
+        while (rows[v] != 0) {
+            const auto u = static_cast<std::uint32_t>(std::countr_zero(rows[v]));
+            const voxel_id id = mixed ? id_at(u, v) : single_id;
+            auto width = static_cast<std::uint32_t>(std::countr_one(rows[v] >> u));
+            if (mixed) {
+                for (std::uint32_t w = 1; w < width; ++w) {
+                    if (id_at(u + w, v) != id) {
+                        width = w;
+                        break;
+                    }
+                }
+            }
+            const std::uint64_t run = low_bits(width) << u;
+
+            std::size_t height = 1;
+            while (v + height < rows.size() && (rows[v + height] & run) == run) {
+                bool same = true;
+                for (std::uint32_t w = 0; mixed && w < width; ++w) {
+                    if (id_at(u + w, v + height) != id) {
+                        same = false;
+                        break;
+                    }
+                }
+                if (!same) {
+                    break;
+                }
+                ++height;
+            }
+            for (std::size_t h = 0; h < height; ++h) {
+                rows[v + h] &= ~run;
+            }
+            emit(u, static_cast<std::uint32_t>(v), width, static_cast<std::uint32_t>(height), id);
+        }
+    }
+}
+
+} // namespace detail
+
+// Greedy mesher over 64-bit occupancy rows. One pass packs opacity into a bit per voxel along x; face masks then come
+// from shifts (x faces) and ANDs with the adjacent row (y and z faces), and quads are merged with bit scans instead of
+// per-cell tests. Emits the same visible faces as greedy_quads_with_neighbors (y faces may be split into different
+// rectangles), but is_opaque runs once per voxel and neighbor_opaque only for opaque boundary cells. Chunks wider than
+// binary_mesh_max_extent along x or y fall back to greedy_quads_with_neighbors. Bit rows live in `scratch`.
+template <typename IsOpaque, typename NeighborOpaque, typename QuadSink>
+void binary_greedy_quads_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
+    NeighborOpaque&& neighbor_opaque, QuadSink&& sink, mesher_scratch& scratch) {
+    const auto extent = chunk.extent();
+    if (extent.x > binary_mesh_max_extent || extent.y > binary_mesh_max_extent) {
+        greedy_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque),
+            std::forward<NeighborOpaque>(neighbor_opaque), std::forward<QuadSink>(sink), scratch);
+        return;
+    }
+
+    const auto uniform = chunk.uniform_voxel();
+    if ((uniform && !is_opaque(*uniform)) || extent.volume() == 0) {
+        return;
+    }
+    const std::size_t nx = extent.x;
+    const std::size_t ny = extent.y;
+    const std::size_t nz = extent.z;
+
+    // Bit x of rows[y + z * ny] is set when voxel (x, y, z) is opaque.
+    auto& rows = scratch.rows;
+    rows.assign(ny * nz, 0);
+    span3d<const voxel_id> voxels{};
+    bool mixed = false;
+    voxel_id single_id{};
+    if (uniform) {
+        std::fill(rows.begin(), rows.end(), detail::low_bits(nx));
+        single_id = *uniform;
+    } else {
+        voxels = chunk.read_voxels(scratch.voxels);
+        const auto* data = voxels.linear().data();
+        bool found = false;
+        for (std::size_t r = 0; r < rows.size(); ++r) {
+            const auto* row = data + r * nx;
+            std::uint64_t bits = 0;
+            for (std::size_t x = 0; x < nx; ++x) {
+                bits |= std::uint64_t{is_opaque(row[x]) ? 1u : 0u} << x;
+            }
+            rows[r] = bits;
+            // Single-material chunks skip id comparisons while merging.
+            for (auto rest = bits; rest != 0 && !mixed; rest &= rest - 1) {
+                const auto id = row[std::countr_zero(rest)];
+                mixed = found && id != single_id;
+                single_id = found ? single_id : id;
+                found = true;
+            }
+        }
+    }
+
+    const auto neighbor = [&](std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t z) {
+        return neighbor_opaque(std::array<std::ptrdiff_t, 3>{x, y, z});
+    };
+    // Opaque cells just outside the chunk, as bits along x for the y and z boundary rows.
+    const auto boundary_row = [&](std::uint64_t inside, std::ptrdiff_t y, std::ptrdiff_t z) {
+        std::uint64_t bits = 0;
+        for (auto rest = inside; rest != 0; rest &= rest - 1) {
+            const auto x = std::countr_zero(rest);
+            bits |= std::uint64_t{neighbor(x, y, z) ? 1u : 0u} << x;
+        }
+        return bits;
+    };
+
+    auto& plane_rows = scratch.plane_rows;
+    plane_rows.resize(std::max(ny, nz));
+    const auto plane_span = [&](std::size_t count) { return std::span<std::uint64_t>{plane_rows.data(), count}; };
+    const auto id_at = [&](std::size_t x, std::size_t y, std::size_t z) { return voxels(x, y, z); };
+
+    // x faces: shift each row against itself, then scatter the face bits into per-x planes of z rows with y bits.
+    auto& x_planes = scratch.x_planes;
+    x_planes.resize(nx * nz);
+    for (const auto face : {block_face::pos_x, block_face::neg_x}) {
+        const bool positive = face == block_face::pos_x;
+        std::fill(x_planes.begin(), x_planes.end(), 0);
+        for (std::size_t z = 0; z < nz; ++z) {
+            for (std::size_t y = 0; y < ny; ++y) {
+                const auto r = rows[y + z * ny];
+                const std::uint64_t edge = positive ? std::uint64_t{1} << (nx - 1) : 1u;
+                std::uint64_t covered = positive ? r >> 1u : r << 1u;
+                if ((r & edge) != 0 && neighbor(positive ? static_cast<std::ptrdiff_t>(nx) : -1,
+                        static_cast<std::ptrdiff_t>(y), static_cast<std::ptrdiff_t>(z))) {
+                    covered |= edge;
+                }
+                for (auto visible = r & ~covered; visible != 0; visible &= visible - 1) {
+                    x_planes[static_cast<std::size_t>(std::countr_zero(visible)) * nz + z] |= std::uint64_t{1} << y;
+                }
+            }
+        }
+        for (std::size_t x = 0; x < nx; ++x) {
+            detail::merge_binary_plane(std::span<std::uint64_t>{x_planes.data() + x * nz, nz}, mixed, single_id,
+                [&](std::size_t u, std::size_t v) { return id_at(x, u, v); },
+                [&](std::uint32_t u, std::uint32_t v, std::uint32_t w, std::uint32_t h, voxel_id id) {
+                    sink(quad{face, {static_cast<std::uint32_t>(x), u, v}, w, h, id});
+                });
+        }
+    }
+
+    // y faces: AND each row with its neighbour along y; planes hold z rows with x bits.
+    for (const auto face : {block_face::pos_y, block_face::neg_y}) {
+        const bool positive = face == block_face::pos_y;
+        for (std::size_t y = 0; y < ny; ++y) {
+            const bool boundary = positive ? y + 1 == ny : y == 0;
+            const auto outside = positive ? static_cast<std::ptrdiff_t>(ny) : -1;
+            for (std::size_t z = 0; z < nz; ++z) {
+                const auto r = rows[y + z * ny];
+                const auto covered = boundary ? boundary_row(r, outside, static_cast<std::ptrdiff_t>(z))
+                                              : rows[(positive ? y + 1 : y - 1) + z * ny];
+                plane_rows[z] = r & ~covered;
+            }
+            detail::merge_binary_plane(plane_span(nz), mixed, single_id,
+                [&](std::size_t u, std::size_t v) { return id_at(u, y, v); },
+                [&](std::uint32_t u, std::uint32_t v, std::uint32_t w, std::uint32_t h, voxel_id id) {
+                    sink(quad{face, {u, static_cast<std::uint32_t>(y), v}, h, w, id});
+                });
+        }
+    }
+
+    // z faces: AND each row with the same row one layer up or down; planes hold y rows with x bits.
+    for (const auto face : {block_face::pos_z, block_face::neg_z}) {
+        const bool positive = face == block_face::pos_z;
+        for (std::size_t z = 0; z < nz; ++z) {
+            const bool boundary = positive ? z + 1 == nz : z == 0;
+            const auto outside = positive ? static_cast<std::ptrdiff_t>(nz) : -1;
+            for (std::size_t y = 0; y < ny; ++y) {
+                const auto r = rows[y + z * ny];
+                const auto covered = boundary ? boundary_row(r, static_cast<std::ptrdiff_t>(y), outside)
+                                              : rows[y + (positive ? z + 1 : z - 1) * ny];
+                plane_rows[y] = r & ~covered;
+            }
+            detail::merge_binary_plane(plane_span(ny), mixed, single_id,
+                [&](std::size_t u, std::size_t v) { return id_at(u, v, z); },
+                [&](std::uint32_t u, std::uint32_t v, std::uint32_t w, std::uint32_t h, voxel_id id) {
+                    sink(quad{face, {u, v, static_cast<std::uint32_t>(z)}, w, h, id});
+                });
+        }
+    }
+}
+
+template <typename IsOpaque, typename NeighborOpaque, typename QuadSink>
+void binary_greedy_quads_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
+    NeighborOpaque&& neighbor_opaque, QuadSink&& sink) {
+    mesher_scratch scratch;
+    binary_greedy_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque),
+        std::forward<NeighborOpaque>(neighbor_opaque), std::forward<QuadSink>(sink), scratch);
+}
+
+namespace detail {
+
+inline void append_quads(mesh_result& result, const std::vector<quad>& quads) {
+    result.vertices.reserve(result.vertices.size() + quads.size() * 4);
+    result.indices.reserve(result.indices.size() + quads.size() * 6);
+    for (const auto& q : quads) {
+        append_quad(result, q);
+    }
+}
+
+} // namespace detail
+
+template <typename IsOpaque, typename NeighborOpaque>
+[[nodiscard]] mesh_result binary_greedy_mesh_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
+    NeighborOpaque&& neighbor_opaque) {
+    // Quads are gathered first so the vertex and index buffers are sized exactly once.
+    std::vector<quad> quads;
+    binary_greedy_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque),
+        std::forward<NeighborOpaque>(neighbor_opaque), [&quads](const quad& q) { quads.push_back(q); });
+    mesh_result result;
+    detail::append_quads(result, quads);
+    return result;
+}
+
+// Meshes against all 26 neighbours. Shades differ per voxel face, which the bit-plane merge cannot compare, so lit
+// meshes come from greedy_quads_with_neighborhood instead.
+template <typename IsOpaque, typename QuadSink>
+void binary_greedy_quads_with_neighborhood(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting, QuadSink&& sink, mesher_scratch& scratch) {
+    if (lighting.enabled()) {
+        greedy_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+            std::forward<QuadSink>(sink), scratch);
+        return;
+    }
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_opaque(*uniform)) {
+        return;
+    }
+    // The bit rows convert the centre themselves, so only the apron shell goes through is_opaque here.
+    auto& opacity = scratch.opacity;
+    detail::build_opacity_shell(chunk, neighborhood, is_opaque, opacity);
+    auto neighbor_sampler = [&opacity](const std::array<std::ptrdiff_t, 3>& coord) {
+        return opacity(coord[0], coord[1], coord[2]) != 0;
+    };
+
+    binary_greedy_quads_with_neighbors(chunk, is_opaque, neighbor_sampler, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque, typename QuadSink>
+void binary_greedy_quads_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque, QuadSink&& sink, mesher_scratch& scratch) {
+    binary_greedy_quads_with_neighborhood(chunk, chunk_neighborhood::from_faces(neighbors),
+        std::forward<IsOpaque>(is_opaque), mesh_lighting_config{}, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque, typename QuadSink>
+void binary_greedy_quads_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque, QuadSink&& sink) {
+    mesher_scratch scratch;
+    binary_greedy_quads_with_neighbor_chunks(chunk, neighbors, std::forward<IsOpaque>(is_opaque),
+        std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result binary_greedy_mesh_with_neighbor_chunks(const chunk_storage& chunk,
+    const chunk_neighbors& neighbors, IsOpaque&& is_opaque) {
+    std::vector<quad> quads;
+    binary_greedy_quads_with_neighbor_chunks(chunk, neighbors, std::forward<IsOpaque>(is_opaque),
+        [&quads](const quad& q) { quads.push_back(q); });
+    mesh_result result;
+    detail::append_quads(result, quads);
+    return result;
+}
+
+inline mesh_result binary_greedy_mesh_with_neighbor_chunks(const chunk_storage& chunk,
+    const chunk_neighbors& neighbors) {
+    return binary_greedy_mesh_with_neighbor_chunks(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result binary_greedy_mesh_with_neighborhood(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, IsOpaque&& is_opaque, const mesh_lighting_config& lighting = {}) {
+    std::vector<quad> quads;
+    mesher_scratch scratch;
+    binary_greedy_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [&quads](const quad& q) { quads.push_back(q); }, scratch);
+    mesh_result result;
+    detail::append_quads(result, quads);
+    return result;
+}
+
+inline mesh_result binary_greedy_mesh_with_neighborhood(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, const mesh_lighting_config& lighting = {}) {
+    return binary_greedy_mesh_with_neighborhood(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; },
+        lighting);
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result binary_greedy_mesh(const chunk_storage& chunk, IsOpaque&& is_opaque) {
+    auto neighbor = [](const std::array<std::ptrdiff_t, 3>&) { return false; };
+    return binary_greedy_mesh_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), neighbor);
+}
+
+inline mesh_result binary_greedy_mesh(const chunk_storage& chunk) {
+    return binary_greedy_mesh(chunk, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/binary_greedy_mesher.hpp
+
+// begin: almond_voxel/meshing/marching_cubes_tables.hpp
+
+#include <array>
+#include <cstdint>
+
+namespace almond::voxel::meshing::detail {
+
+    inline constexpr std::array<int, 256> mc_edge_table{
+        0x000, 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
+        0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
+        0x190, 0x099, 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
+        0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
+        0x230, 0x339, 0x033, 0x13a, 0x636, 0x73f, 0x435, 0x53c,
+        0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
+        0x3a0, 0x2a9, 0x1a3, 0x0aa, 0x7a6, 0x6af, 0x5a5, 0x4ac,
+        0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
+        0x460, 0x569, 0x663, 0x76a, 0x066, 0x16f, 0x265, 0x36c,
+        0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
+        0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0x0ff, 0x3f5, 0x2fc,
+        0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
+        0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x055, 0x15c,
+        0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
+        0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0x0cc,
+        0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
+        0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
+        0x0cc, 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
+        0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
+        0x15c, 0x055, 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
+        0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
+        0x2fc, 0x3f5, 0x0ff, 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
+        0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
+        0x36c, 0x265, 0x16f, 0x066, 0x76a, 0x663, 0x569, 0x460,
+        0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
+        0x4ac, 0x5a5, 0x6af, 0x7a6, 0x0aa, 0x1a3, 0x2a9, 0x3a0,
+        0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
+        0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x033, 0x339, 0x230,
+        0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
+        0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x099, 0x190,
+        0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
+        0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x000
+    };
+
+    inline constexpr std::array<std::array<int, 32>, 256> mc_triangle_table
+    {
+        {
+            {{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1}},
+            {{3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1}},
+            {{3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1}},
+            {{3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1}},
+            {{2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1}},
+            {{8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1}},
+            {{4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1}},
+            {{3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1}},
+            {{4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1}},
+            {{4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1}},
+            {{5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1}},
+            {{2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1}},
+            {{9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1}},
+            {{2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1}},
+            {{10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1}},
+            {{4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1}},
+            {{5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1}},
+            {{5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1}},
+            {{10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1}},
+            {{8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1}},
+            {{2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1}},
+            {{7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1}},
+            {{2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1}},
+            {{11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1}},
+            {{5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1}},
+            {{11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1}},
+            {{11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1}},
+            {{9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1}},
+            {{5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1}},
+            {{2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1}},
+            {{5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1}},
+            {{6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1}},
+            {{3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1}},
+            {{6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1}},
+            {{5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1}},
+            {{10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1}},
+            {{6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1}},
+            {{8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1}},
+            {{7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1}},
+            {{3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1}},
+            {{5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1}},
+            {{0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1}},
+            {{9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1}},
+            {{8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1}},
+            {{5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1}},
+            {{0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1}},
+            {{6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1}},
+            {{10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1}},
+            {{10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1}},
+            {{8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1}},
+            {{1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1}},
+            {{3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1}},
+            {{0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1}},
+            {{10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1}},
+            {{3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1}},
+            {{6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1}},
+            {{9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1}},
+            {{8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1}},
+            {{3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1}},
+            {{6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1}},
+            {{10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1}},
+            {{10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1}},
+            {{1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1}},
+            {{2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1}},
+            {{7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1}},
+            {{7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1}},
+            {{2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1}},
+            {{1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1}},
+            {{11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1}},
+            {{8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1}},
+            {{0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1}},
+            {{7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+            {{8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1}},
             {{10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
             {{1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1}},
             {{2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1}},
@@ -2885,243 +6496,4614 @@ namespace almond::voxel::meshing::detail {
         }
     };
 
-} // namespace almond::voxel::meshing::detail
-// end: almond_voxel/meshing/marching_cubes_tables.hpp
+} // namespace almond::voxel::meshing::detail
+// end: almond_voxel/meshing/marching_cubes_tables.hpp
+
+// begin: almond_voxel/meshing/marching_cubes.hpp
+
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+struct marching_cubes_config {
+    // Scalar threshold for the implicit surface. Sample values strictly below the iso value are
+    // classified as solid, while values greater than or equal to the iso value are treated as empty.
+    float iso_value{0.5f};
+};
+
+// Wraps a row sampler `fill(y, z, std::span<float> row)` that writes the densities of points (0..extent.x, y, z) in
+// one call, so samplers backed by contiguous memory or vectorised noise avoid a call per point. Pass it wherever a
+// density sampler is accepted.
+template <typename Fill>
+struct density_rows {
+    Fill fill;
+};
+
+template <typename Fill>
+density_rows(Fill) -> density_rows<Fill>;
+
+namespace detail {
+
+inline constexpr std::array<std::array<int, 3>, 8> cube_corners{{
+    {{0, 0, 0}},
+    {{1, 0, 0}},
+    {{1, 1, 0}},
+    {{0, 1, 0}},
+    {{0, 0, 1}},
+    {{1, 0, 1}},
+    {{1, 1, 1}},
+    {{0, 1, 1}},
+}};
+
+// Each cube edge as {axis, x, y, z}: the edge starts at cube corner (x, y, z) and runs along `axis`. Edges are keyed by
+// their lower end, so the cells sharing an edge find the same cached vertex.
+inline constexpr std::array<std::array<int, 4>, 12> cube_edges{{
+    {{0, 0, 0, 0}},
+    {{1, 1, 0, 0}},
+    {{0, 0, 1, 0}},
+    {{1, 0, 0, 0}},
+    {{0, 0, 0, 1}},
+    {{1, 1, 0, 1}},
+    {{0, 0, 1, 1}},
+    {{1, 0, 0, 1}},
+    {{2, 0, 0, 0}},
+    {{2, 1, 0, 0}},
+    {{2, 1, 1, 0}},
+    {{2, 0, 1, 0}},
+}};
+
+inline constexpr std::uint32_t no_cached_vertex = 0xFFFFFFFFu;
+
+template <typename DensitySampler>
+struct is_density_rows : std::false_type {};
+
+template <typename Fill>
+struct is_density_rows<density_rows<Fill>> : std::true_type {};
+
+// Adapts a density sampler to the row form the slab loop reads; point samplers are called once per row point.
+template <typename DensitySampler>
+[[nodiscard]] auto row_sampler(DensitySampler& density_sampler) {
+    if constexpr (is_density_rows<std::remove_cvref_t<DensitySampler>>::value) {
+        return [&density_sampler](std::size_t y, std::size_t z, std::span<float> row) {
+            density_sampler.fill(y, z, row);
+        };
+    } else {
+        return [&density_sampler](std::size_t y, std::size_t z, std::span<float> row) {
+            for (std::size_t x = 0; x < row.size(); ++x) {
+                row[x] = static_cast<float>(density_sampler(x, y, z));
+            }
+        };
+    }
+}
+
+// Density gradient at a lattice point of `lattice` (anything with at(x, y, z) and limits()) from central differences,
+// one-sided on the lattice boundary. Used for caller-supplied samplers, which cannot be read outside the lattice.
+template <typename Lattice>
+[[nodiscard]] std::array<float, 3> lattice_gradient(const Lattice& lattice, const std::array<std::size_t, 3>& point) {
+    const auto limit = lattice.limits();
+    std::array<float, 3> result{};
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+        auto lo = point;
+        auto hi = point;
+        lo[axis] = point[axis] > 0 ? point[axis] - 1 : 0;
+        hi[axis] = point[axis] < limit[axis] ? point[axis] + 1 : limit[axis];
+        if (lo[axis] == hi[axis]) {
+            continue;
+        }
+        result[axis] = (lattice.at(hi[0], hi[1], hi[2]) - lattice.at(lo[0], lo[1], lo[2]))
+            / static_cast<float>(hi[axis] - lo[axis]);
+    }
+    return result;
+}
+
+struct lattice_gradients {
+    template <typename Lattice>
+    [[nodiscard]] std::array<float, 3> operator()(
+        const Lattice& lattice, const std::array<std::size_t, 3>& point) const {
+        return lattice_gradient(lattice, point);
+    }
+};
+
+// Central differences read from the padded density grid instead of the lattice, one lattice step either side of every
+// point, so both chunks on a seam compute the same normal for a shared vertex. Lattice point p sits on voxel p * step,
+// which needs an apron of step + 1 voxels; padded_density_apron() gives it.
+struct padded_gradients {
+    const padded_grid<float>* density{nullptr};
+    std::ptrdiff_t step{1};
+
+    template <typename Lattice>
+    [[nodiscard]] std::array<float, 3> operator()(const Lattice&, const std::array<std::size_t, 3>& point) const {
+        const std::array<std::ptrdiff_t, 3> voxel{static_cast<std::ptrdiff_t>(point[0]) * step,
+            static_cast<std::ptrdiff_t>(point[1]) * step, static_cast<std::ptrdiff_t>(point[2]) * step};
+        const auto base = static_cast<std::ptrdiff_t>(density->index(voxel[0], voxel[1], voxel[2]));
+        std::array<float, 3> result{};
+        for (int axis = 0; axis < 3; ++axis) {
+            std::array<int, 3> unit{};
+            unit[static_cast<std::size_t>(axis)] = 1;
+            const auto reach = density->offset(unit[0], unit[1], unit[2]) * step;
+            result[static_cast<std::size_t>(axis)] = ((*density)[static_cast<std::size_t>(base + reach)]
+                                                         - (*density)[static_cast<std::size_t>(base - reach)])
+                * 0.5f;
+        }
+        return result;
+    }
+};
+
+[[nodiscard]] constexpr std::uint32_t padded_density_apron(std::size_t step) noexcept {
+    return static_cast<std::uint32_t>(step) + 1;
+}
+
+// The surface vertex on the lattice edge that starts at `lo` and runs along `axis`, with positions scaled by
+// `cell_size`. Meshing and LOD stitching both build vertices here, so the same edge always lands on the same point.
+template <typename Lattice, typename Gradient = lattice_gradients>
+[[nodiscard]] vertex edge_vertex(const Lattice& lattice, const std::array<std::size_t, 3>& lo, int axis,
+    float iso_value, voxel_id material, float cell_size, const Gradient& gradient = {}) {
+    const auto a = static_cast<std::size_t>(axis);
+    auto hi = lo;
+    ++hi[a];
+    const float v0 = lattice.at(lo[0], lo[1], lo[2]);
+    const float v1 = lattice.at(hi[0], hi[1], hi[2]);
+    const float delta = v1 - v0;
+    const float mu = std::abs(delta) < 1e-6f ? 0.0f : (iso_value - v0) / delta;
+
+    std::array<float, 3> position{static_cast<float>(lo[0]), static_cast<float>(lo[1]), static_cast<float>(lo[2])};
+    position[a] += mu;
+    for (auto& coordinate : position) {
+        coordinate *= cell_size;
+    }
+
+    const auto g0 = gradient(lattice, lo);
+    const auto g1 = gradient(lattice, hi);
+    std::array<float, 3> normal{g0[0] + mu * (g1[0] - g0[0]), g0[1] + mu * (g1[1] - g0[1]),
+        g0[2] + mu * (g1[2] - g0[2])};
+    const float length_sq = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
+    if (length_sq <= 1e-12f) {
+        // Flat field around the edge: face away from its solid end.
+        normal = {0.0f, 0.0f, 0.0f};
+        normal[a] = v0 < iso_value ? 1.0f : -1.0f;
+    } else {
+        const float inv_length = 1.0f / std::sqrt(length_sq);
+        normal = {normal[0] * inv_length, normal[1] * inv_length, normal[2] * inv_length};
+    }
+    return vertex{position, normal, {position[0], position[1]}, material};
+}
+
+// Density lattice of (extent + 1)^3 points, read one z slice at a time into a ring of four slices: a slab of cells
+// between slices z and z + 1 needs z - 1 and z + 2 for central-difference gradients. Every point is sampled once.
+class density_slab_cache {
+public:
+    density_slab_cache(chunk_extent extent, std::vector<float>& storage)
+        : nx_{static_cast<std::size_t>(extent.x) + 1},
+          ny_{static_cast<std::size_t>(extent.y) + 1},
+          nz_{static_cast<std::size_t>(extent.z) + 1},
+          storage_{storage} {
+        storage_.resize(nx_ * ny_ * 4);
+    }
+
+    // Loads the slices up to `z`; each is read once, in order.
+    template <typename RowSampler>
+    void load_through(std::size_t z, RowSampler& fill_row) {
+        for (; loaded_ <= z && loaded_ < nz_; ++loaded_) {
+            float* slice = storage_.data() + (loaded_ % 4) * nx_ * ny_;
+            for (std::size_t y = 0; y < ny_; ++y) {
+                fill_row(y, loaded_, std::span<float>{slice + y * nx_, nx_});
+            }
+        }
+    }
+
+    [[nodiscard]] const float* slice(std::size_t z) const noexcept {
+        return storage_.data() + (z % 4) * nx_ * ny_;
+    }
+
+    [[nodiscard]] float at(std::size_t x, std::size_t y, std::size_t z) const noexcept {
+        return slice(z)[x + nx_ * y];
+    }
+
+    [[nodiscard]] std::array<std::size_t, 3> limits() const noexcept { return {nx_ - 1, ny_ - 1, nz_ - 1}; }
+
+    [[nodiscard]] std::size_t points_x() const noexcept { return nx_; }
+    [[nodiscard]] std::size_t slice_size() const noexcept { return nx_ * ny_; }
+
+private:
+    std::size_t nx_;
+    std::size_t ny_;
+    std::size_t nz_;
+    std::vector<float>& storage_;
+    std::size_t loaded_{0};
+};
+
+// Marches the cells one z slab at a time. Edge vertices are created once and cached by their lower lattice point: x
+// and y edges for the slab's bottom and top layers (the top layer becomes the next slab's bottom) and z edges for the
+// slab itself. New vertices go to `emit_vertex(const vertex&)`, which returns the index triangles use, and triangles go
+// to `emit_triangle(const std::array<std::uint32_t, 3>&)` in counter-clockwise order. Normals interpolate the density
+// gradient at the edge ends, taken from `gradient(lattice, point)`, so shared vertices shade smoothly. `extent` counts
+// cells, and positions are scaled by `cell_size`.
+template <typename RowSampler, typename MaterialSampler, typename EmitVertex, typename EmitTriangle,
+    typename Gradient = lattice_gradients>
+void march_slabs(chunk_extent extent, RowSampler&& fill_row, MaterialSampler& material_sampler,
+    const marching_cubes_config& config, mesher_scratch& scratch, EmitVertex&& emit_vertex,
+    EmitTriangle&& emit_triangle, float cell_size = 1.0f, const Gradient& gradient = {}) {
+    if (extent.x == 0 || extent.y == 0 || extent.z == 0) {
+        return;
+    }
+    density_slab_cache density{extent, scratch.density_slices};
+    const auto nx = density.points_x();
+    const auto slice_size = density.slice_size();
+
+    // Layout: x and y edges of layer 0, x and y edges of layer 1, z edges of the current slab.
+    auto& edge_cache = scratch.edge_vertices;
+    edge_cache.assign(slice_size * 5, no_cached_vertex);
+    const auto cached_vertex = [&](int axis, std::size_t point, std::size_t z_layer) -> std::uint32_t& {
+        if (axis == 2) {
+            return edge_cache[slice_size * 4 + point];
+        }
+        return edge_cache[slice_size * (2 * (z_layer & 1u) + static_cast<std::size_t>(axis)) + point];
+    };
+
+    const auto& edge_table = mc_edge_table;
+    const auto& triangle_table = mc_triangle_table;
+    std::array<std::uint32_t, 12> cell_vertices{};
+
+    for (std::size_t z = 0; z < extent.z; ++z) {
+        density.load_through(z + 2, fill_row);
+        if (z > 0) {
+            std::fill_n(edge_cache.begin() + static_cast<std::ptrdiff_t>(slice_size * 2 * ((z + 1) & 1u)),
+                slice_size * 2, no_cached_vertex);
+            std::fill_n(edge_cache.begin() + static_cast<std::ptrdiff_t>(slice_size * 4), slice_size,
+                no_cached_vertex);
+        }
+        const float* bottom = density.slice(z);
+        const float* top = density.slice(z + 1);
+
+        for (std::size_t y = 0; y < extent.y; ++y) {
+            for (std::size_t x = 0; x < extent.x; ++x) {
+                const std::size_t point = x + nx * y;
+                const std::array<float, 8> corner_values{bottom[point], bottom[point + 1], bottom[point + 1 + nx],
+                    bottom[point + nx], top[point], top[point + 1], top[point + 1 + nx], top[point + nx]};
+
+                int cube_index = 0;
+                for (int corner = 0; corner < 8; ++corner) {
+                    if (corner_values[static_cast<std::size_t>(corner)] < config.iso_value) {
+                        cube_index |= (1 << corner);
+                    }
+                }
+                const int edges = edge_table[cube_index];
+                if (edges == 0) {
+                    continue;
+                }
+
+                const voxel_id material = material_sampler(x, y, z);
+                for (std::size_t edge = 0; edge < cube_edges.size(); ++edge) {
+                    if ((edges & (1 << edge)) == 0) {
+                        continue;
+                    }
+                    const auto& [axis, ex, ey, ez] = cube_edges[edge];
+                    const std::array<std::size_t, 3> lo{x + static_cast<std::size_t>(ex),
+                        y + static_cast<std::size_t>(ey), z + static_cast<std::size_t>(ez)};
+                    auto& slot = cached_vertex(axis, lo[0] + nx * lo[1], lo[2]);
+                    if (slot == no_cached_vertex) {
+                        slot = emit_vertex(
+                            edge_vertex(density, lo, axis, config.iso_value, material, cell_size, gradient));
+                    }
+                    cell_vertices[edge] = slot;
+                }
+
+                for (int tri = 0; triangle_table[cube_index][tri] != -1; tri += 3) {
+                    const auto* corners = &triangle_table[cube_index][tri];
+                    emit_triangle(std::array<std::uint32_t, 3>{cell_vertices[static_cast<std::size_t>(corners[0])],
+                        cell_vertices[static_cast<std::size_t>(corners[2])],
+                        cell_vertices[static_cast<std::size_t>(corners[1])]});
+                }
+            }
+        }
+    }
+}
+
+// Appends indexed marching cubes output to a mesh_result.
+struct indexed_mesh_sink {
+    mesh_result& mesh;
+
+    std::uint32_t operator()(const vertex& v) const {
+        mesh.vertices.push_back(v);
+        return static_cast<std::uint32_t>(mesh.vertices.size() - 1);
+    }
+
+    void operator()(const std::array<std::uint32_t, 3>& triangle) const {
+        mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+    }
+};
+
+inline void append_triangle(mesh_result& result, const std::array<vertex, 3>& triangle) {
+    const auto base_index = static_cast<std::uint32_t>(result.vertices.size());
+    result.vertices.insert(result.vertices.end(), triangle.begin(), triangle.end());
+    result.indices.insert(result.indices.end(), {base_index, base_index + 1, base_index + 2});
+}
+
+template <typename DensitySampler, typename MaterialSampler, typename IndexedSink, typename Gradient>
+void march_indexed(chunk_extent extent, DensitySampler& density_sampler, MaterialSampler& material_sampler,
+    const marching_cubes_config& config, IndexedSink& sink, mesher_scratch& scratch, const Gradient& gradient) {
+    march_slabs(extent, row_sampler(density_sampler), material_sampler, config, scratch,
+        [&sink](const vertex& v) -> std::uint32_t { return sink(v); },
+        [&sink](const std::array<std::uint32_t, 3>& triangle) { sink(triangle); }, 1.0f, gradient);
+}
+
+template <typename DensitySampler, typename MaterialSampler, typename TriangleSink, typename Gradient>
+void march_triangles(chunk_extent extent, DensitySampler& density_sampler, MaterialSampler& material_sampler,
+    const marching_cubes_config& config, TriangleSink& sink, mesher_scratch& scratch, const Gradient& gradient) {
+    auto& shared = scratch.smooth_vertices;
+    shared.clear();
+    march_slabs(extent, row_sampler(density_sampler), material_sampler, config, scratch,
+        [&shared](const vertex& v) {
+            shared.push_back(v);
+            return static_cast<std::uint32_t>(shared.size() - 1);
+        },
+        [&](const std::array<std::uint32_t, 3>& triangle) {
+            sink(std::array<vertex, 3>{shared[triangle[0]], shared[triangle[1]], shared[triangle[2]]});
+        },
+        1.0f, gradient);
+}
+
+} // namespace detail
+
+// Indexed output: each surface vertex is emitted once through `std::uint32_t sink(const vertex&)`, which returns the
+// index the sink stored it at, and triangles follow as `sink(const std::array<std::uint32_t, 3>&)` in
+// counter-clockwise order. Cells share the vertices on their common edges, so meshes carry roughly a fifth of the
+// vertices of the triangle form, and the density sampler is called once per lattice point. span_mesh_sink and
+// packed_smooth_sink accept this form.
+template <typename DensitySampler, typename MaterialSampler, typename IndexedSink>
+void marching_cubes_indexed(chunk_extent extent, DensitySampler&& density_sampler,
+    MaterialSampler&& material_sampler, const marching_cubes_config& config, IndexedSink&& sink,
+    mesher_scratch& scratch) {
+    detail::march_indexed(extent, density_sampler, material_sampler, config, sink, scratch,
+        detail::lattice_gradients{});
+}
+
+template <typename DensitySampler, typename MaterialSampler, typename IndexedSink>
+void marching_cubes_indexed(chunk_extent extent, DensitySampler&& density_sampler,
+    MaterialSampler&& material_sampler, const marching_cubes_config& config, IndexedSink&& sink) {
+    mesher_scratch scratch;
+    marching_cubes_indexed(extent, std::forward<DensitySampler>(density_sampler),
+        std::forward<MaterialSampler>(material_sampler), config, std::forward<IndexedSink>(sink), scratch);
+}
+
+// Emits each triangle as three float vertices in counter-clockwise order to `sink(const std::array<vertex, 3>&)`,
+// for consumers that want unshared vertices; positions and normals match the indexed form.
+template <typename DensitySampler, typename MaterialSampler, typename TriangleSink>
+void marching_cubes_triangles(chunk_extent extent, DensitySampler&& density_sampler,
+    MaterialSampler&& material_sampler, const marching_cubes_config& config, TriangleSink&& sink,
+    mesher_scratch& scratch) {
+    detail::march_triangles(extent, density_sampler, material_sampler, config, sink, scratch,
+        detail::lattice_gradients{});
+}
+
+template <typename DensitySampler, typename MaterialSampler, typename TriangleSink>
+void marching_cubes_triangles(chunk_extent extent, DensitySampler&& density_sampler,
+    MaterialSampler&& material_sampler, const marching_cubes_config& config, TriangleSink&& sink) {
+    mesher_scratch scratch;
+    marching_cubes_triangles(extent, std::forward<DensitySampler>(density_sampler),
+        std::forward<MaterialSampler>(material_sampler), config, std::forward<TriangleSink>(sink), scratch);
+}
+
+template <typename DensitySampler, typename MaterialSampler>
+    requires std::is_invocable_v<MaterialSampler&, std::size_t, std::size_t, std::size_t>
+[[nodiscard]] mesh_result marching_cubes(chunk_extent extent, DensitySampler&& density_sampler,
+    MaterialSampler&& material_sampler, const marching_cubes_config& config = {}) {
+    mesh_result result;
+    marching_cubes_indexed(extent, std::forward<DensitySampler>(density_sampler),
+        std::forward<MaterialSampler>(material_sampler), config, detail::indexed_mesh_sink{result});
+    return result;
+}
+
+template <typename DensitySampler>
+[[nodiscard]] mesh_result marching_cubes(chunk_extent extent, DensitySampler&& density_sampler,
+    const marching_cubes_config& config = {}, voxel_id material = voxel_id{1}) {
+    auto material_sampler = [material](std::size_t, std::size_t, std::size_t) {
+        return material;
+    };
+    return marching_cubes(extent, std::forward<DensitySampler>(density_sampler), material_sampler, config);
+}
+
+namespace detail {
+
+// Shared set-up of the chunk entry points: pads the chunk's density with its neighbours in `scratch.density`, wide
+// enough for padded_gradients at lattice spacing `step`, and calls `march(const padded_grid<float>& density,
+// material_sampler)`, unless the chunk and its neighbours are uniformly empty.
+template <typename IsSolid, typename March>
+void march_chunk(const chunk_storage& chunk, IsSolid& is_solid, const chunk_neighborhood& neighborhood,
+    mesher_scratch& scratch, March&& march, std::size_t step = 1) {
+    // A uniform empty chunk surrounded by missing or uniform empty neighbors samples a constant density field.
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_solid(*uniform)) {
+        const bool flat = std::all_of(neighborhood.chunks.begin(), neighborhood.chunks.end(),
+            [&](const chunk_storage* neighbor) {
+                if (neighbor == nullptr) {
+                    return true;
+                }
+                const auto id = neighbor->uniform_voxel();
+                return id && !is_solid(*id);
+            });
+        if (flat) {
+            return;
+        }
+    }
+    span3d<const voxel_id> voxels{};
+    if (!uniform) {
+        voxels = chunk.read_voxels(scratch.voxels);
+    }
+
+    auto& density = scratch.density;
+    build_voxel_apron(chunk, neighborhood, density, [&](voxel_id id) { return is_solid(id) ? 0.0f : 1.0f; }, 1.0f,
+        padded_density_apron(step));
+
+    auto material_sampler = [&](std::size_t x, std::size_t y, std::size_t z) {
+        return uniform ? *uniform : voxels(x, y, z);
+    };
+    march(static_cast<const padded_grid<float>&>(density), material_sampler);
+}
+
+// Rows of the padded density grid, copied straight into the slab cache.
+[[nodiscard]] inline auto padded_density_rows(const padded_grid<float>& density) {
+    return density_rows{[&density](std::size_t y, std::size_t z, std::span<float> row) {
+        const auto* source = &density(0, static_cast<std::ptrdiff_t>(y), static_cast<std::ptrdiff_t>(z));
+        std::copy(source, source + row.size(), row.begin());
+    }};
+}
+
+} // namespace detail
+
+// Samples density from a padded copy of the chunk, so cells on chunk edges and corners see the diagonal neighbours in
+// `neighborhood` and the inner loop never leaves the grid. Normals use central differences across the seams too, so
+// vertices shared with a neighbour chunk shade identically in both. Missing neighbours read as empty. The padded
+// density grid and slab caches live in `scratch`.
+template <typename IsSolid, typename IndexedSink>
+void marching_cubes_indexed_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config, IndexedSink&& sink,
+    mesher_scratch& scratch) {
+    detail::march_chunk(chunk, is_solid, neighborhood, scratch, [&](const auto& density, auto& material_sampler) {
+        auto rows = detail::padded_density_rows(density);
+        detail::march_indexed(chunk.extent(), rows, material_sampler, config, sink, scratch,
+            detail::padded_gradients{&density});
+    });
+}
+
+template <typename IsSolid, typename IndexedSink>
+void marching_cubes_indexed_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config, IndexedSink&& sink) {
+    mesher_scratch scratch;
+    marching_cubes_indexed_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, config,
+        std::forward<IndexedSink>(sink), scratch);
+}
+
+template <typename IsSolid, typename TriangleSink>
+void marching_cubes_triangles_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config, TriangleSink&& sink,
+    mesher_scratch& scratch) {
+    detail::march_chunk(chunk, is_solid, neighborhood, scratch, [&](const auto& density, auto& material_sampler) {
+        auto rows = detail::padded_density_rows(density);
+        detail::march_triangles(chunk.extent(), rows, material_sampler, config, sink, scratch,
+            detail::padded_gradients{&density});
+    });
+}
+
+template <typename IsSolid, typename TriangleSink>
+void marching_cubes_triangles_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config, TriangleSink&& sink) {
+    mesher_scratch scratch;
+    marching_cubes_triangles_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, config,
+        std::forward<TriangleSink>(sink), scratch);
+}
+
+// Face neighbours only: cells on chunk edges and corners treat the missing diagonal neighbours as empty.
+template <typename IsSolid, typename TriangleSink>
+void marching_cubes_triangles_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighbors& neighbors, const marching_cubes_config& config, TriangleSink&& sink) {
+    marching_cubes_triangles_from_chunk(chunk, std::forward<IsSolid>(is_solid),
+        chunk_neighborhood::from_faces(neighbors), config, std::forward<TriangleSink>(sink));
+}
+
+template <typename IsSolid>
+[[nodiscard]] mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config = {}) {
+    mesh_result result;
+    marching_cubes_indexed_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, config,
+        detail::indexed_mesh_sink{result});
+    return result;
+}
+
+template <typename IsSolid>
+[[nodiscard]] mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighbors& neighbors, const marching_cubes_config& config = {}) {
+    return marching_cubes_from_chunk(chunk, std::forward<IsSolid>(is_solid), chunk_neighborhood::from_faces(neighbors),
+        config);
+}
+
+inline mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, const marching_cubes_config& config = {}) {
+    return marching_cubes_from_chunk(chunk, [](voxel_id id) { return id != voxel_id{}; }, chunk_neighbors{}, config);
+}
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/marching_cubes.hpp
+
+// begin: almond_voxel/meshing/marching_cubes_lod.hpp
+
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+inline constexpr std::uint8_t max_marching_cubes_lod = 3;
+
+// Level of detail for marching cubes. Level L meshes cells 2^L voxels wide from point samples of the density, so each
+// level cuts the triangles of smooth terrain about fourfold. `neighbor_levels` holds the levels of the six face
+// neighbours, indexed by block_face: a face next to a coarser neighbour is resampled from the neighbour's samples and
+// stitched to its surface, so chunks meshed at different levels meet without cracks. Levels are clamped to the largest
+// cell size that divides the chunk extent.
+struct marching_cubes_lod {
+    std::uint8_t level{0};
+    std::array<std::uint8_t, block_face_count> neighbor_levels{};
+};
+
+// Chooses levels from the Chebyshev distance, in chunks, between a chunk and the viewer.
+struct marching_cubes_lod_policy {
+    // Distances at which levels 1, 2 and 3 begin, ascending; 0 leaves a level unused. All zero keeps every chunk at
+    // full resolution.
+    std::array<std::uint32_t, max_marching_cubes_lod> level_distances{};
+
+    [[nodiscard]] bool enabled() const noexcept {
+        return std::any_of(level_distances.begin(), level_distances.end(), [](std::uint32_t d) { return d != 0; });
+    }
+
+    [[nodiscard]] std::uint8_t level(const region_key& key, const region_key& viewer) const noexcept {
+        const auto distance = std::max({std::llabs(static_cast<long long>(key.x) - viewer.x),
+            std::llabs(static_cast<long long>(key.y) - viewer.y),
+            std::llabs(static_cast<long long>(key.z) - viewer.z)});
+        std::uint8_t result = 0;
+        for (std::size_t i = 0; i < level_distances.size(); ++i) {
+            if (level_distances[i] != 0 && distance >= static_cast<long long>(level_distances[i])) {
+                result = static_cast<std::uint8_t>(i + 1);
+            }
+        }
+        return result;
+    }
+
+    // Level of `key` together with the levels of its face neighbours, ready to mesh with.
+    [[nodiscard]] marching_cubes_lod select(const region_key& key, const region_key& viewer) const noexcept {
+        marching_cubes_lod result{level(key, viewer), {}};
+        for (std::size_t face = 0; face < block_face_count; ++face) {
+            const auto f = static_cast<block_face>(face);
+            auto neighbor = key;
+            const auto sign = axis_sign(f);
+            switch (axis_of(f)) {
+            case axis::x: neighbor.x += sign; break;
+            case axis::y: neighbor.y += sign; break;
+            case axis::z: neighbor.z += sign; break;
+            }
+            result.neighbor_levels[face] = level(neighbor, viewer);
+        }
+        return result;
+    }
+};
+
+namespace detail {
+
+// Largest level not above `level` whose cell size divides every axis of `extent`.
+[[nodiscard]] inline std::uint8_t clamp_lod_level(chunk_extent extent, std::uint8_t level) noexcept {
+    level = std::min(level, max_marching_cubes_lod);
+    for (; level > 0; --level) {
+        const std::uint32_t step = 1u << level;
+        if (extent.x % step == 0 && extent.y % step == 0 && extent.z % step == 0) {
+            break;
+        }
+    }
+    return level;
+}
+
+// Dense lattice of (cells + 1)^3 density samples for one level of detail.
+class lod_lattice {
+public:
+    lod_lattice(const std::array<std::size_t, 3>& cells, std::vector<float>& storage)
+        : cells_{cells}, storage_{storage} {
+        storage_.resize((cells[0] + 1) * (cells[1] + 1) * (cells[2] + 1));
+    }
+
+    [[nodiscard]] float at(std::size_t x, std::size_t y, std::size_t z) const noexcept {
+        return storage_[index(x, y, z)];
+    }
+    [[nodiscard]] float& at(std::size_t x, std::size_t y, std::size_t z) noexcept { return storage_[index(x, y, z)]; }
+    [[nodiscard]] float at(const std::array<std::size_t, 3>& p) const noexcept { return at(p[0], p[1], p[2]); }
+    [[nodiscard]] float& at(const std::array<std::size_t, 3>& p) noexcept { return at(p[0], p[1], p[2]); }
+
+    [[nodiscard]] const std::array<std::size_t, 3>& cells() const noexcept { return cells_; }
+    [[nodiscard]] const std::array<std::size_t, 3>& limits() const noexcept { return cells_; }
+
+    // Rows for march_slabs.
+    [[nodiscard]] auto rows() const {
+        return [this](std::size_t y, std::size_t z, std::span<float> row) {
+            const auto* source = storage_.data() + index(0, y, z);
+            std::copy(source, source + row.size(), row.begin());
+        };
+    }
+
+private:
+    [[nodiscard]] std::size_t index(std::size_t x, std::size_t y, std::size_t z) const noexcept {
+        return x + (cells_[0] + 1) * (y + (cells_[1] + 1) * z);
+    }
+
+    std::array<std::size_t, 3> cells_;
+    std::vector<float>& storage_;
+};
+
+// Replaces the samples on one lattice face that a neighbour `ratio` times coarser does not have with the bilinear
+// interpolation of those it does have. Both sides then agree on where the surface crosses every coarse edge.
+inline void restrict_lod_face(lod_lattice& lattice, block_face face, std::size_t ratio) {
+    const auto axis = static_cast<std::size_t>(axis_of(face));
+    const auto u = (axis + 1) % 3;
+    const auto v = (axis + 2) % 3;
+    const auto& cells = lattice.cells();
+    std::array<std::size_t, 3> point{};
+    point[axis] = axis_sign(face) > 0 ? cells[axis] : 0;
+    const auto sample = [&](std::size_t pu, std::size_t pv) {
+        auto p = point;
+        p[u] = pu;
+        p[v] = pv;
+        return lattice.at(p);
+    };
+
+    for (std::size_t pv = 0; pv <= cells[v]; ++pv) {
+        for (std::size_t pu = 0; pu <= cells[u]; ++pu) {
+            const auto fu = pu % ratio;
+            const auto fv = pv % ratio;
+            if (fu == 0 && fv == 0) {
+                continue;
+            }
+            const auto u0 = pu - fu;
+            const auto v0 = pv - fv;
+            const auto u1 = fu != 0 ? u0 + ratio : u0;
+            const auto v1 = fv != 0 ? v0 + ratio : v0;
+            const float tu = static_cast<float>(fu) / static_cast<float>(ratio);
+            const float tv = static_cast<float>(fv) / static_cast<float>(ratio);
+            const float bottom = sample(u0, v0) + tu * (sample(u1, v0) - sample(u0, v0));
+            const float top = sample(u0, v1) + tu * (sample(u1, v1) - sample(u0, v1));
+            auto p = point;
+            p[u] = pu;
+            p[v] = pv;
+            lattice.at(p) = bottom + tv * (top - bottom);
+        }
+    }
+}
+
+// A coarser neighbour's view of the lattice: point q reads `sample` at lattice point q * ratio.
+template <typename Sample>
+struct coarse_lattice_view {
+    const Sample& sample;
+    std::size_t ratio;
+
+    [[nodiscard]] float at(std::size_t x, std::size_t y, std::size_t z) const {
+        return sample(std::array<std::size_t, 3>{x * ratio, y * ratio, z * ratio});
+    }
+};
+
+// Where a fine chain or a neighbour chord meets the border of a coarse face cell. `t` runs counter-clockwise round the
+// border in lattice steps from corner 0. Loops enter chains at their tail and chords at their head.
+struct lod_stitch_end {
+    float t{0.0f};
+    std::size_t element{0};
+    int side{0};
+    bool entry{false};
+    int link{-1};
+    vertex point{};
+};
+
+// Fills the cracks along one face restricted by restrict_lod_face. In each coarse face cell our surface crosses the
+// face along chains of fine segments, and the neighbour's along straight chords between its own samples, read through
+// `neighbor_sample(lattice_point)`. The gaps between them lie in the face plane: each is bounded by chains, chords
+// and stretches of the cell border, and is filled with a fan that faces from the solid side to the empty one.
+//
+// Chains are oriented with our solid side on their left and chords with the neighbour's, so walking a chain forwards
+// and a chord backwards keeps the gap on one side. Where a chain and a chord meet the border at the same point the
+// loop steps straight across; elsewhere it follows the border to the next crossing. The latter happens on chunk edges
+// where a coarser face neighbour restricted samples that this neighbour still reads unrestricted, so chunks three or
+// more levels apart around an edge still close. Fine saddle squares pair their crossings as marching cubes did in the
+// cell behind them; a coarse saddle is assumed to cut off its solid corners.
+template <typename NeighborSample, typename MaterialSampler, typename EmitVertex, typename EmitTriangle,
+    typename Gradient>
+void stitch_lod_face(const lod_lattice& lattice, const NeighborSample& neighbor_sample, block_face face,
+    std::size_t ratio, const marching_cubes_config& config, float cell_size, MaterialSampler& material_sampler,
+    EmitVertex& emit_vertex, EmitTriangle& emit_triangle, const Gradient& gradient, mesher_scratch& scratch) {
+    const auto axis = static_cast<std::size_t>(axis_of(face));
+    const auto u = (axis + 1) % 3;
+    const auto v = (axis + 2) % 3;
+    const auto& cells = lattice.cells();
+    std::array<std::size_t, 3> plane{};
+    plane[axis] = axis_sign(face) > 0 ? cells[axis] : 0;
+    const auto lattice_point = [&](std::size_t pu, std::size_t pv) {
+        auto p = plane;
+        p[u] = pu;
+        p[v] = pv;
+        return p;
+    };
+    const auto solid = [&](std::size_t pu, std::size_t pv) {
+        return lattice.at(lattice_point(pu, pv)) < config.iso_value;
+    };
+    // Square corners (0, 0), (1, 0), (1, 1), (0, 1) in (u, v); side k runs from corner k to corner k + 1.
+    constexpr std::array<std::array<std::size_t, 2>, 4> square_corners{{{0, 0}, {1, 0}, {1, 1}, {0, 1}}};
+    const auto square_mask = [&](std::size_t pu, std::size_t pv, std::size_t size) {
+        return int{solid(pu, pv)} | int{solid(pu + size, pv)} << 1 | int{solid(pu + size, pv + size)} << 2
+            | int{solid(pu, pv + size)} << 3;
+    };
+    // Directs a crossing between sides a and b so the solid corners of `mask` lie on its left, as {tail, head}.
+    const auto orient = [](int a, int b, int mask) {
+        return (mask >> ((a + 1) % 4) & 1) != 0 ? std::array<int, 2>{b, a} : std::array<int, 2>{a, b};
+    };
+
+    // A face edge is keyed by its lower lattice point and whether it runs along v.
+    const auto edge_key = [&](std::size_t pu, std::size_t pv, bool along_v) {
+        return (pv * (cells[u] + 1) + pu) * 2 + (along_v ? 1u : 0u);
+    };
+    const auto key_vertex = [&](std::size_t key) {
+        const bool along_v = (key & 1u) != 0;
+        const auto point = key / 2;
+        const auto lo = lattice_point(point % (cells[u] + 1), point / (cells[u] + 1));
+        std::array<std::size_t, 3> cell{};
+        for (std::size_t i = 0; i < 3; ++i) {
+            cell[i] = std::min(lo[i], cells[i] - 1);
+        }
+        return edge_vertex(lattice, lo, static_cast<int>(along_v ? v : u), config.iso_value,
+            material_sampler(cell[0], cell[1], cell[2]), cell_size, gradient);
+    };
+    const coarse_lattice_view<NeighborSample> coarse{neighbor_sample, ratio};
+    const auto coarse_gradient = [&](const auto&, const std::array<std::size_t, 3>& q) {
+        return gradient(lattice, std::array<std::size_t, 3>{q[0] * ratio, q[1] * ratio, q[2] * ratio});
+    };
+
+    // The cube behind a face square, and the face edges its marching cubes triangles cross it along.
+    const auto saddle_pairs = [&](std::size_t fu, std::size_t fv, const std::array<std::size_t, 4>& sides,
+                                  std::array<std::array<int, 2>, 2>& pairs) {
+        auto cube = lattice_point(fu, fv);
+        cube[axis] = plane[axis] == 0 ? 0 : plane[axis] - 1;
+        int cube_index = 0;
+        for (std::size_t corner = 0; corner < cube_corners.size(); ++corner) {
+            if (lattice.at(cube[0] + static_cast<std::size_t>(cube_corners[corner][0]),
+                    cube[1] + static_cast<std::size_t>(cube_corners[corner][1]),
+                    cube[2] + static_cast<std::size_t>(cube_corners[corner][2]))
+                < config.iso_value) {
+                cube_index |= 1 << corner;
+            }
+        }
+        const auto face_side = [&](int edge) {
+            const auto& [edge_axis, ex, ey, ez] = cube_edges[static_cast<std::size_t>(edge)];
+            const std::array<std::size_t, 3> lo{cube[0] + static_cast<std::size_t>(ex),
+                cube[1] + static_cast<std::size_t>(ey), cube[2] + static_cast<std::size_t>(ez)};
+            if (static_cast<std::size_t>(edge_axis) == axis || lo[axis] != plane[axis]) {
+                return -1;
+            }
+            const auto key = edge_key(lo[u], lo[v], static_cast<std::size_t>(edge_axis) == v);
+            return static_cast<int>(std::find(sides.begin(), sides.end(), key) - sides.begin());
+        };
+        // Triangle edges on the face that no second triangle shares are where the surface leaves the cube.
+        std::array<std::array<int, 2>, 8> found{};
+        std::size_t count = 0;
+        const auto& triangles = mc_triangle_table[static_cast<std::size_t>(cube_index)];
+        for (std::size_t tri = 0; triangles[tri] != -1; tri += 3) {
+            for (std::size_t e = 0; e < 3; ++e) {
+                const int a = face_side(triangles[tri + e]);
+                const int b = face_side(triangles[tri + (e + 1) % 3]);
+                if (a < 0 || b < 0 || a > 3 || b > 3 || a == b) {
+                    continue;
+                }
+                const std::array<int, 2> pair{std::min(a, b), std::max(a, b)};
+                const auto match = std::find(found.begin(), found.begin() + static_cast<std::ptrdiff_t>(count), pair);
+                if (match != found.begin() + static_cast<std::ptrdiff_t>(count)) {
+                    *match = found[--count];
+                } else if (count < found.size()) {
+                    found[count++] = pair;
+                }
+            }
+        }
+        if (count != 2) {
+            return false;
+        }
+        pairs = {found[0], found[1]};
+        return true;
+    };
+
+    // Side of the coarse cell at (cu, cv) a face edge lies on, or -1 inside it.
+    const auto border_side = [&](std::size_t key, std::size_t cu, std::size_t cv) {
+        const auto point = key / 2;
+        const auto pu = point % (cells[u] + 1);
+        const auto pv = point / (cells[u] + 1);
+        if ((key & 1u) == 0) {
+            return pv == cv ? 0 : pv == cv + ratio ? 2 : -1;
+        }
+        return pu == cu + ratio ? 1 : pu == cu ? 3 : -1;
+    };
+    const float perimeter = 4.0f * static_cast<float>(ratio);
+    const auto distance = [&](float from, float to, bool ccw) {
+        float d = ccw ? to - from : from - to;
+        return d < 0.0f ? d + perimeter : d;
+    };
+
+    auto& segments = scratch.lod_segments;
+    auto& polyline = scratch.lod_polyline;
+    auto& polygon = scratch.lod_polygon;
+    auto& indices = scratch.lod_polygon_indices;
+    constexpr std::size_t used = static_cast<std::size_t>(-1);
+    const auto emit_polygon = [&] {
+        if (polygon.size() < 3) {
+            return;
+        }
+        indices.clear();
+        for (const auto& corner : polygon) {
+            indices.push_back(emit_vertex(corner));
+        }
+        // Loops keep the gap on our solid side counter-clockwise in (u, v), and (u, v, axis) is right-handed, so
+        // loop order faces along the axis: away from us when our side is solid and towards us when it is empty.
+        for (std::size_t i = 1; i + 1 < indices.size(); ++i) {
+            if (axis_sign(face) > 0) {
+                emit_triangle(std::array<std::uint32_t, 3>{indices[0], indices[i], indices[i + 1]});
+            } else {
+                emit_triangle(std::array<std::uint32_t, 3>{indices[0], indices[i + 1], indices[i]});
+            }
+        }
+    };
+
+    for (std::size_t cv = 0; cv < cells[v]; cv += ratio) {
+        for (std::size_t cu = 0; cu < cells[u]; cu += ratio) {
+            std::array<std::size_t, 3> cell = lattice_point(cu, cv);
+            cell[axis] = std::min(cell[axis], cells[axis] - 1);
+            const voxel_id material = material_sampler(cell[0], cell[1], cell[2]);
+
+            // Our fine crossings, directed with our solid side on the left.
+            segments.clear();
+            for (std::size_t fv = cv; fv < cv + ratio; ++fv) {
+                for (std::size_t fu = cu; fu < cu + ratio; ++fu) {
+                    const int mask = square_mask(fu, fv, 1);
+                    if (mask == 0 || mask == 15) {
+                        continue;
+                    }
+                    const std::array<std::size_t, 4> sides{edge_key(fu, fv, false), edge_key(fu + 1, fv, true),
+                        edge_key(fu, fv + 1, false), edge_key(fu, fv, true)};
+                    std::array<std::array<int, 2>, 2> pairs{};
+                    std::size_t pair_count = 1;
+                    if (mask == 5 || mask == 10) {
+                        if (!saddle_pairs(fu, fv, sides, pairs)) {
+                            // Fall back to cutting off the solid corners.
+                            const int first = mask == 5 ? 0 : 1;
+                            pairs = {std::array<int, 2>{(first + 3) % 4, first},
+                                std::array<int, 2>{(first + 1) % 4, first + 2}};
+                        }
+                        pair_count = 2;
+                    } else {
+                        std::size_t found = 0;
+                        for (int side = 0; side < 4; ++side) {
+                            if ((mask >> side & 1) != (mask >> ((side + 1) % 4) & 1)) {
+                                pairs[0][found++] = side;
+                            }
+                        }
+                    }
+                    for (std::size_t p = 0; p < pair_count; ++p) {
+                        const auto directed = orient(pairs[p][0], pairs[p][1], mask);
+                        segments.push_back({sides[static_cast<std::size_t>(directed[0])],
+                            sides[static_cast<std::size_t>(directed[1])]});
+                    }
+                }
+            }
+
+            // The neighbour's corners and chords.
+            std::array<float, 4> neighbor_values{};
+            std::array<bool, 4> unrestricted{};
+            int neighbor_mask = 0;
+            for (std::size_t corner = 0; corner < 4; ++corner) {
+                const auto p = lattice_point(cu + square_corners[corner][0] * ratio,
+                    cv + square_corners[corner][1] * ratio);
+                neighbor_values[corner] = neighbor_sample(p);
+                unrestricted[corner] = neighbor_values[corner] == lattice.at(p);
+                neighbor_mask |= int{neighbor_values[corner] < config.iso_value} << corner;
+            }
+            if (segments.empty() && (neighbor_mask == 0 || neighbor_mask == 15)) {
+                continue;
+            }
+            std::array<std::array<int, 2>, 2> chords{};
+            std::size_t chord_count = 0;
+            if (neighbor_mask == 5 || neighbor_mask == 10) {
+                for (int corner = 0; corner < 4; ++corner) {
+                    if ((neighbor_mask >> corner & 1) != 0) {
+                        chords[chord_count++] = orient((corner + 3) % 4, corner, neighbor_mask);
+                    }
+                }
+            } else if (neighbor_mask != 0 && neighbor_mask != 15) {
+                std::array<int, 2> crossed{};
+                std::size_t found = 0;
+                for (int side = 0; side < 4; ++side) {
+                    if ((neighbor_mask >> side & 1) != (neighbor_mask >> ((side + 1) % 4) & 1)) {
+                        crossed[found++] = side;
+                    }
+                }
+                chords[chord_count++] = orient(crossed[0], crossed[1], neighbor_mask);
+            }
+
+            // Chain our segments from the border; what is left over are closed islands.
+            std::array<std::array<std::size_t, 2>, 4> chains{};
+            std::size_t chain_count = 0;
+            bool broken = false;
+            polyline.clear();
+            for (auto& start : segments) {
+                if (start[0] == used || border_side(start[0], cu, cv) < 0) {
+                    continue;
+                }
+                if (chain_count == chains.size()) {
+                    broken = true;
+                    break;
+                }
+                const auto begin = polyline.size();
+                polyline.push_back(start[0]);
+                auto* segment = &start;
+                while (true) {
+                    const auto head = (*segment)[1];
+                    polyline.push_back(head);
+                    (*segment)[0] = used;
+                    if (border_side(head, cu, cv) >= 0) {
+                        break;
+                    }
+                    const auto next = std::find_if(
+                        segments.begin(), segments.end(), [head](const auto& s) { return s[0] == head; });
+                    if (next == segments.end()) {
+                        broken = true;
+                        break;
+                    }
+                    segment = &*next;
+                }
+                chains[chain_count++] = {begin, polyline.size()};
+            }
+            if (broken) {
+                continue;
+            }
+
+            // Ends on the border: chains 0..3, chords 4 and 5.
+            std::array<lod_stitch_end, 12> ends{};
+            std::size_t end_count = 0;
+            std::array<int, 4> our_side_end{-1, -1, -1, -1};
+            for (std::size_t c = 0; c < chain_count; ++c) {
+                for (const bool entry : {true, false}) {
+                    const auto key = entry ? polyline[chains[c][0]] : polyline[chains[c][1] - 1];
+                    const int side = border_side(key, cu, cv);
+                    if (our_side_end[static_cast<std::size_t>(side)] >= 0) {
+                        broken = true;
+                    }
+                    our_side_end[static_cast<std::size_t>(side)] = static_cast<int>(end_count);
+                    ends[end_count++] = {0.0f, c, side, entry, -1, key_vertex(key)};
+                }
+            }
+            if (broken) {
+                continue;
+            }
+            for (std::size_t c = 0; c < chord_count; ++c) {
+                for (const bool entry : {true, false}) {
+                    const int side = chords[c][entry ? 1 : 0];
+                    const auto s = static_cast<std::size_t>(side);
+                    auto& end = ends[end_count];
+                    end = {0.0f, 4 + c, side, entry, -1, {}};
+                    const int ours = our_side_end[s];
+                    if (ours >= 0 && unrestricted[s] && unrestricted[(s + 1) % 4]) {
+                        // Same samples on this side, so the same crossing.
+                        end.link = ours;
+                        end.point = ends[static_cast<std::size_t>(ours)].point;
+                        ends[static_cast<std::size_t>(ours)].link = static_cast<int>(end_count);
+                    } else {
+                        // The neighbour interpolates along the whole side, from its lower end.
+                        auto lo = lattice_point(cu + (side == 1 ? ratio : 0), cv + (side == 2 ? ratio : 0));
+                        for (auto& coordinate : lo) {
+                            coordinate /= ratio;
+                        }
+                        end.point = edge_vertex(coarse, lo, static_cast<int>(side % 2 == 0 ? u : v), config.iso_value,
+                            material, cell_size * static_cast<float>(ratio), coarse_gradient);
+                    }
+                    ++end_count;
+                }
+            }
+            for (std::size_t e = 0; e < end_count; ++e) {
+                const auto& position = ends[e].point.position;
+                const float pu = position[u] / cell_size - static_cast<float>(cu);
+                const float pv = position[v] / cell_size - static_cast<float>(cv);
+                const float r = static_cast<float>(ratio);
+                const std::array<float, 4> along{pu, r + pv, 3.0f * r - pu, 4.0f * r - pv};
+                ends[e].t = along[static_cast<std::size_t>(ends[e].side)];
+            }
+
+            // Whether our side (`ours`) or the neighbour's is solid just counter-clockwise of `t`: the next end of
+            // that kind is a chain tail or chord tail exactly when it is.
+            const auto solid_after = [&](float t, bool ours) {
+                float nearest = perimeter + 1.0f;
+                bool result = ours ? (square_mask(cu, cv, ratio) & 1) != 0 : (neighbor_mask & 1) != 0;
+                for (std::size_t e = 0; e < end_count; ++e) {
+                    if ((ends[e].element < 4) != ours) {
+                        continue;
+                    }
+                    float d = distance(t, ends[e].t, true);
+                    d = d > 0.0f ? d : perimeter;
+                    if (d < nearest) {
+                        nearest = d;
+                        result = ours ? ends[e].entry : !ends[e].entry;
+                    }
+                }
+                return result;
+            };
+            const auto append_element = [&](std::size_t element, bool skip_first) {
+                if (element < 4) {
+                    for (auto i = chains[element][0] + (skip_first ? 1 : 0); i < chains[element][1]; ++i) {
+                        polygon.push_back(key_vertex(polyline[i]));
+                    }
+                    return;
+                }
+                for (std::size_t e = 0; e < end_count; ++e) {
+                    if (ends[e].element == element && ends[e].entry && !skip_first) {
+                        polygon.push_back(ends[e].point);
+                    }
+                }
+                for (std::size_t e = 0; e < end_count; ++e) {
+                    if (ends[e].element == element && !ends[e].entry) {
+                        polygon.push_back(ends[e].point);
+                    }
+                }
+            };
+            const auto exit_of = [&](std::size_t element) {
+                std::size_t e = 0;
+                while (ends[e].element != element || ends[e].entry) {
+                    ++e;
+                }
+                return e;
+            };
+
+            std::array<bool, 6> visited{};
+            for (std::size_t start = 0; start < 6; ++start) {
+                if ((start < 4 ? start >= chain_count : start - 4 >= chord_count) || visited[start]) {
+                    continue;
+                }
+                polygon.clear();
+                auto element = start;
+                bool skip_first = false;
+                bool closed = false;
+                for (std::size_t guard = 0; guard < visited.size() && !visited[element]; ++guard) {
+                    visited[element] = true;
+                    append_element(element, skip_first);
+                    const auto& exit = ends[exit_of(element)];
+                    std::size_t next = end_count;
+                    if (exit.link >= 0) {
+                        next = static_cast<std::size_t>(exit.link);
+                        skip_first = true;
+                    } else {
+                        // Follow the border the way the gap lies, turning the cell corners on the way.
+                        const bool ccw = exit.element < 4 ? !solid_after(exit.t, false) : solid_after(exit.t, true);
+                        float nearest = perimeter + 1.0f;
+                        for (std::size_t e = 0; e < end_count; ++e) {
+                            const float d = distance(exit.t, ends[e].t, ccw);
+                            if (&ends[e] != &exit && d < nearest) {
+                                nearest = d;
+                                next = e;
+                            }
+                        }
+                        if (next == end_count || !ends[next].entry) {
+                            break;
+                        }
+                        std::array<std::pair<float, std::size_t>, 4> turns{};
+                        std::size_t turn_count = 0;
+                        for (std::size_t corner = 0; corner < 4; ++corner) {
+                            const float d = distance(exit.t, static_cast<float>(corner * ratio), ccw);
+                            if (d > 0.0f && d < nearest) {
+                                turns[turn_count++] = {d, corner};
+                            }
+                        }
+                        std::sort(turns.begin(), turns.begin() + static_cast<std::ptrdiff_t>(turn_count));
+                        for (std::size_t i = 0; i < turn_count; ++i) {
+                            const auto p = lattice_point(cu + square_corners[turns[i].second][0] * ratio,
+                                cv + square_corners[turns[i].second][1] * ratio);
+                            const auto g = gradient(lattice, p);
+                            const float length = std::sqrt(g[0] * g[0] + g[1] * g[1] + g[2] * g[2]);
+                            std::array<float, 3> normal{};
+                            normal[axis] = static_cast<float>(axis_sign(face));
+                            if (length > 1e-6f) {
+                                normal = {g[0] / length, g[1] / length, g[2] / length};
+                            }
+                            const std::array<float, 3> position{static_cast<float>(p[0]) * cell_size,
+                                static_cast<float>(p[1]) * cell_size, static_cast<float>(p[2]) * cell_size};
+                            polygon.push_back(vertex{position, normal, {position[0], position[1]}, material});
+                        }
+                        skip_first = false;
+                    }
+                    element = ends[next].element;
+                    closed = element == start;
+                }
+                if (closed) {
+                    if (skip_first) {
+                        // Closed across a shared crossing, which already opens the polygon.
+                        polygon.pop_back();
+                    }
+                    emit_polygon();
+                }
+            }
+
+            // An island of one side inside the other gaps against the neighbour wherever the neighbour has no chord,
+            // since then it sees the island's surroundings throughout.
+            for (auto& start : segments) {
+                if (start[0] == used) {
+                    continue;
+                }
+                polygon.clear();
+                const auto first = start[0];
+                auto* segment = &start;
+                bool closed = false;
+                while ((*segment)[0] != used) {
+                    polygon.push_back(key_vertex((*segment)[0]));
+                    const auto head = (*segment)[1];
+                    (*segment)[0] = used;
+                    if (head == first) {
+                        closed = true;
+                        break;
+                    }
+                    const auto next = std::find_if(
+                        segments.begin(), segments.end(), [head](const auto& s) { return s[0] == head; });
+                    if (next == segments.end()) {
+                        break;
+                    }
+                    segment = &*next;
+                }
+                if (!closed || chord_count != 0) {
+                    continue;
+                }
+                float area = 0.0f;
+                for (std::size_t i = 0; i < polygon.size(); ++i) {
+                    const auto& a = polygon[i].position;
+                    const auto& b = polygon[(i + 1) % polygon.size()].position;
+                    area += a[u] * b[v] - a[v] * b[u];
+                }
+                // Counter-clockwise islands are solid on our side.
+                if ((area > 0.0f) != (neighbor_mask == 15)) {
+                    emit_polygon();
+                }
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+// Meshes `chunk` at `lod.level` with the neighbour-aware sampling of marching_cubes_indexed_from_chunk. Positions stay
+// in voxel units, so chunks at any level line up. Faces next to coarser neighbours are restricted and stitched as
+// described on marching_cubes_lod; finer neighbours stitch to this chunk themselves.
+template <typename IsSolid, typename IndexedSink>
+void marching_cubes_lod_indexed_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_lod& lod, const marching_cubes_config& config,
+    IndexedSink&& sink, mesher_scratch& scratch) {
+    const auto extent = chunk.extent();
+    const auto level = detail::clamp_lod_level(extent, lod.level);
+    const std::size_t step = std::size_t{1} << level;
+    detail::march_chunk(
+        chunk, is_solid, neighborhood, scratch,
+        [&](const padded_grid<float>& density, auto& material_sampler) {
+            detail::lod_lattice lattice{{extent.x / step, extent.y / step, extent.z / step}, scratch.lod_density};
+            const auto& cells = lattice.cells();
+            for (std::size_t z = 0; z <= cells[2]; ++z) {
+                for (std::size_t y = 0; y <= cells[1]; ++y) {
+                    for (std::size_t x = 0; x <= cells[0]; ++x) {
+                        lattice.at(x, y, z) = density(static_cast<std::ptrdiff_t>(x * step),
+                            static_cast<std::ptrdiff_t>(y * step), static_cast<std::ptrdiff_t>(z * step));
+                    }
+                }
+            }
+
+            // Coarser faces, coarsest first, so the coarsest neighbour decides the samples on shared chunk edges and
+            // finer faces interpolate from those; a finer face restricted first would keep samples beside the edge
+            // that the coarser face then moved out from under it.
+            std::array<std::pair<std::size_t, block_face>, block_face_count> coarser{};
+            std::size_t coarser_count = 0;
+            for (std::size_t face = 0; face < block_face_count; ++face) {
+                const auto neighbor_level = detail::clamp_lod_level(extent, lod.neighbor_levels[face]);
+                if (neighbor_level > level) {
+                    coarser[coarser_count++] = {std::size_t{1} << (neighbor_level - level),
+                        static_cast<block_face>(face)};
+                }
+            }
+            std::sort(coarser.begin(), coarser.begin() + static_cast<std::ptrdiff_t>(coarser_count),
+                [](const auto& a, const auto& b) { return a.first > b.first; });
+            for (std::size_t i = 0; i < coarser_count; ++i) {
+                detail::restrict_lod_face(lattice, coarser[i].second, coarser[i].first);
+            }
+
+            auto lod_material = [&](std::size_t x, std::size_t y, std::size_t z) {
+                return material_sampler(x * step, y * step, z * step);
+            };
+            auto emit_vertex = [&sink](const vertex& v) -> std::uint32_t { return sink(v); };
+            auto emit_triangle = [&sink](const std::array<std::uint32_t, 3>& triangle) { sink(triangle); };
+            const auto cell_size = static_cast<float>(step);
+            const detail::padded_gradients gradient{&density, static_cast<std::ptrdiff_t>(step)};
+            // Coarser neighbours sample the density itself, not our restricted lattice.
+            const auto neighbor_sample = [&](const std::array<std::size_t, 3>& p) {
+                return density(static_cast<std::ptrdiff_t>(p[0] * step), static_cast<std::ptrdiff_t>(p[1] * step),
+                    static_cast<std::ptrdiff_t>(p[2] * step));
+            };
+            detail::march_slabs(chunk_extent{static_cast<std::uint32_t>(cells[0]),
+                                    static_cast<std::uint32_t>(cells[1]), static_cast<std::uint32_t>(cells[2])},
+                lattice.rows(), lod_material, config, scratch, emit_vertex, emit_triangle, cell_size, gradient);
+            for (std::size_t i = 0; i < coarser_count; ++i) {
+                detail::stitch_lod_face(lattice, neighbor_sample, coarser[i].second, coarser[i].first, config,
+                    cell_size, lod_material, emit_vertex, emit_triangle, gradient, scratch);
+            }
+        },
+        step);
+}
+
+template <typename IsSolid>
+[[nodiscard]] mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_lod& lod, const marching_cubes_config& config = {}) {
+    mesh_result result;
+    mesher_scratch scratch;
+    marching_cubes_lod_indexed_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, lod, config,
+        detail::indexed_mesh_sink{result}, scratch);
+    return result;
+}
+
+inline mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    const marching_cubes_lod& lod, const marching_cubes_config& config = {}) {
+    return marching_cubes_from_chunk(chunk, [](voxel_id id) { return id != voxel_id{}; }, neighborhood, lod, config);
+}
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/marching_cubes_lod.hpp
+
+// begin: almond_voxel/meshing/naive_mesher.hpp
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+namespace detail {
+
+struct naive_face_definition {
+    std::array<std::array<float, 3>, 4> corners;
+    std::array<std::array<float, 2>, 4> uvs;
+};
+
+[[nodiscard]] constexpr naive_face_definition make_face(
+    std::array<std::array<float, 3>, 4> corners,
+    std::array<std::array<float, 2>, 4> uvs) noexcept {
+    return naive_face_definition{corners, uvs};
+}
+
+constexpr std::array<naive_face_definition, block_face_count> naive_face_definitions{{
+    make_face({{{1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 0.0f, 1.0f}}},
+        {{{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}}}),
+    make_face({{{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 1.0f}, {0.0f, 1.0f, 0.0f}}},
+        {{{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}}}),
+    make_face({{{0.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 0.0f}}},
+        {{{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}}}),
+    make_face({{{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}}},
+        {{{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}}}),
+    make_face({{{0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f, 1.0f}}},
+        {{{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}}}),
+    make_face({{{0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}},
+        {{{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}}}),
+}};
+
+constexpr std::array<block_face, block_face_count> naive_faces{{
+    block_face::pos_x,
+    block_face::neg_x,
+    block_face::pos_y,
+    block_face::neg_y,
+    block_face::pos_z,
+    block_face::neg_z,
+}};
+
+// `shade(face, x, y, z)` returns the corner shades of one voxel face.
+template <typename IsOpaque, typename NeighborOpaque, typename Shade, typename QuadSink>
+void naive_quads(const chunk_storage& chunk, IsOpaque&& is_opaque, NeighborOpaque&& neighbor_opaque,
+    const Shade& shade, QuadSink&& sink, mesher_scratch& scratch) {
+    const auto extent = chunk.extent();
+
+    // Uniform chunks never expose interior faces, so only their boundary shell is visited.
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_opaque(*uniform)) {
+        return;
+    }
+    span3d<const voxel_id> voxels{};
+    if (!uniform) {
+        voxels = chunk.read_voxels(scratch.voxels);
+    }
+    const auto sample = [&](std::size_t x, std::size_t y, std::size_t z) {
+        return uniform ? *uniform : voxels(x, y, z);
+    };
+
+    for (std::uint32_t z = 0; z < extent.z; ++z) {
+        for (std::uint32_t y = 0; y < extent.y; ++y) {
+            const bool interior_row = uniform && z > 0 && z + 1 < extent.z && y > 0 && y + 1 < extent.y;
+            const std::uint32_t x_step = interior_row && extent.x > 1 ? extent.x - 1 : 1;
+            for (std::uint32_t x = 0; x < extent.x; x += x_step) {
+                const voxel_id id = sample(x, y, z);
+                if (!is_opaque(id)) {
+                    continue;
+                }
+
+                for (const block_face face : detail::naive_faces) {
+                    std::array<std::ptrdiff_t, 3> neighbor_coord{
+                        static_cast<std::ptrdiff_t>(x),
+                        static_cast<std::ptrdiff_t>(y),
+                        static_cast<std::ptrdiff_t>(z),
+                    };
+                    const auto normal_i = face_normal(face);
+                    neighbor_coord[0] += normal_i[0];
+                    neighbor_coord[1] += normal_i[1];
+                    neighbor_coord[2] += normal_i[2];
+
+                    bool neighbor_solid = false;
+                    const bool neighbor_inside = neighbor_coord[0] >= 0
+                        && neighbor_coord[0] < static_cast<std::ptrdiff_t>(extent.x)
+                        && neighbor_coord[1] >= 0
+                        && neighbor_coord[1] < static_cast<std::ptrdiff_t>(extent.y)
+                        && neighbor_coord[2] >= 0
+                        && neighbor_coord[2] < static_cast<std::ptrdiff_t>(extent.z);
+                    if (neighbor_inside) {
+                        neighbor_solid = is_opaque(sample(static_cast<std::size_t>(neighbor_coord[0]),
+                            static_cast<std::size_t>(neighbor_coord[1]), static_cast<std::size_t>(neighbor_coord[2])));
+                    } else {
+                        neighbor_solid = neighbor_opaque(neighbor_coord);
+                    }
+
+                    if (neighbor_solid) {
+                        continue;
+                    }
+
+                    sink(quad{face, {x, y, z}, 1, 1, id, shade(face, x, y, z)});
+                }
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+// Emits one unit quad per visible voxel face to `sink(const quad&)`.
+template <typename IsOpaque, typename NeighborOpaque, typename QuadSink>
+void naive_quads_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque, NeighborOpaque&& neighbor_opaque,
+    QuadSink&& sink) {
+    mesher_scratch scratch;
+    detail::naive_quads(chunk, std::forward<IsOpaque>(is_opaque), std::forward<NeighborOpaque>(neighbor_opaque),
+        detail::no_shading{}, std::forward<QuadSink>(sink), scratch);
+}
+
+namespace detail {
+
+// Index into quad::shade of definition corner `corner`, found from its position along the face's u and v axes.
+[[nodiscard]] constexpr std::size_t naive_shade_corner(block_face face, std::size_t corner) noexcept {
+    const auto axis = static_cast<std::size_t>(axis_of(face));
+    const auto& position = naive_face_definitions[static_cast<std::size_t>(face)].corners[corner];
+    const bool u = position[(axis + 1) % 3] > 0.5f;
+    const bool v = position[(axis + 2) % 3] > 0.5f;
+    return u ? (v ? 2 : 1) : (v ? 3 : 0);
+}
+
+inline void append_naive_face(mesh_result& result, const quad& face) {
+    const auto& definition = naive_face_definitions[static_cast<std::size_t>(face.face)];
+    const auto normal_i = face_normal(face.face);
+    const std::array<float, 3> normal{
+        static_cast<float>(normal_i[0]),
+        static_cast<float>(normal_i[1]),
+        static_cast<float>(normal_i[2]),
+    };
+
+    const auto base_index = static_cast<std::uint32_t>(result.vertices.size());
+    for (std::size_t i = 0; i < definition.corners.size(); ++i) {
+        vertex v{};
+        v.position = {
+            static_cast<float>(face.origin[0]) + definition.corners[i][0],
+            static_cast<float>(face.origin[1]) + definition.corners[i][1],
+            static_cast<float>(face.origin[2]) + definition.corners[i][2],
+        };
+        v.normal = normal;
+        v.uv = definition.uvs[i];
+        v.id = face.id;
+        v.shade = face.shade[naive_shade_corner(face.face, i)];
+        result.vertices.push_back(v);
+    }
+
+    // Cut along the brighter diagonal so occlusion interpolates evenly; the winding is unchanged.
+    const auto* corners = result.vertices.data() + base_index;
+    if (corners[0].shade.occlusion + corners[2].shade.occlusion
+        > corners[1].shade.occlusion + corners[3].shade.occlusion) {
+        result.indices.insert(result.indices.end(),
+            {base_index + 1, base_index + 2, base_index + 3, base_index + 1, base_index + 3, base_index});
+        return;
+    }
+    result.indices.insert(result.indices.end(),
+        {base_index, base_index + 1, base_index + 2, base_index, base_index + 2, base_index + 3});
+}
+
+} // namespace detail
+
+template <typename IsOpaque, typename NeighborOpaque>
+[[nodiscard]] mesh_result naive_mesh_with_neighbors(const chunk_storage& chunk, IsOpaque&& is_opaque,
+    NeighborOpaque&& neighbor_opaque) {
+    mesh_result result;
+    naive_quads_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), std::forward<NeighborOpaque>(neighbor_opaque),
+        [&result](const quad& face) { detail::append_naive_face(result, face); });
+    return result;
+}
+
+// Meshes against all 26 neighbours and bakes the lighting requested in `lighting` into each quad's shade. Padded grids
+// live in `scratch`.
+template <typename IsOpaque, typename QuadSink>
+void naive_quads_with_neighborhood(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting, QuadSink&& sink, mesher_scratch& scratch) {
+    const auto uniform = chunk.uniform_voxel();
+    if (uniform && !is_opaque(*uniform)) {
+        return;
+    }
+    // Unlit meshing only samples the apron; ambient occlusion also reads the centre cells.
+    auto& opacity = scratch.opacity;
+    detail::build_opacity_apron(chunk, neighborhood, is_opaque, opacity, lighting.enabled());
+    auto neighbor_sampler = [&opacity](const std::array<std::ptrdiff_t, 3>& coord) {
+        return opacity(coord[0], coord[1], coord[2]) != 0;
+    };
+
+    if (!lighting.enabled()) {
+        detail::naive_quads(chunk, is_opaque, neighbor_sampler, detail::no_shading{}, std::forward<QuadSink>(sink),
+            scratch);
+        return;
+    }
+    const auto shader = detail::prepare_face_shader(chunk, neighborhood, lighting, scratch);
+    detail::naive_quads(chunk, is_opaque, neighbor_sampler, shader, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result naive_mesh_with_neighborhood(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, IsOpaque&& is_opaque, const mesh_lighting_config& lighting = {}) {
+    mesh_result result;
+    mesher_scratch scratch;
+    naive_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [&result](const quad& face) { detail::append_naive_face(result, face); }, scratch);
+    return result;
+}
+
+inline mesh_result naive_mesh_with_neighborhood(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    const mesh_lighting_config& lighting = {}) {
+    return naive_mesh_with_neighborhood(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; }, lighting);
+}
+
+template <typename IsOpaque, typename QuadSink>
+void naive_quads_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque, QuadSink&& sink) {
+    mesher_scratch scratch;
+    naive_quads_with_neighborhood(chunk, chunk_neighborhood::from_faces(neighbors), std::forward<IsOpaque>(is_opaque),
+        mesh_lighting_config{}, std::forward<QuadSink>(sink), scratch);
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result naive_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque) {
+    mesh_result result;
+    naive_quads_with_neighbor_chunks(chunk, neighbors, std::forward<IsOpaque>(is_opaque),
+        [&result](const quad& face) { detail::append_naive_face(result, face); });
+    return result;
+}
+
+inline mesh_result naive_mesh_with_neighbor_chunks(const chunk_storage& chunk, const chunk_neighbors& neighbors) {
+    return naive_mesh_with_neighbor_chunks(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+template <typename IsOpaque>
+[[nodiscard]] mesh_result naive_mesh(const chunk_storage& chunk, IsOpaque&& is_opaque) {
+    auto neighbor = [](const std::array<std::ptrdiff_t, 3>&) { return false; };
+    return naive_mesh_with_neighbors(chunk, std::forward<IsOpaque>(is_opaque), neighbor);
+}
+
+inline mesh_result naive_mesh(const chunk_storage& chunk) {
+    return naive_mesh(chunk, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/naive_mesher.hpp
+
+// begin: almond_voxel/meshing/packed_mesh.hpp
+
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+// Blocky vertex in 8 bytes. position_face holds x, y and z in bits 0-6, 7-13 and 14-20 (0..64, in voxels from the
+// chunk origin), the block_face in bits 21-23 and the vertex_shade occlusion in bits 24-25; bits 26-31 are zero.
+// Smooth light is not packed. uv_id holds the quad-relative u and v in bits 0-6 and 7-13 and the voxel id in bits
+// 16-31. The normal follows from the face. Unlike append_quad, z faces carry no bias; renderers that stack chunks
+// vertically apply it in the shader.
+struct packed_vertex {
+    std::uint32_t position_face{0};
+    std::uint32_t uv_id{0};
+
+    [[nodiscard]] constexpr std::uint32_t x() const noexcept { return position_face & 0x7Fu; }
+    [[nodiscard]] constexpr std::uint32_t y() const noexcept { return (position_face >> 7u) & 0x7Fu; }
+    [[nodiscard]] constexpr std::uint32_t z() const noexcept { return (position_face >> 14u) & 0x7Fu; }
+    [[nodiscard]] constexpr block_face face() const noexcept {
+        return static_cast<block_face>((position_face >> 21u) & 0x7u);
+    }
+    [[nodiscard]] constexpr std::uint32_t occlusion() const noexcept { return (position_face >> 24u) & 0x3u; }
+    [[nodiscard]] constexpr std::uint32_t u() const noexcept { return uv_id & 0x7Fu; }
+    [[nodiscard]] constexpr std::uint32_t v() const noexcept { return (uv_id >> 7u) & 0x7Fu; }
+    [[nodiscard]] constexpr voxel_id id() const noexcept { return static_cast<voxel_id>(uv_id >> 16u); }
+};
+
+// One face rectangle per instance for vertex-pulling renderers, which expand the four corners in the shader, so no
+// index buffer is needed. origin_face holds the origin x, y and z in bits 0-5, 6-11 and 12-17, the block_face in
+// bits 18-20 and the occlusion of corners 0-3 in two bits each from bit 21. size_id holds width - 1 and height - 1 in
+// bits 0-5 and 6-11 and the voxel id in bits 16-31.
+struct packed_quad {
+    std::uint32_t origin_face{0};
+    std::uint32_t size_id{0};
+
+    [[nodiscard]] constexpr std::uint32_t x() const noexcept { return origin_face & 0x3Fu; }
+    [[nodiscard]] constexpr std::uint32_t y() const noexcept { return (origin_face >> 6u) & 0x3Fu; }
+    [[nodiscard]] constexpr std::uint32_t z() const noexcept { return (origin_face >> 12u) & 0x3Fu; }
+    [[nodiscard]] constexpr block_face face() const noexcept {
+        return static_cast<block_face>((origin_face >> 18u) & 0x7u);
+    }
+    [[nodiscard]] constexpr std::uint32_t occlusion(std::size_t corner) const noexcept {
+        return (origin_face >> (21u + 2u * static_cast<std::uint32_t>(corner))) & 0x3u;
+    }
+    [[nodiscard]] constexpr std::uint32_t width() const noexcept { return (size_id & 0x3Fu) + 1u; }
+    [[nodiscard]] constexpr std::uint32_t height() const noexcept { return ((size_id >> 6u) & 0x3Fu) + 1u; }
+    [[nodiscard]] constexpr voxel_id id() const noexcept { return static_cast<voxel_id>(size_id >> 16u); }
+};
+
+// Smooth-surface vertex in 12 bytes: position in 1/256 voxel fixed point (up to 255 voxels per axis), octahedral
+// normal in two snorm8 components, and the voxel id.
+struct packed_smooth_vertex {
+    std::array<std::uint16_t, 3> position{};
+    std::array<std::int8_t, 2> normal{};
+    voxel_id id{0};
+    std::uint16_t reserved{0};
+
+    [[nodiscard]] std::array<float, 3> unpack_position() const noexcept;
+    [[nodiscard]] std::array<float, 3> unpack_normal() const noexcept;
+};
+
+static_assert(sizeof(packed_vertex) == 8, "packed_vertex must stay 8 bytes");
+static_assert(sizeof(packed_quad) == 8, "packed_quad must stay 8 bytes");
+static_assert(sizeof(packed_smooth_vertex) == 12, "packed_smooth_vertex must stay 12 bytes");
+
+inline constexpr float smooth_position_scale = 256.0f;
+
+struct packed_mesh {
+    std::vector<packed_vertex> vertices;
+    std::vector<std::uint32_t> indices;
+};
+
+struct packed_smooth_mesh {
+    std::vector<packed_smooth_vertex> vertices;
+    std::vector<std::uint32_t> indices;
+};
+
+// Corners in the same order and winding as append_quad. Throws std::out_of_range for quads outside a 64³ chunk.
+[[nodiscard]] inline std::array<packed_vertex, 4> pack_quad_vertices(const quad& q) {
+    const std::size_t axis = static_cast<std::size_t>(axis_of(q.face));
+    const std::size_t u_axis = (axis + 1) % 3;
+    const std::size_t v_axis = (axis + 2) % 3;
+    auto base = q.origin;
+    base[axis] += axis_sign(q.face) > 0 ? 1u : 0u;
+    if (base[axis] > 64 || base[u_axis] + q.width > 64 || base[v_axis] + q.height > 64) {
+        throw std::out_of_range("quad exceeds the packed vertex range");
+    }
+
+    const std::array<std::array<std::uint32_t, 2>, 4> offsets{{{0, 0}, {q.width, 0}, {q.width, q.height}, {0, q.height}}};
+    std::array<packed_vertex, 4> corners{};
+    for (std::size_t i = 0; i < 4; ++i) {
+        auto position = base;
+        position[u_axis] += offsets[i][0];
+        position[v_axis] += offsets[i][1];
+        corners[i].position_face = position[0] | (position[1] << 7u) | (position[2] << 14u)
+            | (static_cast<std::uint32_t>(q.face) << 21u) | ((q.shade[i].occlusion & 0x3u) << 24u);
+        corners[i].uv_id = offsets[i][0] | (offsets[i][1] << 7u) | (std::uint32_t{q.id} << 16u);
+    }
+    return corners;
+}
+
+[[nodiscard]] inline packed_quad pack_quad(const quad& q) {
+    if (q.origin[0] > 63 || q.origin[1] > 63 || q.origin[2] > 63 || q.width == 0 || q.width > 64 || q.height == 0
+        || q.height > 64) {
+        throw std::out_of_range("quad exceeds the packed quad range");
+    }
+    packed_quad packed{};
+    packed.origin_face = q.origin[0] | (q.origin[1] << 6u) | (q.origin[2] << 12u)
+        | (static_cast<std::uint32_t>(q.face) << 18u);
+    for (std::size_t i = 0; i < q.shade.size(); ++i) {
+        packed.origin_face |= (q.shade[i].occlusion & 0x3u) << (21u + 2u * static_cast<std::uint32_t>(i));
+    }
+    packed.size_id = (q.width - 1) | ((q.height - 1) << 6u) | (std::uint32_t{q.id} << 16u);
+    return packed;
+}
+
+// Throws std::out_of_range for positions the fixed point cannot hold: negative, past 65535/256 voxels, or not finite.
+[[nodiscard]] inline packed_smooth_vertex pack_smooth_vertex(const vertex& source) {
+    packed_smooth_vertex packed{};
+    for (std::size_t i = 0; i < 3; ++i) {
+        const float scaled = source.position[i] * smooth_position_scale;
+        if (!(scaled >= -0.5f && scaled < 65535.5f)) {
+            throw std::out_of_range("vertex exceeds the packed smooth vertex range");
+        }
+        packed.position[i] = static_cast<std::uint16_t>(std::lround(scaled));
+    }
+
+    // Octahedral mapping: project onto |x| + |y| + |z| = 1 and fold the lower hemisphere over the diagonals.
+    const auto& n = source.normal;
+    const float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+    if (l1 > 0.0f) {
+        float px = n[0] / l1;
+        float py = n[1] / l1;
+        if (n[2] < 0.0f) {
+            const float fx = (1.0f - std::abs(py)) * (px >= 0.0f ? 1.0f : -1.0f);
+            const float fy = (1.0f - std::abs(px)) * (py >= 0.0f ? 1.0f : -1.0f);
+            px = fx;
+            py = fy;
+        }
+        packed.normal[0] = static_cast<std::int8_t>(std::lround(px * 127.0f));
+        packed.normal[1] = static_cast<std::int8_t>(std::lround(py * 127.0f));
+    }
+    packed.id = source.id;
+    return packed;
+}
+
+inline std::array<float, 3> packed_smooth_vertex::unpack_position() const noexcept {
+    return {static_cast<float>(position[0]) / smooth_position_scale,
+        static_cast<float>(position[1]) / smooth_position_scale,
+        static_cast<float>(position[2]) / smooth_position_scale};
+}
+
+inline std::array<float, 3> packed_smooth_vertex::unpack_normal() const noexcept {
+    float x = static_cast<float>(normal[0]) / 127.0f;
+    float y = static_cast<float>(normal[1]) / 127.0f;
+    const float z = 1.0f - std::abs(x) - std::abs(y);
+    if (z < 0.0f) {
+        const float fx = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float fy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    const float length = std::sqrt(x * x + y * y + z * z);
+    return {x / length, y / length, z / length};
+}
+
+// Quad sink for the *_quads mesher entry points that appends four packed vertices and six indices per quad.
+struct packed_mesh_sink {
+    packed_mesh& mesh;
+
+    void operator()(const quad& q) const {
+        const auto base_index = static_cast<std::uint32_t>(mesh.vertices.size());
+        const auto corners = pack_quad_vertices(q);
+        const auto indices = quad_indices(base_index, q);
+        mesh.vertices.insert(mesh.vertices.end(), corners.begin(), corners.end());
+        mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+    }
+};
+
+// Quad sink that appends one packed_quad instance per quad.
+struct packed_quad_sink {
+    std::vector<packed_quad>& quads;
+
+    void operator()(const quad& q) const { quads.push_back(pack_quad(q)); }
+};
+
+// Sink for marching cubes in both the indexed (marching_cubes_indexed*) and triangle (marching_cubes_triangles*) forms.
+struct packed_smooth_sink {
+    packed_smooth_mesh& mesh;
+
+    std::uint32_t operator()(const vertex& v) const {
+        mesh.vertices.push_back(pack_smooth_vertex(v));
+        return static_cast<std::uint32_t>(mesh.vertices.size() - 1);
+    }
+
+    void operator()(const std::array<std::uint32_t, 3>& triangle) const {
+        mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+    }
+
+    void operator()(const std::array<vertex, 3>& triangle) const {
+        // Pack every corner first, so a corner out of range leaves the mesh as it was.
+        const std::array<packed_smooth_vertex, 3> corners{
+            pack_smooth_vertex(triangle[0]), pack_smooth_vertex(triangle[1]), pack_smooth_vertex(triangle[2])};
+        const auto base_index = static_cast<std::uint32_t>(mesh.vertices.size());
+        mesh.vertices.insert(mesh.vertices.end(), corners.begin(), corners.end());
+        mesh.indices.insert(mesh.indices.end(), {base_index, base_index + 1, base_index + 2});
+    }
+};
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/packed_mesh.hpp
+
+// begin: almond_voxel/meshing/mesh_context.hpp
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+namespace almond::voxel::meshing {
+
+// Outcome of meshing into caller spans. `vertex_count` and `index_count` were written; the required counts cover
+// every primitive the mesher produced. When they differ the spans were too small: writing stopped at the first
+// primitive that did not fit, so grow the buffers to the required counts and mesh again.
+struct mesh_span_result {
+    std::size_t vertex_count{0};
+    std::size_t index_count{0};
+    std::size_t required_vertices{0};
+    std::size_t required_indices{0};
+
+    [[nodiscard]] bool complete() const noexcept {
+        return vertex_count == required_vertices && index_count == required_indices;
+    }
+};
+
+namespace detail {
+
+template <typename Vertex, std::size_t VertexCount, std::size_t IndexCount, typename MakeIndices>
+void write_span_primitive(std::span<Vertex> vertices, std::span<std::uint32_t> indices, mesh_span_result& result,
+    const std::array<Vertex, VertexCount>& corners, MakeIndices&& make_indices) {
+    const bool fits = result.complete() && result.vertex_count + VertexCount <= vertices.size()
+        && result.index_count + IndexCount <= indices.size();
+    if (fits) {
+        const std::array<std::uint32_t, IndexCount> primitive = make_indices(
+            static_cast<std::uint32_t>(result.vertex_count));
+        std::copy(corners.begin(), corners.end(), vertices.begin() + static_cast<std::ptrdiff_t>(result.vertex_count));
+        std::copy(primitive.begin(), primitive.end(), indices.begin() + static_cast<std::ptrdiff_t>(result.index_count));
+        result.vertex_count += VertexCount;
+        result.index_count += IndexCount;
+    }
+    result.required_vertices += VertexCount;
+    result.required_indices += IndexCount;
+}
+
+} // namespace detail
+
+// Quad and triangle sink that writes float vertices and indices into caller memory, such as a mapped GPU buffer.
+// Pass it by lvalue so the counts survive the call, then read result().
+class span_mesh_sink {
+public:
+    span_mesh_sink(std::span<vertex> vertices, std::span<std::uint32_t> indices) noexcept
+        : vertices_{vertices}, indices_{indices} {}
+
+    void operator()(const quad& q) {
+        detail::write_span_primitive<vertex, 4, 6>(vertices_, indices_, result_, quad_vertices(q),
+            [&](std::uint32_t base) { return quad_indices(base, q); });
+    }
+
+    void operator()(const std::array<vertex, 3>& triangle) {
+        detail::write_span_primitive<vertex, 3, 3>(vertices_, indices_, result_, triangle,
+            [](std::uint32_t base) { return std::array<std::uint32_t, 3>{base, base + 1, base + 2}; });
+    }
+
+    // Indexed marching cubes output. Indices count every vertex this sink has received, and writing stops at the first
+    // vertex or triangle that does not fit.
+    std::uint32_t operator()(const vertex& v) {
+        const auto index = static_cast<std::uint32_t>(result_.required_vertices);
+        if (result_.complete() && result_.vertex_count < vertices_.size()) {
+            vertices_[result_.vertex_count++] = v;
+        }
+        ++result_.required_vertices;
+        return index;
+    }
+
+    void operator()(const std::array<std::uint32_t, 3>& triangle) {
+        if (result_.complete() && result_.index_count + triangle.size() <= indices_.size()) {
+            std::copy(triangle.begin(), triangle.end(),
+                indices_.begin() + static_cast<std::ptrdiff_t>(result_.index_count));
+            result_.index_count += triangle.size();
+        }
+        result_.required_indices += triangle.size();
+    }
+
+    [[nodiscard]] const mesh_span_result& result() const noexcept { return result_; }
+
+private:
+    std::span<vertex> vertices_;
+    std::span<std::uint32_t> indices_;
+    mesh_span_result result_{};
+};
+
+// span_mesh_sink for packed_vertex output.
+class packed_span_sink {
+public:
+    packed_span_sink(std::span<packed_vertex> vertices, std::span<std::uint32_t> indices) noexcept
+        : vertices_{vertices}, indices_{indices} {}
+
+    void operator()(const quad& q) {
+        detail::write_span_primitive<packed_vertex, 4, 6>(vertices_, indices_, result_, pack_quad_vertices(q),
+            [&](std::uint32_t base) { return quad_indices(base, q); });
+    }
+
+    [[nodiscard]] const mesh_span_result& result() const noexcept { return result_; }
+
+private:
+    std::span<packed_vertex> vertices_;
+    std::span<std::uint32_t> indices_;
+    mesh_span_result result_{};
+};
+
+// Reusable mesher state for streaming loops: scratch masks plus one output mesh whose buffers keep their capacity
+// between calls. Once the buffers have grown to the busiest chunk, meshing allocates nothing. Each call replaces the
+// previous mesh, and the returned reference stays valid until the next call. A context is not thread-safe; give each
+// worker its own.
+class mesher_context {
+public:
+    mesher_context() = default;
+
+    // Pre-sizes the output mesh so even the first chunks mesh without growing it.
+    void reserve(std::size_t vertices, std::size_t indices);
+
+    template <typename IsOpaque>
+    const mesh_result& greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors, IsOpaque&& is_opaque);
+    const mesh_result& greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors = {});
+
+    template <typename IsOpaque>
+    const mesh_result& binary_greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+        IsOpaque&& is_opaque);
+    const mesh_result& binary_greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors = {});
+
+    template <typename IsOpaque>
+    const mesh_result& naive(const chunk_storage& chunk, const chunk_neighbors& neighbors, IsOpaque&& is_opaque);
+    const mesh_result& naive(const chunk_storage& chunk, const chunk_neighbors& neighbors = {});
+
+    // All 26 neighbours, with the vertex lighting requested in `lighting` baked into the mesh.
+    template <typename IsOpaque>
+    const mesh_result& greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        IsOpaque&& is_opaque, const mesh_lighting_config& lighting);
+    const mesh_result& greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        const mesh_lighting_config& lighting = {});
+    template <typename IsOpaque>
+    const mesh_result& binary_greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        IsOpaque&& is_opaque, const mesh_lighting_config& lighting);
+    const mesh_result& binary_greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        const mesh_lighting_config& lighting = {});
+    template <typename IsOpaque>
+    const mesh_result& naive(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        IsOpaque&& is_opaque, const mesh_lighting_config& lighting);
+    const mesh_result& naive(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        const mesh_lighting_config& lighting = {});
+
+    template <typename IsSolid>
+    const mesh_result& marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+        const chunk_neighbors& neighbors, const marching_cubes_config& config = {});
+    const mesh_result& marching_cubes(const chunk_storage& chunk, const chunk_neighbors& neighbors = {},
+        const marching_cubes_config& config = {});
+    // Edge and corner neighbours included, for seamless surfaces along chunk edges.
+    template <typename IsSolid>
+    const mesh_result& marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+        const chunk_neighborhood& neighborhood, const marching_cubes_config& config = {});
+    const mesh_result& marching_cubes(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        const marching_cubes_config& config = {});
+    // At a level of detail, stitched to coarser face neighbours.
+    template <typename IsSolid>
+    const mesh_result& marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+        const chunk_neighborhood& neighborhood, const marching_cubes_lod& lod,
+        const marching_cubes_config& config = {});
+    const mesh_result& marching_cubes(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+        const marching_cubes_lod& lod, const marching_cubes_config& config = {});
+
+    // For the *_quads entry points when meshing straight into a custom sink such as span_mesh_sink.
+    [[nodiscard]] mesher_scratch& scratch() noexcept { return scratch_; }
+    [[nodiscard]] const mesh_result& mesh() const noexcept { return mesh_; }
+
+private:
+    void reset() noexcept;
+
+    mesher_scratch scratch_{};
+    mesh_result mesh_{};
+};
+
+inline void mesher_context::reserve(std::size_t vertices, std::size_t indices) {
+    mesh_.vertices.reserve(vertices);
+    mesh_.indices.reserve(indices);
+    scratch_.quads.reserve(vertices / 4);
+}
+
+inline void mesher_context::reset() noexcept {
+    mesh_.vertices.clear();
+    mesh_.indices.clear();
+    scratch_.quads.clear();
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque) {
+    return greedy(chunk, chunk_neighborhood::from_faces(neighbors), std::forward<IsOpaque>(is_opaque),
+        mesh_lighting_config{});
+}
+
+inline const mesh_result& mesher_context::greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors) {
+    return greedy(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::binary_greedy(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque) {
+    return binary_greedy(chunk, chunk_neighborhood::from_faces(neighbors), std::forward<IsOpaque>(is_opaque),
+        mesh_lighting_config{});
+}
+
+inline const mesh_result& mesher_context::binary_greedy(const chunk_storage& chunk,
+    const chunk_neighbors& neighbors) {
+    return binary_greedy(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::naive(const chunk_storage& chunk, const chunk_neighbors& neighbors,
+    IsOpaque&& is_opaque) {
+    return naive(chunk, chunk_neighborhood::from_faces(neighbors), std::forward<IsOpaque>(is_opaque),
+        mesh_lighting_config{});
+}
+
+inline const mesh_result& mesher_context::naive(const chunk_storage& chunk, const chunk_neighbors& neighbors) {
+    return naive(chunk, neighbors, [](voxel_id id) { return id != voxel_id{}; });
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting) {
+    reset();
+    greedy_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [this](const quad& q) { append_quad(mesh_, q); }, scratch_);
+    return mesh_;
+}
+
+inline const mesh_result& mesher_context::greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    const mesh_lighting_config& lighting) {
+    return greedy(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; }, lighting);
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::binary_greedy(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting) {
+    reset();
+    auto& quads = scratch_.quads;
+    binary_greedy_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [&quads](const quad& q) { quads.push_back(q); }, scratch_);
+    detail::append_quads(mesh_, quads);
+    return mesh_;
+}
+
+inline const mesh_result& mesher_context::binary_greedy(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, const mesh_lighting_config& lighting) {
+    return binary_greedy(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; }, lighting);
+}
+
+template <typename IsOpaque>
+const mesh_result& mesher_context::naive(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    IsOpaque&& is_opaque, const mesh_lighting_config& lighting) {
+    reset();
+    naive_quads_with_neighborhood(chunk, neighborhood, std::forward<IsOpaque>(is_opaque), lighting,
+        [this](const quad& q) { detail::append_naive_face(mesh_, q); }, scratch_);
+    return mesh_;
+}
+
+inline const mesh_result& mesher_context::naive(const chunk_storage& chunk, const chunk_neighborhood& neighborhood,
+    const mesh_lighting_config& lighting) {
+    return naive(chunk, neighborhood, [](voxel_id id) { return id != voxel_id{}; }, lighting);
+}
+
+template <typename IsSolid>
+const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighbors& neighbors, const marching_cubes_config& config) {
+    return marching_cubes(chunk, std::forward<IsSolid>(is_solid), chunk_neighborhood::from_faces(neighbors), config);
+}
+
+inline const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk,
+    const chunk_neighbors& neighbors, const marching_cubes_config& config) {
+    return marching_cubes(chunk, [](voxel_id id) { return id != voxel_id{}; }, neighbors, config);
+}
+
+template <typename IsSolid>
+const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config) {
+    reset();
+    marching_cubes_indexed_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, config,
+        detail::indexed_mesh_sink{mesh_}, scratch_);
+    return mesh_;
+}
+
+inline const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, const marching_cubes_config& config) {
+    return marching_cubes(chunk, [](voxel_id id) { return id != voxel_id{}; }, neighborhood, config);
+}
+
+template <typename IsSolid>
+const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk, IsSolid&& is_solid,
+    const chunk_neighborhood& neighborhood, const marching_cubes_lod& lod, const marching_cubes_config& config) {
+    reset();
+    marching_cubes_lod_indexed_from_chunk(chunk, std::forward<IsSolid>(is_solid), neighborhood, lod, config,
+        detail::indexed_mesh_sink{mesh_}, scratch_);
+    return mesh_;
+}
+
+inline const mesh_result& mesher_context::marching_cubes(const chunk_storage& chunk,
+    const chunk_neighborhood& neighborhood, const marching_cubes_lod& lod, const marching_cubes_config& config) {
+    return marching_cubes(chunk, [](voxel_id id) { return id != voxel_id{}; }, neighborhood, lod, config);
+}
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/mesh_context.hpp
+
+// begin: almond_voxel/parallel/completion_queue.hpp
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace almond::voxel::parallel {
+
+// Unbounded multi-producer, single-consumer queue. Producers push onto a lock-free stack with one CAS; the consumer
+// detaches the whole stack with one exchange and reverses it, so items come out in push order per producer and no
+// side ever blocks. Only one thread may call try_pop() at a time.
+template <typename T>
+class completion_queue {
+public:
+    completion_queue() = default;
+    completion_queue(const completion_queue&) = delete;
+    completion_queue& operator=(const completion_queue&) = delete;
+    ~completion_queue();
+
+    void push(T value);
+    [[nodiscard]] bool try_pop(T& out);
+    // May miss pushes that are racing with the call.
+    [[nodiscard]] bool empty() const noexcept;
+
+private:
+    struct node {
+        T value;
+        node* next{nullptr};
+    };
+
+    static void destroy(node* list) noexcept;
+
+    std::atomic<node*> incoming_{nullptr};
+    node* ready_{nullptr};
+};
+
+template <typename T>
+completion_queue<T>::~completion_queue() {
+    destroy(ready_);
+    destroy(incoming_.load(std::memory_order_acquire));
+}
+
+template <typename T>
+void completion_queue<T>::push(T value) {
+    auto* item = new node{std::move(value), incoming_.load(std::memory_order_relaxed)};
+    while (!incoming_.compare_exchange_weak(item->next, item, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+template <typename T>
+bool completion_queue<T>::try_pop(T& out) {
+    if (ready_ == nullptr) {
+        // The detached stack is newest first; reversing it restores arrival order.
+        auto* list = incoming_.exchange(nullptr, std::memory_order_acquire);
+        while (list != nullptr) {
+            auto* next = list->next;
+            list->next = ready_;
+            ready_ = list;
+            list = next;
+        }
+        if (ready_ == nullptr) {
+            return false;
+        }
+    }
+    auto* item = ready_;
+    ready_ = item->next;
+    out = std::move(item->value);
+    delete item;
+    return true;
+}
+
+template <typename T>
+bool completion_queue<T>::empty() const noexcept {
+    return ready_ == nullptr && incoming_.load(std::memory_order_acquire) == nullptr;
+}
+
+template <typename T>
+void completion_queue<T>::destroy(node* list) noexcept {
+    while (list != nullptr) {
+        auto* next = list->next;
+        delete list;
+        list = next;
+    }
+}
+
+} // namespace almond::voxel::parallel
+// end: almond_voxel/parallel/completion_queue.hpp
+
+// begin: almond_voxel/meshing/batch_mesher.hpp
+
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::meshing {
+
+enum class batch_mesher_kind { binary_greedy, greedy, naive, marching_cubes };
+
+struct batch_mesh_config {
+    batch_mesher_kind mesher{batch_mesher_kind::binary_greedy};
+    marching_cubes_config marching_cubes{};
+    // Level of detail for marching cubes, chosen per chunk from its distance to the viewer of the latest
+    // submit(keys, viewer). Results carry the level; resubmit chunks whose level or neighbour levels changed.
+    marching_cubes_lod_policy lod{};
+    // Vertex lighting for the blocky meshers; enabling it also gathers edge and corner neighbours.
+    mesh_lighting_config lighting{};
+    std::size_t worker_count{parallel::task_pool::default_worker_count()};
+};
+
+enum class batch_mesh_status { meshed, missing, failed };
+
+struct batch_mesh_result {
+    region_key key{};
+    batch_mesh_status status{batch_mesh_status::meshed};
+    // chunk_storage::revision() of the snapshot that was meshed, so stale results can be recognised.
+    std::uint64_t revision{0};
+    // Level of detail the chunk was meshed at; always 0 for the blocky meshers.
+    std::uint8_t lod_level{0};
+    mesh_result mesh{};
+    // What the mesher threw for a failed result; the mesh is empty.
+    std::exception_ptr error{};
+};
+
+// Meshes resident chunks of a region_manager on a worker pool. Each job snapshots the chunk and its neighbours (O(1)
+// copy-on-write, under shared guards), then meshes the snapshots with a per-worker mesher_context, so workers never
+// block the owner thread or each other. Queued keys run highest priority first; resubmitting a queued key updates its
+// priority, and a key submitted while it is being meshed runs again afterwards so the newest edit always lands last.
+// Results arrive through a lock-free completion queue drained by one consumer thread.
+//
+// submit(), cancel() and cancel_all() may be called from any thread; try_pop() and drain() from one consumer thread.
+// The region_manager must outlive the batch_mesher. Keys that are not resident when their job runs report missing;
+// keys whose snapshot or mesher throws report failed with the exception attached.
+class batch_mesher {
+public:
+    explicit batch_mesher(const region_manager& regions, batch_mesh_config config = {});
+    batch_mesher(const batch_mesher&) = delete;
+    batch_mesher& operator=(const batch_mesher&) = delete;
+    ~batch_mesher();
+
+    void submit(const region_key& key, int priority = 0);
+    // Nearer regions first: priority is the negated squared distance to `viewer`, in region units.
+    void submit(std::span<const region_key> keys, const region_key& viewer);
+
+    // Drops a queued key and discards the result of a run in progress. Returns false when the key was neither.
+    bool cancel(const region_key& key);
+    void cancel_all();
+
+    [[nodiscard]] bool try_pop(batch_mesh_result& out);
+    // Calls `consume(batch_mesh_result&&)` for each completed result; returns how many were delivered.
+    template <typename Consume>
+    std::size_t drain(Consume&& consume);
+
+    // Keys queued or being meshed, and of those the ones a worker is meshing right now.
+    [[nodiscard]] std::size_t pending() const;
+    [[nodiscard]] std::size_t in_flight() const;
+    [[nodiscard]] std::size_t worker_count() const noexcept { return pool_.worker_count(); }
+    // Blocks until every submitted key has been meshed or cancelled. Not callable from inside a consumer callback
+    // that workers wait on.
+    void wait_idle();
+
+    [[nodiscard]] static int distance_priority(const region_key& key, const region_key& viewer) noexcept;
+
+private:
+    struct queued_entry {
+        int priority{0};
+        std::uint64_t sequence{0};
+        region_key key{};
+        std::uint64_t ticket{0};
+
+        // Max-heap on priority, then first come first served.
+        [[nodiscard]] friend bool operator<(const queued_entry& lhs, const queued_entry& rhs) noexcept {
+            return lhs.priority != rhs.priority ? lhs.priority < rhs.priority : lhs.sequence > rhs.sequence;
+        }
+    };
+
+    struct running_entry {
+        bool cancelled{false};
+        // Set when the key was resubmitted during the run; it is queued again once the run finishes.
+        std::optional<int> rerun{};
+    };
+
+    void push_locked(const region_key& key, int priority);
+    void run_next();
+    [[nodiscard]] batch_mesh_result mesh_key(const region_key& key, const std::optional<region_key>& viewer,
+        mesher_context& context) const;
+
+    const region_manager& regions_;
+    batch_mesh_config config_{};
+
+    mutable std::mutex mutex_{};
+    std::vector<queued_entry> heap_{};
+    std::unordered_map<region_key, std::uint64_t, region_key_hash> queued_{};
+    std::unordered_map<region_key, running_entry, region_key_hash> running_{};
+    std::uint64_t next_sequence_{0};
+    std::uint64_t next_ticket_{0};
+    std::size_t jobs_to_submit_{0};
+    std::optional<region_key> viewer_{};
+
+    parallel::completion_queue<batch_mesh_result> completed_{};
+    std::vector<mesher_context> contexts_{};
+    // Declared last so its workers stop before the state they use is destroyed.
+    parallel::task_pool pool_;
+};
+
+inline batch_mesher::batch_mesher(const region_manager& regions, batch_mesh_config config)
+    : regions_{regions}, config_{config}, contexts_(std::max<std::size_t>(1, config.worker_count)),
+      pool_{std::max<std::size_t>(1, config.worker_count)} {}
+
+inline batch_mesher::~batch_mesher() {
+    cancel_all();
+    pool_.wait_idle();
+}
+
+inline int batch_mesher::distance_priority(const region_key& key, const region_key& viewer) noexcept {
+    const auto dx = static_cast<std::int64_t>(key.x) - viewer.x;
+    const auto dy = static_cast<std::int64_t>(key.y) - viewer.y;
+    const auto dz = static_cast<std::int64_t>(key.z) - viewer.z;
+    const auto distance = dx * dx + dy * dy + dz * dz;
+    return -static_cast<int>(std::min<std::int64_t>(distance, std::numeric_limits<int>::max()));
+}
+
+inline void batch_mesher::push_locked(const region_key& key, int priority) {
+    if (auto running = running_.find(key); running != running_.end()) {
+        running->second.rerun = std::max(priority, running->second.rerun.value_or(priority));
+        return;
+    }
+    // Re-queueing leaves the old heap entry behind with a stale ticket; run_next() skips it.
+    const auto ticket = ++next_ticket_;
+    queued_.insert_or_assign(key, ticket);
+    heap_.push_back(queued_entry{priority, next_sequence_++, key, ticket});
+    std::push_heap(heap_.begin(), heap_.end());
+    ++jobs_to_submit_;
+}
+
+inline void batch_mesher::submit(const region_key& key, int priority) {
+    std::size_t jobs = 0;
+    {
+        std::scoped_lock lock{mutex_};
+        push_locked(key, priority);
+        jobs = std::exchange(jobs_to_submit_, 0);
+    }
+    for (std::size_t i = 0; i < jobs; ++i) {
+        pool_.submit([this] { run_next(); });
+    }
+}
+
+inline void batch_mesher::submit(std::span<const region_key> keys, const region_key& viewer) {
+    std::size_t jobs = 0;
+    {
+        // Queue the whole batch before any worker starts so the first jobs already see the nearest keys.
+        std::scoped_lock lock{mutex_};
+        viewer_ = viewer;
+        for (const auto& key : keys) {
+            push_locked(key, distance_priority(key, viewer));
+        }
+        jobs = std::exchange(jobs_to_submit_, 0);
+    }
+    for (std::size_t i = 0; i < jobs; ++i) {
+        pool_.submit([this] { run_next(); });
+    }
+}
+
+inline bool batch_mesher::cancel(const region_key& key) {
+    std::scoped_lock lock{mutex_};
+    bool found = queued_.erase(key) > 0;
+    if (auto running = running_.find(key); running != running_.end()) {
+        running->second.cancelled = true;
+        running->second.rerun.reset();
+        found = true;
+    }
+    return found;
+}
+
+inline void batch_mesher::cancel_all() {
+    std::scoped_lock lock{mutex_};
+    queued_.clear();
+    heap_.clear();
+    for (auto& [key, running] : running_) {
+        running.cancelled = true;
+        running.rerun.reset();
+    }
+}
+
+inline bool batch_mesher::try_pop(batch_mesh_result& out) {
+    return completed_.try_pop(out);
+}
+
+template <typename Consume>
+std::size_t batch_mesher::drain(Consume&& consume) {
+    std::size_t delivered = 0;
+    batch_mesh_result result;
+    while (completed_.try_pop(result)) {
+        consume(std::move(result));
+        ++delivered;
+    }
+    return delivered;
+}
+
+inline std::size_t batch_mesher::pending() const {
+    std::scoped_lock lock{mutex_};
+    return queued_.size() + running_.size();
+}
+
+inline std::size_t batch_mesher::in_flight() const {
+    std::scoped_lock lock{mutex_};
+    return running_.size();
+}
+
+inline void batch_mesher::wait_idle() {
+    pool_.wait_idle();
+}
+
+inline void batch_mesher::run_next() {
+    region_key key{};
+    std::optional<region_key> viewer{};
+    {
+        // Every queued entry submitted one job, but a job takes whichever live key has the highest priority now.
+        std::scoped_lock lock{mutex_};
+        for (;;) {
+            if (heap_.empty()) {
+                return;
+            }
+            std::pop_heap(heap_.begin(), heap_.end());
+            const auto entry = heap_.back();
+            heap_.pop_back();
+            const auto queued = queued_.find(entry.key);
+            if (queued == queued_.end() || queued->second != entry.ticket) {
+                continue;
+            }
+            queued_.erase(queued);
+            key = entry.key;
+            viewer = viewer_;
+            running_.insert_or_assign(key, running_entry{});
+            break;
+        }
+    }
+
+    // Pool jobs must not throw, and the key has to leave running_ either way or pending() never drains.
+    batch_mesh_result result{key};
+    try {
+        result = mesh_key(key, viewer, contexts_[pool_.worker_index()]);
+    } catch (...) {
+        result = batch_mesh_result{key};
+        result.status = batch_mesh_status::failed;
+        result.error = std::current_exception();
+    }
+
+    std::size_t jobs = 0;
+    {
+        // Publishing before the rerun is queued keeps results for one key in submission order.
+        std::scoped_lock lock{mutex_};
+        const auto running = running_.find(key);
+        if (!running->second.cancelled) {
+            completed_.push(std::move(result));
+        }
+        const auto rerun = running->second.rerun;
+        running_.erase(running);
+        if (rerun) {
+            push_locked(key, *rerun);
+        }
+        jobs = std::exchange(jobs_to_submit_, 0);
+    }
+    for (std::size_t i = 0; i < jobs; ++i) {
+        pool_.submit([this] { run_next(); });
+    }
+}
+
+inline batch_mesh_result batch_mesher::mesh_key(const region_key& key, const std::optional<region_key>& viewer,
+    mesher_context& context) const {
+    batch_mesh_result result{key};
+    const auto snapshot_of = [&](const region_key& at) -> std::shared_ptr<const chunk_storage> {
+        const auto chunk = regions_.find(at);
+        if (!chunk) {
+            return {};
+        }
+        const auto guard = chunk->lock_shared();
+        return chunk->snapshot();
+    };
+
+    const auto center = snapshot_of(key);
+    if (!center) {
+        result.status = batch_mesh_status::missing;
+        return result;
+    }
+    result.revision = center->revision();
+
+    // Marching cubes and vertex lighting sample across chunk edges and corners, so they snapshot all 26 neighbours;
+    // unlit blocky meshing only reads the six face neighbours.
+    const bool diagonals = config_.mesher == batch_mesher_kind::marching_cubes || config_.lighting.enabled();
+    std::array<std::shared_ptr<const chunk_storage>, 27> around{};
+    chunk_neighborhood neighborhood{};
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const int distance = std::abs(dx) + std::abs(dy) + std::abs(dz);
+                if (distance == 0 || (distance > 1 && !diagonals)) {
+                    continue;
+                }
+                auto& snapshot = around[chunk_neighborhood::slot(dx, dy, dz)];
+                snapshot = snapshot_of(region_key{key.x + dx, key.y + dy, key.z + dz});
+                neighborhood.set(dx, dy, dz, snapshot.get());
+            }
+        }
+    }
+    switch (config_.mesher) {
+    case batch_mesher_kind::binary_greedy:
+        result.mesh = context.binary_greedy(*center, neighborhood, config_.lighting);
+        break;
+    case batch_mesher_kind::greedy:
+        result.mesh = context.greedy(*center, neighborhood, config_.lighting);
+        break;
+    case batch_mesher_kind::naive:
+        result.mesh = context.naive(*center, neighborhood, config_.lighting);
+        break;
+    case batch_mesher_kind::marching_cubes:
+        if (config_.lod.enabled() && viewer) {
+            const auto lod = config_.lod.select(key, *viewer);
+            result.lod_level = detail::clamp_lod_level(center->extent(), lod.level);
+            result.mesh = context.marching_cubes(*center, neighborhood, lod, config_.marching_cubes);
+        } else {
+            result.mesh = context.marching_cubes(*center, neighborhood, config_.marching_cubes);
+        }
+        break;
+    }
+    return result;
+}
+
+} // namespace almond::voxel::meshing
+// end: almond_voxel/meshing/batch_mesher.hpp
+
+// begin: almond_voxel/serialization/file_commit.hpp
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+// Trim <windows.h> and keep its min/max macros out, without leaking either setting into the including code.
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#define ALMOND_VOXEL_UNDEF_NOMINMAX
+#endif
+#include <windows.h>
+#ifdef ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#ifdef ALMOND_VOXEL_UNDEF_NOMINMAX
+#undef NOMINMAX
+#undef ALMOND_VOXEL_UNDEF_NOMINMAX
+#endif
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace almond::voxel::serialization {
+
+// Forces the written contents of `path` to stable storage. Streams must be flushed first; the file is reopened, so
+// this works for files written through std::ofstream.
+inline void sync_file(const std::filesystem::path& path) {
+#if defined(_WIN32)
+    const HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open file for sync");
+    }
+    const bool synced = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+#else
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("failed to open file for sync");
+    }
+    const bool synced = ::fsync(descriptor) == 0;
+    ::close(descriptor);
+#endif
+    if (!synced) {
+        throw std::runtime_error("failed to sync file");
+    }
+}
+
+// Makes a rename or create inside `directory` durable. NTFS journals metadata itself, so this is a no-op on Windows.
+inline void sync_directory(const std::filesystem::path& directory) {
+#if !defined(_WIN32)
+    const int descriptor = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("failed to open directory for sync");
+    }
+    const bool synced = ::fsync(descriptor) == 0;
+    ::close(descriptor);
+    if (!synced) {
+        throw std::runtime_error("failed to sync directory");
+    }
+#else
+    static_cast<void>(directory);
+#endif
+}
+
+// Atomically replaces `target` with the fully written `temporary`: the data is synced before the rename, so a crash
+// leaves either the old file or the complete new one, never a torn mix.
+inline void commit_file(const std::filesystem::path& temporary, const std::filesystem::path& target) {
+    sync_file(temporary);
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+    if (error) {
+        throw std::runtime_error("failed to replace " + target.string() + ": " + error.message());
+    }
+    sync_directory(target.parent_path());
+}
+
+} // namespace almond::voxel::serialization
+// end: almond_voxel/serialization/file_commit.hpp
+
+// begin: almond_voxel/storage/checksum.hpp
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace almond::voxel {
+
+namespace detail::checksum {
+
+inline constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87ull;
+inline constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+inline constexpr std::uint64_t prime3 = 0x165667B19E3779F9ull;
+inline constexpr std::uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+inline constexpr std::uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+template <typename Word>
+[[nodiscard]] inline Word read_le(const std::byte* data) noexcept {
+    Word value{};
+    std::memcpy(&value, data, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) {
+        Word swapped{};
+        for (std::size_t i = 0; i < sizeof(Word); ++i) {
+            swapped = static_cast<Word>((swapped << 8u) | ((value >> (8u * i)) & 0xFFu));
+        }
+        value = swapped;
+    }
+    return value;
+}
+
+[[nodiscard]] constexpr std::uint64_t round(std::uint64_t accumulator, std::uint64_t input) noexcept {
+    accumulator += input * prime2;
+    return std::rotl(accumulator, 31) * prime1;
+}
+
+[[nodiscard]] constexpr std::uint64_t merge_round(std::uint64_t accumulator, std::uint64_t lane) noexcept {
+    accumulator ^= round(0, lane);
+    return accumulator * prime1 + prime4;
+}
+
+} // namespace detail::checksum
+
+// XXH64 of `bytes`. Four independent accumulator lanes keep the multiply units busy, so hashing runs near memory
+// bandwidth without target-specific SIMD; output matches the reference xxHash implementation.
+[[nodiscard]] inline std::uint64_t xxhash64(std::span<const std::byte> bytes, std::uint64_t seed = 0) noexcept {
+    using namespace detail::checksum;
+    const auto* data = bytes.data();
+    const auto* const end = data + bytes.size();
+    std::uint64_t hash = 0;
+
+    if (bytes.size() >= 32) {
+        std::uint64_t lanes[4]{seed + prime1 + prime2, seed + prime2, seed, seed - prime1};
+        for (; end - data >= 32; data += 32) {
+            lanes[0] = round(lanes[0], read_le<std::uint64_t>(data));
+            lanes[1] = round(lanes[1], read_le<std::uint64_t>(data + 8));
+            lanes[2] = round(lanes[2], read_le<std::uint64_t>(data + 16));
+            lanes[3] = round(lanes[3], read_le<std::uint64_t>(data + 24));
+        }
+        hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+        for (const auto lane : lanes) {
+            hash = merge_round(hash, lane);
+        }
+    } else {
+        hash = seed + prime5;
+    }
+    hash += bytes.size();
+
+    for (; end - data >= 8; data += 8) {
+        hash ^= round(0, read_le<std::uint64_t>(data));
+        hash = std::rotl(hash, 27) * prime1 + prime4;
+    }
+    if (end - data >= 4) {
+        hash ^= std::uint64_t{read_le<std::uint32_t>(data)} * prime1;
+        hash = std::rotl(hash, 23) * prime2 + prime3;
+        data += 4;
+    }
+    for (; data < end; ++data) {
+        hash ^= std::to_integer<std::uint64_t>(*data) * prime5;
+        hash = std::rotl(hash, 11) * prime1;
+    }
+
+    hash ^= hash >> 33u;
+    hash *= prime2;
+    hash ^= hash >> 29u;
+    hash *= prime3;
+    hash ^= hash >> 32u;
+    return hash;
+}
+
+} // namespace almond::voxel
+// end: almond_voxel/storage/checksum.hpp
+
+// begin: almond_voxel/serialization/region_io.hpp
+
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::serialization {
+
+constexpr std::uint32_t chunk_version_latest = 4;
+// Delta payloads (see chunk_delta.hpp) share the v2 header, carry this version and set `chunk_channel_delta`.
+constexpr std::uint32_t chunk_version_delta = 5;
+constexpr std::array<char, 4> chunk_magic{'A', 'V', 'C', 'K'};
+
+struct chunk_header_v1 {
+    char magic[4]{chunk_magic[0], chunk_magic[1], chunk_magic[2], chunk_magic[3]};
+    std::uint32_t version{1};
+    std::uint32_t extent[3]{1, 1, 1};
+};
+
+struct chunk_header_v2 {
+    char magic[4]{chunk_magic[0], chunk_magic[1], chunk_magic[2], chunk_magic[3]};
+    std::uint32_t version{chunk_version_latest};
+    std::uint32_t extent[3]{1, 1, 1};
+    std::uint32_t channel_flags{0};
+};
+
+enum chunk_channel_flags : std::uint32_t {
+    chunk_channel_materials = 1u << 0u,
+    chunk_channel_skylight_cache = 1u << 1u,
+    chunk_channel_blocklight_cache = 1u << 2u,
+    chunk_channel_effect_density = 1u << 3u,
+    chunk_channel_effect_velocity = 1u << 4u,
+    chunk_channel_effect_lifetime = 1u << 5u,
+    chunk_channel_uniform = 1u << 6u,
+    chunk_channel_delta = 1u << 7u
+};
+
+// Payload size following a v2 header. Uniform payloads (version 4+) store a single value per enabled plane.
+[[nodiscard]] inline std::size_t chunk_payload_bytes(std::uint32_t flags, std::size_t count) noexcept {
+    if (flags & chunk_channel_uniform) {
+        count = 1;
+    }
+    std::size_t bytes = count * (sizeof(voxel_id) + 3);
+    if (flags & chunk_channel_materials) {
+        bytes += count * sizeof(material_index);
+    }
+    if (flags & chunk_channel_skylight_cache) {
+        bytes += count * sizeof(float);
+    }
+    if (flags & chunk_channel_blocklight_cache) {
+        bytes += count * sizeof(float);
+    }
+    if (flags & chunk_channel_effect_density) {
+        bytes += count * sizeof(float);
+    }
+    if (flags & chunk_channel_effect_velocity) {
+        bytes += count * sizeof(effects::velocity_sample);
+    }
+    if (flags & chunk_channel_effect_lifetime) {
+        bytes += count * sizeof(float);
+    }
+    return bytes;
+}
+
+struct region_blob {
+    region_key key{};
+    std::vector<std::byte> payload;
+};
+
+inline void append_bytes(std::vector<std::byte>& buffer, const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const std::byte*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+namespace detail {
+
+// Channel flags describing which optional planes a chunk carries.
+[[nodiscard]] inline std::uint32_t chunk_channels(const chunk_storage& chunk) noexcept {
+    std::uint32_t flags = 0;
+    if (chunk.materials_enabled()) {
+        flags |= chunk_channel_materials;
+    }
+    if (chunk.high_precision_lighting_enabled()) {
+        flags |= chunk_channel_skylight_cache | chunk_channel_blocklight_cache;
+    }
+    if (chunk.effect_density_enabled()) {
+        flags |= chunk_channel_effect_density;
+    }
+    if (chunk.effect_velocity_enabled()) {
+        flags |= chunk_channel_effect_velocity;
+    }
+    if (chunk.effect_lifetime_enabled()) {
+        flags |= chunk_channel_effect_lifetime;
+    }
+    return flags;
+}
+
+inline void reject_delta_payload(const chunk_header_v2& header) {
+    if (header.version == chunk_version_delta || (header.channel_flags & chunk_channel_delta) != 0) {
+        throw std::runtime_error("chunk payload is a delta; apply it with apply_chunk_delta");
+    }
+}
+
+// Decodes the planes following a v2+ header straight into a new chunk. `read(destination, size)` must fill exactly
+// `size` bytes or throw, so stream and span sources share one decoder without staging the payload.
+template <typename Read>
+chunk_storage decode_chunk_body(const chunk_header_v2& header, Read&& read) {
+    const chunk_extent extent{header.extent[0], header.extent[1], header.extent[2]};
+    const auto count = extent.volume();
+    const bool has_materials = (header.channel_flags & chunk_channel_materials) != 0;
+    const bool has_sky_cache = (header.channel_flags & chunk_channel_skylight_cache) != 0;
+    const bool has_block_cache = (header.channel_flags & chunk_channel_blocklight_cache) != 0;
+    const bool has_effect_density = (header.channel_flags & chunk_channel_effect_density) != 0;
+    const bool has_effect_velocity = (header.channel_flags & chunk_channel_effect_velocity) != 0;
+    const bool has_effect_lifetime = (header.channel_flags & chunk_channel_effect_lifetime) != 0;
+    const bool uniform = (header.channel_flags & chunk_channel_uniform) != 0;
+
+    chunk_storage_config config{};
+    config.extent = extent;
+    config.enable_materials = has_materials;
+    config.enable_high_precision_lighting = has_sky_cache || has_block_cache;
+    config.effect_channels = effects::channel::none;
+    if (has_effect_density) {
+        config.effect_channels |= effects::channel::density;
+    }
+    if (has_effect_velocity) {
+        config.effect_channels |= effects::channel::velocity;
+    }
+    if (has_effect_lifetime) {
+        config.effect_channels |= effects::channel::lifetime;
+    }
+
+    chunk_storage chunk{config};
+
+    if (uniform) {
+        chunk_uniform_values values{};
+        const auto read_value = [&read](auto& value) { read(&value, sizeof(value)); };
+        read_value(values.voxel);
+        read_value(values.skylight);
+        read_value(values.blocklight);
+        read_value(values.metadata);
+        if (has_materials) {
+            read_value(values.material);
+        }
+        if (has_sky_cache) {
+            read_value(values.skylight_cache);
+        }
+        if (has_block_cache) {
+            read_value(values.blocklight_cache);
+        }
+        if (has_effect_density) {
+            read_value(values.effect_density);
+        }
+        if (has_effect_velocity) {
+            read_value(values.effect_velocity);
+        }
+        if (has_effect_lifetime) {
+            read_value(values.effect_lifetime);
+        }
+        chunk.fill(values);
+        chunk.mark_dirty(false);
+        return chunk;
+    }
+
+    const auto read_plane = [&read, count](auto view) {
+        using value_type = typename decltype(view)::element_type;
+        read(view.linear().data(), count * sizeof(value_type));
+    };
+
+    read_plane(chunk.voxels());
+    read_plane(chunk.skylight());
+    read_plane(chunk.blocklight());
+    read_plane(chunk.metadata());
+    if (has_materials) {
+        read_plane(chunk.materials());
+    }
+    if (has_sky_cache) {
+        read_plane(chunk.skylight_cache());
+    }
+    if (has_block_cache) {
+        read_plane(chunk.blocklight_cache());
+    }
+    if (has_effect_density) {
+        read_plane(chunk.effect_density());
+    }
+    if (has_effect_velocity) {
+        read_plane(chunk.effect_velocity());
+    }
+    if (has_effect_lifetime) {
+        read_plane(chunk.effect_lifetime());
+    }
+
+    chunk.mark_dirty(false);
+    return chunk;
+}
+
+} // namespace detail
+
+inline std::vector<std::byte> serialize_chunk(const chunk_storage& chunk) {
+    const auto extent = chunk.extent();
+    const bool has_materials = chunk.materials_enabled();
+    const bool has_high_precision = chunk.high_precision_lighting_enabled();
+    const bool has_effect_density = chunk.effect_density_enabled();
+    const bool has_effect_velocity = chunk.effect_velocity_enabled();
+    const bool has_effect_lifetime = chunk.effect_lifetime_enabled();
+
+    chunk_header_v2 header{};
+    header.extent[0] = extent.x;
+    header.extent[1] = extent.y;
+    header.extent[2] = extent.z;
+    header.channel_flags = detail::chunk_channels(chunk);
+
+    const auto uniform = chunk.uniform_values();
+    if (uniform) {
+        header.channel_flags |= chunk_channel_uniform;
+    }
+
+    const auto volume = extent.volume();
+    std::vector<std::byte> buffer;
+    buffer.reserve(sizeof(chunk_header_v2) + chunk_payload_bytes(header.channel_flags, volume));
+    append_bytes(buffer, &header, sizeof(header));
+
+    if (uniform) {
+        append_bytes(buffer, &uniform->voxel, sizeof(uniform->voxel));
+        append_bytes(buffer, &uniform->skylight, sizeof(uniform->skylight));
+        append_bytes(buffer, &uniform->blocklight, sizeof(uniform->blocklight));
+        append_bytes(buffer, &uniform->metadata, sizeof(uniform->metadata));
+        if (has_materials) {
+            append_bytes(buffer, &uniform->material, sizeof(uniform->material));
+        }
+        if (has_high_precision) {
+            append_bytes(buffer, &uniform->skylight_cache, sizeof(uniform->skylight_cache));
+            append_bytes(buffer, &uniform->blocklight_cache, sizeof(uniform->blocklight_cache));
+        }
+        if (has_effect_density) {
+            append_bytes(buffer, &uniform->effect_density, sizeof(uniform->effect_density));
+        }
+        if (has_effect_velocity) {
+            append_bytes(buffer, &uniform->effect_velocity, sizeof(uniform->effect_velocity));
+        }
+        if (has_effect_lifetime) {
+            append_bytes(buffer, &uniform->effect_lifetime, sizeof(uniform->effect_lifetime));
+        }
+        return buffer;
+    }
+
+    const auto copy_span = [&buffer](auto span) {
+        using value_type = typename decltype(span)::value_type;
+        append_bytes(buffer, span.data(), span.size() * sizeof(value_type));
+    };
+
+    std::vector<voxel_id> decoded;
+    copy_span(chunk.read_voxels(decoded).linear());
+    copy_span(chunk.skylight().linear());
+    copy_span(chunk.blocklight().linear());
+    copy_span(chunk.metadata().linear());
+
+    if (has_materials) {
+        copy_span(chunk.materials().linear());
+    }
+    if (has_high_precision) {
+        copy_span(chunk.skylight_cache().linear());
+        copy_span(chunk.blocklight_cache().linear());
+    }
+    if (has_effect_density) {
+        copy_span(chunk.effect_density().linear());
+    }
+    if (has_effect_velocity) {
+        copy_span(chunk.effect_velocity().linear());
+    }
+    if (has_effect_lifetime) {
+        copy_span(chunk.effect_lifetime().linear());
+    }
+
+    return buffer;
+}
+
+inline chunk_storage deserialize_chunk(std::span<const std::byte> bytes) {
+    if (bytes.size() < sizeof(chunk_header_v1)) {
+        throw std::runtime_error("chunk payload too small");
+    }
+
+    chunk_header_v1 header_v1{};
+    std::memcpy(&header_v1, bytes.data(), sizeof(header_v1));
+    if (std::string_view(header_v1.magic, 4) != std::string_view{chunk_magic.data(), chunk_magic.size()}) {
+        throw std::runtime_error("invalid chunk magic");
+    }
+
+    if (header_v1.version == 1) {
+        const chunk_extent extent{header_v1.extent[0], header_v1.extent[1], header_v1.extent[2]};
+        const auto count = extent.volume();
+        const std::size_t required = sizeof(chunk_header_v1) + count * (sizeof(voxel_id) + 3);
+        if (bytes.size() < required) {
+            throw std::runtime_error("chunk payload truncated");
+        }
+
+        chunk_storage_config config{};
+        config.extent = extent;
+        chunk_storage chunk{config};
+        const auto* ptr = bytes.data() + sizeof(chunk_header_v1);
+
+        auto copy_into = [&ptr, count](auto view) {
+            using value_type = typename decltype(view)::element_type;
+            std::memcpy(view.linear().data(), ptr, count * sizeof(value_type));
+            ptr += count * sizeof(value_type);
+        };
+
+        copy_into(chunk.voxels());
+        copy_into(chunk.skylight());
+        copy_into(chunk.blocklight());
+        copy_into(chunk.metadata());
+        chunk.mark_dirty(false);
+        return chunk;
+    }
+
+    if (bytes.size() < sizeof(chunk_header_v2)) {
+        throw std::runtime_error("chunk payload too small for extended header");
+    }
+
+    chunk_header_v2 header_v2{};
+    std::memcpy(&header_v2, bytes.data(), sizeof(header_v2));
+    if (header_v2.version < 2) {
+        throw std::runtime_error("unsupported chunk version");
+    }
+    detail::reject_delta_payload(header_v2);
+
+    const chunk_extent extent{header_v2.extent[0], header_v2.extent[1], header_v2.extent[2]};
+    const std::size_t required = sizeof(chunk_header_v2) + chunk_payload_bytes(header_v2.channel_flags, extent.volume());
+    if (bytes.size() < required) {
+        throw std::runtime_error("chunk payload truncated");
+    }
+
+    const auto* ptr = bytes.data() + sizeof(chunk_header_v2);
+    return detail::decode_chunk_body(header_v2, [&ptr](void* destination, std::size_t size) {
+        std::memcpy(destination, ptr, size);
+        ptr += size;
+    });
+}
+
+inline bool is_legacy_chunk_payload(std::span<const std::byte> bytes) {
+    if (bytes.size() < sizeof(chunk_header_v1)) {
+        return false;
+    }
+    chunk_header_v1 header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    return std::string_view(header.magic, 4) == std::string_view{chunk_magic.data(), chunk_magic.size()}
+        && header.version == 1;
+}
+
+inline std::vector<std::byte> migrate_legacy_chunk_payload(std::span<const std::byte> bytes) {
+    if (!is_legacy_chunk_payload(bytes)) {
+        throw std::runtime_error("chunk payload is not a legacy format");
+    }
+    chunk_storage chunk = deserialize_chunk(bytes);
+    return serialize_chunk(chunk);
+}
+
+inline void serialize_chunk_to_stream(const chunk_storage& chunk, std::ostream& out) {
+    auto payload = serialize_chunk(chunk);
+    out.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+}
+
+inline chunk_storage deserialize_chunk_from_stream(std::istream& in) {
+    chunk_header_v1 header_v1{};
+    in.read(reinterpret_cast<char*>(&header_v1), sizeof(header_v1));
+    if (!in) {
+        throw std::runtime_error("unable to read chunk header");
+    }
+    if (std::string_view(header_v1.magic, 4) != std::string_view{chunk_magic.data(), chunk_magic.size()}) {
+        throw std::runtime_error("invalid chunk magic");
+    }
+
+    if (header_v1.version == 1) {
+        const chunk_extent extent{header_v1.extent[0], header_v1.extent[1], header_v1.extent[2]};
+        const auto count = extent.volume();
+        std::vector<std::byte> payload(sizeof(chunk_header_v1) + count * (sizeof(voxel_id) + 3));
+        std::memcpy(payload.data(), &header_v1, sizeof(header_v1));
+        in.read(reinterpret_cast<char*>(payload.data() + sizeof(header_v1)),
+            static_cast<std::streamsize>(payload.size() - sizeof(header_v1)));
+        if (!in) {
+            throw std::runtime_error("unable to read chunk payload");
+        }
+        return deserialize_chunk(payload);
+    }
+
+    std::uint32_t flags = 0;
+    in.read(reinterpret_cast<char*>(&flags), sizeof(flags));
+    if (!in) {
+        throw std::runtime_error("unable to read chunk channel flags");
+    }
+
+    chunk_header_v2 header_v2{};
+    std::memcpy(&header_v2, &header_v1, sizeof(header_v1));
+    header_v2.version = header_v1.version;
+    header_v2.channel_flags = flags;
+    if (header_v2.version < 2) {
+        throw std::runtime_error("unsupported chunk version");
+    }
+    detail::reject_delta_payload(header_v2);
+
+    // Planes stream straight into the chunk instead of being staged in a temporary payload.
+    return detail::decode_chunk_body(header_v2, [&in](void* destination, std::size_t size) {
+        in.read(static_cast<char*>(destination), static_cast<std::streamsize>(size));
+        if (!in) {
+            throw std::runtime_error("unable to read chunk payload");
+        }
+    });
+}
+
+inline region_blob serialize_snapshot(const region_manager::region_snapshot& snapshot) {
+    region_blob blob;
+    blob.key = snapshot.key;
+    if (snapshot.chunk) {
+        blob.payload = serialize_chunk(*snapshot.chunk);
+    }
+    return blob;
+}
+
+template <typename Sink>
+auto make_region_serializer(Sink&& sink) {
+    return [sink = std::forward<Sink>(sink)](const region_manager::region_snapshot& snapshot) mutable {
+        sink(serialize_snapshot(snapshot));
+    };
+}
+
+template <typename Sink>
+void dump_region(const region_manager& manager, Sink&& sink, bool include_clean = false) {
+    auto&& callable = std::forward<Sink>(sink);
+    for (const auto& snapshot : manager.snapshot_loaded(include_clean)) {
+        callable(snapshot);
+    }
+}
+
+// Region streams are sequences of checked records: a 32-byte region_record_header followed by the payload. The header
+// carries a check of its own fields, so a damaged size is caught before anything is allocated, and an XXH64 of the
+// payload. Streams written before checksums were added hold bare (key, u32 size, payload) records; readers still
+// accept them, unverified.
+constexpr std::array<char, 4> region_record_magic{'A', 'V', 'R', 'B'};
+
+struct region_record_header {
+    char magic[4]{region_record_magic[0], region_record_magic[1], region_record_magic[2], region_record_magic[3]};
+    region_key key{};
+    std::uint32_t size{0};
+    std::uint32_t header_check{0};
+    std::uint64_t payload_check{0};
+};
+
+static_assert(sizeof(region_record_header) == 32, "region record header must stay 32 bytes");
+
+enum class region_record_status {
+    ok,
+    // Clean end of stream before the first byte of a record.
+    end,
+    // The stream ended inside a record, as after a crash mid-append.
+    truncated,
+    // A header or payload failed its checksum.
+    corrupt,
+};
+
+namespace detail {
+
+inline std::uint32_t record_header_check(const region_record_header& header) {
+    const auto covered = std::as_bytes(std::span{&header, 1}).first(offsetof(region_record_header, header_check));
+    return static_cast<std::uint32_t>(xxhash64(covered));
+}
+
+inline region_record_header make_record_header(const region_blob& blob) {
+    region_record_header header{};
+    header.key = blob.key;
+    header.size = static_cast<std::uint32_t>(blob.payload.size());
+    header.header_check = record_header_check(header);
+    header.payload_check = xxhash64(blob.payload);
+    return header;
+}
+
+inline bool has_record_magic(const void* bytes) {
+    return std::memcmp(bytes, region_record_magic.data(), region_record_magic.size()) == 0;
+}
+
+inline bool record_header_valid(const region_record_header& header) {
+    return has_record_magic(header.magic) && header.header_check == record_header_check(header);
+}
+
+} // namespace detail
+
+// Writes checked region records to one file through a single handle, so a world save never reopens the file per
+// chunk. Small records (uniform chunks, packed payloads, deltas) are staged in a buffer and written in large sequential
+// blocks; payloads of `direct_write_bytes` or more are written straight from the blob to avoid a second copy. write()
+// may be called from several threads; records from one call are never interleaved.
+//
+// Append mode journals: records land after the existing ones, a crash can only tear the tail record, and commit()
+// syncs what has been written. Otherwise the file is rebuilt in `<path>.tmp` and commit() atomically renames it over
+// `path`, so readers see either the previous save or the complete new one. The destructor commits unless it runs
+// during stack unwinding, in which case a rebuilt file is discarded.
+class region_writer {
+public:
+    static constexpr std::size_t default_buffer_bytes = 1u << 20u;
+    static constexpr std::size_t direct_write_bytes = 64u << 10u;
+
+    explicit region_writer(const std::filesystem::path& path, bool append = true,
+        std::size_t buffer_bytes = default_buffer_bytes);
+    region_writer(const region_writer&) = delete;
+    region_writer& operator=(const region_writer&) = delete;
+    ~region_writer();
+
+    void write(const region_blob& blob);
+    // Hands staged records to the OS without syncing or, for a rebuilt file, publishing them.
+    void flush();
+    void commit();
+
+    [[nodiscard]] std::uint64_t bytes_written() const;
+
+private:
+    void drain_locked();
+
+    std::filesystem::path path_{};
+    // Empty in append mode.
+    std::filesystem::path temporary_{};
+    std::ofstream out_;
+    std::vector<std::byte> buffer_{};
+    std::size_t capacity_{0};
+    std::uint64_t written_{0};
+    bool committed_{false};
+    int uncaught_{std::uncaught_exceptions()};
+    mutable std::mutex mutex_{};
+};
+
+inline region_writer::region_writer(const std::filesystem::path& path, bool append, std::size_t buffer_bytes)
+    : path_{path}
+    , capacity_{std::max<std::size_t>(buffer_bytes, 4096)} {
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+    if (!append) {
+        temporary_ = path;
+        temporary_ += ".tmp";
+    }
+    out_.open(append ? path_ : temporary_, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    if (!out_) {
+        throw std::runtime_error("failed to open region file");
+    }
+    buffer_.reserve(capacity_);
+}
+
+inline region_writer::~region_writer() {
+    try {
+        if (temporary_.empty()) {
+            flush();
+        } else if (!committed_ && std::uncaught_exceptions() > uncaught_) {
+            out_.close();
+            std::error_code ignored;
+            std::filesystem::remove(temporary_, ignored);
+        } else if (!committed_) {
+            commit();
+        }
+    } catch (...) {
+        // Destructors must not throw; call commit() explicitly to observe write errors.
+    }
+}
+
+inline void region_writer::write(const region_blob& blob) {
+    const auto header = detail::make_record_header(blob);
+    const std::size_t record = sizeof(header) + blob.payload.size();
+    std::scoped_lock lock{mutex_};
+    if (committed_) {
+        throw std::logic_error("region writer already committed");
+    }
+    if (buffer_.size() + record > capacity_) {
+        drain_locked();
+    }
+    append_bytes(buffer_, &header, sizeof(header));
+    if (blob.payload.size() >= direct_write_bytes || record > capacity_) {
+        drain_locked();
+        out_.write(reinterpret_cast<const char*>(blob.payload.data()), static_cast<std::streamsize>(header.size));
+        written_ += header.size;
+    } else {
+        append_bytes(buffer_, blob.payload.data(), blob.payload.size());
+    }
+    if (!out_) {
+        throw std::runtime_error("failed to write region file");
+    }
+}
+
+inline void region_writer::flush() {
+    std::scoped_lock lock{mutex_};
+    if (committed_) {
+        return;
+    }
+    drain_locked();
+    out_.flush();
+    if (!out_) {
+        throw std::runtime_error("failed to write region file");
+    }
+}
+
+inline void region_writer::commit() {
+    std::scoped_lock lock{mutex_};
+    if (committed_) {
+        return;
+    }
+    drain_locked();
+    out_.flush();
+    if (!out_) {
+        throw std::runtime_error("failed to write region file");
+    }
+    if (temporary_.empty()) {
+        sync_file(path_);
+        return;
+    }
+    out_.close();
+    commit_file(temporary_, path_);
+    committed_ = true;
+}
+
+inline std::uint64_t region_writer::bytes_written() const {
+    std::scoped_lock lock{mutex_};
+    return written_ + buffer_.size();
+}
+
+inline void region_writer::drain_locked() {
+    if (buffer_.empty()) {
+        return;
+    }
+    out_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    written_ += buffer_.size();
+    buffer_.clear();
+    if (!out_) {
+        throw std::runtime_error("failed to write region file");
+    }
+}
+
+// Appends blobs to `path` through one shared region_writer. Copies of the sink share the handle; the file is flushed
+// when the last copy is destroyed.
+inline auto file_sink(const std::filesystem::path& path) {
+    auto writer = std::make_shared<region_writer>(path);
+    return [writer](const region_blob& blob) { writer->write(blob); };
+}
+
+// Reads the next record into `blob`. On anything but ok, `blob` is unspecified and the stream position is undefined.
+inline region_record_status read_region_record(std::istream& in, region_blob& blob) {
+    region_record_header header{};
+    auto* raw = reinterpret_cast<char*>(&header);
+    in.read(raw, sizeof(header.magic));
+    if (in.gcount() == 0) {
+        return region_record_status::end;
+    }
+    if (!in) {
+        return region_record_status::truncated;
+    }
+    const bool checked = detail::has_record_magic(header.magic);
+    if (checked) {
+        in.read(raw + sizeof(header.magic), sizeof(header) - sizeof(header.magic));
+        if (!in) {
+            return region_record_status::truncated;
+        }
+        if (!detail::record_header_valid(header)) {
+            return region_record_status::corrupt;
+        }
+        blob.key = header.key;
+    } else {
+        // Legacy record: the four bytes already read are key.x.
+        std::memcpy(&blob.key.x, header.magic, sizeof(blob.key.x));
+        in.read(reinterpret_cast<char*>(&blob.key.y), sizeof(blob.key.y));
+        in.read(reinterpret_cast<char*>(&blob.key.z), sizeof(blob.key.z));
+        in.read(reinterpret_cast<char*>(&header.size), sizeof(header.size));
+        if (!in) {
+            return region_record_status::truncated;
+        }
+    }
+    blob.payload.resize(header.size);
+    in.read(reinterpret_cast<char*>(blob.payload.data()), static_cast<std::streamsize>(header.size));
+    if (!in) {
+        return region_record_status::truncated;
+    }
+    if (checked && xxhash64(blob.payload) != header.payload_check) {
+        return region_record_status::corrupt;
+    }
+    return region_record_status::ok;
+}
+
+// Returns std::nullopt at a clean end of stream and throws std::runtime_error on a truncated or corrupt record; use
+// salvage_region_file() to recover what a damaged stream still holds.
+inline std::optional<region_blob> read_region_blob(std::istream& in) {
+    region_blob blob;
+    switch (read_region_record(in, blob)) {
+    case region_record_status::ok:
+        return blob;
+    case region_record_status::end:
+        return std::nullopt;
+    case region_record_status::truncated:
+        throw std::runtime_error("truncated region record");
+    case region_record_status::corrupt:
+        break;
+    }
+    throw std::runtime_error("corrupt region record");
+}
+
+struct region_salvage_report {
+    // Last intact copy of every key, in the order keys first appear.
+    std::vector<region_blob> blobs;
+    std::size_t records{0};
+    // Damaged spans skipped while resynchronising on the record magic, and their total size.
+    std::size_t damaged{0};
+    std::size_t skipped_bytes{0};
+};
+
+// Scans checked records, skipping damage by resynchronising on the next record magic, so an append-mode journal that
+// was torn mid-write or bit-rotted still yields the latest good copy of every chunk. Legacy records cannot be verified
+// and are skipped as damage.
+inline region_salvage_report salvage_region_blobs(std::span<const std::byte> bytes) {
+    region_salvage_report report;
+    std::unordered_map<region_key, std::size_t, region_key_hash> positions;
+    std::size_t offset = 0;
+    bool damaged = false;
+    while (offset < bytes.size()) {
+        const auto remaining = bytes.size() - offset;
+        region_record_header header{};
+        if (remaining >= sizeof(header)) {
+            std::memcpy(&header, bytes.data() + offset, sizeof(header));
+        }
+        if (remaining >= sizeof(header) && detail::record_header_valid(header)
+            && header.size <= remaining - sizeof(header)) {
+            const auto payload = bytes.subspan(offset + sizeof(header), header.size);
+            if (xxhash64(payload) == header.payload_check) {
+                region_blob blob{header.key, std::vector<std::byte>(payload.begin(), payload.end())};
+                const auto [it, inserted] = positions.try_emplace(blob.key, report.blobs.size());
+                if (inserted) {
+                    report.blobs.push_back(std::move(blob));
+                } else {
+                    report.blobs[it->second] = std::move(blob);
+                }
+                ++report.records;
+                offset += sizeof(header) + header.size;
+                damaged = false;
+                continue;
+            }
+        }
+
+        const auto* next = std::search(bytes.data() + offset + 1, bytes.data() + bytes.size(),
+            reinterpret_cast<const std::byte*>(region_record_magic.data()),
+            reinterpret_cast<const std::byte*>(region_record_magic.data()) + region_record_magic.size());
+        const auto skipped = static_cast<std::size_t>(next - (bytes.data() + offset));
+        report.skipped_bytes += skipped;
+        report.damaged += damaged ? 0 : 1;
+        damaged = true;
+        offset += skipped;
+    }
+    return report;
+}
+
+inline region_salvage_report salvage_region_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("failed to open region file");
+    }
+    std::vector<std::byte> bytes(static_cast<std::size_t>(std::filesystem::file_size(path)));
+    in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!in) {
+        throw std::runtime_error("failed to read region file");
+    }
+    return salvage_region_blobs(bytes);
+}
+
+// Salvages `path` and atomically rewrites it with only the surviving records.
+inline region_salvage_report repair_region_file(const std::filesystem::path& path) {
+    auto report = salvage_region_file(path);
+    region_writer writer{path, false};
+    for (const auto& blob : report.blobs) {
+        writer.write(blob);
+    }
+    writer.commit();
+    return report;
+}
+
+// Packed payloads wrap a serialized chunk in a codec stream: magic, codec id byte, u32 raw size, encoded bytes.
+constexpr std::array<char, 4> packed_chunk_magic{'A', 'V', 'C', 'Z'};
+inline constexpr std::size_t packed_chunk_header = 9;
+
+inline bool is_packed_chunk_payload(std::span<const std::byte> bytes) {
+    return bytes.size() >= packed_chunk_header
+        && std::memcmp(bytes.data(), packed_chunk_magic.data(), packed_chunk_magic.size()) == 0;
+}
+
+inline std::vector<std::byte> pack_chunk_payload(std::span<const std::byte> payload, codec_id codec) {
+    std::vector<std::byte> packed;
+    append_bytes(packed, packed_chunk_magic.data(), packed_chunk_magic.size());
+    packed.push_back(std::byte{0});
+    const auto size = static_cast<std::uint32_t>(payload.size());
+    append_bytes(packed, &size, sizeof(size));
+    const auto used = codec_registry::shared().encode(codec, payload, 1, packed);
+    packed[packed_chunk_magic.size()] = static_cast<std::byte>(used);
+    return packed;
+}
+
+inline std::vector<std::byte> unpack_chunk_payload(std::span<const std::byte> bytes) {
+    if (!is_packed_chunk_payload(bytes)) {
+        throw std::runtime_error("payload is not a packed chunk");
+    }
+    const auto codec = static_cast<codec_id>(std::to_integer<std::uint8_t>(bytes[packed_chunk_magic.size()]));
+    std::uint32_t size = 0;
+    std::memcpy(&size, bytes.data() + packed_chunk_magic.size() + 1, sizeof(size));
+    std::vector<std::byte> payload(size);
+    codec_registry::shared().decode(codec, bytes.subspan(packed_chunk_header), payload, 1);
+    return payload;
+}
+
+// Accepts plain and packed chunk payloads.
+inline chunk_storage deserialize_region_payload(std::span<const std::byte> bytes) {
+    if (is_packed_chunk_payload(bytes)) {
+        return deserialize_chunk(unpack_chunk_payload(bytes));
+    }
+    return deserialize_chunk(bytes);
+}
+
+inline void ingest_blob(region_manager& manager, const region_blob& blob) {
+    auto& target = manager.replace(blob.key, deserialize_region_payload(blob.payload));
+    target.mark_dirty(false);
+}
+
+struct batch_io_options {
+    // Chunks serialized or decoded per batch. The next batch runs on the pool while the caller writes or installs the
+    // previous one, so at most two batches are held in memory.
+    std::size_t batch_size{16};
+    // Codec applied to each serialized chunk; `raw` writes plain payloads.
+    codec_id codec{codec_id::raw};
+    bool include_clean{false};
+};
+
+namespace detail {
+
+template <typename Result>
+struct io_batch {
+    explicit io_batch(std::size_t count) : results(count), errors(count), pending{count} {}
+
+    void finish_one() {
+        std::scoped_lock lock{mutex};
+        if (--pending == 0) {
+            finished.notify_all();
+        }
+    }
+
+    void wait() {
+        std::unique_lock lock{mutex};
+        finished.wait(lock, [this] { return pending == 0; });
+    }
+
+    std::vector<Result> results;
+    std::vector<std::exception_ptr> errors;
+    std::size_t pending{0};
+    std::mutex mutex{};
+    std::condition_variable finished{};
+};
+
+// Runs produce(i) for i in [0, count) on the pool, one job per item. Pool jobs must not throw, so failures are kept
+// per item and rethrown by finish_batch().
+template <typename Result, typename Produce>
+std::unique_ptr<io_batch<Result>> launch_batch(parallel::task_pool& pool, std::size_t count, Produce produce) {
+    auto batch = std::make_unique<io_batch<Result>>(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        pool.submit([state = batch.get(), i, produce] {
+            try {
+                state->results[i] = produce(i);
+            } catch (...) {
+                state->errors[i] = std::current_exception();
+            }
+            state->finish_one();
+        });
+    }
+    return batch;
+}
+
+template <typename Result>
+std::vector<Result>& finish_batch(io_batch<Result>& batch) {
+    batch.wait();
+    for (const auto& error : batch.errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return batch.results;
+}
+
+// Waits for an in-flight batch before an exception unwinds past the state its jobs reference.
+template <typename Result>
+struct batch_join {
+    std::unique_ptr<io_batch<Result>>& batch;
+    ~batch_join() {
+        if (batch) {
+            batch->wait();
+        }
+    }
+};
+
+} // namespace detail
+
+// Serializes every dirty (or, with include_clean, every) resident chunk on `pool` and hands the blobs to `sink` on the
+// calling thread in snapshot order. Chunks are copy-on-write snapshots, so editing may continue meanwhile. Must not be
+// called from one of the pool's workers. Returns the number of blobs written.
+template <typename BlobSink>
+std::size_t dump_region_parallel(const region_manager& manager, parallel::task_pool& pool, BlobSink&& sink,
+    const batch_io_options& options = {}) {
+    const auto snapshots = manager.snapshot_loaded(options.include_clean);
+    const auto batch_size = std::max<std::size_t>(options.batch_size, 1);
+    const auto codec = options.codec;
+    const auto launch = [&](std::size_t begin) {
+        const auto* first = snapshots.data() + begin;
+        return detail::launch_batch<region_blob>(pool, std::min(batch_size, snapshots.size() - begin),
+            [first, codec](std::size_t i) {
+                auto blob = serialize_snapshot(first[i]);
+                if (codec != codec_id::raw) {
+                    blob.payload = pack_chunk_payload(blob.payload, codec);
+                }
+                return blob;
+            });
+    };
+
+    std::unique_ptr<detail::io_batch<region_blob>> next;
+    const detail::batch_join<region_blob> join{next};
+    for (std::size_t begin = 0; begin < snapshots.size(); begin += batch_size) {
+        auto current = next ? std::move(next) : launch(begin);
+        if (begin + batch_size < snapshots.size()) {
+            next = launch(begin + batch_size);
+        }
+        for (const auto& blob : detail::finish_batch(*current)) {
+            sink(blob);
+        }
+    }
+    return snapshots.size();
+}
+
+// Reads blobs from `in` in batches, decodes each batch on `pool` while the next one is read, and installs the chunks
+// on the calling thread in file order, so later records for a key win. Must be called from the region manager's owner
+// thread and not from one of the pool's workers. Returns the number of chunks ingested.
+inline std::size_t ingest_parallel(region_manager& manager, parallel::task_pool& pool, std::istream& in,
+    const batch_io_options& options = {}) {
+    const auto batch_size = std::max<std::size_t>(options.batch_size, 1);
+    struct decoded {
+        region_key key{};
+        std::optional<chunk_storage> chunk;
+    };
+    const auto read_batch = [&] {
+        std::vector<region_blob> blobs;
+        blobs.reserve(batch_size);
+        while (blobs.size() < batch_size) {
+            auto blob = read_region_blob(in);
+            if (!blob) {
+                break;
+            }
+            blobs.push_back(std::move(*blob));
+        }
+        return blobs;
+    };
+    const auto launch = [&](const std::vector<region_blob>& blobs) {
+        const auto* first = blobs.data();
+        return detail::launch_batch<decoded>(pool, blobs.size(), [first](std::size_t i) {
+            return decoded{first[i].key, deserialize_region_payload(first[i].payload)};
+        });
+    };
+
+    std::size_t ingested = 0;
+    auto blobs = read_batch();
+    std::unique_ptr<detail::io_batch<decoded>> current;
+    const detail::batch_join<decoded> join{current};
+    while (!blobs.empty()) {
+        current = launch(blobs);
+        auto upcoming = read_batch();
+        for (auto& item : detail::finish_batch(*current)) {
+            manager.replace(item.key, std::move(*item.chunk)).mark_dirty(false);
+            ++ingested;
+        }
+        current.reset();
+        blobs = std::move(upcoming);
+    }
+    return ingested;
+}
+
+} // namespace almond::voxel::serialization
+// end: almond_voxel/serialization/region_io.hpp
+
+// begin: almond_voxel/serialization/chunk_delta.hpp
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace almond::voxel::serialization {
+
+// Delta payloads patch a chunk from a baseline state to a newer one. Layout after the v2 header: u64 base revision,
+// u64 revision, then one record per changed plane: plane index byte, varint run count, and per run a varint count of
+// unchanged cells to skip, a varint run length and the new raw cell values. Planes without a record are unchanged.
+struct chunk_delta_info {
+    chunk_extent extent{};
+    std::uint32_t channel_flags{0};
+    std::uint64_t base_revision{0};
+    std::uint64_t revision{0};
+    chunk_plane planes{chunk_plane::none};
+};
+
+namespace detail {
+
+inline constexpr std::size_t chunk_delta_prefix = sizeof(chunk_header_v2) + 2 * sizeof(std::uint64_t);
+
+template <typename T>
+void append_plane_delta(std::vector<std::byte>& out, chunk_plane plane, std::span<const T> current,
+    std::span<const T> baseline) {
+    // Snapshots share untouched planes with their chunk, so identical buffers skip the comparison entirely.
+    if (current.data() == baseline.data()) {
+        return;
+    }
+    constexpr std::size_t block = 64 / sizeof(T) == 0 ? 1 : 64 / sizeof(T);
+    const auto equal = [&](std::size_t index, std::size_t count) {
+        return std::memcmp(current.data() + index, baseline.data() + index, count * sizeof(T)) == 0;
+    };
+
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    std::size_t index = 0;
+    const auto count = current.size();
+    while (index < count) {
+        while (index + block <= count && equal(index, block)) {
+            index += block;
+        }
+        while (index < count && equal(index, 1)) {
+            ++index;
+        }
+        if (index == count) {
+            break;
+        }
+        const auto start = index;
+        while (index < count && !equal(index, 1)) {
+            ++index;
+        }
+        runs.emplace_back(start, index - start);
+    }
+    if (runs.empty()) {
+        return;
+    }
+
+    out.push_back(static_cast<std::byte>(voxel::detail::plane_index(plane)));
+    voxel::detail::codecs::put_varint(out, runs.size());
+    std::size_t cursor = 0;
+    for (const auto& [start, length] : runs) {
+        voxel::detail::codecs::put_varint(out, start - cursor);
+        voxel::detail::codecs::put_varint(out, length);
+        append_bytes(out, current.data() + start, length * sizeof(T));
+        cursor = start + length;
+    }
+}
+
+// Diffs one plane of `current` against `baseline`. `read(chunk, scratch)` returns a chunk's cells. A side whose plane
+// is uniform (its value passed instead of nullptr) is compared by value or stood in for by `scratch`, so lazy planes
+// are never materialised just to be diffed.
+template <typename T, typename Read>
+void diff_chunk_plane(std::vector<std::byte>& out, chunk_plane plane, const chunk_storage& current,
+    const chunk_storage& baseline, const T* current_uniform, const T* baseline_uniform, Read&& read) {
+    if (current_uniform && baseline_uniform && std::memcmp(current_uniform, baseline_uniform, sizeof(T)) == 0) {
+        return;
+    }
+    std::vector<T> current_scratch;
+    std::vector<T> baseline_scratch;
+    const auto cells = [&](const chunk_storage& chunk, const T* uniform, std::vector<T>& scratch) {
+        if (uniform == nullptr) {
+            return read(chunk, scratch);
+        }
+        scratch.assign(chunk.volume(), *uniform);
+        return std::span<const T>{scratch};
+    };
+    append_plane_delta<T>(out, plane, cells(current, current_uniform, current_scratch),
+        cells(baseline, baseline_uniform, baseline_scratch));
+}
+
+// Walks the runs of one plane record, calling `write(cell, source, length)` per run. Returns the offset past the record.
+template <typename T, typename Write>
+std::size_t read_plane_delta(std::span<const std::byte> bytes, std::size_t offset, std::size_t count, Write&& write) {
+    const auto runs = voxel::detail::codecs::get_varint(bytes, offset);
+    std::size_t cursor = 0;
+    for (std::uint64_t run = 0; run < runs; ++run) {
+        const auto skip = voxel::detail::codecs::get_varint(bytes, offset);
+        const auto length = voxel::detail::codecs::get_varint(bytes, offset);
+        if (skip > count - cursor || length > count - cursor - skip
+            || length > (bytes.size() - offset) / sizeof(T)) {
+            throw std::runtime_error("malformed chunk delta");
+        }
+        cursor += static_cast<std::size_t>(skip);
+        write(cursor, bytes.data() + offset, static_cast<std::size_t>(length));
+        offset += static_cast<std::size_t>(length) * sizeof(T);
+        cursor += static_cast<std::size_t>(length);
+    }
+    return offset;
+}
+
+// Calls `visit(view)` with a callable returning the writable view of `plane`; throws for planes the chunk lacks.
+template <typename Visit>
+void visit_delta_plane(chunk_storage& chunk, chunk_plane plane, Visit&& visit) {
+    switch (plane) {
+    case chunk_plane::voxels:
+        visit([&] { return chunk.voxels(); });
+        return;
+    case chunk_plane::skylight:
+        visit([&] { return chunk.skylight(); });
+        return;
+    case chunk_plane::blocklight:
+        visit([&] { return chunk.blocklight(); });
+        return;
+    case chunk_plane::metadata:
+        visit([&] { return chunk.metadata(); });
+        return;
+    case chunk_plane::materials:
+        if (chunk.materials_enabled()) {
+            visit([&] { return chunk.materials(); });
+            return;
+        }
+        break;
+    case chunk_plane::skylight_cache:
+        if (chunk.high_precision_lighting_enabled()) {
+            visit([&] { return chunk.skylight_cache(); });
+            return;
+        }
+        break;
+    case chunk_plane::blocklight_cache:
+        if (chunk.high_precision_lighting_enabled()) {
+            visit([&] { return chunk.blocklight_cache(); });
+            return;
+        }
+        break;
+    case chunk_plane::effect_density:
+        if (chunk.effect_density_enabled()) {
+            visit([&] { return chunk.effect_density(); });
+            return;
+        }
+        break;
+    case chunk_plane::effect_velocity:
+        if (chunk.effect_velocity_enabled()) {
+            visit([&] { return chunk.effect_velocity(); });
+            return;
+        }
+        break;
+    case chunk_plane::effect_lifetime:
+        if (chunk.effect_lifetime_enabled()) {
+            visit([&] { return chunk.effect_lifetime(); });
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+    throw std::runtime_error("malformed chunk delta");
+}
 
-// begin: almond_voxel/meshing/marching_cubes.hpp
+} // namespace detail
+
+inline bool is_chunk_delta(std::span<const std::byte> bytes) {
+    if (bytes.size() < sizeof(chunk_header_v2)) {
+        return false;
+    }
+    chunk_header_v2 header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    return std::string_view(header.magic, 4) == std::string_view{chunk_magic.data(), chunk_magic.size()}
+        && header.version == chunk_version_delta && (header.channel_flags & chunk_channel_delta) != 0;
+}
+
+// Encodes the cells of `chunk` that differ from `baseline`. Both chunks must share an extent and channel layout; pass
+// a snapshot taken at the last save as the baseline so shared planes are skipped without being compared.
+inline std::vector<std::byte> serialize_chunk_delta(const chunk_storage& chunk, const chunk_storage& baseline) {
+    const auto extent = chunk.extent();
+    const auto channels = detail::chunk_channels(chunk);
+    if (baseline.extent() != extent || detail::chunk_channels(baseline) != channels) {
+        throw std::runtime_error("chunk delta baseline has a different layout");
+    }
+
+    chunk_header_v2 header{};
+    header.version = chunk_version_delta;
+    header.extent[0] = extent.x;
+    header.extent[1] = extent.y;
+    header.extent[2] = extent.z;
+    header.channel_flags = channels | chunk_channel_delta;
+
+    std::vector<std::byte> buffer;
+    buffer.reserve(detail::chunk_delta_prefix);
+    append_bytes(buffer, &header, sizeof(header));
+    const std::uint64_t revisions[2]{baseline.revision(), chunk.revision()};
+    append_bytes(buffer, revisions, sizeof(revisions));
+
+    const auto current_uniform = chunk.uniform_planes();
+    const auto baseline_uniform = baseline.uniform_planes();
+    const auto diff = [&](chunk_plane plane, auto chunk_uniform_values::*value, auto read) {
+        const auto uniform = [&](const chunk_uniform_planes& planes) {
+            return contains(planes.planes, plane) ? &(planes.values.*value) : nullptr;
+        };
+        detail::diff_chunk_plane(buffer, plane, chunk, baseline, uniform(current_uniform), uniform(baseline_uniform),
+            read);
+    };
+    diff(chunk_plane::voxels, &chunk_uniform_values::voxel,
+        [](const chunk_storage& source, std::vector<voxel_id>& scratch) { return source.read_voxels(scratch).linear(); });
+    diff(chunk_plane::skylight, &chunk_uniform_values::skylight,
+        [](const chunk_storage& source, auto&) { return source.skylight().linear(); });
+    diff(chunk_plane::blocklight, &chunk_uniform_values::blocklight,
+        [](const chunk_storage& source, auto&) { return source.blocklight().linear(); });
+    diff(chunk_plane::metadata, &chunk_uniform_values::metadata,
+        [](const chunk_storage& source, auto&) { return source.metadata().linear(); });
+    if (chunk.materials_enabled()) {
+        diff(chunk_plane::materials, &chunk_uniform_values::material,
+            [](const chunk_storage& source, auto&) { return source.materials().linear(); });
+    }
+    if (chunk.high_precision_lighting_enabled()) {
+        diff(chunk_plane::skylight_cache, &chunk_uniform_values::skylight_cache,
+            [](const chunk_storage& source, auto&) { return source.skylight_cache().linear(); });
+        diff(chunk_plane::blocklight_cache, &chunk_uniform_values::blocklight_cache,
+            [](const chunk_storage& source, auto&) { return source.blocklight_cache().linear(); });
+    }
+    if (chunk.effect_density_enabled()) {
+        diff(chunk_plane::effect_density, &chunk_uniform_values::effect_density,
+            [](const chunk_storage& source, auto&) { return source.effect_density().linear(); });
+    }
+    if (chunk.effect_velocity_enabled()) {
+        diff(chunk_plane::effect_velocity, &chunk_uniform_values::effect_velocity,
+            [](const chunk_storage& source, auto&) { return source.effect_velocity().linear(); });
+    }
+    if (chunk.effect_lifetime_enabled()) {
+        diff(chunk_plane::effect_lifetime, &chunk_uniform_values::effect_lifetime,
+            [](const chunk_storage& source, auto&) { return source.effect_lifetime().linear(); });
+    }
+    return buffer;
+}
+
+// Reads the header and revisions of a delta without applying it. `planes` is left empty.
+inline chunk_delta_info read_chunk_delta_info(std::span<const std::byte> bytes) {
+    if (bytes.size() < detail::chunk_delta_prefix || !is_chunk_delta(bytes)) {
+        throw std::runtime_error("payload is not a chunk delta");
+    }
+    chunk_header_v2 header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    chunk_delta_info info{};
+    info.extent = chunk_extent{header.extent[0], header.extent[1], header.extent[2]};
+    info.channel_flags = header.channel_flags & ~chunk_channel_delta;
+    std::memcpy(&info.base_revision, bytes.data() + sizeof(header), sizeof(info.base_revision));
+    std::memcpy(&info.revision, bytes.data() + sizeof(header) + sizeof(info.base_revision), sizeof(info.revision));
+    return info;
+}
+
+// Patches `chunk` in place. The chunk should hold the delta's baseline state; callers that track revisions can compare
+// read_chunk_delta_info().base_revision before applying. The whole payload is validated before the first cell is
+// written, so a malformed or truncated delta throws and leaves the chunk untouched. Listeners fire once for the union
+// of patched planes.
+inline chunk_delta_info apply_chunk_delta(chunk_storage& chunk, std::span<const std::byte> bytes) {
+    auto info = read_chunk_delta_info(bytes);
+    if (info.extent != chunk.extent() || info.channel_flags != detail::chunk_channels(chunk)) {
+        throw std::runtime_error("chunk delta does not match the target chunk layout");
+    }
+
+    const auto count = chunk.volume();
+    const auto extent = chunk.extent();
+    // Walks every plane record; `patch(plane, view, offset)` reads one record and returns the offset past it.
+    const auto walk = [&](auto&& patch) {
+        std::size_t offset = detail::chunk_delta_prefix;
+        while (offset < bytes.size()) {
+            const auto index = std::to_integer<std::uint32_t>(bytes[offset++]);
+            if (index >= chunk_plane_count) {
+                throw std::runtime_error("malformed chunk delta");
+            }
+            const auto plane = static_cast<chunk_plane>(1u << index);
+            detail::visit_delta_plane(chunk, plane, [&](auto view) { offset = patch(plane, view, offset); });
+            info.planes |= plane;
+        }
+    };
+
+    walk([&](chunk_plane, auto view, std::size_t offset) {
+        using value_type = typename decltype(view())::element_type;
+        return detail::read_plane_delta<value_type>(bytes, offset, count,
+            [](std::size_t, const std::byte*, std::size_t) {});
+    });
+
+    auto scope = chunk.edit();
+    walk([&](chunk_plane plane, auto view, std::size_t offset) {
+        using value_type = typename decltype(view())::element_type;
+        if (plane == chunk_plane::voxels && chunk.palette() != nullptr) {
+            // Keep palette chunks packed; patches are usually a handful of cells.
+            return detail::read_plane_delta<voxel_id>(bytes, offset, count,
+                [&](std::size_t cell, const std::byte* source, std::size_t length) {
+                    for (std::size_t i = 0; i < length; ++i, ++cell) {
+                        voxel_id value{};
+                        std::memcpy(&value, source + i * sizeof(voxel_id), sizeof(voxel_id));
+                        const auto x = static_cast<std::uint32_t>(cell % extent.x);
+                        const auto y = static_cast<std::uint32_t>((cell / extent.x) % extent.y);
+                        const auto z = static_cast<std::uint32_t>(cell / (static_cast<std::size_t>(extent.x) * extent.y));
+                        chunk.set_voxel(x, y, z, value);
+                    }
+                });
+        }
+        auto* data = view().linear().data();
+        return detail::read_plane_delta<value_type>(bytes, offset, count,
+            [data](std::size_t cell, const std::byte* source, std::size_t length) {
+                std::memcpy(data + cell, source, length * sizeof(value_type));
+            });
+    });
+    return info;
+}
+
+} // namespace almond::voxel::serialization
+// end: almond_voxel/serialization/chunk_delta.hpp
+
+// begin: almond_voxel/serialization/region_file.hpp
 
 
+#include <algorithm>
 #include <array>
-#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
-namespace almond::voxel::meshing {
+namespace almond::voxel::serialization {
 
-struct marching_cubes_config {
-    // Scalar threshold for the implicit surface. Sample values strictly below the iso value are
-    // classified as solid, while values greater than or equal to the iso value are treated as empty.
-    float iso_value{0.5f};
+// Version 2 stores a payload checksum in each index entry; version 1 files are still read, unverified.
+constexpr std::uint32_t region_file_version = 2;
+constexpr std::array<char, 4> region_file_magic{'A', 'V', 'R', 'G'};
+
+struct region_file_config {
+    // Chunks per axis covered by one file.
+    std::uint32_t region_size{16};
+    std::uint32_t sector_size{4096};
+    // Sync each relocated payload to disk before its index entry is repointed, so a power loss cannot leave the entry
+    // pointing at sectors that never reached the disk. Costs one fsync per write.
+    bool sync_writes{false};
+};
+
+struct region_file_header {
+    char magic[4]{region_file_magic[0], region_file_magic[1], region_file_magic[2], region_file_magic[3]};
+    std::uint32_t version{region_file_version};
+    std::uint32_t region_size{16};
+    std::uint32_t sector_size{4096};
+    std::int32_t region[3]{0, 0, 0};
+    std::uint32_t reserved{0};
+};
+
+// Index slot for one chunk. sector_count == 0 marks an empty slot.
+struct region_file_entry {
+    std::uint32_t sector{0};
+    std::uint32_t sector_count{0};
+    std::uint32_t size{0};
+    // Low 32 bits of the payload's XXH64.
+    std::uint32_t checksum{0};
 };
 
 namespace detail {
 
-inline constexpr std::array<std::array<int, 3>, 8> cube_corners{{
-    {{0, 0, 0}},
-    {{1, 0, 0}},
-    {{1, 1, 0}},
-    {{0, 1, 0}},
-    {{0, 0, 1}},
-    {{1, 0, 1}},
-    {{1, 1, 1}},
-    {{0, 1, 1}},
-}};
+inline std::uint32_t region_payload_checksum(std::span<const std::byte> payload) {
+    return static_cast<std::uint32_t>(xxhash64(payload));
+}
 
-inline constexpr std::array<std::array<int, 2>, 12> edge_connection{{
-    {{0, 1}},
-    {{1, 2}},
-    {{2, 3}},
-    {{3, 0}},
-    {{4, 5}},
-    {{5, 6}},
-    {{6, 7}},
-    {{7, 4}},
-    {{0, 4}},
-    {{1, 5}},
-    {{2, 6}},
-    {{3, 7}},
-}};
+} // namespace detail
 
-inline std::array<float, 3> interpolate_vertex(const std::array<float, 3>& p0, const std::array<float, 3>& p1,
-    float v0, float v1, float iso_value) {
-    const float delta = v1 - v0;
-    if (std::abs(delta) < 1e-6f) {
-        return p0;
-    }
-    const float mu = (iso_value - v0) / delta;
-    return std::array<float, 3>{
-        p0[0] + mu * (p1[0] - p0[0]),
-        p0[1] + mu * (p1[1] - p0[1]),
-        p0[2] + mu * (p1[2] - p0[2])
+// Region container: a fixed header, an index table keyed by local chunk coordinates, then sector-aligned payloads.
+// Writes never overwrite live sectors: the payload goes to the first free run and the index entry is repointed (and
+// the old sectors released) only afterwards, so a crash mid-write leaves the previous copy reachable. read() verifies
+// each payload against its checksum. compact() rebuilds the packed file beside the original and swaps it in with
+// commit_file(). The first write to a version 1 file checksums its payloads and upgrades the header to version 2.
+class region_file {
+public:
+    explicit region_file(std::filesystem::path path, region_key region = {}, region_file_config config = {});
+
+    [[nodiscard]] static region_key region_of(const region_key& chunk, std::uint32_t region_size) noexcept;
+
+    [[nodiscard]] const std::filesystem::path& path() const noexcept { return path_; }
+    [[nodiscard]] region_key region() const noexcept {
+        return region_key{header_.region[0], header_.region[1], header_.region[2]};
+    }
+    [[nodiscard]] std::uint32_t region_size() const noexcept { return header_.region_size; }
+    [[nodiscard]] std::uint32_t sector_size() const noexcept { return header_.sector_size; }
+    [[nodiscard]] bool covers(const region_key& chunk) const noexcept;
+
+    [[nodiscard]] bool contains(const region_key& chunk) const;
+    [[nodiscard]] std::optional<std::vector<std::byte>> read(const region_key& chunk);
+    void write(const region_key& chunk, std::span<const std::byte> payload);
+    bool erase(const region_key& chunk);
+
+    [[nodiscard]] std::optional<chunk_storage> load_chunk(const region_key& chunk);
+    void store_chunk(const region_key& chunk, const chunk_storage& storage);
+
+    // Returns the number of bytes released.
+    std::size_t compact();
+    void flush();
+
+    [[nodiscard]] std::size_t chunk_count() const noexcept;
+    [[nodiscard]] std::size_t sector_count() const noexcept { return used_.size(); }
+    [[nodiscard]] std::size_t used_sectors() const noexcept;
+    [[nodiscard]] std::uintmax_t file_size() const noexcept { return std::uintmax_t{used_.size()} * header_.sector_size; }
+
+private:
+    [[nodiscard]] std::size_t slot(const region_key& chunk) const;
+    [[nodiscard]] std::size_t data_sector() const noexcept;
+    [[nodiscard]] std::uint32_t sectors_for(std::size_t bytes) const noexcept;
+    [[nodiscard]] std::uint32_t allocate(std::uint32_t count);
+    void mark(std::uint32_t sector, std::uint32_t count, bool used);
+    void write_preamble(std::ostream& out, std::span<const region_file_entry> index) const;
+    void upgrade_version();
+    void write_entry(std::size_t index);
+    void write_payload(std::uint32_t sector, std::uint32_t count, std::span<const std::byte> payload);
+    void read_payload(const region_file_entry& entry, std::span<std::byte> out);
+    void open_stream();
+
+    std::filesystem::path path_{};
+    std::fstream stream_{};
+    region_file_header header_{};
+    std::vector<region_file_entry> index_{};
+    std::vector<bool> used_{};
+    bool sync_writes_{false};
+};
+
+// Maps chunk keys onto one region_file per region inside a directory and keeps the files open. Safe to share between
+// threads, so it can back region_manager loaders that run on worker threads. Each file has its own lock, so chunks in
+// different regions load and save in parallel; chunk (de)serialisation runs outside the file locks.
+class region_store {
+public:
+    explicit region_store(std::filesystem::path directory, region_file_config config = {});
+
+    [[nodiscard]] std::optional<chunk_storage> load(const region_key& chunk);
+    void save(const region_key& chunk, const chunk_storage& storage);
+    bool erase(const region_key& chunk);
+    void flush();
+
+    // Loader that falls back to `fallback` (or an empty chunk of `extent`) when the chunk was never stored.
+    [[nodiscard]] region_manager::loader_type loader(chunk_extent extent, region_manager::loader_type fallback = {});
+    [[nodiscard]] region_manager::saver_type saver();
+
+    [[nodiscard]] std::filesystem::path file_path(const region_key& region) const;
+
+private:
+    // One region's file, opened on first use. `file` is only touched under `mutex`.
+    struct open_region {
+        std::mutex mutex{};
+        std::unique_ptr<region_file> file{};
     };
+
+    [[nodiscard]] open_region& region_for(const region_key& chunk);
+    [[nodiscard]] region_file& file_of(open_region& region, const region_key& chunk);
+
+    std::filesystem::path directory_{};
+    region_file_config config_{};
+    // Guards the map only; entries are never removed, so references to them stay valid without it.
+    std::mutex files_mutex_{};
+    std::unordered_map<region_key, std::unique_ptr<open_region>, region_key_hash> files_{};
+};
+
+inline region_file::region_file(std::filesystem::path path, region_key region, region_file_config config)
+    : path_{std::move(path)}
+    , sync_writes_{config.sync_writes} {
+    if (config.region_size == 0 || config.sector_size < sizeof(region_file_header)) {
+        throw std::logic_error("invalid region file configuration");
+    }
+    header_.region_size = config.region_size;
+    header_.sector_size = config.sector_size;
+    header_.region[0] = region.x;
+    header_.region[1] = region.y;
+    header_.region[2] = region.z;
+
+    if (!path_.parent_path().empty()) {
+        std::filesystem::create_directories(path_.parent_path());
+    }
+
+    if (std::filesystem::exists(path_) && std::filesystem::file_size(path_) > 0) {
+        open_stream();
+        region_file_header stored{};
+        stream_.read(reinterpret_cast<char*>(&stored), sizeof(stored));
+        if (!stream_ || std::string_view(stored.magic, 4)
+                != std::string_view{region_file_magic.data(), region_file_magic.size()}) {
+            throw std::runtime_error("invalid region file header");
+        }
+        if (stored.version == 0 || stored.version > region_file_version) {
+            throw std::runtime_error("unsupported region file version");
+        }
+        header_.version = stored.version;
+        if (stored.region_size != config.region_size || stored.sector_size != config.sector_size
+            || stored.region[0] != region.x || stored.region[1] != region.y || stored.region[2] != region.z) {
+            throw std::runtime_error("region file layout does not match the requested region");
+        }
+        index_.resize(std::size_t{header_.region_size} * header_.region_size * header_.region_size);
+        stream_.read(reinterpret_cast<char*>(index_.data()),
+            static_cast<std::streamsize>(index_.size() * sizeof(region_file_entry)));
+        if (!stream_) {
+            throw std::runtime_error("truncated region file index");
+        }
+        const auto total = static_cast<std::size_t>(std::filesystem::file_size(path_) / header_.sector_size);
+        used_.assign(std::max(total, data_sector()), false);
+        mark(0, static_cast<std::uint32_t>(data_sector()), true);
+        for (const auto& entry : index_) {
+            if (entry.sector_count == 0) {
+                continue;
+            }
+            if (entry.sector < data_sector() || std::size_t{entry.sector} + entry.sector_count > used_.size()
+                || entry.size > std::size_t{entry.sector_count} * header_.sector_size) {
+                throw std::runtime_error("corrupt region file index entry");
+            }
+            mark(entry.sector, entry.sector_count, true);
+        }
+        return;
+    }
+
+    {
+        std::ofstream create(path_, std::ios::binary | std::ios::trunc);
+        if (!create) {
+            throw std::runtime_error("failed to create region file");
+        }
+    }
+    open_stream();
+    index_.assign(std::size_t{header_.region_size} * header_.region_size * header_.region_size, region_file_entry{});
+    used_.assign(data_sector(), true);
+    stream_.seekp(0);
+    write_preamble(stream_, index_);
+    stream_.flush();
+    if (!stream_) {
+        throw std::runtime_error("failed to initialise region file");
+    }
 }
 
-inline std::array<float, 3> compute_normal(const std::array<float, 3>& p0, const std::array<float, 3>& p1,
-    const std::array<float, 3>& p2) {
-    const std::array<float, 3> u{
-        p1[0] - p0[0],
-        p1[1] - p0[1],
-        p1[2] - p0[2]
-    };
-    const std::array<float, 3> v{
-        p2[0] - p0[0],
-        p2[1] - p0[1],
-        p2[2] - p0[2]
-    };
+inline region_key region_file::region_of(const region_key& chunk, std::uint32_t region_size) noexcept {
+    const auto size = static_cast<std::int32_t>(region_size);
+    const auto floor_div = [size](std::int32_t value) { return value >= 0 ? value / size : -((-value - 1) / size) - 1; };
+    return region_key{floor_div(chunk.x), floor_div(chunk.y), floor_div(chunk.z)};
+}
 
-    std::array<float, 3> normal{
-        v[1] * u[2] - v[2] * u[1],
-        v[2] * u[0] - v[0] * u[2],
-        v[0] * u[1] - v[1] * u[0]
-    };
+inline bool region_file::covers(const region_key& chunk) const noexcept {
+    return region_of(chunk, header_.region_size) == region();
+}
 
-    const float length_sq = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
-    if (length_sq <= 1e-12f) {
-        return std::array<float, 3>{0.0f, 0.0f, 0.0f};
+inline bool region_file::contains(const region_key& chunk) const {
+    return index_[slot(chunk)].sector_count != 0;
+}
+
+inline std::optional<std::vector<std::byte>> region_file::read(const region_key& chunk) {
+    const auto& entry = index_[slot(chunk)];
+    if (entry.sector_count == 0) {
+        return std::nullopt;
+    }
+    std::vector<std::byte> payload(entry.size);
+    read_payload(entry, payload);
+    if (header_.version >= 2 && detail::region_payload_checksum(payload) != entry.checksum) {
+        throw std::runtime_error("region file payload checksum mismatch");
+    }
+    return payload;
+}
+
+inline void region_file::write(const region_key& chunk, std::span<const std::byte> payload) {
+    const auto index = slot(chunk);
+    auto& entry = index_[index];
+    const auto needed = sectors_for(payload.size());
+    if (needed == 0) {
+        erase(chunk);
+        return;
+    }
+    upgrade_version();
+
+    // Write the new copy before repointing the index so the old payload stays readable until then.
+    const auto sector = allocate(needed);
+    mark(sector, needed, true);
+    write_payload(sector, needed, payload);
+    if (sync_writes_) {
+        flush();
+    }
+    mark(entry.sector, entry.sector_count, false);
+    entry.sector = sector;
+    entry.sector_count = needed;
+    entry.size = static_cast<std::uint32_t>(payload.size());
+    entry.checksum = detail::region_payload_checksum(payload);
+    write_entry(index);
+}
+
+inline bool region_file::erase(const region_key& chunk) {
+    const auto index = slot(chunk);
+    auto& entry = index_[index];
+    if (entry.sector_count == 0) {
+        return false;
+    }
+    upgrade_version();
+    mark(entry.sector, entry.sector_count, false);
+    entry = region_file_entry{};
+    write_entry(index);
+    return true;
+}
+
+inline std::optional<chunk_storage> region_file::load_chunk(const region_key& chunk) {
+    auto payload = read(chunk);
+    if (!payload) {
+        return std::nullopt;
+    }
+    return deserialize_chunk(*payload);
+}
+
+inline void region_file::store_chunk(const region_key& chunk, const chunk_storage& storage) {
+    const auto payload = serialize_chunk(storage);
+    write(chunk, payload);
+}
+
+inline std::size_t region_file::compact() {
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < index_.size(); ++i) {
+        if (index_[i].sector_count != 0) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return index_[lhs].sector < index_[rhs].sector;
+    });
+
+    // Live sectors are never touched: the packed copy goes to a temporary file that replaces this one only once it is
+    // complete and synced, so a crash at any point leaves either the old or the new file intact.
+    auto temporary = path_;
+    temporary += ".tmp";
+    std::vector<region_file_entry> packed(index_.size());
+    auto next = static_cast<std::uint32_t>(data_sector());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("failed to create compacted region file");
+        }
+        // Placeholder preamble; the final index is written once every payload has its new offset.
+        write_preamble(out, packed);
+        std::vector<std::byte> buffer;
+        for (const auto i : order) {
+            const auto& entry = index_[i];
+            buffer.resize(entry.size);
+            read_payload(entry, buffer);
+            const auto padding = std::size_t{entry.sector_count} * header_.sector_size - buffer.size();
+            out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+            const std::vector<char> zeros(padding, 0);
+            out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+            packed[i] = region_file_entry{next, entry.sector_count, entry.size,
+                header_.version >= 2 ? entry.checksum : detail::region_payload_checksum(buffer)};
+            next += entry.sector_count;
+        }
+        auto header = header_;
+        header.version = region_file_version;
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(packed.data()),
+            static_cast<std::streamsize>(packed.size() * sizeof(region_file_entry)));
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("failed to write compacted region file");
+        }
+    }
+
+    const auto before = file_size();
+    stream_.close();
+    std::exception_ptr error;
+    try {
+        commit_file(temporary, path_);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    open_stream();
+    // A failed directory sync happens after the rename, so the packed layout may already be the live file.
+    if (!std::filesystem::exists(temporary)) {
+        header_.version = region_file_version;
+        index_ = std::move(packed);
+        used_.assign(next, true);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return static_cast<std::size_t>(before - file_size());
+}
+
+inline void region_file::flush() {
+    stream_.flush();
+    if (!stream_) {
+        throw std::runtime_error("failed to flush region file");
+    }
+    if (sync_writes_) {
+        sync_file(path_);
+    }
+}
+
+inline std::size_t region_file::chunk_count() const noexcept {
+    return static_cast<std::size_t>(std::count_if(index_.begin(), index_.end(),
+        [](const region_file_entry& entry) { return entry.sector_count != 0; }));
+}
+
+inline std::size_t region_file::used_sectors() const noexcept {
+    return static_cast<std::size_t>(std::count(used_.begin(), used_.end(), true));
+}
+
+inline std::size_t region_file::slot(const region_key& chunk) const {
+    if (!covers(chunk)) {
+        throw std::out_of_range("chunk lies outside this region file");
+    }
+    const auto size = static_cast<std::int32_t>(header_.region_size);
+    const auto local = [size](std::int32_t value) { return static_cast<std::size_t>(((value % size) + size) % size); };
+    const std::size_t n = header_.region_size;
+    return local(chunk.x) + n * (local(chunk.y) + n * local(chunk.z));
+}
+
+inline std::size_t region_file::data_sector() const noexcept {
+    const std::size_t n = header_.region_size;
+    const std::size_t bytes = sizeof(region_file_header) + n * n * n * sizeof(region_file_entry);
+    return (bytes + header_.sector_size - 1) / header_.sector_size;
+}
+
+inline std::uint32_t region_file::sectors_for(std::size_t bytes) const noexcept {
+    return static_cast<std::uint32_t>((bytes + header_.sector_size - 1) / header_.sector_size);
+}
+
+inline std::uint32_t region_file::allocate(std::uint32_t count) {
+    std::size_t run = 0;
+    for (std::size_t sector = data_sector(); sector < used_.size(); ++sector) {
+        run = used_[sector] ? 0 : run + 1;
+        if (run == count) {
+            return static_cast<std::uint32_t>(sector + 1 - count);
+        }
     }
-    const float inv_length = 1.0f / std::sqrt(length_sq);
-    normal[0] *= inv_length;
-    normal[1] *= inv_length;
-    normal[2] *= inv_length;
-    return normal;
+    // Extend the file, reusing a free tail run if there is one.
+    const auto start = used_.size() - run;
+    used_.resize(start + count, false);
+    return static_cast<std::uint32_t>(start);
 }
 
-} // namespace detail
+inline void region_file::mark(std::uint32_t sector, std::uint32_t count, bool used) {
+    if (used_.size() < std::size_t{sector} + count) {
+        used_.resize(std::size_t{sector} + count, false);
+    }
+    std::fill_n(used_.begin() + sector, count, used);
+}
 
-template <typename DensitySampler, typename MaterialSampler>
-[[nodiscard]] mesh_result marching_cubes(chunk_extent extent, DensitySampler&& density_sampler,
-    MaterialSampler&& material_sampler, const marching_cubes_config& config = {}) {
-    mesh_result result;
-    const std::size_t approximate_cells = static_cast<std::size_t>(extent.volume());
-    result.vertices.reserve(approximate_cells * 3);
-    result.indices.reserve(approximate_cells * 3);
+inline void region_file::write_preamble(std::ostream& out, std::span<const region_file_entry> index) const {
+    out.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    out.write(reinterpret_cast<const char*>(index.data()),
+        static_cast<std::streamsize>(index.size() * sizeof(region_file_entry)));
+    const auto padding = data_sector() * header_.sector_size - sizeof(header_) - index.size() * sizeof(region_file_entry);
+    const std::vector<char> zeros(padding, 0);
+    out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+}
 
-    std::array<std::array<float, 3>, 12> edge_vertices{};
-    const auto& edge_table = detail::mc_edge_table;
-    const auto& triangle_table = detail::mc_triangle_table;
+inline void region_file::upgrade_version() {
+    if (header_.version >= region_file_version) {
+        return;
+    }
+    // Version 1 entries carry no checksums. Fill them in first and bump the header last, so the file never claims
+    // verified entries it does not have.
+    std::vector<std::byte> payload;
+    for (std::size_t i = 0; i < index_.size(); ++i) {
+        auto& entry = index_[i];
+        if (entry.sector_count == 0) {
+            continue;
+        }
+        payload.resize(entry.size);
+        read_payload(entry, payload);
+        entry.checksum = detail::region_payload_checksum(payload);
+        write_entry(i);
+    }
+    flush();
+    header_.version = region_file_version;
+    stream_.seekp(0);
+    stream_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    if (!stream_) {
+        throw std::runtime_error("failed to upgrade region file header");
+    }
+}
 
-    for (std::size_t z = 0; z < extent.z; ++z) {
-        for (std::size_t y = 0; y < extent.y; ++y) {
-            for (std::size_t x = 0; x < extent.x; ++x) {
-                std::array<float, 8> corner_values{};
-                std::array<std::array<float, 3>, 8> corner_positions{};
+inline void region_file::write_entry(std::size_t index) {
+    stream_.seekp(static_cast<std::streamoff>(sizeof(region_file_header) + index * sizeof(region_file_entry)));
+    stream_.write(reinterpret_cast<const char*>(&index_[index]), sizeof(region_file_entry));
+    if (!stream_) {
+        throw std::runtime_error("failed to write region file index");
+    }
+}
 
-                for (int corner = 0; corner < 8; ++corner) {
-                    const auto& offset = detail::cube_corners[corner];
-                    const std::size_t sample_x = x + static_cast<std::size_t>(offset[0]);
-                    const std::size_t sample_y = y + static_cast<std::size_t>(offset[1]);
-                    const std::size_t sample_z = z + static_cast<std::size_t>(offset[2]);
-                    corner_values[corner] = static_cast<float>(density_sampler(sample_x, sample_y, sample_z));
-                    corner_positions[corner] = std::array<float, 3>{
-                        static_cast<float>(x + offset[0]),
-                        static_cast<float>(y + offset[1]),
-                        static_cast<float>(z + offset[2])
-                    };
-                }
+inline void region_file::write_payload(std::uint32_t sector, std::uint32_t count, std::span<const std::byte> payload) {
+    stream_.seekp(static_cast<std::streamoff>(std::uintmax_t{sector} * header_.sector_size));
+    stream_.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    const auto padding = std::size_t{count} * header_.sector_size - payload.size();
+    if (padding > 0) {
+        const std::vector<char> zeros(padding, 0);
+        stream_.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+    if (!stream_) {
+        throw std::runtime_error("failed to write region file payload");
+    }
+}
 
-                int cube_index = 0;
-                for (int corner = 0; corner < 8; ++corner) {
-                    if (corner_values[corner] < config.iso_value) {
-                        cube_index |= (1 << corner);
-                    }
-                }
+inline void region_file::read_payload(const region_file_entry& entry, std::span<std::byte> out) {
+    stream_.seekg(static_cast<std::streamoff>(std::uintmax_t{entry.sector} * header_.sector_size));
+    stream_.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!stream_) {
+        stream_.clear();
+        throw std::runtime_error("failed to read region file payload");
+    }
+}
 
-                if (edge_table[cube_index] == 0) {
-                    continue;
-                }
+inline void region_file::open_stream() {
+    stream_.open(path_, std::ios::binary | std::ios::in | std::ios::out);
+    if (!stream_) {
+        throw std::runtime_error("failed to open region file");
+    }
+}
 
-                for (int edge = 0; edge < 12; ++edge) {
-                    if ((edge_table[cube_index] & (1 << edge)) == 0) {
-                        continue;
-                    }
-                    const auto connection = detail::edge_connection[static_cast<std::size_t>(edge)];
-                    edge_vertices[edge] = detail::interpolate_vertex(
-                        corner_positions[connection[0]],
-                        corner_positions[connection[1]],
-                        corner_values[connection[0]],
-                        corner_values[connection[1]],
-                        config.iso_value);
-                }
+inline region_store::region_store(std::filesystem::path directory, region_file_config config)
+    : directory_{std::move(directory)}
+    , config_{config} {
+}
 
-                const voxel_id material = material_sampler(x, y, z);
-                for (int tri = 0; triangle_table[cube_index][tri] != -1; tri += 3) {
-                    const int a0 = triangle_table[cube_index][tri];
-                    const int a1 = triangle_table[cube_index][tri + 1];
-                    const int a2 = triangle_table[cube_index][tri + 2];
-
-                    const auto& p0 = edge_vertices[a0];
-                    const auto& p1 = edge_vertices[a1];
-                    const auto& p2 = edge_vertices[a2];
-                    const auto normal = detail::compute_normal(p0, p2, p1);
-
-                    const auto base_index = static_cast<std::uint32_t>(result.vertices.size());
-                    result.vertices.push_back(vertex{p0, normal, {p0[0], p0[1]}, material});
-                    result.vertices.push_back(vertex{p2, normal, {p2[0], p2[1]}, material});
-                    result.vertices.push_back(vertex{p1, normal, {p1[0], p1[1]}, material});
-                    result.indices.insert(result.indices.end(), {base_index, base_index + 1, base_index + 2});
-                }
-            }
-        }
+inline std::optional<chunk_storage> region_store::load(const region_key& chunk) {
+    auto& region = region_for(chunk);
+    std::optional<std::vector<std::byte>> payload;
+    {
+        std::scoped_lock lock{region.mutex};
+        payload = file_of(region, chunk).read(chunk);
     }
-
-    return result;
+    if (!payload) {
+        return std::nullopt;
+    }
+    return deserialize_chunk(*payload);
 }
 
-template <typename DensitySampler>
-[[nodiscard]] mesh_result marching_cubes(chunk_extent extent, DensitySampler&& density_sampler,
-    const marching_cubes_config& config = {}, voxel_id material = voxel_id{1}) {
-    auto material_sampler = [material](std::size_t, std::size_t, std::size_t) {
-        return material;
-    };
-    return marching_cubes(extent, std::forward<DensitySampler>(density_sampler), material_sampler, config);
+inline void region_store::save(const region_key& chunk, const chunk_storage& storage) {
+    auto payload = serialize_chunk(storage);
+    auto& region = region_for(chunk);
+    std::scoped_lock lock{region.mutex};
+    file_of(region, chunk).write(chunk, payload);
 }
 
-template <typename IsSolid>
-[[nodiscard]] mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, IsSolid&& is_solid,
-    const chunk_neighbors& neighbors, const marching_cubes_config& config = {}) {
-    const auto voxels = chunk.voxels();
-    const auto extent = chunk.extent();
-    const auto neighbor_views = detail::load_neighbor_views(neighbors);
+inline bool region_store::erase(const region_key& chunk) {
+    auto& region = region_for(chunk);
+    std::scoped_lock lock{region.mutex};
+    return file_of(region, chunk).erase(chunk);
+}
 
-    auto sample_voxel = [&](std::ptrdiff_t x, std::ptrdiff_t y, std::ptrdiff_t z) -> std::optional<voxel_id> {
-        if (x >= 0 && x < static_cast<std::ptrdiff_t>(extent.x) && y >= 0 && y < static_cast<std::ptrdiff_t>(extent.y)
-            && z >= 0 && z < static_cast<std::ptrdiff_t>(extent.z)) {
-            return voxels(static_cast<std::size_t>(x), static_cast<std::size_t>(y), static_cast<std::size_t>(z));
+inline void region_store::flush() {
+    std::vector<open_region*> regions;
+    {
+        std::scoped_lock lock{files_mutex_};
+        regions.reserve(files_.size());
+        for (auto& [key, region] : files_) {
+            regions.push_back(region.get());
         }
-
-        std::array<std::ptrdiff_t, 3> coord{x, y, z};
-        const detail::neighbor_view* view = nullptr;
-        if (!detail::remap_to_neighbor_coords(extent, coord, neighbor_views, view)) {
-            return std::nullopt;
+    }
+    for (auto* region : regions) {
+        std::scoped_lock lock{region->mutex};
+        if (region->file) {
+            region->file->flush();
         }
-        return view->voxels(static_cast<std::size_t>(coord[0]), static_cast<std::size_t>(coord[1]),
-            static_cast<std::size_t>(coord[2]));
-    };
+    }
+}
 
-    auto density_sampler = [&](std::size_t vx, std::size_t vy, std::size_t vz) -> float {
-        const auto sample = sample_voxel(static_cast<std::ptrdiff_t>(vx), static_cast<std::ptrdiff_t>(vy),
-            static_cast<std::ptrdiff_t>(vz));
-        if (!sample) {
-            return 1.0f;
+inline region_manager::loader_type region_store::loader(chunk_extent extent, region_manager::loader_type fallback) {
+    return [this, extent, fallback = std::move(fallback)](const region_key& key) {
+        if (auto stored = load(key)) {
+            return std::move(*stored);
         }
-        return is_solid(*sample) ? 0.0f : 1.0f;
+        return fallback ? fallback(key) : chunk_storage{extent};
     };
+}
 
-    auto material_sampler = [&](std::size_t x, std::size_t y, std::size_t z) {
-        return voxels(x, y, z);
-    };
+inline region_manager::saver_type region_store::saver() {
+    return [this](const region_key& key, const chunk_storage& chunk) { save(key, chunk); };
+}
 
-    return marching_cubes(extent, density_sampler, material_sampler, config);
+inline std::filesystem::path region_store::file_path(const region_key& region) const {
+    return directory_ / ("r." + std::to_string(region.x) + '.' + std::to_string(region.y) + '.'
+        + std::to_string(region.z) + ".avr");
 }
 
-inline mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, const marching_cubes_config& config = {}) {
-    return marching_cubes_from_chunk(chunk, [](voxel_id id) { return id != voxel_id{}; }, chunk_neighbors{}, config);
+inline region_store::open_region& region_store::region_for(const region_key& chunk) {
+    const auto region = region_file::region_of(chunk, config_.region_size);
+    std::scoped_lock lock{files_mutex_};
+    auto& entry = files_[region];
+    if (!entry) {
+        entry = std::make_unique<open_region>();
+    }
+    return *entry;
 }
 
-} // namespace almond::voxel::meshing
-// end: almond_voxel/meshing/marching_cubes.hpp
+inline region_file& region_store::file_of(open_region& region, const region_key& chunk) {
+    if (!region.file) {
+        const auto key = region_file::region_of(chunk, config_.region_size);
+        region.file = std::make_unique<region_file>(file_path(key), key, config_);
+    }
+    return *region.file;
+}
 
-// begin: almond_voxel/serialization/region_io.hpp
+} // namespace almond::voxel::serialization
+// end: almond_voxel/serialization/region_file.hpp
+
+// begin: almond_voxel/serialization/mapped_region.hpp
 
 
-#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
-#include <fstream>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <span>
 #include <stdexcept>
@@ -3129,429 +11111,376 @@ inline mesh_result marching_cubes_from_chunk(const chunk_storage& chunk, const m
 #include <utility>
 #include <vector>
 
-namespace almond::voxel::serialization {
-
-constexpr std::uint32_t chunk_version_latest = 3;
-constexpr std::array<char, 4> chunk_magic{'A', 'V', 'C', 'K'};
+#if defined(_WIN32)
+// Trim <windows.h> and keep its min/max macros out, without leaking either setting into the including code.
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#define ALMOND_VOXEL_UNDEF_NOMINMAX
+#endif
+#include <windows.h>
+#ifdef ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef ALMOND_VOXEL_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#ifdef ALMOND_VOXEL_UNDEF_NOMINMAX
+#undef NOMINMAX
+#undef ALMOND_VOXEL_UNDEF_NOMINMAX
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-struct chunk_header_v1 {
-    char magic[4]{chunk_magic[0], chunk_magic[1], chunk_magic[2], chunk_magic[3]};
-    std::uint32_t version{1};
-    std::uint32_t extent[3]{1, 1, 1};
-};
+namespace almond::voxel::serialization {
 
-struct chunk_header_v2 {
-    char magic[4]{chunk_magic[0], chunk_magic[1], chunk_magic[2], chunk_magic[3]};
-    std::uint32_t version{chunk_version_latest};
-    std::uint32_t extent[3]{1, 1, 1};
-    std::uint32_t channel_flags{0};
-};
+// Read-only memory mapping of a whole file.
+class mapped_file {
+public:
+    explicit mapped_file(const std::filesystem::path& path);
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    ~mapped_file();
 
-enum chunk_channel_flags : std::uint32_t {
-    chunk_channel_materials = 1u << 0u,
-    chunk_channel_skylight_cache = 1u << 1u,
-    chunk_channel_blocklight_cache = 1u << 2u,
-    chunk_channel_effect_density = 1u << 3u,
-    chunk_channel_effect_velocity = 1u << 4u,
-    chunk_channel_effect_lifetime = 1u << 5u
-};
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return {data_, size_}; }
 
-struct region_blob {
-    region_key key{};
-    std::vector<std::byte> payload;
+private:
+    const std::byte* data_{nullptr};
+    std::size_t size_{0};
+#if defined(_WIN32)
+    HANDLE file_{INVALID_HANDLE_VALUE};
+    HANDLE mapping_{nullptr};
+#endif
 };
 
-inline void append_bytes(std::vector<std::byte>& buffer, const void* data, std::size_t size) {
-    const auto* bytes = static_cast<const std::byte*>(data);
-    buffer.insert(buffer.end(), bytes, bytes + size);
-}
+// Read-only view of a serialized chunk payload. Dense planes alias the payload bytes, so nothing is copied until
+// promote(). The view keeps its backing storage (for example a mapped file) alive.
+class chunk_view {
+public:
+    chunk_view() = default;
+    explicit chunk_view(std::span<const std::byte> payload, std::shared_ptr<const void> owner = {});
 
-inline std::vector<std::byte> serialize_chunk(const chunk_storage& chunk) {
-    const auto extent = chunk.extent();
-    const auto voxel_data = chunk.voxels();
-    const auto sky_data = chunk.skylight();
-    const auto block_data = chunk.blocklight();
-    const auto meta_data = chunk.metadata();
-    const bool has_materials = chunk.materials_enabled();
-    const bool has_high_precision = chunk.high_precision_lighting_enabled();
-    const bool has_effect_density = chunk.effect_density_enabled();
-    const bool has_effect_velocity = chunk.effect_velocity_enabled();
-    const bool has_effect_lifetime = chunk.effect_lifetime_enabled();
+    [[nodiscard]] chunk_extent extent() const noexcept { return extent_; }
+    [[nodiscard]] std::size_t volume() const noexcept { return extent_.volume(); }
+    [[nodiscard]] std::uint32_t channel_flags() const noexcept { return header_.channel_flags; }
+    [[nodiscard]] std::span<const std::byte> payload() const noexcept { return payload_; }
 
-    chunk_header_v2 header{};
-    header.extent[0] = extent.x;
-    header.extent[1] = extent.y;
-    header.extent[2] = extent.z;
-    if (has_materials) {
-        header.channel_flags |= chunk_channel_materials;
-    }
-    if (has_high_precision) {
-        header.channel_flags |= chunk_channel_skylight_cache | chunk_channel_blocklight_cache;
-    }
-    if (has_effect_density) {
-        header.channel_flags |= chunk_channel_effect_density;
-    }
-    if (has_effect_velocity) {
-        header.channel_flags |= chunk_channel_effect_velocity;
-    }
-    if (has_effect_lifetime) {
-        header.channel_flags |= chunk_channel_effect_lifetime;
-    }
+    [[nodiscard]] bool uniform() const noexcept { return (header_.channel_flags & chunk_channel_uniform) != 0; }
+    [[nodiscard]] std::optional<voxel_id> uniform_voxel() const noexcept;
+    [[nodiscard]] voxel_id voxel_at(std::uint32_t x, std::uint32_t y, std::uint32_t z) const;
 
-    const auto volume = extent.volume();
-    std::size_t payload_bytes = volume * (sizeof(voxel_id) + 3);
-    if (has_materials) {
-        payload_bytes += volume * sizeof(material_index);
-    }
-    if (has_high_precision) {
-        payload_bytes += volume * sizeof(float) * 2;
-    }
-    if (has_effect_density) {
-        payload_bytes += volume * sizeof(float);
-    }
-    if (has_effect_velocity) {
-        payload_bytes += volume * sizeof(effects::velocity_sample);
-    }
-    if (has_effect_lifetime) {
-        payload_bytes += volume * sizeof(float);
-    }
+    // Aliasing plane views; only available for dense (non-uniform) payloads.
+    [[nodiscard]] span3d<const voxel_id> voxels() const;
+    [[nodiscard]] span3d<const std::uint8_t> skylight() const;
+    [[nodiscard]] span3d<const std::uint8_t> blocklight() const;
+    [[nodiscard]] span3d<const std::uint8_t> metadata() const;
 
-    std::vector<std::byte> buffer;
-    buffer.reserve(sizeof(chunk_header_v2) + payload_bytes);
-    append_bytes(buffer, &header, sizeof(header));
+    // Decodes an owned, clean chunk.
+    [[nodiscard]] chunk_storage promote() const { return deserialize_chunk(payload_); }
 
-    const auto copy_span = [&buffer](auto span) {
-        using value_type = typename decltype(span)::value_type;
-        append_bytes(buffer, span.data(), span.size() * sizeof(value_type));
-    };
+private:
+    [[nodiscard]] const std::byte* plane(std::size_t offset) const;
 
-    copy_span(voxel_data.linear());
-    copy_span(sky_data.linear());
-    copy_span(block_data.linear());
-    copy_span(meta_data.linear());
+    std::span<const std::byte> payload_{};
+    std::shared_ptr<const void> owner_{};
+    chunk_header_v2 header_{};
+    chunk_extent extent_{};
+};
 
-    if (has_materials) {
-        copy_span(chunk.materials().linear());
-    }
-    if (has_high_precision) {
-        copy_span(chunk.skylight_cache().linear());
-        copy_span(chunk.blocklight_cache().linear());
-    }
-    if (has_effect_density) {
-        copy_span(chunk.effect_density().linear());
-    }
-    if (has_effect_velocity) {
-        copy_span(chunk.effect_velocity().linear());
-    }
-    if (has_effect_lifetime) {
-        copy_span(chunk.effect_lifetime().linear());
-    }
+// Chunk that reads through a chunk_view until first mutated, then promotes itself to an owned chunk_storage.
+class cow_chunk {
+public:
+    explicit cow_chunk(chunk_view view) : view_{std::move(view)} {}
 
-    return buffer;
-}
+    [[nodiscard]] bool promoted() const noexcept { return owned_.has_value(); }
+    [[nodiscard]] chunk_extent extent() const noexcept { return view_.extent(); }
+    [[nodiscard]] const chunk_view& view() const noexcept { return view_; }
+    [[nodiscard]] const chunk_storage* owned() const noexcept { return owned_ ? &*owned_ : nullptr; }
 
-inline chunk_storage deserialize_chunk(std::span<const std::byte> bytes) {
-    if (bytes.size() < sizeof(chunk_header_v1)) {
-        throw std::runtime_error("chunk payload too small");
+    [[nodiscard]] std::optional<voxel_id> uniform_voxel() const noexcept {
+        return owned_ ? owned_->uniform_voxel() : view_.uniform_voxel();
     }
-
-    chunk_header_v1 header_v1{};
-    std::memcpy(&header_v1, bytes.data(), sizeof(header_v1));
-    if (std::string_view(header_v1.magic, 4) != std::string_view{chunk_magic.data(), chunk_magic.size()}) {
-        throw std::runtime_error("invalid chunk magic");
+    [[nodiscard]] voxel_id voxel_at(std::uint32_t x, std::uint32_t y, std::uint32_t z) const {
+        return owned_ ? owned_->voxel_at(x, y, z) : view_.voxel_at(x, y, z);
     }
 
-    if (header_v1.version == 1) {
-        const chunk_extent extent{header_v1.extent[0], header_v1.extent[1], header_v1.extent[2]};
-        const auto count = extent.volume();
-        const std::size_t required = sizeof(chunk_header_v1) + count * (sizeof(voxel_id) + 3);
-        if (bytes.size() < required) {
-            throw std::runtime_error("chunk payload truncated");
+    [[nodiscard]] chunk_storage& mutate() {
+        if (!owned_) {
+            owned_.emplace(view_.promote());
         }
-
-        chunk_storage_config config{};
-        config.extent = extent;
-        chunk_storage chunk{config};
-        const auto* ptr = bytes.data() + sizeof(chunk_header_v1);
-
-        auto copy_into = [&ptr, count](auto view) {
-            using value_type = typename decltype(view)::element_type;
-            std::memcpy(view.linear().data(), ptr, count * sizeof(value_type));
-            ptr += count * sizeof(value_type);
-        };
-
-        copy_into(chunk.voxels());
-        copy_into(chunk.skylight());
-        copy_into(chunk.blocklight());
-        copy_into(chunk.metadata());
-        chunk.mark_dirty(false);
-        return chunk;
-    }
-
-    if (bytes.size() < sizeof(chunk_header_v2)) {
-        throw std::runtime_error("chunk payload too small for extended header");
-    }
-
-    chunk_header_v2 header_v2{};
-    std::memcpy(&header_v2, bytes.data(), sizeof(header_v2));
-    if (header_v2.version < 2) {
-        throw std::runtime_error("unsupported chunk version");
-    }
-
-    const chunk_extent extent{header_v2.extent[0], header_v2.extent[1], header_v2.extent[2]};
-    const auto count = extent.volume();
-    const bool has_materials = (header_v2.channel_flags & chunk_channel_materials) != 0;
-    const bool has_sky_cache = (header_v2.channel_flags & chunk_channel_skylight_cache) != 0;
-    const bool has_block_cache = (header_v2.channel_flags & chunk_channel_blocklight_cache) != 0;
-    const bool has_effect_density = (header_v2.channel_flags & chunk_channel_effect_density) != 0;
-    const bool has_effect_velocity = (header_v2.channel_flags & chunk_channel_effect_velocity) != 0;
-    const bool has_effect_lifetime = (header_v2.channel_flags & chunk_channel_effect_lifetime) != 0;
-
-    std::size_t required = sizeof(chunk_header_v2) + count * (sizeof(voxel_id) + 3);
-    if (has_materials) {
-        required += count * sizeof(material_index);
-    }
-    if (has_sky_cache) {
-        required += count * sizeof(float);
-    }
-    if (has_block_cache) {
-        required += count * sizeof(float);
-    }
-    if (has_effect_density) {
-        required += count * sizeof(float);
-    }
-    if (has_effect_velocity) {
-        required += count * sizeof(effects::velocity_sample);
-    }
-    if (has_effect_lifetime) {
-        required += count * sizeof(float);
-    }
-    if (bytes.size() < required) {
-        throw std::runtime_error("chunk payload truncated");
+        return *owned_;
     }
 
-    chunk_storage_config config{};
-    config.extent = extent;
-    config.enable_materials = has_materials;
-    config.enable_high_precision_lighting = has_sky_cache || has_block_cache;
-    config.effect_channels = effects::channel::none;
-    if (has_effect_density) {
-        config.effect_channels |= effects::channel::density;
-    }
-    if (has_effect_velocity) {
-        config.effect_channels |= effects::channel::velocity;
+    // Releases the owned chunk (promoting first if needed), e.g. to hand it to region_manager::replace.
+    [[nodiscard]] chunk_storage take() {
+        chunk_storage chunk = std::move(mutate());
+        owned_.reset();
+        return chunk;
     }
-    if (has_effect_lifetime) {
-        config.effect_channels |= effects::channel::lifetime;
+
+private:
+    chunk_view view_{};
+    std::optional<chunk_storage> owned_{};
+};
+
+// Memory-mapped region_file. Chunk views alias the mapped pages, so a cold read is bounded by page faults rather than
+// copies. Views of version 2 files verify the payload checksum when created. The file must not be rewritten or
+// compacted while mapped.
+class mapped_region_file {
+public:
+    explicit mapped_region_file(const std::filesystem::path& path);
+
+    [[nodiscard]] region_key region() const noexcept {
+        return region_key{header_.region[0], header_.region[1], header_.region[2]};
     }
+    [[nodiscard]] std::uint32_t region_size() const noexcept { return header_.region_size; }
+    [[nodiscard]] bool contains(const region_key& chunk) const noexcept;
+    [[nodiscard]] std::size_t chunk_count() const noexcept;
 
-    chunk_storage chunk{config};
-    const auto* ptr = bytes.data() + sizeof(chunk_header_v2);
+    [[nodiscard]] std::optional<chunk_view> view(const region_key& chunk) const;
+    void for_each(const std::function<void(const region_key&, const chunk_view&)>& visitor) const;
 
-    auto copy_into = [&ptr, count](auto view) {
-        using value_type = typename decltype(view)::element_type;
-        std::memcpy(view.linear().data(), ptr, count * sizeof(value_type));
-        ptr += count * sizeof(value_type);
-    };
+private:
+    [[nodiscard]] std::optional<std::size_t> slot(const region_key& chunk) const noexcept;
+    [[nodiscard]] chunk_view view_slot(std::size_t index) const;
 
-    copy_into(chunk.voxels());
-    copy_into(chunk.skylight());
-    copy_into(chunk.blocklight());
-    copy_into(chunk.metadata());
+    std::shared_ptr<const mapped_file> file_{};
+    region_file_header header_{};
+    std::vector<region_file_entry> index_{};
+};
 
-    if (has_materials) {
-        auto materials = chunk.materials();
-        std::memcpy(materials.linear().data(), ptr, count * sizeof(material_index));
-        ptr += count * sizeof(material_index);
+#if defined(_WIN32)
+inline mapped_file::mapped_file(const std::filesystem::path& path) {
+    file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open file for mapping");
     }
-
-    if (config.enable_high_precision_lighting) {
-        if (has_sky_cache) {
-            auto sky_cache = chunk.skylight_cache();
-            std::memcpy(sky_cache.linear().data(), ptr, count * sizeof(float));
-            ptr += count * sizeof(float);
-        }
-        if (has_block_cache) {
-            auto block_cache = chunk.blocklight_cache();
-            std::memcpy(block_cache.linear().data(), ptr, count * sizeof(float));
-            ptr += count * sizeof(float);
-        }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file_, &size)) {
+        CloseHandle(file_);
+        throw std::runtime_error("failed to query mapped file size");
     }
-
-    if (has_effect_density) {
-        auto density = chunk.effect_density();
-        std::memcpy(density.linear().data(), ptr, count * sizeof(float));
-        ptr += count * sizeof(float);
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    if (size_ == 0) {
+        return;
     }
-    if (has_effect_velocity) {
-        auto velocity = chunk.effect_velocity();
-        std::memcpy(velocity.linear().data(), ptr, count * sizeof(effects::velocity_sample));
-        ptr += count * sizeof(effects::velocity_sample);
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ == nullptr) {
+        CloseHandle(file_);
+        throw std::runtime_error("failed to create file mapping");
     }
-    if (has_effect_lifetime) {
-        auto lifetime = chunk.effect_lifetime();
-        std::memcpy(lifetime.linear().data(), ptr, count * sizeof(float));
-        ptr += count * sizeof(float);
+    data_ = static_cast<const std::byte*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        CloseHandle(mapping_);
+        CloseHandle(file_);
+        throw std::runtime_error("failed to map file");
     }
-
-    chunk.mark_dirty(false);
-    return chunk;
 }
 
-inline bool is_legacy_chunk_payload(std::span<const std::byte> bytes) {
-    if (bytes.size() < sizeof(chunk_header_v1)) {
-        return false;
+inline mapped_file::~mapped_file() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
     }
-    chunk_header_v1 header{};
-    std::memcpy(&header, bytes.data(), sizeof(header));
-    return std::string_view(header.magic, 4) == std::string_view{chunk_magic.data(), chunk_magic.size()}
-        && header.version == 1;
 }
-
-inline std::vector<std::byte> migrate_legacy_chunk_payload(std::span<const std::byte> bytes) {
-    if (!is_legacy_chunk_payload(bytes)) {
-        throw std::runtime_error("chunk payload is not a legacy format");
+#else
+inline mapped_file::mapped_file(const std::filesystem::path& path) {
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("failed to open file for mapping");
     }
-    chunk_storage chunk = deserialize_chunk(bytes);
-    return serialize_chunk(chunk);
+    struct stat info {};
+    if (::fstat(descriptor, &info) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error("failed to query mapped file size");
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0) {
+        void* address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (address == MAP_FAILED) {
+            ::close(descriptor);
+            throw std::runtime_error("failed to map file");
+        }
+        data_ = static_cast<const std::byte*>(address);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close(descriptor);
 }
 
-inline void serialize_chunk_to_stream(const chunk_storage& chunk, std::ostream& out) {
-    auto payload = serialize_chunk(chunk);
-    out.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+inline mapped_file::~mapped_file() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
 }
+#endif
 
-inline chunk_storage deserialize_chunk_from_stream(std::istream& in) {
-    chunk_header_v1 header_v1{};
-    in.read(reinterpret_cast<char*>(&header_v1), sizeof(header_v1));
-    if (!in) {
-        throw std::runtime_error("unable to read chunk header");
+inline chunk_view::chunk_view(std::span<const std::byte> payload, std::shared_ptr<const void> owner)
+    : payload_{payload}
+    , owner_{std::move(owner)} {
+    if (payload_.size() < sizeof(chunk_header_v2)) {
+        throw std::runtime_error("chunk payload too small");
     }
-    if (std::string_view(header_v1.magic, 4) != std::string_view{chunk_magic.data(), chunk_magic.size()}) {
+    std::memcpy(&header_, payload_.data(), sizeof(header_));
+    if (std::string_view(header_.magic, 4) != std::string_view{chunk_magic.data(), chunk_magic.size()}) {
         throw std::runtime_error("invalid chunk magic");
     }
-
-    if (header_v1.version == 1) {
-        const chunk_extent extent{header_v1.extent[0], header_v1.extent[1], header_v1.extent[2]};
-        const auto count = extent.volume();
-        std::vector<std::byte> payload(sizeof(chunk_header_v1) + count * (sizeof(voxel_id) + 3));
-        std::memcpy(payload.data(), &header_v1, sizeof(header_v1));
-        in.read(reinterpret_cast<char*>(payload.data() + sizeof(header_v1)),
-            static_cast<std::streamsize>(payload.size() - sizeof(header_v1)));
-        if (!in) {
-            throw std::runtime_error("unable to read chunk payload");
-        }
-        return deserialize_chunk(payload);
+    if (header_.version < 2) {
+        throw std::runtime_error("chunk views require a version 2+ payload");
+    }
+    detail::reject_delta_payload(header_);
+    extent_ = chunk_extent{header_.extent[0], header_.extent[1], header_.extent[2]};
+    if (payload_.size() < sizeof(chunk_header_v2) + chunk_payload_bytes(header_.channel_flags, extent_.volume())) {
+        throw std::runtime_error("chunk payload truncated");
     }
+}
 
-    std::uint32_t flags = 0;
-    in.read(reinterpret_cast<char*>(&flags), sizeof(flags));
-    if (!in) {
-        throw std::runtime_error("unable to read chunk channel flags");
+inline std::optional<voxel_id> chunk_view::uniform_voxel() const noexcept {
+    if (!uniform()) {
+        return std::nullopt;
     }
+    voxel_id value{};
+    std::memcpy(&value, payload_.data() + sizeof(chunk_header_v2), sizeof(value));
+    return value;
+}
 
-    chunk_header_v2 header_v2{};
-    std::memcpy(&header_v2, &header_v1, sizeof(header_v1));
-    header_v2.version = header_v1.version;
-    header_v2.channel_flags = flags;
+inline voxel_id chunk_view::voxel_at(std::uint32_t x, std::uint32_t y, std::uint32_t z) const {
+    if (!extent_.contains(x, y, z)) {
+        throw std::out_of_range("voxel coordinate outside chunk view");
+    }
+    if (const auto value = uniform_voxel()) {
+        return *value;
+    }
+    const std::size_t index = x + std::size_t{extent_.x} * (y + std::size_t{extent_.y} * z);
+    voxel_id value{};
+    std::memcpy(&value, payload_.data() + sizeof(chunk_header_v2) + index * sizeof(voxel_id), sizeof(value));
+    return value;
+}
 
-    const chunk_extent extent{header_v2.extent[0], header_v2.extent[1], header_v2.extent[2]};
-    const auto count = extent.volume();
-    std::size_t payload_bytes = count * (sizeof(voxel_id) + 3);
-    if (flags & chunk_channel_materials) {
-        payload_bytes += count * sizeof(material_index);
+inline span3d<const voxel_id> chunk_view::voxels() const {
+    const auto* data = plane(0);
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(voxel_id) != 0) {
+        throw std::runtime_error("chunk view voxel plane is misaligned");
     }
-    if (flags & chunk_channel_skylight_cache) {
-        payload_bytes += count * sizeof(float);
+    return span3d<const voxel_id>{reinterpret_cast<const voxel_id*>(data), extent_};
+}
+
+inline span3d<const std::uint8_t> chunk_view::skylight() const {
+    return span3d<const std::uint8_t>{reinterpret_cast<const std::uint8_t*>(plane(volume() * sizeof(voxel_id))), extent_};
+}
+
+inline span3d<const std::uint8_t> chunk_view::blocklight() const {
+    return span3d<const std::uint8_t>{
+        reinterpret_cast<const std::uint8_t*>(plane(volume() * (sizeof(voxel_id) + 1))), extent_};
+}
+
+inline span3d<const std::uint8_t> chunk_view::metadata() const {
+    return span3d<const std::uint8_t>{
+        reinterpret_cast<const std::uint8_t*>(plane(volume() * (sizeof(voxel_id) + 2))), extent_};
+}
+
+inline const std::byte* chunk_view::plane(std::size_t offset) const {
+    if (uniform()) {
+        throw std::logic_error("uniform chunk views have no dense planes");
     }
-    if (flags & chunk_channel_blocklight_cache) {
-        payload_bytes += count * sizeof(float);
+    return payload_.data() + sizeof(chunk_header_v2) + offset;
+}
+
+inline mapped_region_file::mapped_region_file(const std::filesystem::path& path)
+    : file_{std::make_shared<const mapped_file>(path)} {
+    const auto bytes = file_->bytes();
+    if (bytes.size() < sizeof(region_file_header)) {
+        throw std::runtime_error("region file too small");
     }
-    if (flags & chunk_channel_effect_density) {
-        payload_bytes += count * sizeof(float);
+    std::memcpy(&header_, bytes.data(), sizeof(header_));
+    if (std::string_view(header_.magic, 4) != std::string_view{region_file_magic.data(), region_file_magic.size()}) {
+        throw std::runtime_error("invalid region file header");
     }
-    if (flags & chunk_channel_effect_velocity) {
-        payload_bytes += count * sizeof(effects::velocity_sample);
+    if (header_.version == 0 || header_.version > region_file_version || header_.region_size == 0) {
+        throw std::runtime_error("unsupported region file version");
     }
-    if (flags & chunk_channel_effect_lifetime) {
-        payload_bytes += count * sizeof(float);
+    const std::size_t n = header_.region_size;
+    index_.resize(n * n * n);
+    const auto index_bytes = index_.size() * sizeof(region_file_entry);
+    if (bytes.size() < sizeof(region_file_header) + index_bytes) {
+        throw std::runtime_error("truncated region file index");
     }
-
-    std::vector<std::byte> payload(sizeof(chunk_header_v2) + payload_bytes);
-    std::memcpy(payload.data(), &header_v2, sizeof(header_v2));
-    in.read(reinterpret_cast<char*>(payload.data() + sizeof(header_v2)), static_cast<std::streamsize>(payload_bytes));
-    if (!in) {
-        throw std::runtime_error("unable to read chunk payload");
+    std::memcpy(index_.data(), bytes.data() + sizeof(region_file_header), index_bytes);
+    for (const auto& entry : index_) {
+        if (entry.sector_count != 0
+            && std::uintmax_t{entry.sector} * header_.sector_size + entry.size > bytes.size()) {
+            throw std::runtime_error("corrupt region file index entry");
+        }
     }
-    return deserialize_chunk(payload);
 }
 
-inline region_blob serialize_snapshot(const region_manager::region_snapshot& snapshot) {
-    region_blob blob;
-    blob.key = snapshot.key;
-    if (snapshot.chunk) {
-        blob.payload = serialize_chunk(*snapshot.chunk);
-    }
-    return blob;
+inline bool mapped_region_file::contains(const region_key& chunk) const noexcept {
+    const auto index = slot(chunk);
+    return index && index_[*index].sector_count != 0;
 }
 
-template <typename Sink>
-auto make_region_serializer(Sink&& sink) {
-    return [sink = std::forward<Sink>(sink)](const region_manager::region_snapshot& snapshot) mutable {
-        sink(serialize_snapshot(snapshot));
-    };
+inline std::size_t mapped_region_file::chunk_count() const noexcept {
+    std::size_t count = 0;
+    for (const auto& entry : index_) {
+        count += entry.sector_count != 0 ? 1 : 0;
+    }
+    return count;
 }
 
-template <typename Sink>
-void dump_region(const region_manager& manager, Sink&& sink, bool include_clean = false) {
-    auto&& callable = std::forward<Sink>(sink);
-    for (const auto& snapshot : manager.snapshot_loaded(include_clean)) {
-        callable(snapshot);
+inline std::optional<chunk_view> mapped_region_file::view(const region_key& chunk) const {
+    const auto index = slot(chunk);
+    if (!index || index_[*index].sector_count == 0) {
+        return std::nullopt;
     }
+    return view_slot(*index);
 }
 
-inline auto file_sink(const std::filesystem::path& path) {
-    return [path](const region_blob& blob) {
-        std::filesystem::create_directories(path.parent_path());
-        std::ofstream out(path, std::ios::binary | std::ios::app);
-        if (!out) {
-            throw std::runtime_error("failed to open region file");
+inline void mapped_region_file::for_each(
+    const std::function<void(const region_key&, const chunk_view&)>& visitor) const {
+    const auto n = static_cast<std::int32_t>(header_.region_size);
+    const auto origin = region();
+    for (std::size_t i = 0; i < index_.size(); ++i) {
+        if (index_[i].sector_count == 0) {
+            continue;
         }
-        out.write(reinterpret_cast<const char*>(&blob.key), sizeof(blob.key));
-        const std::uint32_t size = static_cast<std::uint32_t>(blob.payload.size());
-        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
-        out.write(reinterpret_cast<const char*>(blob.payload.data()), static_cast<std::streamsize>(blob.payload.size()));
-    };
+        const auto local = static_cast<std::int32_t>(i);
+        const region_key key{origin.x * n + local % n, origin.y * n + (local / n) % n, origin.z * n + local / (n * n)};
+        visitor(key, view_slot(i));
+    }
 }
 
-inline std::optional<region_blob> read_region_blob(std::istream& in) {
-    region_blob blob;
-    in.read(reinterpret_cast<char*>(&blob.key), sizeof(blob.key));
-    if (!in) {
-        return std::nullopt;
-    }
-    std::uint32_t size = 0;
-    in.read(reinterpret_cast<char*>(&size), sizeof(size));
-    if (!in) {
+inline std::optional<std::size_t> mapped_region_file::slot(const region_key& chunk) const noexcept {
+    if (region_file::region_of(chunk, header_.region_size) != region()) {
         return std::nullopt;
     }
-    blob.payload.resize(size);
-    in.read(reinterpret_cast<char*>(blob.payload.data()), static_cast<std::streamsize>(size));
-    if (!in) {
-        return std::nullopt;
-    }
-    return blob;
+    const auto size = static_cast<std::int32_t>(header_.region_size);
+    const auto local = [size](std::int32_t value) { return static_cast<std::size_t>(((value % size) + size) % size); };
+    const std::size_t n = header_.region_size;
+    return local(chunk.x) + n * (local(chunk.y) + n * local(chunk.z));
 }
 
-inline void ingest_blob(region_manager& manager, const region_blob& blob) {
-    chunk_storage chunk = deserialize_chunk(blob.payload);
-    auto& target = manager.assure(blob.key);
-    target = std::move(chunk);
-    target.mark_dirty(false);
+inline chunk_view mapped_region_file::view_slot(std::size_t index) const {
+    const auto& entry = index_[index];
+    const auto offset = static_cast<std::size_t>(std::uintmax_t{entry.sector} * header_.sector_size);
+    const auto payload = file_->bytes().subspan(offset, entry.size);
+    if (header_.version >= 2 && detail::region_payload_checksum(payload) != entry.checksum) {
+        throw std::runtime_error("region file payload checksum mismatch");
+    }
+    return chunk_view{payload, file_};
 }
 
 } // namespace almond::voxel::serialization
-// end: almond_voxel/serialization/region_io.hpp
+// end: almond_voxel/serialization/mapped_region.hpp
 
 // begin: almond_voxel/terrain/classic.hpp
 
@@ -3560,6 +11489,7 @@ inline void ingest_blob(region_manager& manager, const region_blob& blob) {
 #include <cstdint>
 #include <vector>
 
+
 namespace almond::voxel::terrain {
 
 struct classic_config {
@@ -3685,13 +11615,15 @@ inline double classic_heightfield::sample_height(double world_x, double world_y)
 
 // begin: almond_voxel/raytracing/structures.hpp
 
+
 #include <algorithm>
 #include <array>
 #include <cstdint>
-#include <limits>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include <limits>
 
 namespace almond::voxel::raytracing {
 
@@ -3708,6 +11640,15 @@ struct voxel_node_bounds {
         min_material = std::min(min_material, id);
         max_material = std::max(max_material, id);
     }
+
+    void merge(const voxel_node_bounds& other) {
+        if (!other.occupied) {
+            return;
+        }
+        occupied = true;
+        min_material = std::min(min_material, other.min_material);
+        max_material = std::max(max_material, other.max_material);
+    }
 };
 
 struct sparse_voxel_octree_node {
@@ -3732,6 +11673,8 @@ public:
     sparse_voxel_octree() = default;
 
     void build(const chunk_storage& chunk, std::uint32_t max_depth = 5);
+    // Rebuilds only the subtrees intersecting `dirty`, falling back to a full build when a subtree empties out.
+    void update(const chunk_storage& chunk, const voxel_bounds& dirty);
 
     [[nodiscard]] const sparse_voxel_octree_node& root() const { return nodes_.front(); }
     [[nodiscard]] const std::vector<sparse_voxel_octree_node>& nodes() const { return nodes_; }
@@ -3742,10 +11685,14 @@ private:
     void build_node(std::uint32_t node_index, const chunk_storage& chunk, std::uint32_t depth,
         std::array<std::uint32_t, 3> size, std::array<std::uint32_t, 3> offset, std::uint32_t max_depth);
 
+    [[nodiscard]] bool update_node(std::uint32_t node_index, const chunk_storage& chunk, std::uint32_t depth,
+        std::array<std::uint32_t, 3> size, std::array<std::uint32_t, 3> offset, const voxel_bounds& dirty);
+
     [[nodiscard]] static voxel_node_bounds accumulate_bounds(const chunk_storage& chunk,
         const std::array<std::uint32_t, 3>& size, const std::array<std::uint32_t, 3>& offset);
 
     std::vector<sparse_voxel_octree_node> nodes_{};
+    std::uint32_t max_depth_{5};
 };
 
 struct clipmap_level {
@@ -3756,6 +11703,7 @@ struct clipmap_level {
 class clipmap_grid {
 public:
     void build(const chunk_storage& chunk, std::uint32_t levels = 3);
+    void update(const chunk_storage& chunk, const voxel_bounds& dirty);
 
     [[nodiscard]] const std::vector<clipmap_level>& levels() const noexcept { return levels_; }
 
@@ -3763,16 +11711,22 @@ private:
     std::vector<clipmap_level> levels_{};
 };
 
+// Entry updates and invalidations are serialised internally so region tasks running on worker threads may share one
+// cache. Pointers returned by find/assure stay valid until the entry is updated again.
 class acceleration_cache {
 public:
     struct region_entry {
         sparse_voxel_octree svo{};
         clipmap_grid clipmap{};
         bool dirty{true};
+        bool built{false};
+        voxel_bounds pending{};
     };
 
+    // Brings the entry up to date. Entries invalidated only by bounded edits are patched in place.
     void update_region(const region_key& key, const chunk_storage& chunk);
     void invalidate_region(const region_key& key);
+    void invalidate_region(const region_key& key, const voxel_bounds& bounds);
 
     [[nodiscard]] const region_entry* find(const region_key& key) const;
     [[nodiscard]] region_entry* assure(const region_key& key);
@@ -3780,16 +11734,82 @@ public:
     void rebuild_dirty(const region_manager& manager);
 
 private:
+    void update_entry(region_entry& entry, const chunk_storage& chunk);
+
+    mutable std::mutex mutex_{};
     std::unordered_map<region_key, region_entry, region_key_hash> regions_{};
 };
 
 inline void sparse_voxel_octree::build(const chunk_storage& chunk, std::uint32_t max_depth) {
+    max_depth_ = max_depth;
     nodes_.clear();
     nodes_.push_back({});
     auto extent = chunk.extent();
+    if (const auto uniform = chunk.uniform_voxel()) {
+        // Homogeneous chunks collapse to a single leaf covering the whole extent.
+        auto& root = nodes_.front();
+        root.bounds.include(*uniform);
+        if (!root.bounds.occupied) {
+            root.bounds.min_material = 0;
+        }
+        root.size = extent.x;
+        root.children.fill(std::numeric_limits<std::uint32_t>::max());
+        return;
+    }
     build_node(0, chunk, 0, {extent.x, extent.y, extent.z}, {0, 0, 0}, max_depth);
 }
 
+inline void sparse_voxel_octree::update(const chunk_storage& chunk, const voxel_bounds& dirty) {
+    const auto extent = chunk.extent();
+    if (dirty.empty() && !nodes_.empty()) {
+        return;
+    }
+    if (nodes_.empty() || dirty.covers(extent) || chunk.uniform_voxel()
+        || !update_node(0, chunk, 0, {extent.x, extent.y, extent.z}, {0, 0, 0}, dirty)) {
+        build(chunk, max_depth_);
+    }
+}
+
+inline bool sparse_voxel_octree::update_node(std::uint32_t node_index, const chunk_storage& chunk, std::uint32_t depth,
+    std::array<std::uint32_t, 3> size, std::array<std::uint32_t, 3> offset, const voxel_bounds& dirty) {
+    const voxel_bounds box{offset, {offset[0] + size[0], offset[1] + size[1], offset[2] + size[2]}};
+    if (!box.intersects(dirty)) {
+        return true;
+    }
+    if (nodes_[node_index].leaf) {
+        build_node(node_index, chunk, depth, size, offset, max_depth_);
+        return true;
+    }
+
+    const std::array<std::uint32_t, 3> child_size{
+        std::max<std::uint32_t>(1, size[0] / 2), std::max<std::uint32_t>(1, size[1] / 2), std::max<std::uint32_t>(1, size[2] / 2)};
+    voxel_node_bounds merged{};
+    for (std::uint32_t child = 0; child < 8; ++child) {
+        std::array<std::uint32_t, 3> child_offset = offset;
+        if (child & 1) {
+            child_offset[0] += child_size[0];
+        }
+        if (child & 2) {
+            child_offset[1] += child_size[1];
+        }
+        if (child & 4) {
+            child_offset[2] += child_size[2];
+        }
+        const std::uint32_t child_index = nodes_[node_index].children[child];
+        if (!update_node(child_index, chunk, depth + 1, child_size, child_offset, dirty)) {
+            return false;
+        }
+        merged.merge(nodes_[child_index].bounds);
+    }
+    if (!merged.occupied) {
+        return false;
+    }
+    // Odd extents leave a remainder the children do not cover, so those nodes rescan their own box.
+    const bool exact = size[0] % 2 == 0 && size[1] % 2 == 0 && size[2] % 2 == 0;
+    nodes_[node_index].bounds = exact ? merged : accumulate_bounds(chunk, size, offset);
+    return true;
+}
+
 inline voxel_node_bounds sparse_voxel_octree::accumulate_bounds(const chunk_storage& chunk,
     const std::array<std::uint32_t, 3>& size, const std::array<std::uint32_t, 3>& offset) {
     voxel_node_bounds bounds;
@@ -3828,14 +11848,19 @@ inline void sparse_voxel_octree::build_node(std::uint32_t node_index, const chun
         return;
     }
 
+    // Children are allocated as one contiguous block before recursing; recursion grows nodes_, so the parent is
+    // re-fetched by index rather than held by reference.
+    const auto first_child = static_cast<std::uint32_t>(nodes_.size());
     node.leaf = false;
-    node.first_child = static_cast<std::uint32_t>(nodes_.size());
+    node.first_child = first_child;
+    for (std::uint32_t child = 0; child < 8; ++child) {
+        node.children[child] = first_child + child;
+    }
+    nodes_.resize(nodes_.size() + 8);
     const std::array<std::uint32_t, 3> child_size{
         std::max<std::uint32_t>(1, size[0] / 2), std::max<std::uint32_t>(1, size[1] / 2), std::max<std::uint32_t>(1, size[2] / 2)};
 
     for (std::uint32_t child = 0; child < 8; ++child) {
-        nodes_.push_back({});
-        node.children[child] = node.first_child + child;
         std::array<std::uint32_t, 3> child_offset = offset;
         if (child & 1) {
             child_offset[0] += child_size[0];
@@ -3846,7 +11871,7 @@ inline void sparse_voxel_octree::build_node(std::uint32_t node_index, const chun
         if (child & 4) {
             child_offset[2] += child_size[2];
         }
-        build_node(node.children[child], chunk, depth + 1, child_size, child_offset, max_depth);
+        build_node(first_child + child, chunk, depth + 1, child_size, child_offset, max_depth);
     }
 }
 
@@ -3871,11 +11896,22 @@ inline void clipmap_grid::build(const chunk_storage& chunk, std::uint32_t levels
     levels_.reserve(levels);
     auto extent = chunk.extent();
     std::array<std::uint32_t, 3> dims{extent.x, extent.y, extent.z};
+    const auto uniform = chunk.uniform_voxel();
 
     for (std::uint32_t level = 0; level < levels; ++level) {
         clipmap_level entry;
         entry.dimensions = dims;
         entry.cells.resize(static_cast<std::size_t>(dims[0]) * dims[1] * dims[2]);
+        if (uniform) {
+            voxel_node_bounds bounds{};
+            bounds.include(*uniform);
+            std::fill(entry.cells.begin(), entry.cells.end(), bounds);
+            levels_.push_back(std::move(entry));
+            dims[0] = std::max(1U, dims[0] / 2);
+            dims[1] = std::max(1U, dims[1] / 2);
+            dims[2] = std::max(1U, dims[2] / 2);
+            continue;
+        }
         const auto voxels = chunk.voxels();
         for (std::uint32_t z = 0; z < dims[2]; ++z) {
             for (std::uint32_t y = 0; y < dims[1]; ++y) {
@@ -3894,22 +11930,67 @@ inline void clipmap_grid::build(const chunk_storage& chunk, std::uint32_t levels
     }
 }
 
+inline void clipmap_grid::update(const chunk_storage& chunk, const voxel_bounds& dirty) {
+    if (levels_.empty() || chunk.uniform_voxel()) {
+        build(chunk, levels_.empty() ? 3 : static_cast<std::uint32_t>(levels_.size()));
+        return;
+    }
+    const auto voxels = chunk.voxels();
+    for (auto& level : levels_) {
+        const auto& dims = level.dimensions;
+        const chunk_extent level_extent{dims[0], dims[1], dims[2]};
+        const auto region = dirty.expanded({0, 0, 0}, {0, 0, 0}, level_extent);
+        for (std::uint32_t z = region.min[2]; z < region.max[2]; ++z) {
+            for (std::uint32_t y = region.min[1]; y < region.max[1]; ++y) {
+                for (std::uint32_t x = region.min[0]; x < region.max[0]; ++x) {
+                    auto& cell = level.cells[x + dims[0] * (y + dims[1] * z)];
+                    cell = voxel_node_bounds{};
+                    if (voxels.contains(x, y, z)) {
+                        cell.include(voxels(x, y, z));
+                    }
+                }
+            }
+        }
+    }
+}
+
 inline void acceleration_cache::update_region(const region_key& key, const chunk_storage& chunk) {
-    auto& entry = regions_[key];
-    entry.svo.build(chunk);
-    entry.clipmap.build(chunk);
+    std::scoped_lock lock{mutex_};
+    update_entry(regions_[key], chunk);
+}
+
+inline void acceleration_cache::update_entry(region_entry& entry, const chunk_storage& chunk) {
+    if (entry.built && entry.dirty && !entry.pending.empty() && !entry.pending.covers(chunk.extent())) {
+        entry.svo.update(chunk, entry.pending);
+        entry.clipmap.update(chunk, entry.pending);
+    } else {
+        entry.svo.build(chunk);
+        entry.clipmap.build(chunk);
+    }
+    entry.built = true;
+    entry.pending = voxel_bounds{};
     entry.dirty = false;
 }
 
 inline void acceleration_cache::invalidate_region(const region_key& key) {
-    if (auto it = regions_.find(key); it != regions_.end()) {
-        it->second.dirty = true;
-    } else {
-        regions_[key].dirty = true;
+    std::scoped_lock lock{mutex_};
+    auto& entry = regions_[key];
+    entry.dirty = true;
+    entry.pending = voxel_bounds{};
+}
+
+inline void acceleration_cache::invalidate_region(const region_key& key, const voxel_bounds& bounds) {
+    std::scoped_lock lock{mutex_};
+    auto& entry = regions_[key];
+    if (entry.dirty && entry.pending.empty()) {
+        return;
     }
+    entry.dirty = true;
+    entry.pending.merge(bounds);
 }
 
 inline const acceleration_cache::region_entry* acceleration_cache::find(const region_key& key) const {
+    std::scoped_lock lock{mutex_};
     if (auto it = regions_.find(key); it != regions_.end()) {
         return &it->second;
     }
@@ -3917,33 +11998,35 @@ inline const acceleration_cache::region_entry* acceleration_cache::find(const re
 }
 
 inline acceleration_cache::region_entry* acceleration_cache::assure(const region_key& key) {
+    std::scoped_lock lock{mutex_};
     return &regions_[key];
 }
 
 inline void acceleration_cache::rebuild_dirty(const region_manager& manager) {
     auto snapshots = manager.snapshot_loaded(true);
+    std::scoped_lock lock{mutex_};
     for (const auto& snapshot : snapshots) {
         if (!snapshot.chunk) {
             continue;
         }
         auto it = regions_.find(snapshot.key);
         if (it == regions_.end() || it->second.dirty) {
-            update_region(snapshot.key, *snapshot.chunk);
+            update_entry(regions_[snapshot.key], *snapshot.chunk);
         }
     }
 }
 
 } // namespace almond::voxel::raytracing
-
 // end: almond_voxel/raytracing/structures.hpp
 
 // begin: almond_voxel/raytracing/ray_queries.hpp
 
-#include <algorithm>
+
 #include <array>
 #include <cmath>
-#include <limits>
 #include <optional>
+#include <algorithm>
+#include <limits>
 
 namespace almond::voxel::raytracing {
 
@@ -4107,33 +12190,59 @@ inline void export_gpu_nodes(const acceleration_cache& cache, const region_key&
 }
 
 } // namespace almond::voxel::raytracing
-
 // end: almond_voxel/raytracing/ray_queries.hpp
 
 // begin: almond_voxel/raytracing/lighting.hpp
 
-#include <algorithm>
+
 #include <memory>
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 namespace almond::voxel::raytracing {
 
-inline void bake_lighting(chunk_storage& chunk, const sparse_voxel_octree& svo) {
+namespace detail {
+
+inline cone_trace_desc bake_cone() noexcept {
+    cone_trace_desc desc{};
+    desc.aperture = 0.75f;
+    desc.steps = 6;
+    desc.max_distance = 12.0f;
+    return desc;
+}
+
+} // namespace detail
+
+// Cells whose baked light can change when voxels inside `dirty` change: the upward bake cone reaches
+// `max_distance` above each cell and `aperture` to the sides.
+inline voxel_bounds lighting_influence(const voxel_bounds& dirty, chunk_extent extent) {
+    const auto desc = detail::bake_cone();
+    const auto side = static_cast<std::uint32_t>(std::ceil(desc.aperture));
+    const auto reach = static_cast<std::uint32_t>(std::ceil(desc.max_distance)) + side;
+    return dirty.expanded({side, reach, side}, {side, side, side}, extent);
+}
+
+// Re-bakes the cells inside `region` only. Use lighting_influence() to turn an edit box into a bake region.
+inline void bake_lighting(chunk_storage& chunk, const sparse_voxel_octree& svo, const voxel_bounds& region) {
     (void)svo;
-    auto voxels = chunk.voxels();
+    const auto bounds = region.expanded({0, 0, 0}, {0, 0, 0}, chunk.extent());
+    if (bounds.empty()) {
+        return;
+    }
+    auto scope = chunk.edit();
+    const auto voxels = std::as_const(chunk).voxels();
     auto blocklight = chunk.blocklight();
     auto skylight = chunk.skylight();
     if (voxels.empty() || blocklight.empty() || skylight.empty()) {
         return;
     }
 
-    cone_trace_desc desc{};
-    desc.aperture = 0.75f;
-    desc.steps = 6;
-    desc.max_distance = 12.0f;
+    auto desc = detail::bake_cone();
 
-    for (std::uint32_t z = 0; z < voxels.extent().z; ++z) {
-        for (std::uint32_t y = 0; y < voxels.extent().y; ++y) {
-            for (std::uint32_t x = 0; x < voxels.extent().x; ++x) {
+    for (std::uint32_t z = bounds.min[2]; z < bounds.max[2]; ++z) {
+        for (std::uint32_t y = bounds.min[1]; y < bounds.max[1]; ++y) {
+            for (std::uint32_t x = bounds.min[0]; x < bounds.max[0]; ++x) {
                 voxel_id id = voxels(x, y, z);
                 if (id == voxel_id{}) {
                     blocklight(x, y, z) = 0;
@@ -4152,15 +12261,19 @@ inline void bake_lighting(chunk_storage& chunk, const sparse_voxel_octree& svo)
     }
 }
 
+inline void bake_lighting(chunk_storage& chunk, const sparse_voxel_octree& svo) {
+    bake_lighting(chunk, svo, voxel_bounds::full(chunk.extent()));
+}
+
 inline void enqueue_global_illumination(region_manager& manager, const std::shared_ptr<acceleration_cache>& cache) {
     if (!cache) {
         return;
     }
 
     cache->rebuild_dirty(manager);
-    manager.add_dirty_observer([cache](const region_key& key) {
-        cache->invalidate_region(key);
-    });
+    manager.add_dirty_region_observer([cache](const region_key& key, const dirty_event& event) {
+        cache->invalidate_region(key, event.bounds);
+    }, chunk_plane::voxels);
 
     auto snapshots = manager.snapshot_loaded(true);
     for (const auto& snapshot : snapshots) {
@@ -4171,14 +12284,12 @@ inline void enqueue_global_illumination(region_manager& manager, const std::shar
             cache->update_region(key, chunk);
             if (auto* entry = cache->find(key); entry != nullptr) {
                 bake_lighting(chunk, entry->svo);
-                chunk.mark_dirty();
             }
         });
     }
 }
 
 } // namespace almond::voxel::raytracing
-
 // end: almond_voxel/raytracing/lighting.hpp
 
 // begin: almond_voxel/version.hpp
@@ -1,7 +1,16 @@
 #include "almond_voxel/chunk.hpp"
 #include "test_framework.hpp"
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using namespace almond::voxel;
 
@@ -25,3 +34,389 @@ TEST_CASE(chunk_span_addressing) {
         CHECK(flat[i] == static_cast<voxel_id>(i + 1));
     }
 }
+
+TEST_CASE(palette_plane_grows_index_width) {
+    palette_plane plane{64, voxel_id{3}};
+    CHECK(plane.bits_per_index() == 0);
+    CHECK(plane.get(17) == voxel_id{3});
+
+    plane.set(5, voxel_id{9});
+    CHECK(plane.bits_per_index() == 1);
+    plane.set(6, voxel_id{10});
+    CHECK(plane.bits_per_index() == 2);
+    for (std::uint32_t i = 0; i < 20; ++i) {
+        plane.set(i, static_cast<voxel_id>(100 + i));
+    }
+    CHECK(plane.bits_per_index() == 8);
+    CHECK(plane.get(5) == voxel_id{105});
+    CHECK(plane.get(40) == voxel_id{3});
+
+    for (std::uint32_t i = 0; i < 64; ++i) {
+        plane.set(i, static_cast<voxel_id>(1000 + i * 500));
+    }
+    CHECK(plane.get(63) == static_cast<voxel_id>(1000 + 63 * 500));
+
+    palette_plane wide{300};
+    for (std::uint32_t i = 0; i < 300; ++i) {
+        wide.set(i, static_cast<voxel_id>(i * 7));
+    }
+    CHECK(wide.direct());
+    CHECK(wide.get(299) == static_cast<voxel_id>(299 * 7));
+
+    plane.fill(voxel_id{1});
+    plane.set(0, voxel_id{2});
+    plane.compact();
+    CHECK(plane.palette().size() == 2);
+    CHECK(plane.bits_per_index() == 1);
+}
+
+TEST_CASE(chunk_palette_layout_roundtrip) {
+    chunk_storage_config config{};
+    config.extent = cubic_extent(8);
+    config.layout = voxel_layout::palette;
+    chunk_storage chunk{config};
+    CHECK(chunk.layout() == voxel_layout::palette);
+
+    CHECK(chunk.set_voxel(1, 2, 3, voxel_id{7}));
+    CHECK(chunk.set_voxel(7, 7, 7, voxel_id{8}));
+    CHECK_FALSE(chunk.set_voxel(8, 0, 0, voxel_id{1}));
+    CHECK(chunk.layout() == voxel_layout::palette);
+    REQUIRE(chunk.palette() != nullptr);
+    CHECK(chunk.palette()->bits_per_index() == 2);
+    CHECK(chunk.voxel_at(1, 2, 3) == voxel_id{7});
+
+    const auto& const_chunk = chunk;
+    std::vector<voxel_id> scratch;
+    CHECK(const_chunk.read_voxels(scratch)(7, 7, 7) == voxel_id{8});
+    CHECK(chunk.layout() == voxel_layout::palette);
+    voxel_id row[3]{};
+    const_chunk.copy_voxel_row(0, 2, 3, row);
+    CHECK(row[1] == voxel_id{7});
+    CHECK(const_chunk.voxels()(7, 7, 7) == voxel_id{8});
+    CHECK(chunk.palette() != nullptr);
+    CHECK(chunk.set_voxel(2, 2, 2, voxel_id{8}));
+    CHECK(chunk.layout() == voxel_layout::palette);
+    CHECK(chunk.memory_usage().bytes(chunk_plane::voxels) == chunk.palette()->memory_usage());
+    CHECK(chunk.voxel_at(2, 2, 2) == voxel_id{8});
+
+    chunk.voxels()(0, 0, 0) = voxel_id{9};
+    CHECK(chunk.palette() == nullptr);
+    CHECK(chunk.compact_voxels());
+    CHECK(chunk.layout() == voxel_layout::palette);
+    CHECK(chunk.voxel_at(0, 0, 0) == voxel_id{9});
+    CHECK(chunk.voxel_at(1, 2, 3) == voxel_id{7});
+    CHECK(chunk.voxel_at(4, 4, 4) == voxel_id{});
+}
+
+TEST_CASE(chunk_uniform_planes_allocate_lazily) {
+    chunk_storage_config config{};
+    config.extent = cubic_extent(8);
+    config.enable_materials = true;
+    chunk_storage chunk{config};
+    REQUIRE(chunk.uniform());
+    REQUIRE(chunk.uniform_voxel().has_value());
+    CHECK(*chunk.uniform_voxel() == voxel_id{});
+
+    chunk.fill(voxel_id{3}, 15);
+    const auto values = chunk.uniform_values();
+    REQUIRE(values.has_value());
+    CHECK(values->voxel == voxel_id{3});
+    CHECK(values->skylight == 15);
+    CHECK(values->material == invalid_material_index);
+
+    const auto& const_chunk = chunk;
+    CHECK(const_chunk.skylight()(7, 7, 7) == 15);
+    CHECK(const_chunk.voxels()(1, 2, 3) == voxel_id{3});
+    CHECK(chunk.uniform());
+    CHECK(chunk.release_uniform_planes());
+
+    CHECK(chunk.set_voxel(0, 0, 0, voxel_id{3}));
+    CHECK(chunk.uniform());
+    CHECK(chunk.set_voxel(0, 0, 0, voxel_id{4}));
+    CHECK_FALSE(chunk.uniform_voxel().has_value());
+    CHECK(chunk.voxel_at(0, 0, 0) == voxel_id{4});
+    CHECK(chunk.voxel_at(1, 0, 0) == voxel_id{3});
+
+    chunk.skylight()(0, 0, 0) = 2;
+    chunk.fill(voxel_id{});
+    CHECK(chunk.uniform());
+}
+
+TEST_CASE(chunk_write_scope_marks_planes_once) {
+    chunk_storage chunk{cubic_extent(4)};
+    chunk.mark_dirty(false);
+
+    int notifications = 0;
+    chunk_plane notified = chunk_plane::none;
+    int voxel_notifications = 0;
+    chunk.add_plane_dirty_listener([&](const dirty_event& event) {
+        ++notifications;
+        notified = event.planes;
+    });
+    chunk.add_plane_dirty_listener([&](const dirty_event&) { ++voxel_notifications; }, chunk_plane::voxels);
+
+    const auto& const_chunk = chunk;
+    CHECK(const_chunk.voxels()(0, 0, 0) == voxel_id{});
+    CHECK(const_chunk.skylight()(0, 0, 0) == 0);
+    CHECK_FALSE(chunk.dirty());
+    CHECK(notifications == 0);
+
+    {
+        auto scope = chunk.edit();
+        for (std::uint32_t x = 0; x < 4; ++x) {
+            scope->skylight()(x, 0, 0) = 15;
+            scope->blocklight()(x, 0, 0) = 3;
+        }
+        CHECK(notifications == 0);
+    }
+    CHECK(notifications == 1);
+    CHECK(notified == (chunk_plane::skylight | chunk_plane::blocklight));
+    CHECK(voxel_notifications == 0);
+    CHECK(chunk.dirty_planes() == (chunk_plane::skylight | chunk_plane::blocklight));
+
+    CHECK(chunk.set_voxel(1, 1, 1, voxel_id{2}));
+    CHECK(chunk.set_voxel(1, 1, 1, voxel_id{2}));
+    CHECK(voxel_notifications == 1);
+    CHECK(contains(chunk.dirty_planes(), chunk_plane::voxels));
+
+    chunk.clear_dirty(chunk_plane::lighting);
+    CHECK(chunk.dirty_planes() == chunk_plane::voxels);
+    chunk.mark_dirty(false);
+    CHECK_FALSE(chunk.dirty());
+}
+
+TEST_CASE(chunk_dirty_bounds_accumulate_edits) {
+    chunk_storage chunk{cubic_extent(8)};
+    CHECK(chunk.dirty_bounds().empty());
+
+    voxel_bounds last{};
+    chunk.add_plane_dirty_listener([&](const dirty_event& event) { last = event.bounds; });
+
+    chunk.set_voxel(2, 3, 4, voxel_id{1});
+    CHECK(last == voxel_bounds::cell(2, 3, 4));
+    chunk.set_voxel(5, 1, 4, voxel_id{1});
+    CHECK(chunk.dirty_bounds() == (voxel_bounds{{2, 1, 4}, {6, 4, 5}}));
+    CHECK(chunk.dirty_bounds().volume() == 12);
+
+    {
+        auto scope = chunk.edit();
+        scope->set_voxel(0, 0, 0, voxel_id{2});
+        scope->set_voxel(1, 1, 1, voxel_id{2});
+    }
+    CHECK(last == (voxel_bounds{{0, 0, 0}, {2, 2, 2}}));
+
+    chunk.clear_dirty_bounds();
+    CHECK(chunk.dirty_bounds().empty());
+    chunk.metadata()(0, 0, 0) = 1;
+    CHECK(chunk.dirty_bounds().covers(chunk.extent()));
+
+    chunk.mark_dirty(false);
+    CHECK(chunk.dirty_bounds().empty());
+}
+
+TEST_CASE(chunk_memory_usage_tracks_planes) {
+    chunk_storage_config config{};
+    config.extent = cubic_extent(8);
+    config.enable_high_precision_lighting = true;
+    chunk_storage chunk{config};
+    const auto volume = chunk.volume();
+
+    const auto empty = chunk.memory_usage();
+    CHECK(empty.bytes(chunk_plane::all) < volume);
+    CHECK(empty.bytes(chunk_plane::all & ~chunk_plane::voxels) == 0);
+
+    chunk.voxels()(1, 2, 3) = voxel_id{4};
+    chunk.skylight_cache()(0, 0, 0) = 1.0f;
+    const auto usage = chunk.memory_usage();
+    CHECK(usage.bytes(chunk_plane::voxels) >= volume * sizeof(voxel_id));
+    CHECK(usage.bytes(chunk_plane::skylight_cache) == volume * sizeof(float));
+    CHECK(usage.bytes(chunk_plane::blocklight_cache) == 0);
+    CHECK(usage.bytes(chunk_plane::lighting) == volume * sizeof(float));
+    CHECK(usage.total() > empty.total());
+
+    chunk.fill(voxel_id{2});
+    CHECK(chunk.release_uniform_planes());
+    CHECK(chunk.memory_usage().bytes(chunk_plane::lighting) == 0);
+}
+
+namespace {
+template <typename T>
+bool codec_round_trips(codec_id id, const std::vector<T>& values) {
+    const auto& registry = codec_registry::shared();
+    std::vector<std::byte> stream{};
+    const auto used = registry.encode(id, std::as_bytes(std::span{values}), sizeof(T), stream);
+    std::vector<T> decoded(values.size());
+    registry.decode(used, stream, std::as_writable_bytes(std::span{decoded}), sizeof(T));
+    return values.empty() || std::memcmp(decoded.data(), values.data(), values.size() * sizeof(T)) == 0;
+}
+}
+
+TEST_CASE(chunk_codecs_round_trip_plane_layouts) {
+    std::mt19937 rng{7};
+    std::vector<voxel_id> terrain(4096);
+    for (std::size_t i = 0; i < terrain.size(); ++i) {
+        terrain[i] = static_cast<voxel_id>((i / 16) % 16 < 6 ? 1 + (i % 7 == 0) : 0);
+    }
+    std::vector<std::uint8_t> noise(1000);
+    for (auto& value : noise) {
+        value = static_cast<std::uint8_t>(rng());
+    }
+    std::vector<float> ramp(777);
+    for (std::size_t i = 0; i < ramp.size(); ++i) {
+        ramp[i] = static_cast<float>(i % 15) / 15.0f;
+    }
+    std::vector<effects::velocity_sample> velocity(300, effects::velocity_sample{0.5f, -1.0f, 0.0f});
+    velocity[42].y = 3.0f;
+    const std::vector<std::uint8_t> tiny{1, 2, 3};
+    const std::vector<std::uint16_t> empty{};
+
+    for (const auto id : {codec_id::raw, codec_id::rle, codec_id::delta_bitpack, codec_id::lz, codec_id::automatic}) {
+        CHECK(codec_round_trips(id, terrain));
+        CHECK(codec_round_trips(id, noise));
+        CHECK(codec_round_trips(id, ramp));
+        CHECK(codec_round_trips(id, velocity));
+        CHECK(codec_round_trips(id, tiny));
+        CHECK(codec_round_trips(id, empty));
+    }
+
+    const auto& registry = codec_registry::shared();
+    std::vector<std::byte> stream{};
+    CHECK(registry.encode(codec_id::automatic, std::as_bytes(std::span{noise}), 1, stream) == codec_id::raw);
+    stream.clear();
+    registry.encode(codec_id::lz, std::as_bytes(std::span{terrain}), sizeof(voxel_id), stream);
+    CHECK(stream.size() * 10 < terrain.size() * sizeof(voxel_id));
+    stream.pop_back();
+    std::vector<voxel_id> decoded(terrain.size());
+    bool truncated = false;
+    try {
+        registry.decode(codec_id::lz, stream, std::as_writable_bytes(std::span{decoded}), sizeof(voxel_id));
+    } catch (const std::runtime_error&) {
+        truncated = true;
+    }
+    CHECK(truncated);
+
+    bool reserved = false;
+    try {
+        codec_registry::shared().add(codec_id::rle, registry.get(codec_id::raw));
+    } catch (const std::logic_error&) {
+        reserved = true;
+    }
+    CHECK(reserved);
+    CHECK_FALSE(registry.find(static_cast<codec_id>(200)).has_value());
+}
+
+TEST_CASE(chunk_codecs_compress_idle_chunk) {
+    chunk_storage_config config{};
+    config.extent = cubic_extent(32);
+    config.enable_high_precision_lighting = true;
+    chunk_storage chunk{config};
+    {
+        auto voxels = chunk.voxels();
+        auto sky = chunk.skylight();
+        auto cache = chunk.skylight_cache();
+        for (std::uint32_t z = 0; z < 32; ++z) {
+            for (std::uint32_t y = 0; y < 32; ++y) {
+                for (std::uint32_t x = 0; x < 32; ++x) {
+                    const auto height = 10u + (x / 8u + z / 4u) % 5u;
+                    voxels(x, y, z) = y < height ? voxel_id{static_cast<voxel_id>(y + 3 < height ? 1 : 2)} : voxel_id{};
+                    sky(x, y, z) = static_cast<std::uint8_t>(y < height ? 0 : 15);
+                    cache(x, y, z) = y < height ? 0.0f : 1.0f;
+                }
+            }
+        }
+    }
+    const auto expected_voxel = chunk.voxel_at(5, 11, 7);
+    const auto before = chunk.memory_usage();
+
+    REQUIRE(chunk.compress());
+    CHECK(chunk.compressed());
+    const auto after = chunk.memory_usage();
+    CHECK(after.bytes(chunk_plane::all) == 0);
+    CHECK(after.compressed > 0);
+    CHECK(before.bytes(chunk_plane::all) >= 5 * (after.bytes(chunk_plane::all) + after.compressed));
+    CHECK_FALSE(chunk.compress());
+
+    CHECK(chunk.voxel_at(5, 11, 7) == expected_voxel);
+    CHECK_FALSE(chunk.compressed());
+    CHECK(chunk.skylight()(0, 31, 0) == 15);
+    CHECK(chunk.skylight_cache()(0, 0, 0) == 0.0f);
+    CHECK(chunk.blocklight_cache()(0, 0, 0) == 0.0f);
+
+    chunk.set_codec_config(chunk_codec_config{}.set(chunk_plane::all, codec_id::automatic));
+    chunk.request_compression();
+    REQUIRE(chunk.flush_compression());
+    CHECK(chunk.decompress());
+    CHECK(chunk.voxel_at(5, 11, 7) == expected_voxel);
+    CHECK(chunk.skylight()(31, 31, 31) == 15);
+
+    chunk_storage packed{chunk_storage_config{cubic_extent(8), voxel_layout::palette}};
+    packed.set_voxel(1, 1, 1, voxel_id{9});
+    CHECK_FALSE(packed.compress());
+    CHECK(packed.layout() == voxel_layout::palette);
+    CHECK(packed.voxel_at(1, 1, 1) == voxel_id{9});
+}
+
+TEST_CASE(chunk_snapshot_shares_planes_until_written) {
+    chunk_storage chunk{cubic_extent(8)};
+    auto voxels = chunk.voxels();
+    voxels(1, 2, 3) = voxel_id{4};
+    chunk.skylight()(1, 2, 3) = 9;
+    chunk.blocklight()(0, 0, 0) = 3;
+
+    const auto frozen = chunk.snapshot();
+    const auto& live = std::as_const(chunk);
+    CHECK(frozen->voxels().data() == live.voxels().data());
+    CHECK(frozen->skylight().data() == live.skylight().data());
+    CHECK(frozen->dirty_planes() == chunk.dirty_planes());
+
+    chunk.set_voxel(1, 2, 3, voxel_id{7});
+    chunk.skylight()(1, 2, 3) = 2;
+    CHECK(frozen->voxel_at(1, 2, 3) == voxel_id{4});
+    CHECK(frozen->skylight()(1, 2, 3) == 9);
+    CHECK(chunk.voxel_at(1, 2, 3) == voxel_id{7});
+    CHECK(frozen->voxels().data() != live.voxels().data());
+    CHECK(frozen->blocklight().data() == live.blocklight().data());
+
+    chunk.fill(voxel_id{1});
+    CHECK(frozen->voxel_at(1, 2, 3) == voxel_id{4});
+    CHECK(frozen->blocklight()(0, 0, 0) == 3);
+
+    chunk.metadata()(2, 2, 2) = 6;
+    CHECK(chunk.compress());
+    const auto warm = chunk.snapshot();
+    chunk.set_voxel(0, 0, 0, voxel_id{5});
+    CHECK(warm->compressed());
+    CHECK(warm->voxel_at(0, 0, 0) == voxel_id{1});
+    CHECK(warm->metadata()(2, 2, 2) == 6);
+    CHECK(chunk.voxel_at(0, 0, 0) == voxel_id{5});
+}
+
+TEST_CASE(chunk_shared_readers_race_dense_materialisation) {
+    chunk_storage chunk{cubic_extent(8)};
+    for (std::uint32_t i = 0; i < 8; ++i) {
+        chunk.set_voxel(i, i, i, voxel_id{static_cast<voxel_id>(i + 1)});
+    }
+
+    std::atomic<int> mismatches{0};
+    for (int round = 0; round < 50; ++round) {
+        CHECK(chunk.compact_voxels());
+        const auto& shared = std::as_const(chunk);
+        std::thread materialise{[&] {
+            auto guard = shared.lock_shared();
+            if (shared.voxels()(3, 3, 3) != voxel_id{4}) {
+                ++mismatches;
+            }
+        }};
+        std::thread sample{[&] {
+            auto guard = shared.lock_shared();
+            for (std::uint32_t i = 0; i < 8; ++i) {
+                if (shared.voxel_at(i, i, i) != voxel_id{static_cast<voxel_id>(i + 1)} || shared.uniform_voxel()) {
+                    ++mismatches;
+                }
+            }
+        }};
+        materialise.join();
+        sample.join();
+    }
+    CHECK(mismatches.load() == 0);
+}
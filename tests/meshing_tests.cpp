@@ -1,6 +1,14 @@
+#include "almond_voxel/meshing/apron.hpp"
+#include "almond_voxel/meshing/batch_mesher.hpp"
+#include "almond_voxel/meshing/binary_greedy_mesher.hpp"
 #include "almond_voxel/meshing/greedy_mesher.hpp"
 #include "almond_voxel/meshing/marching_cubes.hpp"
+#include "almond_voxel/meshing/marching_cubes_lod.hpp"
+#include "almond_voxel/meshing/mesh_context.hpp"
+#include "almond_voxel/meshing/naive_mesher.hpp"
 #include "almond_voxel/meshing/neighbors.hpp"
+#include "almond_voxel/meshing/packed_mesh.hpp"
+#include "almond_voxel/meshing/vertex_shading.hpp"
 #include "test_framework.hpp"
 
 #include "almond_voxel/chunk.hpp"
@@ -9,11 +17,154 @@
 #include <array>
 #include <cstddef>
 #include <cmath>
+#include <deque>
+#include <span>
+#include <stdexcept>
+#include <thread>
 #include <tuple>
 #include <vector>
 
 using namespace almond::voxel;
 
+namespace {
+
+// Unit faces covered by a quad mesh as {axis, sign, plane, a, b, id}, sorted, so meshers that merge differently compare.
+std::vector<std::array<int, 6>> unit_faces(const meshing::mesh_result& mesh) {
+    std::vector<std::array<int, 6>> faces;
+    for (std::size_t quad = 0; quad + 3 < mesh.vertices.size(); quad += 4) {
+        const auto& first = mesh.vertices[quad];
+        const auto axis = first.normal[0] != 0.0f ? 0 : (first.normal[1] != 0.0f ? 1 : 2);
+        const auto sign = first.normal[static_cast<std::size_t>(axis)] > 0.0f ? 1 : -1;
+        const auto a_axis = static_cast<std::size_t>((axis + 1) % 3);
+        const auto b_axis = static_cast<std::size_t>((axis + 2) % 3);
+        std::array<float, 3> low = first.position;
+        std::array<float, 3> high = first.position;
+        for (std::size_t corner = 1; corner < 4; ++corner) {
+            for (std::size_t i = 0; i < 3; ++i) {
+                low[i] = std::min(low[i], mesh.vertices[quad + corner].position[i]);
+                high[i] = std::max(high[i], mesh.vertices[quad + corner].position[i]);
+            }
+        }
+        const auto plane = static_cast<int>(std::lround(first.position[static_cast<std::size_t>(axis)]));
+        for (auto a = static_cast<int>(low[a_axis]); a < static_cast<int>(high[a_axis]); ++a) {
+            for (auto b = static_cast<int>(low[b_axis]); b < static_cast<int>(high[b_axis]); ++b) {
+                faces.push_back({axis, sign, plane, a, b, static_cast<int>(first.id)});
+            }
+        }
+    }
+    std::sort(faces.begin(), faces.end());
+    return faces;
+}
+
+// Expands a packed mesh back into float vertices so it can be compared through unit_faces.
+meshing::mesh_result unpack_mesh(const meshing::packed_mesh& packed) {
+    meshing::mesh_result mesh;
+    for (const auto& source : packed.vertices) {
+        const auto normal = face_normal(source.face());
+        mesh.vertices.push_back(meshing::vertex{{static_cast<float>(source.x()), static_cast<float>(source.y()),
+                                                    static_cast<float>(source.z())},
+            {static_cast<float>(normal[0]), static_cast<float>(normal[1]), static_cast<float>(normal[2])},
+            {static_cast<float>(source.u()), static_cast<float>(source.v())}, source.id()});
+    }
+    mesh.indices = packed.indices;
+    return mesh;
+}
+
+// A 4 x 4 grid of 16^3 chunks, from (-1, -1) to (2, 2) in x and y, filled where `solid(x, y, z)` holds in world
+// voxels.
+class chunk_grid {
+public:
+    template <typename Solid>
+    explicit chunk_grid(Solid&& solid) {
+        const auto extent = cubic_extent(16);
+        for (int cy = -1; cy <= 2; ++cy) {
+            for (int cx = -1; cx <= 2; ++cx) {
+                auto voxels = chunks_.emplace_back(extent).voxels();
+                for (std::uint32_t z = 0; z < extent.z; ++z) {
+                    for (std::uint32_t y = 0; y < extent.y; ++y) {
+                        for (std::uint32_t x = 0; x < extent.x; ++x) {
+                            const bool filled = solid(cx * 16 + static_cast<int>(x), cy * 16 + static_cast<int>(y),
+                                static_cast<int>(z));
+                            voxels(x, y, z) = filled ? voxel_id{1} : voxel_id{};
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] const chunk_storage& at(int cx, int cy) const {
+        return chunks_[static_cast<std::size_t>((cy + 1) * 4 + cx + 1)];
+    }
+
+    [[nodiscard]] meshing::chunk_neighborhood neighborhood(int cx, int cy) const {
+        meshing::chunk_neighborhood result{};
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (cx + dx >= -1 && cx + dx <= 2 && cy + dy >= -1 && cy + dy <= 2) {
+                    result.set(dx, dy, 0, &at(cx + dx, cy + dy));
+                }
+            }
+        }
+        return result;
+    }
+
+private:
+    std::deque<chunk_storage> chunks_;
+};
+
+// Edges in the seam plane x = 16 between the meshes of chunks (0, 0) and (1, 0), away from the z borders and from the
+// chunk edges at y = 0 and y = 16, which also border chunks off the seam, that the two meshes do not use an even number
+// of times. Collapsed triangles, which restricted samples on the iso value leave, are skipped. `edges` receives the
+// number of seam edges seen.
+std::size_t open_seam_edges(const meshing::mesh_result& left, const meshing::mesh_result& right, std::size_t& edges) {
+    std::vector<std::array<long, 6>> seam;
+    const auto collect = [&](const meshing::mesh_result& mesh, float offset_x) {
+        for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            const auto weld = [&](std::size_t corner) {
+                const auto& p = mesh.vertices[mesh.indices[i + corner]].position;
+                return std::array<long, 3>{std::lround((p[0] + offset_x) * 1024.0f), std::lround(p[1] * 1024.0f),
+                    std::lround(p[2] * 1024.0f)};
+            };
+            if (weld(0) == weld(1) || weld(1) == weld(2) || weld(2) == weld(0)) {
+                continue;
+            }
+            for (std::size_t e = 0; e < 3; ++e) {
+                const auto a = weld(e);
+                const auto b = weld((e + 1) % 3);
+                const auto in_seam = [](const std::array<long, 3>& p) {
+                    return p[0] == 16 * 1024 && p[2] > 0 && p[2] < 16 * 1024;
+                };
+                const auto on_chunk_edge = [&](long y) { return a[1] == y && b[1] == y; };
+                if (!in_seam(a) || !in_seam(b) || on_chunk_edge(0) || on_chunk_edge(16 * 1024)) {
+                    continue;
+                }
+                std::array<long, 6> edge{a[0], a[1], a[2], b[0], b[1], b[2]};
+                if (std::lexicographical_compare(edge.begin() + 3, edge.end(), edge.begin(), edge.begin() + 3)) {
+                    std::rotate(edge.begin(), edge.begin() + 3, edge.end());
+                }
+                seam.push_back(edge);
+            }
+        }
+    };
+    collect(left, 0.0f);
+    collect(right, 16.0f);
+    std::sort(seam.begin(), seam.end());
+    edges = seam.size();
+    std::size_t open = 0;
+    for (std::size_t i = 0; i < seam.size();) {
+        std::size_t j = i;
+        while (j < seam.size() && seam[j] == seam[i]) {
+            ++j;
+        }
+        open += (j - i) % 2;
+        i = j;
+    }
+    return open;
+}
+
+} // namespace
+
 TEST_CASE(greedy_mesher_single_voxel) {
     chunk_storage chunk{cubic_extent(3)};
     chunk.fill(voxel_id{});
@@ -29,6 +180,37 @@ TEST_CASE(greedy_mesher_single_voxel) {
     }
 }
 
+TEST_CASE(meshers_short_circuit_uniform_chunks) {
+    const auto extent = cubic_extent(4);
+    chunk_storage empty{extent};
+    CHECK(meshing::greedy_mesh(empty).vertices.empty());
+    CHECK(meshing::naive_mesh(empty).vertices.empty());
+    CHECK(meshing::marching_cubes_from_chunk(empty).vertices.empty());
+
+    chunk_storage solid{extent};
+    solid.fill(voxel_id{2});
+    REQUIRE(solid.uniform_voxel().has_value());
+    chunk_storage dense{extent};
+    dense.fill(voxel_id{2});
+    dense.voxels()(0, 0, 0) = voxel_id{2};
+    REQUIRE_FALSE(dense.uniform_voxel().has_value());
+
+    const auto greedy = meshing::greedy_mesh(solid);
+    CHECK(greedy.vertices.size() == 24);
+    CHECK(greedy.indices == meshing::greedy_mesh(dense).indices);
+
+    const auto naive = meshing::naive_mesh(solid);
+    CHECK(naive.vertices.size() == 6 * 16 * 4);
+    CHECK(naive.vertices.size() == meshing::naive_mesh(dense).vertices.size());
+
+    meshing::chunk_neighbors neighbors{};
+    neighbors.pos_x = &solid;
+    const auto covered = meshing::greedy_mesh_with_neighbor_chunks(dense, neighbors);
+    CHECK(covered.vertices.size() == 20);
+    CHECK_FALSE(meshing::marching_cubes_from_chunk(empty, [](voxel_id id) { return id != voxel_id{}; }, neighbors)
+                    .vertices.empty());
+}
+
 TEST_CASE(greedy_mesher_respects_chunk_neighbors) {
     const auto extent = cubic_extent(2);
     chunk_storage primary{extent};
@@ -321,6 +503,60 @@ TEST_CASE(marching_cubes_triangle_orientation) {
     CHECK(dot(normal, view) < 0.0f);
 }
 
+TEST_CASE(marching_cubes_shares_vertices_and_samples_once) {
+    const chunk_extent extent = cubic_extent(8);
+    std::size_t samples = 0;
+    const auto sphere = [](std::size_t x, std::size_t y, std::size_t z) {
+        const float dx = static_cast<float>(x) - 4.0f;
+        const float dy = static_cast<float>(y) - 4.0f;
+        const float dz = static_cast<float>(z) - 4.0f;
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    };
+    const auto counted = [&](std::size_t x, std::size_t y, std::size_t z) {
+        ++samples;
+        return sphere(x, y, z);
+    };
+    meshing::marching_cubes_config config{};
+    config.iso_value = 3.0f;
+
+    const auto mesh = meshing::marching_cubes(extent, counted, config);
+    CHECK(samples == 9 * 9 * 9);
+    REQUIRE_FALSE(mesh.indices.empty());
+    // A closed surface shares each vertex among about six triangles.
+    CHECK(mesh.vertices.size() * 4 < mesh.indices.size());
+    for (const auto& v : mesh.vertices) {
+        const std::array<float, 3> outward{v.position[0] - 4.0f, v.position[1] - 4.0f, v.position[2] - 4.0f};
+        const float length = std::sqrt(outward[0] * outward[0] + outward[1] * outward[1] + outward[2] * outward[2]);
+        const float dot = (v.normal[0] * outward[0] + v.normal[1] * outward[1] + v.normal[2] * outward[2]) / length;
+        CHECK(dot > 0.9f);
+    }
+
+    // Row samplers and the triangle form produce the same surface.
+    const auto rows = meshing::marching_cubes(extent,
+        meshing::density_rows{[&](std::size_t y, std::size_t z, std::span<float> row) {
+            for (std::size_t x = 0; x < row.size(); ++x) {
+                row[x] = sphere(x, y, z);
+            }
+        }},
+        config);
+    CHECK(rows.indices == mesh.indices);
+    REQUIRE(rows.vertices.size() == mesh.vertices.size());
+    for (std::size_t i = 0; i < mesh.vertices.size(); ++i) {
+        CHECK(rows.vertices[i].position == mesh.vertices[i].position);
+    }
+
+    std::size_t corner = 0;
+    meshing::marching_cubes_triangles(extent, sphere, [](std::size_t, std::size_t, std::size_t) { return voxel_id{1}; },
+        config, [&](const std::array<meshing::vertex, 3>& triangle) {
+            for (const auto& v : triangle) {
+                REQUIRE(corner < mesh.indices.size());
+                CHECK(v.position == mesh.vertices[mesh.indices[corner]].position);
+                ++corner;
+            }
+        });
+    CHECK(corner == mesh.indices.size());
+}
+
 TEST_CASE(marching_cubes_from_chunk_binary) {
     chunk_storage chunk{cubic_extent(1)};
     auto voxels = chunk.voxels();
@@ -354,3 +590,842 @@ TEST_CASE(marching_cubes_respects_chunk_neighbors) {
 
     CHECK_FALSE(has_positive_x_surface);
 }
+
+TEST_CASE(marching_cubes_lod_stitches_coarser_neighbors) {
+    const auto extent = cubic_extent(16);
+    // A sloped heightfield spanning two chunks along x.
+    const auto populate = [&](chunk_storage& chunk, std::uint32_t offset_x) {
+        auto voxels = chunk.voxels();
+        for (std::uint32_t z = 0; z < extent.z; ++z) {
+            for (std::uint32_t y = 0; y < extent.y; ++y) {
+                for (std::uint32_t x = 0; x < extent.x; ++x) {
+                    const auto height = 4 + (z * 5 + (x + offset_x) * 2) / 7;
+                    voxels(x, y, z) = y < height ? voxel_id{1} : voxel_id{};
+                }
+            }
+        }
+    };
+    chunk_storage fine{extent};
+    chunk_storage coarse{extent};
+    populate(fine, 0);
+    populate(coarse, 16);
+    meshing::chunk_neighborhood fine_neighbors{};
+    fine_neighbors.set(1, 0, 0, &coarse);
+    meshing::chunk_neighborhood coarse_neighbors{};
+    coarse_neighbors.set(-1, 0, 0, &fine);
+
+    meshing::marching_cubes_lod coarse_lod{1, {}};
+    coarse_lod.neighbor_levels[static_cast<std::size_t>(block_face::neg_x)] = 0;
+    const auto coarse_mesh = meshing::marching_cubes_from_chunk(coarse, coarse_neighbors, coarse_lod);
+    const auto full_mesh = meshing::marching_cubes_from_chunk(coarse, coarse_neighbors, meshing::marching_cubes_lod{});
+    CHECK(coarse_mesh.indices.size() * 2 < full_mesh.indices.size());
+
+    // Counts how often each edge on the shared face x = 16 is used across both meshes; a closed seam uses each twice.
+    const auto open_seam_edges = [&](const meshing::mesh_result& left) {
+        std::vector<std::array<long, 6>> edges;
+        const auto collect = [&](const meshing::mesh_result& mesh, float offset_x) {
+            for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+                // Restricted samples on the iso value put several vertices at one point; skip collapsed triangles.
+                const auto weld = [&](std::size_t corner) {
+                    const auto& p = mesh.vertices[mesh.indices[i + corner]].position;
+                    return std::array<long, 3>{std::lround((p[0] + offset_x) * 1024.0f), std::lround(p[1] * 1024.0f),
+                        std::lround(p[2] * 1024.0f)};
+                };
+                if (weld(0) == weld(1) || weld(1) == weld(2) || weld(2) == weld(0)) {
+                    continue;
+                }
+                for (std::size_t e = 0; e < 3; ++e) {
+                    const auto& a = mesh.vertices[mesh.indices[i + e]].position;
+                    const auto& b = mesh.vertices[mesh.indices[i + (e + 1) % 3]].position;
+                    const auto on_seam = [&](const std::array<float, 3>& p) {
+                        return std::abs(p[0] + offset_x - 16.0f) < 1e-4f && p[2] > 1e-4f && p[2] < 16.0f - 1e-4f;
+                    };
+                    if (!on_seam(a) || !on_seam(b)) {
+                        continue;
+                    }
+                    std::array<long, 6> edge{std::lround((a[0] + offset_x) * 1024.0f), std::lround(a[1] * 1024.0f),
+                        std::lround(a[2] * 1024.0f), std::lround((b[0] + offset_x) * 1024.0f),
+                        std::lround(b[1] * 1024.0f), std::lround(b[2] * 1024.0f)};
+                    if (std::lexicographical_compare(edge.begin() + 3, edge.end(), edge.begin(), edge.begin() + 3)) {
+                        std::rotate(edge.begin(), edge.begin() + 3, edge.end());
+                    }
+                    edges.push_back(edge);
+                }
+            }
+        };
+        collect(left, 0.0f);
+        collect(coarse_mesh, 16.0f);
+        std::sort(edges.begin(), edges.end());
+        std::size_t open = 0;
+        for (std::size_t i = 0; i < edges.size();) {
+            std::size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i]) {
+                ++j;
+            }
+            open += (j - i) % 2;
+            i = j;
+        }
+        return open;
+    };
+
+    meshing::marching_cubes_lod fine_lod{};
+    CHECK(open_seam_edges(meshing::marching_cubes_from_chunk(fine, fine_neighbors, fine_lod)) > 0);
+    fine_lod.neighbor_levels[static_cast<std::size_t>(block_face::pos_x)] = 1;
+    meshing::mesher_context context;
+    CHECK(open_seam_edges(context.marching_cubes(fine, fine_neighbors, fine_lod)) == 0);
+}
+
+TEST_CASE(marching_cubes_lod_closes_chunk_edges_between_three_levels) {
+    // A bumpy heightfield that crosses the chunk edge x = 16, y = 16 many times along z.
+    const chunk_grid grid{[](int x, int y, int z) { return y < 14 + x / 6 + ((z * 5 + x * 3) % 7) / 2; }};
+
+    // This chunk at level 0, its +x neighbour at 1 and its +y neighbour at 2: the chunk edge between them is
+    // restricted for the +y face, while the +x neighbour still samples it at its own spacing.
+    meshing::marching_cubes_lod lod{};
+    lod.neighbor_levels[static_cast<std::size_t>(block_face::pos_x)] = 1;
+    lod.neighbor_levels[static_cast<std::size_t>(block_face::pos_y)] = 2;
+    meshing::marching_cubes_lod right_lod{1, {}};
+    right_lod.neighbor_levels.fill(1);
+    right_lod.neighbor_levels[static_cast<std::size_t>(block_face::neg_x)] = 0;
+    meshing::mesher_context context;
+    const auto mesh = context.marching_cubes(grid.at(0, 0), grid.neighborhood(0, 0), lod);
+    const auto right = meshing::marching_cubes_from_chunk(grid.at(1, 0), grid.neighborhood(1, 0), right_lod);
+    std::size_t edges = 0;
+    CHECK(open_seam_edges(mesh, right, edges) == 0);
+    CHECK(edges > 0);
+}
+
+TEST_CASE(marching_cubes_lod_stitches_saddle_cells) {
+    // Square columns along x in a checkerboard, so every coarse face cell on x = 16 has solid corners on one diagonal.
+    const chunk_grid grid{[](int, int y, int z) { return y >= 4 && y < 12 && (y / 4 + z / 4) % 2 == 0; }};
+
+    meshing::marching_cubes_lod lod{};
+    lod.neighbor_levels[static_cast<std::size_t>(block_face::pos_x)] = 2;
+    meshing::marching_cubes_lod right_lod{2, {}};
+    right_lod.neighbor_levels[static_cast<std::size_t>(block_face::neg_x)] = 0;
+    const auto mesh = meshing::marching_cubes_from_chunk(grid.at(0, 0), grid.neighborhood(0, 0), lod);
+    const auto right = meshing::marching_cubes_from_chunk(grid.at(1, 0), grid.neighborhood(1, 0), right_lod);
+    std::size_t edges = 0;
+    CHECK(open_seam_edges(mesh, right, edges) == 0);
+    CHECK(edges > 0);
+}
+
+TEST_CASE(marching_cubes_lod_policy_selects_levels_by_distance) {
+    meshing::marching_cubes_lod_policy policy{};
+    CHECK_FALSE(policy.enabled());
+    CHECK(policy.level(region_key{9, 0, 0}, region_key{}) == 0);
+
+    policy.level_distances = {2, 4, 8};
+    CHECK(policy.enabled());
+    CHECK(policy.level(region_key{1, -1, 0}, region_key{}) == 0);
+    CHECK(policy.level(region_key{0, -3, 2}, region_key{}) == 1);
+    CHECK(policy.level(region_key{5, 0, 0}, region_key{1, 0, 0}) == 2);
+    CHECK(policy.level(region_key{0, 0, -20}, region_key{}) == 3);
+
+    const auto lod = policy.select(region_key{3, 0, 0}, region_key{});
+    CHECK(lod.level == 1);
+    CHECK(lod.neighbor_levels[static_cast<std::size_t>(block_face::pos_x)] == 2);
+    CHECK(lod.neighbor_levels[static_cast<std::size_t>(block_face::neg_x)] == 1);
+    CHECK(lod.neighbor_levels[static_cast<std::size_t>(block_face::pos_y)] == 1);
+
+    // Levels the extent cannot divide fall back to the finest that fits.
+    CHECK(meshing::detail::clamp_lod_level(chunk_extent{12, 12, 12}, 3) == 2);
+    CHECK(meshing::detail::clamp_lod_level(chunk_extent{12, 6, 12}, 3) == 1);
+}
+
+TEST_CASE(apron_copies_face_edge_and_corner_neighbors) {
+    const auto extent = cubic_extent(4);
+    chunk_storage center{extent};
+    chunk_storage face{extent};
+    chunk_storage edge{extent};
+    chunk_storage corner{extent};
+    chunk_storage mismatched{cubic_extent(2)};
+    center.set_voxel(0, 0, 0, voxel_id{1});
+    center.set_voxel(3, 2, 1, voxel_id{2});
+    face.set_voxel(1, 2, 3, voxel_id{9});
+    edge.fill(voxel_id{5});
+    corner.set_voxel(3, 3, 3, voxel_id{7});
+    mismatched.fill(voxel_id{6});
+    face.skylight()(1, 2, 3) = 12;
+
+    meshing::chunk_neighborhood neighborhood{};
+    neighborhood.set(0, 0, -1, &face);
+    neighborhood.set(1, 1, 0, &edge);
+    neighborhood.set(-1, -1, -1, &corner);
+    neighborhood.set(0, 1, 0, &mismatched);
+
+    const auto edge_bytes = edge.memory_usage().bytes(chunk_plane::voxels);
+    meshing::padded_grid<voxel_id> apron;
+    meshing::build_voxel_apron(center, neighborhood, apron, voxel_id{3});
+    CHECK(apron.padded_extent() == cubic_extent(6));
+    CHECK(apron(0, 0, 0) == voxel_id{1});
+    CHECK(apron(3, 2, 1) == voxel_id{2});
+    CHECK(apron(1, 2, -1) == voxel_id{9});
+    CHECK(apron(4, 4, 2) == voxel_id{5});
+    CHECK(apron(-1, -1, -1) == voxel_id{7});
+    CHECK(apron(4, 0, 0) == voxel_id{3});
+    CHECK(apron(2, 4, 2) == voxel_id{3});
+    CHECK(apron(4, 4, 4) == voxel_id{3});
+    CHECK(apron[apron.index(1, 2, 0) + static_cast<std::size_t>(-apron.offset(0, 0, 1))] == voxel_id{9});
+    CHECK(edge.memory_usage().bytes(chunk_plane::voxels) == edge_bytes);
+
+    meshing::padded_grid<std::uint8_t> sky;
+    meshing::build_plane_apron(center, neighborhood, sky,
+        [](const chunk_storage& chunk) { return chunk.skylight(); }, std::uint8_t{15});
+    CHECK(sky(1, 2, -1) == 12);
+    CHECK(sky(1, 1, 1) == 0);
+    CHECK(sky(-1, 0, 0) == 15);
+}
+
+TEST_CASE(meshing_palette_chunks_keeps_them_packed) {
+    const chunk_storage_config config{cubic_extent(8), voxel_layout::palette};
+    chunk_storage center{config};
+    chunk_storage neighbor{config};
+    center.set_voxel(2, 3, 4, voxel_id{1});
+    center.set_voxel(7, 0, 0, voxel_id{2});
+    neighbor.set_voxel(0, 0, 0, voxel_id{1});
+    meshing::chunk_neighborhood neighborhood{};
+    neighborhood.set(1, 0, 0, &neighbor);
+
+    CHECK_FALSE(meshing::greedy_mesh(center).vertices.empty());
+    CHECK_FALSE(meshing::naive_mesh_with_neighborhood(center, neighborhood).vertices.empty());
+    CHECK_FALSE(meshing::binary_greedy_mesh_with_neighborhood(center, neighborhood).vertices.empty());
+    CHECK_FALSE(meshing::marching_cubes_from_chunk(center).vertices.empty());
+    CHECK(center.layout() == voxel_layout::palette);
+    CHECK(neighbor.layout() == voxel_layout::palette);
+    CHECK(center.memory_usage().bytes(chunk_plane::voxels) == center.palette()->memory_usage());
+}
+
+TEST_CASE(apron_remaps_neighbors_of_a_different_extent) {
+    chunk_storage center{cubic_extent(4)};
+    chunk_storage small{cubic_extent(2)};
+    chunk_storage large{chunk_extent{6, 4, 5}};
+    small.set_voxel(0, 1, 1, voxel_id{4});
+    small.set_voxel(1, 0, 1, voxel_id{6});
+    large.set_voxel(5, 2, 3, voxel_id{8});
+
+    meshing::chunk_neighborhood neighborhood{};
+    neighborhood.set(1, 0, 0, &small);
+    neighborhood.set(-1, 0, 0, &large);
+    neighborhood.set(0, 0, -1, &small);
+
+    meshing::padded_grid<voxel_id> apron;
+    meshing::build_voxel_apron(center, neighborhood, apron, voxel_id{3});
+    CHECK(apron(4, 1, 1) == voxel_id{4});
+    CHECK(apron(4, 0, 0) == voxel_id{0});
+    CHECK(apron(4, 2, 1) == voxel_id{3});
+    CHECK(apron(4, 1, 3) == voxel_id{3});
+    CHECK(apron(-1, 2, 3) == voxel_id{8});
+    CHECK(apron(-1, 0, 0) == voxel_id{0});
+    CHECK(apron(1, 0, -1) == voxel_id{6});
+    CHECK(apron(2, 0, -1) == voxel_id{3});
+
+    meshing::padded_grid<voxel_id> wide;
+    meshing::build_voxel_apron(center, neighborhood, wide, std::identity{}, voxel_id{3}, 3);
+    CHECK(wide(-1, 2, 3) == voxel_id{8});
+    CHECK(wide(-3, 1, 3) == voxel_id{0});
+    CHECK(wide(4, 1, 1) == voxel_id{4});
+    CHECK(wide(5, 0, 1) == voxel_id{6});
+    CHECK(wide(6, 0, 0) == voxel_id{3});
+    CHECK(wide(1, 0, -1) == voxel_id{6});
+    CHECK(wide(1, 0, -2) == voxel_id{0});
+    CHECK(wide(1, 0, -3) == voxel_id{3});
+}
+
+TEST_CASE(marching_cubes_closes_seams_along_chunk_edges) {
+    const auto extent = cubic_extent(4);
+    chunk_storage empty{extent};
+    chunk_storage solid{extent};
+    solid.fill(voxel_id{1});
+
+    meshing::chunk_neighborhood neighborhood{};
+    neighborhood.set(1, 1, 0, &solid);
+    const auto is_solid = [](voxel_id id) { return id != voxel_id{}; };
+
+    // Only the diagonal neighbour is solid, so face neighbours alone see nothing to mesh.
+    const auto faces_only = meshing::marching_cubes_from_chunk(empty, is_solid, meshing::chunk_neighbors{});
+    CHECK(faces_only.vertices.empty());
+
+    const auto mesh = meshing::marching_cubes_from_chunk(empty, is_solid, neighborhood);
+    CHECK_FALSE(mesh.vertices.empty());
+    CHECK(std::all_of(mesh.vertices.begin(), mesh.vertices.end(), [](const meshing::vertex& v) {
+        return v.position[0] >= 3.0f && v.position[1] >= 3.0f;
+    }));
+
+    meshing::mesher_context context;
+    CHECK(context.marching_cubes(empty, neighborhood).vertices.size() == mesh.vertices.size());
+}
+
+TEST_CASE(marching_cubes_seam_vertices_share_normals) {
+    const auto extent = cubic_extent(8);
+    chunk_storage left{extent};
+    chunk_storage right{extent};
+    // A slanted, bumpy floor running across the seam at x = 8.
+    const auto populate = [&](chunk_storage& chunk, std::uint32_t origin_x) {
+        auto voxels = chunk.voxels();
+        for (std::uint32_t z = 0; z < extent.z; ++z) {
+            for (std::uint32_t y = 0; y < extent.y; ++y) {
+                for (std::uint32_t x = 0; x < extent.x; ++x) {
+                    const auto wx = origin_x + x;
+                    const auto height = 2 + (wx + z) / 3 + (wx * z) % 3;
+                    voxels(x, y, z) = y < height ? voxel_id{1} : voxel_id{};
+                }
+            }
+        }
+    };
+    populate(left, 0);
+    populate(right, 8);
+    const auto is_solid = [](voxel_id id) { return id != voxel_id{}; };
+
+    meshing::chunk_neighborhood left_neighbors{};
+    left_neighbors.set(1, 0, 0, &right);
+    meshing::chunk_neighborhood right_neighbors{};
+    right_neighbors.set(-1, 0, 0, &left);
+    const auto check_seam = [&](const meshing::mesh_result& a, const meshing::mesh_result& b) {
+        std::size_t shared = 0;
+        for (const auto& va : a.vertices) {
+            if (va.position[0] != 8.0f) {
+                continue;
+            }
+            for (const auto& vb : b.vertices) {
+                if (vb.position[0] == 0.0f && vb.position[1] == va.position[1] && vb.position[2] == va.position[2]) {
+                    ++shared;
+                    CHECK(vb.normal == va.normal);
+                }
+            }
+        }
+        CHECK(shared > 0);
+    };
+
+    check_seam(meshing::marching_cubes_from_chunk(left, is_solid, left_neighbors),
+        meshing::marching_cubes_from_chunk(right, is_solid, right_neighbors));
+
+    meshing::marching_cubes_lod lod{1, {}};
+    check_seam(meshing::marching_cubes_from_chunk(left, is_solid, left_neighbors, lod),
+        meshing::marching_cubes_from_chunk(right, is_solid, right_neighbors, lod));
+}
+
+TEST_CASE(meshing_touched_neighbor_faces) {
+    const auto extent = cubic_extent(8);
+    const auto interior = meshing::touched_neighbor_faces(voxel_bounds::cell(3, 4, 5), extent);
+    CHECK(std::none_of(interior.begin(), interior.end(), [](bool touched) { return touched; }));
+
+    const auto corner = meshing::touched_neighbor_faces(voxel_bounds::cell(7, 0, 3), extent);
+    CHECK(corner[static_cast<std::size_t>(block_face::pos_x)]);
+    CHECK(corner[static_cast<std::size_t>(block_face::neg_y)]);
+    CHECK_FALSE(corner[static_cast<std::size_t>(block_face::neg_x)]);
+    CHECK_FALSE(corner[static_cast<std::size_t>(block_face::pos_z)]);
+}
+
+TEST_CASE(binary_greedy_mesher_matches_greedy_faces) {
+    const chunk_extent extent{13, 64, 9};
+    const auto populate = [&](chunk_storage& chunk, std::uint32_t salt) {
+        auto voxels = chunk.voxels();
+        for (std::uint32_t z = 0; z < extent.z; ++z) {
+            for (std::uint32_t y = 0; y < extent.y; ++y) {
+                for (std::uint32_t x = 0; x < extent.x; ++x) {
+                    const bool solid = (x * 7 + y * 3 + z * 5 + salt) % 11 < 6 || z < 2;
+                    voxels(x, y, z) = solid ? static_cast<voxel_id>(1 + (x / 4 + y / 9 + salt) % 3) : voxel_id{};
+                }
+            }
+        }
+    };
+    chunk_storage chunk{extent};
+    chunk_storage pos_x{extent};
+    chunk_storage neg_y{extent};
+    chunk_storage pos_z{extent};
+    populate(chunk, 0);
+    populate(pos_x, 3);
+    populate(neg_y, 5);
+    pos_z.fill(voxel_id{2});
+
+    meshing::chunk_neighbors neighbors{};
+    neighbors.pos_x = &pos_x;
+    neighbors.neg_y = &neg_y;
+    neighbors.pos_z = &pos_z;
+
+    const auto greedy = meshing::greedy_mesh_with_neighbor_chunks(chunk, neighbors);
+    const auto binary = meshing::binary_greedy_mesh_with_neighbor_chunks(chunk, neighbors);
+    REQUIRE(binary.indices.size() * 4 == binary.vertices.size() * 6);
+    CHECK(unit_faces(binary) == unit_faces(greedy));
+
+    // is_opaque runs once per centre voxel plus once per apron cell of the non-uniform neighbours (the uniform pos_z
+    // neighbour converts once); the centre is never converted twice.
+    std::size_t opacity_calls = 0;
+    const auto counted = meshing::binary_greedy_mesh_with_neighbor_chunks(chunk, neighbors, [&](voxel_id id) {
+        ++opacity_calls;
+        return id != voxel_id{};
+    });
+    CHECK(unit_faces(counted) == unit_faces(binary));
+    CHECK(opacity_calls == extent.volume() + extent.y * extent.z + extent.x * extent.z + 1);
+
+    // Same winding convention: every triangle faces along its vertex normal.
+    for (std::size_t i = 0; i < binary.indices.size(); i += 3) {
+        const auto& p0 = binary.vertices[binary.indices[i]].position;
+        const auto& p1 = binary.vertices[binary.indices[i + 1]].position;
+        const auto& p2 = binary.vertices[binary.indices[i + 2]].position;
+        const std::array<float, 3> e1{p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        const std::array<float, 3> e2{p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        const std::array<float, 3> cross{e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2],
+            e1[0] * e2[1] - e1[1] * e2[0]};
+        const auto& normal = binary.vertices[binary.indices[i]].normal;
+        CHECK(cross[0] * normal[0] + cross[1] * normal[1] + cross[2] * normal[2] > 0.0f);
+    }
+
+    chunk_storage solid{cubic_extent(64)};
+    solid.fill(voxel_id{4});
+    const auto cube = meshing::binary_greedy_mesh(solid);
+    CHECK(cube.vertices.size() == 24);
+    CHECK(unit_faces(cube) == unit_faces(meshing::greedy_mesh(solid)));
+
+    // Wider chunks take the cell-wise path.
+    chunk_storage wide{chunk_extent{70, 2, 2}};
+    wide.set_voxel(69, 1, 0, voxel_id{1});
+    CHECK(meshing::binary_greedy_mesh(wide).vertices.size() == 24);
+}
+
+TEST_CASE(packed_mesh_formats_match_float_meshes) {
+    const chunk_extent extent{16, 16, 16};
+    chunk_storage chunk{extent};
+    auto voxels = chunk.voxels();
+    for (std::uint32_t z = 0; z < extent.z; ++z) {
+        for (std::uint32_t y = 0; y < extent.y; ++y) {
+            for (std::uint32_t x = 0; x < extent.x; ++x) {
+                if ((x * 5 + y * 3 + z * 7) % 9 < 4 || y < 3) {
+                    voxels(x, y, z) = static_cast<voxel_id>(1 + (x + z) % 3);
+                }
+            }
+        }
+    }
+    chunk_storage pos_y{extent};
+    pos_y.fill(voxel_id{1});
+    meshing::chunk_neighbors neighbors{};
+    neighbors.pos_y = &pos_y;
+    const auto opaque = [](voxel_id id) { return id != voxel_id{}; };
+
+    meshing::packed_mesh greedy;
+    meshing::greedy_quads_with_neighbor_chunks(chunk, neighbors, opaque, meshing::packed_mesh_sink{greedy});
+    meshing::packed_mesh binary;
+    meshing::binary_greedy_quads_with_neighbor_chunks(chunk, neighbors, opaque, meshing::packed_mesh_sink{binary});
+    meshing::packed_mesh naive;
+    meshing::naive_quads_with_neighbor_chunks(chunk, neighbors, opaque, meshing::packed_mesh_sink{naive});
+
+    const auto reference = unit_faces(meshing::greedy_mesh_with_neighbor_chunks(chunk, neighbors));
+    REQUIRE(!reference.empty());
+    CHECK(unit_faces(unpack_mesh(greedy)) == reference);
+    CHECK(unit_faces(unpack_mesh(binary)) == reference);
+    CHECK(unit_faces(unpack_mesh(naive)) == reference);
+    CHECK(greedy.indices.size() * 4 == greedy.vertices.size() * 6);
+    for (const auto& vertex : greedy.vertices) {
+        CHECK((vertex.position_face >> 24u) == 0);
+    }
+
+    // The instance stream carries the same rectangles as the indexed packed mesh.
+    std::vector<meshing::packed_quad> stream;
+    meshing::greedy_quads_with_neighbor_chunks(chunk, neighbors, opaque, meshing::packed_quad_sink{stream});
+    REQUIRE(stream.size() * 4 == greedy.vertices.size());
+    for (std::size_t i = 0; i < stream.size(); ++i) {
+        const auto& instance = stream[i];
+        meshing::quad expanded{instance.face(), {instance.x(), instance.y(), instance.z()}, instance.width(),
+            instance.height(), instance.id()};
+        const auto corners = meshing::pack_quad_vertices(expanded);
+        for (std::size_t corner = 0; corner < 4; ++corner) {
+            CHECK(corners[corner].position_face == greedy.vertices[i * 4 + corner].position_face);
+            CHECK(corners[corner].uv_id == greedy.vertices[i * 4 + corner].uv_id);
+        }
+    }
+
+    bool rejected = false;
+    try {
+        static_cast<void>(meshing::pack_quad(meshing::quad{block_face::pos_x, {64, 0, 0}, 1, 1, voxel_id{1}}));
+    } catch (const std::out_of_range&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+
+    // Smooth surfaces quantize to 1/256 voxel and an octahedral normal.
+    meshing::packed_smooth_mesh smooth;
+    chunk_storage ball{cubic_extent(8)};
+    ball.set_voxel(3, 3, 3, voxel_id{5});
+    ball.set_voxel(4, 3, 3, voxel_id{5});
+    meshing::marching_cubes_indexed_from_chunk(ball, opaque, meshing::chunk_neighborhood{}, {},
+        meshing::packed_smooth_sink{smooth});
+    const auto reference_smooth = meshing::marching_cubes_from_chunk(ball);
+    REQUIRE(smooth.vertices.size() == reference_smooth.vertices.size());
+    CHECK(smooth.indices == reference_smooth.indices);
+    for (std::size_t i = 0; i < smooth.vertices.size(); ++i) {
+        const auto position = smooth.vertices[i].unpack_position();
+        const auto normal = smooth.vertices[i].unpack_normal();
+        const auto& expected = reference_smooth.vertices[i];
+        float dot = 0.0f;
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            CHECK(std::abs(position[axis] - expected.position[axis]) <= 0.5f / meshing::smooth_position_scale);
+            dot += normal[axis] * expected.normal[axis];
+        }
+        CHECK(dot > 0.99f);
+        CHECK(smooth.vertices[i].id == expected.id);
+    }
+
+    for (const float coordinate : {-1.0f, 256.0f}) {
+        bool out_of_range = false;
+        try {
+            static_cast<void>(meshing::pack_smooth_vertex(meshing::vertex{{1.0f, coordinate, 1.0f}, {0.0f, 1.0f, 0.0f},
+                {}, voxel_id{1}}));
+        } catch (const std::out_of_range&) {
+            out_of_range = true;
+        }
+        CHECK(out_of_range);
+    }
+}
+
+TEST_CASE(blocky_meshers_bake_vertex_lighting) {
+    const auto extent = cubic_extent(4);
+    chunk_storage chunk{extent};
+    chunk.set_voxel(1, 0, 1, voxel_id{1});
+    chunk.set_voxel(2, 1, 1, voxel_id{1});
+    auto sky = chunk.skylight();
+    for (std::uint32_t z = 0; z < extent.z; ++z) {
+        for (std::uint32_t y = 0; y < extent.y; ++y) {
+            for (std::uint32_t x = 0; x < extent.x; ++x) {
+                sky(x, y, z) = 15;
+            }
+        }
+    }
+    sky(1, 1, 0) = 0;
+
+    const auto opaque = [](voxel_id id) { return id != voxel_id{}; };
+    const auto top_face = [&](const meshing::mesh_lighting_config& lighting) {
+        std::vector<meshing::quad> quads;
+        meshing::mesher_scratch scratch;
+        meshing::naive_quads_with_neighborhood(chunk, meshing::chunk_neighborhood{}, opaque, lighting,
+            [&quads](const meshing::quad& q) { quads.push_back(q); }, scratch);
+        const auto it = std::find_if(quads.begin(), quads.end(), [](const meshing::quad& q) {
+            return q.face == block_face::pos_y && q.origin == std::array<std::uint32_t, 3>{1, 0, 1};
+        });
+        CHECK(it != quads.end());
+        return it->shade;
+    };
+
+    // Corners run (z, x) = (1, 1), (2, 1), (2, 2), (1, 2); the wall at x = 2 occludes the last two.
+    const auto lit = top_face(meshing::mesh_lighting_config{true, true});
+    CHECK(lit[0].occlusion == 0);
+    CHECK(lit[1].occlusion == 0);
+    CHECK(lit[2].occlusion == 1);
+    CHECK(lit[3].occlusion == 1);
+    CHECK(lit[0].skylight == 180);
+    CHECK(lit[1].skylight == 240);
+    CHECK(lit[2].skylight == 240);
+    CHECK(lit[3].skylight == 160);
+    CHECK(lit[0].blocklight == 0);
+    for (const auto& shade : top_face(meshing::mesh_lighting_config{})) {
+        CHECK(shade == meshing::vertex_shade{});
+    }
+
+    const auto packed = meshing::pack_quad(meshing::quad{block_face::pos_y, {1, 0, 1}, 1, 1, voxel_id{1}, lit});
+    const auto vertices = meshing::pack_quad_vertices(meshing::quad{block_face::pos_y, {1, 0, 1}, 1, 1, voxel_id{1},
+        lit});
+    for (std::size_t i = 0; i < lit.size(); ++i) {
+        CHECK(packed.occlusion(i) == lit[i].occlusion);
+        CHECK(vertices[i].occlusion() == lit[i].occlusion);
+    }
+
+    // Occlusion sampled across a chunk corner only reaches the face when the diagonal neighbour is supplied.
+    chunk_storage corner_chunk{extent};
+    chunk_storage diagonal{extent};
+    corner_chunk.set_voxel(3, 0, 3, voxel_id{1});
+    diagonal.set_voxel(0, 1, 0, voxel_id{1});
+    meshing::chunk_neighborhood neighborhood{};
+    neighborhood.set(1, 0, 1, &diagonal);
+    meshing::mesher_context context;
+    const meshing::mesh_lighting_config occlusion_only{true, false};
+    const auto corner_occlusion = [&](const meshing::mesh_result& mesh) {
+        int occlusion = -1;
+        for (const auto& v : mesh.vertices) {
+            if (v.normal[1] > 0.5f && v.position[0] == 4.0f && v.position[2] == 4.0f) {
+                occlusion = v.shade.occlusion;
+            }
+        }
+        return occlusion;
+    };
+    CHECK(corner_occlusion(context.greedy(corner_chunk, neighborhood, occlusion_only)) == 1);
+    CHECK(corner_occlusion(context.naive(corner_chunk, neighborhood, occlusion_only)) == 1);
+    CHECK(corner_occlusion(context.binary_greedy(corner_chunk, neighborhood, occlusion_only)) == 1);
+    CHECK(corner_occlusion(context.greedy(corner_chunk, meshing::chunk_neighborhood{}, occlusion_only)) == 0);
+}
+
+TEST_CASE(greedy_mesher_splits_quads_with_different_shading) {
+    const auto extent = cubic_extent(4);
+    chunk_storage chunk{extent};
+    for (std::uint32_t z = 0; z < extent.z; ++z) {
+        for (std::uint32_t x = 0; x < extent.x; ++x) {
+            chunk.set_voxel(x, 0, z, voxel_id{1});
+        }
+    }
+    chunk.set_voxel(3, 1, 3, voxel_id{1});
+
+    const auto top_quads = [&](const meshing::mesh_lighting_config& lighting) {
+        std::vector<meshing::quad> quads;
+        meshing::mesher_scratch scratch;
+        meshing::greedy_quads_with_neighborhood(chunk, meshing::chunk_neighborhood{},
+            [](voxel_id id) { return id != voxel_id{}; }, lighting,
+            [&quads](const meshing::quad& q) {
+                if (q.face == block_face::pos_y && q.origin[1] == 0) {
+                    quads.push_back(q);
+                }
+            },
+            scratch);
+        return quads;
+    };
+    const auto area = [](const std::vector<meshing::quad>& quads) {
+        std::uint32_t total = 0;
+        for (const auto& q : quads) {
+            total += q.width * q.height;
+        }
+        return total;
+    };
+
+    const auto flat = top_quads(meshing::mesh_lighting_config{});
+    const auto shaded = top_quads(meshing::mesh_lighting_config{true, false});
+    CHECK(area(flat) == 15);
+    CHECK(area(shaded) == 15);
+    CHECK(shaded.size() > flat.size());
+    for (const auto& q : shaded) {
+        const bool touches_bump = q.origin[0] + q.height >= 3 && q.origin[2] + q.width >= 3;
+        if (!touches_bump) {
+            for (const auto& shade : q.shade) {
+                CHECK(shade.occlusion == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE(mesher_context_reuses_buffers) {
+    const chunk_extent extent{32, 32, 32};
+    const auto populate = [&](chunk_storage& chunk, std::uint32_t salt) {
+        auto voxels = chunk.voxels();
+        for (std::uint32_t z = 0; z < extent.z; ++z) {
+            for (std::uint32_t y = 0; y < extent.y; ++y) {
+                for (std::uint32_t x = 0; x < extent.x; ++x) {
+                    if ((x * 3 + y * 7 + z * 5 + salt) % 13 < 5) {
+                        voxels(x, y, z) = static_cast<voxel_id>(1 + (x / 8 + salt) % 2);
+                    }
+                }
+            }
+        }
+    };
+    chunk_storage first{extent};
+    chunk_storage second{extent};
+    populate(first, 0);
+    populate(second, 4);
+    meshing::chunk_neighbors neighbors{};
+    neighbors.neg_x = &second;
+
+    meshing::mesher_context context;
+    CHECK(unit_faces(context.greedy(first, neighbors)) == unit_faces(meshing::greedy_mesh_with_neighbor_chunks(first, neighbors)));
+    CHECK(unit_faces(context.binary_greedy(second)) == unit_faces(meshing::binary_greedy_mesh(second)));
+    CHECK(context.naive(first).vertices.size() == meshing::naive_mesh(first).vertices.size());
+    CHECK(context.marching_cubes(second).indices == meshing::marching_cubes_from_chunk(second).indices);
+
+    // Once every mesher has run on the busiest chunk, later calls reuse the same storage.
+    const auto* vertices = context.mesh().vertices.data();
+    const auto* indices = context.mesh().indices.data();
+    const auto* mask = context.scratch().mask.data();
+    const auto* rows = context.scratch().rows.data();
+    for (int pass = 0; pass < 3; ++pass) {
+        for (const auto* chunk : {&first, &second}) {
+            static_cast<void>(context.greedy(*chunk, neighbors));
+            static_cast<void>(context.binary_greedy(*chunk, neighbors));
+            static_cast<void>(context.naive(*chunk));
+            static_cast<void>(context.marching_cubes(*chunk));
+        }
+    }
+    CHECK(context.mesh().vertices.data() == vertices);
+    CHECK(context.mesh().indices.data() == indices);
+    CHECK(context.scratch().mask.data() == mask);
+    CHECK(context.scratch().rows.data() == rows);
+    CHECK(context.marching_cubes(second).vertices.size() == meshing::marching_cubes_from_chunk(second).vertices.size());
+}
+
+TEST_CASE(span_mesh_sinks_write_caller_buffers) {
+    chunk_storage chunk{cubic_extent(8)};
+    chunk.set_voxel(1, 1, 1, voxel_id{3});
+    chunk.set_voxel(2, 1, 1, voxel_id{3});
+    chunk.set_voxel(5, 5, 5, voxel_id{4});
+    const auto opaque = [](voxel_id id) { return id != voxel_id{}; };
+    meshing::mesher_scratch scratch;
+    const auto expected = meshing::greedy_mesh(chunk);
+
+    std::vector<meshing::vertex> vertices(expected.vertices.size());
+    std::vector<std::uint32_t> indices(expected.indices.size());
+    meshing::span_mesh_sink sink{vertices, indices};
+    meshing::greedy_quads_with_neighbor_chunks(chunk, {}, opaque, sink, scratch);
+    REQUIRE(sink.result().complete());
+    CHECK(sink.result().vertex_count == expected.vertices.size());
+    CHECK(indices == expected.indices);
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        CHECK(vertices[i].position == expected.vertices[i].position);
+        CHECK(vertices[i].id == expected.vertices[i].id);
+    }
+
+    // Short spans keep a whole-primitive prefix and report the size needed.
+    std::vector<meshing::packed_vertex> packed(10);
+    std::vector<std::uint32_t> packed_indices(64);
+    meshing::packed_span_sink short_sink{packed, packed_indices};
+    meshing::binary_greedy_quads_with_neighbor_chunks(chunk, {}, opaque, short_sink, scratch);
+    const auto& partial = short_sink.result();
+    CHECK_FALSE(partial.complete());
+    CHECK(partial.vertex_count == 8);
+    CHECK(partial.index_count == 12);
+    CHECK(partial.required_vertices == expected.vertices.size());
+    CHECK(partial.required_indices == expected.indices.size());
+
+    const auto smooth = meshing::marching_cubes_from_chunk(chunk);
+    std::vector<meshing::vertex> triangles(smooth.indices.size());
+    std::vector<std::uint32_t> triangle_indices(smooth.indices.size());
+    meshing::span_mesh_sink triangle_sink{triangles, triangle_indices};
+    meshing::marching_cubes_triangles_from_chunk(chunk, opaque, meshing::chunk_neighbors{}, {}, triangle_sink);
+    CHECK(triangle_sink.result().complete());
+    CHECK(triangle_sink.result().vertex_count == triangles.size());
+
+    std::vector<meshing::vertex> shared(smooth.vertices.size());
+    std::vector<std::uint32_t> shared_indices(smooth.indices.size());
+    meshing::span_mesh_sink indexed_sink{shared, shared_indices};
+    meshing::marching_cubes_indexed_from_chunk(chunk, opaque, meshing::chunk_neighborhood{}, {}, indexed_sink);
+    CHECK(indexed_sink.result().complete());
+    CHECK(shared_indices == smooth.indices);
+}
+
+TEST_CASE(batch_mesher_meshes_regions_with_neighbors) {
+    region_manager regions{cubic_extent(16)};
+    regions.set_loader([](const region_key& key) {
+        chunk_storage chunk{cubic_extent(16)};
+        auto voxels = chunk.voxels();
+        for (std::uint32_t z = 0; z < 16; ++z) {
+            for (std::uint32_t y = 0; y < 16; ++y) {
+                for (std::uint32_t x = 0; x < 16; ++x) {
+                    const auto salt = static_cast<std::uint32_t>(key.x * 5 + key.y * 3 + key.z * 7 + 64);
+                    if ((x * 3 + y * 5 + z + salt) % 7 < 3) {
+                        voxels(x, y, z) = static_cast<voxel_id>(1 + salt % 3);
+                    }
+                }
+            }
+        }
+        return chunk;
+    });
+    std::vector<region_key> keys;
+    for (std::int32_t z = 0; z < 2; ++z) {
+        for (std::int32_t y = -1; y <= 1; ++y) {
+            for (std::int32_t x = -1; x <= 1; ++x) {
+                keys.push_back({x, y, z});
+                static_cast<void>(regions.assure(keys.back()));
+            }
+        }
+    }
+    const auto expected_faces = [&](const region_key& key) {
+        const auto at = [&](int dx, int dy, int dz) {
+            return regions.find(region_key{key.x + dx, key.y + dy, key.z + dz}).get();
+        };
+        meshing::chunk_neighbors neighbors{};
+        neighbors.pos_x = at(1, 0, 0);
+        neighbors.neg_x = at(-1, 0, 0);
+        neighbors.pos_y = at(0, 1, 0);
+        neighbors.neg_y = at(0, -1, 0);
+        neighbors.pos_z = at(0, 0, 1);
+        neighbors.neg_z = at(0, 0, -1);
+        return unit_faces(meshing::greedy_mesh_with_neighbor_chunks(*regions.find(key), neighbors));
+    };
+
+    {
+        meshing::batch_mesh_config config{};
+        config.worker_count = 3;
+        meshing::batch_mesher mesher{regions, config};
+        mesher.submit(keys, region_key{0, 0, 0});
+        mesher.submit(region_key{40, 0, 0});
+        mesher.wait_idle();
+        CHECK(mesher.pending() == 0);
+
+        std::size_t meshed = 0;
+        bool matches = true;
+        bool missing_reported = false;
+        mesher.drain([&](meshing::batch_mesh_result&& result) {
+            if (result.status == meshing::batch_mesh_status::missing) {
+                missing_reported = result.key == region_key{40, 0, 0};
+                return;
+            }
+            ++meshed;
+            matches = matches && unit_faces(result.mesh) == expected_faces(result.key);
+        });
+        CHECK(meshed == keys.size());
+        CHECK(matches);
+        CHECK(missing_reported);
+    }
+
+    // One worker blocked on the nearest chunk: the rest follow by distance, a cancelled key never reports, and a key
+    // resubmitted mid-run is meshed again once that run finishes.
+    meshing::batch_mesh_config config{};
+    config.worker_count = 1;
+    meshing::batch_mesher mesher{regions, config};
+    const region_key viewer{1, 1, 1};
+    std::vector<region_key> results;
+    {
+        const auto nearest = regions.find(viewer);
+        const auto guard = nearest->lock_exclusive();
+        mesher.submit(keys, viewer);
+        while (mesher.in_flight() == 0) {
+            std::this_thread::yield();
+        }
+        CHECK(mesher.cancel(region_key{-1, -1, 0}));
+        CHECK_FALSE(mesher.cancel(region_key{40, 0, 0}));
+        mesher.submit(viewer, 100);
+    }
+    mesher.wait_idle();
+    meshing::batch_mesh_result result;
+    while (mesher.try_pop(result)) {
+        results.push_back(result.key);
+    }
+    REQUIRE(results.size() == keys.size());
+    CHECK(results[0] == viewer);
+    CHECK(results[1] == viewer);
+    for (std::size_t i = 2; i < results.size(); ++i) {
+        CHECK(meshing::batch_mesher::distance_priority(results[i], viewer)
+            <= meshing::batch_mesher::distance_priority(results[i - 1], viewer));
+        CHECK_FALSE(results[i] == (region_key{-1, -1, 0}));
+    }
+}
+
+TEST_CASE(batch_mesher_reports_failed_jobs) {
+    region_manager regions{cubic_extent(8)};
+    auto& broken = regions.assure(region_key{0, 0, 0});
+    broken.set_voxel(1, 1, 1, voxel_id{1});
+    broken.set_compression_hooks([](const chunk_storage::const_planes_view&) { return std::vector<std::byte>(4); },
+        [](const chunk_storage::planes_view&, std::span<const std::byte>) {
+            throw std::runtime_error("corrupt blob");
+        });
+    broken.request_compression();
+    REQUIRE(broken.flush_compression());
+    regions.assure(region_key{5, 0, 0}).set_voxel(2, 2, 2, voxel_id{1});
+
+    meshing::batch_mesh_config config{};
+    config.worker_count = 2;
+    meshing::batch_mesher mesher{regions, config};
+    mesher.submit(region_key{0, 0, 0});
+    mesher.submit(region_key{5, 0, 0});
+    mesher.wait_idle();
+    CHECK(mesher.pending() == 0);
+
+    std::size_t failed = 0;
+    std::size_t meshed = 0;
+    mesher.drain([&](meshing::batch_mesh_result&& result) {
+        if (result.status == meshing::batch_mesh_status::failed) {
+            ++failed;
+            CHECK(result.key == (region_key{0, 0, 0}));
+            CHECK(result.error != nullptr);
+            CHECK(result.mesh.indices.empty());
+        } else if (result.status == meshing::batch_mesh_status::meshed) {
+            ++meshed;
+            CHECK_FALSE(result.mesh.indices.empty());
+        }
+    });
+    CHECK(failed == 1);
+    CHECK(meshed == 1);
+}
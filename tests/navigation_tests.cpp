@@ -116,3 +116,40 @@ TEST_CASE(navigation_stitched_graph_links_neighbors) {
     CHECK(has_forward);
     CHECK(has_reverse);
 }
+
+TEST_CASE(navigation_grid_uniform_chunks) {
+    chunk_storage air{cubic_extent(4)};
+    const auto open = navigation::build_nav_grid(air);
+    CHECK(open.walkable(open.index(2, 0, 3)));
+    CHECK_FALSE(open.walkable(open.index(2, 1, 3)));
+
+    chunk_storage solid{cubic_extent(4)};
+    solid.fill(voxel_id{1});
+    const auto closed = navigation::build_nav_grid(solid);
+    CHECK(std::none_of(closed.cells.begin(), closed.cells.end(), [](const auto& cell) { return cell.walkable; }));
+    CHECK(solid.uniform());
+}
+
+TEST_CASE(navigation_incremental_update_matches_full_build) {
+    chunk_storage chunk{cubic_extent(8)};
+    for (std::uint32_t x = 0; x < 8; ++x) {
+        for (std::uint32_t z = 0; z < 8; ++z) {
+            chunk.set_voxel(x, 0, z, voxel_id{1});
+        }
+    }
+    navigation::nav_build_config config;
+    config.clearance = 2;
+    auto grid = navigation::build_nav_grid(chunk, config);
+
+    const std::array<std::array<std::uint32_t, 3>, 4> edits{{{3, 2, 3}, {3, 1, 4}, {0, 0, 0}, {7, 7, 7}}};
+    for (const auto& edit : edits) {
+        chunk.clear_dirty_bounds();
+        chunk.set_voxel(edit[0], edit[1], edit[2], voxel_id{2});
+        navigation::update_nav_grid(grid, chunk, chunk.dirty_bounds(), config);
+        const auto reference = navigation::build_nav_grid(chunk, config);
+        REQUIRE(grid.cells.size() == reference.cells.size());
+        for (std::size_t i = 0; i < grid.cells.size(); ++i) {
+            CHECK(grid.cells[i].walkable == reference.cells[i].walkable);
+        }
+    }
+}
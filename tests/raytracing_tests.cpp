@@ -3,7 +3,11 @@
 #include "almond_voxel/raytracing/structures.hpp"
 #include "test_framework.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 using namespace almond::voxel;
 using namespace almond::voxel::raytracing;
@@ -73,3 +77,55 @@ TEST_CASE(raytracing_lighting_updates_on_dirty) {
     CHECK(refreshed->svo.root().bounds.max_material == voxel_id{3});
 }
 
+
+TEST_CASE(raytracing_incremental_update_matches_full_build) {
+    chunk_storage chunk{cubic_extent(8)};
+    chunk.set_voxel(1, 1, 1, voxel_id{4});
+    acceleration_cache cache;
+    const region_key key{0, 0, 0};
+    cache.update_region(key, chunk);
+
+    chunk.clear_dirty_bounds();
+    chunk.set_voxel(6, 5, 6, voxel_id{9});
+    chunk.set_voxel(1, 1, 1, voxel_id{3});
+    cache.invalidate_region(key, chunk.dirty_bounds());
+    REQUIRE(cache.find(key)->dirty);
+    cache.update_region(key, chunk);
+
+    sparse_voxel_octree reference;
+    reference.build(chunk);
+    const auto& updated = cache.find(key)->svo;
+    CHECK(updated.root().bounds.min_material == reference.root().bounds.min_material);
+    CHECK(updated.root().bounds.max_material == reference.root().bounds.max_material);
+
+    const auto occupied_leaves = [](const sparse_voxel_octree& tree) {
+        std::vector<std::array<std::int32_t, 4>> leaves;
+        for (const auto& node : tree.nodes()) {
+            if (node.leaf && node.bounds.occupied) {
+                leaves.push_back({node.origin[0], node.origin[1], node.origin[2], static_cast<std::int32_t>(node.size)});
+            }
+        }
+        std::sort(leaves.begin(), leaves.end());
+        return leaves;
+    };
+    CHECK(occupied_leaves(updated) == occupied_leaves(reference));
+
+    clipmap_grid clipmap_reference;
+    clipmap_reference.build(chunk);
+    const auto& clipmap = cache.find(key)->clipmap;
+    REQUIRE(clipmap.levels().size() == clipmap_reference.levels().size());
+    for (std::size_t level = 0; level < clipmap.levels().size(); ++level) {
+        const auto& cells = clipmap.levels()[level].cells;
+        const auto& expected = clipmap_reference.levels()[level].cells;
+        REQUIRE(cells.size() == expected.size());
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            CHECK(cells[i].occupied == expected[i].occupied);
+            CHECK(cells[i].max_material == expected[i].max_material);
+        }
+    }
+
+    const auto region = lighting_influence(voxel_bounds::cell(6, 5, 6), chunk.extent());
+    CHECK(region.contains(6, 0, 6));
+    CHECK(region.contains(5, 5, 7));
+    CHECK_FALSE(region.contains(1, 1, 1));
+}
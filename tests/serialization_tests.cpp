@@ -1,9 +1,18 @@
+#include "almond_voxel/serialization/chunk_delta.hpp"
+#include "almond_voxel/serialization/mapped_region.hpp"
+#include "almond_voxel/serialization/region_file.hpp"
 #include "almond_voxel/serialization/region_io.hpp"
 #include "test_framework.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <span>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
 using namespace almond::voxel;
@@ -153,3 +162,642 @@ TEST_CASE(chunk_legacy_payload_migration) {
     REQUIRE(std::equal(legacy_chunk.metadata().linear().begin(), legacy_chunk.metadata().linear().end(),
         restored.metadata().linear().begin(), restored.metadata().linear().end()));
 }
+
+TEST_CASE(chunk_serialization_palette_layout) {
+    chunk_storage_config config{};
+    config.extent = cubic_extent(4);
+    config.layout = voxel_layout::palette;
+    chunk_storage chunk{config};
+    chunk.set_voxel(0, 1, 2, voxel_id{4});
+    chunk.set_voxel(3, 3, 3, voxel_id{5});
+
+    const auto bytes = serialization::serialize_chunk(chunk);
+    CHECK(chunk.layout() == voxel_layout::palette);
+
+    const auto restored = serialization::deserialize_chunk(bytes);
+    CHECK(restored.voxel_at(0, 1, 2) == voxel_id{4});
+    CHECK(restored.voxel_at(3, 3, 3) == voxel_id{5});
+    CHECK(restored.voxel_at(1, 1, 1) == voxel_id{});
+}
+
+TEST_CASE(chunk_serialization_uniform_payload) {
+    chunk_storage_config config{};
+    config.extent = cubic_extent(16);
+    config.enable_materials = true;
+    config.effect_channels = channel::velocity;
+    chunk_storage chunk{config};
+    chunk_uniform_values values{};
+    values.voxel = voxel_id{9};
+    values.skylight = 12;
+    values.material = material_index{3};
+    values.effect_velocity = velocity_sample{1.0f, 2.0f, 3.0f};
+    chunk.fill(values);
+
+    const auto bytes = serialization::serialize_chunk(chunk);
+    CHECK(bytes.size() < 64);
+
+    serialization::chunk_header_v2 header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    CHECK(header.version == serialization::chunk_version_latest);
+    CHECK((header.channel_flags & serialization::chunk_channel_uniform) != 0);
+
+    const auto restored = serialization::deserialize_chunk(bytes);
+    const auto restored_values = restored.uniform_values();
+    REQUIRE(restored_values.has_value());
+    CHECK(restored_values->voxel == voxel_id{9});
+    CHECK(restored_values->skylight == 12);
+    CHECK(restored_values->material == material_index{3});
+    CHECK(restored_values->effect_velocity.y == 2.0f);
+    CHECK_FALSE(restored.dirty());
+}
+
+TEST_CASE(region_file_random_access_and_compaction) {
+    const auto directory = std::filesystem::temp_directory_path() / "almond_voxel_region_file_test";
+    std::filesystem::remove_all(directory);
+    const auto path = directory / "r.0.0.0.avr";
+    serialization::region_file_config config{};
+    config.region_size = 4;
+    config.sector_size = 512;
+
+    const auto make_payload = [](std::size_t size, std::uint8_t seed) {
+        std::vector<std::byte> payload(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            payload[i] = static_cast<std::byte>(seed + i);
+        }
+        return payload;
+    };
+
+    const region_key a{0, 0, 0};
+    const region_key b{1, 2, 3};
+    const region_key c{3, 3, 3};
+    {
+        serialization::region_file file{path, {0, 0, 0}, config};
+        file.write(a, make_payload(700, 1));
+        file.write(b, make_payload(100, 2));
+        file.write(c, make_payload(300, 3));
+        CHECK(file.chunk_count() == 3);
+        CHECK_FALSE(file.contains(region_key{2, 0, 0}));
+        bool rejected = false;
+        try {
+            file.write(region_key{4, 0, 0}, make_payload(8, 0));
+        } catch (const std::out_of_range&) {
+            rejected = true;
+        }
+        CHECK(rejected);
+
+        // Rewrites always relocate: growing b extends the file, shrinking a reuses b's old sector and frees its own.
+        const auto grown_size = file.file_size();
+        file.write(b, make_payload(1200, 4));
+        CHECK(file.file_size() > grown_size);
+        file.write(a, make_payload(200, 5));
+        CHECK(file.erase(c));
+        CHECK_FALSE(file.erase(c));
+    }
+
+    serialization::region_file file{path, {0, 0, 0}, config};
+    CHECK(file.chunk_count() == 2);
+    auto payload_a = file.read(a);
+    auto payload_b = file.read(b);
+    REQUIRE(payload_a);
+    REQUIRE(payload_b);
+    CHECK(*payload_a == make_payload(200, 5));
+    CHECK(*payload_b == make_payload(1200, 4));
+    CHECK_FALSE(file.read(c));
+
+    const auto before = file.file_size();
+    CHECK(file.compact() > 0);
+    CHECK(file.file_size() < before);
+    CHECK(std::filesystem::file_size(path) == file.file_size());
+    CHECK(file.used_sectors() == file.sector_count());
+    CHECK(*file.read(a) == make_payload(200, 5));
+    CHECK(*file.read(b) == make_payload(1200, 4));
+
+    bool mismatch = false;
+    try {
+        serialization::region_file other{path, {1, 0, 0}, config};
+    } catch (const std::runtime_error&) {
+        mismatch = true;
+    }
+    CHECK(mismatch);
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE(region_store_backs_region_manager) {
+    const auto directory = std::filesystem::temp_directory_path() / "almond_voxel_region_store_test";
+    std::filesystem::remove_all(directory);
+    serialization::region_file_config config{};
+    config.region_size = 2;
+    serialization::region_store store{directory, config};
+
+    const region_key near{1, 0, 0};
+    const region_key far{-3, 0, 5};
+    {
+        region_manager regions{cubic_extent(4)};
+        regions.set_saver(store.saver());
+        regions.assure(near).set_voxel(1, 1, 1, voxel_id{6});
+        regions.assure(far).fill(voxel_id{2});
+        CHECK(regions.unload(near));
+        CHECK(regions.unload(far));
+    }
+    CHECK(std::filesystem::exists(store.file_path(serialization::region_file::region_of(far, 2))));
+
+    region_manager regions{cubic_extent(4)};
+    regions.set_loader(store.loader(cubic_extent(4)));
+    CHECK(regions.assure(near).voxel_at(1, 1, 1) == voxel_id{6});
+    CHECK(regions.assure(far).uniform_voxel() == voxel_id{2});
+    CHECK(regions.assure(region_key{0, 0, 0}).uniform_voxel() == voxel_id{});
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE(region_store_serves_threads_across_regions) {
+    const auto directory = std::filesystem::temp_directory_path() / "almond_voxel_region_store_threads_test";
+    std::filesystem::remove_all(directory);
+    serialization::region_file_config config{};
+    config.region_size = 2;
+    serialization::region_store store{directory, config};
+
+    constexpr int thread_count = 4;
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 8; ++i) {
+                // Alternates between a region of its own and one shared by every thread.
+                const region_key key{i % 2 == 0 ? 4 * t : t % 2, i, 0};
+                chunk_storage chunk{cubic_extent(4)};
+                chunk.set_voxel(1, 2, 3, voxel_id{static_cast<std::uint16_t>(1 + t)});
+                store.save(key, chunk);
+                const auto loaded = store.load(key);
+                if (!loaded || loaded->voxel_at(1, 2, 3) != voxel_id{static_cast<std::uint16_t>(1 + t)}) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    store.flush();
+    CHECK(mismatches.load() == 0);
+    CHECK(store.load(region_key{4, 2, 0})->voxel_at(1, 2, 3) == voxel_id{2});
+    CHECK_FALSE(store.load(region_key{4, 1, 0}).has_value());
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE(chunk_stream_deserialization_reads_planes_directly) {
+    chunk_storage_config config{};
+    config.extent = cubic_extent(4);
+    config.enable_materials = true;
+    chunk_storage chunk{config};
+    chunk.set_voxel(1, 2, 3, voxel_id{9});
+    chunk.blocklight()(0, 1, 0) = 12;
+    chunk.materials()(3, 3, 3) = material_index{5};
+
+    std::stringstream stream;
+    serialization::serialize_chunk_to_stream(chunk, stream);
+    serialization::serialize_chunk_to_stream(chunk_storage{cubic_extent(4)}, stream);
+
+    const auto restored = serialization::deserialize_chunk_from_stream(stream);
+    CHECK(restored.voxel_at(1, 2, 3) == voxel_id{9});
+    CHECK(restored.blocklight()(0, 1, 0) == 12);
+    CHECK(restored.materials()(3, 3, 3) == material_index{5});
+    CHECK_FALSE(restored.dirty());
+    const auto uniform = serialization::deserialize_chunk_from_stream(stream);
+    CHECK(uniform.uniform_voxel() == voxel_id{});
+}
+
+TEST_CASE(mapped_region_views_alias_payloads) {
+    const auto directory = std::filesystem::temp_directory_path() / "almond_voxel_mapped_region_test";
+    std::filesystem::remove_all(directory);
+    const auto path = directory / "r.0.0.0.avr";
+    serialization::region_file_config config{};
+    config.region_size = 2;
+
+    const region_key dense_key{1, 0, 1};
+    const region_key uniform_key{0, 1, 0};
+    {
+        serialization::region_file file{path, {0, 0, 0}, config};
+        chunk_storage dense{cubic_extent(8)};
+        dense.set_voxel(2, 3, 4, voxel_id{7});
+        dense.skylight()(2, 3, 4) = 11;
+        file.store_chunk(dense_key, dense);
+        chunk_storage solid{cubic_extent(8)};
+        solid.fill(voxel_id{3});
+        file.store_chunk(uniform_key, solid);
+    }
+
+    serialization::mapped_region_file mapped{path};
+    CHECK(mapped.chunk_count() == 2);
+    CHECK_FALSE(mapped.contains(region_key{0, 0, 0}));
+    CHECK_FALSE(mapped.view(region_key{5, 0, 0}));
+
+    std::size_t visited = 0;
+    mapped.for_each([&](const region_key& key, const serialization::chunk_view&) {
+        CHECK((key == dense_key || key == uniform_key));
+        ++visited;
+    });
+    CHECK(visited == 2);
+
+    const auto view = mapped.view(dense_key);
+    REQUIRE(view);
+    CHECK_FALSE(view->uniform());
+    const auto voxels = view->voxels();
+    CHECK(reinterpret_cast<const std::byte*>(voxels.data()) == view->payload().data() + sizeof(serialization::chunk_header_v2));
+    CHECK(voxels(2, 3, 4) == voxel_id{7});
+    CHECK(view->voxel_at(2, 3, 4) == voxel_id{7});
+    CHECK(view->skylight()(2, 3, 4) == 11);
+
+    const auto uniform_view = mapped.view(uniform_key);
+    REQUIRE(uniform_view);
+    CHECK(uniform_view->uniform_voxel() == voxel_id{3});
+    CHECK(uniform_view->voxel_at(7, 7, 7) == voxel_id{3});
+
+    serialization::cow_chunk cow{*view};
+    CHECK(cow.voxel_at(2, 3, 4) == voxel_id{7});
+    CHECK_FALSE(cow.promoted());
+    cow.mutate().set_voxel(2, 3, 4, voxel_id{1});
+    CHECK(cow.promoted());
+    CHECK(cow.voxel_at(2, 3, 4) == voxel_id{1});
+    CHECK(view->voxel_at(2, 3, 4) == voxel_id{7});
+
+    region_manager regions{cubic_extent(8)};
+    regions.replace(dense_key, cow.take());
+    CHECK(regions.find(dense_key)->voxel_at(2, 3, 4) == voxel_id{1});
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE(chunk_delta_patches_sparse_edits) {
+    chunk_storage chunk{cubic_extent(32)};
+    auto voxels = chunk.voxels();
+    for (std::uint32_t z = 0; z < 32; ++z) {
+        for (std::uint32_t x = 0; x < 32; ++x) {
+            for (std::uint32_t y = 0; y < 8 + (x + z) % 5; ++y) {
+                voxels(x, y, z) = voxel_id{static_cast<voxel_id>(1 + y % 3)};
+            }
+        }
+    }
+    chunk.skylight()(4, 20, 4) = 15;
+    const auto baseline = chunk.snapshot();
+    auto replica = serialization::deserialize_chunk(serialization::serialize_chunk(*baseline));
+
+    const auto unchanged = serialization::serialize_chunk_delta(chunk, *baseline);
+    CHECK(unchanged.size() == sizeof(serialization::chunk_header_v2) + 2 * sizeof(std::uint64_t));
+
+    chunk.set_voxel(3, 20, 7, voxel_id{9});
+    chunk.set_voxel(4, 20, 7, voxel_id{9});
+    chunk.set_voxel(31, 31, 31, voxel_id{5});
+    chunk.skylight()(4, 20, 4) = 7;
+
+    const auto delta = serialization::serialize_chunk_delta(chunk, *baseline);
+    const auto full = serialization::serialize_chunk(chunk);
+    CHECK(serialization::is_chunk_delta(delta));
+    CHECK_FALSE(serialization::is_chunk_delta(full));
+    CHECK(delta.size() < 80);
+    CHECK(delta.size() * 1000 < full.size());
+
+    const auto info = serialization::apply_chunk_delta(replica, delta);
+    CHECK(info.base_revision == baseline->revision());
+    CHECK(info.revision == chunk.revision());
+    CHECK(info.planes == (chunk_plane::voxels | chunk_plane::skylight));
+    CHECK(serialization::serialize_chunk(replica) == full);
+    CHECK(replica.dirty_planes() == (chunk_plane::voxels | chunk_plane::skylight));
+
+    chunk_storage_config palette_config{};
+    palette_config.extent = cubic_extent(32);
+    palette_config.layout = voxel_layout::palette;
+    chunk_storage packed{palette_config};
+    packed.assign_voxels(baseline->voxels().linear());
+    packed.skylight()(4, 20, 4) = 15;
+    serialization::apply_chunk_delta(packed, delta);
+    CHECK(packed.layout() == voxel_layout::palette);
+    CHECK(serialization::serialize_chunk(packed) == full);
+
+    bool rejected = false;
+    try {
+        (void)serialization::deserialize_chunk(delta);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+
+    chunk_storage_config other_config{};
+    other_config.extent = cubic_extent(32);
+    other_config.enable_materials = true;
+    chunk_storage mismatched{other_config};
+    bool mismatch = false;
+    try {
+        serialization::apply_chunk_delta(mismatched, delta);
+    } catch (const std::runtime_error&) {
+        mismatch = true;
+    }
+    CHECK(mismatch);
+
+    auto untouched = serialization::deserialize_chunk(serialization::serialize_chunk(*baseline));
+    const auto before = serialization::serialize_chunk(untouched);
+    bool truncated = false;
+    try {
+        serialization::apply_chunk_delta(untouched, std::span<const std::byte>{delta.data(), delta.size() - 1});
+    } catch (const std::runtime_error&) {
+        truncated = true;
+    }
+    CHECK(truncated);
+    CHECK(serialization::serialize_chunk(untouched) == before);
+    CHECK_FALSE(untouched.dirty());
+
+    chunk_storage lazy{other_config};
+    const auto lazy_baseline = lazy.snapshot();
+    lazy.set_voxel(1, 1, 1, voxel_id{4});
+    lazy.metadata().linear()[0] = 3;
+    const auto lazy_delta = serialization::serialize_chunk_delta(lazy, *lazy_baseline);
+    CHECK(serialization::read_chunk_delta_info(lazy_delta).revision == lazy.revision());
+    CHECK(lazy.memory_usage().bytes(chunk_plane::skylight) == 0);
+    CHECK(lazy.memory_usage().bytes(chunk_plane::materials) == 0);
+    CHECK(lazy_baseline->memory_usage().bytes(chunk_plane::metadata) == 0);
+    chunk_storage lazy_replica{other_config};
+    CHECK(serialization::apply_chunk_delta(lazy_replica, lazy_delta).planes
+        == (chunk_plane::voxels | chunk_plane::metadata));
+    CHECK(lazy_replica.voxel_at(1, 1, 1) == voxel_id{4});
+    CHECK(lazy_replica.metadata()(0, 0, 0) == 3);
+}
+
+TEST_CASE(parallel_world_save_and_ingest_round_trip) {
+    const auto directory = std::filesystem::temp_directory_path() / "almond_voxel_batch_io";
+    std::filesystem::remove_all(directory);
+
+    region_manager source{cubic_extent(8)};
+    for (std::int32_t i = 0; i < 21; ++i) {
+        auto& chunk = source.assure(region_key{i, 0, -i});
+        chunk.set_voxel(static_cast<std::uint32_t>(i % 8), 1, 2, voxel_id{static_cast<voxel_id>(i + 1)});
+        chunk.skylight()(3, 3, 3) = static_cast<std::uint8_t>(i % 16);
+    }
+
+    parallel::task_pool pool{3};
+    serialization::batch_io_options options{};
+    options.batch_size = 4;
+    options.codec = codec_id::lz;
+    {
+        serialization::region_writer writer{directory / "world.bin", false, 4096};
+        CHECK(serialization::dump_region_parallel(source, pool,
+                  [&writer](const serialization::region_blob& blob) { writer.write(blob); }, options)
+            == 21);
+        CHECK_FALSE(std::filesystem::exists(directory / "world.bin"));
+        writer.commit();
+        CHECK(writer.bytes_written() == std::filesystem::file_size(directory / "world.bin"));
+    }
+    serialization::dump_region(source, serialization::make_region_serializer(
+        serialization::file_sink(directory / "plain.bin")));
+
+    for (const auto* name : {"world.bin", "plain.bin"}) {
+        region_manager target{cubic_extent(8)};
+        std::ifstream in{directory / name, std::ios::binary};
+        CHECK(serialization::ingest_parallel(target, pool, in, options) == 21);
+        for (std::int32_t i = 0; i < 21; ++i) {
+            const region_key key{i, 0, -i};
+            const auto restored = target.find(key);
+            REQUIRE(restored != nullptr);
+            CHECK_FALSE(restored->dirty());
+            CHECK(serialization::serialize_chunk(*restored) == serialization::serialize_chunk(*source.find(key)));
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE(region_records_detect_damage_and_salvage) {
+    CHECK(xxhash64({}) == 0xEF46DB3751D8E999ull);
+    const char abc[] = "abc";
+    CHECK(xxhash64(std::as_bytes(std::span{abc, 3})) == 0x44BC2CF5AD770999ull);
+
+    const auto directory = std::filesystem::temp_directory_path() / "almond_voxel_record_salvage";
+    std::filesystem::remove_all(directory);
+    const auto path = directory / "journal.bin";
+    const auto make_blob = [](region_key key, std::size_t size, std::uint8_t seed) {
+        serialization::region_blob blob{key, std::vector<std::byte>(size)};
+        for (std::size_t i = 0; i < size; ++i) {
+            blob.payload[i] = static_cast<std::byte>(seed + i * 7);
+        }
+        return blob;
+    };
+    const region_key a{1, 2, 3};
+    const region_key b{-4, 0, 9};
+
+    // A rebuilt file only appears once committed.
+    {
+        serialization::region_writer writer{path, false};
+        writer.write(make_blob(a, 40, 1));
+        writer.write(make_blob(b, 90000, 2));
+        writer.flush();
+        CHECK_FALSE(std::filesystem::exists(path));
+    }
+    REQUIRE(std::filesystem::exists(path));
+    CHECK_FALSE(std::filesystem::exists(directory / "journal.bin.tmp"));
+    try {
+        serialization::region_writer writer{path, false};
+        writer.write(make_blob(a, 8, 9));
+        throw std::runtime_error("abandoned save");
+    } catch (const std::runtime_error&) {
+    }
+    CHECK_FALSE(std::filesystem::exists(directory / "journal.bin.tmp"));
+
+    // Journal newer copies of a, then tear the last record as a crash mid-append would.
+    {
+        serialization::region_writer writer{path};
+        writer.write(make_blob(a, 64, 3));
+        writer.write(make_blob(a, 32, 4));
+        writer.commit();
+    }
+    const auto intact = std::filesystem::file_size(path);
+    {
+        serialization::region_writer writer{path};
+        writer.write(make_blob(b, 500, 5));
+    }
+    std::filesystem::resize_file(path, intact + 100);
+
+    const auto read_all = [&](std::size_t& count) {
+        std::ifstream in{path, std::ios::binary};
+        while (serialization::read_region_blob(in)) {
+            ++count;
+        }
+    };
+    std::size_t count = 0;
+    bool truncated = false;
+    try {
+        read_all(count);
+    } catch (const std::runtime_error&) {
+        truncated = true;
+    }
+    CHECK(truncated);
+    CHECK(count == 4);
+
+    // Flip one payload byte of the newest record for a.
+    {
+        std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+        const auto offset = 2 * sizeof(serialization::region_record_header) + 40 + 90000
+            + sizeof(serialization::region_record_header) + 64 + sizeof(serialization::region_record_header) + 5;
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.put('\x7f');
+    }
+    {
+        std::ifstream in{path, std::ios::binary};
+        serialization::region_blob blob;
+        for (int i = 0; i < 3; ++i) {
+            CHECK(serialization::read_region_record(in, blob) == serialization::region_record_status::ok);
+        }
+        CHECK(serialization::read_region_record(in, blob) == serialization::region_record_status::corrupt);
+    }
+
+    const auto report = serialization::repair_region_file(path);
+    CHECK(report.records == 3);
+    // The corrupt record and the torn tail are adjacent, so they form one damaged span.
+    CHECK(report.damaged == 1);
+    CHECK(report.skipped_bytes == sizeof(serialization::region_record_header) + 32 + 100);
+    REQUIRE(report.blobs.size() == 2);
+    CHECK(report.blobs[0].key == a);
+    CHECK(report.blobs[0].payload == make_blob(a, 64, 3).payload);
+    CHECK(report.blobs[1].payload == make_blob(b, 90000, 2).payload);
+
+    count = 0;
+    read_all(count);
+    CHECK(count == 2);
+
+    // Streams written before record checksums still load.
+    std::stringstream legacy;
+    const auto old = make_blob(b, 12, 6);
+    const auto size = static_cast<std::uint32_t>(old.payload.size());
+    legacy.write(reinterpret_cast<const char*>(&old.key), sizeof(old.key));
+    legacy.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    legacy.write(reinterpret_cast<const char*>(old.payload.data()), size);
+    const auto loaded = serialization::read_region_blob(legacy);
+    REQUIRE(loaded);
+    CHECK(loaded->key == b);
+    CHECK(loaded->payload == old.payload);
+    CHECK_FALSE(serialization::read_region_blob(legacy));
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE(region_file_rejects_corrupt_payloads) {
+    const auto directory = std::filesystem::temp_directory_path() / "almond_voxel_region_checksum";
+    std::filesystem::remove_all(directory);
+    const auto path = directory / "r.0.0.0.avr";
+    serialization::region_file_config config{};
+    config.region_size = 2;
+    config.sector_size = 512;
+    config.sync_writes = true;
+
+    chunk_storage chunk{cubic_extent(4)};
+    chunk.set_voxel(1, 2, 3, voxel_id{7});
+    const region_key key{1, 0, 1};
+    std::uint32_t sector = 0;
+    {
+        serialization::region_file file{path, {0, 0, 0}, config};
+        file.store_chunk(key, chunk);
+        file.store_chunk(region_key{0, 0, 0}, chunk_storage{cubic_extent(4)});
+        file.flush();
+        std::ifstream in{path, std::ios::binary};
+        serialization::region_file_header header{};
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        CHECK(header.version == serialization::region_file_version);
+        serialization::region_file_entry entry{};
+        in.seekg(static_cast<std::streamoff>(sizeof(header) + 5 * sizeof(entry)));
+        in.read(reinterpret_cast<char*>(&entry), sizeof(entry));
+        sector = entry.sector;
+    }
+    {
+        std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+        file.seekp(static_cast<std::streamoff>(std::uint64_t{sector} * config.sector_size + 40));
+        file.put('\x55');
+    }
+
+    serialization::region_file file{path, {0, 0, 0}, config};
+    CHECK(file.load_chunk(region_key{0, 0, 0}).has_value());
+    bool rejected = false;
+    try {
+        static_cast<void>(file.read(key));
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+
+    {
+        const serialization::mapped_region_file mapped{path};
+        CHECK(mapped.view(region_key{0, 0, 0}).has_value());
+        rejected = false;
+        try {
+            static_cast<void>(mapped.view(key));
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        CHECK(rejected);
+    }
+
+    // Overwriting the damaged chunk relocates it and makes it readable again.
+    file.store_chunk(key, chunk);
+    CHECK(file.load_chunk(key)->voxels()(1, 2, 3) == voxel_id{7});
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE(region_file_upgrades_version_one_files) {
+    const auto directory = std::filesystem::temp_directory_path() / "almond_voxel_region_upgrade";
+    std::filesystem::remove_all(directory);
+    const auto path = directory / "r.0.0.0.avr";
+    serialization::region_file_config config{};
+    config.region_size = 2;
+    config.sector_size = 512;
+
+    const std::vector<std::byte> first(600, std::byte{3});
+    const std::vector<std::byte> second(100, std::byte{4});
+    const auto read_header = [&] {
+        std::ifstream in{path, std::ios::binary};
+        serialization::region_file_header header{};
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        return header;
+    };
+    {
+        serialization::region_file file{path, {0, 0, 0}, config};
+        file.write(region_key{0, 0, 0}, std::vector<std::byte>(900, std::byte{1}));
+        file.write(region_key{1, 0, 0}, first);
+        CHECK(file.erase(region_key{0, 0, 0}));
+    }
+    {
+        // Rewrite the preamble as version 1 with no checksums.
+        std::fstream out{path, std::ios::binary | std::ios::in | std::ios::out};
+        auto header = read_header();
+        header.version = 1;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        std::vector<serialization::region_file_entry> index(8);
+        out.read(reinterpret_cast<char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(index[0])));
+        for (auto& entry : index) {
+            entry.checksum = 0;
+        }
+        out.seekp(sizeof(header));
+        out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(index[0])));
+    }
+
+    {
+        serialization::region_file file{path, {0, 0, 0}, config};
+        CHECK(*file.read(region_key{1, 0, 0}) == first);
+        file.write(region_key{0, 1, 0}, second);
+        file.flush();
+        CHECK(read_header().version == serialization::region_file_version);
+    }
+    {
+        serialization::region_file file{path, {0, 0, 0}, config};
+        CHECK(*file.read(region_key{1, 0, 0}) == first);
+        CHECK(*file.read(region_key{0, 1, 0}) == second);
+
+        const auto before = file.file_size();
+        CHECK(file.compact() > 0);
+        CHECK(file.file_size() < before);
+        CHECK_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+        CHECK(*file.read(region_key{1, 0, 0}) == first);
+        file.write(region_key{1, 1, 0}, second);
+    }
+    serialization::region_file file{path, {0, 0, 0}, config};
+    CHECK(file.chunk_count() == 3);
+    CHECK(*file.read(region_key{1, 0, 0}) == first);
+    CHECK(*file.read(region_key{0, 1, 0}) == second);
+    CHECK(*file.read(region_key{1, 1, 0}) == second);
+    std::filesystem::remove_all(directory);
+}
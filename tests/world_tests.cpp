@@ -1,7 +1,16 @@
+#include "almond_voxel/parallel/completion_queue.hpp"
 #include "almond_voxel/world.hpp"
 
 #include "test_framework.hpp"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
 using namespace almond::voxel;
 
 TEST_CASE(region_manager_readonly_task_keeps_chunk_clean) {
@@ -45,3 +54,488 @@ TEST_CASE(region_manager_unpin_requeues_for_eviction) {
     CHECK_FALSE(regions.find(pinned));
     CHECK(regions.find(replacement));
 }
+
+TEST_CASE(region_manager_lighting_writes_skip_navigation) {
+    const region_key key{0, 0, 0};
+    region_manager regions{cubic_extent(4)};
+    regions.enable_navigation(true);
+    auto& chunk = regions.assure(key);
+    regions.tick();
+    const auto grid = regions.navigation_grid(key);
+    REQUIRE(grid);
+
+    int voxel_edits = 0;
+    int any_edits = 0;
+    regions.add_dirty_observer([&](const region_key&) { ++voxel_edits; }, chunk_plane::voxels);
+    regions.add_dirty_observer([&](const region_key&) { ++any_edits; });
+
+    chunk.skylight()(0, 0, 0) = 15;
+    CHECK(regions.tick() == 0);
+    CHECK(regions.navigation_grid(key) == grid);
+    CHECK(voxel_edits == 0);
+    CHECK(any_edits == 1);
+
+    chunk.set_voxel(0, 0, 0, voxel_id{1});
+    CHECK(regions.tick() == 1);
+    CHECK(regions.navigation_grid(key) != grid);
+    CHECK(voxel_edits == 1);
+
+    const auto snapshots = regions.snapshot_loaded();
+    REQUIRE(snapshots.size() == 1);
+    CHECK(snapshots.front().dirty_planes == (chunk_plane::voxels | chunk_plane::skylight));
+
+    chunk_storage replacement{cubic_extent(4)};
+    regions.replace(key, std::move(replacement)).set_voxel(1, 0, 0, voxel_id{1});
+    CHECK(voxel_edits == 2);
+}
+
+TEST_CASE(region_manager_worker_pool_serialises_regions) {
+    region_manager regions{cubic_extent(4)};
+    regions.set_worker_count(4);
+    CHECK(regions.worker_count() == 4);
+
+    constexpr int region_count = 6;
+    constexpr int tasks_per_region = 12;
+    std::array<std::atomic<int>, region_count> running{};
+    std::array<std::atomic<int>, region_count> next{};
+    std::atomic<int> overlaps{0};
+    std::atomic<int> out_of_order{0};
+    for (int step = 0; step < tasks_per_region; ++step) {
+        for (int r = 0; r < region_count; ++r) {
+            regions.enqueue_task(region_key{r, 0, 0}, [&, r, step](chunk_storage& chunk, const region_key&) {
+                if (running[r].fetch_add(1) != 0) {
+                    ++overlaps;
+                }
+                if (next[r].load() != step) {
+                    ++out_of_order;
+                }
+                chunk.set_voxel(0, 0, 0, static_cast<voxel_id>(step + 1));
+                std::this_thread::yield();
+                next[r].store(step + 1);
+                running[r].fetch_sub(1);
+            });
+        }
+    }
+
+    std::size_t started = 0;
+    while (regions.pending_tasks() > 0) {
+        const std::size_t count = regions.tick(4);
+        CHECK(count <= 4);
+        started += count;
+        regions.wait_idle();
+    }
+
+    CHECK(started == static_cast<std::size_t>(region_count * tasks_per_region));
+    CHECK(overlaps.load() == 0);
+    CHECK(out_of_order.load() == 0);
+    for (int r = 0; r < region_count; ++r) {
+        const auto chunk = regions.find(region_key{r, 0, 0});
+        REQUIRE(chunk);
+        CHECK(chunk->voxel_at(0, 0, 0) == static_cast<voxel_id>(tasks_per_region));
+    }
+}
+
+TEST_CASE(region_manager_failed_load_drops_its_task_and_requeues_the_rest) {
+    region_manager regions{cubic_extent(4)};
+    regions.set_loader([](const region_key& key) {
+        if (key.x == 1) {
+            throw std::runtime_error("loader failed");
+        }
+        return chunk_storage{cubic_extent(4)};
+    });
+    regions.set_worker_count(2);
+
+    std::atomic<int> ran{0};
+    for (std::int32_t r = 0; r < 3; ++r) {
+        regions.enqueue_task(region_key{r, 0, 0}, [&](chunk_storage& chunk, const region_key&) {
+            chunk.set_voxel(0, 0, 0, voxel_id{1});
+            ++ran;
+        });
+    }
+
+    // Like the inline path, the failing task is dropped and its error leaves tick().
+    bool threw = false;
+    try {
+        regions.tick();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    regions.wait_idle();
+    CHECK(ran.load() == 1);
+    CHECK(regions.pending_tasks() == 1);
+
+    // The valid task queued behind it still runs.
+    CHECK(regions.tick() == 1);
+    regions.wait_idle();
+    CHECK(ran.load() == 2);
+    CHECK(regions.pending_tasks() == 0);
+    CHECK_FALSE(regions.find(region_key{1, 0, 0}));
+    const auto chunk = regions.find(region_key{2, 0, 0});
+    REQUIRE(chunk);
+    CHECK(chunk->voxel_at(0, 0, 0) == voxel_id{1});
+}
+
+TEST_CASE(region_manager_worker_edits_notify_on_tick_thread) {
+    const region_key key{0, 0, 0};
+    region_manager regions{cubic_extent(4)};
+    regions.enable_navigation(true);
+    regions.set_worker_count(2);
+    regions.assure(key);
+    regions.tick();
+    regions.wait_idle();
+    const auto grid = regions.navigation_grid(key);
+    REQUIRE(grid);
+    CHECK(grid->walkable(grid->index(1, 0, 1)));
+
+    const auto tick_thread = std::this_thread::get_id();
+    int notifications = 0;
+    bool notified_on_tick_thread = true;
+    regions.add_dirty_observer([&](const region_key&) {
+        ++notifications;
+        notified_on_tick_thread = notified_on_tick_thread && std::this_thread::get_id() == tick_thread;
+    }, chunk_plane::voxels);
+
+    regions.enqueue_task(key, [](chunk_storage& chunk, const region_key&) { chunk.set_voxel(1, 0, 1, voxel_id{1}); });
+    CHECK(regions.tick() == 1);
+    regions.wait_idle();
+    CHECK(notifications == 1);
+    CHECK(notified_on_tick_thread);
+
+    CHECK(regions.tick() == 1);
+    regions.wait_idle();
+    const auto rebuilt = regions.navigation_grid(key);
+    REQUIRE(rebuilt);
+    CHECK(rebuilt != grid);
+    CHECK_FALSE(rebuilt->walkable(rebuilt->index(1, 0, 1)));
+    CHECK(regions.pending_tasks() == 0);
+}
+
+TEST_CASE(region_manager_async_requests_deduplicate_and_notify) {
+    region_manager regions{cubic_extent(4)};
+    std::atomic<int> loads{0};
+    regions.set_loader([&](const region_key&) {
+        ++loads;
+        chunk_storage chunk{cubic_extent(4)};
+        chunk.fill(voxel_id{3});
+        return chunk;
+    });
+    regions.set_worker_count(2);
+
+    const region_key key{2, 0, 0};
+    const auto tick_thread = std::this_thread::get_id();
+    int ready_calls = 0;
+    bool on_tick_thread = true;
+    const auto on_ready = [&](const load_handle& handle) {
+        ++ready_calls;
+        on_tick_thread = on_tick_thread && std::this_thread::get_id() == tick_thread;
+        CHECK(handle.ready());
+    };
+
+    const auto first = regions.request(key, 0, on_ready);
+    const auto second = regions.request(key, 5, on_ready);
+    CHECK(first.valid());
+    CHECK(first.key() == key);
+    CHECK_FALSE(regions.find(key));
+
+    regions.wait_idle();
+    CHECK(loads.load() == 1);
+    CHECK(ready_calls == 2);
+    CHECK(on_tick_thread);
+    REQUIRE(first.ready());
+    REQUIRE(second.ready());
+    CHECK(first.chunk() == second.chunk());
+    CHECK(regions.find(key) == first.chunk());
+    CHECK(first.chunk()->voxel_at(0, 0, 0) == voxel_id{3});
+    CHECK(regions.pending_loads() == 0);
+
+    const auto resident = regions.request(key);
+    CHECK(resident.ready());
+    CHECK(resident.chunk() == first.chunk());
+    CHECK(loads.load() == 1);
+}
+
+TEST_CASE(region_manager_async_requests_follow_priority_and_cancel) {
+    region_manager regions{cubic_extent(4)};
+    std::vector<region_key> order;
+    regions.set_loader([&](const region_key& key) {
+        order.push_back(key);
+        return chunk_storage{cubic_extent(4)};
+    });
+    regions.set_load_concurrency(1);
+
+    const region_key low{0, 0, 0};
+    const region_key high{1, 0, 0};
+    const region_key dropped{2, 0, 0};
+    bool dropped_notified = false;
+    const auto low_handle = regions.request(low, 0);
+    const auto high_handle = regions.request(high, 10);
+    const auto dropped_handle = regions.request(dropped, 20, [&](const load_handle&) { dropped_notified = true; });
+    CHECK(regions.cancel(dropped));
+    CHECK_FALSE(regions.cancel(dropped));
+    CHECK(dropped_handle.status() == load_status::cancelled);
+
+    regions.tick();
+    CHECK(high_handle.ready());
+    CHECK(low_handle.status() == load_status::queued);
+    regions.tick();
+    CHECK(low_handle.ready());
+    regions.tick();
+
+    REQUIRE(order.size() == 2);
+    CHECK(order[0] == high);
+    CHECK(order[1] == low);
+    CHECK_FALSE(regions.find(dropped));
+    CHECK_FALSE(dropped_notified);
+    CHECK(dropped_handle.chunk() == nullptr);
+}
+
+TEST_CASE(region_manager_lru_tracks_pins_separately) {
+    region_manager regions{cubic_extent(2)};
+    const region_key a{0, 0, 0};
+    const region_key b{1, 0, 0};
+    const region_key c{2, 0, 0};
+    const region_key d{3, 0, 0};
+    const region_key e{4, 0, 0};
+
+    regions.set_max_resident(3);
+    regions.assure(a);
+    regions.assure(b);
+    regions.assure(c);
+    regions.pin(a);
+    regions.pin(a);
+    CHECK(regions.pinned_count() == 1);
+
+    regions.assure(b);
+    regions.assure(d);
+    regions.evict_until_within_limit();
+    CHECK(regions.resident() == 3);
+    CHECK(regions.find(a));
+    CHECK(regions.find(b));
+    CHECK_FALSE(regions.find(c));
+    CHECK(regions.find(d));
+    CHECK_FALSE(regions.unload(a));
+
+    regions.unpin(a);
+    CHECK(regions.pinned_count() == 0);
+    regions.assure(e);
+    regions.evict_until_within_limit();
+    CHECK_FALSE(regions.find(b));
+    CHECK(regions.find(a));
+    CHECK(regions.find(d));
+    CHECK(regions.find(e));
+}
+
+TEST_CASE(region_manager_memory_budget_evicts_by_bytes) {
+    region_manager regions{cubic_extent(8)};
+    const auto dense_bytes = std::size_t{8 * 8 * 8} * sizeof(voxel_id);
+
+    regions.assure(region_key{7, 0, 0});
+    regions.tick(0);
+    CHECK(regions.memory_usage().bytes(chunk_plane::all) < dense_bytes);
+
+    for (std::int32_t i = 0; i < 4; ++i) {
+        regions.assure(region_key{i, 0, 0}).voxels()(0, 0, 0) = voxel_id{1};
+    }
+    for (std::int32_t i = 4; i < 7; ++i) {
+        regions.assure(region_key{i, 0, 0});
+    }
+    regions.assure(region_key{7, 0, 0});
+    regions.tick(0);
+    CHECK(regions.resident() == 8);
+    CHECK(regions.memory_usage().bytes(chunk_plane::voxels) >= 4 * dense_bytes);
+
+    // The two least recently used regions are the dense ones written first.
+    regions.set_memory_budget(regions.resident_bytes() - 2 * dense_bytes);
+    CHECK(regions.resident_bytes() <= regions.memory_budget());
+    CHECK(regions.resident() == 6);
+    CHECK_FALSE(regions.find(region_key{0, 0, 0}));
+    CHECK_FALSE(regions.find(region_key{1, 0, 0}));
+    CHECK(regions.find(region_key{2, 0, 0}));
+    CHECK(regions.find(region_key{7, 0, 0}));
+
+    regions.set_memory_budget(0);
+    regions.assure(region_key{0, 0, 0}).voxels()(0, 0, 0) = voxel_id{1};
+    regions.tick(0);
+    CHECK(regions.find(region_key{0, 0, 0}));
+}
+
+TEST_CASE(region_manager_compresses_idle_regions) {
+    region_manager regions{cubic_extent(16)};
+    compression_policy policy{};
+    policy.idle_ticks = 2;
+    regions.set_compression_policy(policy);
+
+    const region_key idle{0, 0, 0};
+    const region_key busy{1, 0, 0};
+    for (const auto& key : {idle, busy}) {
+        auto voxels = regions.assure(key).voxels();
+        for (std::uint32_t i = 0; i < voxels.size(); ++i) {
+            voxels.data()[i] = voxel_id{static_cast<voxel_id>(i / 256 < 6 ? 1 : 0)};
+        }
+    }
+    regions.refresh_memory_usage();
+    const auto dense = regions.memory_usage().bytes(chunk_plane::voxels);
+
+    for (int i = 0; i < 3; ++i) {
+        regions.assure(busy);
+        regions.tick();
+    }
+    CHECK(regions.tier(idle) == residency_tier::warm);
+    CHECK(regions.tier(busy) == residency_tier::hot);
+    CHECK(regions.tier(region_key{9, 0, 0}) == residency_tier::cold);
+    CHECK(regions.memory_usage().compressed > 0);
+    CHECK(regions.memory_usage().bytes(chunk_plane::voxels) * 3 < dense * 2);
+
+    CHECK(regions.assure(idle).voxel_at(3, 3, 3) == voxel_id{1});
+    CHECK(regions.tier(idle) == residency_tier::hot);
+}
+
+TEST_CASE(region_manager_compresses_before_evicting_under_pressure) {
+    region_manager regions{cubic_extent(16)};
+    regions.set_worker_count(2);
+    compression_policy policy{};
+    policy.compress_under_pressure = true;
+    regions.set_compression_policy(policy);
+
+    for (std::int32_t i = 0; i < 6; ++i) {
+        auto voxels = regions.assure(region_key{i, 0, 0}).voxels();
+        for (std::uint32_t j = 0; j < voxels.size(); ++j) {
+            voxels.data()[j] = voxel_id{static_cast<voxel_id>(j % 4096 < 1024 ? i + 1 : 0)};
+        }
+    }
+    regions.tick();
+    const auto dense = regions.resident_bytes();
+
+    // Half the dense footprint only fits once the least recently used regions are compressed.
+    regions.set_memory_budget(dense / 2);
+    CHECK(regions.resident() == 6);
+    regions.wait_idle();
+    regions.tick();
+    regions.wait_idle();
+    regions.tick();
+    CHECK(regions.resident() == 6);
+    CHECK(regions.resident_bytes() <= regions.memory_budget());
+    CHECK(regions.tier(region_key{0, 0, 0}) == residency_tier::warm);
+    for (std::int32_t i = 0; i < 6; ++i) {
+        CHECK(regions.assure(region_key{i, 0, 0}).voxel_at(0, 0, 0) == voxel_id{static_cast<voxel_id>(i + 1)});
+    }
+}
+
+TEST_CASE(region_manager_concurrent_readers_see_whole_edits) {
+    region_manager regions{cubic_extent(8)};
+    regions.set_worker_count(2);
+    regions.set_max_resident(8);
+    compression_policy policy{};
+    policy.idle_ticks = 1;
+    regions.set_compression_policy(policy);
+    for (std::int32_t i = 0; i < 4; ++i) {
+        regions.assure(region_key{i, 0, 0}).fill(voxel_id{1});
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> torn{0};
+    std::atomic<int> reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&, r] {
+            for (std::uint32_t n = 0; !stop.load(); ++n) {
+                const auto chunk = regions.find(region_key{static_cast<std::int32_t>((n + r) % 4), 0, 0});
+                if (!chunk) {
+                    continue;
+                }
+                auto guard = chunk->lock_shared();
+                const auto voxels = std::as_const(*chunk).voxels();
+                const auto expected = voxels(0, 0, 0);
+                for (std::uint32_t i = 0; i < voxels.size(); ++i) {
+                    if (voxels.data()[i] != expected) {
+                        ++torn;
+                        break;
+                    }
+                }
+                if (chunk->voxel_at(n % 8, 3, 5) != expected || std::as_const(*chunk).skylight()(1, 2, 3) != 0) {
+                    ++torn;
+                }
+                ++reads;
+            }
+        });
+    }
+
+    for (std::uint32_t step = 0; step < 200; ++step) {
+        const auto value = voxel_id{static_cast<voxel_id>(step % 7 + 1)};
+        const region_key key{static_cast<std::int32_t>(step % 4), 0, 0};
+        regions.enqueue_task(key, [value, step](chunk_storage& chunk, const region_key&) {
+            if (step % 2 == 0) {
+                chunk.fill(value);
+                return;
+            }
+            auto voxels = chunk.voxels();
+            for (std::uint32_t i = 0; i < voxels.size(); ++i) {
+                voxels.data()[i] = value;
+            }
+        });
+        // Churn other regions so the map rehashes while readers look keys up.
+        regions.assure(region_key{static_cast<std::int32_t>(100 + step), 0, 0});
+        regions.tick();
+    }
+    regions.wait_idle();
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    CHECK(torn.load() == 0);
+    CHECK(reads.load() > 0);
+}
+
+TEST_CASE(region_manager_snapshots_ignore_later_edits) {
+    region_manager regions{cubic_extent(4)};
+    const region_key key{0, 0, 0};
+    regions.assure(key).set_voxel(1, 1, 1, voxel_id{3});
+
+    const auto snapshots = regions.snapshot_loaded();
+    REQUIRE(snapshots.size() == 1);
+    regions.enqueue_task(key, [](chunk_storage& chunk, const region_key&) {
+        chunk.set_voxel(1, 1, 1, voxel_id{8});
+    });
+    regions.tick();
+
+    CHECK(regions.find(key)->voxel_at(1, 1, 1) == voxel_id{8});
+    CHECK(snapshots.front().chunk->voxel_at(1, 1, 1) == voxel_id{3});
+    CHECK(snapshots.front().chunk.get() != regions.find(key).get());
+}
+
+TEST_CASE(completion_queue_delivers_every_push_in_producer_order) {
+    constexpr int producers = 4;
+    constexpr int per_producer = 2000;
+    parallel::completion_queue<std::pair<int, int>> queue;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < per_producer; ++i) {
+                queue.push({p, i});
+            }
+        });
+    }
+
+    std::array<int, producers> next{};
+    int received = 0;
+    bool ordered = true;
+    while (received < producers * per_producer) {
+        std::pair<int, int> item;
+        if (!queue.try_pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && item.second == next[static_cast<std::size_t>(item.first)];
+        ++next[static_cast<std::size_t>(item.first)];
+        ++received;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(ordered);
+    CHECK(queue.empty());
+
+    // Items still queued at destruction are released.
+    queue.push({0, 0});
+}